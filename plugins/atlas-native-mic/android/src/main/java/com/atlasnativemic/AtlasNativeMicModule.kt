@@ -12,6 +12,8 @@ import com.facebook.react.bridge.Promise
 import com.facebook.react.bridge.ReactApplicationContext
 import com.facebook.react.bridge.ReactContextBaseJavaModule
 import com.facebook.react.bridge.ReactMethod
+import com.facebook.react.bridge.ReadableMap
+import com.facebook.react.bridge.ReadableType
 import com.facebook.react.bridge.WritableMap
 import com.facebook.react.modules.core.DeviceEventManagerModule
 import java.io.File
@@ -28,6 +30,8 @@ class AtlasNativeMicModule(private val reactContext: ReactApplicationContext) :
     private var lastTerminalSessionId: String? = null
     private var lastTerminalWasFinalize = false
     private var tornDown = false
+    private var warmCapture: WarmCapture? = null
+    private var warmSession = false
 
     override fun getName(): String = "AtlasNativeMic"
 
@@ -56,13 +60,76 @@ class AtlasNativeMicModule(private val reactContext: ReactApplicationContext) :
         return m
     }
 
+    private fun hasRecordPermission(): Boolean =
+        ContextCompat.checkSelfPermission(reactApplicationContext, Manifest.permission.RECORD_AUDIO) ==
+            PackageManager.PERMISSION_GRANTED
+
     @ReactMethod
-    fun init(promise: Promise) {
+    fun init(options: ReadableMap?, promise: Promise) {
         if (tornDown) {
             promise.reject("E_TORN_DOWN", "AtlasNativeMic torn down")
             return
         }
-        Log.i(TAG, "[AtlasNativeMic] init")
+        if (options == null || !options.hasKey("warm") || options.getType("warm") != ReadableType.Boolean) {
+            Log.i(TAG, "[AtlasNativeMic] init")
+            promise.resolve(null)
+            return
+        }
+        val warm = options.getBoolean("warm")
+        val preRollMs =
+            if (options.hasKey("preRollMs") && options.getType("preRollMs") == ReadableType.Number) {
+                options.getDouble("preRollMs").toInt().coerceIn(0, MAX_PRE_ROLL_MS)
+            } else {
+                DEFAULT_PRE_ROLL_MS
+            }
+        mainHandler.post {
+            if (!warm) {
+                if (!warmSession) {
+                    warmCapture?.stop()
+                    warmCapture = null
+                }
+                Log.i(TAG, "[AtlasNativeMic] init warm=false")
+                promise.resolve(null)
+                return@post
+            }
+            if (warmCapture?.preRollMs != preRollMs && !warmSession) {
+                warmCapture?.stop()
+                warmCapture = null
+            }
+            val wc = warmCapture ?: WarmCapture(preRollMs).also { warmCapture = it }
+            // Warm up now only with the permission already granted; startCapture retries otherwise.
+            if (!captureActive && hasRecordPermission()) {
+                try {
+                    wc.start()
+                } catch (e: Exception) {
+                    Log.w(TAG, "[AtlasNativeMic][E_AUDIO] warm start deferred: ${e.message}")
+                }
+            }
+            Log.i(TAG, "[AtlasNativeMic] init warm=true preRollMs=$preRollMs running=${wc.isRunning}")
+            promise.resolve(null)
+        }
+    }
+
+    private fun beginWarmCapture(wc: WarmCapture, sessionId: String, promise: Promise) {
+        try {
+            wc.start()
+        } catch (e: Exception) {
+            Log.e(TAG, "[AtlasNativeMic][E_AUDIO] warm start failed", e)
+            promise.reject("E_AUDIO", e.message ?: "warm start failed", e)
+            return
+        }
+        val preRollMs = wc.beginSession()
+        val out = File(reactApplicationContext.cacheDir, "atlas_mic_${sessionId}.wav")
+        if (out.exists()) out.delete()
+        recordingPath = out.absolutePath
+        warmSession = true
+        activeSessionId = sessionId
+        captureActive = true
+        startedAtMs = System.currentTimeMillis()
+        lastTerminalSessionId = null
+        lastTerminalWasFinalize = false
+        sendEvent("mic_capture_started", micPayload(sessionId, "capturing"))
+        Log.i(TAG, "[AtlasNativeMic] capture started $sessionId (warm, pre-roll $preRollMs ms)")
         promise.resolve(null)
     }
 
@@ -87,12 +154,15 @@ class AtlasNativeMicModule(private val reactContext: ReactApplicationContext) :
                 return@post
             }
             val ctx = reactApplicationContext
-            if (ContextCompat.checkSelfPermission(ctx, Manifest.permission.RECORD_AUDIO) !=
-                PackageManager.PERMISSION_GRANTED
-            ) {
+            if (!hasRecordPermission()) {
                 promise.reject("E_PERMISSION", "RECORD_AUDIO not granted")
                 return@post
             }
+            val wc = warmCapture
+            if (wc != null) {
+                beginWarmCapture(wc, sessionId, promise)
+                return@post
+            }
             val out = File(ctx.cacheDir, "atlas_mic_${sessionId}.m4a")
             if (out.exists()) out.delete()
             recordingPath = out.absolutePath
@@ -152,26 +222,45 @@ class AtlasNativeMicModule(private val reactContext: ReactApplicationContext) :
             sendEvent("mic_capture_stopping", micPayload(sessionId, "stopping"))
             val path = recordingPath
             val startMs = startedAtMs
-            try {
-                recorder?.apply {
-                    try {
-                        stop()
-                    } catch (_: Exception) {
+            var durationMs = if (startMs > 0) {
+                (System.currentTimeMillis() - startMs).toInt().coerceAtLeast(0)
+            } else {
+                0
+            }
+            var preRollMs = 0
+            val wc = warmCapture
+            if (warmSession && wc != null && path != null) {
+                // The input stays warm for the next session; only this session's audio is written out.
+                warmSession = false
+                try {
+                    val session = wc.finishSession(File(path))
+                    durationMs = session.durationMillis
+                    preRollMs = session.preRollMillis
+                } catch (e: Exception) {
+                    Log.e(TAG, "[AtlasNativeMic][E_AUDIO] warm session write failed", e)
+                    captureActive = false
+                    activeSessionId = null
+                    recordingPath = null
+                    promise.reject("E_AUDIO", e.message ?: "capture write failed", e)
+                    return@post
+                }
+            } else {
+                try {
+                    recorder?.apply {
+                        try {
+                            stop()
+                        } catch (_: Exception) {
+                        }
+                        release()
                     }
-                    release()
+                    recorder = null
+                } catch (e: Exception) {
+                    Log.e(TAG, "stop", e)
                 }
-                recorder = null
-            } catch (e: Exception) {
-                Log.e(TAG, "stop", e)
             }
             captureActive = false
             activeSessionId = null
             recordingPath = null
-            val durationMs = if (startMs > 0) {
-                (System.currentTimeMillis() - startMs).toInt().coerceAtLeast(0)
-            } else {
-                0
-            }
             lastTerminalSessionId = sessionId
             lastTerminalWasFinalize = true
             sendEvent("mic_capture_finalized", micPayload(sessionId, "finalized"))
@@ -179,8 +268,9 @@ class AtlasNativeMicModule(private val reactContext: ReactApplicationContext) :
             val result = Arguments.createMap()
             result.putString("uri", uri)
             result.putInt("durationMillis", durationMs)
+            result.putInt("preRollMillis", preRollMs)
             result.putBoolean("duplicate", false)
-            Log.i(TAG, "[AtlasNativeMic] capture finalized $sessionId ms=$durationMs")
+            Log.i(TAG, "[AtlasNativeMic] capture finalized $sessionId ms=$durationMs preRollMs=$preRollMs")
             promise.resolve(result)
         }
     }
@@ -211,17 +301,22 @@ class AtlasNativeMicModule(private val reactContext: ReactApplicationContext) :
                 return@post
             }
             val path = recordingPath
-            try {
-                recorder?.apply {
-                    try {
-                        stop()
-                    } catch (_: Exception) {
+            if (warmSession) {
+                warmCapture?.discardSession()
+                warmSession = false
+            } else {
+                try {
+                    recorder?.apply {
+                        try {
+                            stop()
+                        } catch (_: Exception) {
+                        }
+                        release()
                     }
-                    release()
+                    recorder = null
+                } catch (e: Exception) {
+                    Log.e(TAG, "cancel stop", e)
                 }
-                recorder = null
-            } catch (e: Exception) {
-                Log.e(TAG, "cancel stop", e)
             }
             captureActive = false
             activeSessionId = null
@@ -257,6 +352,9 @@ class AtlasNativeMicModule(private val reactContext: ReactApplicationContext) :
             } catch (_: Exception) {
             }
             recorder = null
+            warmCapture?.stop()
+            warmCapture = null
+            warmSession = false
             captureActive = false
             activeSessionId = null
             recordingPath?.let {
@@ -275,11 +373,15 @@ class AtlasNativeMicModule(private val reactContext: ReactApplicationContext) :
     @ReactMethod
     fun getDebugInfo(promise: Promise) {
         val s =
-            "AtlasNativeMic Android captureActive=$captureActive activeSession=$activeSessionId tornDown=$tornDown"
+            "AtlasNativeMic Android captureActive=$captureActive activeSession=$activeSessionId tornDown=$tornDown " +
+                "warm=${warmCapture != null} warmRunning=${warmCapture?.isRunning == true} " +
+                "preRollMs=${warmCapture?.preRollMs ?: 0}"
         promise.resolve(s)
     }
 
     companion object {
         private const val TAG = "AtlasNativeMic"
+        private const val DEFAULT_PRE_ROLL_MS = 500
+        private const val MAX_PRE_ROLL_MS = 2000
     }
 }
@@ -0,0 +1,199 @@
+package com.atlasnativemic
+
+import android.annotation.SuppressLint
+import android.media.AudioFormat
+import android.media.AudioRecord
+import android.media.MediaRecorder
+import android.os.Process
+import android.util.Log
+import java.io.File
+import java.io.FileOutputStream
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Always-warm mic input for AtlasNativeMic. One AudioRecord (16 kHz mono PCM16), read on its own
+ * thread, keeps filling a pre-roll ring. A session marks the current ring position and takes the
+ * last preRollMs of audio with it, so startCapture does no recorder setup and the first syllable
+ * is kept. start/stop and the session methods are called from the main thread.
+ */
+internal class WarmCapture(val preRollMs: Int) {
+
+    data class SessionResult(val durationMillis: Int, val preRollMillis: Int)
+
+    private val lock = Any()
+    private val ring = ShortArray(maxOf(1, SAMPLE_RATE * preRollMs / 1000))
+    private var written = 0L // samples pushed into the ring since start
+    private var sessionActive = false
+    private var session = ShortArray(0)
+    private var sessionLen = 0
+    private var sessionPreRoll = 0
+
+    private var record: AudioRecord? = null
+    private var reader: Thread? = null
+
+    @Volatile
+    private var running = false
+
+    val isRunning: Boolean
+        get() = running
+
+    /** Starts the recorder and reader thread; no-op when already running. Needs RECORD_AUDIO. */
+    @SuppressLint("MissingPermission")
+    fun start() {
+        if (running) return
+        stop(discard = false)
+        val minBytes = AudioRecord.getMinBufferSize(
+            SAMPLE_RATE,
+            AudioFormat.CHANNEL_IN_MONO,
+            AudioFormat.ENCODING_PCM_16BIT,
+        )
+        if (minBytes <= 0) throw IllegalStateException("AudioRecord unsupported ($minBytes)")
+        val r = AudioRecord(
+            MediaRecorder.AudioSource.MIC,
+            SAMPLE_RATE,
+            AudioFormat.CHANNEL_IN_MONO,
+            AudioFormat.ENCODING_PCM_16BIT,
+            maxOf(minBytes, SAMPLE_RATE / 5 * 2), // >= 200 ms
+        )
+        if (r.state != AudioRecord.STATE_INITIALIZED) {
+            r.release()
+            throw IllegalStateException("AudioRecord init failed")
+        }
+        r.startRecording()
+        if (r.recordingState != AudioRecord.RECORDSTATE_RECORDING) {
+            r.release()
+            throw IllegalStateException("AudioRecord start failed")
+        }
+        synchronized(lock) {
+            if (!sessionActive) written = 0
+        }
+        record = r
+        running = true
+        reader = Thread({ readLoop(r) }, "AtlasWarmMic").also { it.start() }
+        Log.i(TAG, "[AtlasNativeMic] warm input started 16 kHz, pre-roll $preRollMs ms")
+    }
+
+    /** Stops the recorder. discard = true also drops an active session. */
+    fun stop(discard: Boolean = true) {
+        running = false
+        record?.let {
+            try {
+                it.stop() // unblocks read()
+            } catch (_: Exception) {
+            }
+        }
+        reader?.join(500)
+        reader = null
+        record?.release()
+        record = null
+        if (discard) discardSession()
+    }
+
+    private fun readLoop(r: AudioRecord) {
+        Process.setThreadPriority(Process.THREAD_PRIORITY_URGENT_AUDIO)
+        val buf = ShortArray(CHUNK_SAMPLES)
+        while (running) {
+            val n = r.read(buf, 0, buf.size)
+            if (n < 0) {
+                // Dead recorder (audio server restart, mic taken); the next start() rebuilds it.
+                Log.w(TAG, "[AtlasNativeMic][E_AUDIO] warm read failed: $n")
+                running = false
+                break
+            }
+            if (n > 0) append(buf, n)
+        }
+    }
+
+    private fun append(samples: ShortArray, count: Int) {
+        synchronized(lock) {
+            val cap = ring.size
+            val skip = if (count > cap) count - cap else 0
+            var pos = ((written + skip) % cap).toInt()
+            for (i in skip until count) {
+                ring[pos] = samples[i]
+                if (++pos == cap) pos = 0
+            }
+            written += count
+            if (sessionActive) {
+                if (sessionLen + count > session.size) {
+                    session = session.copyOf(maxOf(session.size * 2, sessionLen + count))
+                }
+                System.arraycopy(samples, 0, session, sessionLen, count)
+                sessionLen += count
+            }
+        }
+    }
+
+    /** Starts collecting a session. Returns the pre-roll it includes, in ms. */
+    fun beginSession(): Int {
+        val fresh = ShortArray(SESSION_RESERVE_SAMPLES)
+        synchronized(lock) {
+            val cap = ring.size
+            val avail = if (preRollMs > 0) minOf(written, cap.toLong()).toInt() else 0
+            var pos = ((written - avail) % cap).toInt()
+            for (i in 0 until avail) {
+                fresh[i] = ring[pos]
+                if (++pos == cap) pos = 0
+            }
+            session = fresh
+            sessionLen = avail
+            sessionPreRoll = avail
+            sessionActive = true
+            return avail * 1000 / SAMPLE_RATE
+        }
+    }
+
+    /** Ends the session and writes it as a 16 kHz 16-bit mono WAV. Durations include the pre-roll. */
+    fun finishSession(out: File): SessionResult {
+        val pcm: ShortArray
+        val len: Int
+        val preRoll: Int
+        synchronized(lock) {
+            pcm = session
+            len = sessionLen
+            preRoll = sessionPreRoll
+            session = ShortArray(0)
+            sessionLen = 0
+            sessionPreRoll = 0
+            sessionActive = false
+        }
+        val dataBytes = len * 2
+        val bytes = ByteBuffer.allocate(44 + dataBytes).order(ByteOrder.LITTLE_ENDIAN)
+        bytes.put("RIFF".toByteArray(Charsets.US_ASCII))
+        bytes.putInt(36 + dataBytes)
+        bytes.put("WAVEfmt ".toByteArray(Charsets.US_ASCII))
+        bytes.putInt(16)
+        bytes.putShort(1) // PCM
+        bytes.putShort(1) // mono
+        bytes.putInt(SAMPLE_RATE)
+        bytes.putInt(SAMPLE_RATE * 2)
+        bytes.putShort(2)
+        bytes.putShort(16)
+        bytes.put("data".toByteArray(Charsets.US_ASCII))
+        bytes.putInt(dataBytes)
+        bytes.asShortBuffer().put(pcm, 0, len)
+        FileOutputStream(out).use { it.write(bytes.array()) }
+        return SessionResult(
+            durationMillis = (len.toLong() * 1000 / SAMPLE_RATE).toInt(),
+            preRollMillis = (preRoll.toLong() * 1000 / SAMPLE_RATE).toInt(),
+        )
+    }
+
+    fun discardSession() {
+        synchronized(lock) {
+            session = ShortArray(0)
+            sessionLen = 0
+            sessionPreRoll = 0
+            sessionActive = false
+        }
+    }
+
+    companion object {
+        private const val TAG = "AtlasNativeMic"
+        const val SAMPLE_RATE = 16000
+        private const val CHUNK_SAMPLES = SAMPLE_RATE / 50 // 20 ms reads
+        // Room for a typical utterance before the session buffer has to grow (on the reader thread).
+        private const val SESSION_RESERVE_SAMPLES = 30 * SAMPLE_RATE
+    }
+}
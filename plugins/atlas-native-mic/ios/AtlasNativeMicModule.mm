@@ -1,4 +1,5 @@
 #import "AtlasNativeMicModule.h"
+#import "AtlasWarmCapture.h"
 #import <AVFoundation/AVFoundation.h>
 #import <React/RCTLog.h>
 
@@ -11,8 +12,13 @@
 @property (nonatomic, copy) NSString *lastTerminalSessionId;
 @property (nonatomic, assign) BOOL lastTerminalWasFinalize;
 @property (nonatomic, assign) BOOL isTornDown;
+@property (nonatomic, strong) AtlasWarmCapture *warmCapture;
+@property (nonatomic, assign) BOOL warmSession;
 @end
 
+static const NSInteger kDefaultPreRollMs = 500;
+static const NSInteger kMaxPreRollMs = 2000;
+
 @implementation AtlasNativeMicModule
 
 RCT_EXPORT_MODULE(AtlasNativeMic);
@@ -61,12 +67,84 @@ RCT_EXPORT_METHOD(removeListeners : (NSInteger)count) {
   [self sendEventWithName:type body:body];
 }
 
-RCT_EXPORT_METHOD(init : (RCTPromiseResolveBlock)resolve rejecter : (RCTPromiseRejectBlock)reject) {
+RCT_EXPORT_METHOD(init
+                  : (NSDictionary *)options resolver
+                  : (RCTPromiseResolveBlock)resolve rejecter
+                  : (RCTPromiseRejectBlock)reject) {
   if (self.isTornDown) {
     reject(@"E_TORN_DOWN", @"AtlasNativeMic torn down", nil);
     return;
   }
-  RCTLogInfo(@"[AtlasNativeMic] init");
+  id warm = options[@"warm"];
+  if (![warm isKindOfClass:[NSNumber class]]) {
+    RCTLogInfo(@"[AtlasNativeMic] init");
+    resolve(nil);
+    return;
+  }
+  NSInteger preRollMs = kDefaultPreRollMs;
+  if ([options[@"preRollMs"] isKindOfClass:[NSNumber class]]) {
+    preRollMs = MAX(0, MIN(kMaxPreRollMs, [options[@"preRollMs"] integerValue]));
+  }
+
+  dispatch_async(dispatch_get_main_queue(), ^{
+    if (![warm boolValue]) {
+      if (self.warmCapture != nil && !self.warmSession) {
+        [self.warmCapture stop];
+        self.warmCapture = nil;
+      }
+      RCTLogInfo(@"[AtlasNativeMic] init warm=0");
+      resolve(nil);
+      return;
+    }
+    if (self.warmCapture != nil && self.warmCapture.preRollMs != preRollMs && !self.warmSession) {
+      [self.warmCapture stop];
+      self.warmCapture = nil;
+    }
+    if (self.warmCapture == nil) {
+      self.warmCapture = [[AtlasWarmCapture alloc] initWithPreRollMs:preRollMs];
+    }
+    // Warm up now only if that cannot prompt; otherwise the first startCapture asks and starts it.
+    if (!self.captureActive &&
+        [AVAudioSession sharedInstance].recordPermission == AVAudioSessionRecordPermissionGranted) {
+      NSError *err = nil;
+      if (![self.warmCapture start:&err]) {
+        RCTLogWarn(@"[AtlasNativeMic][E_AUDIO] warm start deferred: %@", err);
+      }
+    }
+    RCTLogInfo(@"[AtlasNativeMic] init warm=1 preRollMs=%ld running=%d",
+               (long)preRollMs, self.warmCapture.isRunning);
+    resolve(nil);
+  });
+}
+
+- (void)beginWarmCapture:(NSString *)sessionId
+                resolver:(RCTPromiseResolveBlock)resolve
+                rejecter:(RCTPromiseRejectBlock)reject {
+  if (self.captureActive) {
+    reject(@"E_SESSION_ACTIVE", @"Another capture session is active", nil);
+    return;
+  }
+  NSError *err = nil;
+  if (![self.warmCapture start:&err]) {
+    RCTLogError(@"[AtlasNativeMic][E_AUDIO] warm start: %@", err);
+    reject(@"E_AUDIO", err ? err.localizedDescription : @"Warm input start failed", err);
+    return;
+  }
+  NSInteger preRollMs = [self.warmCapture beginSession];
+  self.recordingPath = [NSTemporaryDirectory()
+      stringByAppendingPathComponent:[NSString stringWithFormat:@"atlas_mic_%@.wav", sessionId]];
+  self.warmSession = YES;
+  self.activeSessionId = sessionId;
+  self.captureActive = YES;
+  self.lastTerminalSessionId = nil;
+  self.lastTerminalWasFinalize = NO;
+
+  [self sendMicEvent:@"mic_capture_started"
+           sessionId:sessionId
+               phase:@"capturing"
+              extras:nil];
+  RCTLogInfo(@"[AtlasNativeMic] capture started %@ (warm, pre-roll %ld ms)", sessionId,
+             (long)preRollMs);
   resolve(nil);
 }
 
@@ -95,6 +173,24 @@ RCT_EXPORT_METHOD(startCapture
     }
 
     AVAudioSession *session = [AVAudioSession sharedInstance];
+    if (self.warmCapture != nil) {
+      if (session.recordPermission == AVAudioSessionRecordPermissionGranted) {
+        [self beginWarmCapture:sessionId resolver:resolve rejecter:reject];
+        return;
+      }
+      [session requestRecordPermission:^(BOOL granted) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+          if (!granted) {
+            RCTLogError(@"[AtlasNativeMic][E_PERMISSION] denied");
+            reject(@"E_PERMISSION", @"Microphone permission denied", nil);
+            return;
+          }
+          [self beginWarmCapture:sessionId resolver:resolve rejecter:reject];
+        });
+      }];
+      return;
+    }
+
     __block BOOL sessionActivated = NO;
     [session requestRecordPermission:^(BOOL granted) {
       if (!granted) {
@@ -208,19 +304,38 @@ RCT_EXPORT_METHOD(stopFinalize
                  phase:@"stopping"
                 extras:nil];
 
-    NSTimeInterval seconds = self.recorder.currentTime;
-    [self.recorder stop];
-    self.recorder = nil;
+    long ms = 0;
+    long preRollMs = 0;
+    NSError *err = nil;
+    if (self.warmSession) {
+      // The input stays warm for the next session; only this session's audio is written out.
+      BOOL written = [self.warmCapture finishSessionToPath:self.recordingPath
+                                             durationMillis:&ms
+                                              preRollMillis:&preRollMs
+                                                      error:&err];
+      self.warmSession = NO;
+      if (!written) {
+        RCTLogError(@"[AtlasNativeMic][E_AUDIO] warm session write: %@", err);
+        self.captureActive = NO;
+        self.activeSessionId = nil;
+        self.isStopping = NO;
+        self.recordingPath = nil;
+        reject(@"E_AUDIO", err ? err.localizedDescription : @"Capture write failed", err);
+        return;
+      }
+    } else {
+      NSTimeInterval seconds = self.recorder.currentTime;
+      [self.recorder stop];
+      self.recorder = nil;
+      [[AVAudioSession sharedInstance] setActive:NO
+                                     withOptions:AVAudioSessionSetActiveOptionNotifyOthersOnDeactivation
+                                           error:&err];
+      ms = (long)lround(seconds * 1000.0);
+    }
     self.captureActive = NO;
     self.activeSessionId = nil;
     self.isStopping = NO;
 
-    NSError *err = nil;
-    [[AVAudioSession sharedInstance] setActive:NO
-                                   withOptions:AVAudioSessionSetActiveOptionNotifyOthersOnDeactivation
-                                         error:&err];
-
-    long ms = (long)lround(seconds * 1000.0);
     NSString *uri = self.recordingPath ?: @"";
     self.recordingPath = nil;
 
@@ -232,10 +347,12 @@ RCT_EXPORT_METHOD(stopFinalize
                  phase:@"finalized"
                 extras:nil];
 
-    RCTLogInfo(@"[AtlasNativeMic] capture finalized %@ ms=%ld", sessionId, (long)ms);
+    RCTLogInfo(@"[AtlasNativeMic] capture finalized %@ ms=%ld preRollMs=%ld", sessionId, (long)ms,
+               (long)preRollMs);
     resolve(@{
       @"uri" : uri,
       @"durationMillis" : @(ms),
+      @"preRollMillis" : @(preRollMs),
       @"duplicate" : @NO,
     });
   });
@@ -270,8 +387,14 @@ RCT_EXPORT_METHOD(cancel
       return;
     }
 
-    [self.recorder stop];
-    self.recorder = nil;
+    BOOL wasWarm = self.warmSession;
+    if (wasWarm) {
+      [self.warmCapture discardSession];
+      self.warmSession = NO;
+    } else {
+      [self.recorder stop];
+      self.recorder = nil;
+    }
     self.captureActive = NO;
     self.activeSessionId = nil;
     NSString *path = self.recordingPath;
@@ -280,10 +403,12 @@ RCT_EXPORT_METHOD(cancel
       [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
     }
 
-    NSError *err = nil;
-    [[AVAudioSession sharedInstance] setActive:NO
-                                   withOptions:AVAudioSessionSetActiveOptionNotifyOthersOnDeactivation
-                                         error:&err];
+    if (!wasWarm) {
+      NSError *err = nil;
+      [[AVAudioSession sharedInstance] setActive:NO
+                                     withOptions:AVAudioSessionSetActiveOptionNotifyOthersOnDeactivation
+                                           error:&err];
+    }
 
     self.lastTerminalSessionId = sessionId;
     self.lastTerminalWasFinalize = NO;
@@ -306,6 +431,9 @@ RCT_EXPORT_METHOD(teardown : (RCTPromiseResolveBlock)resolve rejecter : (RCTProm
       [self.recorder stop];
       self.recorder = nil;
     }
+    [self.warmCapture stop];
+    self.warmCapture = nil;
+    self.warmSession = NO;
     self.captureActive = NO;
     self.activeSessionId = nil;
     if (self.recordingPath.length) {
@@ -323,10 +451,14 @@ RCT_EXPORT_METHOD(teardown : (RCTPromiseResolveBlock)resolve rejecter : (RCTProm
 
 RCT_EXPORT_METHOD(getDebugInfo : (RCTPromiseResolveBlock)resolve rejecter : (RCTPromiseRejectBlock)reject) {
   NSString *s = [NSString stringWithFormat:
-                              @"AtlasNativeMic iOS captureActive=%d activeSession=%@ tornDown=%d",
+                              @"AtlasNativeMic iOS captureActive=%d activeSession=%@ tornDown=%d "
+                              @"warm=%d warmRunning=%d preRollMs=%ld",
                               self.captureActive,
                               self.activeSessionId ?: @"(nil)",
-                              self.isTornDown];
+                              self.isTornDown,
+                              self.warmCapture != nil,
+                              self.warmCapture.isRunning,
+                              (long)self.warmCapture.preRollMs];
   resolve(s);
 }
 
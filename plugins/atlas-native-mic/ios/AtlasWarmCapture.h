@@ -0,0 +1,35 @@
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Always-warm mic input for AtlasNativeMic. One AVAudioEngine input tap, converted to 16 kHz mono
+ * int16, keeps filling a pre-roll ring. A session marks the current ring position and takes the last
+ * preRollMs of audio with it, so startCapture does no audio session or recorder setup and the first
+ * syllable is kept. Session methods and start/stop are main-queue only.
+ */
+@interface AtlasWarmCapture : NSObject
+
+@property (nonatomic, readonly) NSInteger preRollMs;
+@property (nonatomic, readonly, getter=isRunning) BOOL running;
+
+- (instancetype)initWithPreRollMs:(NSInteger)preRollMs NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Sets PlayAndRecord and starts the engine. No-op when already running with that category. */
+- (BOOL)start:(NSError **)error;
+/** Stops the engine and deactivates the audio session. An active session is discarded. */
+- (void)stop;
+
+/** Starts collecting a session. Returns the pre-roll it includes, in ms. */
+- (NSInteger)beginSession;
+/** Ends the session and writes it as a 16 kHz 16-bit mono WAV. Durations include the pre-roll. */
+- (BOOL)finishSessionToPath:(NSString *)path
+             durationMillis:(long *)durationMillis
+              preRollMillis:(long *)preRollMillis
+                      error:(NSError **)error;
+- (void)discardSession;
+
+@end
+
+NS_ASSUME_NONNULL_END
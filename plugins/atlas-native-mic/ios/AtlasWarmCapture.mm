@@ -0,0 +1,312 @@
+#import "AtlasWarmCapture.h"
+#import <AVFoundation/AVFoundation.h>
+#import <React/RCTLog.h>
+#include <os/lock.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+static const double kWarmSampleRate = 16000.0;
+// Room for a typical utterance before the session buffer has to grow (on the tap thread).
+static const size_t kSessionReserveSamples = 30 * 16000;
+
+static NSError *WarmError(NSString *message) {
+  return [NSError errorWithDomain:@"AtlasNativeMic"
+                             code:-1
+                         userInfo:@{NSLocalizedDescriptionKey : message}];
+}
+
+@implementation AtlasWarmCapture {
+  AVAudioEngine *_engine;
+  AVAudioFormat *_outFormat;
+  id _configObserver;
+  id _interruptionObserver;
+
+  // Guarded by _lock; written by the tap, read by the session methods.
+  os_unfair_lock _lock;
+  std::vector<int16_t> _ring;
+  uint64_t _written;  // samples pushed into the ring since start
+  bool _sessionActive;
+  std::vector<int16_t> _session;
+  size_t _sessionPreRoll;
+}
+
+- (instancetype)initWithPreRollMs:(NSInteger)preRollMs {
+  if ((self = [super init])) {
+    _preRollMs = std::max<NSInteger>(0, preRollMs);
+    _lock = OS_UNFAIR_LOCK_INIT;
+    _ring.assign(std::max<size_t>(1, (size_t)llround(kWarmSampleRate * _preRollMs / 1000.0)), 0);
+    _outFormat = [[AVAudioFormat alloc] initWithCommonFormat:AVAudioPCMFormatInt16
+                                                  sampleRate:kWarmSampleRate
+                                                    channels:1
+                                                 interleaved:YES];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [self stopEngine];
+}
+
+- (BOOL)isRunning {
+  return _engine.isRunning;
+}
+
+- (BOOL)start:(NSError **)error {
+  AVAudioSession *session = [AVAudioSession sharedInstance];
+  BOOL categoryOk = [session.category isEqualToString:AVAudioSessionCategoryPlayAndRecord];
+  if (_engine.isRunning && categoryOk) {
+    return YES;
+  }
+  [self stopEngine];
+
+  NSError *err = nil;
+  if (!categoryOk) {
+    [session setCategory:AVAudioSessionCategoryPlayAndRecord
+             withOptions:AVAudioSessionCategoryOptionAllowBluetooth |
+                         AVAudioSessionCategoryOptionDefaultToSpeaker
+                   error:&err];
+    if (err) {
+      if (error) *error = err;
+      return NO;
+    }
+  }
+  [session setActive:YES withOptions:0 error:&err];
+  if (err) {
+    if (error) *error = err;
+    return NO;
+  }
+  if (![self startEngine:error]) {
+    return NO;
+  }
+
+  __weak AtlasWarmCapture *weakSelf = self;
+  // Route changes (headset, Bluetooth) stop the engine and may change the input format. Observed
+  // for any engine because a restart replaces ours; restartAfter: ignores a running engine.
+  _configObserver = [[NSNotificationCenter defaultCenter]
+      addObserverForName:AVAudioEngineConfigurationChangeNotification
+                   object:nil
+                    queue:[NSOperationQueue mainQueue]
+               usingBlock:^(NSNotification *note) {
+                 [weakSelf restartAfter:@"configuration change"];
+               }];
+  _interruptionObserver = [[NSNotificationCenter defaultCenter]
+      addObserverForName:AVAudioSessionInterruptionNotification
+                   object:nil
+                    queue:[NSOperationQueue mainQueue]
+               usingBlock:^(NSNotification *note) {
+                 NSNumber *type = note.userInfo[AVAudioSessionInterruptionTypeKey];
+                 if (type.unsignedIntegerValue == AVAudioSessionInterruptionTypeEnded) {
+                   [weakSelf restartAfter:@"interruption"];
+                 }
+               }];
+  return YES;
+}
+
+- (BOOL)startEngine:(NSError **)error {
+  _engine = [[AVAudioEngine alloc] init];
+  AVAudioInputNode *input = _engine.inputNode;
+  AVAudioFormat *inFormat = [input outputFormatForBus:0];
+  if (inFormat.sampleRate <= 0 || inFormat.channelCount == 0) {
+    _engine = nil;
+    if (error) *error = WarmError(@"No audio input available");
+    return NO;
+  }
+  AVAudioConverter *converter = [[AVAudioConverter alloc] initFromFormat:inFormat
+                                                                toFormat:_outFormat];
+  if (!converter) {
+    _engine = nil;
+    if (error) *error = WarmError(@"Unsupported input format");
+    return NO;
+  }
+
+  {
+    os_unfair_lock_lock(&_lock);
+    if (!_sessionActive) _written = 0;
+    os_unfair_lock_unlock(&_lock);
+  }
+
+  // The converter and its output buffer belong to this tap; a restart builds new ones.
+  AVAudioFormat *outFormat = _outFormat;
+  double ratio = kWarmSampleRate / inFormat.sampleRate;
+  __block AVAudioPCMBuffer *outBuffer = nil;
+  __weak AtlasWarmCapture *weakSelf = self;
+  [input installTapOnBus:0
+              bufferSize:1024
+                  format:inFormat
+                   block:^(AVAudioPCMBuffer *buffer, AVAudioTime *when) {
+                     AVAudioFrameCount capacity =
+                         (AVAudioFrameCount)std::ceil(buffer.frameLength * ratio) + 32;
+                     if (outBuffer == nil || outBuffer.frameCapacity < capacity) {
+                       outBuffer = [[AVAudioPCMBuffer alloc] initWithPCMFormat:outFormat
+                                                                 frameCapacity:capacity];
+                     }
+                     outBuffer.frameLength = 0;
+                     __block BOOL supplied = NO;
+                     NSError *convErr = nil;
+                     AVAudioConverterOutputStatus status = [converter
+                         convertToBuffer:outBuffer
+                                   error:&convErr
+                      withInputFromBlock:^AVAudioBuffer *(AVAudioPacketCount count,
+                                                          AVAudioConverterInputStatus *inStatus) {
+                        if (supplied) {
+                          *inStatus = AVAudioConverterInputStatus_NoDataNow;
+                          return nil;
+                        }
+                        supplied = YES;
+                        *inStatus = AVAudioConverterInputStatus_HaveData;
+                        return buffer;
+                      }];
+                     if (status == AVAudioConverterOutputStatus_Error || outBuffer.frameLength == 0) {
+                       return;
+                     }
+                     [weakSelf append:outBuffer.int16ChannelData[0] count:outBuffer.frameLength];
+                   }];
+  [_engine prepare];
+  if (![_engine startAndReturnError:error]) {
+    [input removeTapOnBus:0];
+    _engine = nil;
+    return NO;
+  }
+  RCTLogInfo(@"[AtlasNativeMic] warm input started %.0f Hz x%u -> 16 kHz, pre-roll %ld ms",
+             inFormat.sampleRate, (unsigned)inFormat.channelCount, (long)_preRollMs);
+  return YES;
+}
+
+- (void)restartAfter:(NSString *)reason {
+  if (_engine == nil || _engine.isRunning) {
+    return;
+  }
+  [_engine.inputNode removeTapOnBus:0];
+  [_engine stop];
+  _engine = nil;
+  NSError *err = nil;
+  [[AVAudioSession sharedInstance] setActive:YES withOptions:0 error:&err];
+  if (err || ![self startEngine:&err]) {
+    RCTLogWarn(@"[AtlasNativeMic][E_AUDIO] warm restart after %@ failed: %@", reason, err);
+  }
+}
+
+- (void)stopEngine {
+  if (_configObserver) {
+    [[NSNotificationCenter defaultCenter] removeObserver:_configObserver];
+    _configObserver = nil;
+  }
+  if (_interruptionObserver) {
+    [[NSNotificationCenter defaultCenter] removeObserver:_interruptionObserver];
+    _interruptionObserver = nil;
+  }
+  if (_engine) {
+    [_engine.inputNode removeTapOnBus:0];
+    [_engine stop];
+    _engine = nil;
+  }
+}
+
+- (void)stop {
+  BOOL wasStarted = _engine != nil;
+  [self stopEngine];
+  [self discardSession];
+  if (wasStarted) {
+    NSError *err = nil;
+    [[AVAudioSession sharedInstance] setActive:NO
+                                   withOptions:AVAudioSessionSetActiveOptionNotifyOthersOnDeactivation
+                                         error:&err];
+    if (err) {
+      RCTLogWarn(@"[AtlasNativeMic][E_AUDIO] warm setActive:NO failed: %@", err);
+    }
+  }
+}
+
+// Tap thread.
+- (void)append:(const int16_t *)samples count:(size_t)count {
+  os_unfair_lock_lock(&_lock);
+  size_t cap = _ring.size();
+  size_t skip = count > cap ? count - cap : 0;
+  size_t pos = (size_t)((_written + skip) % cap);
+  for (size_t i = skip; i < count; ++i) {
+    _ring[pos] = samples[i];
+    if (++pos == cap) pos = 0;
+  }
+  _written += count;
+  if (_sessionActive) {
+    _session.insert(_session.end(), samples, samples + count);
+  }
+  os_unfair_lock_unlock(&_lock);
+}
+
+- (NSInteger)beginSession {
+  std::vector<int16_t> fresh;
+  fresh.reserve(kSessionReserveSamples);
+  os_unfair_lock_lock(&_lock);
+  size_t cap = _ring.size();
+  size_t avail = (size_t)std::min<uint64_t>(_written, _preRollMs > 0 ? cap : 0);
+  size_t pos = (size_t)((_written - avail) % cap);
+  for (size_t i = 0; i < avail; ++i) {
+    fresh.push_back(_ring[pos]);
+    if (++pos == cap) pos = 0;
+  }
+  _session.swap(fresh);
+  _sessionPreRoll = avail;
+  _sessionActive = true;
+  os_unfair_lock_unlock(&_lock);
+  return (NSInteger)llround(avail * 1000.0 / kWarmSampleRate);
+}
+
+- (BOOL)finishSessionToPath:(NSString *)path
+             durationMillis:(long *)durationMillis
+              preRollMillis:(long *)preRollMillis
+                      error:(NSError **)error {
+  std::vector<int16_t> pcm;
+  os_unfair_lock_lock(&_lock);
+  pcm.swap(_session);
+  size_t preRoll = _sessionPreRoll;
+  _sessionActive = false;
+  _sessionPreRoll = 0;
+  os_unfair_lock_unlock(&_lock);
+
+  uint32_t dataBytes = (uint32_t)(pcm.size() * sizeof(int16_t));
+  uint32_t rate = (uint32_t)kWarmSampleRate;
+  uint8_t header[44];
+  auto put32 = [&header](size_t at, uint32_t v) {
+    for (int i = 0; i < 4; ++i) header[at + i] = (uint8_t)(v >> (8 * i));
+  };
+  auto put16 = [&header](size_t at, uint16_t v) {
+    header[at] = (uint8_t)v;
+    header[at + 1] = (uint8_t)(v >> 8);
+  };
+  std::memcpy(header, "RIFF", 4);
+  put32(4, 36 + dataBytes);
+  std::memcpy(header + 8, "WAVEfmt ", 8);
+  put32(16, 16);
+  put16(20, 1);  // PCM
+  put16(22, 1);  // mono
+  put32(24, rate);
+  put32(28, rate * 2);
+  put16(32, 2);
+  put16(34, 16);
+  std::memcpy(header + 36, "data", 4);
+  put32(40, dataBytes);
+
+  // iOS devices are little-endian, so the samples go out as they are.
+  NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + dataBytes];
+  [data appendBytes:header length:sizeof(header)];
+  if (dataBytes > 0) {
+    [data appendBytes:pcm.data() length:dataBytes];
+  }
+  if (durationMillis) *durationMillis = (long)llround(pcm.size() * 1000.0 / kWarmSampleRate);
+  if (preRollMillis) *preRollMillis = (long)llround(preRoll * 1000.0 / kWarmSampleRate);
+  return [data writeToFile:path options:NSDataWritingAtomic error:error];
+}
+
+- (void)discardSession {
+  std::vector<int16_t> drop;
+  os_unfair_lock_lock(&_lock);
+  drop.swap(_session);
+  _sessionActive = false;
+  _sessionPreRoll = 0;
+  os_unfair_lock_unlock(&_lock);
+}
+
+@end
@@ -39,6 +39,20 @@ export interface MicEventPayload {
 export interface StopFinalizeResult {
   uri: string;
   durationMillis: number;
+  /** Audio from before startCapture included at the head of the file (warm capture; else 0). */
+  preRollMillis?: number;
   /** True when stopFinalize was a duplicate after terminal (no new file). */
   duplicate?: boolean;
 }
+
+/**
+ * init() options. `warm: true` keeps the mic input open between sessions, filling a pre-roll ring
+ * (`preRollMs`, default 500, max 2000), so startCapture is immediate and keeps the audio just
+ * before it; the file is then 16 kHz 16-bit mono WAV. `warm: false` releases the input; omitting
+ * `warm` leaves the current mode unchanged. The input only warms up at init once record
+ * permission is granted (init never prompts).
+ */
+export interface MicInitOptions {
+  warm?: boolean;
+  preRollMs?: number;
+}
@@ -11,6 +11,7 @@ import type { PluginEventPayload } from '../../../src/shared/types/plugin-contra
 import {
   MIC_EVENT_TYPES,
   type MicEventPayload,
+  type MicInitOptions,
   type MicSessionPhase,
   type StopFinalizeResult,
 } from './contract';
@@ -32,7 +33,7 @@ function emitToListeners(event: MicEventPayload): void {
 }
 
 function getNative(): {
-  init?: () => Promise<void>;
+  init?: (options: MicInitOptions) => Promise<void>;
   startCapture?: (sessionId: string) => Promise<void>;
   stopFinalize?: (sessionId: string) => Promise<StopFinalizeResult>;
   cancel?: (sessionId: string) => Promise<void>;
@@ -102,15 +103,15 @@ function toPluginPayload(e: MicEventPayload): PluginEventPayload {
 }
 
 export { MIC_EVENT_TYPES };
-export type { MicEventPayload, StopFinalizeResult };
+export type { MicEventPayload, MicInitOptions, StopFinalizeResult };
 
 export default {
   subscribe,
 
-  async init(): Promise<void> {
+  async init(options?: MicInitOptions): Promise<void> {
     const n = getNative();
     if (!n?.init) throw new Error(MODULE_MISSING_MSG);
-    await n.init();
+    await n.init(options ?? {});
   },
 
   async startCapture(sessionId: string): Promise<void> {
@@ -136,7 +137,9 @@ export default {
     const uri = typeof r?.uri === 'string' ? r.uri : '';
     const durationMillis =
       typeof r?.durationMillis === 'number' ? r.durationMillis : 0;
-    return { uri, durationMillis, duplicate: !!r?.duplicate };
+    const preRollMillis =
+      typeof r?.preRollMillis === 'number' ? r.preRollMillis : 0;
+    return { uri, durationMillis, preRollMillis, duplicate: !!r?.duplicate };
   },
 
   async cancel(sessionId: string): Promise<void> {
@@ -1,5 +1,6 @@
 package com.pipertts
 
+import android.content.res.AssetManager
 import android.media.AudioAttributes
 import android.media.AudioFormat
 import android.media.AudioTrack
@@ -61,6 +62,32 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
             } catch (e: Exception) {
                 Log.e(TAG, "[Piper] init copy failed: ${e.message}", e)
             }
+            loadSpeechPack()
+        }
+    }
+
+    /**
+     * Content pack ships pre-rendered canned lines at audio/speech_pack.bin (assets root). Copy it to
+     * files/piper/ (re-copied when the app is updated) so native can mmap it; synthesis then serves those
+     * lines from the pack.
+     */
+    private fun loadSpeechPack() {
+        try {
+            if (reactApplicationContext.assets.list("audio")?.contains("speech_pack.bin") != true) return
+            val dir = reactApplicationContext.filesDir.resolve("piper").also { it.mkdirs() }
+            val pack = dir.resolve("speech_pack.bin")
+            val marker = dir.resolve("speech_pack.version")
+            val version = reactApplicationContext.packageManager
+                .getPackageInfo(reactApplicationContext.packageName, 0).lastUpdateTime.toString()
+            if (!pack.exists() || !marker.exists() || marker.readText() != version) {
+                if (!copyAssetToFile("audio/speech_pack.bin", pack)) return
+                marker.writeText(version)
+            }
+            val entries = nativeSetAudioPack(pack.absolutePath)
+            if (entries < 0) Log.w(TAG, "[Piper] speech pack invalid: ${pack.absolutePath}")
+            else Log.i(TAG, "[Piper] speech pack loaded: $entries lines")
+        } catch (e: Exception) {
+            Log.e(TAG, "[Piper] speech pack load failed: ${e.message}", e)
         }
     }
 
@@ -71,6 +98,8 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
 
     @ReactMethod
     fun stop() {
+        // Set before queueing so a streaming speak() already on the executor sees it at the next clause.
+        stopPlaybackRequested = true
         executor.execute {
             stopPlaybackRequested = true
             val t = activeAudioTrack
@@ -117,6 +146,38 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
         }
     }
 
+    /**
+     * Syncs the bundled RAG pack (assets/content_pack) into files/content_pack, copying only files whose
+     * pack_files.json hash changed. Resolves with the destination path. Rejects E_NO_PACK_MANIFEST when the
+     * bundled pack has no pack_files.json (caller falls back to a full copy).
+     */
+    @ReactMethod
+    fun syncContentPack(promise: Promise) {
+        Thread({
+            try {
+                val dest = reactApplicationContext.filesDir.resolve("content_pack").also { it.mkdirs() }
+                val result = nativeSyncPack(reactApplicationContext.assets, "content_pack", dest.absolutePath)
+                val report = result?.getOrNull(0) as? LongArray
+                val error = result?.getOrNull(1) as? String
+                if (report == null || error != null) {
+                    val manifestMissing = report != null && report[10] == PACK_SYNC_MANIFEST_MISSING
+                    Log.w(TAG, "[syncContentPack] ${error ?: "sync failed"}")
+                    promise.reject(if (manifestMissing) "E_NO_PACK_MANIFEST" else "E_PACK_SYNC", error ?: "Pack sync failed")
+                    return@Thread
+                }
+                Log.i(
+                    TAG,
+                    "[syncContentPack] ${report[0]} files: ${report[1]} copied, ${report[3]} verified, " +
+                        "${report[4]} skipped, ${report[5]} removed; ${report[7] / 1024} KB in ${report[9]} ms"
+                )
+                promise.resolve(dest.absolutePath)
+            } catch (e: Exception) {
+                Log.e(TAG, "[syncContentPack] ${e.message}", e)
+                promise.reject("E_PACK_SYNC", e.message ?: "Pack sync failed", e)
+            }
+        }, "PiperPackSync").start()
+    }
+
     @ReactMethod
     fun speak(text: String, promise: Promise) {
         if (text.isBlank()) {
@@ -134,7 +195,8 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
                     activeSpeakPromise = null
                     return@execute
                 }
-                val espeakPath = getEspeakDataPath()
+                // Text-type voices ("phoneme_type": "text") need no espeak-ng data.
+                val espeakPath = if (nativeVoiceNeedsEspeak(configPath)) getEspeakDataPath() else ""
                 if (espeakPath == null) {
                     Log.e(TAG, "[E_NO_ESPEAK_DATA] espeak-ng-data not found. Run: ./scripts/download-espeak-ng-data.sh then rebuild the app.")
                     promise.reject("E_NO_ESPEAK_DATA", "espeak-ng-data not found. Run: ./scripts/download-espeak-ng-data.sh then rebuild the app.")
@@ -143,6 +205,11 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
                 }
                 val sentenceMs = getOptionInt("interSentenceSilenceMs", 0)
                 val commaMs = getOptionInt("interCommaSilenceMs", 0)
+                // Comma pauses are placed proportionally over the whole utterance, so they need single-pass PCM.
+                if (commaMs <= 0 && getOptionBoolean("streamSynthesis", true)) {
+                    speakStreaming(modelPath, configPath, espeakPath, text, sentenceMs, promise)
+                    return@execute
+                }
                 val result = nativeSynthesize(modelPath, configPath, espeakPath, text)
                 val parsed = parseNativePcmResult(result, promise, "full text")
                     ?: run {
@@ -164,6 +231,30 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
         }
     }
 
+    /**
+     * Installs JSI host functions (global.__piperEmbed for query embedding, __piperAsr* for streaming ASR,
+     * __piperQueryCache* and __piperSynthesisMemoryStats).
+     * Blocking sync so it runs on the JS thread that owns the runtime; false if no runtime yet.
+     */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun installJsi(): Boolean {
+        val runtimePtr = reactApplicationContext.javaScriptContextHolder?.get() ?: 0L
+        if (runtimePtr == 0L) return false
+        return nativeInstallJsi(runtimePtr, reactApplicationContext.assets)
+    }
+
+    /** Installs the JSI host functions; assets backs __piperReadAssetBinary (bundled pack files). */
+    private external fun nativeInstallJsi(runtimePtr: Long, assets: AssetManager): Boolean
+
+    /** Loads the audio pack (null unloads); returns its entry count or -1. */
+    private external fun nativeSetAudioPack(path: String?): Int
+
+    /** False for "phoneme_type": "text" voices (piper::voiceNeedsEspeak). */
+    private external fun nativeVoiceNeedsEspeak(configPath: String): Boolean
+
+    /** Incremental pack sync (pack_sync.h); returns [long[] report, String errorOrNull]. */
+    private external fun nativeSyncPack(assets: AssetManager, assetRoot: String, destDir: String): Array<Any?>?
+
     private external fun nativeSynthesize(
         modelPath: String,
         configPath: String,
@@ -172,7 +263,229 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
     ): Array<Any>?
 
     /**
-     * Parses native [ByteArray, sampleRate] or error string; rejects [promise] on failure.
+     * Receives each synthesized clause from nativeSynthesizeStream on the synthesis thread (method ID cached in
+     * JNI_OnLoad). [sampleOffset] is the clause's first sample within the utterance. Return false to cancel.
+     */
+    fun interface ChunkSink {
+        fun onChunk(pcm: ByteArray, sampleRate: Int, sampleOffset: Long): Boolean
+    }
+
+    private external fun nativeSynthesizeStream(
+        modelPath: String,
+        configPath: String,
+        espeakPath: String,
+        text: String,
+        sink: ChunkSink
+    ): Array<Any>?
+
+    /**
+     * Streams clause PCM into an AudioTrack (MODE_STREAM) as native produces it, so playback starts after the
+     * first clause. AudioTrack.write blocks while its buffer is full, which paces synthesis to playback.
+     */
+    private fun speakStreaming(
+        modelPath: String,
+        configPath: String,
+        espeakPath: String,
+        text: String,
+        sentenceMs: Int,
+        promise: Promise,
+    ) {
+        val startNs = System.nanoTime()
+        var track: AudioTrack? = null
+        var renderer: StreamingPcmRenderer? = null
+        var framesWritten = 0L
+        var expectedOffset = 0L
+        val sink = ChunkSink { pcm, sampleRate, sampleOffset ->
+            if (stopPlaybackRequested) return@ChunkSink false
+            if (sampleOffset != expectedOffset) {
+                Log.w(TAG, "[Piper] stream chunk offset $sampleOffset, expected $expectedOffset")
+            }
+            expectedOffset = sampleOffset + pcm.size / 2
+            val t = track ?: createStreamTrack(sampleRate).also {
+                track = it
+                renderer = StreamingPcmRenderer(sampleRate, lastSpeakOptions, sentenceMs)
+                activeAudioTrack = it
+                it.play()
+                Log.d(TAG, "[Piper] stream first clause after ${(System.nanoTime() - startNs) / 1_000_000} ms")
+            }
+            val out = renderer!!.process(pcm)
+            framesWritten += writeFully(t, out) / 2
+            !stopPlaybackRequested
+        }
+        val result = nativeSynthesizeStream(modelPath, configPath, espeakPath, text, sink)
+        (result?.getOrNull(2) as? LongArray)?.let { logMemoryReport(it) }
+        val t = track
+        if (stopPlaybackRequested) {
+            releaseTrack(t)
+            rejectCancelled(promise)
+            return
+        }
+        if (result == null || result.size < 2 || result[0] == null || t == null) {
+            releaseTrack(t)
+            val message = (result?.getOrNull(1) as? String) ?: "Synthesis failed. Native Piper pipeline returned no result."
+            Log.e(TAG, "[E_SYNTHESIS] $message")
+            activeSpeakPromise = null
+            promise.reject("E_SYNTHESIS", message)
+            return
+        }
+        framesWritten += writeFully(t, renderer!!.finish()) / 2
+        Log.d(TAG, "[Piper] stream synthesize ok: ${result[0]} samples, $framesWritten frames written")
+        awaitPlaybackAndRelease(t, framesWritten, promise)
+    }
+
+    private fun createStreamTrack(sampleRate: Int): AudioTrack {
+        val minBuffer = AudioTrack.getMinBufferSize(sampleRate, AudioFormat.CHANNEL_OUT_MONO, AudioFormat.ENCODING_PCM_16BIT)
+        return AudioTrack.Builder()
+            .setAudioAttributes(
+                AudioAttributes.Builder()
+                    .setUsage(AudioAttributes.USAGE_MEDIA)
+                    .setContentType(AudioAttributes.CONTENT_TYPE_SPEECH)
+                    .build()
+            )
+            .setAudioFormat(
+                AudioFormat.Builder()
+                    .setEncoding(AudioFormat.ENCODING_PCM_16BIT)
+                    .setSampleRate(sampleRate)
+                    .setChannelMask(AudioFormat.CHANNEL_OUT_MONO)
+                    .build()
+            )
+            // ~0.5 s of headroom so the next clause can synthesize while this one plays.
+            .setBufferSizeInBytes(maxOf(minBuffer, sampleRate))
+            .setTransferMode(AudioTrack.MODE_STREAM)
+            .build()
+    }
+
+    /** Blocking MODE_STREAM write of all of [data] unless stopped; returns bytes written. */
+    private fun writeFully(track: AudioTrack, data: ByteArray): Int {
+        var off = 0
+        while (off < data.size && !stopPlaybackRequested) {
+            val n = track.write(data, off, data.size - off)
+            if (n <= 0) break
+            off += n
+        }
+        return off
+    }
+
+    /**
+     * Incremental form of applyPiperPostSynthesisRender for streamed clauses: lead silence once, inter-clause
+     * silence, gain, high-pass and layer2 carry their state across chunks, and the last [tailFadeMs] is held
+     * back so the end fade lands on the final samples.
+     */
+    private inner class StreamingPcmRenderer(
+        private val sampleRate: Int,
+        opts: ReadableMap?,
+        private val interClauseMs: Int,
+    ) {
+        private var first = true
+        private val leadSamples = if (opts != null && opts.hasKey("renderLeadSilenceMs")) {
+            (sampleRate * opts.getDouble("renderLeadSilenceMs").toLong() / 1000).toInt().coerceIn(0, 10_000_000)
+        } else {
+            0
+        }
+        private val gainLinear = if (opts != null && opts.hasKey("renderPostGainDb")) {
+            10.0.pow(opts.getDouble("renderPostGainDb") / 20.0)
+        } else {
+            1.0
+        }
+        private val hpR: Double = run {
+            val hz = if (opts != null && opts.hasKey("renderHighPassHz")) opts.getDouble("renderHighPassHz") else 0.0
+            if (hz > 0 && sampleRate > 0) exp(-2.0 * PI * hz / sampleRate).coerceIn(0.0, 0.999999) else -1.0
+        }
+        private var hpX1 = 0f
+        private var hpY1 = 0f
+        private val layer2Delay: Int
+        private val layer2Linear: Double
+        private val layer2Ring: ShortArray
+        private var layer2Pos = 0L
+        private val fadeBytes = (sampleRate * tailFadeMs / 1000.0).roundToInt().coerceAtLeast(0) * 2
+        private var held = ByteArray(0)
+
+        init {
+            val enabled = opts != null && opts.hasKey("renderLayer2Enabled") && opts.getBoolean("renderLayer2Enabled")
+            val delayMs = if (enabled && opts!!.hasKey("renderLayer2DelayMs")) {
+                opts.getDouble("renderLayer2DelayMs").coerceAtLeast(0.0)
+            } else {
+                0.0
+            }
+            layer2Delay = if (enabled) (sampleRate * delayMs / 1000.0).toInt().coerceIn(0, 100_000) else 0
+            var linear = if (enabled && opts!!.hasKey("renderLayer2GainDb")) {
+                10.0.pow(opts.getDouble("renderLayer2GainDb") / 20.0)
+            } else {
+                1.0
+            }
+            if (linear < 0 || linear.isNaN() || linear.isInfinite()) linear = 0.0
+            layer2Linear = linear
+            layer2Ring = ShortArray(layer2Delay)
+        }
+
+        fun process(chunk: ByteArray): ByteArray {
+            val padSamples = if (first) leadSamples else (sampleRate * interClauseMs / 1000.0).roundToInt().coerceAtLeast(0)
+            first = false
+            val input = if (padSamples > 0) concatBytes(ByteArray(padSamples * 2), chunk) else chunk
+            val out = ByteArray(input.size)
+            val inBuf = ByteBuffer.wrap(input).order(ByteOrder.LITTLE_ENDIAN)
+            val outBuf = ByteBuffer.wrap(out).order(ByteOrder.LITTLE_ENDIAN)
+            for (i in 0 until input.size / 2) {
+                outBuf.putShort(i * 2, renderSample(inBuf.getShort(i * 2)))
+            }
+            return holdTail(out)
+        }
+
+        /** Layer2 wet tail plus the held-back samples with the end fade applied. */
+        fun finish(): ByteArray {
+            val flush = ByteArray(layer2Delay * 2)
+            val flushBuf = ByteBuffer.wrap(flush).order(ByteOrder.LITTLE_ENDIAN)
+            for (i in 0 until layer2Delay) {
+                val wet = layer2Ring[((layer2Pos + i) % layer2Delay).toInt()] * layer2Linear
+                flushBuf.putShort(i * 2, wet.roundToInt().coerceIn(-32768, 32767).toShort())
+            }
+            val out = concatBytes(held, flush)
+            held = ByteArray(0)
+            applyEndFadePcm16LE(out, sampleRate, tailFadeMs)
+            return out
+        }
+
+        private fun renderSample(s: Short): Short {
+            var v = s.toDouble()
+            if (gainLinear != 1.0) v = (v * gainLinear).roundToInt().coerceIn(-32768, 32767).toDouble()
+            if (hpR >= 0.0) {
+                val x0 = v.toFloat() / 32768f
+                val y0 = x0 - hpX1 + (hpR * hpY1).toFloat()
+                hpX1 = x0
+                hpY1 = y0
+                v = (y0 * 32768f).roundToInt().coerceIn(-32768, 32767).toDouble()
+            }
+            if (layer2Delay > 0) {
+                val slot = (layer2Pos % layer2Delay).toInt()
+                val wet = layer2Ring[slot]
+                layer2Ring[slot] = v.toInt().toShort()
+                v += wet * layer2Linear
+            }
+            layer2Pos++
+            return v.roundToInt().coerceIn(-32768, 32767).toShort()
+        }
+
+        private fun holdTail(out: ByteArray): ByteArray {
+            val all = if (held.isEmpty()) out else concatBytes(held, out)
+            val keep = minOf(fadeBytes, all.size)
+            held = all.copyOfRange(all.size - keep, all.size)
+            return all.copyOfRange(0, all.size - keep)
+        }
+    }
+
+    /** Per-stage bytes from nativeSynthesize (order in piper_jni.cpp); aggregate via JSI __piperSynthesisMemoryStats. */
+    private fun logMemoryReport(m: LongArray) {
+        if (m.size < 12) return
+        Log.d(
+            TAG,
+            "[Piper] synth memory: phonemes=${m[0]} espeakRss=${m[1]} ortLive=${m[2]} ortPeak=${m[3]} " +
+                "ortAllocs=${m[4]} float=${m[5]} pcm=${m[6]} scratch=${m[7]} scratchMallocs=${m[8]} " +
+                "jni=${m[9]} rssStart=${m[10]} rssPeakDelta=${m[11]}"
+        )
+    }
+
+    /**
+     * Parses native [ByteArray, sampleRate, LongArray memory] or error string; rejects [promise] on failure.
      */
     private fun parseNativePcmResult(result: Array<Any>?, promise: Promise, errLabel: String): Pair<ByteArray, Int>? {
         if (result == null || result.size < 2) {
@@ -183,6 +496,7 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
         val first = result[0]
         val second = result[1]
         if (first == null && second is String) {
+            (result.getOrNull(2) as? LongArray)?.let { logMemoryReport(it) }
             Log.e(TAG, "[E_SYNTHESIS] $second")
             promise.reject("E_SYNTHESIS", second)
             return null
@@ -193,6 +507,7 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
             return null
         }
         val rate = (second as? Number)?.toInt() ?: 0
+        (result.getOrNull(2) as? LongArray)?.let { logMemoryReport(it) }
         if (pcmBytes.isEmpty() || rate <= 0) {
             promise.reject("E_SYNTHESIS", "Native synthesize returned empty audio")
             return null
@@ -365,27 +680,26 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
         activeAudioTrack = track
         track.play()
         track.write(processed, 0, processed.size)
-        val totalFrames = processed.size / 2
-        while (track.playbackHeadPosition < totalFrames && track.playState == AudioTrack.PLAYSTATE_PLAYING) {
+        awaitPlaybackAndRelease(track, processed.size / 2L, promise)
+    }
+
+    /** Waits for [totalFrames] to play (or stop()), then releases [track] and settles [promise]. */
+    private fun awaitPlaybackAndRelease(track: AudioTrack, totalFrames: Long, promise: Promise) {
+        while (track.playbackHeadPosition.toLong() < totalFrames && track.playState == AudioTrack.PLAYSTATE_PLAYING) {
             if (stopPlaybackRequested) {
-                try {
-                    track.stop()
-                } catch (_: Exception) {
-                }
-                try {
-                    track.release()
-                } catch (_: Exception) {
-                }
-                activeAudioTrack = null
-                activeSpeakPromise = null
-                try {
-                    promise.reject("E_CANCELLED", "Playback stopped", null)
-                } catch (_: Exception) {
-                }
+                releaseTrack(track)
+                rejectCancelled(promise)
                 return
             }
             Thread.sleep(50)
         }
+        releaseTrack(track)
+        activeSpeakPromise = null
+        promise.resolve(null)
+    }
+
+    private fun releaseTrack(track: AudioTrack?) {
+        if (track == null) return
         try {
             track.stop()
         } catch (_: Exception) {
@@ -394,18 +708,24 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
             track.release()
         } catch (_: Exception) {
         }
-        activeAudioTrack = null
+        if (activeAudioTrack === track) activeAudioTrack = null
+    }
+
+    private fun rejectCancelled(promise: Promise) {
         activeSpeakPromise = null
-        promise.resolve(null)
+        try {
+            promise.reject("E_CANCELLED", "Playback stopped", null)
+        } catch (_: Exception) {
+        }
     }
 
     @ReactMethod
     fun isModelAvailable(promise: Promise) {
         try {
-            // On Android both the Piper ONNX model and espeak-ng-data are required for synthesis.
-            val modelOk = getModelPaths() != null
-            val espeakOk = getEspeakDataPath() != null
-            promise.resolve(modelOk && espeakOk)
+            // On Android the Piper ONNX model is required, plus espeak-ng-data unless the voice is text-type.
+            val paths = getModelPaths()
+            val espeakOk = paths != null && (!nativeVoiceNeedsEspeak(paths.second) || getEspeakDataPath() != null)
+            promise.resolve(paths != null && espeakOk)
         } catch (e: Exception) {
             promise.resolve(false)
         }
@@ -416,6 +736,11 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
         return if (opts.hasKey(key)) opts.getDouble(key).toInt() else default
     }
 
+    private fun getOptionBoolean(key: String, default: Boolean): Boolean {
+        val opts = lastSpeakOptions ?: return default
+        return if (opts.hasKey(key)) opts.getBoolean(key) else default
+    }
+
     /** Post-synth: leading silence, optional dB gain, optional high-pass on int16 LE PCM (same keys as iOS). */
     private fun applyPiperPostSynthesisRender(pcm: ByteArray, sampleRate: Int): ByteArray {
         val opts = lastSpeakOptions ?: return pcm
@@ -588,5 +913,7 @@ class PiperTtsModule(reactContext: ReactApplicationContext) :
             System.loadLibrary("piper_tts")
         }
         private const val TAG = "PiperTts"
+        /** PackSyncError::kManifestMissing (report[10] of nativeSyncPack). */
+        private const val PACK_SYNC_MANIFEST_MISSING = 1L
     }
 }
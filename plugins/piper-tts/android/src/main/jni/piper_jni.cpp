@@ -1,13 +1,167 @@
+#include <android/asset_manager.h>
+#include <android/asset_manager_jni.h>
 #include <jni.h>
+#include <cerrno>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <jsi/jsi.h>
+#include "asr_jsi.h"
+#include "embedding_jsi.h"
+#include "memory_stats_jsi.h"
+#include "pack_file_jsi.h"
+#include "pack_sync.h"
+#include "pack_table_jsi.h"
+#include "phoneme_memo_jsi.h"
 #include "piper_engine.h"
+#include "query_cache_jsi.h"
+#include "silence_trim_jsi.h"
+#include "vector_index_jsi.h"
+
+namespace {
+
+// Bundled pack files read from APK assets under a prefix (content_pack/).
+class AssetPackReader : public piper::PackSyncReader {
+ public:
+  explicit AssetPackReader(AAsset* asset) : asset_(asset) {}
+  ~AssetPackReader() override { AAsset_close(asset_); }
+  long read(void* buf, size_t n) override { return AAsset_read(asset_, buf, n); }
+
+ private:
+  AAsset* asset_;
+};
+
+class AssetPackSource : public piper::PackSyncSource {
+ public:
+  AssetPackSource(AAssetManager* mgr, std::string prefix) : mgr_(mgr), prefix_(std::move(prefix)) {}
+  bool readAll(const std::string& rel_path, std::string& out) override {
+    AAsset* asset = AAssetManager_open(mgr_, (prefix_ + rel_path).c_str(), AASSET_MODE_BUFFER);
+    if (!asset) return false;
+    const void* data = AAsset_getBuffer(asset);
+    if (data) out.assign(static_cast<const char*>(data), static_cast<size_t>(AAsset_getLength64(asset)));
+    AAsset_close(asset);
+    return data != nullptr;
+  }
+  std::unique_ptr<piper::PackSyncReader> open(const std::string& rel_path, uint64_t offset) override {
+    AAsset* asset = AAssetManager_open(mgr_, (prefix_ + rel_path).c_str(), AASSET_MODE_STREAMING);
+    if (!asset) return nullptr;
+    if (offset > 0 && AAsset_seek64(asset, static_cast<off64_t>(offset), SEEK_SET) < 0) {
+      AAsset_close(asset);
+      return nullptr;
+    }
+    return std::unique_ptr<piper::PackSyncReader>(new AssetPackReader(asset));
+  }
+
+ private:
+  AAssetManager* mgr_;
+  std::string prefix_;
+};
+
+// A bundled pack file handed to JS (__piperReadAssetBinary). JS may write into the ArrayBuffer, so, like
+// mapPackFile, an uncompressed asset is mapped copy-on-write from the APK (MAP_PRIVATE, PROT_READ | PROT_WRITE):
+// writes land in private pages and never reach the shared APK mapping. The map starts at the page holding the
+// asset's first byte.
+class MappedAssetBuffer : public facebook::jsi::MutableBuffer {
+ public:
+  MappedAssetBuffer(void* map, size_t map_size, size_t offset, size_t size)
+      : map_(map), map_size_(map_size), offset_(offset), size_(size) {}
+  ~MappedAssetBuffer() override { munmap(map_, map_size_); }
+  size_t size() const override { return size_; }
+  uint8_t* data() override { return static_cast<uint8_t*>(map_) + offset_; }
+
+ private:
+  void* map_;
+  size_t map_size_;
+  size_t offset_;
+  size_t size_;
+};
+
+// A compressed asset has no file range to map: it is inflated once into an owned, writable copy.
+class CopiedAssetBuffer : public facebook::jsi::MutableBuffer {
+ public:
+  explicit CopiedAssetBuffer(std::vector<uint8_t> bytes) : bytes_(std::move(bytes)) {}
+  size_t size() const override { return bytes_.size(); }
+  uint8_t* data() override { return bytes_.empty() ? &empty_ : bytes_.data(); }
+
+ private:
+  std::vector<uint8_t> bytes_;
+  uint8_t empty_ = 0;
+};
+
+// Java AssetManager backing g_asset_manager; held as a global ref so the native manager stays valid.
+jobject g_asset_manager_ref = nullptr;
+AAssetManager* g_asset_manager = nullptr;
+
+std::shared_ptr<facebook::jsi::MutableBuffer> openAssetBuffer(const std::string& path, std::string* error) {
+  AAsset* asset = g_asset_manager ? AAssetManager_open(g_asset_manager, path.c_str(), AASSET_MODE_STREAMING) : nullptr;
+  if (!asset) {
+    if (error) *error = "asset not found";
+    return nullptr;
+  }
+  off64_t start = 0, length = 0;
+  const int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+  if (fd >= 0) {
+    AAsset_close(asset);
+    if (length == 0) {
+      ::close(fd);
+      return std::make_shared<CopiedAssetBuffer>(std::vector<uint8_t>());
+    }
+    const off64_t page = static_cast<off64_t>(sysconf(_SC_PAGESIZE));
+    const off64_t map_start = start - start % page;
+    const size_t offset = static_cast<size_t>(start - map_start);
+    const size_t map_size = offset + static_cast<size_t>(length);
+    void* map = mmap64(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, map_start);
+    const int e = errno;
+    ::close(fd);
+    if (map == MAP_FAILED) {
+      if (error) *error = std::string("mmap failed: ") + std::strerror(e);
+      return nullptr;
+    }
+    return std::make_shared<MappedAssetBuffer>(map, map_size, offset, static_cast<size_t>(length));
+  }
+
+  std::vector<uint8_t> bytes(static_cast<size_t>(AAsset_getLength64(asset)));
+  size_t got = 0;
+  while (got < bytes.size()) {
+    const int n = AAsset_read(asset, bytes.data() + got, bytes.size() - got);
+    if (n <= 0) break;
+    got += static_cast<size_t>(n);
+  }
+  AAsset_close(asset);
+  if (got != bytes.size()) {
+    if (error) *error = "asset not readable";
+    return nullptr;
+  }
+  return std::make_shared<CopiedAssetBuffer>(std::move(bytes));
+}
+
+}  // namespace
 
 extern "C" {
 
-// Returns Object[] of length 2:
-// - Success: [byte[] pcm, Integer sampleRate]
-// - Failure: [null, String errorMessage] so Kotlin can reject with the real pipeline error.
+// Returns Object[] of length 3:
+// - Success: [byte[] pcm, Integer sampleRate, long[] memory]
+// - Failure: [null, String errorMessage, long[] memory] so Kotlin can reject with the real pipeline error.
+// memory (bytes): phoneme, espeakRssDelta, ortLive, ortPeak, ortAllocCount, floatAudio, pcm, scratch,
+// scratchBlockMallocs, jniOutput, rssStart, rssPeakDelta (piper::SynthesisMemoryReport field order).
+static jlongArray memoryReportToJava(JNIEnv* env, const piper::SynthesisMemoryReport& m) {
+  const jlong values[] = {
+      static_cast<jlong>(m.phoneme_bytes),   static_cast<jlong>(m.espeak_rss_delta),
+      static_cast<jlong>(m.ort_live_bytes),  static_cast<jlong>(m.ort_peak_bytes),
+      static_cast<jlong>(m.ort_alloc_count), static_cast<jlong>(m.float_audio_bytes),
+      static_cast<jlong>(m.pcm_bytes),       static_cast<jlong>(m.scratch_bytes),
+      static_cast<jlong>(m.scratch_block_mallocs), static_cast<jlong>(m.output_bytes),
+      static_cast<jlong>(m.rss_start),       static_cast<jlong>(m.rss_peak_delta),
+  };
+  const jsize n = static_cast<jsize>(sizeof(values) / sizeof(values[0]));
+  jlongArray arr = env->NewLongArray(n);
+  if (arr) env->SetLongArrayRegion(arr, 0, n, values);
+  return arr;
+}
+
 static const char* synthesizeErrorToString(piper::SynthesizeError e) {
   switch (e) {
     case piper::SynthesizeError::kNone: return "None";
@@ -20,6 +174,7 @@ static const char* synthesizeErrorToString(piper::SynthesizeError e) {
     case piper::SynthesizeError::kPhonemeIdsEmpty: return "Phoneme id sequence empty";
     case piper::SynthesizeError::kOrtCreateSessionFailed: return "ONNX Runtime session creation failed";
     case piper::SynthesizeError::kOrtRunInferenceFailed: return "ONNX inference failed";
+    case piper::SynthesizeError::kCancelled: return "Synthesis cancelled";
     default: return "Synthesis failed";
   }
 }
@@ -45,7 +200,9 @@ Java_com_pipertts_PiperTtsModule_nativeSynthesize(JNIEnv* env, jclass clazz,
   std::vector<int16_t> pcm;
   int sample_rate = 0;
   piper::SynthesizeError synth_error = piper::SynthesizeError::kNone;
-  bool ok = piper::synthesize(model_path, config_path, espeak_path ? espeak_path : "", text, pcm, sample_rate, &synth_error);
+  piper::SynthesisMemoryReport memory;
+  bool ok = piper::synthesize(model_path, config_path, espeak_path ? espeak_path : "", text, pcm, sample_rate,
+                              &synth_error, nullptr, &memory);
 
   env->ReleaseStringUTFChars(j_model_path, model_path);
   env->ReleaseStringUTFChars(j_config_path, config_path);
@@ -54,7 +211,7 @@ Java_com_pipertts_PiperTtsModule_nativeSynthesize(JNIEnv* env, jclass clazz,
 
   jclass objectArrayClass = env->FindClass("[Ljava/lang/Object;");
   if (!objectArrayClass) return nullptr;
-  jobjectArray result = env->NewObjectArray(2, env->FindClass("java/lang/Object"), nullptr);
+  jobjectArray result = env->NewObjectArray(3, env->FindClass("java/lang/Object"), nullptr);
   if (!result) return nullptr;
 
   if (!ok || pcm.empty()) {
@@ -62,12 +219,15 @@ Java_com_pipertts_PiperTtsModule_nativeSynthesize(JNIEnv* env, jclass clazz,
     jstring j_err = env->NewStringUTF(err_msg);
     env->SetObjectArrayElement(result, 0, nullptr);
     env->SetObjectArrayElement(result, 1, j_err);
+    env->SetObjectArrayElement(result, 2, memoryReportToJava(env, memory));
     return result;
   }
 
   jbyteArray pcmArray = env->NewByteArray(static_cast<jsize>(pcm.size() * 2));
   if (!pcmArray) return nullptr;
   env->SetByteArrayRegion(pcmArray, 0, static_cast<jsize>(pcm.size() * 2), reinterpret_cast<const jbyte*>(pcm.data()));
+  memory.output_bytes = pcm.size() * 2;
+  piper::recordSynthesisMemory(memory);
 
   jclass integerClass = env->FindClass("java/lang/Integer");
   jmethodID integerValueOf = env->GetStaticMethodID(integerClass, "valueOf", "(I)Ljava/lang/Integer;");
@@ -75,7 +235,202 @@ Java_com_pipertts_PiperTtsModule_nativeSynthesize(JNIEnv* env, jclass clazz,
 
   env->SetObjectArrayElement(result, 0, pcmArray);
   env->SetObjectArrayElement(result, 1, sampleRateObj);
+  env->SetObjectArrayElement(result, 2, memoryReportToJava(env, memory));
   return result;
 }
 
+// PiperTtsModule.ChunkSink.onChunk(byte[] pcm, int sampleRate, long sampleOffset): boolean, resolved once in
+// JNI_OnLoad. The interface's method ID is valid for any implementation, so each chunk costs one call.
+static jclass g_chunk_sink_class = nullptr;
+static jmethodID g_chunk_sink_on_chunk = nullptr;
+
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void*) {
+  JNIEnv* env = nullptr;
+  if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) return JNI_ERR;
+  jclass local = env->FindClass("com/pipertts/PiperTtsModule$ChunkSink");
+  if (!local) {
+    env->ExceptionClear();
+    return JNI_VERSION_1_6;  // streaming unavailable; nativeSynthesizeStream reports it
+  }
+  g_chunk_sink_class = static_cast<jclass>(env->NewGlobalRef(local));
+  env->DeleteLocalRef(local);
+  g_chunk_sink_on_chunk = env->GetMethodID(g_chunk_sink_class, "onChunk", "([BIJ)Z");
+  if (!g_chunk_sink_on_chunk) env->ExceptionClear();
+  return JNI_VERSION_1_6;
+}
+
+// Streams one utterance clause by clause: sink.onChunk(pcm, sampleRate, sampleOffset) is called on this thread
+// as each clause finishes, so Kotlin can write it to AudioTrack while the next clause synthesizes. onChunk
+// returning false (or throwing) cancels the rest.
+// Returns Object[] of length 3:
+// - Success: [Long totalSamples, Integer sampleRate, long[] memory]
+// - Failure: [null, String errorMessage, long[] memory]
+// memory as in nativeSynthesize; float/pcm/phoneme bytes are the largest clause, jniOutput the largest chunk copy.
+JNIEXPORT jobject JNICALL
+Java_com_pipertts_PiperTtsModule_nativeSynthesizeStream(JNIEnv* env, jclass clazz,
+                                                        jstring j_model_path,
+                                                        jstring j_config_path,
+                                                        jstring j_espeak_path,
+                                                        jstring j_text,
+                                                        jobject j_sink) {
+  if (!j_sink || !g_chunk_sink_on_chunk) return nullptr;
+  const char* model_path = env->GetStringUTFChars(j_model_path, nullptr);
+  const char* config_path = env->GetStringUTFChars(j_config_path, nullptr);
+  const char* espeak_path = j_espeak_path ? env->GetStringUTFChars(j_espeak_path, nullptr) : "";
+  const char* text = env->GetStringUTFChars(j_text, nullptr);
+  if (!model_path || !config_path || !text) {
+    if (model_path) env->ReleaseStringUTFChars(j_model_path, model_path);
+    if (config_path) env->ReleaseStringUTFChars(j_config_path, config_path);
+    if (espeak_path && j_espeak_path) env->ReleaseStringUTFChars(j_espeak_path, espeak_path);
+    if (text) env->ReleaseStringUTFChars(j_text, text);
+    return nullptr;
+  }
+
+  int sample_rate = 0;
+  size_t total_samples = 0;
+  size_t max_chunk_bytes = 0;
+  piper::SynthesizeError synth_error = piper::SynthesizeError::kNone;
+  piper::SynthesisMemoryReport memory;
+  auto on_chunk = [&](const int16_t* pcm, size_t samples, size_t sample_offset) -> bool {
+    const jsize n_bytes = static_cast<jsize>(samples * 2);
+    jbyteArray chunk = env->NewByteArray(n_bytes);
+    if (!chunk) return false;
+    env->SetByteArrayRegion(chunk, 0, n_bytes, reinterpret_cast<const jbyte*>(pcm));
+    const jboolean keep_going = env->CallBooleanMethod(j_sink, g_chunk_sink_on_chunk, chunk,
+                                                       static_cast<jint>(sample_rate),
+                                                       static_cast<jlong>(sample_offset));
+    env->DeleteLocalRef(chunk);
+    if (env->ExceptionCheck()) {
+      env->ExceptionDescribe();
+      env->ExceptionClear();
+      return false;
+    }
+    total_samples = sample_offset + samples;
+    if (static_cast<size_t>(n_bytes) > max_chunk_bytes) max_chunk_bytes = static_cast<size_t>(n_bytes);
+    return keep_going == JNI_TRUE;
+  };
+  bool ok = piper::synthesizeStreaming(model_path, config_path, espeak_path ? espeak_path : "", text, on_chunk,
+                                       sample_rate, &synth_error, nullptr, &memory);
+
+  env->ReleaseStringUTFChars(j_model_path, model_path);
+  env->ReleaseStringUTFChars(j_config_path, config_path);
+  if (espeak_path && j_espeak_path) env->ReleaseStringUTFChars(j_espeak_path, espeak_path);
+  env->ReleaseStringUTFChars(j_text, text);
+
+  memory.output_bytes = max_chunk_bytes;
+  jobjectArray result = env->NewObjectArray(3, env->FindClass("java/lang/Object"), nullptr);
+  if (!result) return nullptr;
+
+  if (!ok) {
+    env->SetObjectArrayElement(result, 0, nullptr);
+    env->SetObjectArrayElement(result, 1, env->NewStringUTF(synthesizeErrorToString(synth_error)));
+    env->SetObjectArrayElement(result, 2, memoryReportToJava(env, memory));
+    return result;
+  }
+  piper::recordSynthesisMemory(memory);
+
+  jclass longClass = env->FindClass("java/lang/Long");
+  jmethodID longValueOf = env->GetStaticMethodID(longClass, "valueOf", "(J)Ljava/lang/Long;");
+  jclass integerClass = env->FindClass("java/lang/Integer");
+  jmethodID integerValueOf = env->GetStaticMethodID(integerClass, "valueOf", "(I)Ljava/lang/Integer;");
+  env->SetObjectArrayElement(result, 0,
+                             env->CallStaticObjectMethod(longClass, longValueOf, static_cast<jlong>(total_samples)));
+  env->SetObjectArrayElement(result, 1,
+                             env->CallStaticObjectMethod(integerClass, integerValueOf, static_cast<jint>(sample_rate)));
+  env->SetObjectArrayElement(result, 2, memoryReportToJava(env, memory));
+  return result;
+}
+
+// Loads (or with null/empty path, unloads) the pre-rendered audio pack. Returns the entry count, or -1 if
+// the file is missing or invalid (the engine keeps synthesizing live).
+JNIEXPORT jint JNICALL
+Java_com_pipertts_PiperTtsModule_nativeSetAudioPack(JNIEnv* env, jclass clazz, jstring j_path) {
+  std::string path;
+  if (j_path) {
+    const char* p = env->GetStringUTFChars(j_path, nullptr);
+    if (!p) return -1;
+    path = p;
+    env->ReleaseStringUTFChars(j_path, p);
+  }
+  std::string error;
+  if (!piper::setAudioPack(path, &error)) return -1;
+  return static_cast<jint>(piper::audioPackSize());
+}
+
+// piper::voiceNeedsEspeak for the voice config: text-type voices skip the espeak-ng-data copy and check.
+JNIEXPORT jboolean JNICALL
+Java_com_pipertts_PiperTtsModule_nativeVoiceNeedsEspeak(JNIEnv* env, jclass clazz, jstring j_config_path) {
+  if (!j_config_path) return JNI_TRUE;
+  const char* p = env->GetStringUTFChars(j_config_path, nullptr);
+  if (!p) return JNI_TRUE;
+  const bool needs = piper::voiceNeedsEspeak(p);
+  env->ReleaseStringUTFChars(j_config_path, p);
+  return needs ? JNI_TRUE : JNI_FALSE;
+}
+
+// Incremental sync of the APK's bundled pack (assets/<asset_root>) into dest_dir (see pack_sync.h).
+// Returns Object[] of length 2: [long[] report, String errorOrNull]. report: files, copied, resumed,
+// verified, skipped, removed, bytesTotal, bytesCopied, bytesHashed, elapsedMs, errorCode (PackSyncError).
+JNIEXPORT jobjectArray JNICALL
+Java_com_pipertts_PiperTtsModule_nativeSyncPack(JNIEnv* env, jclass clazz, jobject j_asset_manager,
+                                                 jstring j_asset_root, jstring j_dest_dir) {
+  AAssetManager* mgr = j_asset_manager ? AAssetManager_fromJava(env, j_asset_manager) : nullptr;
+  const char* asset_root = j_asset_root ? env->GetStringUTFChars(j_asset_root, nullptr) : nullptr;
+  const char* dest_dir = j_dest_dir ? env->GetStringUTFChars(j_dest_dir, nullptr) : nullptr;
+  piper::PackSyncReport report;
+  piper::PackSyncError err = piper::PackSyncError::kSourceReadFailed;
+  if (mgr && asset_root && dest_dir) {
+    std::string prefix = asset_root;
+    if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+    AssetPackSource source(mgr, prefix);
+    piper::syncPack(source, dest_dir, piper::PackSyncOptions{}, &report, &err);
+  }
+  if (asset_root) env->ReleaseStringUTFChars(j_asset_root, asset_root);
+  if (dest_dir) env->ReleaseStringUTFChars(j_dest_dir, dest_dir);
+
+  const jlong values[] = {
+      static_cast<jlong>(report.files),        static_cast<jlong>(report.copied),
+      static_cast<jlong>(report.resumed),      static_cast<jlong>(report.verified),
+      static_cast<jlong>(report.skipped),      static_cast<jlong>(report.removed),
+      static_cast<jlong>(report.bytes_total),  static_cast<jlong>(report.bytes_copied),
+      static_cast<jlong>(report.bytes_hashed), static_cast<jlong>(report.elapsed_ms),
+      static_cast<jlong>(err),
+  };
+  const jsize n = static_cast<jsize>(sizeof(values) / sizeof(values[0]));
+  jobjectArray result = env->NewObjectArray(2, env->FindClass("java/lang/Object"), nullptr);
+  if (!result) return nullptr;
+  jlongArray arr = env->NewLongArray(n);
+  if (arr) env->SetLongArrayRegion(arr, 0, n, values);
+  env->SetObjectArrayElement(result, 0, arr);
+  if (err != piper::PackSyncError::kNone) {
+    std::string message = piper::packSyncErrorString(err);
+    if (!report.failed_path.empty()) message += ": " + report.failed_path;
+    env->SetObjectArrayElement(result, 1, env->NewStringUTF(message.c_str()));
+  }
+  return result;
+}
+
+// Installs JSI host functions (global.__piperEmbed, __piperAsr*, __piperQueryCache*, __piperSynthesisMemoryStats,
+// __piperVectorIndex*, __piperPackTable*, __piperPhonemeMemo*) into the JS runtime. Called on the JS thread
+// from a blocking sync method; runtime_ptr is ReactContext.javaScriptContextHolder.get().
+JNIEXPORT jboolean JNICALL
+Java_com_pipertts_PiperTtsModule_nativeInstallJsi(JNIEnv* env, jobject thiz, jlong runtime_ptr, jobject assets) {
+  auto* runtime = reinterpret_cast<facebook::jsi::Runtime*>(runtime_ptr);
+  if (!runtime) return JNI_FALSE;
+  if (assets && !g_asset_manager_ref) {
+    g_asset_manager_ref = env->NewGlobalRef(assets);
+    g_asset_manager = AAssetManager_fromJava(env, g_asset_manager_ref);
+  }
+  piper::installEmbeddingJsi(*runtime);
+  piper::installAsrJsi(*runtime);
+  piper::installQueryCacheJsi(*runtime);
+  piper::installMemoryStatsJsi(*runtime);
+  piper::installVectorIndexJsi(*runtime);
+  piper::installPackTableJsi(*runtime);
+  piper::installPhonemeMemoJsi(*runtime);
+  piper::installSilenceTrimJsi(*runtime);
+  piper::installPackFileJsi(*runtime, g_asset_manager ? piper::PackAssetOpener(openAssetBuffer) : nullptr);
+  return JNI_TRUE;
+}
+
 }  // extern "C"
@@ -0,0 +1,226 @@
+// Streaming ASR evaluation on Linux: feeds WAV fixtures through StreamingRecognizer in
+// mic-sized frames and reports word error rate and real-time factor.
+//
+//   asr_eval --model model.onnx --tokens tokens.txt --config asr_config.json
+//            --manifest fixtures/asr/manifest.tsv [--frame-ms 10] [--json report.json]
+//
+// Manifest: one "<wav path>\t<reference transcript>" per line; relative paths resolve
+// against the manifest's directory; lines starting with '#' are ignored.
+
+#include "json.hpp"
+#include "streaming_asr.h"
+#include "wav_io.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct Utterance {
+  std::string wav;
+  std::string reference;
+};
+
+struct UtteranceResult {
+  std::string wav;
+  std::string reference;
+  std::string hypothesis;
+  size_t ref_words = 0;
+  size_t edits = 0;
+  double audio_sec = 0.0;
+  double compute_sec = 0.0;
+  double first_partial_audio_sec = -1.0;
+  int partial_updates = 0;
+};
+
+std::vector<std::string> normalizeWords(const std::string& text) {
+  std::vector<std::string> words;
+  std::string cur;
+  for (unsigned char c : text) {
+    if (std::isalnum(c) || c == '\'' || c >= 0x80) {
+      cur.push_back(static_cast<char>(std::tolower(c)));
+    } else if (!cur.empty()) {
+      words.push_back(cur);
+      cur.clear();
+    }
+  }
+  if (!cur.empty()) words.push_back(cur);
+  return words;
+}
+
+size_t editDistance(const std::vector<std::string>& ref, const std::vector<std::string>& hyp) {
+  std::vector<size_t> prev(hyp.size() + 1), cur(hyp.size() + 1);
+  for (size_t j = 0; j <= hyp.size(); j++) prev[j] = j;
+  for (size_t i = 1; i <= ref.size(); i++) {
+    cur[0] = i;
+    for (size_t j = 1; j <= hyp.size(); j++) {
+      const size_t sub = prev[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1);
+      cur[j] = std::min({sub, prev[j] + 1, cur[j - 1] + 1});
+    }
+    std::swap(prev, cur);
+  }
+  return prev[hyp.size()];
+}
+
+bool readManifest(const std::string& path, std::vector<Utterance>& out) {
+  std::ifstream in(path);
+  if (!in) return false;
+  const size_t slash = path.find_last_of('/');
+  const std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty() || line[0] == '#') continue;
+    const size_t tab = line.find('\t');
+    if (tab == std::string::npos) continue;
+    Utterance u;
+    u.wav = line.substr(0, tab);
+    if (!u.wav.empty() && u.wav[0] != '/') u.wav = dir + u.wav;
+    u.reference = line.substr(tab + 1);
+    out.push_back(u);
+  }
+  return true;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: asr_eval --model <model.onnx> --tokens <tokens.txt> --config <asr_config.json>\n"
+               "                --manifest <manifest.tsv> [--frame-ms 10] [--json <report.json>]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string model, tokens, config, manifest, json_out;
+  int frame_ms = 10;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--model") model = next();
+    else if (arg == "--tokens") tokens = next();
+    else if (arg == "--config") config = next();
+    else if (arg == "--manifest") manifest = next();
+    else if (arg == "--json") json_out = next();
+    else if (arg == "--frame-ms") frame_ms = std::max(1, std::atoi(next().c_str()));
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (model.empty() || tokens.empty() || config.empty() || manifest.empty()) {
+    usage();
+    return 2;
+  }
+
+  std::vector<Utterance> utterances;
+  if (!readManifest(manifest, utterances) || utterances.empty()) {
+    std::fprintf(stderr, "asr_eval: no utterances in %s\n", manifest.c_str());
+    return 1;
+  }
+
+  piper::StreamingRecognizer recognizer;
+  piper::AsrError err = piper::AsrError::kNone;
+  const auto load_t0 = std::chrono::steady_clock::now();
+  if (!recognizer.load(model, tokens, config, &err)) {
+    std::fprintf(stderr, "asr_eval: load failed: %s\n", piper::asrErrorToString(err));
+    return 1;
+  }
+  const double load_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_t0).count();
+  const int rate = recognizer.sampleRate();
+  const size_t frame = static_cast<size_t>(rate) * static_cast<size_t>(frame_ms) / 1000;
+
+  std::vector<UtteranceResult> results;
+  std::vector<int16_t> pcm;
+  for (const Utterance& u : utterances) {
+    std::vector<float> audio;
+    int wav_rate = 0;
+    std::string wav_err;
+    if (!piper_host::readWav(u.wav, audio, wav_rate, &wav_err)) {
+      std::fprintf(stderr, "asr_eval: skip %s (%s)\n", u.wav.c_str(), wav_err.c_str());
+      continue;
+    }
+    audio = piper_host::resampleLinear(audio, wav_rate, rate);
+    pcm.resize(audio.size());
+    for (size_t i = 0; i < audio.size(); i++) {
+      const float v = std::max(-1.0f, std::min(1.0f, audio[i]));
+      pcm[i] = static_cast<int16_t>(v * 32767.0f);
+    }
+
+    recognizer.reset();
+    bool ok = true;
+    for (size_t off = 0; off < pcm.size() && ok; off += frame) {
+      ok = recognizer.acceptPcm16(pcm.data() + off, std::min(frame, pcm.size() - off), &err);
+    }
+    const std::string hyp = ok ? recognizer.finish(&err) : std::string();
+    if (!ok || err != piper::AsrError::kNone) {
+      std::fprintf(stderr, "asr_eval: decode failed on %s: %s\n", u.wav.c_str(), piper::asrErrorToString(err));
+      continue;
+    }
+
+    const piper::AsrStats& s = recognizer.stats();
+    UtteranceResult r;
+    r.wav = u.wav;
+    r.reference = u.reference;
+    r.hypothesis = hyp;
+    const auto ref_words = normalizeWords(u.reference);
+    r.ref_words = ref_words.size();
+    r.edits = editDistance(ref_words, normalizeWords(hyp));
+    r.audio_sec = s.audio_sec;
+    r.compute_sec = s.feature_sec + s.inference_sec;
+    r.first_partial_audio_sec = s.first_partial_audio_sec;
+    r.partial_updates = s.partial_updates;
+    results.push_back(r);
+    std::printf("%-40s WER %6.2f%%  RTF %.3f  partials %3d  \"%s\"\n", u.wav.substr(u.wav.find_last_of('/') + 1).c_str(),
+                r.ref_words ? 100.0 * r.edits / r.ref_words : 0.0, r.audio_sec > 0 ? r.compute_sec / r.audio_sec : 0.0,
+                r.partial_updates, hyp.c_str());
+  }
+  if (results.empty()) {
+    std::fprintf(stderr, "asr_eval: no utterances decoded\n");
+    return 1;
+  }
+
+  size_t total_edits = 0, total_words = 0;
+  double total_audio = 0.0, total_compute = 0.0;
+  for (const auto& r : results) {
+    total_edits += r.edits;
+    total_words += r.ref_words;
+    total_audio += r.audio_sec;
+    total_compute += r.compute_sec;
+  }
+  const double wer = total_words ? static_cast<double>(total_edits) / total_words : 0.0;
+  const double rtf = total_audio > 0.0 ? total_compute / total_audio : 0.0;
+  std::printf("\nutterances %zu  words %zu  WER %.2f%%  RTF %.3f  audio %.1fs  compute %.2fs  model load %.2fs  frame %dms\n",
+              results.size(), total_words, wer * 100.0, rtf, total_audio, total_compute, load_sec, frame_ms);
+
+  if (!json_out.empty()) {
+    json report;
+    report["model"] = model;
+    report["frame_ms"] = frame_ms;
+    report["model_load_sec"] = load_sec;
+    report["utterances"] = json::array();
+    for (const auto& r : results) {
+      report["utterances"].push_back({{"wav", r.wav},
+                                      {"reference", r.reference},
+                                      {"hypothesis", r.hypothesis},
+                                      {"ref_words", r.ref_words},
+                                      {"edits", r.edits},
+                                      {"audio_sec", r.audio_sec},
+                                      {"compute_sec", r.compute_sec},
+                                      {"first_partial_audio_sec", r.first_partial_audio_sec},
+                                      {"partial_updates", r.partial_updates}});
+    }
+    report["summary"] = {{"wer", wer}, {"rtf", rtf}, {"audio_sec", total_audio}, {"compute_sec", total_compute},
+                         {"ref_words", total_words}, {"edits", total_edits}};
+    std::ofstream out(json_out);
+    out << report.dump(2) << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,421 @@
+// Capture front-end evaluation on Linux: streams WAV fixtures (at their recorded rate, e.g. 44.1 / 48 kHz)
+// through CaptureFrontEnd in mic-sized chunks and reports the per-10 ms processing cost, levels, the
+// noise floor and AGC gain; --out-dir writes the 16 kHz output for listening or for asr_eval.
+//
+//   capture_eval --manifest fixtures/capture/manifest.tsv [--frame-ms 10] [--out-dir out/] [--json report.json]
+//                [--wav a.wav ...] [--high-pass 80] [--no-ns] [--no-agc] [--agc-target -20] [--selftest]
+//
+// Manifest: one "<wav path>[\t...]" per line (asr_eval manifests work; transcripts are ignored).
+// --selftest checks the stages on generated signals at 44.1 and 48 kHz (resampler passband gain, alias
+// rejection and delay compensation, high-pass, noise suppression, AGC level and limiting) and that
+// process()/flush() never allocate; exits non-zero on any failure.
+
+#include "capture_frontend.h"
+#include "json.hpp"
+#include "wav_io.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Allocation counter for the no-allocation check.
+static std::atomic<size_t> g_allocs{0};
+
+// Every replaceable form is replaced, so each delete frees what the matching new allocated.
+static void* countedAlloc(size_t n) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+
+static void* countedAlignedAlloc(size_t n, std::align_val_t al) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  const size_t align = std::max(static_cast<size_t>(al), sizeof(void*));
+  void* p = nullptr;
+  if (posix_memalign(&p, align, n ? n : 1) == 0) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(size_t n) { return countedAlloc(n); }
+void* operator new[](size_t n) { return countedAlloc(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+  try {
+    return countedAlloc(n);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void* operator new[](size_t n, const std::nothrow_t&) noexcept {
+  try {
+    return countedAlloc(n);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void* operator new(size_t n, std::align_val_t al) { return countedAlignedAlloc(n, al); }
+void* operator new[](size_t n, std::align_val_t al) { return countedAlignedAlloc(n, al); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+struct FileResult {
+  std::string wav;
+  int rate = 0;
+  double audio_sec = 0.0;
+  size_t frames = 0;
+  double mean_us = 0.0;
+  double p99_us = 0.0;
+  double max_us = 0.0;
+  double in_dbfs = 0.0;
+  double out_dbfs = 0.0;
+  float noise_dbfs = 0.0f;
+  float agc_gain_db = 0.0f;
+  size_t allocs = 0;
+};
+
+double rmsDb(const float* x, size_t n) {
+  double e = 0.0;
+  for (size_t i = 0; i < n; i++) e += double(x[i]) * x[i];
+  return 10.0 * std::log10(e / std::max<size_t>(n, 1) + 1e-20);
+}
+
+double rmsDb16(const int16_t* x, size_t n) {
+  double e = 0.0;
+  for (size_t i = 0; i < n; i++) e += double(x[i]) * x[i];
+  return 10.0 * std::log10(e / std::max<size_t>(n, 1) / (32768.0 * 32768.0) + 1e-20);
+}
+
+double percentile(std::vector<double> v, double q) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, static_cast<size_t>(q * (v.size() - 1) + 0.5))];
+}
+
+// Streams in chunk-sized calls; returns the output, flush included.
+std::vector<float> stream(piper::CaptureFrontEnd& fe, const std::vector<float>& in, size_t chunk, size_t* allocs) {
+  std::vector<float> out(fe.maxOutput(in.size()) + fe.maxOutput(0));
+  size_t n = 0;
+  const size_t before = g_allocs.load();
+  for (size_t off = 0; off < in.size(); off += chunk) {
+    n += fe.process(in.data() + off, std::min(chunk, in.size() - off), out.data() + n);
+  }
+  n += fe.flush(out.data() + n);
+  if (allocs) *allocs = g_allocs.load() - before;
+  out.resize(n);
+  return out;
+}
+
+std::vector<float> tone(int rate, double hz, double amp, double sec, double phase = 0.0) {
+  std::vector<float> x(static_cast<size_t>(rate * sec));
+  for (size_t i = 0; i < x.size(); i++) x[i] = static_cast<float>(amp * std::sin(2.0 * kPi * hz * i / rate + phase));
+  return x;
+}
+
+// Amplitude of hz in x by projection (x long enough for many periods).
+double toneAmplitude(const float* x, size_t n, int rate, double hz) {
+  double s = 0.0, c = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    s += x[i] * std::sin(2.0 * kPi * hz * i / rate);
+    c += x[i] * std::cos(2.0 * kPi * hz * i / rate);
+  }
+  return 2.0 * std::sqrt(s * s + c * c) / n;
+}
+
+int g_failures = 0;
+
+void check(bool ok, const char* what, double value, const char* unit) {
+  std::printf("  %-52s %10.2f %-4s %s\n", what, value, unit, ok ? "ok" : "FAIL");
+  if (!ok) g_failures++;
+}
+
+piper::CaptureFrontEndConfig bare(int rate) {
+  piper::CaptureFrontEndConfig c;
+  c.input_rate = rate;
+  c.high_pass_hz = 0.0f;
+  c.noise_suppression = false;
+  c.agc = false;
+  return c;
+}
+
+int selftest(size_t chunk_ms) {
+  for (int rate : {48000, 44100}) {
+    std::printf("input %d Hz\n", rate);
+    const size_t chunk = static_cast<size_t>(rate) * chunk_ms / 1000;
+    {
+      // Passband gain, SNR against the ideal 16 kHz tone, delay compensation and output length.
+      piper::CaptureFrontEnd fe(bare(rate));
+      const auto in = tone(rate, 1000.0, 0.5, 2.0);
+      size_t allocs = 0;
+      const auto out = stream(fe, in, chunk, &allocs);
+      const size_t expect = static_cast<size_t>(std::lround(in.size() * 16000.0 / rate));
+      check(out.size() == expect, "output length - expected", double(out.size()) - double(expect), "smp");
+      const auto ideal = tone(16000, 1000.0, 0.5, 2.0);
+      double err = 0.0, sig = 0.0;
+      for (size_t i = 1600; i + 1600 < out.size(); i++) {
+        err += (out[i] - ideal[i]) * double(out[i] - ideal[i]);
+        sig += double(ideal[i]) * ideal[i];
+      }
+      const double snr = 10.0 * std::log10(sig / (err + 1e-20));
+      check(snr > 40.0, "1 kHz SNR vs ideal (aligned)", snr, "dB");
+      const double gain = 20.0 * std::log10(toneAmplitude(out.data() + 1600, 16000, 16000, 1000.0) / 0.5);
+      check(std::fabs(gain) < 0.1, "1 kHz passband gain", gain, "dB");
+      const auto high = stream(fe, tone(rate, 6000.0, 0.5, 1.0), chunk, nullptr);
+      const double hi = 20.0 * std::log10(toneAmplitude(high.data() + 1600, 8000, 16000, 6000.0) / 0.5);
+      check(std::fabs(hi) < 0.5, "6 kHz passband gain", hi, "dB");
+      check(allocs == 0, "allocations in process()/flush()", double(allocs), "");
+    }
+    {
+      // A tone above the output Nyquist must not fold back (11 kHz -> 5 kHz alias).
+      piper::CaptureFrontEnd fe(bare(rate));
+      const auto out = stream(fe, tone(rate, 11000.0, 0.5, 1.0), chunk, nullptr);
+      const double alias = 20.0 * std::log10(toneAmplitude(out.data() + 1600, 12800, 16000, 5000.0) / 0.5 + 1e-12);
+      check(alias < -60.0, "11 kHz alias at 5 kHz", alias, "dB");
+    }
+    {
+      piper::CaptureFrontEndConfig c = bare(rate);
+      c.high_pass_hz = 80.0f;
+      piper::CaptureFrontEnd fe(c);
+      const auto low = stream(fe, tone(rate, 30.0, 0.5, 2.0), chunk, nullptr);
+      const double att = 20.0 * std::log10(toneAmplitude(low.data() + 8000, 16000, 16000, 30.0) / 0.5);
+      check(att < -15.0, "high-pass 80 Hz: 30 Hz gain", att, "dB");
+      const auto mid = stream(fe, tone(rate, 1000.0, 0.5, 1.0), chunk, nullptr);
+      const double pass = 20.0 * std::log10(toneAmplitude(mid.data() + 1600, 12800, 16000, 1000.0) / 0.5);
+      check(std::fabs(pass) < 0.1, "high-pass 80 Hz: 1 kHz gain", pass, "dB");
+    }
+    {
+      // Stationary noise at -50 dBFS with tone bursts (1 s on / 1 s off) standing in for speech.
+      piper::CaptureFrontEndConfig c = bare(rate);
+      c.noise_suppression = true;
+      piper::CaptureFrontEnd fe(c);
+      std::mt19937 rng(7);
+      std::normal_distribution<float> noise(0.0f, 0.00316f);
+      std::vector<float> in(static_cast<size_t>(rate) * 8);
+      for (size_t i = 0; i < in.size(); i++) {
+        const bool on = (i / rate) % 2 == 1;
+        in[i] = noise(rng) + (on ? static_cast<float>(0.1 * std::sin(2.0 * kPi * 700.0 * i / rate)) : 0.0f);
+      }
+      size_t allocs = 0;
+      const auto out = stream(fe, in, chunk, &allocs);
+      // Last off second (6-7 s) and last on second (7-8 s), skipping 100 ms edges.
+      const double off_in = rmsDb(in.data() + size_t(rate * 6.1), size_t(rate * 0.8));
+      const double off_out = rmsDb(out.data() + 16000 * 6 + 1600, 12800);
+      check(off_in - off_out > 10.0, "noise-only reduction", off_in - off_out, "dB");
+      const double burst = 20.0 * std::log10(toneAmplitude(out.data() + 16000 * 7 + 1600, 12800, 16000, 700.0) / 0.1);
+      check(std::fabs(burst) < 1.0, "tone burst level through suppressor", burst, "dB");
+      check(allocs == 0, "allocations in process()/flush()", double(allocs), "");
+    }
+    {
+      // Quiet talker (-40 dBFS bursts over a -70 dBFS floor) steered toward -20 dBFS.
+      piper::CaptureFrontEndConfig c = bare(rate);
+      c.agc = true;
+      piper::CaptureFrontEnd fe(c);
+      std::mt19937 rng(11);
+      std::normal_distribution<float> noise(0.0f, 0.000316f);
+      std::vector<float> in(static_cast<size_t>(rate) * 4);
+      for (size_t i = 0; i < in.size(); i++) {
+        const double t = double(i) / rate;
+        const bool on = std::fmod(t, 0.5) < 0.35;
+        in[i] = noise(rng) + (on ? static_cast<float>(0.01414 * std::sin(2.0 * kPi * 300.0 * t)) : 0.0f);
+      }
+      const auto out = stream(fe, in, chunk, nullptr);
+      const double level =
+          20.0 * std::log10(toneAmplitude(out.data() + 16000 * 3 + 800, 4000, 16000, 300.0) / std::sqrt(2.0));
+      check(std::fabs(level - c.agc_target_dbfs) < 3.0, "AGC speech level after 3 s (target -20)", level, "dBFS");
+      // A near-full-scale input must not clip.
+      piper::CaptureFrontEnd loud(c);
+      const auto hot = stream(loud, tone(rate, 300.0, 0.99, 2.0), chunk, nullptr);
+      float peak = 0.0f;
+      for (float v : hot) peak = std::max(peak, std::fabs(v));
+      check(peak <= 0.975f, "AGC peak on a 0.99 full-scale tone", peak, "");
+    }
+    {
+      // Whole chain on the int16 path: cost per 10 ms frame.
+      piper::CaptureFrontEndConfig c;
+      c.input_rate = rate;
+      piper::CaptureFrontEnd fe(c);
+      std::mt19937 rng(3);
+      std::normal_distribution<float> noise(0.0f, 1000.0f);
+      std::vector<int16_t> in(static_cast<size_t>(rate) * 10);
+      for (auto& v : in) v = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, noise(rng))));
+      std::vector<int16_t> out(fe.maxOutput(chunk));
+      const size_t before = g_allocs.load();
+      for (size_t off = 0; off + chunk <= in.size(); off += chunk) fe.process(in.data() + off, chunk, out.data());
+      fe.flush(out.data());
+      check(g_allocs.load() == before, "allocations, full chain int16", double(g_allocs.load() - before), "");
+      std::printf("  full chain: %.2f us mean / %.2f us max per 10 ms frame (%llu frames)\n",
+                  fe.stats().meanFrameUs(), fe.stats().max_frame_us,
+                  static_cast<unsigned long long>(fe.stats().frames));
+    }
+  }
+  std::printf(g_failures ? "selftest: %d FAILED\n" : "selftest: all passed\n", g_failures);
+  return g_failures ? 1 : 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: capture_eval (--manifest <tsv> | --wav <file> ... | --selftest) [--frame-ms 10] [--out-dir <dir>]\n"
+               "                    [--json <report.json>] [--high-pass 80] [--no-ns] [--no-agc] [--agc-target -20]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string manifest, out_dir, json_out;
+  std::vector<std::string> wavs;
+  int frame_ms = 10;
+  bool run_selftest = false;
+  piper::CaptureFrontEndConfig base;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--manifest") manifest = next();
+    else if (arg == "--wav") wavs.push_back(next());
+    else if (arg == "--frame-ms") frame_ms = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--out-dir") out_dir = next();
+    else if (arg == "--json") json_out = next();
+    else if (arg == "--high-pass") base.high_pass_hz = static_cast<float>(std::atof(next().c_str()));
+    else if (arg == "--no-ns") base.noise_suppression = false;
+    else if (arg == "--no-agc") base.agc = false;
+    else if (arg == "--agc-target") base.agc_target_dbfs = static_cast<float>(std::atof(next().c_str()));
+    else if (arg == "--selftest") run_selftest = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (run_selftest) return selftest(static_cast<size_t>(frame_ms));
+  if (!manifest.empty()) {
+    std::ifstream in(manifest);
+    const std::string dir = manifest.find('/') == std::string::npos ? "" : manifest.substr(0, manifest.rfind('/') + 1);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      std::string path = line.substr(0, line.find('\t'));
+      if (!path.empty() && path[0] != '/') path = dir + path;
+      wavs.push_back(path);
+    }
+  }
+  if (wavs.empty()) {
+    usage();
+    return 2;
+  }
+
+  std::vector<FileResult> results;
+  std::vector<double> all_frame_us;
+  for (const std::string& path : wavs) {
+    std::vector<float> audio;
+    int rate = 0;
+    std::string err;
+    if (!piper_host::readWav(path, audio, rate, &err)) {
+      std::fprintf(stderr, "capture_eval: skip %s (%s)\n", path.c_str(), err.c_str());
+      continue;
+    }
+    piper::CaptureFrontEndConfig config = base;
+    config.input_rate = rate;
+    piper::CaptureFrontEnd fe;
+    if (!fe.configure(config)) {
+      std::fprintf(stderr, "capture_eval: skip %s (unsupported rate %d)\n", path.c_str(), rate);
+      continue;
+    }
+    std::vector<int16_t> pcm(audio.size());
+    for (size_t i = 0; i < audio.size(); i++) {
+      pcm[i] = static_cast<int16_t>(std::lrint(std::max(-1.0f, std::min(1.0f, audio[i])) * 32767.0f));
+    }
+    // Mic-sized chunks; one timing sample per call (one 10 ms frame per call at the default --frame-ms).
+    const size_t chunk = std::max<size_t>(1, static_cast<size_t>(rate) * frame_ms / 1000);
+    std::vector<int16_t> out(fe.maxOutput(pcm.size()) + fe.maxOutput(0));
+    std::vector<double> frame_us;
+    frame_us.reserve(pcm.size() / chunk + 1);
+    size_t n = 0;
+    const size_t allocs_before = g_allocs.load();
+    for (size_t off = 0; off < pcm.size(); off += chunk) {
+      const uint64_t frames_before = fe.stats().frames;
+      const double us_before = fe.stats().total_us;
+      n += fe.process(pcm.data() + off, std::min(chunk, pcm.size() - off), out.data() + n);
+      const uint64_t produced = fe.stats().frames - frames_before;
+      if (produced) frame_us.push_back((fe.stats().total_us - us_before) / static_cast<double>(produced));
+    }
+    n += fe.flush(out.data() + n);
+    const size_t allocs = g_allocs.load() - allocs_before;
+    out.resize(n);
+
+    FileResult r;
+    r.wav = path;
+    r.rate = rate;
+    r.audio_sec = static_cast<double>(audio.size()) / rate;
+    r.frames = static_cast<size_t>(fe.stats().frames);
+    r.mean_us = fe.stats().meanFrameUs();
+    r.p99_us = percentile(frame_us, 0.99);
+    r.max_us = fe.stats().max_frame_us;
+    r.in_dbfs = rmsDb(audio.data(), audio.size());
+    r.out_dbfs = rmsDb16(out.data(), out.size());
+    r.noise_dbfs = fe.stats().noise_dbfs;
+    r.agc_gain_db = fe.stats().agc_gain_db;
+    r.allocs = allocs;
+    results.push_back(r);
+    all_frame_us.insert(all_frame_us.end(), frame_us.begin(), frame_us.end());
+    std::printf("%-32s %6d Hz %6.2fs  %6.2f us/frame (p99 %6.2f, max %6.2f)  in %6.1f dBFS  out %6.1f dBFS  "
+                "noise %6.1f dBFS  gain %+5.1f dB%s\n",
+                path.substr(path.find_last_of('/') + 1).c_str(), rate, r.audio_sec, r.mean_us, r.p99_us, r.max_us,
+                r.in_dbfs, r.out_dbfs, r.noise_dbfs, r.agc_gain_db, allocs ? "  (allocated!)" : "");
+    if (!out_dir.empty()) {
+      std::string name = path.substr(path.find_last_of('/') + 1);
+      if (name.size() > 4 && name.compare(name.size() - 4, 4, ".wav") == 0) name.resize(name.size() - 4);
+      piper_host::writeWav16(out_dir + "/" + name + ".16k.wav", out.data(), out.size(), config.output_rate);
+    }
+  }
+  if (results.empty()) {
+    std::fprintf(stderr, "capture_eval: no files processed\n");
+    return 1;
+  }
+  double total_us = 0.0, total_frames = 0.0, audio_sec = 0.0;
+  for (const FileResult& r : results) {
+    total_us += r.mean_us * r.frames;
+    total_frames += r.frames;
+    audio_sec += r.audio_sec;
+  }
+  const double mean = total_frames > 0 ? total_us / total_frames : 0.0;
+  std::printf("\nfiles %zu  audio %.1fs  %.2f us mean / %.2f us p99 per 10 ms frame  (%.4f%% of real time)\n",
+              results.size(), audio_sec, mean, percentile(all_frame_us, 0.99), mean / 100.0);
+  if (!json_out.empty()) {
+    json report = {{"frame_ms", frame_ms},
+                   {"mean_us_per_frame", mean},
+                   {"p99_us_per_frame", percentile(all_frame_us, 0.99)},
+                   {"files", json::array()}};
+    for (const FileResult& r : results) {
+      report["files"].push_back({{"wav", r.wav},
+                                 {"rate", r.rate},
+                                 {"audio_sec", r.audio_sec},
+                                 {"frames", r.frames},
+                                 {"mean_us", r.mean_us},
+                                 {"p99_us", r.p99_us},
+                                 {"max_us", r.max_us},
+                                 {"in_dbfs", r.in_dbfs},
+                                 {"out_dbfs", r.out_dbfs},
+                                 {"noise_dbfs", r.noise_dbfs},
+                                 {"agc_gain_db", r.agc_gain_db},
+                                 {"allocations", r.allocs}});
+    }
+    std::ofstream(json_out) << report.dump(2) << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,959 @@
+// Rewrites an exported Piper voice so the decoder's LeakyRelu -> Conv1d [-> Add residual] chains run as one
+// FusedConv1d node each (ios/cpp/fused_decoder_ops.h), then optionally benchmarks the original and rewritten
+// model through the app's ORT adapter and checks that the audio matches.
+//
+//   decoder_fuse --in model.onnx --out model.fused.onnx [--no-residual]
+//                [--bench] [--config model.onnx.json] [--phonemes 120] [--runs 10] [--json report.json]
+//   decoder_fuse (--selftest | --kernel-bench [--seconds 1] [--runs 10])
+//
+// Matched: Conv (default domain) with stride 1, group 1, one spatial dim and explicit or no pads, whose input is
+// a LeakyRelu used only by it and/or whose output is used only by an Add of a non-constant tensor. Bare Convs
+// are left alone (ORT's im2col + GEMM is as fast there). The fused node takes the Add's place, so the residual
+// is already computed when it runs. The model is edited at the protobuf level; everything else is copied as is.
+//
+// --selftest checks fusedConv1d against a plain reference convolution over random and edge-case shapes (padding,
+// dilation, outputs ending on and just past a tile or 16-sample group, channel counts around the 4-channel
+// block, with and without LeakyRelu / bias / residual, tiles run out of order); exits non-zero on any failure.
+// --kernel-bench times the resblock convolutions of a medium voice's decoder for --seconds of audio, fused
+// against LeakyRelu, Conv1d and Add as separate passes, single-threaded. Neither needs a model.
+
+#include "fused_decoder_ops.h"
+#include "json.hpp"
+#include "ort_capi_adapter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+// --- Minimal protobuf wire format ------------------------------------------------------------------------
+
+enum WireType : uint32_t { kVarint = 0, kFixed64 = 1, kLengthDelimited = 2, kFixed32 = 5 };
+
+struct Field {
+  uint32_t number = 0;
+  uint32_t wire = 0;
+  uint64_t value = 0;  // varint / fixed32 / fixed64 payload
+  size_t begin = 0;    // whole field, key included
+  size_t end = 0;
+  size_t sub_begin = 0;  // kLengthDelimited payload
+  size_t sub_end = 0;
+};
+
+class Reader {
+ public:
+  Reader(const std::string& data, size_t begin, size_t end) : data_(data), pos_(begin), end_(end) {}
+  bool done() const { return pos_ >= end_; }
+
+  bool varint(uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos_ < end_; shift += 7) {
+      const uint8_t b = static_cast<uint8_t>(data_[pos_++]);
+      v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80)) return true;
+    }
+    return false;
+  }
+
+  bool next(Field& f) {
+    f.begin = pos_;
+    uint64_t key = 0;
+    if (!varint(key)) return false;
+    f.number = static_cast<uint32_t>(key >> 3);
+    f.wire = static_cast<uint32_t>(key & 7);
+    f.value = 0;
+    switch (f.wire) {
+      case kVarint:
+        if (!varint(f.value)) return false;
+        break;
+      case kFixed64:
+      case kFixed32: {
+        const size_t n = f.wire == kFixed32 ? 4 : 8;
+        if (end_ - pos_ < n) return false;
+        for (size_t i = 0; i < n; i++) f.value |= static_cast<uint64_t>(static_cast<uint8_t>(data_[pos_ + i])) << (8 * i);
+        pos_ += n;
+        break;
+      }
+      case kLengthDelimited: {
+        uint64_t len = 0;
+        if (!varint(len) || len > end_ - pos_) return false;
+        f.sub_begin = pos_;
+        f.sub_end = pos_ + static_cast<size_t>(len);
+        pos_ = f.sub_end;
+        break;
+      }
+      default:
+        return false;
+    }
+    f.end = pos_;
+    return true;
+  }
+
+  std::string str(const Field& f) const { return data_.substr(f.sub_begin, f.sub_end - f.sub_begin); }
+
+ private:
+  const std::string& data_;
+  size_t pos_;
+  size_t end_;
+};
+
+void putVarint(std::string& out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<char>(v));
+}
+
+void putKey(std::string& out, uint32_t number, uint32_t wire) { putVarint(out, (static_cast<uint64_t>(number) << 3) | wire); }
+
+void putBytes(std::string& out, uint32_t number, const std::string& bytes) {
+  putKey(out, number, kLengthDelimited);
+  putVarint(out, bytes.size());
+  out += bytes;
+}
+
+void putInt(std::string& out, uint32_t number, int64_t v) {
+  putKey(out, number, kVarint);
+  putVarint(out, static_cast<uint64_t>(v));
+}
+
+void putFloat(std::string& out, uint32_t number, float v) {
+  putKey(out, number, kFixed32);
+  uint32_t bits = 0;
+  std::memcpy(&bits, &v, 4);
+  for (int i = 0; i < 4; i++) out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+}
+
+// --- ONNX graph view ------------------------------------------------------------------------------------
+
+// onnx.proto3 field numbers.
+constexpr uint32_t kModelGraph = 7;
+constexpr uint32_t kModelOpsetImport = 8;
+constexpr uint32_t kOpsetDomain = 1;
+constexpr uint32_t kOpsetVersion = 2;
+constexpr uint32_t kGraphNode = 1;
+constexpr uint32_t kGraphInitializer = 5;
+constexpr uint32_t kGraphOutput = 12;
+constexpr uint32_t kGraphValueInfo = 13;
+constexpr uint32_t kValueInfoName = 1;
+constexpr uint32_t kTensorDims = 1;
+constexpr uint32_t kTensorName = 8;
+constexpr uint32_t kNodeInput = 1;
+constexpr uint32_t kNodeOutput = 2;
+constexpr uint32_t kNodeName = 3;
+constexpr uint32_t kNodeOpType = 4;
+constexpr uint32_t kNodeAttribute = 5;
+constexpr uint32_t kNodeDomain = 7;
+constexpr uint32_t kAttrName = 1;
+constexpr uint32_t kAttrF = 2;
+constexpr uint32_t kAttrI = 3;
+constexpr uint32_t kAttrS = 4;
+constexpr uint32_t kAttrG = 6;
+constexpr uint32_t kAttrInts = 8;
+constexpr uint32_t kAttrGraphs = 11;
+constexpr uint32_t kAttrType = 20;
+constexpr int64_t kAttrTypeFloat = 1;
+constexpr int64_t kAttrTypeInt = 2;
+
+struct Attribute {
+  bool has_f = false;
+  float f = 0.0f;
+  bool has_i = false;
+  int64_t i = 0;
+  std::string s;
+  std::vector<int64_t> ints;
+};
+
+struct Node {
+  std::vector<std::string> inputs;
+  std::vector<std::string> outputs;
+  std::string name;
+  std::string op_type;
+  std::string domain;
+  std::map<std::string, Attribute> attrs;
+  std::vector<std::string> subgraph_inputs;  // names read by nested graphs (If/Loop bodies)
+};
+
+bool isDefaultDomain(const std::string& d) { return d.empty() || d == "ai.onnx"; }
+
+bool readGraphInputs(const std::string& data, size_t begin, size_t end, std::vector<std::string>& out);
+
+bool readAttribute(const std::string& data, const Field& af, std::string& name, Attribute& a,
+                   std::vector<std::string>& subgraph_inputs) {
+  Reader r(data, af.sub_begin, af.sub_end);
+  Field f;
+  while (!r.done()) {
+    if (!r.next(f)) return false;
+    if (f.number == kAttrName && f.wire == kLengthDelimited) {
+      name = r.str(f);
+    } else if (f.number == kAttrF && f.wire == kFixed32) {
+      const uint32_t bits = static_cast<uint32_t>(f.value);
+      std::memcpy(&a.f, &bits, 4);
+      a.has_f = true;
+    } else if (f.number == kAttrI && f.wire == kVarint) {
+      a.i = static_cast<int64_t>(f.value);
+      a.has_i = true;
+    } else if (f.number == kAttrS && f.wire == kLengthDelimited) {
+      a.s = r.str(f);
+    } else if (f.number == kAttrInts) {
+      if (f.wire == kVarint) {
+        a.ints.push_back(static_cast<int64_t>(f.value));
+      } else if (f.wire == kLengthDelimited) {
+        Reader packed(data, f.sub_begin, f.sub_end);
+        while (!packed.done()) {
+          uint64_t v = 0;
+          if (!packed.varint(v)) return false;
+          a.ints.push_back(static_cast<int64_t>(v));
+        }
+      }
+    } else if ((f.number == kAttrG || f.number == kAttrGraphs) && f.wire == kLengthDelimited) {
+      if (!readGraphInputs(data, f.sub_begin, f.sub_end, subgraph_inputs)) return false;
+    }
+  }
+  return true;
+}
+
+bool readNode(const std::string& data, size_t begin, size_t end, Node& n) {
+  Reader r(data, begin, end);
+  Field f;
+  while (!r.done()) {
+    if (!r.next(f)) return false;
+    if (f.wire != kLengthDelimited) continue;
+    if (f.number == kNodeInput) n.inputs.push_back(r.str(f));
+    else if (f.number == kNodeOutput) n.outputs.push_back(r.str(f));
+    else if (f.number == kNodeName) n.name = r.str(f);
+    else if (f.number == kNodeOpType) n.op_type = r.str(f);
+    else if (f.number == kNodeDomain) n.domain = r.str(f);
+    else if (f.number == kNodeAttribute) {
+      std::string name;
+      Attribute a;
+      if (!readAttribute(data, f, name, a, n.subgraph_inputs)) return false;
+      n.attrs[name] = std::move(a);
+    }
+  }
+  return true;
+}
+
+// Every tensor name a (nested) graph's nodes read, outer-scope references included.
+bool readGraphInputs(const std::string& data, size_t begin, size_t end, std::vector<std::string>& out) {
+  Reader r(data, begin, end);
+  Field f;
+  while (!r.done()) {
+    if (!r.next(f)) return false;
+    if (f.number != kGraphNode || f.wire != kLengthDelimited) continue;
+    Node n;
+    if (!readNode(data, f.sub_begin, f.sub_end, n)) return false;
+    out.insert(out.end(), n.inputs.begin(), n.inputs.end());
+    out.insert(out.end(), n.subgraph_inputs.begin(), n.subgraph_inputs.end());
+  }
+  return true;
+}
+
+struct Graph {
+  std::vector<Field> fields;  // top-level GraphProto fields in order
+  std::vector<Node> nodes;    // parallel to the kGraphNode fields
+  std::map<std::string, std::vector<int64_t>> initializer_dims;
+  std::set<std::string> outputs;
+};
+
+bool readGraph(const std::string& data, size_t begin, size_t end, Graph& g) {
+  Reader r(data, begin, end);
+  Field f;
+  while (!r.done()) {
+    if (!r.next(f)) return false;
+    g.fields.push_back(f);
+    if (f.wire != kLengthDelimited) continue;
+    if (f.number == kGraphNode) {
+      Node n;
+      if (!readNode(data, f.sub_begin, f.sub_end, n)) return false;
+      g.nodes.push_back(std::move(n));
+    } else if (f.number == kGraphInitializer) {
+      Reader t(data, f.sub_begin, f.sub_end);
+      Field tf;
+      std::string name;
+      std::vector<int64_t> dims;
+      while (!t.done()) {
+        if (!t.next(tf)) return false;
+        if (tf.number == kTensorName && tf.wire == kLengthDelimited) name = t.str(tf);
+        if (tf.number == kTensorDims && tf.wire == kVarint) dims.push_back(static_cast<int64_t>(tf.value));
+        if (tf.number == kTensorDims && tf.wire == kLengthDelimited) {
+          Reader packed(data, tf.sub_begin, tf.sub_end);
+          while (!packed.done()) {
+            uint64_t v = 0;
+            if (!packed.varint(v)) return false;
+            dims.push_back(static_cast<int64_t>(v));
+          }
+        }
+      }
+      g.initializer_dims[name] = dims;
+    } else if (f.number == kGraphOutput) {
+      Reader v(data, f.sub_begin, f.sub_end);
+      Field vf;
+      while (!v.done()) {
+        if (!v.next(vf)) return false;
+        if (vf.number == kValueInfoName && vf.wire == kLengthDelimited) g.outputs.insert(v.str(vf));
+      }
+    }
+  }
+  return true;
+}
+
+// --- Fusion ---------------------------------------------------------------------------------------------
+
+struct Fusion {
+  size_t conv = 0;
+  long pre = -1;   // LeakyRelu node index
+  long post = -1;  // Add node index
+  std::string x, residual;
+  float alpha = 0.01f;
+};
+
+struct FuseStats {
+  size_t convs = 0;
+  size_t fused = 0;
+  size_t with_activation = 0;
+  size_t with_residual = 0;
+};
+
+// Conv attributes the fused kernel supports: (dilation, pad_begin, pad_end) or false.
+bool supportedConv(const Node& conv, const Graph& g, int64_t& dilation, int64_t& pad_begin, int64_t& pad_end) {
+  auto attr = [&](const char* name) -> const Attribute* {
+    auto it = conv.attrs.find(name);
+    return it == conv.attrs.end() ? nullptr : &it->second;
+  };
+  if (conv.inputs.size() < 2 || conv.outputs.size() != 1) return false;
+  if (const Attribute* a = attr("group"); a && a->i != 1) return false;
+  if (const Attribute* a = attr("auto_pad"); a && !a->s.empty() && a->s != "NOTSET") return false;
+  if (const Attribute* a = attr("strides")) {
+    for (int64_t s : a->ints) {
+      if (s != 1) return false;
+    }
+  }
+  size_t spatial = 0;
+  if (const Attribute* a = attr("kernel_shape")) {
+    spatial = a->ints.size();
+  } else {
+    auto w = g.initializer_dims.find(conv.inputs[1]);
+    if (w != g.initializer_dims.end() && w->second.size() >= 2) spatial = w->second.size() - 2;
+  }
+  if (spatial != 1) return false;
+  dilation = 1;
+  if (const Attribute* a = attr("dilations")) {
+    if (a->ints.size() > 1) return false;
+    if (!a->ints.empty()) dilation = a->ints[0];
+  }
+  pad_begin = pad_end = 0;
+  if (const Attribute* a = attr("pads")) {
+    if (a->ints.size() == 2) {
+      pad_begin = a->ints[0];
+      pad_end = a->ints[1];
+    } else if (!a->ints.empty()) {
+      return false;
+    }
+  }
+  return dilation >= 1 && pad_begin >= 0 && pad_end >= 0;
+}
+
+std::vector<Fusion> planFusions(const Graph& g, bool residual, FuseStats& stats) {
+  std::map<std::string, size_t> producer;
+  std::map<std::string, std::vector<size_t>> consumers;
+  std::map<std::string, size_t> uses;
+  std::set<std::string> constants;
+  for (const auto& init : g.initializer_dims) constants.insert(init.first);
+  for (size_t i = 0; i < g.nodes.size(); i++) {
+    const Node& n = g.nodes[i];
+    for (const auto& out : n.outputs) {
+      producer[out] = i;
+      if (n.op_type == "Constant" && isDefaultDomain(n.domain)) constants.insert(out);
+    }
+    for (const auto& in : n.inputs) {
+      if (in.empty()) continue;
+      consumers[in].push_back(i);
+      uses[in]++;
+    }
+    for (const auto& in : n.subgraph_inputs) uses[in] += 2;  // never fold a tensor a nested graph reads
+  }
+  for (const auto& out : g.outputs) uses[out] += 2;
+
+  std::vector<Fusion> plan;
+  std::set<size_t> claimed;
+  for (size_t i = 0; i < g.nodes.size(); i++) {
+    const Node& conv = g.nodes[i];
+    if (conv.op_type != "Conv" || !isDefaultDomain(conv.domain)) continue;
+    stats.convs++;
+    int64_t dilation = 1, pad_begin = 0, pad_end = 0;
+    if (!supportedConv(conv, g, dilation, pad_begin, pad_end)) continue;
+    Fusion fu;
+    fu.conv = i;
+    fu.x = conv.inputs[0];
+    auto p = producer.find(conv.inputs[0]);
+    if (p != producer.end() && uses[conv.inputs[0]] == 1 && !claimed.count(p->second)) {
+      const Node& act = g.nodes[p->second];
+      if (act.op_type == "LeakyRelu" && isDefaultDomain(act.domain) && act.inputs.size() == 1) {
+        auto a = act.attrs.find("alpha");
+        fu.alpha = a != act.attrs.end() && a->second.has_f ? a->second.f : 0.01f;
+        fu.pre = static_cast<long>(p->second);
+        fu.x = act.inputs[0];
+      }
+    }
+    const std::string& y = conv.outputs[0];
+    auto c = consumers.find(y);
+    if (residual && uses[y] == 1 && c != consumers.end() && c->second.size() == 1 && !claimed.count(c->second[0])) {
+      const Node& add = g.nodes[c->second[0]];
+      if (add.op_type == "Add" && isDefaultDomain(add.domain) && add.inputs.size() == 2 && add.outputs.size() == 1) {
+        const std::string& other = add.inputs[0] == y ? add.inputs[1] : add.inputs[0];
+        if (other != y && !other.empty() && !constants.count(other)) {
+          fu.post = static_cast<long>(c->second[0]);
+          fu.residual = other;
+        }
+      }
+    }
+    if (fu.pre < 0 && fu.post < 0) continue;  // bare Conv: leave to ORT
+    if (fu.pre >= 0) claimed.insert(static_cast<size_t>(fu.pre));
+    if (fu.post >= 0) claimed.insert(static_cast<size_t>(fu.post));
+    claimed.insert(i);
+    stats.fused++;
+    stats.with_activation += fu.pre >= 0;
+    stats.with_residual += fu.post >= 0;
+    plan.push_back(fu);
+  }
+  return plan;
+}
+
+std::string fusedNode(const Graph& g, const Fusion& fu) {
+  const Node& conv = g.nodes[fu.conv];
+  int64_t dilation = 1, pad_begin = 0, pad_end = 0;
+  supportedConv(conv, g, dilation, pad_begin, pad_end);
+  std::vector<std::string> inputs = {fu.x, conv.inputs[1]};
+  const std::string bias = conv.inputs.size() > 2 ? conv.inputs[2] : std::string();
+  if (!bias.empty() || fu.post >= 0) inputs.push_back(bias);
+  if (fu.post >= 0) inputs.push_back(fu.residual);
+  const std::string& output = fu.post >= 0 ? g.nodes[static_cast<size_t>(fu.post)].outputs[0] : conv.outputs[0];
+
+  std::string node;
+  for (const auto& in : inputs) putBytes(node, kNodeInput, in);
+  putBytes(node, kNodeOutput, output);
+  putBytes(node, kNodeName, (conv.name.empty() ? output : conv.name) + "/fused");
+  putBytes(node, kNodeOpType, piper_ort::kFusedConv1dOp);
+  auto attr = [&node](const char* name, int64_t type, auto write) {
+    std::string a;
+    putBytes(a, kAttrName, name);
+    write(a);
+    putInt(a, kAttrType, type);
+    putBytes(node, kNodeAttribute, a);
+  };
+  auto int_attr = [&](const char* name, int64_t v) {
+    attr(name, kAttrTypeInt, [v](std::string& a) { putInt(a, kAttrI, v); });
+  };
+  int_attr("dilation", dilation);
+  int_attr("pad_begin", pad_begin);
+  int_attr("pad_end", pad_end);
+  int_attr("pre_activation", fu.pre >= 0 ? 1 : 0);
+  attr("alpha", kAttrTypeFloat, [&fu](std::string& a) { putFloat(a, kAttrF, fu.alpha); });
+  putBytes(node, kNodeDomain, piper_ort::kFusedOpDomain);
+  return node;
+}
+
+std::string rewriteGraph(const std::string& data, const Graph& g, const std::vector<Fusion>& plan) {
+  std::map<size_t, const Fusion*> emit_at;  // node index -> fusion emitted in its place
+  std::set<size_t> dropped;
+  std::set<std::string> removed;  // intermediate tensors that no longer exist
+  for (const Fusion& fu : plan) {
+    dropped.insert(fu.conv);
+    if (fu.pre >= 0) {
+      dropped.insert(static_cast<size_t>(fu.pre));
+      removed.insert(g.nodes[static_cast<size_t>(fu.pre)].outputs[0]);
+    }
+    if (fu.post >= 0) {
+      dropped.insert(static_cast<size_t>(fu.post));
+      removed.insert(g.nodes[fu.conv].outputs[0]);
+    }
+    emit_at[fu.post >= 0 ? static_cast<size_t>(fu.post) : fu.conv] = &fu;
+  }
+  std::string out;
+  size_t node_index = 0;
+  for (const Field& f : g.fields) {
+    if (f.number == kGraphNode && f.wire == kLengthDelimited) {
+      const size_t i = node_index++;
+      auto e = emit_at.find(i);
+      if (e != emit_at.end()) putBytes(out, kGraphNode, fusedNode(g, *e->second));
+      else if (!dropped.count(i)) out.append(data, f.begin, f.end - f.begin);
+      continue;
+    }
+    if (f.number == kGraphValueInfo && f.wire == kLengthDelimited) {
+      Reader v(data, f.sub_begin, f.sub_end);
+      Field vf;
+      bool drop = false;
+      while (!v.done() && v.next(vf)) {
+        if (vf.number == kValueInfoName && vf.wire == kLengthDelimited) drop = removed.count(v.str(vf)) > 0;
+      }
+      if (drop) continue;
+    }
+    out.append(data, f.begin, f.end - f.begin);
+  }
+  return out;
+}
+
+bool fuseModel(const std::string& data, bool residual, std::string& out, FuseStats& stats, std::string& error) {
+  Reader model(data, 0, data.size());
+  Field f;
+  std::vector<Field> fields;
+  bool has_graph = false;
+  bool has_domain = false;
+  while (!model.done()) {
+    if (!model.next(f)) {
+      error = "malformed ModelProto";
+      return false;
+    }
+    fields.push_back(f);
+    if (f.number == kModelOpsetImport && f.wire == kLengthDelimited) {
+      Reader o(data, f.sub_begin, f.sub_end);
+      Field of;
+      while (!o.done() && o.next(of)) {
+        if (of.number == kOpsetDomain && of.wire == kLengthDelimited) has_domain |= o.str(of) == piper_ort::kFusedOpDomain;
+      }
+    }
+  }
+  out.clear();
+  for (const Field& mf : fields) {
+    if (mf.number != kModelGraph || mf.wire != kLengthDelimited) {
+      out.append(data, mf.begin, mf.end - mf.begin);
+      continue;
+    }
+    Graph g;
+    if (!readGraph(data, mf.sub_begin, mf.sub_end, g)) {
+      error = "malformed GraphProto";
+      return false;
+    }
+    has_graph = true;
+    const std::vector<Fusion> plan = planFusions(g, residual, stats);
+    putBytes(out, kModelGraph, rewriteGraph(data, g, plan));
+  }
+  if (!has_graph) {
+    error = "no graph in model";
+    return false;
+  }
+  if (!has_domain) {
+    std::string opset;
+    putBytes(opset, kOpsetDomain, piper_ort::kFusedOpDomain);
+    putInt(opset, kOpsetVersion, piper_ort::kFusedOpDomainVersion);
+    putBytes(out, kModelOpsetImport, opset);
+  }
+  return true;
+}
+
+// --- Benchmark ------------------------------------------------------------------------------------------
+
+bool readFile(const std::string& path, std::string& out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return false;
+  out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Phoneme ids cycling through the voice's id map (or 1..49 without a config), so both models see the same input.
+std::vector<int64_t> benchPhonemes(const std::string& config_path, size_t count) {
+  std::vector<int64_t> ids;
+  std::string text;
+  if (!config_path.empty() && readFile(config_path, text)) {
+    try {
+      const json cfg = json::parse(text);
+      if (cfg.contains("phoneme_id_map") && cfg["phoneme_id_map"].is_object()) {
+        for (const auto& item : cfg["phoneme_id_map"].items()) {
+          for (const auto& id : item.value()) {
+            if (id.is_number_integer() && id.get<int64_t>() > 0) ids.push_back(id.get<int64_t>());
+          }
+        }
+      }
+    } catch (...) {
+    }
+  }
+  if (ids.empty()) {
+    for (int64_t i = 1; i < 50; i++) ids.push_back(i);
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  std::vector<int64_t> out;
+  for (size_t i = 0; i < count; i++) out.push_back(ids[(i * 7) % ids.size()]);
+  return out;
+}
+
+struct BenchResult {
+  double load_ms = 0;
+  double mean_ms = 0;
+  double min_ms = 0;
+  std::vector<float> audio;
+};
+
+// Deterministic run (noise_scale = noise_w = 0); first inference is a warm-up.
+bool benchModel(const std::string& path, const std::vector<int64_t>& ids, int runs, BenchResult& r) {
+  using clock = std::chrono::steady_clock;
+  const auto t0 = clock::now();
+  piper_ort::PiperOrtSession* session = piper_ort::createSession(path.c_str());
+  r.load_ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+  if (!session) return false;
+  r.audio = piper_ort::runInference(session, ids, 0.0f, 1.0f, 0.0f, 0);
+  double total = 0;
+  r.min_ms = 1e30;
+  for (int i = 0; i < runs && !r.audio.empty(); i++) {
+    const auto s = clock::now();
+    const std::vector<float> audio = piper_ort::runInference(session, ids, 0.0f, 1.0f, 0.0f, 0);
+    const double ms = std::chrono::duration<double, std::milli>(clock::now() - s).count();
+    total += ms;
+    r.min_ms = std::min(r.min_ms, ms);
+  }
+  piper_ort::destroySession(session);
+  r.mean_ms = runs > 0 ? total / runs : 0;
+  return !r.audio.empty();
+}
+
+// --- Kernel self-test and bench --------------------------------------------------------------------------
+
+int g_failures = 0;
+
+void check(bool ok, const char* what, double value, const char* unit) {
+  std::printf("  %-52s %10.2f %-4s %s\n", what, value, unit, ok ? "ok" : "FAIL");
+  if (!ok) g_failures++;
+}
+
+// Direct definition of FusedConv1d, accumulated in double.
+std::vector<float> referenceConv1d(const piper_ort::FusedConv1dArgs& a) {
+  const size_t out_length = a.outLength();
+  std::vector<float> y(a.batch * a.out_channels * out_length);
+  for (size_t n = 0; n < a.batch; n++) {
+    for (size_t o = 0; o < a.out_channels; o++) {
+      for (size_t t = 0; t < out_length; t++) {
+        double acc = a.bias ? a.bias[o] : 0.0;
+        for (size_t c = 0; c < a.in_channels; c++) {
+          for (size_t k = 0; k < a.kernel; k++) {
+            const long long i = static_cast<long long>(t + k * a.dilation) - static_cast<long long>(a.pad_begin);
+            if (i < 0 || i >= static_cast<long long>(a.in_length)) continue;
+            float x = a.x[(n * a.in_channels + c) * a.in_length + static_cast<size_t>(i)];
+            if (a.pre_activation && x < 0.0f) x *= a.alpha;
+            acc += static_cast<double>(a.weight[(o * a.in_channels + c) * a.kernel + k]) * x;
+          }
+        }
+        const size_t at = (n * a.out_channels + o) * out_length + t;
+        y[at] = static_cast<float>(acc + (a.residual ? a.residual[at] : 0.0f));
+      }
+    }
+  }
+  return y;
+}
+
+struct ConvCase {
+  size_t batch, in_channels, out_channels, in_length, kernel, dilation, pad_begin, pad_end;
+  bool pre_activation, bias, residual;
+};
+
+// Max |fused - reference| relative to the reference's scale; NaN output (an unwritten sample) is infinite.
+double convCaseError(const ConvCase& cc, std::mt19937& rng, bool reverse_tiles) {
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  piper_ort::FusedConv1dArgs a;
+  a.batch = cc.batch;
+  a.in_channels = cc.in_channels;
+  a.in_length = cc.in_length;
+  a.out_channels = cc.out_channels;
+  a.kernel = cc.kernel;
+  a.dilation = cc.dilation;
+  a.pad_begin = cc.pad_begin;
+  a.pad_end = cc.pad_end;
+  a.pre_activation = cc.pre_activation;
+  a.alpha = 0.1f;
+  const size_t out_length = a.outLength();
+  std::vector<float> x(cc.batch * cc.in_channels * cc.in_length), w(cc.out_channels * cc.in_channels * cc.kernel),
+      b(cc.out_channels), r(cc.batch * cc.out_channels * out_length);
+  for (std::vector<float>* v : {&x, &w, &b, &r}) {
+    for (float& f : *v) f = gauss(rng);
+  }
+  std::vector<float> y(r.size(), std::nanf(""));
+  a.x = x.data();
+  a.weight = w.data();
+  a.bias = cc.bias ? b.data() : nullptr;
+  a.residual = cc.residual ? r.data() : nullptr;
+  a.y = y.data();
+  const size_t tiles = piper_ort::fusedConv1dTiles(a);
+  for (size_t t = 0; t < tiles; t++) piper_ort::fusedConv1dTile(a, reverse_tiles ? tiles - 1 - t : t);
+  const std::vector<float> ref = referenceConv1d(a);
+  double scale = 1.0, err = 0.0;
+  for (float v : ref) scale = std::max(scale, static_cast<double>(std::fabs(v)));
+  for (size_t i = 0; i < ref.size(); i++) {
+    const double d = std::fabs(static_cast<double>(y[i]) - ref[i]);
+    err = std::isnan(d) ? INFINITY : std::max(err, d);
+  }
+  return err / scale;
+}
+
+int selftest() {
+  std::mt19937 rng(11);
+  const double tol = 1e-5;
+  std::printf("edge shapes (tile 64, group 16, channel block 4)\n");
+  const struct {
+    const char* what;
+    ConvCase cc;
+  } edges[] = {
+      {"out 64 (one full tile), O 4", {1, 8, 4, 64, 1, 1, 0, 0, false, false, false}},
+      {"out 65 (one sample past a tile), O 5", {1, 8, 5, 67, 3, 1, 0, 0, true, true, true}},
+      {"out 17 (one sample past a group), O 7", {1, 3, 7, 19, 3, 1, 0, 0, true, true, false}},
+      {"out 1, K 11, pads 5/5", {1, 5, 3, 1, 11, 1, 5, 5, true, false, true}},
+      {"dilation 5, K 3, same padding", {1, 16, 16, 130, 3, 5, 5, 5, true, true, true}},
+      {"dilation 3, K 7, same padding, batch 2", {2, 9, 13, 200, 7, 3, 9, 9, true, true, true}},
+      {"pad_begin only, O 1, C 1", {1, 1, 1, 50, 5, 2, 8, 0, false, true, false}},
+      {"padded input shorter than the kernel span", {1, 4, 4, 3, 7, 2, 1, 1, true, true, false}},
+  };
+  for (const auto& e : edges) {
+    const double err = convCaseError(e.cc, rng, false);
+    check(err <= tol, e.what, err * 1e6, "ppm");
+  }
+
+  std::printf("random shapes\n");
+  const size_t channels[] = {1, 2, 3, 4, 5, 7, 8, 16, 17, 33};
+  const size_t lengths[] = {1, 5, 15, 16, 17, 63, 64, 65, 100, 129, 257};
+  const size_t kernels[] = {1, 3, 5, 7, 11};
+  const size_t dilations[] = {1, 2, 3, 5};
+  std::uniform_int_distribution<size_t> pick(0, 1000);
+  double worst = 0.0;
+  size_t cases = 0, in_order_failures = 0, reversed_failures = 0;
+  for (int i = 0; i < 300; i++) {
+    ConvCase cc;
+    cc.batch = 1 + pick(rng) % 2;
+    cc.in_channels = channels[pick(rng) % 10];
+    cc.out_channels = channels[pick(rng) % 10];
+    cc.in_length = lengths[pick(rng) % 11];
+    cc.kernel = kernels[pick(rng) % 5];
+    cc.dilation = dilations[pick(rng) % 4];
+    const size_t span = cc.dilation * (cc.kernel - 1);
+    cc.pad_begin = pick(rng) % (span + 1);
+    cc.pad_end = pick(rng) % (span + 1);
+    cc.pre_activation = pick(rng) % 2;
+    cc.bias = pick(rng) % 2;
+    cc.residual = pick(rng) % 2;
+    const bool reversed = i % 2 == 1;
+    const double err = convCaseError(cc, rng, reversed);
+    if (!(err <= tol)) ++(reversed ? reversed_failures : in_order_failures);
+    worst = std::max(worst, err);
+    cases++;
+  }
+  check(in_order_failures == 0, "300 random shapes, tiles in order: failures", static_cast<double>(in_order_failures),
+        "");
+  check(reversed_failures == 0, "tiles in reverse order: failures", static_cast<double>(reversed_failures), "");
+  check(worst <= tol, "worst relative error (ppm)", worst * 1e6, "ppm");
+  std::printf("selftest: %s\n", g_failures ? "FAILED" : "all passed");
+  return g_failures ? 1 : 0;
+}
+
+// Resblock convolutions of a Piper medium decoder (HiFi-GAN V1 layout: upsample_initial_channel 512, rates
+// 8, 8, 2, 2; resblock kernels 3, 7, 11 with dilations 1, 3, 5) for `seconds` of 22.05 kHz audio. Each
+// dilation step is LeakyRelu -> Conv(k, d) -> LeakyRelu -> Conv(k, 1) -> Add.
+int kernelBench(double seconds, int runs) {
+  const size_t samples = static_cast<size_t>(seconds * 22050);
+  struct Stage {
+    size_t channels, length;
+  };
+  const Stage stages[] = {{256, samples / 32}, {128, samples / 4}, {64, samples / 2}, {32, samples}};
+  const size_t kernels[] = {3, 7, 11};
+  const size_t dilations[] = {1, 3, 5};
+  std::mt19937 rng(2);
+  std::normal_distribution<float> gauss(0.f, 0.5f);
+  using clock = std::chrono::steady_clock;
+
+  std::printf("medium decoder resblocks, %.2f s of audio, single thread, best of %d\n", seconds, runs);
+  std::printf("%6s %7s %9s %11s %9s %8s\n", "chans", "length", "convs", "separate_ms", "fused_ms", "speedup");
+  double total_separate = 0.0, total_fused = 0.0, total_flops = 0.0;
+  for (const Stage& st : stages) {
+    const size_t C = st.channels, T = st.length;
+    std::vector<float> x(C * T), act(C * T), tmp(C * T), y(C * T);
+    for (float& v : x) v = gauss(rng);
+    std::vector<std::vector<float>> weights;
+    for (size_t k : kernels) {
+      for (int j = 0; j < 6; j++) {
+        std::vector<float> w(C * C * k);
+        for (float& v : w) v = gauss(rng) / std::sqrt(static_cast<float>(C * k));
+        weights.push_back(std::move(w));
+      }
+    }
+    auto conv = [&](const float* in, const float* w, size_t k, size_t d, bool pre, const float* res, float* out) {
+      piper_ort::FusedConv1dArgs a;
+      a.x = in;
+      a.weight = w;
+      a.residual = res;
+      a.y = out;
+      a.in_channels = a.out_channels = C;
+      a.in_length = T;
+      a.kernel = k;
+      a.dilation = d;
+      a.pad_begin = a.pad_end = d * (k - 1) / 2;
+      a.pre_activation = pre;
+      a.alpha = 0.1f;
+      piper_ort::fusedConv1d(a);
+    };
+    auto leaky = [&](const float* in, float* out) {
+      for (size_t i = 0; i < C * T; i++) out[i] = in[i] >= 0.f ? in[i] : 0.1f * in[i];
+    };
+    auto run = [&](bool fused) {
+      size_t wi = 0;
+      for (size_t k : kernels) {
+        for (size_t d : dilations) {
+          const float* w1 = weights[wi++].data();
+          const float* w2 = weights[wi++].data();
+          if (fused) {
+            conv(x.data(), w1, k, d, true, nullptr, tmp.data());
+            conv(tmp.data(), w2, k, 1, true, x.data(), y.data());
+          } else {
+            leaky(x.data(), act.data());
+            conv(act.data(), w1, k, d, false, nullptr, tmp.data());
+            leaky(tmp.data(), act.data());
+            conv(act.data(), w2, k, 1, false, nullptr, y.data());
+            for (size_t i = 0; i < C * T; i++) y[i] += x[i];
+          }
+        }
+      }
+    };
+    double best[2] = {1e30, 1e30};
+    for (int r = 0; r <= runs; r++) {
+      for (int fused = 0; fused < 2; fused++) {
+        const auto t0 = clock::now();
+        run(fused == 1);
+        const double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+        if (r > 0) best[fused] = std::min(best[fused], ms);  // run 0 is a warm-up
+      }
+    }
+    const size_t convs = 2 * 3 * 3;
+    for (size_t k : kernels) total_flops += 2.0 * 6 * C * C * k * T;
+    total_separate += best[0];
+    total_fused += best[1];
+    std::printf("%6zu %7zu %9zu %11.2f %9.2f %7.2fx\n", C, T, convs, best[0], best[1], best[0] / best[1]);
+  }
+  std::printf("%6s %7s %9s %11.2f %9.2f %7.2fx  (%.1f GFLOP/s fused)\n", "total", "", "", total_separate, total_fused,
+              total_separate / total_fused, total_flops / (total_fused * 1e6));
+  return 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: decoder_fuse --in <model.onnx> --out <model.fused.onnx> [--no-residual]\n"
+               "                    [--bench] [--config <model.onnx.json>] [--phonemes N] [--runs N] [--json <report.json>]\n"
+               "       decoder_fuse (--selftest | --kernel-bench [--seconds 1] [--runs 10])\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string in_path, out_path, config_path, json_out;
+  bool residual = true;
+  bool bench = false;
+  int phonemes = 120;
+  int runs = 10;
+  bool run_selftest = false, kernel_bench = false;
+  double seconds = 1.0;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--in") in_path = next();
+    else if (arg == "--out") out_path = next();
+    else if (arg == "--config") config_path = next();
+    else if (arg == "--json") json_out = next();
+    else if (arg == "--no-residual") residual = false;
+    else if (arg == "--bench") bench = true;
+    else if (arg == "--phonemes") phonemes = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--runs") runs = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--selftest") run_selftest = true;
+    else if (arg == "--kernel-bench") kernel_bench = true;
+    else if (arg == "--seconds") seconds = std::max(0.1, std::atof(next().c_str()));
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (run_selftest) return selftest();
+  if (kernel_bench) return kernelBench(seconds, runs);
+  if (in_path.empty() || out_path.empty()) {
+    usage();
+    return 2;
+  }
+  if (config_path.empty()) config_path = in_path + ".json";
+
+  std::string model;
+  if (!readFile(in_path, model)) {
+    std::fprintf(stderr, "decoder_fuse: cannot read %s\n", in_path.c_str());
+    return 1;
+  }
+  std::string fused, error;
+  FuseStats stats;
+  if (!fuseModel(model, residual, fused, stats, error)) {
+    std::fprintf(stderr, "decoder_fuse: %s: %s\n", in_path.c_str(), error.c_str());
+    return 1;
+  }
+  {
+    std::ofstream f(out_path, std::ios::binary);
+    if (!f.write(fused.data(), static_cast<std::streamsize>(fused.size()))) {
+      std::fprintf(stderr, "decoder_fuse: cannot write %s\n", out_path.c_str());
+      return 1;
+    }
+  }
+  std::printf("%s: %zu Conv, %zu fused (%zu with LeakyRelu, %zu with residual Add) -> %s\n", in_path.c_str(),
+              stats.convs, stats.fused, stats.with_activation, stats.with_residual, out_path.c_str());
+
+  json report = {{"model", in_path},
+                 {"out", out_path},
+                 {"convs", stats.convs},
+                 {"fused", stats.fused},
+                 {"fused_with_activation", stats.with_activation},
+                 {"fused_with_residual", stats.with_residual}};
+  int rc = 0;
+  if (bench) {
+    const std::vector<int64_t> ids = benchPhonemes(config_path, static_cast<size_t>(phonemes));
+    BenchResult base, opt;
+    if (!benchModel(in_path, ids, runs, base) || !benchModel(out_path, ids, runs, opt)) {
+      std::fprintf(stderr, "decoder_fuse: inference failed (see [PiperORT] log)\n");
+      return 1;
+    }
+    double max_diff = 0, err = 0, sig = 0;
+    const bool same_length = base.audio.size() == opt.audio.size();
+    for (size_t i = 0; same_length && i < base.audio.size(); i++) {
+      const double d = std::fabs(static_cast<double>(base.audio[i]) - opt.audio[i]);
+      max_diff = std::max(max_diff, d);
+      err += d * d;
+      sig += static_cast<double>(base.audio[i]) * base.audio[i];
+    }
+    const double snr_db = err > 0 ? 10.0 * std::log10(sig / err) : 200.0;
+    std::printf("%d phonemes, %zu samples, %d runs\n", phonemes, base.audio.size(), runs);
+    std::printf("  original: load %.1f ms, infer mean %.2f ms (min %.2f)\n", base.load_ms, base.mean_ms, base.min_ms);
+    std::printf("  fused:    load %.1f ms, infer mean %.2f ms (min %.2f)\n", opt.load_ms, opt.mean_ms, opt.min_ms);
+    std::printf("  speedup %.2fx; max |diff| %.2e, SNR %.1f dB\n", opt.mean_ms > 0 ? base.mean_ms / opt.mean_ms : 0.0,
+                max_diff, snr_db);
+    if (!same_length) {
+      std::fprintf(stderr, "decoder_fuse: output length differs (%zu vs %zu)\n", base.audio.size(), opt.audio.size());
+      rc = 1;
+    }
+    report["bench"] = {{"phonemes", phonemes},
+                       {"runs", runs},
+                       {"samples", base.audio.size()},
+                       {"original_load_ms", base.load_ms},
+                       {"original_mean_ms", base.mean_ms},
+                       {"original_min_ms", base.min_ms},
+                       {"fused_load_ms", opt.load_ms},
+                       {"fused_mean_ms", opt.mean_ms},
+                       {"fused_min_ms", opt.min_ms},
+                       {"speedup", opt.mean_ms > 0 ? base.mean_ms / opt.mean_ms : 0.0},
+                       {"max_abs_diff", max_diff},
+                       {"snr_db", snr_db}};
+  }
+  if (!json_out.empty()) {
+    std::ofstream f(json_out);
+    f << report.dump(2) << "\n";
+  }
+  return rc;
+}
@@ -0,0 +1,865 @@
+// Compiles a content pack's retrieval sources into one mmap-ready container (ios/cpp/pack_container.h):
+// per source (rules, cards) the f16 vector rows, the chunk store and token posting lists, plus columnar copies
+// of rules.db / cards.db with sorted key indexes, the card-name trie from cards.db and an espeak phoneme cache
+// for the pack vocabulary (card names and frequent rules.db words). Sources are read once, every artifact is built on its own worker, and the output is byte-for-byte
+// reproducible (sorted inputs, no timestamps); timings go to stdout and the optional --json report.
+// --sq8 also writes each source's scalar-quantized rows to <source>/vectors.sq8 (ios/cpp/vector_sq8.h) for
+// the runtime index's int8 scan.
+//
+//   pack_compile --pack <content_pack dir> [--out <pack.bin>] [--threads N] [--json <report.json>]
+//                [--espeak-data <dir> --voice en-us] [--phoneme-min-count 3] [--sq8]
+//
+// Delta segments (<source>/segments.json) are left to the runtime index; pack_compile reads the base
+// chunks.jsonl / vectors.f16 a full pack build produces.
+
+#include "json.hpp"
+#include "pack_container.h"
+#include "vector_sq8.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifdef PACK_COMPILE_USE_ESPEAK
+#include <espeak-ng/speak_lib.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+
+const char* const kSources[] = {"rules", "cards"};
+
+struct SourceData {
+  std::string name;
+  bool has_chunks = false;
+  std::vector<std::string> chunks;  // chunks.jsonl lines
+  uint32_t dim = 0;
+  std::string vectors;  // raw f16 bytes; empty if absent
+};
+
+struct CardRow {
+  std::string name_norm;
+  std::string oracle_id;
+  std::string name;
+};
+
+// Every column of a rules.db / cards.db table as read by SELECT *.
+struct TableData {
+  std::vector<std::string> columns;
+  std::vector<std::vector<int>> types;  // [row][column] SQLITE_INTEGER / SQLITE_FLOAT / SQLITE_TEXT / SQLITE_NULL
+  std::vector<std::vector<std::string>> text;
+  std::vector<std::vector<int64_t>> ints;
+  std::vector<std::vector<double>> reals;
+};
+
+struct Section {
+  std::string name;
+  piper::PackSectionKind kind = piper::PackSectionKind::kStrings;
+  uint32_t count = 0;
+  uint32_t param = 0;
+  std::string bytes;
+};
+
+struct Timing {
+  std::string step;
+  double ms = 0.0;
+};
+
+class Timings {
+ public:
+  void add(const std::string& step, double ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    items_.push_back({step, ms});
+  }
+  std::vector<Timing> sorted() const {
+    std::vector<Timing> out = items_;
+    std::sort(out.begin(), out.end(), [](const Timing& a, const Timing& b) { return a.step < b.step; });
+    return out;
+  }
+
+ private:
+  std::mutex mu_;
+  std::vector<Timing> items_;
+};
+
+double msSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Runs tasks on up to `threads` workers; returns the first error (empty on success).
+std::string runParallel(const std::vector<std::pair<std::string, std::function<std::string()>>>& tasks,
+                        size_t threads, Timings& timings) {
+  std::atomic<size_t> next{0};
+  std::mutex mu;
+  std::string first_error;
+  auto worker = [&]() {
+    for (size_t i; (i = next.fetch_add(1)) < tasks.size();) {
+      const auto t0 = std::chrono::steady_clock::now();
+      std::string err = tasks[i].second();
+      timings.add(tasks[i].first, msSince(t0));
+      if (!err.empty()) {
+        std::lock_guard<std::mutex> lock(mu);
+        if (first_error.empty()) first_error = tasks[i].first + ": " + err;
+      }
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < std::min(threads, tasks.size()); ++i) pool.emplace_back(worker);
+  worker();
+  for (std::thread& t : pool) t.join();
+  return first_error;
+}
+
+bool fileExists(const std::string& path) {
+  std::ifstream f(path, std::ios::binary);
+  return static_cast<bool>(f);
+}
+
+bool readFile(const std::string& path, std::string& out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return false;
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  out = ss.str();
+  return true;
+}
+
+// Lowercased ASCII [a-z0-9] runs; UTF-8 bytes (>= 0x80) stay inside tokens so accented names survive.
+template <typename F>
+void forEachToken(const std::string& text, F&& fn) {
+  std::string tok;
+  for (unsigned char c : text) {
+    if (c >= 'A' && c <= 'Z') tok += static_cast<char>(c - 'A' + 'a');
+    else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80) tok += static_cast<char>(c);
+    else if (!tok.empty()) {
+      fn(tok);
+      tok.clear();
+    }
+  }
+  if (!tok.empty()) fn(tok);
+}
+
+void appendRaw(std::string& out, const void* p, size_t n) {
+  out.append(static_cast<const char*>(p), n);
+}
+
+template <typename T>
+void appendPod(std::string& out, const T& v) {
+  appendRaw(out, &v, sizeof(v));
+}
+
+void padTo(std::string& out, size_t align) {
+  out.resize((out.size() + align - 1) / align * align, '\0');
+}
+
+std::string stringTable(const std::vector<std::string>& strings) {
+  std::string out;
+  uint64_t off = 0;
+  appendPod(out, off);
+  for (const std::string& s : strings) {
+    off += s.size();
+    appendPod(out, off);
+  }
+  for (const std::string& s : strings) out += s;
+  return out;
+}
+
+std::string loadSource(const std::string& pack, SourceData& src) {
+  const std::string dir = pack + "/" + src.name;
+  std::string text;
+  if (readFile(dir + "/chunks.jsonl", text)) {
+    src.has_chunks = true;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (!line.empty()) src.chunks.push_back(std::move(line));
+    }
+  }
+  std::string meta_text;
+  if (!readFile(dir + "/index_meta.json", meta_text) || !fileExists(dir + "/vectors.f16")) return std::string();
+  const json meta = json::parse(meta_text, nullptr, false);
+  if (meta.is_discarded() || !meta.contains("dim") || !meta["dim"].is_number_unsigned())
+    return "index_meta.json has no dim";
+  src.dim = meta["dim"].get<uint32_t>();
+  if (!readFile(dir + "/vectors.f16", src.vectors)) return "cannot read vectors.f16";
+  if (src.dim == 0 || src.vectors.size() % (size_t(src.dim) * 2) != 0)
+    return "vectors.f16 size is not a multiple of dim";
+  return std::string();
+}
+
+std::string queryDb(const std::string& path, const char* sql,
+                    const std::function<void(sqlite3_stmt*, const std::map<std::string, int>&)>& row) {
+  sqlite3* db = nullptr;
+  if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+    sqlite3_close(db);
+    return "cannot open " + path;
+  }
+  sqlite3_stmt* stmt = nullptr;
+  std::string err;
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    err = sqlite3_errmsg(db);
+  } else {
+    std::map<std::string, int> columns;
+    for (int i = 0; i < sqlite3_column_count(stmt); ++i) columns[sqlite3_column_name(stmt, i)] = i;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) row(stmt, columns);
+    if (rc != SQLITE_DONE) err = sqlite3_errmsg(db);
+  }
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+  return err;
+}
+
+std::string columnText(sqlite3_stmt* stmt, const std::map<std::string, int>& columns, const char* name) {
+  auto it = columns.find(name);
+  if (it == columns.end()) return std::string();
+  const unsigned char* t = sqlite3_column_text(stmt, it->second);
+  return t ? reinterpret_cast<const char*>(t) : std::string();
+}
+
+void appendTableRow(sqlite3_stmt* stmt, TableData& table) {
+  const int n = sqlite3_column_count(stmt);
+  if (table.columns.empty()) {
+    for (int i = 0; i < n; ++i) table.columns.push_back(sqlite3_column_name(stmt, i));
+  }
+  table.types.emplace_back(n);
+  table.text.emplace_back(n);
+  table.ints.emplace_back(n, 0);
+  table.reals.emplace_back(n, 0.0);
+  for (int i = 0; i < n; ++i) {
+    const int type = sqlite3_column_type(stmt, i);
+    table.types.back()[i] = type == SQLITE_BLOB ? SQLITE_TEXT : type;
+    if (type == SQLITE_INTEGER) table.ints.back()[i] = sqlite3_column_int64(stmt, i);
+    if (type == SQLITE_FLOAT) table.reals.back()[i] = sqlite3_column_double(stmt, i);
+    if (type != SQLITE_NULL) {
+      const unsigned char* t = sqlite3_column_text(stmt, i);
+      table.text.back()[i].assign(reinterpret_cast<const char*>(t), static_cast<size_t>(sqlite3_column_bytes(stmt, i)));
+    }
+  }
+}
+
+// Column-wise copy of a table with sorted row-number indexes on index_columns (missing ones are skipped).
+// Rows are reordered by the first index so the section bytes do not depend on the database's row order. A
+// column is integer when every non-NULL value is, real when every one is numeric, text otherwise.
+Section buildTable(const std::string& source, const TableData& table, const std::vector<std::string>& index_columns) {
+  const size_t rows = table.types.size();
+  const size_t columns = table.columns.size();
+  std::vector<uint32_t> index_of;
+  for (const std::string& name : index_columns) {
+    for (size_t c = 0; c < columns; ++c) {
+      if (table.columns[c] == name) index_of.push_back(static_cast<uint32_t>(c));
+    }
+  }
+  std::vector<piper::PackColumnType> types(columns, piper::PackColumnType::kInt);
+  for (size_t c = 0; c < columns; ++c) {
+    for (size_t r = 0; r < rows; ++r) {
+      const int t = table.types[r][c];
+      if (t == SQLITE_TEXT) types[c] = piper::PackColumnType::kText;
+      else if (t == SQLITE_FLOAT && types[c] == piper::PackColumnType::kInt) types[c] = piper::PackColumnType::kReal;
+    }
+  }
+  auto less = [&](size_t c, size_t a, size_t b) {
+    const bool null_a = table.types[a][c] == SQLITE_NULL, null_b = table.types[b][c] == SQLITE_NULL;
+    if (null_a || null_b) return null_a && !null_b;
+    switch (types[c]) {
+      case piper::PackColumnType::kInt: return table.ints[a][c] < table.ints[b][c];
+      case piper::PackColumnType::kReal: {
+        const double x = table.types[a][c] == SQLITE_INTEGER ? double(table.ints[a][c]) : table.reals[a][c];
+        const double y = table.types[b][c] == SQLITE_INTEGER ? double(table.ints[b][c]) : table.reals[b][c];
+        return x < y;
+      }
+      default: return table.text[a][c] < table.text[b][c];
+    }
+  };
+  std::vector<uint32_t> order(rows);
+  for (size_t r = 0; r < rows; ++r) order[r] = static_cast<uint32_t>(r);
+  if (!index_of.empty()) {
+    // Whole-row tie break so duplicate keys still give one order.
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      if (less(index_of[0], a, b)) return true;
+      if (less(index_of[0], b, a)) return false;
+      for (size_t c = 0; c < columns; ++c) {
+        if (less(c, a, b)) return true;
+        if (less(c, b, a)) return false;
+      }
+      return false;
+    });
+  }
+
+  Section s;
+  s.name = source + ".table";
+  s.kind = piper::PackSectionKind::kTable;
+  s.count = static_cast<uint32_t>(rows);
+  s.param = static_cast<uint32_t>(columns);
+  s.bytes.resize(40);
+  const uint64_t names_off = s.bytes.size();
+  s.bytes += stringTable(table.columns);
+  padTo(s.bytes, 8);
+  const uint64_t columns_off = s.bytes.size();
+  s.bytes.resize(s.bytes.size() + columns * sizeof(piper::PackColumn));
+  const uint64_t indexes_off = s.bytes.size();
+  s.bytes.resize(s.bytes.size() + index_of.size() * sizeof(piper::PackIndex));
+  for (size_t c = 0; c < columns; ++c) {
+    piper::PackColumn col{static_cast<uint32_t>(types[c]), 0, 0, 0};
+    padTo(s.bytes, 8);
+    col.data_off = s.bytes.size();
+    if (types[c] == piper::PackColumnType::kText) {
+      std::vector<std::string> values(rows);
+      for (size_t i = 0; i < rows; ++i) values[i] = table.text[order[i]][c];
+      s.bytes += stringTable(values);
+    } else {
+      for (size_t i = 0; i < rows; ++i) {
+        const size_t r = order[i];
+        if (types[c] == piper::PackColumnType::kInt) {
+          appendPod(s.bytes, table.ints[r][c]);
+        } else {
+          appendPod(s.bytes, table.types[r][c] == SQLITE_INTEGER ? double(table.ints[r][c]) : table.reals[r][c]);
+        }
+      }
+    }
+    std::string nulls((rows + 7) / 8, '\0');
+    bool any_null = false;
+    for (size_t i = 0; i < rows; ++i) {
+      if (table.types[order[i]][c] != SQLITE_NULL) continue;
+      nulls[i / 8] = static_cast<char>(nulls[i / 8] | (1 << (i % 8)));
+      any_null = true;
+    }
+    if (any_null) {
+      col.nulls_off = s.bytes.size();
+      s.bytes += nulls;
+    }
+    std::memcpy(&s.bytes[columns_off + c * sizeof(col)], &col, sizeof(col));
+  }
+  for (size_t i = 0; i < index_of.size(); ++i) {
+    const uint32_t c = index_of[i];
+    std::vector<uint32_t> sorted;
+    for (uint32_t r = 0; r < rows; ++r) {
+      if (table.types[order[r]][c] != SQLITE_NULL) sorted.push_back(r);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [&](uint32_t a, uint32_t b) { return less(c, order[a], order[b]); });
+    padTo(s.bytes, 8);
+    const piper::PackIndex index{c, static_cast<uint32_t>(sorted.size()), s.bytes.size()};
+    appendRaw(s.bytes, sorted.data(), sorted.size() * sizeof(uint32_t));
+    std::memcpy(&s.bytes[indexes_off + i * sizeof(index)], &index, sizeof(index));
+  }
+  const uint32_t header_u32[4] = {static_cast<uint32_t>(rows), static_cast<uint32_t>(columns),
+                                  static_cast<uint32_t>(index_of.size()), 0};
+  const uint64_t header_u64[3] = {names_off, columns_off, indexes_off};
+  std::memcpy(&s.bytes[0], header_u32, sizeof(header_u32));
+  std::memcpy(&s.bytes[16], header_u64, sizeof(header_u64));
+  return s;
+}
+
+Section buildChunks(const SourceData& src) {
+  Section s;
+  s.name = src.name + ".chunks";
+  s.kind = piper::PackSectionKind::kStrings;
+  s.count = static_cast<uint32_t>(src.chunks.size());
+  s.bytes = stringTable(src.chunks);
+  return s;
+}
+
+std::string buildPostings(const SourceData& src, Section& s) {
+  std::unordered_map<std::string, std::vector<piper::PackPosting>> index;
+  std::vector<uint32_t> doc_len(src.chunks.size(), 0);
+  for (size_t row = 0; row < src.chunks.size(); ++row) {
+    const json chunk = json::parse(src.chunks[row], nullptr, false);
+    if (chunk.is_discarded()) return "chunks.jsonl line " + std::to_string(row + 1) + " is not JSON";
+    if (!chunk.contains("text") || !chunk["text"].is_string()) continue;
+    std::unordered_map<std::string, uint32_t> tf;
+    forEachToken(chunk["text"].get_ref<const std::string&>(), [&](const std::string& tok) {
+      ++tf[tok];
+      ++doc_len[row];
+    });
+    for (const auto& kv : tf) index[kv.first].push_back({static_cast<uint32_t>(row), kv.second});
+  }
+  std::vector<const std::string*> terms;
+  terms.reserve(index.size());
+  for (const auto& kv : index) terms.push_back(&kv.first);
+  std::sort(terms.begin(), terms.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+
+  std::vector<piper::PackTerm> entries;
+  std::vector<piper::PackPosting> postings;
+  std::string blob;
+  for (const std::string* term : terms) {
+    const auto& list = index[*term];  // rows were appended in ascending order
+    entries.push_back({static_cast<uint32_t>(blob.size()), static_cast<uint32_t>(term->size()),
+                       static_cast<uint32_t>(postings.size()), static_cast<uint32_t>(list.size())});
+    postings.insert(postings.end(), list.begin(), list.end());
+    blob += *term;
+  }
+
+  s.name = src.name + ".postings";
+  s.kind = piper::PackSectionKind::kPostings;
+  s.count = static_cast<uint32_t>(entries.size());
+  s.param = static_cast<uint32_t>(doc_len.size());
+  const uint64_t header = 48;
+  const uint64_t doc_len_off = header;
+  const uint64_t terms_off = (doc_len_off + doc_len.size() * sizeof(uint32_t) + 7) / 8 * 8;
+  const uint64_t postings_off = terms_off + entries.size() * sizeof(piper::PackTerm);
+  const uint64_t blob_off = postings_off + postings.size() * sizeof(piper::PackPosting);
+  appendPod(s.bytes, s.count);
+  appendPod(s.bytes, s.param);
+  appendPod(s.bytes, static_cast<uint64_t>(postings.size()));
+  appendPod(s.bytes, doc_len_off);
+  appendPod(s.bytes, terms_off);
+  appendPod(s.bytes, postings_off);
+  appendPod(s.bytes, blob_off);
+  appendRaw(s.bytes, doc_len.data(), doc_len.size() * sizeof(uint32_t));
+  padTo(s.bytes, 8);
+  appendRaw(s.bytes, entries.data(), entries.size() * sizeof(piper::PackTerm));
+  appendRaw(s.bytes, postings.data(), postings.size() * sizeof(piper::PackPosting));
+  s.bytes += blob;
+  return std::string();
+}
+
+// Breadth-first layout so each node's children are contiguous; keys sorted and unique.
+Section buildNameTrie(std::vector<CardRow> cards, size_t* duplicates) {
+  std::sort(cards.begin(), cards.end(), [](const CardRow& a, const CardRow& b) {
+    return a.name_norm != b.name_norm ? a.name_norm < b.name_norm : a.oracle_id < b.oracle_id;
+  });
+  std::vector<std::string> keys, values;
+  for (const CardRow& c : cards) {
+    if (c.name_norm.empty()) continue;
+    if (!keys.empty() && keys.back() == c.name_norm) {
+      ++*duplicates;  // same normalized name: keep the smallest oracle id
+      continue;
+    }
+    keys.push_back(c.name_norm);
+    values.push_back(c.oracle_id);
+  }
+
+  struct Pending {
+    size_t lo, hi, depth, node;
+  };
+  std::vector<piper::PackTrieNode> nodes(1, piper::PackTrieNode{0, piper::kPackTrieNoValue, 0, 0, 0, 0});
+  std::vector<Pending> queue{{0, keys.size(), 0, 0}};
+  for (size_t q = 0; q < queue.size(); ++q) {
+    const Pending p = queue[q];
+    size_t i = p.lo;
+    if (i < p.hi && keys[i].size() == p.depth) nodes[p.node].value = static_cast<uint32_t>(i++);
+    nodes[p.node].first_child = static_cast<uint32_t>(nodes.size());
+    while (i < p.hi) {
+      const unsigned char c = static_cast<unsigned char>(keys[i][p.depth]);
+      size_t j = i;
+      while (j < p.hi && static_cast<unsigned char>(keys[j][p.depth]) == c) ++j;
+      nodes.push_back({0, piper::kPackTrieNoValue, 0, c, 0, 0});
+      ++nodes[p.node].child_count;
+      queue.push_back({i, j, p.depth + 1, nodes.size() - 1});
+      i = j;
+    }
+  }
+
+  Section s;
+  s.name = "cards.name_trie";
+  s.kind = piper::PackSectionKind::kTrie;
+  s.count = static_cast<uint32_t>(keys.size());
+  s.param = static_cast<uint32_t>(nodes.size());
+  const uint64_t nodes_off = 24;
+  const uint64_t values_off = nodes_off + nodes.size() * sizeof(piper::PackTrieNode);
+  appendPod(s.bytes, static_cast<uint32_t>(nodes.size()));
+  appendPod(s.bytes, static_cast<uint32_t>(keys.size()));
+  appendPod(s.bytes, nodes_off);
+  appendPod(s.bytes, values_off);
+  appendRaw(s.bytes, nodes.data(), nodes.size() * sizeof(piper::PackTrieNode));
+  s.bytes += stringTable(values);
+  return s;
+}
+
+// Same espeak call as the engine's phonemize_active_voice (IPA, clause by clause).
+std::string phonemizeWords(const std::string& espeak_data, const std::string& voice,
+                           const std::vector<std::string>& words, std::vector<std::string>& ipa) {
+#ifdef PACK_COMPILE_USE_ESPEAK
+  if (espeak_Initialize(AUDIO_OUTPUT_SYNCHRONOUS, 0, espeak_data.empty() ? nullptr : espeak_data.c_str(), 0) < 0)
+    return "espeak_Initialize failed";
+  if (espeak_SetVoiceByName(voice.c_str()) != 0) return "espeak voice " + voice + " not found";
+  ipa.clear();
+  for (const std::string& word : words) {
+    std::string out;
+    const char* input = word.c_str();
+    while (input && *input) {
+      int terminator = 0;
+      const char* phonemes = espeak_TextToPhonemesWithTerminator(reinterpret_cast<const void**>(&input),
+                                                                 espeakCHARS_AUTO, 0x02, &terminator);
+      if (phonemes) out += phonemes;
+    }
+    ipa.push_back(std::move(out));
+  }
+  espeak_Terminate();
+  return std::string();
+#else
+  (void)espeak_data;
+  (void)voice;
+  (void)words;
+  (void)ipa;
+  return "built without espeak-ng";
+#endif
+}
+
+Section buildPhonemes(const std::vector<std::string>& words, const std::vector<std::string>& ipa) {
+  Section s;
+  s.name = "phonemes";
+  s.kind = piper::PackSectionKind::kStringMap;
+  s.count = static_cast<uint32_t>(words.size());
+  const std::string keys = stringTable(words);
+  const uint64_t keys_off = 24;
+  const uint64_t values_off = (keys_off + keys.size() + 7) / 8 * 8;
+  appendPod(s.bytes, s.count);
+  appendPod(s.bytes, static_cast<uint32_t>(0));
+  appendPod(s.bytes, keys_off);
+  appendPod(s.bytes, values_off);
+  s.bytes += keys;
+  padTo(s.bytes, 8);
+  s.bytes += stringTable(ipa);
+  return s;
+}
+
+bool writeContainer(const std::string& path, std::vector<Section>& sections, uint64_t* content_hash,
+                    std::string* error) {
+  std::sort(sections.begin(), sections.end(), [](const Section& a, const Section& b) { return a.name < b.name; });
+  const uint64_t toc_offset = 64;
+  uint64_t offset = (toc_offset + sections.size() * 64 + piper::kPackSectionAlign - 1) / piper::kPackSectionAlign *
+                    piper::kPackSectionAlign;
+  std::string toc;
+  uint64_t hash = 1469598103934665603ull;
+  std::vector<uint64_t> offsets;
+  for (const Section& s : sections) {
+    if (s.name.size() >= 24) {
+      *error = "section name too long: " + s.name;
+      return false;
+    }
+    char name[24] = {};
+    std::memcpy(name, s.name.data(), s.name.size());
+    const uint64_t checksum = piper::packChecksum(s.bytes.data(), s.bytes.size());
+    appendRaw(toc, name, sizeof(name));
+    appendPod(toc, static_cast<uint32_t>(s.kind));
+    appendPod(toc, piper::kPackContainerVersion);
+    appendPod(toc, s.count);
+    appendPod(toc, s.param);
+    appendPod(toc, offset);
+    appendPod(toc, static_cast<uint64_t>(s.bytes.size()));
+    appendPod(toc, checksum);
+    hash = piper::packChecksum(name, sizeof(name), hash);
+    hash = piper::packChecksum(&checksum, sizeof(checksum), hash);
+    offsets.push_back(offset);
+    offset = (offset + s.bytes.size() + piper::kPackSectionAlign - 1) / piper::kPackSectionAlign *
+             piper::kPackSectionAlign;
+  }
+  const uint64_t file_size = sections.empty() ? toc_offset : offsets.back() + sections.back().bytes.size();
+
+  std::string header("PIPERPC1", 8);
+  appendPod(header, piper::kPackContainerVersion);
+  appendPod(header, static_cast<uint32_t>(sections.size()));
+  appendPod(header, toc_offset);
+  appendPod(header, file_size);
+  appendPod(header, hash);
+  padTo(header, 64);
+
+  const std::string tmp = path + ".tmp";
+  std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    *error = "cannot write " + tmp;
+    return false;
+  }
+  std::string head = header + toc;
+  out.write(head.data(), static_cast<std::streamsize>(head.size()));
+  uint64_t pos = head.size();
+  for (size_t i = 0; i < sections.size(); ++i) {
+    const std::string pad(static_cast<size_t>(offsets[i] - pos), '\0');
+    out.write(pad.data(), static_cast<std::streamsize>(pad.size()));
+    out.write(sections[i].bytes.data(), static_cast<std::streamsize>(sections[i].bytes.size()));
+    pos = offsets[i] + sections[i].bytes.size();
+  }
+  out.close();
+  if (!out || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    *error = "cannot write " + path;
+    return false;
+  }
+  *content_hash = hash;
+  return true;
+}
+
+// Reopens the written file with the runtime reader and checks every section, table index and trie key.
+std::string verifyContainer(const std::string& path, const std::vector<Section>& sections,
+                            const std::vector<CardRow>& cards) {
+  piper::PackContainer pack;
+  std::string error;
+  if (!pack.open(path, true, &error)) return error;
+  if (pack.sections().size() != sections.size()) return "section count mismatch";
+  for (const piper::PackSection& section : pack.sections()) {
+    if (section.kind != piper::PackSectionKind::kTable) continue;
+    piper::PackTable table;
+    if (!table.open(section, &error)) return error;
+    std::vector<uint32_t> found;
+    for (uint32_t c = 0; c < table.columns(); ++c) {
+      if (!table.indexed(c)) continue;
+      for (uint32_t row = 0; row < table.rows(); ++row) {
+        if (table.isNull(c, row)) continue;
+        found.clear();
+        if (table.type(c) == piper::PackColumnType::kText) table.findText(c, table.textAt(c, row), false, SIZE_MAX, found);
+        else if (table.type(c) == piper::PackColumnType::kInt) table.findInt(c, table.intAt(c, row), SIZE_MAX, found);
+        else continue;
+        if (std::find(found.begin(), found.end(), row) == found.end())
+          return section.name + ": index lookup failed for " + table.columnName(c);
+      }
+    }
+  }
+  const piper::PackSection* trie = pack.find("cards.name_trie");
+  if (!trie) return std::string();
+  uint64_t nodes_off, values_off;
+  std::memcpy(&nodes_off, trie->data + 8, 8);
+  std::memcpy(&values_off, trie->data + 16, 8);
+  const auto* nodes = reinterpret_cast<const piper::PackTrieNode*>(trie->data + nodes_off);
+  const piper::PackStringTable values(trie->data + values_off, trie->size - values_off, trie->count);
+  if (!values.valid()) return "trie value table invalid";
+  for (const CardRow& c : cards) {
+    if (c.name_norm.empty()) continue;
+    uint32_t node = 0;
+    for (unsigned char ch : c.name_norm) {
+      const piper::PackTrieNode& n = nodes[node];
+      const piper::PackTrieNode* lo = nodes + n.first_child;
+      const piper::PackTrieNode* hi = lo + n.child_count;
+      const piper::PackTrieNode* it =
+          std::lower_bound(lo, hi, ch, [](const piper::PackTrieNode& x, unsigned char v) { return x.label < v; });
+      if (it == hi || it->label != ch) return "trie lookup failed for " + c.name_norm;
+      node = static_cast<uint32_t>(it - nodes);
+    }
+    if (nodes[node].value == piper::kPackTrieNoValue || values.get(nodes[node].value).empty())
+      return "trie has no value for " + c.name_norm;
+  }
+  return std::string();
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: pack_compile --pack <content_pack dir> [--out <pack.bin>] [--threads N] [--json <report.json>]\n"
+               "                    [--espeak-data <dir> [--voice en-us]] [--phoneme-min-count N] [--sq8]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string pack, out_path, json_out, espeak_data, voice = "en-us";
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t phoneme_min_count = 3;
+  bool sq8 = false;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--pack") pack = next();
+    else if (arg == "--out") out_path = next();
+    else if (arg == "--threads") threads = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--json") json_out = next();
+    else if (arg == "--espeak-data") espeak_data = next();
+    else if (arg == "--voice") voice = next();
+    else if (arg == "--phoneme-min-count") phoneme_min_count = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--sq8") sq8 = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (pack.empty()) {
+    usage();
+    return 2;
+  }
+  if (out_path.empty()) out_path = pack + "/pack.bin";
+  const auto t_start = std::chrono::steady_clock::now();
+  Timings timings;
+
+  // Read every source once, in parallel.
+  std::vector<SourceData> sources;
+  for (const char* name : kSources) {
+    sources.emplace_back();
+    sources.back().name = name;
+  }
+  std::vector<std::string> rules_text;
+  std::vector<CardRow> cards;
+  TableData rules_table, cards_table;
+  bool has_rules_db = false, has_cards_db = false;
+  std::vector<std::pair<std::string, std::function<std::string()>>> load;
+  for (SourceData& src : sources) {
+    load.push_back({"read " + src.name + " chunks/vectors", [&pack, &src]() { return loadSource(pack, src); }});
+  }
+  load.push_back({"read rules.db", [&]() {
+                    const std::string path = pack + "/rules/rules.db";
+                    if (!fileExists(path)) return std::string();
+                    has_rules_db = true;
+                    return queryDb(path, "SELECT * FROM rules ORDER BY rule_id",
+                                   [&](sqlite3_stmt* st, const std::map<std::string, int>& cols) {
+                                     rules_text.push_back(columnText(st, cols, "text"));
+                                     appendTableRow(st, rules_table);
+                                   });
+                  }});
+  load.push_back({"read cards.db", [&]() {
+                    const std::string path = pack + "/cards/cards.db";
+                    if (!fileExists(path)) return std::string();
+                    has_cards_db = true;
+                    return queryDb(path, "SELECT * FROM cards",
+                                   [&](sqlite3_stmt* st, const std::map<std::string, int>& cols) {
+                                     cards.push_back({columnText(st, cols, "name_norm"),
+                                                      columnText(st, cols, "oracle_id"),
+                                                      columnText(st, cols, "name")});
+                                     appendTableRow(st, cards_table);
+                                   });
+                  }});
+  std::string err = runParallel(load, threads, timings);
+  if (!err.empty()) {
+    std::fprintf(stderr, "pack_compile: %s\n", err.c_str());
+    return 1;
+  }
+
+  // Phoneme vocabulary: every card-name word plus rules.db words seen at least phoneme_min_count times.
+  std::vector<std::string> vocab;
+  if (!espeak_data.empty()) {
+    std::set<std::string> words;
+    for (const CardRow& c : cards) forEachToken(c.name.empty() ? c.name_norm : c.name, [&](const std::string& t) {
+        words.insert(t);
+      });
+    std::unordered_map<std::string, size_t> freq;
+    for (const std::string& text : rules_text) forEachToken(text, [&](const std::string& t) { ++freq[t]; });
+    for (const auto& kv : freq) {
+      if (kv.second >= phoneme_min_count) words.insert(kv.first);
+    }
+    vocab.assign(words.begin(), words.end());
+  }
+
+  // Build every artifact in parallel.
+  std::mutex sections_mu;
+  std::vector<Section> sections;
+  auto emit = [&](Section s) {
+    std::lock_guard<std::mutex> lock(sections_mu);
+    sections.push_back(std::move(s));
+  };
+  size_t duplicate_names = 0;
+  std::vector<std::pair<std::string, std::function<std::string()>>> build;
+  for (const SourceData& src : sources) {
+    const SourceData* p = &src;
+    if (!src.vectors.empty()) {
+      build.push_back({"build " + src.name + ".vectors", [p, &emit]() {
+                         const uint32_t rows = static_cast<uint32_t>(p->vectors.size() / (size_t(p->dim) * 2));
+                         if (p->has_chunks && rows != p->chunks.size())
+                           return "vectors.f16 has " + std::to_string(rows) + " rows, chunks.jsonl " +
+                                  std::to_string(p->chunks.size());
+                         emit(Section{p->name + ".vectors", piper::PackSectionKind::kVectors, rows, p->dim, p->vectors});
+                         return std::string();
+                       }});
+      if (sq8) {
+        build.push_back({"build " + src.name + "/vectors.sq8", [p, &pack]() {
+                           const size_t rows = p->vectors.size() / (size_t(p->dim) * 2);
+                           std::string e;
+                           piper::sq8WriteFile(pack + "/" + p->name + "/vectors.sq8",
+                                               reinterpret_cast<const uint16_t*>(p->vectors.data()), rows, p->dim, &e);
+                           return e.empty() ? e : p->name + "/vectors.sq8: " + e;
+                         }});
+      }
+    }
+    if (src.has_chunks) {
+      build.push_back({"build " + src.name + ".chunks", [p, &emit]() {
+                         emit(buildChunks(*p));
+                         return std::string();
+                       }});
+      build.push_back({"build " + src.name + ".postings", [p, &emit]() {
+                         Section s;
+                         std::string e = buildPostings(*p, s);
+                         if (e.empty()) emit(std::move(s));
+                         return e;
+                       }});
+    }
+  }
+  if (has_rules_db) {
+    build.push_back({"build rules.table", [&]() {
+                       emit(buildTable("rules", rules_table, {"rule_id", "section"}));
+                       return std::string();
+                     }});
+  }
+  if (has_cards_db) {
+    build.push_back({"build cards.table", [&]() {
+                       emit(buildTable("cards", cards_table, {"oracle_id", "name_norm"}));
+                       return std::string();
+                     }});
+    build.push_back({"build cards.name_trie", [&]() {
+                       emit(buildNameTrie(cards, &duplicate_names));
+                       return std::string();
+                     }});
+  }
+  if (!vocab.empty()) {
+    build.push_back({"build phonemes", [&]() {
+                       std::vector<std::string> ipa;
+                       std::string e = phonemizeWords(espeak_data, voice, vocab, ipa);
+                       if (e.empty()) emit(buildPhonemes(vocab, ipa));
+                       return e;
+                     }});
+  }
+  err = runParallel(build, threads, timings);
+  if (!err.empty()) {
+    std::fprintf(stderr, "pack_compile: %s\n", err.c_str());
+    return 1;
+  }
+  if (sections.empty()) {
+    std::fprintf(stderr, "pack_compile: no sources found under %s\n", pack.c_str());
+    return 1;
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+  uint64_t content_hash = 0;
+  if (!writeContainer(out_path, sections, &content_hash, &err)) {
+    std::fprintf(stderr, "pack_compile: %s\n", err.c_str());
+    return 1;
+  }
+  timings.add("write", msSince(t0));
+  t0 = std::chrono::steady_clock::now();
+  err = verifyContainer(out_path, sections, cards);
+  if (!err.empty()) {
+    std::fprintf(stderr, "pack_compile: written pack invalid: %s\n", err.c_str());
+    return 1;
+  }
+  timings.add("verify", msSince(t0));
+  const double total_ms = msSince(t_start);
+
+  uint64_t bytes = 0;
+  for (const Section& s : sections) {
+    std::printf("  %-20s %10u x %-6u %12zu bytes\n", s.name.c_str(), s.count, s.param, s.bytes.size());
+    bytes += s.bytes.size();
+  }
+  for (const Timing& t : timings.sorted()) std::printf("  %-32s %9.1f ms\n", t.step.c_str(), t.ms);
+  std::printf("sections %zu  %llu bytes  hash %016llx  threads %zu  total %.1f ms -> %s\n", sections.size(),
+              static_cast<unsigned long long>(bytes), static_cast<unsigned long long>(content_hash), threads, total_ms,
+              out_path.c_str());
+  if (duplicate_names > 0) std::printf("  cards.name_trie: %zu duplicate name_norm rows kept once\n", duplicate_names);
+  if (!espeak_data.empty() && vocab.empty()) std::printf("  phonemes: empty vocabulary, section skipped\n");
+  if (espeak_data.empty()) std::printf("  phonemes: skipped (no --espeak-data)\n");
+
+  if (!json_out.empty()) {
+    json report = {{"out", out_path},
+                   {"content_hash", [&]() {
+                      char hex[17];
+                      std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(content_hash));
+                      return std::string(hex);
+                    }()},
+                   {"threads", threads},
+                   {"total_ms", total_ms},
+                   {"sections", json::array()},
+                   {"timings", json::array()}};
+    for (const Section& s : sections)
+      report["sections"].push_back({{"name", s.name}, {"count", s.count}, {"param", s.param}, {"bytes", s.bytes.size()}});
+    for (const Timing& t : timings.sorted()) report["timings"].push_back({{"step", t.step}, {"ms", t.ms}});
+    std::ofstream(json_out) << report.dump(2) << "\n";
+  }
+  return 0;
+}
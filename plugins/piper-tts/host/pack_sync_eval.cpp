@@ -0,0 +1,228 @@
+// Incremental content-pack sync (../ios/cpp/pack_sync.h) on Linux: copies a pack directory that has a
+// pack_files.json into a destination the way the app does on first launch and after an update, and a self-test.
+//
+//   pack_sync_eval (--src <pack dir> --dest <dir> | --selftest) [--threads 0] [--buffer-kb 1024]
+//
+// --selftest syncs generated files in a temp directory: a fresh copy, an unchanged re-sync (state records
+// only), a legacy copy without state (verified by hash), an interrupted .partial (resumed), a .partial left by
+// an older manifest (restarted), a manifest hash the source does not match (fails, no partial kept, previous
+// manifest kept) and a file dropped from the manifest (removed); exits non-zero on any failure.
+
+#include "json.hpp"
+#include "pack_sync.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool ok, const char* what, double value, const char* unit) {
+  std::printf("  %-52s %10.2f %-4s %s\n", what, value, unit, ok ? "ok" : "FAIL");
+  if (!ok) g_failures++;
+}
+
+bool writeFile(const std::string& path, const std::string& data) {
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  const bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+  return std::fclose(f) == 0 && ok;
+}
+
+bool readFile(const std::string& path, std::string& out) {
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return false;
+  char buf[65536];
+  size_t n;
+  out.clear();
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  std::fclose(f);
+  return true;
+}
+
+bool exists(const std::string& path) { return access(path.c_str(), F_OK) == 0; }
+
+std::string randomBytes(size_t n, std::mt19937& rng) {
+  std::string s(n, '\0');
+  for (char& c : s) c = static_cast<char>(rng() & 0xff);
+  return s;
+}
+
+std::string hex16(const std::string& data) {
+  piper::Blake2b h;
+  h.update(data.data(), data.size());
+  return h.hex16();
+}
+
+// Source tree: writes every file and a pack_files.json listing them (bad_hash_path gets a hash it cannot match).
+struct SourcePack {
+  std::string root;
+  std::vector<std::pair<std::string, std::string>> files;  // path, contents
+  std::string bad_hash_path;
+
+  bool write() const {
+    nlohmann::json doc = {{"version", 1}, {"hash", "blake2b-512/128"}, {"files", nlohmann::json::array()}};
+    for (const auto& f : files) {
+      if (!writeFile(root + "/" + f.first, f.second)) return false;
+      const std::string hash = f.first == bad_hash_path ? std::string(32, '0') : hex16(f.second);
+      doc["files"].push_back({{"path", f.first}, {"size", f.second.size()}, {"hash", hash}});
+    }
+    return writeFile(root + "/" + piper::kPackFilesManifest, doc.dump(2));
+  }
+};
+
+bool sameAsSource(const SourcePack& src, const std::string& dest) {
+  for (const auto& f : src.files) {
+    std::string got;
+    if (!readFile(dest + "/" + f.first, got) || got != f.second) return false;
+  }
+  return true;
+}
+
+bool runSync(const SourcePack& src, const std::string& dest, piper::PackSyncReport& r, piper::PackSyncError* err) {
+  std::unique_ptr<piper::PackSyncSource> source = piper::directoryPackSource(src.root);
+  piper::PackSyncOptions options;
+  options.threads = 2;
+  options.buffer_bytes = 4096;  // several reads per file, so a resume lands mid-stream
+  return piper::syncPack(*source, dest, options, &r, err);
+}
+
+int selftest() {
+  char tmpl[] = "/tmp/pack_sync_selftest_XXXXXX";
+  if (!mkdtemp(tmpl)) {
+    std::fprintf(stderr, "pack_sync_eval: cannot create a temp directory\n");
+    return 1;
+  }
+  const std::string dir = tmpl;
+  const std::string dest = dir + "/dest";
+  std::mt19937 rng(5);
+  SourcePack src;
+  src.root = dir + "/src";
+  src.files = {{"voice.onnx", randomBytes(150000, rng)},
+               {"rules.table", randomBytes(40000, rng)},
+               {"chunks.jsonl", randomBytes(9000, rng)},
+               {"intros.bin", randomBytes(3000, rng)}};
+  const bool written = mkdir(src.root.c_str(), 0755) == 0 && src.write();
+  check(written, "source pack written", static_cast<double>(src.files.size()), "file");
+
+  piper::PackSyncReport r;
+  piper::PackSyncError err = piper::PackSyncError::kNone;
+  bool ok = runSync(src, dest, r, &err);
+  check(ok && r.copied == 4 && sameAsSource(src, dest), "fresh: every file copied", static_cast<double>(r.copied),
+        "file");
+
+  ok = runSync(src, dest, r, &err);
+  check(ok && r.skipped == 4 && r.bytes_copied == 0 && r.bytes_hashed == 0, "re-sync: skipped on state records",
+        static_cast<double>(r.skipped), "file");
+
+  // A legacy full copy has no state file: files are hashed, not copied.
+  std::remove((dest + "/.pack_sync_state").c_str());
+  ok = runSync(src, dest, r, &err);
+  check(ok && r.verified == 4 && r.bytes_copied == 0, "no state: verified by hash", static_cast<double>(r.verified),
+        "file");
+
+  // Interrupted copy: the first 60000 bytes are in voice.onnx.partial.
+  const std::string& voice = src.files[0].second;
+  std::remove((dest + "/voice.onnx").c_str());
+  writeFile(dest + "/voice.onnx.partial", voice.substr(0, 60000));
+  ok = runSync(src, dest, r, &err);
+  check(ok && r.copied == 1 && r.resumed == 1 && r.bytes_copied == voice.size() - 60000 &&
+            !exists(dest + "/voice.onnx.partial") && sameAsSource(src, dest),
+        "interrupted partial: resumed (bytes copied)", static_cast<double>(r.bytes_copied), "B");
+
+  // The pack is updated (same size, new bytes) while a partial of the old rules.table is on disk.
+  const std::string old_rules = src.files[1].second;
+  src.files[1].second = randomBytes(old_rules.size(), rng);
+  src.write();
+  writeFile(dest + "/rules.table.partial", old_rules.substr(0, 20000));
+  ok = runSync(src, dest, r, &err);
+  check(ok && r.copied == 1 && r.resumed == 0 && r.bytes_copied == old_rules.size() + (old_rules.size() - 20000) &&
+            !exists(dest + "/rules.table.partial") && sameAsSource(src, dest),
+        "older-manifest partial: restarted (bytes copied)", static_cast<double>(r.bytes_copied), "B");
+
+  // A source file that does not match its manifest hash fails the sync; the completed manifest is kept.
+  std::string manifest_before;
+  readFile(dest + "/" + piper::kPackFilesManifest, manifest_before);
+  SourcePack bad = src;
+  bad.files[2].second = randomBytes(bad.files[2].second.size(), rng);
+  bad.bad_hash_path = "chunks.jsonl";
+  bad.write();
+  ok = runSync(bad, dest, r, &err);
+  std::string manifest_after;
+  readFile(dest + "/" + piper::kPackFilesManifest, manifest_after);
+  check(!ok && err == piper::PackSyncError::kHashMismatch && r.failed_path == "chunks.jsonl" &&
+            !exists(dest + "/chunks.jsonl.partial") && manifest_after == manifest_before,
+        "hash mismatch: fails, no partial, manifest kept", static_cast<double>(r.copied), "file");
+  src.write();
+  ok = runSync(src, dest, r, &err);
+  check(ok && sameAsSource(src, dest), "hash mismatch: installed copy left intact", static_cast<double>(r.skipped),
+        "file");
+
+  // intros.bin is dropped from the manifest: the next sync removes it.
+  src.files.pop_back();
+  src.write();
+  ok = runSync(src, dest, r, &err);
+  check(ok && r.removed == 1 && !exists(dest + "/intros.bin") && r.skipped == 3, "dropped file: removed",
+        static_cast<double>(r.removed), "file");
+
+  for (const char* name : {"voice.onnx", "rules.table", "chunks.jsonl", "intros.bin", piper::kPackFilesManifest,
+                           ".pack_sync_state"}) {
+    std::remove((src.root + "/" + name).c_str());
+    std::remove((dest + "/" + name).c_str());
+  }
+  rmdir(src.root.c_str());
+  rmdir(dest.c_str());
+  rmdir(dir.c_str());
+  std::printf("selftest: %s\n", g_failures ? "FAILED" : "all passed");
+  return g_failures ? 1 : 0;
+}
+
+void usage() {
+  std::fprintf(stderr, "usage: pack_sync_eval (--src <pack dir> --dest <dir> | --selftest) [--threads 0] "
+                       "[--buffer-kb 1024]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string src, dest;
+  bool run_selftest = false;
+  piper::PackSyncOptions options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--src") src = next();
+    else if (arg == "--dest") dest = next();
+    else if (arg == "--threads") options.threads = std::strtoul(next().c_str(), nullptr, 10);
+    else if (arg == "--buffer-kb") options.buffer_bytes = std::strtoul(next().c_str(), nullptr, 10) * 1024;
+    else if (arg == "--selftest") run_selftest = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (run_selftest) return selftest();
+  if (src.empty() || dest.empty()) {
+    usage();
+    return 2;
+  }
+
+  std::unique_ptr<piper::PackSyncSource> source = piper::directoryPackSource(src);
+  piper::PackSyncReport r;
+  piper::PackSyncError err = piper::PackSyncError::kNone;
+  if (!piper::syncPack(*source, dest, options, &r, &err)) {
+    std::fprintf(stderr, "pack_sync_eval: %s%s%s\n", piper::packSyncErrorString(err),
+                 r.failed_path.empty() ? "" : " at ", r.failed_path.c_str());
+    return 1;
+  }
+  std::printf("%zu files: %zu copied (%zu resumed), %zu verified, %zu skipped, %zu removed\n"
+              "%.1f MB copied, %.1f MB hashed in %.0f ms\n",
+              r.files, r.copied, r.resumed, r.verified, r.skipped, r.removed, r.bytes_copied / 1048576.0,
+              r.bytes_hashed / 1048576.0, r.elapsed_ms);
+  return 0;
+}
@@ -0,0 +1,434 @@
+// Word-level phoneme memo evaluation on Linux: phonemizes a text corpus (one utterance per line, e.g. logged
+// LLM answers) through PhonemeMemo on top of espeak-ng, and again with espeak on the whole line, and reports
+// the fraction of words served from the memo, the phonemize time saved and any line whose memo output differs
+// from espeak's.
+//
+//   phoneme_memo_eval --corpus answers.txt [--espeak-data <dir>] [--voice en-us] [--pack pack.bin]
+//                     [--capacity 4096] [--passes 1] [--json report.json] [--selftest]
+//
+// --pack seeds the memo from the pack.bin "phonemes" section (pack_compile --espeak-data). Lines are run in
+// order, so the memo only knows what earlier lines (and the seed) taught it, as on device.
+// --selftest runs the memo over a fake phonemizer with context effects (no espeak needed): assembled output
+// equals whole-text output, function-word context, conflict detection, LRU bound, ineligible-clause
+// batching and seeding from a hand-built pack.bin; exits non-zero on any failure.
+
+#include "pack_container.h"
+#include "phoneme_memo.h"
+#include "json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef PHONEME_MEMO_EVAL_USE_ESPEAK
+#include <espeak-ng/speak_lib.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+
+// ---- self-test -------------------------------------------------------------------------------------------
+
+int g_failures = 0;
+
+void check(bool ok, const char* what, double value) {
+  std::printf("  %-56s %10.3f %s\n", what, value, ok ? "ok" : "FAIL");
+  if (!ok) g_failures++;
+}
+
+bool isBoundary(const std::string& text, size_t i) {
+  return std::strchr(",.;:!?", text[i]) && (i + 1 == text.size() || text[i + 1] == ' ' || text[i + 1] == '\n');
+}
+
+// Stand-in for espeak: clause by clause, words joined by spaces. "the" is "ði" before a vowel and "ðə"
+// otherwise, "wow" gains a "!" at the end of a clause (a context effect the memo cannot predict), and a
+// digit run reads as "#<digits>".
+void fakePhonemizeClause(const std::string& clause, std::string& out) {
+  std::vector<std::string> words;
+  std::string w;
+  for (char c : clause) {
+    if (c == ' ' || c == '\n' || std::strchr(",.;:!?", c)) {
+      if (!w.empty()) words.push_back(w);
+      w.clear();
+    } else {
+      w += static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+  }
+  if (!w.empty()) words.push_back(w);
+  for (size_t k = 0; k < words.size(); ++k) {
+    if (k) out += ' ';
+    const std::string& word = words[k];
+    if (word == "the") {
+      const char next = k + 1 < words.size() ? words[k + 1][0] : 'x';
+      out += std::strchr("aeiou", next) ? "ði" : "ðə";
+    } else if (word == "wow") {
+      out += k + 1 == words.size() ? "wau!" : "wau";
+    } else if (word[0] >= '0' && word[0] <= '9') {
+      out += "#" + word;
+    } else {
+      out += "ˈ" + word;
+    }
+  }
+}
+
+size_t g_fake_calls = 0;
+
+void fakeEspeak(const char* text, std::string& out) {
+  ++g_fake_calls;
+  const std::string s(text);
+  size_t begin = 0;
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (s[i] == '\n' || isBoundary(s, i)) {
+      fakePhonemizeClause(s.substr(begin, i + 1 - begin), out);
+      begin = i + 1;
+    }
+  }
+  if (begin < s.size()) fakePhonemizeClause(s.substr(begin), out);
+}
+
+std::string viaMemo(piper::PhonemeMemo& memo, const std::string& text, const std::string& voice = "en-us") {
+  std::string out;
+  memo.phonemize(voice, text, fakeEspeak, out);
+  return out;
+}
+
+std::string whole(const std::string& text) {
+  std::string out;
+  fakeEspeak(text.c_str(), out);
+  return out;
+}
+
+template <typename T>
+void appendPod(std::string& out, const T& v) {
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+std::string stringTable(const std::vector<std::string>& strings) {
+  std::string out;
+  uint64_t off = 0;
+  appendPod(out, off);
+  for (const std::string& s : strings) appendPod(out, off += s.size());
+  for (const std::string& s : strings) out += s;
+  return out;
+}
+
+// Minimal pack.bin with one "phonemes" section, laid out as pack_compile writes it.
+bool writePhonemePack(const std::string& path, const std::vector<std::string>& words,
+                      const std::vector<std::string>& ipa) {
+  std::string section;
+  const std::string keys = stringTable(words);
+  const uint64_t keys_off = 24;
+  const uint64_t values_off = (keys_off + keys.size() + 7) / 8 * 8;
+  appendPod(section, static_cast<uint32_t>(words.size()));
+  appendPod(section, static_cast<uint32_t>(0));
+  appendPod(section, keys_off);
+  appendPod(section, values_off);
+  section += keys;
+  section.resize(values_off, '\0');
+  section += stringTable(ipa);
+
+  const uint64_t offset = piper::kPackSectionAlign;
+  std::string head("PIPERPC1", 8);
+  appendPod(head, piper::kPackContainerVersion);
+  appendPod(head, static_cast<uint32_t>(1));
+  appendPod(head, static_cast<uint64_t>(64));
+  appendPod(head, offset + section.size());
+  appendPod(head, static_cast<uint64_t>(0));
+  head.resize(64, '\0');
+  char name[24] = "phonemes";
+  head.append(name, sizeof(name));
+  appendPod(head, static_cast<uint32_t>(piper::PackSectionKind::kStringMap));
+  appendPod(head, piper::kPackContainerVersion);
+  appendPod(head, static_cast<uint32_t>(words.size()));
+  appendPod(head, static_cast<uint32_t>(0));
+  appendPod(head, offset);
+  appendPod(head, static_cast<uint64_t>(section.size()));
+  appendPod(head, piper::packChecksum(section.data(), section.size()));
+  head.resize(offset, '\0');
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out << head << section;
+  return static_cast<bool>(out);
+}
+
+int selftest() {
+  std::printf("assembly\n");
+  {
+    piper::PhonemeMemo memo;
+    const std::vector<std::string> corpus = {
+        "The orange cat sat on the mat.",
+        "The cat sat on the orange mat, and the dog sat too.",
+        "On the mat sat the cat.",
+        "It costs 5 coins, then 3 more; the cat paid.",
+        "Dr. Smith saw the cat. The dog saw the orange.",
+        "Don't let the dog near the cat!",
+        "Don't let the cat near the dog!",
+    };
+    bool same = true;
+    for (const std::string& line : corpus) {
+      const std::string a = viaMemo(memo, line), b = whole(line);
+      if (a != b) {
+        std::printf("  mismatch: %s\n    memo   %s\n    espeak %s\n", line.c_str(), a.c_str(), b.c_str());
+        same = false;
+      }
+    }
+    const piper::PhonemeMemoStats s = memo.stats();
+    check(same, "memo output == whole-text output (7 lines)", same ? 1.0 : 0.0);
+    check(s.memo_words > 0 && s.memo_clauses >= 2, "words served from memo", static_cast<double>(s.memo_words));
+    check(s.memoFraction() > 0.2, "memo fraction", s.memoFraction());
+    check(s.conflicts == 0, "conflicts", static_cast<double>(s.conflicts));
+  }
+
+  std::printf("context\n");
+  {
+    piper::PhonemeMemo memo;
+    viaMemo(memo, "The apple fell, the pear fell.");
+    const piper::PhonemeMemoStats before = memo.stats();
+    const std::string a = viaMemo(memo, "The pear fell, the apple fell.");
+    const piper::PhonemeMemoStats after = memo.stats();
+    const bool keyed = a == whole("The pear fell, the apple fell.");
+    check(keyed, "function word keyed by next word", keyed ? 1.0 : 0.0);
+    check(after.espeak_calls == before.espeak_calls, "both clauses assembled (espeak calls)",
+          static_cast<double>(after.espeak_calls - before.espeak_calls));
+
+    // "wow" is learned mid-clause, then seen clause-final in a clause with a new word: conflict.
+    viaMemo(memo, "Wow the pear.");
+    viaMemo(memo, "Such pear wow.");
+    check(memo.stats().conflicts == 1, "conflict detected", static_cast<double>(memo.stats().conflicts));
+    const size_t calls = g_fake_calls;
+    const std::string b = viaMemo(memo, "The pear wow.");
+    check(b == whole("The pear wow.") && g_fake_calls > calls + 1, "context-dependent word goes to espeak", 1.0);
+
+    // Numbers, all-caps and heteronyms never come from the memo.
+    viaMemo(memo, "The apple fell.");
+    const uint64_t memo_words = memo.stats().memo_words;
+    viaMemo(memo, "The apple fell 3 times.");
+    viaMemo(memo, "The NASA apple fell.");
+    viaMemo(memo, "The apple read fell.");
+    check(memo.stats().memo_words == memo_words, "numbers / all-caps / heteronyms bypass",
+          static_cast<double>(memo.stats().memo_words - memo_words));
+  }
+
+  std::printf("batching and capacity\n");
+  {
+    piper::PhonemeMemo memo;
+    size_t calls = g_fake_calls;
+    viaMemo(memo, "Take 2, then 3; done 4.");
+    check(g_fake_calls - calls == 1, "consecutive ineligible clauses: one espeak call",
+          static_cast<double>(g_fake_calls - calls));
+
+    memo.setCapacity(8);
+    for (int i = 0; i < 6; ++i) {
+      std::string line;
+      for (int k = 0; k < 4; ++k) line += std::string(k ? " " : "") + "w" + static_cast<char>('a' + i) +
+                                          static_cast<char>('a' + k);
+      viaMemo(memo, line + ".");
+    }
+    const piper::PhonemeMemoStats s = memo.stats();
+    check(s.entries <= 8, "LRU entries (capacity 8)", static_cast<double>(s.entries));
+    check(s.evictions >= 16, "evictions", static_cast<double>(s.evictions));
+
+    memo.setCapacity(0);
+    calls = g_fake_calls;
+    const std::string text = "The cat sat. The cat sat.";
+    const std::string a = viaMemo(memo, text);
+    const size_t memo_calls = g_fake_calls - calls;
+    check(a == whole(text) && memo_calls == 1, "capacity 0: whole text to espeak", static_cast<double>(memo_calls));
+  }
+
+  std::printf("seed\n");
+  {
+    const std::string path = "/tmp/phoneme_memo_selftest.pack.bin";
+    // Sorted keys, as pack_compile writes them.
+    const bool wrote = writePhonemePack(path, {"amber", "cat", "golem", "mat"},
+                                        {"ˈamber", "ˈcat", "ˈgolem", "ˈmat"});
+    piper::PhonemeMemo memo;
+    std::string err;
+    const bool ok = wrote && memo.setSeed(path, "en-us", &err);
+    check(ok, "seed from pack.bin phonemes section", ok ? 1.0 : 0.0);
+    if (!ok) std::printf("  error: %s\n", err.c_str());
+    check(memo.stats().seed_entries == 4, "seed entries", static_cast<double>(memo.stats().seed_entries));
+    size_t calls = g_fake_calls;
+    const std::string a = viaMemo(memo, "Amber golem cat.");
+    const size_t seeded_calls = g_fake_calls - calls;
+    check(a == whole("Amber golem cat.") && seeded_calls == 0, "unseen sentence served from seed",
+          static_cast<double>(seeded_calls));
+    check(memo.stats().seed_words == 3, "seed words", static_cast<double>(memo.stats().seed_words));
+    calls = g_fake_calls;
+    viaMemo(memo, "The amber cat.");  // "the" is a function word: never seeded
+    check(g_fake_calls == calls + 1, "function word not taken from seed", static_cast<double>(g_fake_calls - calls));
+    calls = g_fake_calls;
+    viaMemo(memo, "Amber golem mat.", "de");
+    check(g_fake_calls == calls + 1, "seed ignored for another voice", static_cast<double>(g_fake_calls - calls));
+    std::remove(path.c_str());
+  }
+
+  std::printf(g_failures ? "selftest: %d FAILED\n" : "selftest: all passed\n", g_failures);
+  return g_failures ? 1 : 0;
+}
+
+// ---- corpus evaluation -----------------------------------------------------------------------------------
+
+#ifdef PHONEME_MEMO_EVAL_USE_ESPEAK
+double msSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Same espeak loop as the engine's espeak_phonemize (IPA, clause by clause).
+void espeakPhonemize(const char* text, std::string& out) {
+  const char* input = text;
+  while (input && *input) {
+    int terminator = 0;
+    const char* phonemes = espeak_TextToPhonemesWithTerminator(reinterpret_cast<const void**>(&input),
+                                                               espeakCHARS_AUTO, 0x02, &terminator);
+    if (phonemes) out += phonemes;
+  }
+}
+#endif
+
+int evaluate(const std::string& corpus, const std::string& espeak_data, const std::string& voice,
+             const std::string& pack, size_t capacity, int passes, const std::string& json_out) {
+#ifdef PHONEME_MEMO_EVAL_USE_ESPEAK
+  std::vector<std::string> lines;
+  {
+    std::ifstream in(corpus);
+    if (!in) {
+      std::fprintf(stderr, "phoneme_memo_eval: cannot read %s\n", corpus.c_str());
+      return 1;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty()) lines.push_back(line);
+    }
+  }
+  if (espeak_Initialize(AUDIO_OUTPUT_SYNCHRONOUS, 0, espeak_data.empty() ? nullptr : espeak_data.c_str(), 0) < 0 ||
+      espeak_SetVoiceByName(voice.c_str()) != 0) {
+    std::fprintf(stderr, "phoneme_memo_eval: espeak init / voice %s failed\n", voice.c_str());
+    return 1;
+  }
+
+  piper::PhonemeMemo memo(capacity);
+  if (!pack.empty()) {
+    std::string err;
+    if (!memo.setSeed(pack, voice, &err)) {
+      std::fprintf(stderr, "phoneme_memo_eval: seed %s: %s\n", pack.c_str(), err.c_str());
+      return 1;
+    }
+  }
+
+  double baseline_ms = 0.0, memo_ms = 0.0;
+  size_t mismatches = 0;
+  json examples = json::array();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (const std::string& line : lines) {
+      std::string expect, got;
+      auto t0 = std::chrono::steady_clock::now();
+      espeakPhonemize(line.c_str(), expect);
+      baseline_ms += msSince(t0);
+      t0 = std::chrono::steady_clock::now();
+      memo.phonemize(voice, line, espeakPhonemize, got);
+      memo_ms += msSince(t0);
+      if (got != expect) {
+        ++mismatches;
+        if (examples.size() < 10) examples.push_back({{"text", line}, {"memo", got}, {"espeak", expect}});
+      }
+    }
+  }
+  espeak_Terminate();
+
+  const piper::PhonemeMemoStats s = memo.stats();
+  std::printf("%zu line(s) x %d pass(es), %llu words, %llu clauses\n", lines.size(), passes,
+              static_cast<unsigned long long>(s.words), static_cast<unsigned long long>(s.clauses));
+  std::printf("memo words   %6.1f%% (seed %llu), clauses %llu/%llu, espeak calls %llu\n", 100.0 * s.memoFraction(),
+              static_cast<unsigned long long>(s.seed_words), static_cast<unsigned long long>(s.memo_clauses),
+              static_cast<unsigned long long>(s.clauses), static_cast<unsigned long long>(s.espeak_calls));
+  std::printf("phonemize    %8.2f ms whole-text espeak, %8.2f ms via memo: saved %.2f ms (%.1f%%), estimated %.2f ms\n",
+              baseline_ms, memo_ms, baseline_ms - memo_ms,
+              baseline_ms > 0.0 ? 100.0 * (baseline_ms - memo_ms) / baseline_ms : 0.0, s.savedUs() / 1000.0);
+  std::printf("entries %zu/%zu, learned %llu, conflicts %llu, evictions %llu; mismatched lines %zu\n", s.entries,
+              s.capacity, static_cast<unsigned long long>(s.learned), static_cast<unsigned long long>(s.conflicts),
+              static_cast<unsigned long long>(s.evictions), mismatches);
+  for (const json& e : examples) {
+    std::printf("  mismatch: %s\n    memo   %s\n    espeak %s\n", e["text"].get<std::string>().c_str(),
+                e["memo"].get<std::string>().c_str(), e["espeak"].get<std::string>().c_str());
+  }
+
+  if (!json_out.empty()) {
+    json report = {{"lines", lines.size()},
+                   {"passes", passes},
+                   {"voice", voice},
+                   {"capacity", s.capacity},
+                   {"words", s.words},
+                   {"memo_words", s.memo_words},
+                   {"seed_words", s.seed_words},
+                   {"memo_fraction", s.memoFraction()},
+                   {"clauses", s.clauses},
+                   {"memo_clauses", s.memo_clauses},
+                   {"espeak_calls", s.espeak_calls},
+                   {"baseline_ms", baseline_ms},
+                   {"memo_ms", memo_ms},
+                   {"saved_ms", baseline_ms - memo_ms},
+                   {"estimated_saved_ms", s.savedUs() / 1000.0},
+                   {"learned", s.learned},
+                   {"conflicts", s.conflicts},
+                   {"evictions", s.evictions},
+                   {"entries", s.entries},
+                   {"seed_entries", s.seed_entries},
+                   {"mismatched_lines", mismatches},
+                   {"mismatch_examples", examples}};
+    std::ofstream(json_out) << report.dump(2) << "\n";
+  }
+  return 0;
+#else
+  (void)corpus;
+  (void)espeak_data;
+  (void)voice;
+  (void)pack;
+  (void)capacity;
+  (void)passes;
+  (void)json_out;
+  std::fprintf(stderr, "phoneme_memo_eval: built without espeak-ng; only --selftest is available\n");
+  return 1;
+#endif
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: phoneme_memo_eval (--corpus <txt> | --selftest) [--espeak-data <dir>] [--voice en-us]\n"
+               "                         [--pack pack.bin] [--capacity 4096] [--passes 1] [--json <report.json>]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string corpus, espeak_data, voice = "en-us", pack, json_out;
+  size_t capacity = 4096;
+  int passes = 1;
+  bool run_selftest = false;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--corpus") corpus = next();
+    else if (arg == "--espeak-data") espeak_data = next();
+    else if (arg == "--voice") voice = next();
+    else if (arg == "--pack") pack = next();
+    else if (arg == "--capacity") capacity = static_cast<size_t>(std::max(0L, std::atol(next().c_str())));
+    else if (arg == "--passes") passes = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--json") json_out = next();
+    else if (arg == "--selftest") run_selftest = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (run_selftest) return selftest();
+  if (corpus.empty()) {
+    usage();
+    return 2;
+  }
+  return evaluate(corpus, espeak_data, voice, pack, capacity, passes, json_out);
+}
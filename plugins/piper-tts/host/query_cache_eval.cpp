@@ -0,0 +1,170 @@
+// Semantic query cache (../ios/cpp/semantic_query_cache.h) on Linux: a self-test of what the RAG path relies
+// on, and probe cost at the app's capacities.
+//
+//   query_cache_eval (--selftest | --bench) [--dim 384] [--capacity 64]
+//
+// --selftest checks the cosine threshold (unnormalized queries, best match among several), near-duplicate
+// refresh, invalidation when the version key (pack content / embed model) or dim changes, LRU eviction at the
+// size cap and on a capacity shrink, and the probe / hit / insert / saved_ms counters; exits non-zero on any
+// failure. --bench times a missing probe against a full cache.
+
+#include "semantic_query_cache.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool ok, const char* what, double value, const char* unit) {
+  std::printf("  %-52s %10.2f %-4s %s\n", what, value, unit, ok ? "ok" : "FAIL");
+  if (!ok) g_failures++;
+}
+
+// Unit vector along axis a, rotated towards axis b so its cosine with axis a is cos_a; scaled by `scale`.
+std::vector<float> axisVector(size_t dim, size_t a, size_t b, float cos_a, float scale = 1.f) {
+  std::vector<float> v(dim, 0.f);
+  v[a] = scale * cos_a;
+  v[b] = scale * std::sqrt(1.f - cos_a * cos_a);
+  return v;
+}
+
+int selftest() {
+  const size_t dim = 52;  // not a multiple of 8: exercises the dot product's tails
+  const std::string key = "pack-v3|content-a|embed-small";
+  piper::SemanticQueryCache cache;
+  piper::QueryCacheConfig config;
+  config.min_cosine = 0.95f;
+  config.capacity = 4;
+  cache.configure(config);
+  piper::QueryCacheHit hit;
+
+  std::printf("threshold (min_cosine %.2f)\n", config.min_cosine);
+  cache.insert(key, axisVector(dim, 0, 1, 1.f).data(), dim, "rules:trample", 40.0);
+  const bool near = cache.probe(key, axisVector(dim, 0, 1, 0.96f, 7.f).data(), dim, &hit);
+  check(near && hit.payload == "rules:trample" && std::fabs(hit.cosine - 0.96f) < 1e-4f,
+        "cos 0.96 (unnormalized x7) hits", hit.cosine, "cos");
+  check(!cache.probe(key, axisVector(dim, 0, 1, 0.94f).data(), dim, &hit), "cos 0.94 misses", 0.94, "cos");
+  // 0.94 from the first entry, so stored separately; a probe between them is within the threshold of both.
+  cache.insert(key, axisVector(dim, 0, 2, 0.94f).data(), dim, "rules:deathtouch", 30.0);
+  const bool best = cache.probe(key, axisVector(dim, 0, 2, std::cos(0.25f)).data(), dim, &hit);
+  check(best && hit.payload == "rules:deathtouch" && hit.cosine > 0.99f, "best of two matches served", hit.cosine,
+        "cos");
+  const std::vector<float> zero(dim, 0.f);
+  check(!cache.probe(key, zero.data(), dim, &hit), "zero vector never hits", 0, "");
+  // Above the threshold of an entry: refreshed in place, not duplicated.
+  cache.insert(key, axisVector(dim, 0, 1, 0.99f).data(), dim, "rules:trample-v2", 50.0);
+  const bool refreshed = cache.probe(key, axisVector(dim, 0, 1, 0.99f).data(), dim, &hit);
+  check(refreshed && hit.payload == "rules:trample-v2" && cache.stats().entries == 2,
+        "near-duplicate insert refreshes the entry", static_cast<double>(cache.stats().entries), "ents");
+
+  std::printf("counters\n");
+  piper::QueryCacheStats s = cache.stats();
+  check(s.probes == 4 && s.hits == 3 && s.inserts == 3, "probes / hits / inserts (zero vector not counted)",
+        static_cast<double>(s.hits) / s.probes, "rate");
+  check(std::fabs(s.saved_ms - (40.0 + 30.0 + 50.0)) < 1e-9, "saved_ms credits the entry that served each hit",
+        s.saved_ms, "ms");
+  cache.resetStats();
+  s = cache.stats();
+  check(s.probes == 0 && s.hits == 0 && s.saved_ms == 0.0 && s.entries == 2, "resetStats keeps the entries",
+        static_cast<double>(s.entries), "ents");
+
+  std::printf("invalidation\n");
+  const std::string new_content = "pack-v3|content-b|embed-small";
+  const bool stale = cache.probe(new_content, axisVector(dim, 0, 1, 1.f).data(), dim, &hit);
+  s = cache.stats();
+  check(!stale && s.entries == 0 && s.invalidations == 1, "pack content change drops every entry",
+        static_cast<double>(s.invalidations), "");
+  cache.insert(new_content, axisVector(dim, 3, 4, 1.f).data(), dim, "cards:llanowar", 20.0);
+  const bool other_dim = cache.probe(new_content, axisVector(dim + 16, 3, 4, 1.f).data(), dim + 16, &hit);
+  s = cache.stats();
+  check(!other_dim && s.entries == 0 && s.invalidations == 2, "embed dim change drops every entry",
+        static_cast<double>(s.invalidations), "");
+  const bool old_key = cache.probe(key, axisVector(dim, 0, 1, 1.f).data(), dim, &hit);
+  check(!old_key, "old content key does not resurrect entries", static_cast<double>(cache.stats().entries), "ents");
+
+  std::printf("size cap (capacity %zu)\n", config.capacity);
+  cache.clear();
+  cache.resetStats();
+  for (size_t i = 0; i < config.capacity; ++i) {
+    cache.insert(key, axisVector(dim, i, i + 1, 1.f).data(), dim, "q" + std::to_string(i), 1.0);
+  }
+  cache.probe(key, axisVector(dim, 0, 1, 1.f).data(), dim, &hit);  // q0 becomes most recent; q1 is now LRU
+  cache.insert(key, axisVector(dim, 10, 11, 1.f).data(), dim, "q10", 1.0);
+  s = cache.stats();
+  const bool kept_q0 = cache.probe(key, axisVector(dim, 0, 1, 1.f).data(), dim, &hit) && hit.payload == "q0";
+  const bool lost_q1 = !cache.probe(key, axisVector(dim, 1, 2, 1.f).data(), dim, &hit);
+  const bool kept_q10 = cache.probe(key, axisVector(dim, 10, 11, 1.f).data(), dim, &hit) && hit.payload == "q10";
+  check(s.entries == config.capacity && s.evictions == 1 && kept_q0 && lost_q1 && kept_q10,
+        "insert past the cap evicts the least recently used", static_cast<double>(s.evictions), "");
+  config.capacity = 2;
+  cache.configure(config);
+  s = cache.stats();
+  const bool shrink_kept = cache.probe(key, axisVector(dim, 10, 11, 1.f).data(), dim, &hit) &&
+                           cache.probe(key, axisVector(dim, 0, 1, 1.f).data(), dim, &hit);
+  check(s.entries == 2 && s.evictions == 3 && shrink_kept, "capacity shrink keeps the two most recent",
+        static_cast<double>(s.entries), "ents");
+  config.capacity = 0;
+  cache.configure(config);
+  cache.insert(key, axisVector(dim, 20, 21, 1.f).data(), dim, "q20", 1.0);
+  check(cache.stats().entries == 0, "capacity 0 stores nothing", static_cast<double>(cache.stats().entries), "ents");
+
+  std::printf("selftest: %s\n", g_failures ? "FAILED" : "all passed");
+  return g_failures ? 1 : 0;
+}
+
+int bench(size_t dim, size_t capacity) {
+  std::mt19937 rng(3);
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  piper::SemanticQueryCache cache;
+  cache.configure({0.95f, capacity});
+  std::vector<float> v(dim);
+  for (size_t i = 0; i < capacity; ++i) {
+    for (float& x : v) x = gauss(rng);
+    cache.insert("bench", v.data(), dim, std::string(2048, 'x'), 0.0);
+  }
+  // Fresh random queries: almost surely below min_cosine of every entry, so each probe scans the whole cache.
+  std::vector<float> queries(256 * dim);
+  for (float& x : queries) x = gauss(rng);
+  const int probes = 20000;
+  const auto t0 = std::chrono::steady_clock::now();
+  int hits = 0;
+  for (int i = 0; i < probes; ++i) hits += cache.probe("bench", queries.data() + (i % 256) * dim, dim, nullptr);
+  const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+  std::printf("dim %zu  capacity %zu  %.2f us per probe (%d hits)\n", dim, capacity, us / probes, hits);
+  return 0;
+}
+
+void usage() {
+  std::fprintf(stderr, "usage: query_cache_eval (--selftest | --bench) [--dim 384] [--capacity 64]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool run_selftest = false, run_bench = false;
+  size_t dim = 384, capacity = 64;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--selftest") run_selftest = true;
+    else if (arg == "--bench") run_bench = true;
+    else if (arg == "--dim") dim = std::strtoul(next().c_str(), nullptr, 10);
+    else if (arg == "--capacity") capacity = std::strtoul(next().c_str(), nullptr, 10);
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (run_selftest) return selftest();
+  if (!run_bench || dim == 0 || capacity == 0) {
+    usage();
+    return 2;
+  }
+  return bench(dim, capacity);
+}
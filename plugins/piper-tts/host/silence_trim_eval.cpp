@@ -0,0 +1,159 @@
+// Model-silence trimming (../ios/cpp/silence_trim.h) on Linux: reports what trimSilence removes from WAV
+// files (e.g. raw VITS renders) with the engine's defaults or the given settings, and a self-test.
+//
+//   silence_trim_eval (--wav a.wav ... | --selftest) [--max-gap-ms 0] [--threshold-db -45] [--edge-keep-ms 20]
+//
+// --selftest runs generated utterances at 16 and 22.05 kHz: edge silence is dropped down to edge_keep_ms,
+// the pause between two sentences survives the default settings sample for sample (whole, and streamed as
+// two clauses), an opt-in max_gap_ms shortens it, and silent or disabled input is left alone; exits non-zero
+// on any failure.
+
+#include "silence_trim.h"
+#include "wav_io.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool ok, const char* what, double value, const char* unit) {
+  std::printf("  %-52s %10.2f %-4s %s\n", what, value, unit, ok ? "ok" : "FAIL");
+  if (!ok) g_failures++;
+}
+
+// Voiced stand-in: a 180 Hz tone with a 4 Hz syllable envelope that never reaches zero.
+void appendSpeech(std::vector<float>& out, int rate, double sec) {
+  const size_t n = static_cast<size_t>(sec * rate);
+  for (size_t i = 0; i < n; i++) {
+    const double t = static_cast<double>(i) / rate;
+    out.push_back(static_cast<float>(0.4 * (0.6 + 0.4 * std::sin(2 * M_PI * 4 * t)) * std::sin(2 * M_PI * 180 * t)));
+  }
+}
+
+// Model "silence": low-level noise about 70 dB under the speech.
+void appendSilence(std::vector<float>& out, int rate, double sec, std::mt19937& rng) {
+  std::normal_distribution<float> noise(0.f, 1e-4f);
+  const size_t n = static_cast<size_t>(sec * rate);
+  for (size_t i = 0; i < n; i++) out.push_back(noise(rng));
+}
+
+double ms(size_t samples, int rate) { return 1000.0 * static_cast<double>(samples) / rate; }
+
+int selftest() {
+  std::mt19937 rng(7);
+  for (int rate : {22050, 16000}) {
+    std::printf("rate %d Hz\n", rate);
+    const double lead = 0.25, first = 0.6, pause = 0.45, second = 0.5, tail = 0.3;
+    std::vector<float> clip;
+    appendSilence(clip, rate, lead, rng);
+    appendSpeech(clip, rate, first);
+    appendSilence(clip, rate, pause, rng);
+    appendSpeech(clip, rate, second);
+    appendSilence(clip, rate, tail, rng);
+
+    const piper::SilenceTrimConfig defaults;
+    const double win_ms = defaults.window_ms;
+    std::vector<float> trimmed = clip;
+    const piper::SilenceTrimStats s = piper::trimSilence(trimmed, rate, defaults);
+    const double lead_left = lead * 1000 - ms(s.lead_samples, rate);
+    const double tail_left = tail * 1000 - ms(s.tail_samples, rate);
+    check(std::fabs(lead_left - defaults.edge_keep_ms) <= win_ms, "defaults: lead silence left (ms)", lead_left, "ms");
+    check(std::fabs(tail_left - defaults.edge_keep_ms) <= win_ms, "defaults: tail silence left (ms)", tail_left, "ms");
+    check(s.gaps == 0 && s.gap_samples == 0, "defaults: interior samples removed", ms(s.gap_samples, rate), "ms");
+    // Both sentences and the pause between them, unchanged.
+    const size_t body_begin = static_cast<size_t>(lead * rate);
+    const size_t body_len = static_cast<size_t>((first + pause + second) * rate);
+    bool intact = body_begin >= s.lead_samples && body_begin - s.lead_samples + body_len <= trimmed.size();
+    for (size_t i = 0; intact && i < body_len; i++) {
+      intact = trimmed[body_begin - s.lead_samples + i] == clip[body_begin + i];
+    }
+    check(intact, "defaults: inter-sentence pause kept (ms)", pause * 1000, "ms");
+
+    // Streamed as two clauses split inside the pause: only the utterance's outer edges are cut.
+    const size_t split = body_begin + static_cast<size_t>((first + pause / 2) * rate);
+    std::vector<float> clause1(clip.begin(), clip.begin() + split);
+    std::vector<float> clause2(clip.begin() + split, clip.end());
+    const piper::SilenceTrimStats s1 = piper::trimSilence(clause1, rate, defaults, piper::kSilenceEdgeLead);
+    const piper::SilenceTrimStats s2 = piper::trimSilence(clause2, rate, defaults, piper::kSilenceEdgeTail);
+    // The outer edges match the whole-utterance trim to within a window (clause 2 has its own window grid).
+    const double outer_ms = std::fabs(ms(s1.lead_samples + s2.tail_samples, rate) - ms(s.removed(), rate));
+    const bool joined = s1.tail_samples == 0 && s2.lead_samples == 0 && s1.gaps == 0 && s2.gaps == 0 &&
+                        outer_ms <= win_ms;
+    check(joined, "clauses: pause kept across the clause edges (ms)", pause * 1000, "ms");
+
+    piper::SilenceTrimConfig compact = defaults;
+    compact.max_gap_ms = 200;
+    std::vector<float> shortened = clip;
+    const piper::SilenceTrimStats c = piper::trimSilence(shortened, rate, compact);
+    const double gap_left = pause * 1000 - ms(c.gap_samples, rate);
+    check(c.gaps == 1 && std::fabs(gap_left - compact.max_gap_ms) <= 2 * win_ms, "max_gap_ms=200: pause left (ms)",
+          gap_left, "ms");
+
+    std::vector<float> silent;
+    appendSilence(silent, rate, 0.5, rng);
+    const std::vector<float> silent_in = silent;
+    piper::trimSilence(silent, rate, defaults);
+    check(silent == silent_in, "all-silence clip unchanged (samples)", static_cast<double>(silent.size()), "");
+
+    piper::SilenceTrimConfig off = defaults;
+    off.enabled = false;
+    std::vector<float> untouched = clip;
+    const piper::SilenceTrimStats o = piper::trimSilence(untouched, rate, off);
+    check(o.removed() == 0 && untouched == clip, "enabled=false: samples removed", static_cast<double>(o.removed()), "");
+  }
+  std::printf("selftest: %s\n", g_failures ? "FAILED" : "all passed");
+  return g_failures ? 1 : 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: silence_trim_eval (--wav <file> ... | --selftest) [--max-gap-ms 0] [--threshold-db -45]\n"
+               "                         [--edge-keep-ms 20]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> wavs;
+  bool run_selftest = false;
+  piper::SilenceTrimConfig config;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--wav") wavs.push_back(next());
+    else if (arg == "--max-gap-ms") config.max_gap_ms = std::atoi(next().c_str());
+    else if (arg == "--threshold-db") config.threshold_db = static_cast<float>(std::atof(next().c_str()));
+    else if (arg == "--edge-keep-ms") config.edge_keep_ms = std::atoi(next().c_str());
+    else if (arg == "--selftest") run_selftest = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (run_selftest) return selftest();
+  if (wavs.empty()) {
+    usage();
+    return 2;
+  }
+
+  for (const std::string& path : wavs) {
+    std::vector<float> audio;
+    int rate = 0;
+    std::string err;
+    if (!piper_host::readWav(path, audio, rate, &err)) {
+      std::fprintf(stderr, "silence_trim_eval: skip %s (%s)\n", path.c_str(), err.c_str());
+      continue;
+    }
+    const size_t before = audio.size();
+    const piper::SilenceTrimStats s = piper::trimSilence(audio, rate, config);
+    std::printf("%s: %.0f ms -> %.0f ms (lead %.0f, tail %.0f, %zu gaps %.0f ms)\n", path.c_str(), ms(before, rate),
+                ms(audio.size(), rate), ms(s.lead_samples, rate), ms(s.tail_samples, rate), s.gaps,
+                ms(s.gap_samples, rate));
+  }
+  return 0;
+}
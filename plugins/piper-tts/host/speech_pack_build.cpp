@@ -0,0 +1,144 @@
+// Renders canned app lines into an audio pack (ios/cpp/audio_pack.h) with the same piper::synthesize the
+// devices run, so a pack hit sounds exactly like live synthesis of that line.
+//
+//   speech_pack_build --model model.onnx --config model.onnx.json --espeak-data <dir>
+//                     --lines speech_lines.json --out speech_pack.bin [--json report.json]
+//
+// Lines: JSON array of strings or {"text": "..."} objects. Duplicates (after whitespace canonicalization)
+// are rendered once. The written pack is reopened and every line looked up before exiting.
+
+#include "audio_pack.h"
+#include "json.hpp"
+#include "piper_engine.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+bool readLines(const std::string& path, std::vector<std::string>& lines) {
+  std::ifstream f(path);
+  if (!f) return false;
+  json doc;
+  try {
+    doc = json::parse(f);
+  } catch (...) {
+    return false;
+  }
+  if (!doc.is_array()) return false;
+  std::set<std::string> seen;
+  for (const auto& item : doc) {
+    std::string text;
+    if (item.is_string()) text = item.get<std::string>();
+    else if (item.is_object() && item.contains("text") && item["text"].is_string()) text = item["text"].get<std::string>();
+    text = piper::canonicalUtteranceText(text);
+    if (!text.empty() && seen.insert(text).second) lines.push_back(text);
+  }
+  return true;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: speech_pack_build --model <model.onnx> --config <model.onnx.json> --espeak-data <dir>\n"
+               "                         --lines <speech_lines.json> --out <speech_pack.bin> [--json <report.json>]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string model, config, espeak_data, lines_path, out_path, json_out;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--model") model = next();
+    else if (arg == "--config") config = next();
+    else if (arg == "--espeak-data") espeak_data = next();
+    else if (arg == "--lines") lines_path = next();
+    else if (arg == "--out") out_path = next();
+    else if (arg == "--json") json_out = next();
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (model.empty() || config.empty() || lines_path.empty() || out_path.empty()) {
+    usage();
+    return 2;
+  }
+  if (!piper::hasEspeak()) {
+    std::fprintf(stderr, "speech_pack_build: built without espeak-ng (PIPER_ENGINE_USE_ESPEAK)\n");
+    return 1;
+  }
+
+  std::vector<std::string> texts;
+  if (!readLines(lines_path, texts)) {
+    std::fprintf(stderr, "speech_pack_build: cannot read lines from %s\n", lines_path.c_str());
+    return 1;
+  }
+  uint64_t voice_key = 0;
+  if (!piper::voiceIdentityKeyForFiles(model, config, &voice_key)) {
+    std::fprintf(stderr, "speech_pack_build: cannot read model/config\n");
+    return 1;
+  }
+
+  // Render sequentially with the default parallelism; each line is one synthesize() as on device.
+  std::vector<piper::AudioPackLine> rendered;
+  int sample_rate = 0;
+  double audio_sec = 0.0;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (const std::string& text : texts) {
+    piper::AudioPackLine line;
+    line.text = text;
+    int rate = 0;
+    piper::SynthesizeError err = piper::SynthesizeError::kNone;
+    if (!piper::synthesize(model, config, espeak_data, text, line.pcm, rate, &err)) {
+      std::fprintf(stderr, "speech_pack_build: synthesis failed (error %d) for \"%s\"\n", static_cast<int>(err),
+                   text.c_str());
+      return 1;
+    }
+    sample_rate = rate;
+    audio_sec += static_cast<double>(line.pcm.size()) / rate;
+    rendered.push_back(std::move(line));
+  }
+  const double compute_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  std::string error;
+  if (!piper::writeAudioPack(out_path, sample_rate, voice_key, rendered, &error)) {
+    std::fprintf(stderr, "speech_pack_build: %s: %s\n", out_path.c_str(), error.c_str());
+    return 1;
+  }
+
+  piper::AudioPack pack;
+  if (!pack.open(out_path, &error)) {
+    std::fprintf(stderr, "speech_pack_build: written pack invalid: %s\n", error.c_str());
+    return 1;
+  }
+  for (const auto& line : rendered) {
+    const int16_t* pcm = nullptr;
+    size_t samples = 0;
+    if (!pack.find(line.text, &pcm, &samples) || samples != line.pcm.size()) {
+      std::fprintf(stderr, "speech_pack_build: lookup mismatch for \"%s\"\n", line.text.c_str());
+      return 1;
+    }
+  }
+
+  std::ifstream sized(out_path, std::ios::binary | std::ios::ate);
+  const long long bytes = sized ? static_cast<long long>(sized.tellg()) : 0;
+  std::printf("lines %zu  audio %.1fs  render %.2fs  pack %lld bytes @ %d Hz -> %s\n", pack.size(), audio_sec,
+              compute_sec, bytes, sample_rate, out_path.c_str());
+
+  if (!json_out.empty()) {
+    json report = {
+        {"lines", pack.size()},       {"audio_sec", audio_sec}, {"render_sec", compute_sec},
+        {"pack_bytes", bytes},        {"sample_rate", sample_rate},
+        {"voice_key", std::to_string(voice_key)},
+    };
+    std::ofstream(json_out) << report.dump(2) << "\n";
+  }
+  return 0;
+}
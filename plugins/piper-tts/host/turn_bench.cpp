@@ -0,0 +1,410 @@
+// End-to-end turn latency on Linux: audio in -> transcript -> retrieval + context -> LLM stand-in -> first
+// Piper audio, with the same native cores the apps run (StreamingRecognizer, embedText, SegmentedVectorIndex,
+// synthesizeStreaming). Reports per-stage and total latency distributions over every fixture and run.
+//
+//   turn_bench --manifest fixtures/turns/manifest.tsv --pack assets/content_pack
+//              --embed-model models/embed/model.onnx
+//              --tts-model model.onnx --tts-config model.onnx.json --espeak-data <dir>
+//              [--asr-model model.onnx --asr-tokens tokens.txt --asr-config asr_config.json]
+//              [--llm-reply "text" | --llm-replay replay.json] [--llm-ttft-ms 350] [--llm-tok-per-sec 20]
+//              [--runs 5] [--frame-ms 10] [--top-k-rules 3] [--top-k-cards 2] [--top-k-merge 4] [--json report.json]
+//
+// Manifest: "<wav path>\t<transcript>" per line (asr_eval format). Without --asr-model the transcript is the
+// query and the ASR stages are skipped. The LLM is a stand-in on a virtual clock: a fixed reply streamed at
+// --llm-ttft-ms / --llm-tok-per-sec, or a replay of recorded token times ({"tokens":[{"text","ms"}]}, ms from
+// request start, e.g. from the app's rag_first_token / rag_stream_update telemetry). Context assembly follows
+// runtimePrompt.ts (excerpt block capped at 2400 chars, prompt at 1400 by dropping trailing chunks).
+//
+// Stages per turn (ms): asr_stream (feature + inference while audio arrives), asr_final (finish() after the
+// last frame), embed, search, context, llm_first_token, llm_total, tts_first_audio (speak() to the first
+// clause's PCM) and first_audio = asr_final + embed + search + context + llm_total + tts_first_audio, the
+// user-perceived gap from end of speech to hearing the answer (the app speaks the completed reply).
+
+#include "embedding_engine.h"
+#include "json.hpp"
+#include "piper_engine.h"
+#include "streaming_asr.h"
+#include "vector_index.h"
+#include "wav_io.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+const char* const kStages[] = {"asr_stream",      "asr_final", "embed",           "search", "context",
+                               "llm_first_token", "llm_total", "tts_first_audio", "first_audio"};
+constexpr size_t kMaxContextChars = 2400;
+constexpr size_t kMaxPromptChars = 1400;
+
+struct Turn {
+  std::string wav;
+  std::string transcript;
+};
+
+struct LlmReplay {
+  double ttft_ms = 350.0;
+  double tok_per_sec = 20.0;
+  std::string text = "Trample lets excess combat damage go to the player or planeswalker it's attacking.";
+  std::vector<std::pair<std::string, double>> tokens;  // recorded (text, ms since request); empty = synthetic
+};
+
+struct Source {
+  std::string name;
+  std::vector<std::string> chunks;
+  piper::SegmentedVectorIndex index;
+};
+
+double msSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+bool readManifest(const std::string& path, std::vector<Turn>& out) {
+  std::ifstream in(path);
+  if (!in) return false;
+  const size_t slash = path.find_last_of('/');
+  const std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty() || line[0] == '#') continue;
+    const size_t tab = line.find('\t');
+    if (tab == std::string::npos) continue;
+    Turn t;
+    t.wav = line.substr(0, tab);
+    if (!t.wav.empty() && t.wav[0] != '/') t.wav = dir + t.wav;
+    t.transcript = line.substr(tab + 1);
+    out.push_back(t);
+  }
+  return true;
+}
+
+bool loadSource(const std::string& pack, Source& src, std::string* error) {
+  const std::string dir = pack + "/" + src.name;
+  std::ifstream meta_in(dir + "/index_meta.json");
+  const json meta = meta_in ? json::parse(meta_in, nullptr, false) : json();
+  if (!meta.is_object() || !meta.contains("dim")) {
+    *error = dir + "/index_meta.json missing or has no dim";
+    return false;
+  }
+  std::ifstream chunks(dir + "/chunks.jsonl");
+  std::string line;
+  while (std::getline(chunks, line)) {
+    if (!line.empty()) src.chunks.push_back(line);
+  }
+  piper::VectorIndexSpec spec;
+  spec.dim = meta["dim"].get<uint32_t>();
+  spec.segments.push_back({"base", dir + "/vectors.f16", 0, ""});
+  piper::VectorIndexError err = piper::VectorIndexError::kNone;
+  if (!src.index.open(spec, &err)) {
+    *error = dir + "/vectors.f16: " + piper::vectorIndexErrorString(err);
+    return false;
+  }
+  return true;
+}
+
+// Synthetic tokens: whitespace-split words at tok_per_sec after ttft.
+std::vector<std::pair<std::string, double>> replayTokens(const LlmReplay& llm) {
+  if (!llm.tokens.empty()) return llm.tokens;
+  std::vector<std::pair<std::string, double>> out;
+  std::istringstream words(llm.text);
+  std::string w;
+  double t = llm.ttft_ms;
+  while (words >> w) {
+    out.push_back({(out.empty() ? "" : " ") + w, t});
+    t += 1000.0 / std::max(0.1, llm.tok_per_sec);
+  }
+  return out;
+}
+
+bool loadReplay(const std::string& path, LlmReplay& llm) {
+  std::ifstream in(path);
+  const json doc = in ? json::parse(in, nullptr, false) : json();
+  if (!doc.is_object() || !doc.contains("tokens") || !doc["tokens"].is_array()) return false;
+  llm.tokens.clear();
+  for (const auto& t : doc["tokens"]) {
+    if (!t.contains("text") || !t.contains("ms")) return false;
+    llm.tokens.push_back({t["text"].get<std::string>(), t["ms"].get<double>()});
+  }
+  return !llm.tokens.empty();
+}
+
+struct Hit {
+  const Source* source;
+  uint32_t row;
+  double score;
+};
+
+// runtimePrompt.ts buildContextBlock + trimChunksToFitPrompt over the hits' chunk rows.
+std::string buildPrompt(const std::vector<Hit>& hits, const std::string& question) {
+  std::vector<std::pair<std::string, std::string>> excerpts;  // (source, line)
+  for (const Hit& h : hits) {
+    if (h.row >= h.source->chunks.size()) continue;
+    const json chunk = json::parse(h.source->chunks[h.row], nullptr, false);
+    if (chunk.is_discarded()) continue;
+    const std::string doc_id = chunk.value("doc_id", "");
+    const std::string title = chunk.value("title", "");
+    const std::string text = chunk.value("text", "");
+    excerpts.push_back({h.source->name, "[" + doc_id + "] " + (title.empty() ? "" : title + ": ") + text});
+  }
+  for (;;) {
+    std::string block;
+    for (const char* src : {"rules", "cards"}) {
+      bool header = false;
+      for (const auto& e : excerpts) {
+        if (e.first != src) continue;
+        if (!header) {
+          block += std::string(block.empty() ? "" : "\n\n") + (e.first == "rules" ? "Rules" : "Cards") +
+                   " excerpts (doc_id for citation):";
+          header = true;
+        }
+        block += "\n\n" + e.second;
+      }
+    }
+    if (block.size() > kMaxContextChars) block = block.substr(0, kMaxContextChars) + "\n[...truncated]";
+    const std::string prompt = "<|begin_of_text|><|start_header_id|>system<|end_header_id|>\n\n"
+                               "You are a concise assistant.<|eot_id|>\n<|start_header_id|>user<|end_header_id|>\n\n" +
+                               block + "\n\nQuestion: " + question +
+                               "<|eot_id|>\n<|start_header_id|>assistant<|end_header_id|>\n\n";
+    if (prompt.size() <= kMaxPromptChars || excerpts.empty()) return prompt;
+    excerpts.pop_back();
+  }
+}
+
+struct Distribution {
+  double mean = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;
+};
+
+Distribution distribution(std::vector<double> v) {
+  Distribution d;
+  if (v.empty()) return d;
+  std::sort(v.begin(), v.end());
+  auto pct = [&](double p) { return v[std::min(v.size() - 1, static_cast<size_t>(std::ceil(p * v.size())) - 1)]; };
+  double sum = 0;
+  for (double x : v) sum += x;
+  d.mean = sum / v.size();
+  d.p50 = pct(0.50);
+  d.p90 = pct(0.90);
+  d.p99 = pct(0.99);
+  d.max = v.back();
+  return d;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: turn_bench --manifest <manifest.tsv> --pack <content_pack> --embed-model <model.onnx>\n"
+               "                  --tts-model <model.onnx> --tts-config <model.onnx.json> --espeak-data <dir>\n"
+               "                  [--asr-model <m> --asr-tokens <t> --asr-config <c>] [--llm-reply <text> |\n"
+               "                  --llm-replay <replay.json>] [--llm-ttft-ms 350] [--llm-tok-per-sec 20] [--runs 5]\n"
+               "                  [--frame-ms 10] [--top-k-rules 3] [--top-k-cards 2] [--top-k-merge 4]\n"
+               "                  [--json <report.json>]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string manifest, pack, embed_model, tts_model, tts_config, espeak_data, asr_model, asr_tokens, asr_config,
+      replay_path, json_out;
+  LlmReplay llm;
+  int runs = 5, frame_ms = 10;
+  size_t top_k_rules = 3, top_k_cards = 2, top_k_merge = 4;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--manifest") manifest = next();
+    else if (arg == "--pack") pack = next();
+    else if (arg == "--embed-model") embed_model = next();
+    else if (arg == "--tts-model") tts_model = next();
+    else if (arg == "--tts-config") tts_config = next();
+    else if (arg == "--espeak-data") espeak_data = next();
+    else if (arg == "--asr-model") asr_model = next();
+    else if (arg == "--asr-tokens") asr_tokens = next();
+    else if (arg == "--asr-config") asr_config = next();
+    else if (arg == "--llm-reply") llm.text = next();
+    else if (arg == "--llm-replay") replay_path = next();
+    else if (arg == "--llm-ttft-ms") llm.ttft_ms = std::atof(next().c_str());
+    else if (arg == "--llm-tok-per-sec") llm.tok_per_sec = std::atof(next().c_str());
+    else if (arg == "--runs") runs = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--frame-ms") frame_ms = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--top-k-rules") top_k_rules = static_cast<size_t>(std::atoi(next().c_str()));
+    else if (arg == "--top-k-cards") top_k_cards = static_cast<size_t>(std::atoi(next().c_str()));
+    else if (arg == "--top-k-merge") top_k_merge = static_cast<size_t>(std::atoi(next().c_str()));
+    else if (arg == "--json") json_out = next();
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (manifest.empty() || pack.empty() || embed_model.empty() || tts_model.empty() || tts_config.empty()) {
+    usage();
+    return 2;
+  }
+  if (!replay_path.empty() && !loadReplay(replay_path, llm)) {
+    std::fprintf(stderr, "turn_bench: invalid LLM replay %s\n", replay_path.c_str());
+    return 1;
+  }
+  std::vector<Turn> turns;
+  if (!readManifest(manifest, turns) || turns.empty()) {
+    std::fprintf(stderr, "turn_bench: no turns in %s\n", manifest.c_str());
+    return 1;
+  }
+
+  std::map<std::string, double> load_ms;
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<Source> sources(2);
+  sources[0].name = "rules";
+  sources[1].name = "cards";
+  for (Source& s : sources) {
+    std::string error;
+    if (!loadSource(pack, s, &error)) {
+      std::fprintf(stderr, "turn_bench: %s\n", error.c_str());
+      return 1;
+    }
+  }
+  load_ms["pack"] = msSince(t0);
+
+  piper::StreamingRecognizer recognizer;
+  const bool use_asr = !asr_model.empty();
+  if (use_asr) {
+    t0 = std::chrono::steady_clock::now();
+    piper::AsrError err = piper::AsrError::kNone;
+    if (!recognizer.load(asr_model, asr_tokens, asr_config, &err)) {
+      std::fprintf(stderr, "turn_bench: ASR load failed: %s\n", piper::asrErrorToString(err));
+      return 1;
+    }
+    load_ms["asr"] = msSince(t0);
+  }
+  const std::string vocab = embed_model.substr(0, embed_model.find_last_of('/') + 1) + "vocab.txt";
+  const std::vector<std::pair<std::string, double>> reply_tokens = replayTokens(llm);
+  std::string reply;
+  for (const auto& t : reply_tokens) reply += t.first;
+
+  std::map<std::string, std::vector<double>> samples;
+  size_t failures = 0, prompt_chars = 0;
+  // Run 0 is a warm-up (model/session loads, page faults) and is reported as load time, not latency.
+  for (int run = 0; run <= runs; ++run) {
+    for (const Turn& turn : turns) {
+      std::map<std::string, double> stage;
+      std::string transcript = turn.transcript;
+      if (use_asr) {
+        std::vector<float> audio;
+        int wav_rate = 0;
+        std::string wav_err;
+        if (!piper_host::readWav(turn.wav, audio, wav_rate, &wav_err)) {
+          std::fprintf(stderr, "turn_bench: skip %s (%s)\n", turn.wav.c_str(), wav_err.c_str());
+          ++failures;
+          continue;
+        }
+        audio = piper_host::resampleLinear(audio, wav_rate, recognizer.sampleRate());
+        std::vector<int16_t> pcm(audio.size());
+        for (size_t i = 0; i < audio.size(); i++)
+          pcm[i] = static_cast<int16_t>(std::max(-1.0f, std::min(1.0f, audio[i])) * 32767.0f);
+        const size_t frame = static_cast<size_t>(recognizer.sampleRate()) * frame_ms / 1000;
+        recognizer.reset();
+        piper::AsrError err = piper::AsrError::kNone;
+        t0 = std::chrono::steady_clock::now();
+        bool ok = true;
+        for (size_t off = 0; off < pcm.size() && ok; off += frame)
+          ok = recognizer.acceptPcm16(pcm.data() + off, std::min(frame, pcm.size() - off), &err);
+        stage["asr_stream"] = msSince(t0);
+        t0 = std::chrono::steady_clock::now();
+        if (ok) transcript = recognizer.finish(&err);
+        stage["asr_final"] = msSince(t0);
+        if (!ok || err != piper::AsrError::kNone) {
+          std::fprintf(stderr, "turn_bench: ASR failed on %s: %s\n", turn.wav.c_str(), piper::asrErrorToString(err));
+          ++failures;
+          continue;
+        }
+      }
+
+      t0 = std::chrono::steady_clock::now();
+      std::vector<float> query;
+      piper::EmbedError embed_err = piper::EmbedError::kNone;
+      if (!piper::embedText(embed_model, vocab, transcript, query, &embed_err)) {
+        std::fprintf(stderr, "turn_bench: embed failed: %s\n", piper::embedErrorToString(embed_err));
+        return 1;
+      }
+      stage["embed"] = msSince(t0);
+
+      // ask.ts: per-source top-k, scores normalized per source and weighted (rules 0.6, cards 0.4).
+      t0 = std::chrono::steady_clock::now();
+      std::vector<Hit> hits;
+      const double weights[2] = {0.6, 0.4};
+      const size_t ks[2] = {top_k_rules, top_k_cards};
+      for (size_t s = 0; s < sources.size(); ++s) {
+        const auto found = sources[s].index.search(query.data(), query.size(), ks[s]);
+        double best = 0;
+        for (const auto& h : found) best = std::max(best, 1.0 / (1.0 + h.distance));
+        for (const auto& h : found)
+          hits.push_back({&sources[s], h.row, best > 0 ? weights[s] * (1.0 / (1.0 + h.distance)) / best : 0});
+      }
+      std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.score > b.score; });
+      if (hits.size() > top_k_merge) hits.resize(top_k_merge);
+      stage["search"] = msSince(t0);
+
+      t0 = std::chrono::steady_clock::now();
+      const std::string prompt = buildPrompt(hits, transcript);
+      stage["context"] = msSince(t0);
+
+      stage["llm_first_token"] = reply_tokens.empty() ? 0.0 : reply_tokens.front().second;
+      stage["llm_total"] = reply_tokens.empty() ? 0.0 : reply_tokens.back().second;
+
+      t0 = std::chrono::steady_clock::now();
+      double first_audio = -1;
+      int rate = 0;
+      piper::SynthesizeError tts_err = piper::SynthesizeError::kNone;
+      piper::synthesizeStreaming(
+          tts_model, tts_config, espeak_data, reply,
+          [&](const int16_t*, size_t, size_t) {
+            first_audio = msSince(t0);
+            return false;  // only time to first audio is measured
+          },
+          rate, &tts_err);
+      if (first_audio < 0) {
+        std::fprintf(stderr, "turn_bench: synthesis failed (error %d)\n", static_cast<int>(tts_err));
+        return 1;
+      }
+      stage["tts_first_audio"] = first_audio;
+      const double asr_final = use_asr ? stage["asr_final"] : 0.0;
+      stage["first_audio"] = asr_final + stage["embed"] + stage["search"] + stage["context"] + stage["llm_total"] +
+                             stage["tts_first_audio"];
+      if (run == 0) {
+        load_ms["warmup_turn"] = std::max(load_ms["warmup_turn"], stage["first_audio"]);
+        continue;
+      }
+      for (const auto& kv : stage) samples[kv.first].push_back(kv.second);
+      prompt_chars += prompt.size();
+    }
+  }
+  if (samples.empty()) {
+    std::fprintf(stderr, "turn_bench: no turns completed\n");
+    return 1;
+  }
+
+  const size_t n = samples["first_audio"].size();
+  std::printf("turns %zu (%zu fixtures x %d runs)  failures %zu  asr %s  llm %s  prompt %zu chars (mean)\n", n,
+              turns.size(), runs, failures, use_asr ? "on" : "off (transcripts)",
+              replay_path.empty() ? "fixed reply" : "replay", prompt_chars / n);
+  std::printf("  %-16s %9s %9s %9s %9s %9s\n", "stage (ms)", "mean", "p50", "p90", "p99", "max");
+  json report = {{"turns", n}, {"failures", failures}, {"runs", runs}, {"load_ms", load_ms},
+               {"prompt_chars_mean", prompt_chars / n}, {"stages", json::object()}};
+  for (const char* name : kStages) {
+    auto it = samples.find(name);
+    if (it == samples.end()) continue;
+    const Distribution d = distribution(it->second);
+    std::printf("  %-16s %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, d.mean, d.p50, d.p90, d.p99, d.max);
+    report["stages"][name] = {{"mean", d.mean}, {"p50", d.p50}, {"p90", d.p90}, {"p99", d.p99}, {"max", d.max}};
+  }
+  for (const auto& kv : load_ms) std::printf("  load %-11s %9.1f\n", kv.first.c_str(), kv.second);
+  if (!json_out.empty()) std::ofstream(json_out) << report.dump(2) << "\n";
+  return 0;
+}
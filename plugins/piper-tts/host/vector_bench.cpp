@@ -0,0 +1,608 @@
+// Coarse-to-fine vector search benchmark: recall@k and query time of SegmentedVectorIndex with a truncated
+// (Matryoshka) prefix scan plus full f16 re-rank, against the exhaustive scan, over a grid of prefix lengths
+// and candidate counts. --sq8 adds the full-dimension int8 scan (codes from a vectors.sq8 built the way
+// pack_compile --sq8 does) for each dot-product kernel in --kernels (default: the one picked for this CPU).
+// Prints a table and a recall-vs-speedup chart.
+//
+//   vector_bench --vectors assets/content_pack/rules/vectors.f16 --dim 768
+//                [--queries queries.f16 | --num-queries 200 --noise 0.5] [--k 10]
+//                [--prefix 64,128,256] [--candidates 16,32,64,128] [--int8] [--sq8 [--kernels vnni,avx2,scalar]]
+//                [--repeat 3] [--json report.json]
+//   vector_bench --synthetic 50000 --dim 768 ...
+//   vector_bench --selftest
+//
+// Without --queries, queries are index rows (evenly spaced) plus Gaussian noise of --noise times the row's
+// RMS per dimension, so a query's nearest row is usually, not always, its source. --synthetic writes a temp
+// f16 file whose per-dimension spread decays with the index, like a Matryoshka embedding.
+//
+// --selftest builds a base file, two delta segments (raw f16 and .vseg) and a tombstone-only delta in a temp
+// directory, and checks search against a brute-force scan of the live rows before and after compact(), the
+// .vseg round-trip, row-overlap and bad-header rejection, and fingerprint reuse of a compacted view; exits
+// non-zero on any failure.
+
+#include "json.hpp"
+#include "vector_index.h"
+#include "vector_sq8.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct Config {
+  uint32_t prefix = 0;
+  uint32_t candidates = 0;
+  bool int8 = false;
+  std::string sq8_kernel;  // empty: prefix scan
+};
+
+struct Result {
+  Config config;
+  double recall = 0.0;
+  double us_per_query = 0.0;
+  double speedup = 0.0;
+  size_t coarse_bytes = 0;
+};
+
+std::vector<std::string> splitList(const std::string& s) {
+  std::vector<std::string> out;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) out.push_back(item);
+  }
+  return out;
+}
+
+std::vector<uint32_t> parseList(const std::string& s) {
+  std::vector<uint32_t> out;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) out.push_back(static_cast<uint32_t>(std::strtoul(item.c_str(), nullptr, 10)));
+  }
+  return out;
+}
+
+// Round-to-nearest float -> f16 for the normal range (flushes tiny values to zero, clamps large ones).
+uint16_t floatToHalf(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+  const int32_t exp = static_cast<int32_t>((bits >> 23) & 0xffu) - 127 + 15;
+  if (exp <= 0) return sign;
+  if (exp >= 31) return static_cast<uint16_t>(sign | 0x7bffu);
+  uint32_t mant = bits & 0x7fffffu;
+  uint32_t h = (static_cast<uint32_t>(exp) << 10) | (mant >> 13);
+  if ((mant & 0x1fffu) > 0x1000u || ((mant & 0x1fffu) == 0x1000u && (h & 1u))) ++h;
+  return static_cast<uint16_t>(sign | std::min<uint32_t>(h, 0x7bffu));
+}
+
+bool readF16(const std::string& path, uint32_t dim, std::vector<float>& out) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (bytes.empty() || bytes.size() % (size_t(dim) * 2) != 0) return false;
+  out.resize(bytes.size() / 2);
+  for (size_t i = 0; i < out.size(); ++i) {
+    uint16_t h;
+    std::memcpy(&h, bytes.data() + i * 2, 2);
+    out[i] = piper::halfToFloat(h);
+  }
+  return true;
+}
+
+// Unit-length rows whose per-dimension spread decays like a Matryoshka embedding's.
+bool writeSynthetic(const std::string& path, size_t rows, uint32_t dim) {
+  std::mt19937 rng(1234);
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  std::vector<uint16_t> buf(dim);
+  std::vector<float> row(dim);
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  bool ok = true;
+  for (size_t r = 0; r < rows && ok; ++r) {
+    float norm = 0.f;
+    for (uint32_t d = 0; d < dim; ++d) {
+      row[d] = gauss(rng) * std::exp(-3.f * static_cast<float>(d) / dim);
+      norm += row[d] * row[d];
+    }
+    const float inv = 1.f / std::sqrt(norm);
+    for (uint32_t d = 0; d < dim; ++d) buf[d] = floatToHalf(row[d] * inv);
+    ok = std::fwrite(buf.data(), sizeof(uint16_t), dim, f) == dim;
+  }
+  return std::fclose(f) == 0 && ok;
+}
+
+std::vector<std::vector<piper::VectorHit>> runQueries(const piper::SegmentedVectorIndex& index,
+                                                       const std::vector<float>& queries, uint32_t dim, size_t k,
+                                                       bool exact, int repeat, double* us_per_query) {
+  const size_t n = queries.size() / dim;
+  std::vector<std::vector<piper::VectorHit>> hits(n);
+  double best = 0.0;
+  for (int r = 0; r < repeat; ++r) {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < n; ++q) {
+      hits[q] = exact ? index.searchExact(queries.data() + q * dim, dim, k)
+                      : index.search(queries.data() + q * dim, dim, k);
+    }
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    if (r == 0 || us < best) best = us;
+  }
+  *us_per_query = n ? best / n : 0.0;
+  return hits;
+}
+
+double recallAt(const std::vector<std::vector<piper::VectorHit>>& truth,
+                const std::vector<std::vector<piper::VectorHit>>& got) {
+  size_t found = 0, total = 0;
+  for (size_t q = 0; q < truth.size(); ++q) {
+    for (const piper::VectorHit& t : truth[q]) {
+      ++total;
+      for (const piper::VectorHit& g : got[q]) {
+        if (g.row == t.row) {
+          ++found;
+          break;
+        }
+      }
+    }
+  }
+  return total ? static_cast<double>(found) / total : 0.0;
+}
+
+int g_failures = 0;
+
+void check(bool ok, const char* what, double value, const char* unit) {
+  std::printf("  %-52s %10.2f %-4s %s\n", what, value, unit, ok ? "ok" : "FAIL");
+  if (!ok) g_failures++;
+}
+
+struct RefRow {
+  uint32_t id;
+  std::vector<uint16_t> f16;
+};
+
+bool writeFile(const std::string& path, const void* data, size_t bytes) {
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  const bool ok = std::fwrite(data, 1, bytes, f) == bytes;
+  return std::fclose(f) == 0 && ok;
+}
+
+bool writeRows(const std::string& path, const std::vector<RefRow>& rows) {
+  std::vector<uint16_t> buf;
+  for (const RefRow& r : rows) buf.insert(buf.end(), r.f16.begin(), r.f16.end());
+  return writeFile(path, buf.data(), buf.size() * sizeof(uint16_t));
+}
+
+// A delta in the .vseg layout (vector_index.h) with explicit, non-contiguous row ids.
+bool writeVseg(const std::string& path, uint32_t dim, const std::vector<RefRow>& rows) {
+  std::vector<unsigned char> out = {'P', 'I', 'P', 'E', 'R', 'V', 'S', '1'};
+  auto put = [&out](const void* p, size_t n) {
+    out.insert(out.end(), static_cast<const unsigned char*>(p), static_cast<const unsigned char*>(p) + n);
+  };
+  const uint32_t header_u32[4] = {1, dim, static_cast<uint32_t>(rows.size()), 0};
+  const uint64_t vectors_offset = (40 + rows.size() * 4 + 15) & ~uint64_t(15);
+  const uint64_t header_u64[2] = {0, vectors_offset};
+  put(header_u32, sizeof(header_u32));
+  put(header_u64, sizeof(header_u64));
+  for (const RefRow& r : rows) put(&r.id, sizeof(r.id));
+  out.resize(vectors_offset, 0);
+  for (const RefRow& r : rows) put(r.f16.data(), r.f16.size() * sizeof(uint16_t));
+  return writeFile(path, out.data(), out.size());
+}
+
+std::vector<RefRow> randomRows(uint32_t first, size_t n, uint32_t step, uint32_t dim, std::mt19937& rng) {
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  std::vector<RefRow> rows(n);
+  for (size_t i = 0; i < n; ++i) {
+    rows[i].id = first + static_cast<uint32_t>(i) * step;
+    rows[i].f16.resize(dim);
+    for (uint32_t d = 0; d < dim; ++d) rows[i].f16[d] = floatToHalf(gauss(rng));
+  }
+  return rows;
+}
+
+std::vector<piper::VectorHit> bruteForce(const std::vector<RefRow>& live, const float* q, uint32_t dim, size_t k) {
+  std::vector<piper::VectorHit> all;
+  for (const RefRow& r : live) {
+    double sum = 0.0;
+    for (uint32_t d = 0; d < dim; ++d) {
+      const double diff = double(q[d]) - piper::halfToFloat(r.f16[d]);
+      sum += diff * diff;
+    }
+    all.push_back({r.id, static_cast<float>(std::sqrt(sum))});
+  }
+  std::sort(all.begin(), all.end(),
+            [](const piper::VectorHit& a, const piper::VectorHit& b) { return a.distance < b.distance; });
+  all.resize(std::min(k, all.size()));
+  return all;
+}
+
+// Queries whose top-k (ids in order, distances within f32 rounding) match the brute-force scan.
+size_t matchingQueries(const piper::SegmentedVectorIndex& index, const std::vector<RefRow>& live,
+                       const std::vector<float>& queries, uint32_t dim, size_t k, bool exact) {
+  size_t matched = 0;
+  for (size_t q = 0; q < queries.size() / dim; ++q) {
+    const float* query = queries.data() + q * dim;
+    const auto got = exact ? index.searchExact(query, dim, k) : index.search(query, dim, k);
+    const auto want = bruteForce(live, query, dim, k);
+    bool same = got.size() == want.size();
+    for (size_t i = 0; same && i < got.size(); ++i) {
+      same = got[i].row == want[i].row && std::fabs(got[i].distance - want[i].distance) <= 1e-4f * want[i].distance;
+    }
+    matched += same;
+  }
+  return matched;
+}
+
+int selftest() {
+  char tmpl[] = "/tmp/vector_bench_selftest_XXXXXX";
+  if (!mkdtemp(tmpl)) {
+    std::fprintf(stderr, "vector_bench: cannot create a temp directory\n");
+    return 1;
+  }
+  const std::string dir = tmpl;
+  const uint32_t dim = 36;  // not a multiple of 8: exercises the scalar tails
+  const size_t k = 8;
+  std::mt19937 rng(99);
+
+  // base 0..199, raw delta 200..259 (tombstones 3, 17, 150, 205), .vseg delta 300, 303, ... 357
+  // (tombstones 201), tombstone-only delta (tombstones 306, 999).
+  const std::vector<RefRow> base = randomRows(0, 200, 1, dim, rng);
+  const std::vector<RefRow> delta1 = randomRows(200, 60, 1, dim, rng);
+  const std::vector<RefRow> delta2 = randomRows(300, 20, 3, dim, rng);
+  const uint32_t t1[] = {3, 17, 150, 205}, t2[] = {201}, t3[] = {306, 999};
+  bool written = writeRows(dir + "/base.f16", base) && writeRows(dir + "/delta1.f16", delta1) &&
+                 writeVseg(dir + "/delta2.vseg", dim, delta2) && writeFile(dir + "/delta1.tomb", t1, sizeof(t1)) &&
+                 writeFile(dir + "/delta2.tomb", t2, sizeof(t2)) && writeFile(dir + "/delta3.tomb", t3, sizeof(t3));
+  check(written, "fixture files written", 4, "segs");
+  std::vector<RefRow> live;
+  for (const std::vector<RefRow>* rows : {&base, &delta1, &delta2}) {
+    for (const RefRow& r : *rows) {
+      if (r.id != 3 && r.id != 17 && r.id != 150 && r.id != 205 && r.id != 201 && r.id != 306) live.push_back(r);
+    }
+  }
+
+  std::vector<float> queries;
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  for (size_t q = 0; q < 40; ++q) {
+    // Half are near a live or tombstoned row (tombstoned ones must not come back), half random.
+    const RefRow* src = q % 4 == 0 ? &base[150] : q % 4 == 1 ? &live[q * 7 % live.size()] : nullptr;
+    for (uint32_t d = 0; d < dim; ++d)
+      queries.push_back((src ? piper::halfToFloat(src->f16[d]) : 0.f) + (src ? 0.1f : 1.f) * gauss(rng));
+  }
+  const size_t n_queries = queries.size() / dim;
+
+  piper::VectorIndexSpec spec;
+  spec.dim = dim;
+  spec.segments = {{"base", dir + "/base.f16", 0, ""},
+                   {"delta1", dir + "/delta1.f16", 200, dir + "/delta1.tomb"},
+                   {"delta2", dir + "/delta2.vseg", 0, dir + "/delta2.tomb"},
+                   {"delta3", "", 0, dir + "/delta3.tomb"}};
+  spec.compacted_path = dir + "/compacted.vseg";
+
+  piper::SegmentedVectorIndex index;
+  piper::VectorIndexError err = piper::VectorIndexError::kNone;
+  const bool opened = index.open(spec, &err);
+  piper::VectorIndexStats st = index.stats();
+  check(opened && st.segments == 3 && st.rows == 280 && !st.compacted, "segments: rows across base + deltas",
+        static_cast<double>(st.rows), "rows");
+  check(st.tombstones == 6 && st.live_rows == live.size(), "segments: tombstoned rows (ids 999 ignored)",
+        static_cast<double>(st.tombstones), "rows");
+  check(matchingQueries(index, live, queries, dim, k, true) == n_queries, "segments: searchExact == brute force",
+        static_cast<double>(n_queries), "qry");
+  check(matchingQueries(index, live, queries, dim, k, false) == n_queries, "segments: search == brute force",
+        static_cast<double>(n_queries), "qry");
+
+  // Overlap: a delta starting inside the base is rejected and the open index is kept.
+  piper::VectorIndexSpec overlap = spec;
+  overlap.segments[1].first_row = 150;
+  const bool overlap_opened = index.open(overlap, &err);
+  check(!overlap_opened && err == piper::VectorIndexError::kRowOverlap && index.stats().fingerprint == st.fingerprint,
+        "overlapping delta rejected, previous state kept", static_cast<double>(overlap.segments[1].first_row), "row");
+  const std::vector<unsigned char> truncated = {'P', 'I', 'P', 'E', 'R', 'V', 'S', '1', 1, 0, 0, 0};
+  writeFile(dir + "/bad.vseg", truncated.data(), truncated.size());
+  piper::VectorIndexSpec bad = spec;
+  bad.segments[2].vectors_path = dir + "/bad.vseg";
+  err = piper::VectorIndexError::kNone;
+  check(!index.open(bad, &err) && err == piper::VectorIndexError::kBadFormat, "truncated .vseg rejected",
+        static_cast<double>(truncated.size()), "B");
+
+  // Compaction folds every segment and tombstone into one .vseg with the same answers.
+  err = piper::VectorIndexError::kNone;
+  const bool compacted = index.compact(spec.compacted_path, &err);
+  st = index.stats();
+  check(compacted && st.compacted && st.segments == 1 && st.tombstones == 0 && st.live_rows == live.size(),
+        "compact: one segment of the live rows", static_cast<double>(st.live_rows), "rows");
+  check(matchingQueries(index, live, queries, dim, k, true) == n_queries, "compact: searchExact == brute force",
+        static_cast<double>(n_queries), "qry");
+  // With every row a candidate, the coarse pass only reorders and the f16 re-rank must give the exact top-k.
+  index.setCoarseSearch({12, 512, true, false});
+  const size_t coarse_matched = matchingQueries(index, live, queries, dim, k, false);
+  index.setCoarseSearch({});
+  check(coarse_matched == n_queries, "compact: int8 prefix + re-rank == brute force",
+        static_cast<double>(coarse_matched), "qry");
+  check(index.open(spec, &err) && index.stats().compacted, "fingerprint: same spec keeps the compacted view",
+        static_cast<double>(index.stats().segments), "segs");
+
+  // A fresh index prefers the compacted file while its fingerprint matches the spec.
+  piper::SegmentedVectorIndex reopened;
+  const bool reopened_ok = reopened.open(spec, &err);
+  check(reopened_ok && reopened.stats().compacted && reopened.stats().fingerprint == st.fingerprint,
+        "fingerprint: new index reuses compacted.vseg", static_cast<double>(reopened.stats().live_rows), "rows");
+  check(matchingQueries(reopened, live, queries, dim, k, true) == n_queries, "round-trip: reopened .vseg == brute force",
+        static_cast<double>(n_queries), "qry");
+  piper::SegmentedVectorIndex as_segment;
+  piper::VectorIndexSpec only;
+  only.dim = dim;
+  only.segments = {{"compacted", spec.compacted_path, 0, ""}};
+  check(as_segment.open(only, &err) && matchingQueries(as_segment, live, queries, dim, k, true) == n_queries,
+        "round-trip: .vseg as a plain segment == brute force", static_cast<double>(n_queries), "qry");
+
+  // Changing a delta's tombstones changes the fingerprint: the stale compacted view is not used.
+  const uint32_t t3_more[] = {306, 999, 10};
+  writeFile(dir + "/delta3.tomb", t3_more, sizeof(t3_more));
+  live.erase(std::remove_if(live.begin(), live.end(), [](const RefRow& r) { return r.id == 10; }), live.end());
+  piper::SegmentedVectorIndex changed;
+  const bool changed_opened = changed.open(spec, &err);
+  check(changed_opened && !changed.stats().compacted && changed.stats().fingerprint != st.fingerprint &&
+            changed.stats().live_rows == live.size(),
+        "fingerprint: edited delta ignores compacted.vseg", static_cast<double>(changed.stats().tombstones), "rows");
+  check(matchingQueries(changed, live, queries, dim, k, true) == n_queries, "edited delta: search == brute force",
+        static_cast<double>(n_queries), "qry");
+
+  for (const char* name : {"base.f16", "delta1.f16", "delta2.vseg", "delta1.tomb", "delta2.tomb", "delta3.tomb",
+                           "bad.vseg", "compacted.vseg"})
+    std::remove((dir + "/" + name).c_str());
+  rmdir(dir.c_str());
+  std::printf("selftest: %s\n", g_failures ? "FAILED" : "all passed");
+  return g_failures ? 1 : 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: vector_bench --selftest\n"
+               "       vector_bench (--vectors <vectors.f16> | --synthetic <rows>) --dim <n>\n"
+               "                    [--queries <queries.f16> | --num-queries 200 --noise 0.5] [--k 10]\n"
+               "                    [--prefix 64,128,256] [--candidates 16,32,64,128] [--int8]\n"
+               "                    [--sq8 [--kernels sdot,neon,vnni,avx2,sse2,scalar]] [--repeat 3] [--json <report.json>]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string vectors, queries_path, json_out;
+  size_t synthetic = 0, num_queries = 200, k = 10;
+  uint32_t dim = 0;
+  float noise = 0.5f;
+  int repeat = 3;
+  std::vector<uint32_t> prefixes, candidate_counts = {16, 32, 64, 128};
+  bool int8 = false, sq8 = false;
+  std::vector<std::string> kernels;
+  bool run_selftest = false;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+    if (arg == "--vectors") vectors = next();
+    else if (arg == "--synthetic") synthetic = std::strtoul(next().c_str(), nullptr, 10);
+    else if (arg == "--dim") dim = static_cast<uint32_t>(std::strtoul(next().c_str(), nullptr, 10));
+    else if (arg == "--queries") queries_path = next();
+    else if (arg == "--num-queries") num_queries = std::max<size_t>(1, std::strtoul(next().c_str(), nullptr, 10));
+    else if (arg == "--noise") noise = std::strtof(next().c_str(), nullptr);
+    else if (arg == "--k") k = std::max<size_t>(1, std::strtoul(next().c_str(), nullptr, 10));
+    else if (arg == "--prefix") prefixes = parseList(next());
+    else if (arg == "--candidates") candidate_counts = parseList(next());
+    else if (arg == "--int8") int8 = true;
+    else if (arg == "--sq8") sq8 = true;
+    else if (arg == "--kernels") kernels = splitList(next());
+    else if (arg == "--repeat") repeat = std::max(1, std::atoi(next().c_str()));
+    else if (arg == "--json") json_out = next();
+    else if (arg == "--selftest") run_selftest = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (run_selftest) return selftest();
+  if (dim == 0 || (vectors.empty() == (synthetic == 0)) || candidate_counts.empty()) {
+    usage();
+    return 2;
+  }
+  if (prefixes.empty()) {
+    for (uint32_t p = 32; p < dim; p *= 2) prefixes.push_back(p);
+  }
+
+  std::string temp_path;
+  if (synthetic > 0) {
+    char tmpl[] = "/tmp/vector_bench_XXXXXX";
+    const int fd = mkstemp(tmpl);
+    if (fd < 0) {
+      std::fprintf(stderr, "vector_bench: cannot create a temp file\n");
+      return 1;
+    }
+    ::close(fd);
+    temp_path = vectors = tmpl;
+    if (!writeSynthetic(vectors, synthetic, dim)) {
+      std::fprintf(stderr, "vector_bench: cannot write %s\n", vectors.c_str());
+      std::remove(temp_path.c_str());
+      return 1;
+    }
+  }
+
+  std::vector<float> rows;
+  if (!readF16(vectors, dim, rows)) {
+    std::fprintf(stderr, "vector_bench: %s is not f16 rows of dim %u\n", vectors.c_str(), dim);
+    if (!temp_path.empty()) std::remove(temp_path.c_str());
+    return 1;
+  }
+  const size_t n_rows = rows.size() / dim;
+
+  // The pack-time table, written the way pack_compile --sq8 does (from the f16 rows).
+  std::string sq8_path;
+  double sq8_build_ms = 0.0;
+  if (sq8) {
+    std::vector<uint16_t> f16(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) f16[i] = floatToHalf(rows[i]);
+    char tmpl[] = "/tmp/vector_bench_sq8_XXXXXX";
+    const int fd = mkstemp(tmpl);
+    if (fd >= 0) ::close(fd);
+    sq8_path = tmpl;
+    const auto t0 = std::chrono::steady_clock::now();
+    std::string sq8_error;
+    if (!piper::sq8WriteFile(sq8_path, f16.data(), n_rows, dim, &sq8_error)) {
+      std::fprintf(stderr, "vector_bench: cannot write %s: %s\n", sq8_path.c_str(), sq8_error.c_str());
+      if (!temp_path.empty()) std::remove(temp_path.c_str());
+      return 1;
+    }
+    sq8_build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (kernels.empty()) kernels.push_back(piper::sq8KernelName());
+  }
+
+  std::vector<float> queries;
+  if (!queries_path.empty()) {
+    if (!readF16(queries_path, dim, queries)) {
+      std::fprintf(stderr, "vector_bench: %s is not f16 rows of dim %u\n", queries_path.c_str(), dim);
+      if (!temp_path.empty()) std::remove(temp_path.c_str());
+      return 1;
+    }
+  } else {
+    std::mt19937 rng(42);
+    std::normal_distribution<float> gauss(0.f, 1.f);
+    num_queries = std::min(num_queries, n_rows);
+    queries.resize(num_queries * dim);
+    for (size_t q = 0; q < num_queries; ++q) {
+      const float* src = rows.data() + (q * n_rows / num_queries) * dim;
+      float ss = 0.f;
+      for (uint32_t d = 0; d < dim; ++d) ss += src[d] * src[d];
+      const float sigma = noise * std::sqrt(ss / dim);
+      for (uint32_t d = 0; d < dim; ++d) queries[q * dim + d] = src[d] + sigma * gauss(rng);
+    }
+  }
+  rows.clear();
+  rows.shrink_to_fit();
+
+  piper::SegmentedVectorIndex index;
+  piper::VectorIndexSpec spec;
+  spec.dim = dim;
+  spec.segments.push_back({"base", vectors, 0, ""});
+  spec.sq8_path = sq8_path;
+  piper::VectorIndexError err = piper::VectorIndexError::kNone;
+  if (!index.open(spec, &err)) {
+    std::fprintf(stderr, "vector_bench: open failed: %s\n", piper::vectorIndexErrorString(err));
+    if (!temp_path.empty()) std::remove(temp_path.c_str());
+    return 1;
+  }
+
+  double exact_us = 0.0;
+  const auto truth = runQueries(index, queries, dim, k, true, repeat, &exact_us);
+  std::printf("rows %zu  dim %u  queries %zu  k %zu  exact scan %.1f us/query (%zu bytes f16)\n\n", n_rows, dim,
+              queries.size() / dim, k, exact_us, n_rows * dim * sizeof(uint16_t));
+
+  std::vector<Result> results;
+  for (uint32_t prefix : prefixes) {
+    if (prefix == 0 || prefix >= dim) continue;
+    for (int q8 = 0; q8 <= (int8 ? 1 : 0); ++q8) {
+      for (uint32_t m : candidate_counts) {
+        Result r;
+        r.config.prefix = prefix;
+        r.config.candidates = m;
+        r.config.int8 = q8 == 1;
+        index.setCoarseSearch({prefix, m, q8 == 1});
+        const auto got = runQueries(index, queries, dim, k, false, repeat, &r.us_per_query);
+        r.recall = recallAt(truth, got);
+        r.speedup = r.us_per_query > 0.0 ? exact_us / r.us_per_query : 0.0;
+        r.coarse_bytes = index.stats().coarse_bytes;
+        results.push_back(r);
+      }
+    }
+  }
+  size_t sq8_table_rows = 0;
+  for (const std::string& kernel : kernels) {
+    if (!piper::sq8SetKernel(kernel)) {
+      std::printf("sq8 kernel %s: not available on this CPU\n", kernel.c_str());
+      continue;
+    }
+    for (uint32_t m : candidate_counts) {
+      Result r;
+      r.config.candidates = m;
+      r.config.sq8_kernel = kernel;
+      piper::CoarseSearchConfig config;
+      config.candidates = m;
+      config.sq8 = true;
+      index.setCoarseSearch(config);
+      const auto got = runQueries(index, queries, dim, k, false, repeat, &r.us_per_query);
+      r.recall = recallAt(truth, got);
+      r.speedup = r.us_per_query > 0.0 ? exact_us / r.us_per_query : 0.0;
+      r.coarse_bytes = index.stats().coarse_bytes;
+      sq8_table_rows = index.stats().sq8_table_rows;
+      results.push_back(r);
+    }
+  }
+  index.setCoarseSearch({});
+  if (sq8) {
+    std::printf("sq8 table %.1f ms to build, %zu of %zu rows used\n\n", sq8_build_ms, sq8_table_rows, n_rows);
+  }
+
+  std::printf("%7s %5s %6s %9s %10s %8s %11s\n", "prefix", "int8", "M", "recall@k", "us/query", "speedup",
+              "coarse_MB");
+  for (const Result& r : results) {
+    const std::string prefix = r.config.sq8_kernel.empty() ? std::to_string(r.config.prefix) : "sq8";
+    const char* int8_label = !r.config.sq8_kernel.empty() ? r.config.sq8_kernel.c_str() : r.config.int8 ? "yes" : "no";
+    std::printf("%7s %5s %6u %9.4f %10.1f %7.2fx %11.2f\n", prefix.c_str(), int8_label, r.config.candidates, r.recall,
+                r.us_per_query, r.speedup, r.coarse_bytes / 1048576.0);
+  }
+
+  // Recall against speed, fastest first: one bar per configuration (50 columns = recall 1.0).
+  std::vector<Result> chart = results;
+  std::sort(chart.begin(), chart.end(), [](const Result& a, const Result& b) { return a.speedup > b.speedup; });
+  std::printf("\nrecall@%zu vs speedup (| = exact scan recall 1.0)\n", k);
+  for (const Result& r : chart) {
+    char label[48];
+    if (!r.config.sq8_kernel.empty()) {
+      std::snprintf(label, sizeof(label), "sq8/%s M%u", r.config.sq8_kernel.c_str(), r.config.candidates);
+    } else {
+      std::snprintf(label, sizeof(label), "p%u%s M%u", r.config.prefix, r.config.int8 ? "/i8" : "",
+                    r.config.candidates);
+    }
+    const int bar = static_cast<int>(std::lround(r.recall * 50.0));
+    std::printf("%6.2fx %-16s %s%*s| %.3f\n", r.speedup, label, std::string(bar, '#').c_str(), 50 - bar, "",
+                r.recall);
+  }
+
+  if (!json_out.empty()) {
+    json report;
+    report["rows"] = n_rows;
+    report["dim"] = dim;
+    report["queries"] = queries.size() / dim;
+    report["k"] = k;
+    report["exact_us_per_query"] = exact_us;
+    if (sq8) report["sq8_build_ms"] = sq8_build_ms;
+    report["configs"] = json::array();
+    for (const Result& r : results) {
+      report["configs"].push_back({{"prefix_dims", r.config.prefix},
+                                   {"candidates", r.config.candidates},
+                                   {"int8", r.config.int8},
+                                   {"sq8_kernel", r.config.sq8_kernel},
+                                   {"recall", r.recall},
+                                   {"us_per_query", r.us_per_query},
+                                   {"speedup", r.speedup},
+                                   {"coarse_bytes", r.coarse_bytes}});
+    }
+    std::ofstream(json_out) << report.dump(2) << "\n";
+  }
+  if (!temp_path.empty()) std::remove(temp_path.c_str());
+  if (!sq8_path.empty()) std::remove(sq8_path.c_str());
+  return 0;
+}
@@ -0,0 +1,130 @@
+#ifndef PIPER_HOST_WAV_IO_H
+#define PIPER_HOST_WAV_IO_H
+
+// Minimal RIFF/WAVE reader/writer for the Linux host tools (fixtures, reports).
+// Reads PCM 16/24/32-bit and IEEE float32, any channel count (downmixed to mono).
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace piper_host {
+
+inline uint32_t readLe32(const unsigned char* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+inline uint16_t readLe16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+// Decode a WAV file to mono float samples in [-1, 1]. Returns false with a message in *error.
+inline bool readWav(const std::string& path, std::vector<float>& mono, int& sample_rate, std::string* error = nullptr) {
+  auto fail = [error](const char* msg) {
+    if (error) *error = msg;
+    return false;
+  };
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return fail("cannot open file");
+  std::vector<unsigned char> data;
+  unsigned char buf[1 << 16];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  std::fclose(f);
+  if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) != 0 || std::memcmp(data.data() + 8, "WAVE", 4) != 0)
+    return fail("not a RIFF/WAVE file");
+
+  uint16_t format = 0, channels = 0, bits = 0;
+  uint32_t rate = 0;
+  const unsigned char* pcm = nullptr;
+  size_t pcm_bytes = 0;
+  for (size_t pos = 12; pos + 8 <= data.size();) {
+    const uint32_t size = readLe32(&data[pos + 4]);
+    const unsigned char* body = &data[pos + 8];
+    const size_t avail = data.size() - pos - 8;
+    if (std::memcmp(&data[pos], "fmt ", 4) == 0 && size >= 16 && avail >= 16) {
+      format = readLe16(body);
+      channels = readLe16(body + 2);
+      rate = readLe32(body + 4);
+      bits = readLe16(body + 14);
+      if (format == 0xFFFE && size >= 26) format = readLe16(body + 24);  // WAVE_FORMAT_EXTENSIBLE
+    } else if (std::memcmp(&data[pos], "data", 4) == 0) {
+      pcm = body;
+      pcm_bytes = size < avail ? size : avail;
+    }
+    pos += 8 + size + (size & 1);
+  }
+  if (!pcm || !channels || !rate) return fail("missing fmt or data chunk");
+  const bool is_float = format == 3 && bits == 32;
+  if (!(format == 1 && (bits == 16 || bits == 24 || bits == 32)) && !is_float) return fail("unsupported sample format");
+
+  const size_t bytes_per_sample = bits / 8;
+  const size_t frames = pcm_bytes / (bytes_per_sample * channels);
+  mono.assign(frames, 0.0f);
+  for (size_t i = 0; i < frames; i++) {
+    float acc = 0.0f;
+    for (size_t c = 0; c < channels; c++) {
+      const unsigned char* s = pcm + (i * channels + c) * bytes_per_sample;
+      float v;
+      if (is_float) {
+        std::memcpy(&v, s, 4);
+      } else if (bits == 16) {
+        v = static_cast<int16_t>(readLe16(s)) / 32768.0f;
+      } else if (bits == 24) {
+        int32_t x = s[0] | (s[1] << 8) | (s[2] << 16);
+        if (x & 0x800000) x |= ~0xFFFFFF;
+        v = x / 8388608.0f;
+      } else {
+        v = static_cast<int32_t>(readLe32(s)) / 2147483648.0f;
+      }
+      acc += v;
+    }
+    mono[i] = acc / channels;
+  }
+  sample_rate = static_cast<int>(rate);
+  return true;
+}
+
+// Write mono int16 PCM.
+inline bool writeWav16(const std::string& path, const int16_t* samples, size_t count, int sample_rate) {
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  const uint32_t data_bytes = static_cast<uint32_t>(count * 2);
+  unsigned char h[44];
+  auto le32 = [](unsigned char* p, uint32_t v) {
+    p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = (v >> 24) & 0xFF;
+  };
+  auto le16 = [](unsigned char* p, uint16_t v) { p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; };
+  std::memcpy(h, "RIFF", 4);
+  le32(h + 4, 36 + data_bytes);
+  std::memcpy(h + 8, "WAVEfmt ", 8);
+  le32(h + 16, 16);
+  le16(h + 20, 1);
+  le16(h + 22, 1);
+  le32(h + 24, static_cast<uint32_t>(sample_rate));
+  le32(h + 28, static_cast<uint32_t>(sample_rate) * 2);
+  le16(h + 32, 2);
+  le16(h + 34, 16);
+  std::memcpy(h + 36, "data", 4);
+  le32(h + 40, data_bytes);
+  const bool ok = std::fwrite(h, 1, 44, f) == 44 && std::fwrite(samples, 2, count, f) == count;
+  std::fclose(f);
+  return ok;
+}
+
+// Linear-interpolation resample (fixture convenience only; the app front-end has its own resampler).
+inline std::vector<float> resampleLinear(const std::vector<float>& in, int from_rate, int to_rate) {
+  if (from_rate == to_rate || in.empty()) return in;
+  const double step = static_cast<double>(from_rate) / to_rate;
+  const size_t out_n = static_cast<size_t>(in.size() / step);
+  std::vector<float> out(out_n);
+  for (size_t i = 0; i < out_n; i++) {
+    const double pos = i * step;
+    const size_t k = static_cast<size_t>(pos);
+    const double frac = pos - k;
+    const float a = in[k], b = k + 1 < in.size() ? in[k + 1] : a;
+    out[i] = static_cast<float>(a + (b - a) * frac);
+  }
+  return out;
+}
+
+}  // namespace piper_host
+
+#endif  // PIPER_HOST_WAV_IO_H
@@ -5,7 +5,22 @@
 #import "PiperTts/PiperTts.h"
 #endif
 
+#if __has_include(<ReactCommon/RCTTurboModuleWithJSIBindings.h>)
+#import <ReactCommon/RCTTurboModuleWithJSIBindings.h>
+#define PIPER_HAS_JSI_BINDINGS 1
+#endif
+
+#import "asr_jsi.h"
+#import "embedding_jsi.h"
+#import "memory_stats_jsi.h"
+#import "pack_file_jsi.h"
+#import "pack_sync.h"
+#import "pack_table_jsi.h"
+#import "phoneme_memo_jsi.h"
 #import "piper_engine.h"
+#import "query_cache_jsi.h"
+#import "silence_trim_jsi.h"
+#import "vector_index_jsi.h"
 #include <algorithm>
 #include <cmath>
 #include <math.h>
@@ -347,6 +362,9 @@ PiperApplyLayer2DesyncFloatMono(AVAudioPCMBuffer *dry, NSDictionary *opts,
 }
 
 @interface PiperTtsModule ()
+#if PIPER_HAS_JSI_BINDINGS
+    <RCTTurboModuleWithJSIBindings>
+#endif
 @property(nonatomic, strong) AVAudioEngine *playbackEngine;
 @property(nonatomic, strong) AVAudioPlayerNode *playbackPlayer;
 /** Options set via setOptions(); used by the next speak(). Copy of the last
@@ -376,6 +394,30 @@ PiperApplyLayer2DesyncFloatMono(AVAudioPCMBuffer *dry, NSDictionary *opts,
 }
 #endif
 
+#if PIPER_HAS_JSI_BINDINGS
+/** Installs global.__piperEmbed (query embedding), __piperAsr* (streaming
+ * ASR), __piperQueryCache* (semantic query cache), __piperVectorIndex*
+ * (segmented vector index), __piperPackTable* (pack.bin rules/cards tables),
+ * __piperPhonemeMemo* (word-level phoneme memo) and
+ * __piperSynthesisMemoryStats when the TurboModule is created. */
+- (void)installJSIBindingsWithRuntime:(facebook::jsi::Runtime &)runtime {
+  piper::installEmbeddingJsi(runtime);
+  piper::installAsrJsi(runtime);
+  piper::installQueryCacheJsi(runtime);
+  piper::installMemoryStatsJsi(runtime);
+  piper::installVectorIndexJsi(runtime);
+  piper::installPackTableJsi(runtime);
+  piper::installPhonemeMemoJsi(runtime);
+  piper::installSilenceTrimJsi(runtime);
+  // Bundled pack files resolve against the main bundle (content_pack/... when the folder is a bundle resource).
+  const std::string resourceRoot([[[NSBundle mainBundle] resourcePath] UTF8String] ?: "");
+  piper::installPackFileJsi(
+      runtime, [resourceRoot](const std::string &path, std::string *error) {
+        return piper::mapPackFile(resourceRoot + "/" + path, error);
+      });
+}
+#endif
+
 + (NSString *)piperModelPathInBundle:(NSBundle *)bundle {
   NSString *path = [bundle pathForResource:@"model" ofType:@"onnx"];
   if (path.length) {
@@ -413,6 +455,32 @@ PiperApplyLayer2DesyncFloatMono(AVAudioPCMBuffer *dry, NSDictionary *opts,
   return path ?: @"";
 }
 
+// Pre-rendered canned lines bundled with the content pack (content_pack/audio/speech_pack.bin, built by
+// scripts/sync-pack-*.js). Loaded into the engine once; the engine then serves those lines from the mmap.
++ (NSString *)speechPackPathInBundle:(NSBundle *)bundle {
+  NSString *path = [bundle pathForResource:@"speech_pack"
+                                    ofType:@"bin"
+                               inDirectory:@"content_pack/audio"];
+  return path ?: @"";
+}
+
++ (void)loadSpeechPackOnce {
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    NSString *path =
+        [PiperTtsModule speechPackPathInBundle:[NSBundle mainBundle]];
+    if (!path.length)
+      return;
+    std::string error;
+    if (piper::setAudioPack([path UTF8String], &error))
+      RCTLogInfo(@"[PiperTts] speech pack loaded: %zu lines",
+                 piper::audioPackSize());
+    else
+      RCTLogWarn(@"[PiperTts] speech pack invalid (%s): %@", error.c_str(),
+                 path);
+  });
+}
+
 // Directory containing espeak-ng data (lang/, voices/; phontab if present). Run
 // scripts/download-espeak-ng-data.sh. CocoaPods may place resources under full
 // paths, so we search the bundle for a dir named "espeak-ng-data".
@@ -541,10 +609,10 @@ RCT_EXPORT_METHOD(stop) {
 - (void)speakOffMain:(NSString *)text
             resolver:(RCTPromiseResolveBlock)resolve
             rejecter:(RCTPromiseRejectBlock)reject {
+  [PiperTtsModule loadSpeechPackOnce];
   NSBundle *appBundle = [NSBundle mainBundle];
   NSString *modelPath = [PiperTtsModule piperModelPathInBundle:appBundle];
   NSString *configPath = [PiperTtsModule piperConfigPathInBundle:appBundle];
-  NSString *espeakDataPath = [PiperTtsModule espeakDataPathInBundle:appBundle];
 
   if (!modelPath.length || !configPath.length) {
     RCTLogError(
@@ -554,7 +622,11 @@ RCT_EXPORT_METHOD(stop) {
            @"Piper model not found. Run scripts/download-piper-voice.sh", nil);
     return;
   }
-  if (!espeakDataPath.length) {
+  // "phoneme_type": "text" voices map characters straight to ids; no espeak-ng data needed.
+  const bool needsEspeak = piper::voiceNeedsEspeak([configPath UTF8String]);
+  NSString *espeakDataPath =
+      needsEspeak ? [PiperTtsModule espeakDataPathInBundle:appBundle] : @"";
+  if (needsEspeak && !espeakDataPath.length) {
     RCTLogError(@"[PiperTts][E_NO_ESPEAK_DATA] espeak-ng-data not found. Run "
                 @"scripts/download-espeak-ng-data.sh");
     reject(@"E_NO_ESPEAK_DATA",
@@ -573,6 +645,7 @@ RCT_EXPORT_METHOD(stop) {
   std::vector<int16_t> pcm;
   int sample_rate = 0;
   piper::SynthesizeError synthError = piper::SynthesizeError::kNone;
+  piper::SynthesisMemoryReport memory;
 
   piper::SynthesizeOverrides overrides;
   bool useOverrides = false;
@@ -625,7 +698,8 @@ RCT_EXPORT_METHOD(stop) {
   }
 
   bool ok = piper::synthesize(model_path, config_path, espeak_path, text_utf8,
-                              pcm, sample_rate, &synthError, overridesPtr);
+                              pcm, sample_rate, &synthError, overridesPtr,
+                              &memory);
   if (!ok || pcm.empty() || sample_rate <= 0) {
     NSString *message = nil;
     switch (synthError) {
@@ -654,6 +728,9 @@ RCT_EXPORT_METHOD(stop) {
       message =
           @"ONNX inference returned no audio. Check model and phoneme ids.";
       break;
+    case piper::SynthesizeError::kCancelled:
+      message = @"Synthesis cancelled.";
+      break;
     case piper::SynthesizeError::kConfigOpenFailed:
       message = @"Piper config file could not be opened.";
       break;
@@ -690,6 +767,8 @@ RCT_EXPORT_METHOD(stop) {
   NSUInteger sampleCount = pcm.size();
   NSData *pcmData = [NSData dataWithBytes:pcm.data()
                                    length:sampleCount * sizeof(int16_t)];
+  memory.output_bytes = pcmData.length;
+  piper::recordSynthesisMemory(memory);
   double expectedDurationSec = (double)sampleCount / (double)sample_rate;
 
   self.lastAudioSampleCount = sampleCount;
@@ -977,6 +1056,16 @@ RCT_EXPORT_METHOD(stop) {
   }
 }
 
+/** JSI bindings are installed via RCTTurboModuleWithJSIBindings on iOS; kept for
+ * API parity with Android, where installJsi() performs the install. */
+RCT_EXPORT_BLOCKING_SYNCHRONOUS_METHOD(installJsi) {
+#if PIPER_HAS_JSI_BINDINGS
+  return @YES;
+#else
+  return @NO;
+#endif
+}
+
 RCT_EXPORT_METHOD(copyModelToFiles : (RCTPromiseResolveBlock)
                       resolve reject : (RCTPromiseRejectBlock)reject) {
   // On iOS the model is used from the bundle; no copy from assets. Resolve with
@@ -990,6 +1079,39 @@ RCT_EXPORT_METHOD(copyModelToFiles : (RCTPromiseResolveBlock)
   }
 }
 
+// Syncs the bundled RAG pack (content_pack in the app bundle) into Documents/content_pack, copying only
+// files whose pack_files.json hash changed (pack_sync.h). Resolves with the destination path; rejects
+// E_NO_PACK_MANIFEST when the bundled pack has no pack_files.json so JS can fall back to a full copy.
+RCT_EXPORT_METHOD(syncContentPack : (RCTPromiseResolveBlock)
+                      resolve reject : (RCTPromiseRejectBlock)reject) {
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+    NSString *source = [[NSBundle mainBundle].resourcePath
+        stringByAppendingPathComponent:@"content_pack"];
+    NSString *documents = NSSearchPathForDirectoriesInDomains(
+        NSDocumentDirectory, NSUserDomainMask, YES)
+                              .firstObject;
+    NSString *dest = [documents stringByAppendingPathComponent:@"content_pack"];
+    auto packSource = piper::directoryPackSource(source.UTF8String);
+    piper::PackSyncReport report;
+    piper::PackSyncError err = piper::PackSyncError::kNone;
+    if (!piper::syncPack(*packSource, dest.UTF8String, piper::PackSyncOptions{},
+                         &report, &err)) {
+      NSString *message =
+          [NSString stringWithUTF8String:piper::packSyncErrorString(err)];
+      if (!report.failed_path.empty()) {
+        message = [message
+            stringByAppendingFormat:@": %s", report.failed_path.c_str()];
+      }
+      reject(err == piper::PackSyncError::kManifestMissing
+                 ? @"E_NO_PACK_MANIFEST"
+                 : @"E_PACK_SYNC",
+             message, nil);
+      return;
+    }
+    resolve(dest);
+  });
+}
+
 RCT_EXPORT_METHOD(isModelAvailable : (RCTPromiseResolveBlock)
                       resolve reject : (RCTPromiseRejectBlock)reject) {
   NSString *modelPath =
@@ -1035,6 +1157,12 @@ RCT_EXPORT_METHOD(getDebugInfo : (RCTPromiseResolveBlock)
                                            espeakPath.length ? espeakPath
                                                              : @"(not found)"]];
 
+  NSString *speechPack = [PiperTtsModule speechPackPathInBundle:main];
+  [lines addObject:[NSString stringWithFormat:@"speech pack: %@ (%zu lines loaded)",
+                                              speechPack.length ? speechPack
+                                                                : @"(not found)",
+                                              piper::audioPackSize()]];
+
   NSArray *onnxInRoot = [main pathsForResourcesOfType:@"onnx" inDirectory:nil];
   [lines
       addObject:[NSString
@@ -1123,6 +1251,41 @@ RCT_EXPORT_METHOD(getDebugInfo : (RCTPromiseResolveBlock)
                                      (unsigned)self.lastBufferFrameLength,
                                      self.lastBufferFormatSampleRate]];
 
+  piper::SynthesisMemoryStats mem = piper::synthesisMemoryStats();
+  [lines addObject:@"--- Synthesis memory (bytes; last / max over requests) ---"];
+  [lines addObject:[NSString stringWithFormat:
+                                 @"requests=%llu phonemes=%zu/%zu "
+                                 @"espeakRss=%zu/%zu ortPeak=%zu/%zu "
+                                 @"ortLive=%zu float=%zu/%zu pcm=%zu/%zu "
+                                 @"scratch=%zu/%zu scratchMallocs=%zu/%zu "
+                                 @"nsdata=%zu/%zu rssPeakDelta=%zu/%zu",
+                                 (unsigned long long)mem.requests,
+                                 mem.last.phoneme_bytes, mem.max.phoneme_bytes,
+                                 mem.last.espeak_rss_delta,
+                                 mem.max.espeak_rss_delta,
+                                 mem.last.ort_peak_bytes,
+                                 mem.max.ort_peak_bytes,
+                                 mem.last.ort_live_bytes,
+                                 mem.last.float_audio_bytes,
+                                 mem.max.float_audio_bytes, mem.last.pcm_bytes,
+                                 mem.max.pcm_bytes, mem.last.scratch_bytes,
+                                 mem.max.scratch_bytes,
+                                 mem.last.scratch_block_mallocs,
+                                 mem.max.scratch_block_mallocs,
+                                 mem.last.output_bytes,
+                                 mem.max.output_bytes, mem.last.rss_peak_delta,
+                                 mem.max.rss_peak_delta]];
+  for (const piper::SynthesisSessionStats &pool : piper::synthesisSessionStats()) {
+    [lines addObject:[NSString stringWithFormat:
+                                   @"sessions %s: replicas=%zu sharedInit=%zu "
+                                   @"sharedWeights=%zu firstReplica=%zu perReplica=%zu",
+                                   pool.model_path.c_str(), pool.replicas,
+                                   pool.shared_initializers,
+                                   pool.shared_weight_bytes,
+                                   pool.first_replica_bytes,
+                                   pool.replica_overhead_bytes]];
+  }
+
   resolve([lines componentsJoinedByString:@"\n"]);
 }
 
@@ -0,0 +1,145 @@
+#include "asr_jsi.h"
+#include "capture_frontend.h"
+#include "streaming_asr.h"
+#include <jsi/jsi.h>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+namespace {
+
+std::mutex g_asr_mutex;
+StreamingRecognizer g_recognizer;
+// Device-rate capture path (start options); off when feeds are already 16 kHz.
+CaptureFrontEnd g_frontend;
+bool g_frontend_on = false;
+std::vector<int16_t> g_frontend_out;
+
+void throwAsr(jsi::Runtime& rt, const char* what, AsrError err) {
+  throw jsi::JSError(rt, std::string(what) + ": " + asrErrorToString(err));
+}
+
+// Applies __piperAsrStart options. A config equal to the running one keeps the AGC gain and noise estimate
+// from the previous utterance.
+void startFrontEnd(jsi::Runtime& rt, const jsi::Value* options) {
+  if (!options || !options->isObject()) {
+    g_frontend_on = false;
+    return;
+  }
+  jsi::Object o = options->getObject(rt);
+  CaptureFrontEndConfig config;
+  config.output_rate = g_recognizer.sampleRate();
+  config.input_rate = config.output_rate;
+  const jsi::Value rate = o.getProperty(rt, "inputSampleRate");
+  if (rate.isNumber()) config.input_rate = static_cast<int>(rate.getNumber());
+  const jsi::Value hp = o.getProperty(rt, "highPassHz");
+  if (hp.isNumber()) config.high_pass_hz = static_cast<float>(hp.getNumber());
+  const jsi::Value ns = o.getProperty(rt, "noiseSuppression");
+  if (ns.isBool()) config.noise_suppression = ns.getBool();
+  const jsi::Value agc = o.getProperty(rt, "agc");
+  if (agc.isBool()) config.agc = agc.getBool();
+  const jsi::Value target = o.getProperty(rt, "agcTargetDbfs");
+  if (target.isNumber()) config.agc_target_dbfs = static_cast<float>(target.getNumber());
+  const CaptureFrontEndConfig& cur = g_frontend.config();
+  const bool same = g_frontend_on && cur.input_rate == config.input_rate && cur.output_rate == config.output_rate &&
+                    cur.high_pass_hz == config.high_pass_hz && cur.noise_suppression == config.noise_suppression &&
+                    cur.agc == config.agc && cur.agc_target_dbfs == config.agc_target_dbfs;
+  if (same) {
+    g_frontend.reset(false);
+  } else if (!g_frontend.configure(config)) {
+    g_frontend_on = false;
+    throw jsi::JSError(rt, "__piperAsrStart: unsupported inputSampleRate " + std::to_string(config.input_rate));
+  }
+  g_frontend_on = true;
+  g_frontend_out.resize(g_frontend.maxOutput(static_cast<size_t>(config.input_rate) / 10));
+}
+
+}  // namespace
+
+void installAsrJsi(jsi::Runtime& runtime) {
+  auto start = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperAsrStart"), 4,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 3 || !args[0].isString() || !args[1].isString() || !args[2].isString()) {
+          throw jsi::JSError(rt, "__piperAsrStart(modelPath, tokensPath, configPath): expected strings");
+        }
+        const std::string model_path = args[0].getString(rt).utf8(rt);
+        std::lock_guard<std::mutex> lock(g_asr_mutex);
+        if (g_recognizer.loaded() && g_recognizer.modelPath() == model_path) {
+          g_recognizer.reset();
+        } else {
+          AsrError err = AsrError::kNone;
+          if (!g_recognizer.load(model_path, args[1].getString(rt).utf8(rt), args[2].getString(rt).utf8(rt), &err)) {
+            throwAsr(rt, "ASR load failed", err);
+          }
+        }
+        startFrontEnd(rt, count > 3 ? args + 3 : nullptr);
+        return jsi::Value(true);
+      });
+
+  auto feed = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperAsrFeed"), 1,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 1 || !args[0].isObject() || !args[0].getObject(rt).isArrayBuffer(rt)) {
+          throw jsi::JSError(rt, "__piperAsrFeed(pcm16: ArrayBuffer): expected ArrayBuffer");
+        }
+        jsi::ArrayBuffer buffer = args[0].getObject(rt).getArrayBuffer(rt);
+        const auto* samples = reinterpret_cast<const int16_t*>(buffer.data(rt));
+        const size_t n = buffer.size(rt) / sizeof(int16_t);
+        std::lock_guard<std::mutex> lock(g_asr_mutex);
+        AsrError err = AsrError::kNone;
+        if (g_frontend_on) {
+          if (g_frontend_out.size() < g_frontend.maxOutput(n)) g_frontend_out.resize(g_frontend.maxOutput(n));
+          const size_t out = g_frontend.process(samples, n, g_frontend_out.data());
+          if (!g_recognizer.acceptPcm16(g_frontend_out.data(), out, &err)) throwAsr(rt, "ASR feed failed", err);
+        } else if (!g_recognizer.acceptPcm16(samples, n, &err)) {
+          throwAsr(rt, "ASR feed failed", err);
+        }
+        return jsi::String::createFromUtf8(rt, g_recognizer.partial());
+      });
+
+  auto finish = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperAsrFinish"), 0,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value*, size_t) -> jsi::Value {
+        std::lock_guard<std::mutex> lock(g_asr_mutex);
+        AsrError err = AsrError::kNone;
+        if (g_frontend_on) {
+          if (g_frontend_out.size() < g_frontend.maxOutput(0)) g_frontend_out.resize(g_frontend.maxOutput(0));
+          const size_t out = g_frontend.flush(g_frontend_out.data());
+          if (!g_recognizer.acceptPcm16(g_frontend_out.data(), out, &err)) throwAsr(rt, "ASR finish failed", err);
+        }
+        const std::string text = g_recognizer.finish(&err);
+        if (err != AsrError::kNone) throwAsr(rt, "ASR finish failed", err);
+        const AsrStats& s = g_recognizer.stats();
+        jsi::Object result(rt);
+        result.setProperty(rt, "text", jsi::String::createFromUtf8(rt, text));
+        result.setProperty(rt, "audioSec", s.audio_sec);
+        result.setProperty(rt, "featureSec", s.feature_sec);
+        result.setProperty(rt, "inferenceSec", s.inference_sec);
+        result.setProperty(rt, "rtf", s.audio_sec > 0.0 ? (s.feature_sec + s.inference_sec) / s.audio_sec : 0.0);
+        result.setProperty(rt, "firstPartialAudioSec", s.first_partial_audio_sec);
+        if (g_frontend_on) {
+          const CaptureFrontEndStats& f = g_frontend.stats();
+          jsi::Object fe(rt);
+          fe.setProperty(rt, "frames", static_cast<double>(f.frames));
+          fe.setProperty(rt, "meanFrameUs", f.meanFrameUs());
+          fe.setProperty(rt, "maxFrameUs", f.max_frame_us);
+          fe.setProperty(rt, "agcGainDb", static_cast<double>(f.agc_gain_db));
+          fe.setProperty(rt, "noiseDbfs", static_cast<double>(f.noise_dbfs));
+          fe.setProperty(rt, "speechFrames", static_cast<double>(f.speech_frames));
+          result.setProperty(rt, "frontEnd", std::move(fe));
+        }
+        return result;
+      });
+
+  runtime.global().setProperty(runtime, "__piperAsrStart", std::move(start));
+  runtime.global().setProperty(runtime, "__piperAsrFeed", std::move(feed));
+  runtime.global().setProperty(runtime, "__piperAsrFinish", std::move(finish));
+}
+
+}  // namespace piper
@@ -0,0 +1,28 @@
+#ifndef ASR_JSI_H
+#define ASR_JSI_H
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+}
+}  // namespace facebook
+
+namespace piper {
+
+// Install the streaming ASR host functions (one process-wide stream, synchronous on the JS thread). This is
+// a library surface: the caller supplies the PCM. Nothing feeds it from the native mic (atlas-native-mic and
+// its pre-roll ring live in a separate plugin with no native link to this one), and each feed runs the
+// front-end and any due CTC chunk on the calling thread, so feed small buffers or call it off the UI path.
+//   __piperAsrStart(modelPath, tokensPath, configPath, options?) -> true   (reuses the session if the model is
+//     unchanged). options { inputSampleRate?, highPassHz?, noiseSuppression?, agc?, agcTargetDbfs? } routes the
+//     feeds through the capture front-end (capture_frontend.h): device-rate mic PCM in, resampled, high-passed,
+//     noise-suppressed and gain-controlled 16 kHz to the model. Without options feeds go to the model as is.
+//   __piperAsrFeed(pcm16: ArrayBuffer) -> partial hypothesis string (mono int16 LE; 16 kHz without options)
+//   __piperAsrFinish() -> { text, audioSec, featureSec, inferenceSec, rtf, firstPartialAudioSec,
+//                           frontEnd?: { frames, meanFrameUs, maxFrameUs, agcGainDb, noiseDbfs, speechFrames } }
+// Errors throw a JS Error with the AsrError string.
+void installAsrJsi(facebook::jsi::Runtime& runtime);
+
+}  // namespace piper
+
+#endif  // ASR_JSI_H
@@ -0,0 +1,289 @@
+#include "audio_pack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace piper {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'I', 'P', 'E', 'R', 'A', 'P', '1'};
+constexpr uint32_t kVersion = 2;
+constexpr size_t kHeaderSize = 48;
+constexpr size_t kEntrySize = 32;
+
+uint32_t readU32(const unsigned char* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t readU64(const unsigned char* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+void appendU32(std::vector<unsigned char>& out, uint32_t v) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(&v);
+  out.insert(out.end(), p, p + sizeof(v));
+}
+
+void appendU64(std::vector<unsigned char>& out, uint64_t v) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(&v);
+  out.insert(out.end(), p, p + sizeof(v));
+}
+
+uint64_t fnv1a64(const void* data, size_t n, uint64_t h = 1469598103934665603ull) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < n; ++i) {
+    h ^= p[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+}  // namespace
+
+std::string canonicalUtteranceText(const std::string& text) {
+  std::string out;
+  out.reserve(text.size());
+  bool pending_space = false;
+  for (char c : text) {
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v') {
+      pending_space = !out.empty();
+      continue;
+    }
+    if (pending_space) out += ' ';
+    pending_space = false;
+    out += c;
+  }
+  return out;
+}
+
+uint64_t utteranceTextHash(const std::string& canonical) {
+  return fnv1a64(canonical.data(), canonical.size());
+}
+
+uint64_t voiceIdentityKey(const std::string& config_bytes, uint64_t model_hash) {
+  return fnv1a64(&model_hash, sizeof(model_hash), fnv1a64(config_bytes.data(), config_bytes.size()));
+}
+
+bool modelContentHash(const std::string& model_path, uint64_t* hash) {
+  struct CachedHash {
+    off_t size;
+    int64_t mtime_ns;
+    uint64_t hash;
+  };
+  static std::mutex mutex;
+  static std::map<std::string, CachedHash> cache;
+
+  const int fd = ::open(model_path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+#ifdef __APPLE__
+  const int64_t mtime_ns = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+  const int64_t mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(model_path);
+    if (it != cache.end() && it->second.size == st.st_size && it->second.mtime_ns == mtime_ns) {
+      ::close(fd);
+      if (hash) *hash = it->second.hash;
+      return true;
+    }
+  }
+  uint64_t h = fnv1a64(nullptr, 0);
+  if (st.st_size > 0) {
+    void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    madvise(map, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    h = fnv1a64(map, static_cast<size_t>(st.st_size));
+    munmap(map, static_cast<size_t>(st.st_size));
+  }
+  ::close(fd);
+  std::lock_guard<std::mutex> lock(mutex);
+  cache[model_path] = {st.st_size, mtime_ns, h};
+  if (hash) *hash = h;
+  return true;
+}
+
+bool voiceIdentityKeyForFiles(const std::string& model_path, const std::string& config_path, uint64_t* key) {
+  std::ifstream config(config_path, std::ios::binary);
+  uint64_t model_hash = 0;
+  if (!config || !modelContentHash(model_path, &model_hash)) return false;
+  const std::string config_bytes((std::istreambuf_iterator<char>(config)), std::istreambuf_iterator<char>());
+  if (key) *key = voiceIdentityKey(config_bytes, model_hash);
+  return true;
+}
+
+AudioPack::~AudioPack() {
+  close();
+}
+
+bool AudioPack::open(const std::string& path, std::string* error) {
+  close();
+  auto fail = [this, error](const char* msg) {
+    if (error) *error = msg;
+    close();
+    return false;
+  };
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return fail("cannot open file");
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize)) {
+    ::close(fd);
+    return fail("file too small");
+  }
+  void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) return fail("mmap failed");
+  base_ = static_cast<const unsigned char*>(map);
+  length_ = static_cast<size_t>(st.st_size);
+
+  if (std::memcmp(base_, kMagic, sizeof(kMagic)) != 0) return fail("bad magic");
+  if (readU32(base_ + 8) != kVersion) return fail("unsupported version");
+  sample_rate_ = static_cast<int>(readU32(base_ + 12));
+  voice_key_ = readU64(base_ + 16);
+  entry_count_ = readU32(base_ + 24);
+  const uint64_t strings_offset = readU64(base_ + 32);
+  const uint64_t pcm_offset = readU64(base_ + 40);
+  if (kHeaderSize + entry_count_ * kEntrySize > strings_offset || strings_offset > pcm_offset ||
+      pcm_offset > length_)
+    return fail("bad section offsets");
+  entries_ = base_ + kHeaderSize;
+  strings_ = base_ + strings_offset;
+  strings_len_ = static_cast<size_t>(pcm_offset - strings_offset);
+  for (size_t i = 0; i < entry_count_; ++i) {
+    const unsigned char* e = entries_ + i * kEntrySize;
+    const uint64_t off = readU64(e + 8);
+    const uint64_t bytes = uint64_t(readU32(e + 16)) * sizeof(int16_t);
+    if (off < pcm_offset || off % sizeof(int16_t) != 0 || off + bytes > length_) return fail("entry out of bounds");
+    if (uint64_t(readU32(e + 20)) + readU32(e + 24) > strings_len_) return fail("entry text out of bounds");
+  }
+  return true;
+}
+
+void AudioPack::close() {
+  if (base_) munmap(const_cast<unsigned char*>(base_), length_);
+  base_ = nullptr;
+  length_ = 0;
+  sample_rate_ = 0;
+  voice_key_ = 0;
+  entry_count_ = 0;
+  entries_ = nullptr;
+  strings_ = nullptr;
+  strings_len_ = 0;
+}
+
+bool AudioPack::find(const std::string& canonical_text, const int16_t** pcm, size_t* samples) const {
+  if (!base_ || entry_count_ == 0) return false;
+  const uint64_t hash = utteranceTextHash(canonical_text);
+  size_t lo = 0, hi = entry_count_;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (readU64(entries_ + mid * kEntrySize) < hash) lo = mid + 1;
+    else hi = mid;
+  }
+  for (size_t i = lo; i < entry_count_; ++i) {
+    const unsigned char* e = entries_ + i * kEntrySize;
+    if (readU64(e) != hash) break;
+    const uint32_t text_len = readU32(e + 24);
+    if (text_len != canonical_text.size() ||
+        std::memcmp(strings_ + readU32(e + 20), canonical_text.data(), text_len) != 0)
+      continue;
+    if (pcm) *pcm = reinterpret_cast<const int16_t*>(base_ + readU64(e + 8));
+    if (samples) *samples = readU32(e + 16);
+    return true;
+  }
+  return false;
+}
+
+bool writeAudioPack(const std::string& path, int sample_rate, uint64_t voice_key,
+                    const std::vector<AudioPackLine>& lines, std::string* error) {
+  struct Item {
+    uint64_t hash;
+    std::string text;
+    const std::vector<int16_t>* pcm;
+  };
+  std::vector<Item> items;
+  items.reserve(lines.size());
+  for (const AudioPackLine& line : lines) {
+    std::string text = canonicalUtteranceText(line.text);
+    if (text.empty() || line.pcm.empty()) continue;
+    bool dup = false;
+    for (const Item& it : items) {
+      if (it.text == text) {
+        dup = true;
+        break;
+      }
+    }
+    if (dup) continue;
+    items.push_back({utteranceTextHash(text), std::move(text), &line.pcm});
+  }
+  std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.hash < b.hash; });
+
+  std::string strings;
+  for (const Item& it : items) strings += it.text;
+  const uint64_t strings_offset = kHeaderSize + items.size() * kEntrySize;
+  const uint64_t pcm_offset = (strings_offset + strings.size() + 15) & ~uint64_t(15);
+
+  std::vector<unsigned char> out;
+  out.insert(out.end(), kMagic, kMagic + sizeof(kMagic));
+  appendU32(out, kVersion);
+  appendU32(out, static_cast<uint32_t>(sample_rate));
+  appendU64(out, voice_key);
+  appendU32(out, static_cast<uint32_t>(items.size()));
+  appendU32(out, 0);
+  appendU64(out, strings_offset);
+  appendU64(out, pcm_offset);
+  uint64_t pcm_cursor = pcm_offset;
+  uint32_t text_cursor = 0;
+  for (const Item& it : items) {
+    appendU64(out, it.hash);
+    appendU64(out, pcm_cursor);
+    appendU32(out, static_cast<uint32_t>(it.pcm->size()));
+    appendU32(out, text_cursor);
+    appendU32(out, static_cast<uint32_t>(it.text.size()));
+    appendU32(out, 0);
+    pcm_cursor += it.pcm->size() * sizeof(int16_t);
+    text_cursor += static_cast<uint32_t>(it.text.size());
+  }
+  out.insert(out.end(), strings.begin(), strings.end());
+  out.resize(pcm_offset, 0);
+  for (const Item& it : items) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(it.pcm->data());
+    out.insert(out.end(), p, p + it.pcm->size() * sizeof(int16_t));
+  }
+
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) {
+    if (error) *error = "cannot open output";
+    return false;
+  }
+  const bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+  if (std::fclose(f) != 0 || !ok) {
+    if (error) *error = "write failed";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace piper
@@ -0,0 +1,80 @@
+#ifndef AUDIO_PACK_H
+#define AUDIO_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace piper {
+
+// Pre-rendered audio for canned app lines (onboarding, errors, clarification prompts, section intros),
+// built on the host with the same piper::synthesize and bundled with the content pack. The engine
+// consults it by canonical text hash before synthesizing; a hit is one read from the mmapped file.
+//
+// File layout (little-endian, as on every target):
+//   header  magic "PIPERAP1", u32 version (2: voice_key hashes the model contents), u32 sample_rate, u64 voice_key, u32 entry_count, u32 reserved,
+//           u64 strings_offset, u64 pcm_offset
+//   entries entry_count x { u64 text_hash, u64 pcm_offset, u32 samples, u32 text_offset, u32 text_len,
+//           u32 reserved }, sorted by text_hash
+//   strings canonical texts (collision check), then int16 mono PCM.
+
+// Trim and collapse whitespace runs to one space; the key both host and device hash.
+std::string canonicalUtteranceText(const std::string& text);
+
+// FNV-1a 64 of canonical text.
+uint64_t utteranceTextHash(const std::string& canonical);
+
+// Identity of the voice a pack was rendered with: config bytes plus modelContentHash. A pack whose key
+// differs from the active voice is ignored.
+uint64_t voiceIdentityKey(const std::string& config_bytes, uint64_t model_hash);
+
+// FNV-1a 64 of the model file's bytes. Cached per path, size and mtime, so only the first call for a model
+// reads it (~60 MB for a medium voice). False if the file cannot be mapped.
+bool modelContentHash(const std::string& model_path, uint64_t* hash);
+
+// voiceIdentityKey from the files on disk (host tools). False if either file cannot be read.
+bool voiceIdentityKeyForFiles(const std::string& model_path, const std::string& config_path, uint64_t* key);
+
+class AudioPack {
+ public:
+  AudioPack() = default;
+  ~AudioPack();
+  AudioPack(const AudioPack&) = delete;
+  AudioPack& operator=(const AudioPack&) = delete;
+
+  // mmaps the file and validates the header and entry bounds. False with a message in *error.
+  bool open(const std::string& path, std::string* error = nullptr);
+  void close();
+  bool isOpen() const { return base_ != nullptr; }
+
+  int sampleRate() const { return sample_rate_; }
+  uint64_t voiceKey() const { return voice_key_; }
+  size_t size() const { return entry_count_; }
+
+  // PCM for canonical text; points into the mapping, valid until close().
+  bool find(const std::string& canonical_text, const int16_t** pcm, size_t* samples) const;
+
+ private:
+  const unsigned char* base_ = nullptr;
+  size_t length_ = 0;
+  int sample_rate_ = 0;
+  uint64_t voice_key_ = 0;
+  size_t entry_count_ = 0;
+  const unsigned char* entries_ = nullptr;
+  const unsigned char* strings_ = nullptr;
+  size_t strings_len_ = 0;
+};
+
+struct AudioPackLine {
+  std::string text;  // canonicalized by writeAudioPack
+  std::vector<int16_t> pcm;
+};
+
+// Host side. Duplicate canonical texts keep the first. False with a message in *error.
+bool writeAudioPack(const std::string& path, int sample_rate, uint64_t voice_key,
+                    const std::vector<AudioPackLine>& lines, std::string* error = nullptr);
+
+}  // namespace piper
+
+#endif  // AUDIO_PACK_H
@@ -0,0 +1,424 @@
+#include "capture_frontend.h"
+#include "simd_f32.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace piper {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kStopbandDb = 70.0;
+constexpr size_t kBlock = 480;     // int16 / flush conversion block (10 ms at 48 kHz)
+constexpr size_t kMinSlots = 6;    // noise minimum over kMinSlots * kMinSlotFrames frames (1.5 s)
+constexpr size_t kMinSlotFrames = 25;
+constexpr float kMinBias = 1.6f;   // minimum of a smoothed periodogram underestimates the mean
+constexpr float kLimit = 0.97f;    // AGC output peak
+
+size_t nextPow2(size_t n) {
+  size_t p = 8;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+double besselI0(double x) {
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; k < 50; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-12) break;
+  }
+  return sum;
+}
+
+float dbToGain(float db) { return std::pow(10.0f, db / 20.0f); }
+
+double nowUs() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+CaptureFrontEnd::CaptureFrontEnd(const CaptureFrontEndConfig& config) : fft_(256) {
+  if (!configure(config)) {
+    CaptureFrontEndConfig fallback;
+    configure(fallback);
+  }
+}
+
+bool CaptureFrontEnd::configure(const CaptureFrontEndConfig& config) {
+  if (config.input_rate < 8000 || config.input_rate > 192000 || config.output_rate < 8000 ||
+      config.output_rate > 48000 || config.output_rate % 100 != 0)
+    return false;
+  config_ = config;
+  frame_ = static_cast<size_t>(config_.output_rate / 100);
+
+  // Resampler: rational up/down, prototype designed at input_rate * up.
+  const uint32_t g = static_cast<uint32_t>(std::gcd(config_.input_rate, config_.output_rate));
+  up_ = static_cast<uint32_t>(config_.output_rate) / g;
+  down_ = static_cast<uint32_t>(config_.input_rate) / g;
+  resample_ = up_ != down_;
+  size_t resampler_delay = 0;
+  if (resample_) {
+    // Passband to 85% of the lower Nyquist, stopband from 100%, so nothing aliases into the passband.
+    const double nyquist = 0.5 * std::min(config_.input_rate, config_.output_rate);
+    const double transition = 0.15 * nyquist;
+    const double cutoff = 0.925 * nyquist;
+    const double taps_at_input =
+        (kStopbandDb - 8.0) / (2.285 * 2.0 * kPi * transition / static_cast<double>(config_.input_rate));
+    taps_ = (static_cast<size_t>(std::ceil(taps_at_input)) + 3) / 4 * 4;
+    const size_t n = taps_ * up_;
+    const double fc = cutoff / (static_cast<double>(config_.input_rate) * up_);  // cycles per prototype sample
+    const double beta = 0.1102 * (kStopbandDb - 8.7);
+    // Center on a whole number of output samples (a multiple of down) so the delay compensation is exact;
+    // the prototype is 2 * center + 1 long and the rest of the n slots stay zero.
+    const size_t center = (n - 1) / 2 / down_ * down_;
+    const double i0_beta = besselI0(beta);
+    std::vector<double> h(n, 0.0);
+    double sum = 0.0;
+    for (size_t i = 0; i <= 2 * center; i++) {
+      const double t = static_cast<double>(i) - static_cast<double>(center);
+      const double sinc = t == 0.0 ? 2.0 * fc : std::sin(2.0 * kPi * fc * t) / (kPi * t);
+      const double r = t / static_cast<double>(center);
+      h[i] = sinc * besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+      sum += h[i];
+    }
+    // Each polyphase branch sums to ~1 (unity passband gain).
+    coeffs_.assign(static_cast<size_t>(up_) * taps_, 0.0f);
+    for (uint32_t p = 0; p < up_; p++) {
+      for (size_t k = 0; k < taps_; k++) {
+        coeffs_[p * taps_ + (taps_ - 1 - k)] = static_cast<float>(h[p + k * up_] * up_ / sum);
+      }
+    }
+    history_.assign(2 * taps_, 0.0f);
+    resampler_delay = center / down_;
+  } else {
+    taps_ = 0;
+    coeffs_.clear();
+    history_.clear();
+  }
+
+  high_pass_ = config_.high_pass_hz > 0.0f && config_.high_pass_hz < 0.45f * config_.output_rate;
+  if (high_pass_) {
+    // RBJ cookbook high-pass, Q = 1/sqrt(2).
+    const double w0 = 2.0 * kPi * config_.high_pass_hz / config_.output_rate;
+    const double alpha = std::sin(w0) / (2.0 * std::sqrt(0.5));
+    const double cw = std::cos(w0);
+    const double a0 = 1.0 + alpha;
+    hp_b0_ = static_cast<float>((1.0 + cw) / 2.0 / a0);
+    hp_b1_ = static_cast<float>(-(1.0 + cw) / a0);
+    hp_b2_ = hp_b0_;
+    hp_a1_ = static_cast<float>(-2.0 * cw / a0);
+    hp_a2_ = static_cast<float>((1.0 - alpha) / a0);
+  }
+
+  // Suppressor window: sine rise over overlap_, flat, cosine fall over overlap_, so the squared windows of
+  // consecutive frames sum to 1.
+  const size_t fft_size = nextPow2(frame_ + frame_ / 2);
+  overlap_ = std::min(fft_size - frame_, frame_);
+  fft_ = RealFft(fft_size);
+  window_.assign(frame_ + overlap_, 1.0f);
+  for (size_t i = 0; i < overlap_; i++) {
+    const double a = 0.5 * kPi * (static_cast<double>(i) + 0.5) / static_cast<double>(overlap_);
+    window_[i] = static_cast<float>(std::sin(a));
+    window_[frame_ + i] = static_cast<float>(std::cos(a));
+  }
+  const size_t bins = fft_.bins();
+  ns_in_.assign(frame_ + overlap_, 0.0f);
+  ns_buf_.assign(fft_size, 0.0f);
+  ns_re_.assign(bins, 0.0f);
+  ns_im_.assign(bins, 0.0f);
+  ns_tail_.assign(overlap_, 0.0f);
+  smooth_.assign(bins, 0.0f);
+  noise_.assign(bins, 0.0f);
+  prev_clean_.assign(bins, 0.0f);
+  min_slots_.assign(kMinSlots * bins, 0.0f);
+  min_cur_.assign(bins, 0.0f);
+  ns_gain_floor_ = dbToGain(-std::fabs(config_.ns_max_attenuation_db));
+
+  latency_ = resampler_delay + (config_.noise_suppression ? overlap_ : 0);
+  frame_buf_.assign(frame_, 0.0f);
+  scratch_in_.assign(kBlock, 0.0f);
+  zeros_.assign(kBlock, 0.0f);
+  scratch_out_.assign(maxOutput(kBlock), 0.0f);
+  reset(true);
+  return true;
+}
+
+size_t CaptureFrontEnd::maxOutput(size_t input_count) const {
+  const uint64_t resampled = (static_cast<uint64_t>(input_count) * up_ + down_ - 1) / down_ + 1;
+  return static_cast<size_t>(resampled) + latency_ + 2 * frame_;
+}
+
+void CaptureFrontEnd::clearStream() {
+  std::fill(history_.begin(), history_.end(), 0.0f);
+  hist_pos_ = 0;
+  in_count_ = out_count_ = next_in_ = 0;
+  phase_ = 0;
+  frame_fill_ = 0;
+  skip_ = latency_;
+  emitted_ = 0;
+  limit_ = UINT64_MAX;
+  hp_z1_ = hp_z2_ = 0.0f;
+  std::fill(ns_in_.begin(), ns_in_.end(), 0.0f);
+  std::fill(ns_tail_.begin(), ns_tail_.end(), 0.0f);
+  std::fill(prev_clean_.begin(), prev_clean_.end(), 0.0f);
+  pending_us_ = 0.0;
+}
+
+void CaptureFrontEnd::reset(bool reset_adaptation) {
+  clearStream();
+  if (reset_adaptation) {
+    std::fill(smooth_.begin(), smooth_.end(), 0.0f);
+    std::fill(noise_.begin(), noise_.end(), 0.0f);
+    std::fill(min_slots_.begin(), min_slots_.end(), 0.0f);
+    std::fill(min_cur_.begin(), min_cur_.end(), 0.0f);
+    min_frames_ = min_slot_ = 0;
+    ns_frames_ = 0;
+    agc_gain_db_ = 0.0f;
+    agc_gain_ = 1.0f;
+    agc_level_db_ = -120.0f;
+    agc_noise_ = 0.0f;
+  }
+  stats_ = CaptureFrontEndStats();
+  stats_.agc_gain_db = agc_gain_db_;
+}
+
+void CaptureFrontEnd::recordCost(double us, uint64_t frames_before) {
+  pending_us_ += us;
+  const uint64_t produced = stats_.frames - frames_before;
+  if (produced == 0) return;
+  stats_.total_us += pending_us_;
+  stats_.max_frame_us = std::max(stats_.max_frame_us, pending_us_ / static_cast<double>(produced));
+  pending_us_ = 0.0;
+}
+
+size_t CaptureFrontEnd::process(const float* in, size_t count, float* out) {
+  const double t0 = nowUs();
+  const uint64_t frames_before = stats_.frames;
+  size_t written = 0;
+  pushInput(in, count, out, written);
+  recordCost(nowUs() - t0, frames_before);
+  return written;
+}
+
+size_t CaptureFrontEnd::process(const int16_t* in, size_t count, int16_t* out) {
+  using namespace piper_simd;
+  const double t0 = nowUs();
+  const uint64_t frames_before = stats_.frames;
+  size_t written = 0;
+  const f32x4 scale = set1(32767.0f), lo = set1(-32768.0f), hi = set1(32767.0f);
+  for (size_t off = 0; off < count; off += kBlock) {
+    const size_t n = std::min(kBlock, count - off);
+    float* x = scratch_in_.data();
+    for (size_t i = 0; i < n; i++) x[i] = in[off + i] * (1.0f / 32768.0f);
+    size_t got = 0;
+    pushInput(x, n, scratch_out_.data(), got);
+    float* y = scratch_out_.data();
+    size_t i = 0;
+    for (; i + 4 <= got; i += 4) store(y + i, min(max(mul(load(y + i), scale), lo), hi));
+    for (; i < got; i++) y[i] = std::min(std::max(y[i] * 32767.0f, -32768.0f), 32767.0f);
+    for (i = 0; i < got; i++) out[written + i] = static_cast<int16_t>(std::lrint(y[i]));
+    written += got;
+  }
+  recordCost(nowUs() - t0, frames_before);
+  return written;
+}
+
+size_t CaptureFrontEnd::flush(float* out) {
+  return flushFloat(out);
+}
+
+size_t CaptureFrontEnd::flush(int16_t* out) {
+  const size_t n = flushFloat(scratch_out_.data());
+  for (size_t i = 0; i < n; i++) {
+    out[i] = static_cast<int16_t>(std::lrint(std::min(std::max(scratch_out_[i] * 32767.0f, -32768.0f), 32767.0f)));
+  }
+  return n;
+}
+
+size_t CaptureFrontEnd::flushFloat(float* out) {
+  const double t0 = nowUs();
+  const uint64_t frames_before = stats_.frames;
+  limit_ = (in_count_ * up_ * 2 + down_) / (2 * static_cast<uint64_t>(down_));
+  size_t written = 0;
+  while (emitted_ < limit_) pushInput(zeros_.data(), zeros_.size(), out, written);
+  recordCost(nowUs() - t0, frames_before);
+  clearStream();
+  return written;
+}
+
+void CaptureFrontEnd::pushInput(const float* in, size_t count, float* out, size_t& written) {
+  using namespace piper_simd;
+  if (!resample_) {
+    for (size_t i = 0; i < count; i++) emitSample(in[i], out, written);
+    in_count_ += count;
+    return;
+  }
+  const size_t taps = taps_;
+  for (size_t i = 0; i < count; i++) {
+    history_[hist_pos_] = in[i];
+    history_[hist_pos_ + taps] = in[i];
+    const uint64_t s = in_count_++;
+    // Window of the last taps inputs ending at s, oldest first.
+    const float* x = history_.data() + hist_pos_ + 1;
+    hist_pos_ = hist_pos_ + 1 == taps ? 0 : hist_pos_ + 1;
+    while (next_in_ == s) {
+      const float* c = coeffs_.data() + static_cast<size_t>(phase_) * taps;
+      f32x4 a0 = set1(0.0f), a1 = set1(0.0f);
+      size_t k = 0;
+      for (; k + 8 <= taps; k += 8) {
+        a0 = fmadd(a0, load(x + k), load(c + k));
+        a1 = fmadd(a1, load(x + k + 4), load(c + k + 4));
+      }
+      for (; k < taps; k += 4) a0 = fmadd(a0, load(x + k), load(c + k));
+      emitSample(hsum(add(a0, a1)), out, written);
+      const uint64_t t = ++out_count_ * down_;
+      next_in_ = t / up_;
+      phase_ = static_cast<uint32_t>(t % up_);
+    }
+  }
+}
+
+void CaptureFrontEnd::emitSample(float y, float* out, size_t& written) {
+  frame_buf_[frame_fill_++] = y;
+  if (frame_fill_ < frame_) return;
+  frame_fill_ = 0;
+  processFrame(frame_buf_.data());
+  stats_.frames++;
+  size_t i = std::min(skip_, frame_);
+  skip_ -= i;
+  const size_t n = static_cast<size_t>(std::min<uint64_t>(frame_ - i, limit_ - std::min(limit_, emitted_)));
+  std::memcpy(out + written, frame_buf_.data() + i, n * sizeof(float));
+  written += n;
+  emitted_ += n;
+}
+
+void CaptureFrontEnd::processFrame(float* frame) {
+  if (high_pass_) {
+    float z1 = hp_z1_, z2 = hp_z2_;
+    for (size_t i = 0; i < frame_; i++) {
+      const float x = frame[i];
+      const float y = hp_b0_ * x + z1;
+      z1 = hp_b1_ * x - hp_a1_ * y + z2;
+      z2 = hp_b2_ * x - hp_a2_ * y;
+      frame[i] = y;
+    }
+    // Flush denormals in silence.
+    hp_z1_ = std::fabs(z1) < 1e-20f ? 0.0f : z1;
+    hp_z2_ = std::fabs(z2) < 1e-20f ? 0.0f : z2;
+  }
+  if (config_.noise_suppression) suppressNoise(frame);
+  if (config_.agc) applyAgc(frame);
+}
+
+void CaptureFrontEnd::suppressNoise(float* frame) {
+  using namespace piper_simd;
+  const size_t span = frame_ + overlap_;
+  const size_t bins = fft_.bins();
+  std::memcpy(ns_in_.data() + overlap_, frame, frame_ * sizeof(float));
+  float* buf = ns_buf_.data();
+  size_t i = 0;
+  for (; i + 4 <= span; i += 4) store(buf + i, mul(load(ns_in_.data() + i), load(window_.data() + i)));
+  for (; i < span; i++) buf[i] = ns_in_[i] * window_[i];
+  // buf[span, fft) stays zero.
+  fft_.forward(buf, ns_re_.data(), ns_im_.data());
+
+  // Noise PSD: minimum of the smoothed power over the last 1.5 s (kMinSlots sub-windows), bias-corrected.
+  const bool first = ns_frames_ == 0;
+  double noise_total = 0.0;
+  for (size_t k = 0; k < bins; k++) {
+    const float p = ns_re_[k] * ns_re_[k] + ns_im_[k] * ns_im_[k];
+    const float s = first ? p : 0.7f * smooth_[k] + 0.3f * p;
+    smooth_[k] = s;
+    const float cur = min_frames_ == 0 ? s : std::min(min_cur_[k], s);
+    min_cur_[k] = cur;
+    float m = cur;
+    const size_t filled = std::min<uint64_t>(ns_frames_ / kMinSlotFrames, kMinSlots);
+    for (size_t slot = 0; slot < filled; slot++) m = std::min(m, min_slots_[slot * bins + k]);
+    const float n = std::max(kMinBias * m, 1e-12f);
+    noise_[k] = n;
+    noise_total += (k == 0 || k + 1 == bins) ? n : 2.0 * n;
+
+    // Decision-directed a priori SNR (Ephraim-Malah) and Wiener gain.
+    const float post = p / n;
+    const float prior = 0.98f * prev_clean_[k] / n + 0.02f * std::max(post - 1.0f, 0.0f);
+    const float g = std::max(prior / (1.0f + prior), ns_gain_floor_);
+    prev_clean_[k] = g * g * p;
+    ns_re_[k] *= g;
+    ns_im_[k] *= g;
+  }
+  if (++min_frames_ == kMinSlotFrames) {
+    std::memcpy(min_slots_.data() + min_slot_ * bins, min_cur_.data(), bins * sizeof(float));
+    min_slot_ = (min_slot_ + 1) % kMinSlots;
+    min_frames_ = 0;
+  }
+  ns_frames_++;
+  // Parseval over the windowed frame (window energy ~ frame_ samples).
+  const double noise_power = noise_total / (static_cast<double>(fft_.size()) * static_cast<double>(frame_));
+  stats_.noise_dbfs = static_cast<float>(10.0 * std::log10(noise_power + 1e-12));
+
+  fft_.inverse(ns_re_.data(), ns_im_.data(), buf);
+  for (i = 0; i + 4 <= span; i += 4) store(buf + i, mul(load(buf + i), load(window_.data() + i)));
+  for (; i < span; i++) buf[i] *= window_[i];
+  // Overlap-add: the first overlap_ samples complete the previous frame's tail.
+  for (i = 0; i + 4 <= overlap_; i += 4) store(frame + i, add(load(buf + i), load(ns_tail_.data() + i)));
+  for (; i < overlap_; i++) frame[i] = buf[i] + ns_tail_[i];
+  std::memcpy(frame + overlap_, buf + overlap_, (frame_ - overlap_) * sizeof(float));
+  std::memcpy(ns_tail_.data(), buf + frame_, overlap_ * sizeof(float));
+  std::memmove(ns_in_.data(), ns_in_.data() + frame_, overlap_ * sizeof(float));
+}
+
+void CaptureFrontEnd::applyAgc(float* frame) {
+  using namespace piper_simd;
+  f32x4 acc = set1(0.0f), peak = set1(0.0f);
+  size_t i = 0;
+  for (; i + 4 <= frame_; i += 4) {
+    const f32x4 x = load(frame + i);
+    acc = fmadd(acc, x, x);
+    peak = max(peak, max(x, sub(set1(0.0f), x)));
+  }
+  float energy = hsum(acc);
+  float lanes[4];
+  store(lanes, peak);
+  float pk = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  for (; i < frame_; i++) {
+    energy += frame[i] * frame[i];
+    pk = std::max(pk, std::fabs(frame[i]));
+  }
+  energy /= static_cast<float>(frame_);
+
+  // Speech gate: 6 dB over a floor that drops instantly and rises ~1 dB/s.
+  agc_noise_ = agc_noise_ == 0.0f || energy < agc_noise_ ? std::max(energy, 1e-10f) : agc_noise_ * 1.0023f;
+  const float level_db = 10.0f * std::log10(energy + 1e-12f);
+  if (energy > 4.0f * agc_noise_ && level_db > -55.0f) {
+    stats_.speech_frames++;
+    if (agc_level_db_ <= -119.0f) agc_level_db_ = level_db;
+    agc_level_db_ += (level_db > agc_level_db_ ? 0.2f : 0.03f) * (level_db - agc_level_db_);
+    const float target =
+        std::min(std::max(config_.agc_target_dbfs - agc_level_db_, -12.0f), std::max(config_.agc_max_gain_db, 0.0f));
+    // Up at most 20 dB/s, down 100 dB/s.
+    agc_gain_db_ += std::min(std::max(target - agc_gain_db_, -1.0f), 0.2f);
+  }
+  stats_.agc_gain_db = agc_gain_db_;
+
+  // Ramp from the last frame's gain; both ends under the limiter so no sample exceeds kLimit.
+  const float limit = pk > 0.0f ? kLimit / pk : 1e9f;
+  const float g1 = std::min(dbToGain(agc_gain_db_), limit);
+  const float g0 = std::min(agc_gain_, limit);
+  const float step = (g1 - g0) / static_cast<float>(frame_);
+  const f32x4 vstep = set1(4.0f * step);
+  const float ramp[4] = {g0 + step, g0 + 2.0f * step, g0 + 3.0f * step, g0 + 4.0f * step};
+  f32x4 g = load(ramp);
+  for (i = 0; i + 4 <= frame_; i += 4) {
+    store(frame + i, mul(load(frame + i), g));
+    g = add(g, vstep);
+  }
+  for (; i < frame_; i++) frame[i] *= g0 + step * static_cast<float>(i + 1);
+  agc_gain_ = g1;
+}
+
+}  // namespace piper
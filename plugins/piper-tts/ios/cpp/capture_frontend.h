@@ -0,0 +1,141 @@
+#ifndef CAPTURE_FRONTEND_H
+#define CAPTURE_FRONTEND_H
+
+#include "fft.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace piper {
+
+// Front-end settings. Defaults suit a phone mic feeding a 16 kHz recognizer.
+struct CaptureFrontEndConfig {
+  int input_rate = 48000;           // device rate (44.1 / 48 kHz; any rate in [8 kHz, 192 kHz])
+  int output_rate = 16000;
+  float high_pass_hz = 80.0f;       // 2nd-order Butterworth; <= 0 = off
+  bool noise_suppression = true;
+  float ns_max_attenuation_db = 18.0f;  // floor of the per-bin suppression gain
+  bool agc = true;
+  float agc_target_dbfs = -20.0f;   // speech RMS the gain steers to
+  float agc_max_gain_db = 24.0f;
+};
+
+// Cost and adaptation state of the current stream (cleared by reset()).
+struct CaptureFrontEndStats {
+  uint64_t frames = 0;          // 10 ms output frames produced
+  double total_us = 0.0;        // processing time of those frames (resampling included)
+  double max_frame_us = 0.0;    // worst per-frame cost of a process() call
+  double meanFrameUs() const { return frames ? total_us / static_cast<double>(frames) : 0.0; }
+  float agc_gain_db = 0.0f;
+  float noise_dbfs = -120.0f;   // suppressor's noise floor estimate (full band)
+  uint64_t speech_frames = 0;   // frames the AGC treated as speech
+};
+
+// Streaming capture front-end: device-rate mono PCM in, output_rate mono PCM out, in any chunk sizes as
+// the mic delivers them. Stages, all on 10 ms output frames:
+//   1. Polyphase FIR resampler (Kaiser-windowed sinc, 70 dB stopband below the output Nyquist). Each
+//      output sample is one contiguous dot product (simd_f32.h) over a mirrored input history.
+//   2. High-pass biquad (DC, handling and wind rumble).
+//   3. Spectral noise suppressor: 256-point FFT with a 10 ms hop (6 ms overlap, sine-tapered flat-top
+//      window, exact overlap-add), minimum-tracking noise PSD and a decision-directed Wiener gain.
+//   4. AGC: speech-gated level follower steering toward agc_target_dbfs, gain ramped across each
+//      frame, and a peak limiter so the output never clips.
+// Output is delay-compensated: sample i of the output lines up with input time i / output_rate, and
+// flush() emits the tail, so total output = round(total input * output_rate / input_rate).
+// configure() sizes every buffer; process() and flush() do not allocate. Not thread-safe.
+class CaptureFrontEnd {
+ public:
+  explicit CaptureFrontEnd(const CaptureFrontEndConfig& config = CaptureFrontEndConfig());
+
+  // False (and the previous configuration kept) for an unsupported rate pair.
+  bool configure(const CaptureFrontEndConfig& config);
+  const CaptureFrontEndConfig& config() const { return config_; }
+
+  // Output samples per frame (10 ms) and an upper bound on what process() writes for count inputs.
+  size_t frameSize() const { return frame_; }
+  size_t maxOutput(size_t input_count) const;
+  // Output samples the pipeline holds back (resampler group delay + suppressor overlap).
+  size_t latencySamples() const { return latency_; }
+
+  // Mono input at input_rate; writes the output of every 10 ms frame it completes to out (at most
+  // maxOutput(count) samples). Returns the number written. int16 and float ([-1, 1]) run the same pipeline.
+  size_t process(const int16_t* in, size_t count, int16_t* out);
+  size_t process(const float* in, size_t count, float* out);
+
+  // End of stream: pushes the held-back audio through and writes the rest (at most maxOutput(0) samples).
+  // The stream buffers are cleared afterwards; stats and adaptation stay until reset().
+  size_t flush(int16_t* out);
+  size_t flush(float* out);
+
+  // New stream. reset_adaptation = false keeps the AGC gain/level and the noise estimate, which still
+  // describe the same mic and room (e.g. the next utterance of a warm capture).
+  void reset(bool reset_adaptation = true);
+
+  const CaptureFrontEndStats& stats() const { return stats_; }
+
+ private:
+  void pushInput(const float* in, size_t count, float* out, size_t& written);
+  void emitSample(float y, float* out, size_t& written);
+  void processFrame(float* frame);
+  void suppressNoise(float* frame);
+  void applyAgc(float* frame);
+  size_t flushFloat(float* out);
+  void recordCost(double us, uint64_t frames_before);
+  void clearStream();
+
+  CaptureFrontEndConfig config_;
+  size_t frame_ = 160;
+  size_t latency_ = 0;
+
+  // Resampler: output sample j reads input position j * down / up (polyphase branch (j * down) % up).
+  bool resample_ = false;
+  uint32_t up_ = 1, down_ = 1;
+  size_t taps_ = 0;                 // per phase, multiple of 4
+  std::vector<float> coeffs_;       // [up][taps], each branch reversed to match the history order
+  std::vector<float> history_;      // 2 * taps mirrored ring
+  size_t hist_pos_ = 0;
+  uint64_t in_count_ = 0;           // input samples consumed this stream
+  uint64_t out_count_ = 0;          // output samples produced by the resampler
+  uint64_t next_in_ = 0;            // input index needed for the next output sample
+  uint32_t phase_ = 0;
+
+  // Frame assembly and delay compensation.
+  std::vector<float> frame_buf_;
+  size_t frame_fill_ = 0;
+  size_t skip_ = 0;                 // leading output samples still to drop
+  uint64_t emitted_ = 0;            // samples written to the caller this stream
+  uint64_t limit_ = UINT64_MAX;     // flush(): stop at the input's length
+
+  // High-pass biquad (transposed direct form II).
+  bool high_pass_ = false;
+  float hp_b0_ = 1, hp_b1_ = 0, hp_b2_ = 0, hp_a1_ = 0, hp_a2_ = 0;
+  float hp_z1_ = 0, hp_z2_ = 0;
+
+  // Noise suppressor.
+  RealFft fft_;
+  size_t overlap_ = 0;
+  std::vector<float> window_;       // analysis = synthesis window, frame + overlap long
+  std::vector<float> ns_in_;        // overlap from the last frame + this frame
+  std::vector<float> ns_buf_, ns_re_, ns_im_;
+  std::vector<float> ns_tail_;      // overlap-add tail
+  std::vector<float> smooth_, noise_, prev_clean_;  // per bin
+  std::vector<float> min_slots_;    // [kMinSlots][bins] minima of the smoothed power per sub-window
+  std::vector<float> min_cur_;      // minimum of the current sub-window
+  size_t min_frames_ = 0, min_slot_ = 0;
+  uint64_t ns_frames_ = 0;
+  float ns_gain_floor_ = 0.0f;
+
+  // AGC.
+  float agc_gain_db_ = 0.0f;
+  float agc_gain_ = 1.0f;           // gain applied at the end of the last frame
+  float agc_level_db_ = -120.0f;    // speech level estimate
+  float agc_noise_ = 0.0f;          // frame-energy noise floor for the speech gate
+
+  std::vector<float> scratch_in_, scratch_out_, zeros_;  // int16 path, flush input
+  double pending_us_ = 0.0;
+  CaptureFrontEndStats stats_;
+};
+
+}  // namespace piper
+
+#endif  // CAPTURE_FRONTEND_H
@@ -0,0 +1,272 @@
+#include "embedding_engine.h"
+#include "ort_env.h"
+#include "wordpiece_tokenizer.h"
+#include <onnxruntime_c_api.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace piper {
+
+namespace {
+
+using piper_ort::logOrtStatus;
+
+constexpr int kDefaultMaxTokens = 256;
+
+struct EmbedSession {
+  OrtSession* session = nullptr;
+  OrtSessionOptions* options = nullptr;
+  OrtMemoryInfo* memory_info = nullptr;
+  std::string model_path;
+  bool has_attention_mask = false;
+  bool has_token_type_ids = false;
+  std::string output_name;
+};
+
+std::mutex g_embed_mutex;
+EmbedSession g_embed;
+WordPieceTokenizer g_tokenizer;
+
+void releaseEmbedSession(const OrtApi* api, EmbedSession& s) {
+  if (s.session) api->ReleaseSession(s.session);
+  if (s.options) api->ReleaseSessionOptions(s.options);
+  if (s.memory_info) api->ReleaseMemoryInfo(s.memory_info);
+  s = EmbedSession{};
+}
+
+// Record which optional BERT inputs the graph declares and pick the output to pool:
+// "sentence_embedding" (already pooled) > "last_hidden_state" > first output.
+bool introspect(const OrtApi* api, EmbedSession& s) {
+  OrtAllocator* allocator = nullptr;
+  if (OrtStatus* st = api->GetAllocatorWithDefaultOptions(&allocator)) {
+    logOrtStatus(api, st);
+    return false;
+  }
+  size_t num_in = 0, num_out = 0;
+  if (OrtStatus* st = api->SessionGetInputCount(s.session, &num_in)) {
+    logOrtStatus(api, st);
+    return false;
+  }
+  if (OrtStatus* st = api->SessionGetOutputCount(s.session, &num_out)) {
+    logOrtStatus(api, st);
+    return false;
+  }
+  for (size_t i = 0; i < num_in; i++) {
+    char* name = nullptr;
+    if (api->SessionGetInputName(s.session, i, allocator, &name) != nullptr || !name) continue;
+    if (std::strcmp(name, "attention_mask") == 0) s.has_attention_mask = true;
+    if (std::strcmp(name, "token_type_ids") == 0) s.has_token_type_ids = true;
+    allocator->Free(allocator, name);
+  }
+  for (size_t i = 0; i < num_out; i++) {
+    char* name = nullptr;
+    if (api->SessionGetOutputName(s.session, i, allocator, &name) != nullptr || !name) continue;
+    const bool pooled = std::strcmp(name, "sentence_embedding") == 0;
+    const bool hidden = std::strcmp(name, "last_hidden_state") == 0;
+    if (pooled || (hidden && s.output_name != "sentence_embedding") || s.output_name.empty())
+      s.output_name = name;
+    allocator->Free(allocator, name);
+  }
+  std::fprintf(stderr, "[Piper] Embed session: %zu input(s) mask=%d type_ids=%d output=\"%s\"\n", num_in,
+               s.has_attention_mask ? 1 : 0, s.has_token_type_ids ? 1 : 0, s.output_name.c_str());
+  return !s.output_name.empty();
+}
+
+bool ensureSession(const OrtApi* api, const std::string& model_path) {
+  if (g_embed.session && g_embed.model_path == model_path) return true;
+  releaseEmbedSession(api, g_embed);
+
+  OrtEnv* env = piper_ort::sharedEnv();
+  if (!env) return false;
+  EmbedSession s;
+  s.options = piper_ort::createSharedSessionOptions(ORT_ENABLE_EXTENDED);
+  if (!s.options) return false;
+  OrtStatus* status = api->CreateSession(env, model_path.c_str(), s.options, &s.session);
+  if (status) {
+    logOrtStatus(api, status);
+    releaseEmbedSession(api, s);
+    return false;
+  }
+  status = api->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &s.memory_info);
+  if (status) {
+    logOrtStatus(api, status);
+    releaseEmbedSession(api, s);
+    return false;
+  }
+  if (!introspect(api, s)) {
+    releaseEmbedSession(api, s);
+    return false;
+  }
+  s.model_path = model_path;
+  g_embed = s;
+  return true;
+}
+
+}  // namespace
+
+const char* embedErrorToString(EmbedError error) {
+  switch (error) {
+    case EmbedError::kNone: return "none";
+    case EmbedError::kInvalidArgs: return "invalid args";
+    case EmbedError::kVocabLoadFailed: return "vocab load failed";
+    case EmbedError::kOrtCreateSessionFailed: return "ORT create session failed";
+    case EmbedError::kOrtRunInferenceFailed: return "ORT run failed";
+    case EmbedError::kUnexpectedOutput: return "unexpected model output";
+  }
+  return "unknown";
+}
+
+bool embedText(const std::string& model_path,
+               const std::string& vocab_path,
+               const std::string& text,
+               std::vector<float>& embedding_out,
+               EmbedError* out_error,
+               const EmbedOptions* options) {
+  auto setErr = [out_error](EmbedError e) {
+    if (out_error) *out_error = e;
+  };
+  setErr(EmbedError::kNone);
+  embedding_out.clear();
+  if (model_path.empty() || vocab_path.empty()) {
+    setErr(EmbedError::kInvalidArgs);
+    return false;
+  }
+  const EmbedOptions defaults;
+  const EmbedOptions& opts = options ? *options : defaults;
+  const size_t max_tokens = static_cast<size_t>(opts.max_tokens > 0 ? opts.max_tokens : kDefaultMaxTokens);
+
+  const OrtApi* api = piper_ort::getApi();
+  if (!api) {
+    setErr(EmbedError::kOrtCreateSessionFailed);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(g_embed_mutex);
+  if (!g_tokenizer.loaded() || g_tokenizer.path() != vocab_path) {
+    if (!g_tokenizer.load(vocab_path)) {
+      setErr(EmbedError::kVocabLoadFailed);
+      return false;
+    }
+  }
+  g_tokenizer.setLowercase(opts.lowercase);
+  if (!ensureSession(api, model_path)) {
+    setErr(EmbedError::kOrtCreateSessionFailed);
+    return false;
+  }
+
+  std::vector<int64_t> input_ids;
+  if (opts.query_prefix.empty()) {
+    g_tokenizer.encode(text, max_tokens, input_ids);
+  } else {
+    g_tokenizer.encode(opts.query_prefix + text, max_tokens, input_ids);
+  }
+  const int64_t seq_len = static_cast<int64_t>(input_ids.size());
+  std::vector<int64_t> attention_mask(input_ids.size(), 1);
+  std::vector<int64_t> token_type_ids(input_ids.size(), 0);
+  const int64_t shape[2] = {1, seq_len};
+  const size_t bytes = input_ids.size() * sizeof(int64_t);
+
+  OrtValue* ids_value = nullptr;
+  OrtValue* mask_value = nullptr;
+  OrtValue* type_value = nullptr;
+  OrtValue* output_value = nullptr;
+  auto releaseValues = [&]() {
+    if (ids_value) api->ReleaseValue(ids_value);
+    if (mask_value) api->ReleaseValue(mask_value);
+    if (type_value) api->ReleaseValue(type_value);
+    if (output_value) api->ReleaseValue(output_value);
+  };
+
+  const char* input_names[3] = {"input_ids", nullptr, nullptr};
+  const OrtValue* inputs[3] = {nullptr, nullptr, nullptr};
+  size_t num_inputs = 0;
+  OrtStatus* status = api->CreateTensorWithDataAsOrtValue(g_embed.memory_info, input_ids.data(), bytes, shape, 2,
+                                                          ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &ids_value);
+  if (!status) inputs[num_inputs++] = ids_value;
+  if (!status && g_embed.has_attention_mask) {
+    status = api->CreateTensorWithDataAsOrtValue(g_embed.memory_info, attention_mask.data(), bytes, shape, 2,
+                                                 ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &mask_value);
+    if (!status) {
+      input_names[num_inputs] = "attention_mask";
+      inputs[num_inputs++] = mask_value;
+    }
+  }
+  if (!status && g_embed.has_token_type_ids) {
+    status = api->CreateTensorWithDataAsOrtValue(g_embed.memory_info, token_type_ids.data(), bytes, shape, 2,
+                                                 ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &type_value);
+    if (!status) {
+      input_names[num_inputs] = "token_type_ids";
+      inputs[num_inputs++] = type_value;
+    }
+  }
+  if (status) {
+    logOrtStatus(api, status);
+    releaseValues();
+    setErr(EmbedError::kOrtRunInferenceFailed);
+    return false;
+  }
+
+  const char* output_names[1] = {g_embed.output_name.c_str()};
+  status = api->Run(g_embed.session, nullptr, input_names, inputs, num_inputs, output_names, 1, &output_value);
+  if (status || !output_value) {
+    logOrtStatus(api, status);
+    releaseValues();
+    setErr(EmbedError::kOrtRunInferenceFailed);
+    return false;
+  }
+
+  OrtTensorTypeAndShapeInfo* info = nullptr;
+  size_t rank = 0;
+  int64_t dims[3] = {0, 0, 0};
+  ONNXTensorElementDataType elem = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+  status = api->GetTensorTypeAndShape(output_value, &info);
+  if (!status) status = api->GetDimensionsCount(info, &rank);
+  if (!status && (rank == 2 || rank == 3)) status = api->GetDimensions(info, dims, rank);
+  if (!status) status = api->GetTensorElementType(info, &elem);
+  if (info) api->ReleaseTensorTypeAndShapeInfo(info);
+  float* data = nullptr;
+  if (!status) status = api->GetTensorMutableData(output_value, reinterpret_cast<void**>(&data));
+  if (status) {
+    logOrtStatus(api, status);
+    releaseValues();
+    setErr(EmbedError::kOrtRunInferenceFailed);
+    return false;
+  }
+  if (elem != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT || !data || (rank != 2 && rank != 3) || dims[0] != 1 ||
+      dims[rank - 1] <= 0 || (rank == 3 && dims[1] != seq_len)) {
+    std::fprintf(stderr, "[Piper] Embed: unexpected output rank=%zu type=%d\n", rank, static_cast<int>(elem));
+    releaseValues();
+    setErr(EmbedError::kUnexpectedOutput);
+    return false;
+  }
+
+  const size_t hidden = static_cast<size_t>(dims[rank - 1]);
+  embedding_out.assign(hidden, 0.0f);
+  if (rank == 2) {
+    std::memcpy(embedding_out.data(), data, hidden * sizeof(float));
+  } else {
+    // Mean pool over the attention mask. Single unpadded sequence: every token counts.
+    float* acc = embedding_out.data();
+    for (int64_t t = 0; t < seq_len; t++) {
+      const float* row = data + static_cast<size_t>(t) * hidden;
+      for (size_t h = 0; h < hidden; h++) acc[h] += row[h];
+    }
+    const float inv = 1.0f / static_cast<float>(seq_len);
+    for (size_t h = 0; h < hidden; h++) acc[h] *= inv;
+  }
+  releaseValues();
+
+  if (opts.normalize) {
+    double sum_sq = 0.0;
+    for (float v : embedding_out) sum_sq += static_cast<double>(v) * v;
+    if (sum_sq > 0.0) {
+      const float inv_norm = static_cast<float>(1.0 / std::sqrt(sum_sq));
+      for (float& v : embedding_out) v *= inv_norm;
+    }
+  }
+  return true;
+}
+
+}  // namespace piper
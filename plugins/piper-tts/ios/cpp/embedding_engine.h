@@ -0,0 +1,45 @@
+#ifndef EMBEDDING_ENGINE_H
+#define EMBEDDING_ENGINE_H
+
+#include <string>
+#include <vector>
+
+namespace piper {
+
+// Error codes for embedText (when return is false).
+enum class EmbedError {
+  kNone = 0,
+  kInvalidArgs,
+  kVocabLoadFailed,
+  kOrtCreateSessionFailed,
+  kOrtRunInferenceFailed,
+  kUnexpectedOutput,
+};
+
+// Optional per-call settings. Defaults match BERT-family sentence encoders.
+struct EmbedOptions {
+  // Prepended to the text before tokenization (e.g. "search_query: " for nomic-embed).
+  std::string query_prefix;
+  // Token budget including [CLS]/[SEP]; <= 0 = default (256).
+  int max_tokens = -1;
+  // L2-normalize the pooled vector (required for cosine/L2 search against normalized pack vectors).
+  bool normalize = true;
+  // Lowercase + strip accents before WordPiece (uncased vocabularies).
+  bool lowercase = true;
+};
+
+// Embed one text with an ONNX sentence encoder on the shared ORT env (see ort_env.h).
+// Model outputs [1, T, H] are mean-pooled over the attention mask; [1, H] outputs are used as-is.
+// Session and vocab are cached per path. Thread-safe (calls are serialized).
+bool embedText(const std::string& model_path,
+               const std::string& vocab_path,
+               const std::string& text,
+               std::vector<float>& embedding_out,
+               EmbedError* out_error = nullptr,
+               const EmbedOptions* options = nullptr);
+
+const char* embedErrorToString(EmbedError error);
+
+}  // namespace piper
+
+#endif  // EMBEDDING_ENGINE_H
@@ -0,0 +1,68 @@
+#include "embedding_jsi.h"
+#include "embedding_engine.h"
+#include <jsi/jsi.h>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+namespace {
+
+// Hands the embedding vector's storage to a JS ArrayBuffer without another copy.
+class FloatVectorBuffer : public jsi::MutableBuffer {
+ public:
+  explicit FloatVectorBuffer(std::vector<float>&& values) : values_(std::move(values)) {}
+  size_t size() const override { return values_.size() * sizeof(float); }
+  uint8_t* data() override { return reinterpret_cast<uint8_t*>(values_.data()); }
+
+ private:
+  std::vector<float> values_;
+};
+
+EmbedOptions readOptions(jsi::Runtime& rt, const jsi::Value& value) {
+  EmbedOptions opts;
+  if (!value.isObject()) return opts;
+  jsi::Object obj = value.getObject(rt);
+  jsi::Value prefix = obj.getProperty(rt, "queryPrefix");
+  if (prefix.isString()) opts.query_prefix = prefix.getString(rt).utf8(rt);
+  jsi::Value max_tokens = obj.getProperty(rt, "maxTokens");
+  if (max_tokens.isNumber()) opts.max_tokens = static_cast<int>(max_tokens.getNumber());
+  jsi::Value normalize = obj.getProperty(rt, "normalize");
+  if (normalize.isBool()) opts.normalize = normalize.getBool();
+  jsi::Value lowercase = obj.getProperty(rt, "lowercase");
+  if (lowercase.isBool()) opts.lowercase = lowercase.getBool();
+  return opts;
+}
+
+}  // namespace
+
+void installEmbeddingJsi(jsi::Runtime& runtime) {
+  auto embed = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperEmbed"), 4,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 3 || !args[0].isString() || !args[1].isString() || !args[2].isString()) {
+          throw jsi::JSError(rt, "__piperEmbed(modelPath, vocabPath, text, options?): expected strings");
+        }
+        const std::string model_path = args[0].getString(rt).utf8(rt);
+        const std::string vocab_path = args[1].getString(rt).utf8(rt);
+        const std::string text = args[2].getString(rt).utf8(rt);
+        const EmbedOptions opts = count > 3 ? readOptions(rt, args[3]) : EmbedOptions{};
+
+        std::vector<float> embedding;
+        EmbedError err = EmbedError::kNone;
+        if (!embedText(model_path, vocab_path, text, embedding, &err, &opts)) {
+          throw jsi::JSError(rt, std::string("Embedding failed: ") + embedErrorToString(err));
+        }
+        jsi::ArrayBuffer buffer(rt, std::make_shared<FloatVectorBuffer>(std::move(embedding)));
+        jsi::Function ctor = rt.global().getPropertyAsFunction(rt, "Float32Array");
+        return ctor.callAsConstructor(rt, std::move(buffer));
+      });
+  runtime.global().setProperty(runtime, "__piperEmbed", std::move(embed));
+}
+
+}  // namespace piper
@@ -0,0 +1,19 @@
+#ifndef EMBEDDING_JSI_H
+#define EMBEDDING_JSI_H
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+}
+}  // namespace facebook
+
+namespace piper {
+
+// Install global.__piperEmbed(modelPath, vocabPath, text, options?) -> Float32Array.
+// Synchronous on the JS thread; throws a JS Error with the EmbedError string on failure.
+// options: { queryPrefix?: string, maxTokens?: number, normalize?: boolean, lowercase?: boolean }
+void installEmbeddingJsi(facebook::jsi::Runtime& runtime);
+
+}  // namespace piper
+
+#endif  // EMBEDDING_JSI_H
@@ -0,0 +1,146 @@
+#include "fft.h"
+#include "simd_f32.h"
+#include <cmath>
+
+namespace piper {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+}
+
+RealFft::RealFft(size_t n) : n_(n), m_(n / 2) {
+  unsigned bits = 0;
+  while ((size_t(1) << bits) < m_) bits++;
+  bitrev_.resize(m_);
+  for (size_t i = 0; i < m_; i++) {
+    uint32_t r = 0;
+    for (unsigned b = 0; b < bits; b++)
+      if (i & (size_t(1) << b)) r |= 1u << (bits - 1 - b);
+    bitrev_[i] = r;
+  }
+  tw_re_.resize(m_ > 1 ? m_ - 1 : 1);
+  tw_im_.resize(tw_re_.size());
+  for (size_t half = 1; half < m_; half <<= 1) {
+    for (size_t j = 0; j < half; j++) {
+      const double a = -kPi * static_cast<double>(j) / static_cast<double>(half);
+      tw_re_[half - 1 + j] = static_cast<float>(std::cos(a));
+      tw_im_[half - 1 + j] = static_cast<float>(std::sin(a));
+    }
+  }
+  post_re_.resize(m_ + 1);
+  post_im_.resize(m_ + 1);
+  for (size_t k = 0; k <= m_; k++) {
+    const double a = -2.0 * kPi * static_cast<double>(k) / static_cast<double>(n_);
+    post_re_[k] = static_cast<float>(std::cos(a));
+    post_im_[k] = static_cast<float>(std::sin(a));
+  }
+  work_re_.resize(m_);
+  work_im_.resize(m_);
+}
+
+void RealFft::complexFft(float* re, float* im) const {
+  using namespace piper_simd;
+  for (size_t half = 1; half < m_; half <<= 1) {
+    const float* wr = tw_re_.data() + half - 1;
+    const float* wi = tw_im_.data() + half - 1;
+    const size_t len = half << 1;
+    for (size_t base = 0; base < m_; base += len) {
+      float* ar = re + base;
+      float* ai = im + base;
+      float* br = ar + half;
+      float* bi = ai + half;
+      size_t j = 0;
+      if (half >= 4) {
+        for (; j + 4 <= half; j += 4) {
+          const f32x4 twr = load(wr + j), twi = load(wi + j);
+          const f32x4 xr = load(br + j), xi = load(bi + j);
+          const f32x4 vr = fmsub(mul(xr, twr), xi, twi);
+          const f32x4 vi = fmadd(mul(xr, twi), xi, twr);
+          const f32x4 ur = load(ar + j), ui = load(ai + j);
+          store(ar + j, add(ur, vr));
+          store(ai + j, add(ui, vi));
+          store(br + j, sub(ur, vr));
+          store(bi + j, sub(ui, vi));
+        }
+      }
+      for (; j < half; j++) {
+        const float vr = br[j] * wr[j] - bi[j] * wi[j];
+        const float vi = br[j] * wi[j] + bi[j] * wr[j];
+        const float ur = ar[j], ui = ai[j];
+        ar[j] = ur + vr;
+        ai[j] = ui + vi;
+        br[j] = ur - vr;
+        bi[j] = ui - vi;
+      }
+    }
+  }
+}
+
+void RealFft::forward(const float* in, float* out_re, float* out_im) {
+  float* zr = work_re_.data();
+  float* zi = work_im_.data();
+  // Pack even/odd samples as one complex sequence of half length (bit-reversed order).
+  for (size_t i = 0; i < m_; i++) {
+    const uint32_t r = bitrev_[i];
+    zr[r] = in[2 * i];
+    zi[r] = in[2 * i + 1];
+  }
+  complexFft(zr, zi);
+
+  // Split into the spectrum of the real input: X[k] = E[k] + W^k O[k].
+  out_re[0] = zr[0] + zi[0];
+  out_im[0] = 0.0f;
+  out_re[m_] = zr[0] - zi[0];
+  out_im[m_] = 0.0f;
+  for (size_t k = 1; k < m_; k++) {
+    const float a = zr[k], b = zi[k];
+    const float c = zr[m_ - k], d = zi[m_ - k];
+    const float er = 0.5f * (a + c), ei = 0.5f * (b - d);
+    const float orr = 0.5f * (b + d), oi = -0.5f * (a - c);
+    const float wr = post_re_[k], wi = post_im_[k];
+    out_re[k] = er + orr * wr - oi * wi;
+    out_im[k] = ei + orr * wi + oi * wr;
+  }
+}
+
+void RealFft::powerSpectrum(const float* in, float* out) {
+  // out doubles as the real-part buffer; imag goes to member scratch (no per-call allocation).
+  std::vector<float>& im = scratch_im_;
+  if (im.size() < m_ + 1) im.resize(m_ + 1);
+  forward(in, out, im.data());
+  using namespace piper_simd;
+  size_t k = 0;
+  for (; k + 4 <= m_ + 1; k += 4) {
+    const f32x4 r = load(out + k), i = load(im.data() + k);
+    store(out + k, fmadd(mul(r, r), i, i));
+  }
+  for (; k <= m_; k++) out[k] = out[k] * out[k] + im[k] * im[k];
+}
+
+void RealFft::inverse(const float* re, const float* im, float* out) {
+  float* zr = work_re_.data();
+  float* zi = work_im_.data();
+  // Rebuild the half-length complex spectrum Z[k] = E[k] + i O[k], O[k] = conj(W^k) (X[k] - E[k]),
+  // with E[k] = (X[k] + conj(X[m-k])) / 2, then inverse FFT via conj-FFT-conj.
+  for (size_t k = 0; k < m_; k++) {
+    const float a = re[k], b = im[k];
+    const float c = re[m_ - k], d = -im[m_ - k];
+    const float er = 0.5f * (a + c), ei = 0.5f * (b + d);
+    const float dr = 0.5f * (a - c), di = 0.5f * (b - d);
+    const float wr = post_re_[k], wi = -post_im_[k];
+    const float orr = dr * wr - di * wi;
+    const float oi = dr * wi + di * wr;
+    const uint32_t r = bitrev_[k];
+    // conj(E + i O) for the conj-FFT-conj inverse.
+    zr[r] = er - oi;
+    zi[r] = -(ei + orr);
+  }
+  complexFft(zr, zi);
+  const float scale = 1.0f / static_cast<float>(m_);
+  for (size_t i = 0; i < m_; i++) {
+    out[2 * i] = zr[i] * scale;
+    out[2 * i + 1] = -zi[i] * scale;
+  }
+}
+
+}  // namespace piper
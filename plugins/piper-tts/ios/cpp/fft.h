@@ -0,0 +1,46 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace piper {
+
+// Real-input FFT of power-of-two size n (>= 8) via an n/2 complex radix-2 FFT on split
+// real/imag arrays. Butterflies are vectorized 4-wide (simd_f32.h); twiddles are precomputed
+// per stage so the hot loop does contiguous loads only. Not thread-safe (owns scratch buffers).
+class RealFft {
+ public:
+  explicit RealFft(size_t n);
+
+  size_t size() const { return n_; }
+  size_t bins() const { return n_ / 2 + 1; }
+
+  // in: n real samples. out_re/out_im: n/2 + 1 bins (DC .. Nyquist).
+  void forward(const float* in, float* out_re, float* out_im);
+
+  // |X[k]|^2 for k in [0, n/2].
+  void powerSpectrum(const float* in, float* out);
+
+  // Inverse of forward: re/im hold n/2 + 1 bins; out receives n real samples (scaled by 1/n).
+  void inverse(const float* re, const float* im, float* out);
+
+ private:
+  void complexFft(float* re, float* im) const;
+
+  size_t n_;
+  size_t m_;  // n / 2
+  std::vector<uint32_t> bitrev_;
+  std::vector<float> tw_re_;  // stage twiddles, stage with half-size h at offset h - 1
+  std::vector<float> tw_im_;
+  std::vector<float> post_re_;  // e^{-2*pi*i*k/n}, k in [0, m]
+  std::vector<float> post_im_;
+  std::vector<float> work_re_;
+  std::vector<float> work_im_;
+  std::vector<float> scratch_im_;
+};
+
+}  // namespace piper
+
+#endif  // FFT_H
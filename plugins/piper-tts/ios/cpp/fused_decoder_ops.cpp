@@ -0,0 +1,357 @@
+#include "fused_decoder_ops.h"
+#include "ort_env.h"
+#include "simd_f32.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PIPER_ORT_LOG(fmt, ...) std::fprintf(stderr, "[PiperORT] " fmt "\n", ##__VA_ARGS__)
+
+namespace piper_ort {
+
+namespace {
+
+using piper_simd::f32x4;
+
+// Output samples per tile, computed in groups of 16 (4 vectors) for 4 output channels at a time: 16 accumulators,
+// which NEON keeps in registers. The tile's input window (C x (64 + dilated kernel span)) stays in L1/L2.
+constexpr size_t kTile = 64;
+constexpr size_t kGroup = 16;
+constexpr size_t kChannelBlock = 4;
+
+thread_local std::vector<float> t_window;
+
+// dst[0, span) = act(src[begin + s]), zero outside [0, length).
+void fillWindow(const float* src, size_t length, long long begin, size_t span, bool activate, float alpha,
+                float* dst) {
+  const long long lo = std::min<long long>(std::max<long long>(0, -begin), static_cast<long long>(span));
+  const long long hi =
+      std::max<long long>(lo, std::min<long long>(static_cast<long long>(span), static_cast<long long>(length) - begin));
+  std::fill(dst, dst + lo, 0.0f);
+  std::fill(dst + hi, dst + span, 0.0f);
+  const float* in = src + begin + lo;
+  float* out = dst + lo;
+  const size_t n = static_cast<size_t>(hi - lo);
+  if (!activate) {
+    std::memcpy(out, in, n * sizeof(float));
+    return;
+  }
+  const f32x4 zero = piper_simd::set1(0.0f);
+  const f32x4 slope = piper_simd::set1(alpha);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const f32x4 v = piper_simd::load(in + i);
+    piper_simd::store(out + i, piper_simd::fmadd(piper_simd::max(v, zero), slope, piper_simd::min(v, zero)));
+  }
+  for (; i < n; i++) out[i] = in[i] >= 0.0f ? in[i] : alpha * in[i];
+}
+
+// OB output channels x 16 samples starting at window offset ts; count valid samples are stored at out_t.
+template <size_t OB>
+void convGroup(const FusedConv1dArgs& a, size_t n, size_t o, const float* window, size_t span, size_t ts,
+               size_t out_t, size_t count, size_t out_length) {
+  const size_t C = a.in_channels;
+  const size_t K = a.kernel;
+  const size_t d = a.dilation;
+  f32x4 acc[OB][4];
+  for (size_t j = 0; j < OB; j++) {
+    const f32x4 b = piper_simd::set1(a.bias ? a.bias[o + j] : 0.0f);
+    for (size_t v = 0; v < 4; v++) acc[j][v] = b;
+  }
+  for (size_t c = 0; c < C; c++) {
+    const float* xs = window + c * span + ts;
+    const float* w[OB];
+    for (size_t j = 0; j < OB; j++) w[j] = a.weight + ((o + j) * C + c) * K;
+    for (size_t k = 0; k < K; k++) {
+      const float* xk = xs + k * d;
+      const f32x4 x0 = piper_simd::load(xk);
+      const f32x4 x1 = piper_simd::load(xk + 4);
+      const f32x4 x2 = piper_simd::load(xk + 8);
+      const f32x4 x3 = piper_simd::load(xk + 12);
+      for (size_t j = 0; j < OB; j++) {
+        const f32x4 wk = piper_simd::set1(w[j][k]);
+        acc[j][0] = piper_simd::fmadd(acc[j][0], wk, x0);
+        acc[j][1] = piper_simd::fmadd(acc[j][1], wk, x1);
+        acc[j][2] = piper_simd::fmadd(acc[j][2], wk, x2);
+        acc[j][3] = piper_simd::fmadd(acc[j][3], wk, x3);
+      }
+    }
+  }
+  for (size_t j = 0; j < OB; j++) {
+    const size_t row = (n * a.out_channels + o + j) * out_length + out_t;
+    float* y = a.y + row;
+    const float* r = a.residual ? a.residual + row : nullptr;
+    if (count == kGroup) {
+      for (size_t v = 0; v < 4; v++) {
+        f32x4 out = acc[j][v];
+        if (r) out = piper_simd::add(out, piper_simd::load(r + v * 4));
+        piper_simd::store(y + v * 4, out);
+      }
+    } else {
+      float tmp[kGroup];
+      for (size_t v = 0; v < 4; v++) piper_simd::store(tmp + v * 4, acc[j][v]);
+      for (size_t t = 0; t < count; t++) y[t] = tmp[t] + (r ? r[t] : 0.0f);
+    }
+  }
+}
+
+struct FusedConv1dKernel {
+  const OrtApi* api = nullptr;
+  int64_t dilation = 1;
+  int64_t pad_begin = 0;
+  int64_t pad_end = 0;
+  int64_t pre_activation = 0;
+  float alpha = 0.01f;
+};
+
+// Attribute or default when absent.
+int64_t intAttribute(const OrtApi* api, const OrtKernelInfo* info, const char* name, int64_t fallback) {
+  int64_t v = fallback;
+  if (OrtStatus* status = api->KernelInfoGetAttribute_int64(info, name, &v)) {
+    api->ReleaseStatus(status);
+    return fallback;
+  }
+  return v;
+}
+
+float floatAttribute(const OrtApi* api, const OrtKernelInfo* info, const char* name, float fallback) {
+  float v = fallback;
+  if (OrtStatus* status = api->KernelInfoGetAttribute_float(info, name, &v)) {
+    api->ReleaseStatus(status);
+    return fallback;
+  }
+  return v;
+}
+
+// Dimensions of a float tensor; false if it is not float.
+bool tensorShape(const OrtApi* api, const OrtValue* value, std::vector<int64_t>& dims) {
+  OrtTensorTypeAndShapeInfo* info = nullptr;
+  if (OrtStatus* status = api->GetTensorTypeAndShape(value, &info)) {
+    api->ReleaseStatus(status);
+    return false;
+  }
+  ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+  size_t rank = 0;
+  bool ok = !api->GetTensorElementType(info, &type) && type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT &&
+            !api->GetDimensionsCount(info, &rank);
+  if (ok) {
+    dims.assign(rank, 0);
+    ok = !api->GetDimensions(info, dims.data(), rank);
+  }
+  api->ReleaseTensorTypeAndShapeInfo(info);
+  return ok;
+}
+
+const float* tensorData(const OrtApi* api, const OrtValue* value) {
+  void* p = nullptr;
+  if (OrtStatus* status = api->GetTensorMutableData(const_cast<OrtValue*>(value), &p)) {
+    api->ReleaseStatus(status);
+    return nullptr;
+  }
+  return static_cast<const float*>(p);
+}
+
+const OrtValue* optionalInput(const OrtApi* api, const OrtKernelContext* context, size_t count, size_t index) {
+  if (index >= count) return nullptr;
+  const OrtValue* v = nullptr;
+  if (OrtStatus* status = api->KernelContext_GetInput(context, index, &v)) {
+    api->ReleaseStatus(status);
+    return nullptr;
+  }
+  return v;
+}
+
+OrtStatusPtr invalid(const OrtApi* api, const std::string& msg) {
+  return api->CreateStatus(ORT_INVALID_ARGUMENT, (std::string(kFusedConv1dOp) + ": " + msg).c_str());
+}
+
+OrtStatusPtr createFusedConv1d(const OrtCustomOp*, const OrtApi* api, const OrtKernelInfo* info, void** kernel) {
+  auto* k = new FusedConv1dKernel();
+  k->api = api;
+  k->dilation = intAttribute(api, info, "dilation", 1);
+  k->pad_begin = intAttribute(api, info, "pad_begin", 0);
+  k->pad_end = intAttribute(api, info, "pad_end", 0);
+  k->pre_activation = intAttribute(api, info, "pre_activation", 0);
+  k->alpha = floatAttribute(api, info, "alpha", 0.01f);
+  if (k->dilation < 1 || k->pad_begin < 0 || k->pad_end < 0) {
+    delete k;
+    return invalid(api, "dilation must be >= 1 and pads >= 0");
+  }
+  *kernel = k;
+  return nullptr;
+}
+
+OrtStatusPtr computeFusedConv1d(void* op_kernel, OrtKernelContext* context) {
+  const auto* k = static_cast<const FusedConv1dKernel*>(op_kernel);
+  const OrtApi* api = k->api;
+  size_t count = 0;
+  if (OrtStatus* status = api->KernelContext_GetInputCount(context, &count)) return status;
+  const OrtValue* x = optionalInput(api, context, count, 0);
+  const OrtValue* w = optionalInput(api, context, count, 1);
+  const OrtValue* b = optionalInput(api, context, count, 2);
+  const OrtValue* r = optionalInput(api, context, count, 3);
+  std::vector<int64_t> xd, wd, bd, rd;
+  if (!x || !w || !tensorShape(api, x, xd) || !tensorShape(api, w, wd)) return invalid(api, "missing X or W");
+  if (xd.size() != 3 || wd.size() != 3 || wd[1] != xd[1] || wd[2] < 1) {
+    return invalid(api, "expected X [N, C, T] and W [O, C, K]");
+  }
+
+  FusedConv1dArgs a;
+  a.batch = static_cast<size_t>(xd[0]);
+  a.in_channels = static_cast<size_t>(xd[1]);
+  a.in_length = static_cast<size_t>(xd[2]);
+  a.out_channels = static_cast<size_t>(wd[0]);
+  a.kernel = static_cast<size_t>(wd[2]);
+  a.dilation = static_cast<size_t>(k->dilation);
+  a.pad_begin = static_cast<size_t>(k->pad_begin);
+  a.pad_end = static_cast<size_t>(k->pad_end);
+  a.pre_activation = k->pre_activation != 0;
+  a.alpha = k->alpha;
+  const size_t out_length = a.outLength();
+  if (b) {
+    if (!tensorShape(api, b, bd) || bd.size() != 1 || bd[0] != wd[0]) return invalid(api, "expected B [O]");
+    a.bias = tensorData(api, b);
+  }
+  if (r) {
+    if (!tensorShape(api, r, rd) || rd.size() != 3 || rd[0] != xd[0] || rd[1] != wd[0] ||
+        rd[2] != static_cast<int64_t>(out_length)) {
+      return invalid(api, "residual shape differs from the output");
+    }
+    a.residual = tensorData(api, r);
+  }
+  a.x = tensorData(api, x);
+  a.weight = tensorData(api, w);
+
+  const int64_t out_dims[3] = {xd[0], wd[0], static_cast<int64_t>(out_length)};
+  OrtValue* y = nullptr;
+  if (OrtStatus* status = api->KernelContext_GetOutput(context, 0, out_dims, 3, &y)) return status;
+  void* yp = nullptr;
+  if (OrtStatus* status = api->GetTensorMutableData(y, &yp)) return status;
+  a.y = static_cast<float*>(yp);
+
+  const size_t tiles = fusedConv1dTiles(a);
+  if (tiles == 0) return nullptr;
+  if (tiles == 1) {
+    fusedConv1dTile(a, 0);
+    return nullptr;
+  }
+  OrtStatus* status = api->KernelContext_ParallelFor(
+      context, [](void* args, size_t tile) { fusedConv1dTile(*static_cast<const FusedConv1dArgs*>(args), tile); },
+      tiles, 0, &a);
+  if (status) {
+    api->ReleaseStatus(status);
+    fusedConv1d(a);  // no intra-op pool
+  }
+  return nullptr;
+}
+
+void destroyFusedConv1d(void* op_kernel) { delete static_cast<FusedConv1dKernel*>(op_kernel); }
+
+OrtCustomOp makeFusedConv1dOp() {
+  OrtCustomOp op;
+  std::memset(&op, 0, sizeof(op));
+  op.version = ORT_API_VERSION;
+  op.GetName = [](const OrtCustomOp*) { return kFusedConv1dOp; };
+  op.GetExecutionProviderType = [](const OrtCustomOp*) -> const char* { return nullptr; };  // CPU
+  op.GetInputType = [](const OrtCustomOp*, size_t) { return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT; };
+  op.GetInputTypeCount = [](const OrtCustomOp*) -> size_t { return 4; };
+  op.GetOutputType = [](const OrtCustomOp*, size_t) { return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT; };
+  op.GetOutputTypeCount = [](const OrtCustomOp*) -> size_t { return 1; };
+  op.GetInputCharacteristic = [](const OrtCustomOp*, size_t index) {
+    return index < 2 ? INPUT_OUTPUT_REQUIRED : INPUT_OUTPUT_OPTIONAL;  // B and R optional
+  };
+  op.GetOutputCharacteristic = [](const OrtCustomOp*, size_t) { return INPUT_OUTPUT_REQUIRED; };
+  op.GetInputMemoryType = [](const OrtCustomOp*, size_t) { return OrtMemTypeDefault; };
+  op.GetVariadicInputMinArity = [](const OrtCustomOp*) { return 1; };
+  op.GetVariadicInputHomogeneity = [](const OrtCustomOp*) { return 1; };
+  op.GetVariadicOutputMinArity = [](const OrtCustomOp*) { return 1; };
+  op.GetVariadicOutputHomogeneity = [](const OrtCustomOp*) { return 1; };
+  op.CreateKernelV2 = createFusedConv1d;
+  op.KernelComputeV2 = computeFusedConv1d;
+  op.KernelDestroy = destroyFusedConv1d;
+  op.GetStartVersion = [](const OrtCustomOp*) { return kFusedOpDomainVersion; };
+  op.GetEndVersion = [](const OrtCustomOp*) { return INT_MAX; };
+  return op;
+}
+
+// ORT keeps pointers to the op and domain for the lifetime of every session using them; never released.
+std::once_flag g_domain_once;
+OrtCustomOp g_fused_conv1d_op;
+OrtCustomOpDomain* g_domain = nullptr;
+
+void createDomain() {
+  const OrtApi* api = getApi();
+  if (!api) return;
+  g_fused_conv1d_op = makeFusedConv1dOp();
+  OrtCustomOpDomain* domain = nullptr;
+  OrtStatus* status = api->CreateCustomOpDomain(kFusedOpDomain, &domain);
+  if (!status) status = api->CustomOpDomain_Add(domain, &g_fused_conv1d_op);
+  if (status) {
+    PIPER_ORT_LOG("Fused decoder op domain unavailable:");
+    logOrtStatus(api, status);
+    if (domain) api->ReleaseCustomOpDomain(domain);
+    return;
+  }
+  g_domain = domain;
+}
+
+}  // namespace
+
+size_t FusedConv1dArgs::outLength() const {
+  const size_t padded = in_length + pad_begin + pad_end;
+  const size_t span = dilation * (kernel - 1) + 1;
+  return padded >= span ? padded - span + 1 : 0;
+}
+
+size_t fusedConv1dTiles(const FusedConv1dArgs& a) {
+  return a.batch * ((a.outLength() + kTile - 1) / kTile);
+}
+
+void fusedConv1dTile(const FusedConv1dArgs& a, size_t tile) {
+  const size_t out_length = a.outLength();
+  const size_t per_item = (out_length + kTile - 1) / kTile;
+  if (per_item == 0) return;
+  const size_t n = tile / per_item;
+  const size_t t0 = (tile % per_item) * kTile;
+  const size_t len = std::min(kTile, out_length - t0);
+  const size_t span = kTile + a.dilation * (a.kernel - 1);
+
+  std::vector<float>& window = t_window;
+  if (window.size() < a.in_channels * span) window.resize(a.in_channels * span);
+  const long long begin = static_cast<long long>(t0) - static_cast<long long>(a.pad_begin);
+  for (size_t c = 0; c < a.in_channels; c++) {
+    fillWindow(a.x + (n * a.in_channels + c) * a.in_length, a.in_length, begin, span, a.pre_activation, a.alpha,
+               window.data() + c * span);
+  }
+
+  for (size_t ts = 0; ts < len; ts += kGroup) {
+    const size_t count = std::min(kGroup, len - ts);
+    size_t o = 0;
+    for (; o + kChannelBlock <= a.out_channels; o += kChannelBlock) {
+      convGroup<kChannelBlock>(a, n, o, window.data(), span, ts, t0 + ts, count, out_length);
+    }
+    for (; o < a.out_channels; o++) convGroup<1>(a, n, o, window.data(), span, ts, t0 + ts, count, out_length);
+  }
+}
+
+void fusedConv1d(const FusedConv1dArgs& a) {
+  const size_t tiles = fusedConv1dTiles(a);
+  for (size_t t = 0; t < tiles; t++) fusedConv1dTile(a, t);
+}
+
+bool registerFusedDecoderOps(OrtSessionOptions* options) {
+  std::call_once(g_domain_once, createDomain);
+  const OrtApi* api = getApi();
+  if (!api || !g_domain || !options) return false;
+  if (OrtStatus* status = api->AddCustomOpDomain(options, g_domain)) {
+    logOrtStatus(api, status);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace piper_ort
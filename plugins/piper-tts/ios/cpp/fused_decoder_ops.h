@@ -0,0 +1,52 @@
+#ifndef FUSED_DECODER_OPS_H
+#define FUSED_DECODER_OPS_H
+
+#include <onnxruntime_c_api.h>
+#include <cstddef>
+
+namespace piper_ort {
+
+// Custom-op domain for the VITS (HiFi-GAN) decoder. host/decoder_fuse rewrites exported voices so each
+// LeakyRelu -> Conv1d [-> Add residual] chain of the resblocks becomes one FusedConv1d node:
+//   Y = Conv1d(pre_activation ? LeakyRelu(X, alpha) : X, W, B) + R
+// X [N, C, T], W [O, C, K], optional B [O] and R [N, O, T_out]; stride 1, group 1; attributes dilation,
+// pad_begin, pad_end (int), pre_activation (int 0/1), alpha (float). ConvTranspose upsampling stays on ORT.
+constexpr const char* kFusedOpDomain = "ai.piper";
+constexpr int kFusedOpDomainVersion = 1;
+constexpr const char* kFusedConv1dOp = "FusedConv1d";
+
+// Adds the domain to session options. Models without FusedConv1d nodes are unaffected. False on ORT error.
+bool registerFusedDecoderOps(OrtSessionOptions* options);
+
+struct FusedConv1dArgs {
+  const float* x = nullptr;         // [batch, in_channels, in_length]
+  const float* weight = nullptr;    // [out_channels, in_channels, kernel]
+  const float* bias = nullptr;      // [out_channels]; nullptr = none
+  const float* residual = nullptr;  // [batch, out_channels, outLength()]; nullptr = none
+  float* y = nullptr;               // [batch, out_channels, outLength()]
+  size_t batch = 1;
+  size_t in_channels = 0;
+  size_t in_length = 0;
+  size_t out_channels = 0;
+  size_t kernel = 1;
+  size_t dilation = 1;
+  size_t pad_begin = 0;
+  size_t pad_end = 0;
+  bool pre_activation = false;
+  float alpha = 0.01f;
+
+  // 0 if the padded input is shorter than the dilated kernel.
+  size_t outLength() const;
+};
+
+// Work is split into output time tiles (per batch item); each tile pre-activates and zero-pads its input
+// window once into a thread-local buffer, then runs every output channel over it with bias and residual
+// added on store, so the intermediate activations never round-trip through memory.
+size_t fusedConv1dTiles(const FusedConv1dArgs& args);
+void fusedConv1dTile(const FusedConv1dArgs& args, size_t tile);
+// All tiles on the calling thread.
+void fusedConv1d(const FusedConv1dArgs& args);
+
+}  // namespace piper_ort
+
+#endif  // FUSED_DECODER_OPS_H
@@ -0,0 +1,187 @@
+#include "language_segmenter.h"
+#include <cstdint>
+
+namespace piper {
+
+namespace {
+
+enum class Script { kNeutral, kLatin, kGreek, kCyrillic, kArabic, kHebrew, kDevanagari, kThai, kHangul, kKana, kHan };
+
+struct ScriptInfo {
+  const char* name;
+  const char* default_voice;
+};
+
+ScriptInfo scriptInfo(Script s) {
+  switch (s) {
+    case Script::kGreek: return {"greek", "el"};
+    case Script::kCyrillic: return {"cyrillic", "ru"};
+    case Script::kArabic: return {"arabic", "ar"};
+    case Script::kHebrew: return {"hebrew", "he"};
+    case Script::kDevanagari: return {"devanagari", "hi"};
+    case Script::kThai: return {"thai", "th"};
+    case Script::kHangul: return {"hangul", "ko"};
+    case Script::kKana: return {"kana", "ja"};
+    case Script::kHan: return {"han", "cmn"};
+    default: return {"latin", ""};
+  }
+}
+
+// Decode one UTF-8 codepoint; advances *len. Invalid bytes decode as U+FFFD (length 1).
+uint32_t decodeUtf8(const char* p, size_t avail, size_t* len) {
+  const auto c = static_cast<unsigned char>(p[0]);
+  size_t n = c < 0x80 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : c < 0xf8 ? 4 : 0;
+  if (n == 0 || n > avail) {
+    *len = 1;
+    return 0xfffd;
+  }
+  uint32_t cp = n == 1 ? c : n == 2 ? (c & 0x1f) : n == 3 ? (c & 0x0f) : (c & 0x07);
+  for (size_t i = 1; i < n; ++i) {
+    const auto cc = static_cast<unsigned char>(p[i]);
+    if ((cc & 0xc0) != 0x80) {
+      *len = 1;
+      return 0xfffd;
+    }
+    cp = (cp << 6) | (cc & 0x3f);
+  }
+  *len = n;
+  return cp;
+}
+
+Script classify(uint32_t cp) {
+  if (cp < 0x80) {
+    return ((cp | 0x20) >= 'a' && (cp | 0x20) <= 'z') ? Script::kLatin : Script::kNeutral;
+  }
+  if (cp >= 0x00c0 && cp <= 0x024f && cp != 0xd7 && cp != 0xf7) return Script::kLatin;
+  if (cp >= 0x1e00 && cp <= 0x1eff) return Script::kLatin;
+  if (cp >= 0x0370 && cp <= 0x03ff) return Script::kGreek;
+  if (cp >= 0x1f00 && cp <= 0x1fff) return Script::kGreek;
+  if (cp >= 0x0400 && cp <= 0x052f) return Script::kCyrillic;
+  if (cp >= 0x0590 && cp <= 0x05ff) return Script::kHebrew;
+  if ((cp >= 0x0600 && cp <= 0x06ff) || (cp >= 0x0750 && cp <= 0x077f)) return Script::kArabic;
+  if (cp >= 0x0900 && cp <= 0x097f) return Script::kDevanagari;
+  if (cp >= 0x0e00 && cp <= 0x0e7f) return Script::kThai;
+  if ((cp >= 0x1100 && cp <= 0x11ff) || (cp >= 0xac00 && cp <= 0xd7af) || (cp >= 0x3130 && cp <= 0x318f)) {
+    return Script::kHangul;
+  }
+  if ((cp >= 0x3040 && cp <= 0x30ff) || (cp >= 0x31f0 && cp <= 0x31ff)) return Script::kKana;
+  if ((cp >= 0x4e00 && cp <= 0x9fff) || (cp >= 0x3400 && cp <= 0x4dbf) || (cp >= 0xf900 && cp <= 0xfaff)) {
+    return Script::kHan;
+  }
+  return Script::kNeutral;
+}
+
+// Voice for a script run; Latin and neutral runs take the enclosing voice.
+std::string voiceForScript(Script s, bool han_as_japanese, const SegmenterOptions& opts) {
+  if (s == Script::kHan && han_as_japanese) s = Script::kKana;
+  const ScriptInfo info = scriptInfo(s);
+  auto it = opts.script_voices.find(info.name);
+  if (it != opts.script_voices.end() && !it->second.empty()) return it->second;
+  return info.default_voice;
+}
+
+void appendRun(std::vector<LanguageSegment>& out, const std::string& text, const std::string& voice, bool is_default) {
+  if (text.empty()) return;
+  if (!out.empty() && out.back().voice == voice) {
+    out.back().text += text;
+    out.back().is_default = out.back().is_default && is_default;
+    return;
+  }
+  out.push_back({text, voice, is_default});
+}
+
+// Script-split one untagged span; base_voice covers Latin/neutral text.
+void segmentScripts(const std::string& text, const std::string& base_voice, bool base_is_default,
+                    const SegmenterOptions& opts, std::vector<LanguageSegment>& out) {
+  if (!opts.detect_scripts) {
+    appendRun(out, text, base_voice, base_is_default);
+    return;
+  }
+  // Han next to kana is Japanese; decide once per span.
+  bool has_kana = false;
+  for (size_t i = 0; i < text.size();) {
+    size_t len = 1;
+    if (classify(decodeUtf8(text.data() + i, text.size() - i, &len)) == Script::kKana) {
+      has_kana = true;
+      break;
+    }
+    i += len;
+  }
+
+  std::string run;
+  std::string run_voice = base_voice;
+  bool run_default = base_is_default;
+  std::string pending_neutral;  // neutral chars between runs; attach to whichever run continues
+  for (size_t i = 0; i < text.size();) {
+    size_t len = 1;
+    const Script s = classify(decodeUtf8(text.data() + i, text.size() - i, &len));
+    const char* p = text.data() + i;
+    i += len;
+    if (s == Script::kNeutral) {
+      pending_neutral.append(p, len);
+      continue;
+    }
+    const bool foreign = s != Script::kLatin;
+    const std::string voice = foreign ? voiceForScript(s, has_kana, opts) : base_voice;
+    if (voice != run_voice) {
+      // Spaces before a switch stay with the finished run, so each segment keeps its own word boundary.
+      run += pending_neutral;
+      appendRun(out, run, run_voice, run_default);
+      run.clear();
+      run_voice = voice;
+      run_default = !foreign && base_is_default;
+    } else {
+      run += pending_neutral;
+    }
+    pending_neutral.clear();
+    run.append(p, len);
+  }
+  run += pending_neutral;
+  appendRun(out, run, run_voice, run_default);
+}
+
+// Finds the next <lang xml:lang="xx"> (or lang="xx") open tag at or after pos.
+bool findLangTag(const std::string& text, size_t pos, size_t* tag_start, size_t* body_start, std::string* voice) {
+  for (size_t at = text.find("<lang", pos); at != std::string::npos; at = text.find("<lang", at + 1)) {
+    const size_t close = text.find('>', at);
+    if (close == std::string::npos) return false;
+    const std::string tag = text.substr(at, close - at);
+    const size_t attr = tag.find("lang=", 5);
+    if (attr == std::string::npos) continue;
+    size_t q = attr + 5;
+    if (q >= tag.size() || (tag[q] != '"' && tag[q] != '\'')) continue;
+    const char quote = tag[q];
+    const size_t end = tag.find(quote, q + 1);
+    if (end == std::string::npos || end == q + 1) continue;
+    *tag_start = at;
+    *body_start = close + 1;
+    *voice = tag.substr(q + 1, end - q - 1);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+std::vector<LanguageSegment> segmentByLanguage(const std::string& text, const SegmenterOptions& options) {
+  std::vector<LanguageSegment> out;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t tag_start = 0, body_start = 0;
+    std::string voice;
+    if (!findLangTag(text, pos, &tag_start, &body_start, &voice)) {
+      segmentScripts(text.substr(pos), options.default_voice, true, options, out);
+      break;
+    }
+    segmentScripts(text.substr(pos, tag_start - pos), options.default_voice, true, options, out);
+    size_t body_end = text.find("</lang>", body_start);
+    const size_t next = body_end == std::string::npos ? text.size() : body_end + 7;
+    if (body_end == std::string::npos) body_end = text.size();
+    // Tagged text keeps its voice for every script inside it.
+    appendRun(out, text.substr(body_start, body_end - body_start), voice, voice == options.default_voice);
+    pos = next;
+  }
+  return out;
+}
+
+}  // namespace piper
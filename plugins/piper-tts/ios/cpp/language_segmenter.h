@@ -0,0 +1,34 @@
+#ifndef LANGUAGE_SEGMENTER_H
+#define LANGUAGE_SEGMENTER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace piper {
+
+// Splits mixed-language text into runs that each go to one espeak voice.
+// Explicit SSML-style tags win: <lang xml:lang="de">Blitzschlag</lang>. Untagged text is split by
+// Unicode script (Cyrillic, Greek, Arabic, Hebrew, Devanagari, Thai, Hangul, Kana, Han); Latin and
+// script-neutral characters (spaces, digits, punctuation) stay with the surrounding run. Latin-script
+// foreign words cannot be told apart from the default language and need a tag.
+
+struct LanguageSegment {
+  std::string text;
+  std::string voice;  // espeak voice name
+  bool is_default = true;  // voice came from the default (not a tag or a non-Latin script)
+};
+
+struct SegmenterOptions {
+  std::string default_voice = "en-us";
+  // Script name ("cyrillic", "greek", "arabic", "hebrew", "devanagari", "thai", "hangul", "kana", "han")
+  // -> espeak voice. Unlisted scripts use built-in defaults (ru, el, ar, he, hi, th, ko, ja, cmn).
+  std::map<std::string, std::string> script_voices;
+  bool detect_scripts = true;
+};
+
+std::vector<LanguageSegment> segmentByLanguage(const std::string& text, const SegmenterOptions& options);
+
+}  // namespace piper
+
+#endif  // LANGUAGE_SEGMENTER_H
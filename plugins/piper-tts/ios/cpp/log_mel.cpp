@@ -0,0 +1,177 @@
+#include "log_mel.h"
+#include "simd_f32.h"
+#include <algorithm>
+#include <cmath>
+
+namespace piper {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+size_t nextPow2(size_t n) {
+  size_t p = 8;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+double hzToMel(double hz, bool slaney) {
+  if (!slaney) return 2595.0 * std::log10(1.0 + hz / 700.0);
+  // Slaney: linear below 1 kHz, log above.
+  const double f_sp = 200.0 / 3.0;
+  const double min_log_hz = 1000.0;
+  const double min_log_mel = min_log_hz / f_sp;
+  const double logstep = std::log(6.4) / 27.0;
+  if (hz < min_log_hz) return hz / f_sp;
+  return min_log_mel + std::log(hz / min_log_hz) / logstep;
+}
+
+double melToHz(double mel, bool slaney) {
+  if (!slaney) return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+  const double f_sp = 200.0 / 3.0;
+  const double min_log_hz = 1000.0;
+  const double min_log_mel = min_log_hz / f_sp;
+  const double logstep = std::log(6.4) / 27.0;
+  if (mel < min_log_mel) return mel * f_sp;
+  return min_log_hz * std::exp(logstep * (mel - min_log_mel));
+}
+
+}  // namespace
+
+LogMelExtractor::LogMelExtractor(const LogMelConfig& config)
+    : config_(config), fft_(nextPow2(static_cast<size_t>(std::max(config.n_fft, config.win_length)))) {
+  if (config_.f_max <= 0.0f) config_.f_max = config_.sample_rate * 0.5f;
+  config_.n_fft = static_cast<int>(fft_.size());
+  const size_t win = static_cast<size_t>(config_.win_length);
+  window_.resize(win);
+  for (size_t i = 0; i < win; i++) {
+    const double hann = 0.5 - 0.5 * std::cos(2.0 * kPi * static_cast<double>(i) / static_cast<double>(win - 1));
+    window_[i] = static_cast<float>(config_.povey_window ? std::pow(hann, 0.85) : hann);
+  }
+
+  // Triangular filters on the FFT bin grid, kept sparse.
+  const size_t bins = fft_.bins();
+  const double mel_lo = hzToMel(config_.f_min, config_.slaney_mel);
+  const double mel_hi = hzToMel(config_.f_max, config_.slaney_mel);
+  std::vector<double> edges(static_cast<size_t>(config_.n_mels) + 2);
+  for (size_t i = 0; i < edges.size(); i++) {
+    const double mel = mel_lo + (mel_hi - mel_lo) * static_cast<double>(i) / static_cast<double>(edges.size() - 1);
+    edges[i] = melToHz(mel, config_.slaney_mel);
+  }
+  const double bin_hz = static_cast<double>(config_.sample_rate) / static_cast<double>(fft_.size());
+  filters_.resize(static_cast<size_t>(config_.n_mels));
+  for (int m = 0; m < config_.n_mels; m++) {
+    const double lo = edges[m], center = edges[m + 1], hi = edges[m + 2];
+    const double norm = config_.slaney_mel ? 2.0 / (hi - lo) : 1.0;
+    MelFilter& f = filters_[static_cast<size_t>(m)];
+    f.first_bin = -1;
+    for (size_t k = 0; k < bins; k++) {
+      const double hz = static_cast<double>(k) * bin_hz;
+      double w = 0.0;
+      if (hz > lo && hz < hi) w = hz <= center ? (hz - lo) / (center - lo) : (hi - hz) / (hi - center);
+      if (w <= 0.0) {
+        if (f.first_bin >= 0) break;
+        continue;
+      }
+      if (f.first_bin < 0) f.first_bin = static_cast<int>(k);
+      f.weights.push_back(static_cast<float>(w * norm));
+    }
+    if (f.first_bin < 0) f.first_bin = 0;
+  }
+
+  frame_buf_.assign(fft_.size(), 0.0f);
+  power_.assign(bins, 0.0f);
+}
+
+void LogMelExtractor::reset() {
+  samples_.clear();
+  read_pos_ = 0;
+  prev_sample_ = 0.0f;
+  features_.clear();
+}
+
+void LogMelExtractor::accept(const float* samples, size_t count) {
+  const size_t win = static_cast<size_t>(config_.win_length);
+  const size_t hop = static_cast<size_t>(config_.hop_length);
+  const size_t old = samples_.size();
+  samples_.resize(old + count);
+  float* dst = samples_.data() + old;
+  if (config_.preemphasis > 0.0f) {
+    const float a = config_.preemphasis;
+    float prev = prev_sample_;
+    for (size_t i = 0; i < count; i++) {
+      dst[i] = samples[i] - a * prev;
+      prev = samples[i];
+    }
+    prev_sample_ = prev;
+  } else {
+    std::copy(samples, samples + count, dst);
+  }
+
+  while (samples_.size() - read_pos_ >= win) {
+    computeFrame(samples_.data() + read_pos_);
+    read_pos_ += hop;
+  }
+  // Compact once the consumed prefix dominates, so steady-state streaming does not grow.
+  if (read_pos_ > 4 * win) {
+    samples_.erase(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(read_pos_));
+    read_pos_ = 0;
+  }
+}
+
+void LogMelExtractor::flush() {
+  const size_t win = static_cast<size_t>(config_.win_length);
+  const size_t remaining = samples_.size() - read_pos_;
+  // Emit a final frame only if at least half a hop of unframed audio is left.
+  if (remaining * 2 >= static_cast<size_t>(config_.hop_length)) {
+    std::vector<float> tail(win, 0.0f);
+    std::copy(samples_.begin() + static_cast<std::ptrdiff_t>(read_pos_), samples_.end(), tail.begin());
+    computeFrame(tail.data());
+  }
+  samples_.clear();
+  read_pos_ = 0;
+}
+
+size_t LogMelExtractor::takeFrames(std::vector<float>& dst) {
+  const size_t frames = pendingFrames();
+  dst.insert(dst.end(), features_.begin(), features_.end());
+  features_.clear();
+  return frames;
+}
+
+void LogMelExtractor::computeFrame(const float* in) {
+  using namespace piper_simd;
+  const size_t win = static_cast<size_t>(config_.win_length);
+  float* buf = frame_buf_.data();
+  float mean = 0.0f;
+  if (config_.remove_dc) {
+    double sum = 0.0;
+    for (size_t i = 0; i < win; i++) sum += in[i];
+    mean = static_cast<float>(sum / static_cast<double>(win));
+  }
+  const f32x4 vmean = set1(mean);
+  size_t i = 0;
+  for (; i + 4 <= win; i += 4) store(buf + i, mul(sub(load(in + i), vmean), load(window_.data() + i)));
+  for (; i < win; i++) buf[i] = (in[i] - mean) * window_[i];
+  // Tail [win, n_fft) stays zero from construction.
+
+  fft_.powerSpectrum(buf, power_.data());
+
+  const size_t row = features_.size();
+  features_.resize(row + static_cast<size_t>(config_.n_mels));
+  float* out = features_.data() + row;
+  for (size_t m = 0; m < filters_.size(); m++) {
+    const MelFilter& f = filters_[m];
+    const float* p = power_.data() + f.first_bin;
+    const float* w = f.weights.data();
+    const size_t n = f.weights.size();
+    f32x4 acc = set1(0.0f);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) acc = fmadd(acc, load(p + k), load(w + k));
+    float e = hsum(acc);
+    for (; k < n; k++) e += p[k] * w[k];
+    out[m] = std::log(std::max(e, config_.log_floor));
+  }
+}
+
+}  // namespace piper
@@ -0,0 +1,72 @@
+#ifndef LOG_MEL_H
+#define LOG_MEL_H
+
+#include "fft.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace piper {
+
+// Feature front-end settings. Defaults: 16 kHz, 25 ms Hann window, 10 ms hop, 80 HTK mels.
+struct LogMelConfig {
+  int sample_rate = 16000;
+  int n_fft = 512;
+  int win_length = 400;
+  int hop_length = 160;
+  int n_mels = 80;
+  float f_min = 0.0f;
+  float f_max = 0.0f;          // <= 0: sample_rate / 2
+  float preemphasis = 0.0f;    // e.g. 0.97 (NeMo); 0 = off
+  bool remove_dc = false;      // subtract per-frame mean before windowing (Kaldi)
+  bool povey_window = false;   // Kaldi "povey" window instead of Hann
+  bool slaney_mel = false;     // Slaney mel scale + area normalization (librosa/NeMo) instead of HTK
+  float log_floor = 1e-10f;    // log(max(energy, floor))
+};
+
+// Streaming log-mel extractor. Accepts samples in arbitrary chunk sizes and emits one
+// n_mels row per hop once a full window is available. Mel filters are stored sparse
+// (first bin + weights); FFT and filter dot products use simd_f32.h.
+class LogMelExtractor {
+ public:
+  explicit LogMelExtractor(const LogMelConfig& config);
+
+  const LogMelConfig& config() const { return config_; }
+  int numMels() const { return config_.n_mels; }
+
+  // Append samples in [-1, 1]. Completed frames are appended to the pending feature buffer.
+  void accept(const float* samples, size_t count);
+
+  // Zero-pad and emit the trailing partial window (end of utterance).
+  void flush();
+
+  // Move pending rows ([frames][n_mels], row-major) onto dst; returns frames moved.
+  size_t takeFrames(std::vector<float>& dst);
+
+  size_t pendingFrames() const { return features_.size() / static_cast<size_t>(config_.n_mels); }
+
+  void reset();
+
+ private:
+  void computeFrame(const float* window_samples);
+
+  struct MelFilter {
+    int first_bin = 0;
+    std::vector<float> weights;
+  };
+
+  LogMelConfig config_;
+  RealFft fft_;
+  std::vector<float> window_;
+  std::vector<MelFilter> filters_;
+  std::vector<float> samples_;   // unframed input; consumed prefix is [0, read_pos_)
+  size_t read_pos_ = 0;
+  float prev_sample_ = 0.0f;     // for preemphasis across chunks
+  std::vector<float> frame_buf_;  // n_fft, zero-padded past win_length
+  std::vector<float> power_;
+  std::vector<float> features_;
+};
+
+}  // namespace piper
+
+#endif  // LOG_MEL_H
@@ -0,0 +1,138 @@
+#include "memory_accounting.h"
+#include "ort_env.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace piper_mem {
+
+namespace {
+
+std::atomic<size_t> g_live_bytes{0};
+thread_local OrtWindow* t_window = nullptr;
+
+#if defined(PIPER_ORT_ALLOC_STATS)
+// Matches ORT's preferred CPU buffer alignment; the size header lives in the padding in front of the block.
+constexpr size_t kAlignment = 64;
+
+void* countingAlloc(OrtAllocator*, size_t size) {
+  void* base = nullptr;
+  if (posix_memalign(&base, kAlignment, size + kAlignment) != 0) return nullptr;
+  std::memcpy(base, &size, sizeof(size));
+  g_live_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (t_window) t_window->charge(static_cast<int64_t>(size));
+  return static_cast<char*>(base) + kAlignment;
+}
+
+void countingFree(OrtAllocator*, void* p) {
+  if (!p) return;
+  void* base = static_cast<char*>(p) - kAlignment;
+  size_t size = 0;
+  std::memcpy(&size, base, sizeof(size));
+  g_live_bytes.fetch_sub(size, std::memory_order_relaxed);
+  if (t_window) t_window->charge(-static_cast<int64_t>(size));
+  std::free(base);
+}
+
+OrtMemoryInfo* g_memory_info = nullptr;
+
+const OrtMemoryInfo* countingInfo(const OrtAllocator*) { return g_memory_info; }
+
+OrtAllocator g_allocator{};
+std::once_flag g_allocator_once;
+
+void createAllocator() {
+  const OrtApi* api = piper_ort::getApi();
+  if (!api) return;
+  OrtStatus* status = api->CreateCpuMemoryInfo(OrtDeviceAllocator, OrtMemTypeDefault, &g_memory_info);
+  if (status) {
+    piper_ort::logOrtStatus(api, status);
+    g_memory_info = nullptr;
+    return;
+  }
+  g_allocator.version = ORT_API_VERSION;
+  g_allocator.Alloc = countingAlloc;
+  g_allocator.Free = countingFree;
+  g_allocator.Info = countingInfo;
+#if ORT_API_VERSION >= 18
+  g_allocator.Reserve = countingAlloc;
+#endif
+}
+#endif  // PIPER_ORT_ALLOC_STATS
+
+}  // namespace
+
+size_t residentBytes() {
+#if defined(__APPLE__)
+  task_vm_info_data_t info;
+  mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+  if (task_info(mach_task_self(), TASK_VM_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return static_cast<size_t>(info.phys_footprint);
+#else
+  FILE* f = std::fopen("/proc/self/statm", "r");
+  if (!f) return 0;
+  unsigned long size_pages = 0, resident_pages = 0;
+  const int n = std::fscanf(f, "%lu %lu", &size_pages, &resident_pages);
+  std::fclose(f);
+  if (n != 2) return 0;
+  return static_cast<size_t>(resident_pages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+OrtAllocator* countingAllocator() {
+#if defined(PIPER_ORT_ALLOC_STATS)
+  std::call_once(g_allocator_once, createAllocator);
+  return g_memory_info ? &g_allocator : nullptr;
+#else
+  return nullptr;
+#endif
+}
+
+size_t ortLiveBytes() { return g_live_bytes.load(std::memory_order_relaxed); }
+
+OrtWindow::OrtWindow() : start_live_(ortLiveBytes()) {}
+
+void OrtWindow::charge(int64_t bytes) {
+  if (bytes > 0) allocs_.fetch_add(1, std::memory_order_relaxed);
+  const int64_t net = net_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  int64_t peak = peak_.load(std::memory_order_relaxed);
+  while (net > peak && !peak_.compare_exchange_weak(peak, net, std::memory_order_relaxed)) {
+  }
+}
+
+size_t OrtWindow::netBytes() const {
+  const int64_t net = net_.load(std::memory_order_relaxed);
+  return net > 0 ? static_cast<size_t>(net) : 0;
+}
+
+OrtAllocCounters OrtWindow::counters() const {
+  OrtAllocCounters c;
+  c.live_bytes = start_live_;
+  c.peak_bytes = static_cast<size_t>(peak_.load(std::memory_order_relaxed));
+  c.alloc_count = allocs_.load(std::memory_order_relaxed);
+  return c;
+}
+
+OrtWindowScope::OrtWindowScope(OrtWindow* window) : previous_(t_window) { t_window = window; }
+
+OrtWindowScope::~OrtWindowScope() { t_window = previous_; }
+
+OrtWindow* OrtWindowScope::current() { return t_window; }
+
+size_t ResidentTracker::sample() {
+  const size_t now = residentBytes();
+  if (now > peak_) peak_ = now;
+  return now > start_ ? now - start_ : 0;
+}
+
+}  // namespace piper_mem
@@ -0,0 +1,82 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <onnxruntime_c_api.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace piper_mem {
+
+// Resident memory of this process in bytes (Android/Linux: /proc/self/statm RSS; Apple: phys_footprint).
+// 0 if unavailable.
+size_t residentBytes();
+
+// Counting CPU allocator registered on the shared OrtEnv (ort_env.cpp) in builds with PIPER_ORT_ALLOC_STATS;
+// nullptr otherwise. Piper sessions opt in via session.use_env_allocators (createSharedSessionOptions), so
+// their ORT buffers (initializers, intermediates, outputs) go through it; embedding and ASR keep ORT's arena.
+OrtAllocator* countingAllocator();
+
+// ORT bytes live in the counting allocator, process-wide.
+size_t ortLiveBytes();
+
+struct OrtAllocCounters {
+  size_t live_bytes = 0;      // process-wide, when the window opened
+  size_t peak_bytes = 0;      // largest net growth charged to the window
+  uint64_t alloc_count = 0;   // allocations charged to the window
+};
+
+// ORT allocations of one request (or replica creation). While an OrtWindowScope for it is active on a
+// thread, the counting allocator charges that thread's allocations and frees to the window, so concurrent
+// requests do not disturb each other's figures. ORT allocates a session's buffers on the thread calling Run.
+class OrtWindow {
+ public:
+  OrtWindow();
+  OrtWindow(const OrtWindow&) = delete;
+  OrtWindow& operator=(const OrtWindow&) = delete;
+
+  OrtAllocCounters counters() const;
+  // Net growth charged so far (0 if frees outweighed allocations).
+  size_t netBytes() const;
+  // Called by the counting allocator: +size for an allocation, -size for a free.
+  void charge(int64_t bytes);
+
+ private:
+  size_t start_live_;
+  std::atomic<int64_t> net_{0};
+  std::atomic<int64_t> peak_{0};
+  std::atomic<uint64_t> allocs_{0};
+};
+
+// Charges this thread's ORT allocations to `window` (nullptr: to none) until destroyed; scopes nest.
+class OrtWindowScope {
+ public:
+  explicit OrtWindowScope(OrtWindow* window);
+  ~OrtWindowScope();
+  OrtWindowScope(const OrtWindowScope&) = delete;
+  OrtWindowScope& operator=(const OrtWindowScope&) = delete;
+
+  // The window this thread is charging, or nullptr; hand it to worker threads that run for the request.
+  static OrtWindow* current();
+
+ private:
+  OrtWindow* previous_;
+};
+
+// Peak resident growth over a request, sampled at stage boundaries (not a continuous high-water mark).
+class ResidentTracker {
+ public:
+  ResidentTracker() : start_(residentBytes()), peak_(start_) {}
+  // Samples RSS; returns growth since construction (0 if it shrank).
+  size_t sample();
+  size_t start() const { return start_; }
+  size_t peakDelta() const { return peak_ > start_ ? peak_ - start_ : 0; }
+
+ private:
+  size_t start_;
+  size_t peak_;
+};
+
+}  // namespace piper_mem
+
+#endif  // MEMORY_ACCOUNTING_H
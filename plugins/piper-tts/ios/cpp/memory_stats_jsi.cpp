@@ -0,0 +1,63 @@
+#include "memory_stats_jsi.h"
+#include "memory_accounting.h"
+#include "piper_engine.h"
+#include <jsi/jsi.h>
+#include <utility>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+namespace {
+
+jsi::Object reportToJs(jsi::Runtime& rt, const SynthesisMemoryReport& m) {
+  jsi::Object o(rt);
+  o.setProperty(rt, "phonemeBytes", static_cast<double>(m.phoneme_bytes));
+  o.setProperty(rt, "espeakRssDelta", static_cast<double>(m.espeak_rss_delta));
+  o.setProperty(rt, "ortLiveBytes", static_cast<double>(m.ort_live_bytes));
+  o.setProperty(rt, "ortPeakBytes", static_cast<double>(m.ort_peak_bytes));
+  o.setProperty(rt, "ortAllocCount", static_cast<double>(m.ort_alloc_count));
+  o.setProperty(rt, "floatAudioBytes", static_cast<double>(m.float_audio_bytes));
+  o.setProperty(rt, "pcmBytes", static_cast<double>(m.pcm_bytes));
+  o.setProperty(rt, "scratchBytes", static_cast<double>(m.scratch_bytes));
+  o.setProperty(rt, "scratchBlockMallocs", static_cast<double>(m.scratch_block_mallocs));
+  o.setProperty(rt, "outputBytes", static_cast<double>(m.output_bytes));
+  o.setProperty(rt, "rssStart", static_cast<double>(m.rss_start));
+  o.setProperty(rt, "rssPeakDelta", static_cast<double>(m.rss_peak_delta));
+  return o;
+}
+
+}  // namespace
+
+void installMemoryStatsJsi(jsi::Runtime& runtime) {
+  auto stats = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperSynthesisMemoryStats"), 1,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        const SynthesisMemoryStats s = synthesisMemoryStats();
+        jsi::Object result(rt);
+        result.setProperty(rt, "requests", static_cast<double>(s.requests));
+        result.setProperty(rt, "last", reportToJs(rt, s.last));
+        result.setProperty(rt, "max", reportToJs(rt, s.max));
+        result.setProperty(rt, "mean", reportToJs(rt, s.mean));
+        result.setProperty(rt, "ortLiveBytes", static_cast<double>(piper_mem::ortLiveBytes()));
+        result.setProperty(rt, "residentBytes", static_cast<double>(piper_mem::residentBytes()));
+        const std::vector<SynthesisSessionStats> pools = synthesisSessionStats();
+        jsi::Array sessions(rt, pools.size());
+        for (size_t i = 0; i < pools.size(); ++i) {
+          jsi::Object p(rt);
+          p.setProperty(rt, "modelPath", jsi::String::createFromUtf8(rt, pools[i].model_path));
+          p.setProperty(rt, "replicas", static_cast<double>(pools[i].replicas));
+          p.setProperty(rt, "sharedInitializers", static_cast<double>(pools[i].shared_initializers));
+          p.setProperty(rt, "sharedWeightBytes", static_cast<double>(pools[i].shared_weight_bytes));
+          p.setProperty(rt, "firstReplicaBytes", static_cast<double>(pools[i].first_replica_bytes));
+          p.setProperty(rt, "replicaOverheadBytes", static_cast<double>(pools[i].replica_overhead_bytes));
+          sessions.setValueAtIndex(rt, i, std::move(p));
+        }
+        result.setProperty(rt, "sessions", std::move(sessions));
+        if (count > 0 && args[0].isBool() && args[0].getBool()) resetSynthesisMemoryStats();
+        return result;
+      });
+  runtime.global().setProperty(runtime, "__piperSynthesisMemoryStats", std::move(stats));
+}
+
+}  // namespace piper
@@ -0,0 +1,19 @@
+#ifndef MEMORY_STATS_JSI_H
+#define MEMORY_STATS_JSI_H
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+}
+}  // namespace facebook
+
+namespace piper {
+
+// Install the synthesis memory accounting host functions:
+//   __piperSynthesisMemoryStats(reset?: boolean) -> { requests, last, max, mean, ortLiveBytes, residentBytes }
+// where last/max/mean are per-stage byte reports (see SynthesisMemoryReport in piper_engine.h).
+void installMemoryStatsJsi(facebook::jsi::Runtime& runtime);
+
+}  // namespace piper
+
+#endif  // MEMORY_STATS_JSI_H
@@ -0,0 +1,172 @@
+#include "onnx_initializers.h"
+
+namespace piper_ort {
+
+namespace {
+
+// ModelProto / GraphProto / TensorProto field numbers (onnx.proto3).
+constexpr uint32_t kModelGraph = 7;
+constexpr uint32_t kGraphInitializer = 5;
+constexpr uint32_t kTensorDims = 1;
+constexpr uint32_t kTensorDataType = 2;
+constexpr uint32_t kTensorFloatData = 4;
+constexpr uint32_t kTensorInt32Data = 5;
+constexpr uint32_t kTensorStringData = 6;
+constexpr uint32_t kTensorInt64Data = 7;
+constexpr uint32_t kTensorName = 8;
+constexpr uint32_t kTensorRawData = 9;
+constexpr uint32_t kTensorDoubleData = 10;
+constexpr uint32_t kTensorUint64Data = 11;
+constexpr uint32_t kTensorExternalData = 13;
+constexpr uint32_t kTensorDataLocation = 14;
+
+enum WireType : uint32_t { kVarint = 0, kFixed64 = 1, kLengthDelimited = 2, kFixed32 = 5 };
+
+class Reader {
+ public:
+  Reader(const uint8_t* data, size_t begin, size_t end) : data_(data), pos_(begin), end_(end) {}
+  bool done() const { return pos_ >= end_; }
+  size_t pos() const { return pos_; }
+
+  bool varint(uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos_ < end_; shift += 7) {
+      const uint8_t b = data_[pos_++];
+      v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80)) return true;
+    }
+    return false;
+  }
+
+  // Next field; for kLengthDelimited, [sub_begin, sub_end) is the payload and is skipped over.
+  bool field(uint32_t& number, uint32_t& wire, uint64_t& value, size_t& sub_begin, size_t& sub_end) {
+    uint64_t key = 0;
+    if (!varint(key)) return false;
+    number = static_cast<uint32_t>(key >> 3);
+    wire = static_cast<uint32_t>(key & 7);
+    switch (wire) {
+      case kVarint:
+        return varint(value);
+      case kFixed64:
+        if (end_ - pos_ < 8) return false;
+        pos_ += 8;
+        return true;
+      case kFixed32:
+        if (end_ - pos_ < 4) return false;
+        pos_ += 4;
+        return true;
+      case kLengthDelimited: {
+        uint64_t len = 0;
+        if (!varint(len) || len > end_ - pos_) return false;
+        sub_begin = pos_;
+        sub_end = pos_ + static_cast<size_t>(len);
+        pos_ = sub_end;
+        return true;
+      }
+      default:
+        return false;  // groups are not used by ONNX
+    }
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t pos_;
+  size_t end_;
+};
+
+bool readTensor(const uint8_t* data, size_t begin, size_t end, OnnxInitializer& t, bool& shareable) {
+  Reader r(data, begin, end);
+  bool has_raw = false;
+  bool typed_or_external = false;
+  while (!r.done()) {
+    uint32_t number = 0, wire = 0;
+    uint64_t value = 0;
+    size_t sb = 0, se = 0;
+    if (!r.field(number, wire, value, sb, se)) return false;
+    if (number == kTensorDims) {
+      if (wire == kVarint) {
+        t.dims.push_back(static_cast<int64_t>(value));
+      } else if (wire == kLengthDelimited) {
+        Reader packed(data, sb, se);
+        while (!packed.done()) {
+          uint64_t d = 0;
+          if (!packed.varint(d)) return false;
+          t.dims.push_back(static_cast<int64_t>(d));
+        }
+      }
+    } else if (number == kTensorDataType && wire == kVarint) {
+      t.data_type = static_cast<int32_t>(value);
+    } else if (number == kTensorName && wire == kLengthDelimited) {
+      t.name.assign(reinterpret_cast<const char*>(data + sb), se - sb);
+    } else if (number == kTensorRawData && wire == kLengthDelimited) {
+      t.offset = sb;
+      t.size = se - sb;
+      has_raw = true;
+    } else if (number == kTensorDataLocation && wire == kVarint) {
+      typed_or_external |= value != 0;
+    } else if (number == kTensorFloatData || number == kTensorInt32Data || number == kTensorStringData ||
+               number == kTensorInt64Data || number == kTensorDoubleData || number == kTensorUint64Data ||
+               number == kTensorExternalData) {
+      typed_or_external = true;
+    }
+  }
+  size_t elements = 1;
+  for (int64_t d : t.dims) elements *= d > 0 ? static_cast<size_t>(d) : 0;
+  const size_t elem = onnxElementSize(t.data_type);
+  shareable = has_raw && !typed_or_external && !t.name.empty() && elem > 0 && elements * elem == t.size;
+  return true;
+}
+
+}  // namespace
+
+size_t onnxElementSize(int32_t data_type) {
+  switch (data_type) {
+    case 1: return 4;   // FLOAT
+    case 2: return 1;   // UINT8
+    case 3: return 1;   // INT8
+    case 4: return 2;   // UINT16
+    case 5: return 2;   // INT16
+    case 6: return 4;   // INT32
+    case 7: return 8;   // INT64
+    case 9: return 1;   // BOOL
+    case 10: return 2;  // FLOAT16
+    case 11: return 8;  // DOUBLE
+    case 12: return 4;  // UINT32
+    case 13: return 8;  // UINT64
+    case 16: return 2;  // BFLOAT16
+    default: return 0;
+  }
+}
+
+bool readOnnxInitializers(const uint8_t* data, size_t size, std::vector<OnnxInitializer>& out, std::string* error) {
+  auto fail = [error](const char* msg) {
+    if (error) *error = msg;
+    return false;
+  };
+  out.clear();
+  if (!data || size == 0) return fail("empty model");
+  Reader model(data, 0, size);
+  bool has_graph = false;
+  while (!model.done()) {
+    uint32_t number = 0, wire = 0;
+    uint64_t value = 0;
+    size_t gb = 0, ge = 0;
+    if (!model.field(number, wire, value, gb, ge)) return fail("malformed ModelProto");
+    if (number != kModelGraph || wire != kLengthDelimited) continue;
+    has_graph = true;
+    Reader graph(data, gb, ge);
+    while (!graph.done()) {
+      size_t tb = 0, te = 0;
+      if (!graph.field(number, wire, value, tb, te)) return fail("malformed GraphProto");
+      if (number != kGraphInitializer || wire != kLengthDelimited) continue;
+      OnnxInitializer t;
+      bool shareable = false;
+      if (!readTensor(data, tb, te, t, shareable)) return fail("malformed TensorProto");
+      if (shareable) out.push_back(std::move(t));
+    }
+  }
+  if (!has_graph) return fail("no graph in model");
+  return true;
+}
+
+}  // namespace piper_ort
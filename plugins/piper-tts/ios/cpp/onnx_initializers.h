@@ -0,0 +1,31 @@
+#ifndef ONNX_INITIALIZERS_H
+#define ONNX_INITIALIZERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace piper_ort {
+
+// One top-level graph initializer stored as raw_data in an .onnx file.
+struct OnnxInitializer {
+  std::string name;
+  int32_t data_type = 0;  // TensorProto.DataType (same numbering as ONNXTensorElementDataType)
+  std::vector<int64_t> dims;
+  size_t offset = 0;  // raw_data bytes within the file
+  size_t size = 0;
+};
+
+// Minimal protobuf walk over ModelProto.graph.initializer (no protobuf dependency). Tensors with typed data
+// fields (float_data, ...), external data, or a raw_data size that does not match dims x element size are
+// skipped; they stay in the model as usual. False only if the bytes are not a well-formed ModelProto.
+bool readOnnxInitializers(const uint8_t* data, size_t size, std::vector<OnnxInitializer>& out,
+                          std::string* error = nullptr);
+
+// Bytes per element for a TensorProto data type; 0 for strings and types we do not share.
+size_t onnxElementSize(int32_t data_type);
+
+}  // namespace piper_ort
+
+#endif  // ONNX_INITIALIZERS_H
@@ -1,10 +1,24 @@
 #include "ort_capi_adapter.h"
+#include "fused_decoder_ops.h"
+#include "memory_accounting.h"
+#include "onnx_initializers.h"
+#include "ort_env.h"
 #include <onnxruntime_c_api.h>
 #include <cstdio>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define PIPER_ORT_LOG(fmt, ...) std::fprintf(stderr, "[PiperORT] " fmt "\n", ##__VA_ARGS__)
 
@@ -44,13 +58,6 @@ static bool logSessionIONamesAndDetectSid(const OrtApi* api, OrtSession* sess) {
   return has_sid;
 }
 
-static void logOrtStatus(const OrtApi* api, OrtStatus* status) {
-  if (!status) return;
-  const char* msg = api->GetErrorMessage(status);
-  PIPER_ORT_LOG("ORT error: %s", msg ? msg : "(no message)");
-  api->ReleaseStatus(status);
-}
-
 static const char* elementTypeStr(ONNXTensorElementDataType t) {
   switch (t) {
     case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: return "float32";
@@ -68,55 +75,181 @@ static const char* elementTypeStr(ONNXTensorElementDataType t) {
 
 struct PiperOrtSession {
   const OrtApi* api = nullptr;
-  OrtEnv* env = nullptr;
+  OrtEnv* env = nullptr;  // Shared process-wide env (see ort_env.h); not owned.
   OrtSession* session = nullptr;
   OrtSessionOptions* session_options = nullptr;
+  // I/O introspected on first run; per session since the engine alternates voices for mixed-language text.
+  bool io_logged = false;
+  bool has_sid = false;
+};
+
+// Weights every session of one model shares: raw_data initializers copied once into an aligned block and
+// handed to each session with AddInitializer, plus the prepacked-weights container. Must outlive those sessions.
+struct SharedWeights {
+  std::string model_path;
+  OrtPrepackedWeightsContainer* container = nullptr;
+  OrtMemoryInfo* memory_info = nullptr;
+  std::vector<std::pair<std::string, OrtValue*>> initializers;
+  void* buffer = nullptr;
+  size_t bytes = 0;
+
+  ~SharedWeights() {
+    const OrtApi* api = getApi();
+    if (!api) return;
+    for (auto& init : initializers) api->ReleaseValue(init.second);
+    if (memory_info) api->ReleaseMemoryInfo(memory_info);
+    if (container) api->ReleasePrepackedWeightsContainer(container);
+    std::free(buffer);
+  }
 };
 
-static const OrtApi* getApi() {
-  const OrtApiBase* base = OrtGetApiBase();
-  if (!base) return nullptr;
-  return base->GetApi(ORT_API_VERSION);
+// Initializers smaller than this stay in the model (shape constants and the like; not worth an OrtValue each).
+static constexpr size_t kMinSharedInitializerBytes = 1024;
+static constexpr size_t kSharedWeightAlign = 64;
+// Piper's audio output is [1, 1, T]; anything deeper is rejected.
+static constexpr size_t kMaxOutputRank = 8;
+
+static size_t alignedWeightSize(size_t n) {
+  return (n + kSharedWeightAlign - 1) / kSharedWeightAlign * kSharedWeightAlign;
+}
+
+// Model path -> live shared weights; an entry lives as long as some pool holds it.
+static std::mutex g_shared_weights_mutex;
+static std::map<std::string, std::weak_ptr<SharedWeights>> g_shared_weights;
+
+// Maps the model, copies its shareable initializers into one aligned block and wraps each as an OrtValue.
+// Leaves initializers empty (sessions then load weights themselves) if the model cannot be read.
+static void loadSharedInitializers(const OrtApi* api, SharedWeights& w) {
+  const int fd = ::open(w.model_path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) return;
+  const auto* bytes = static_cast<const uint8_t*>(map);
+  std::vector<OnnxInitializer> found;
+  std::string error;
+  if (!readOnnxInitializers(bytes, size, found, &error)) {
+    PIPER_ORT_LOG("Shared weights: %s not readable (%s); sessions load their own", w.model_path.c_str(),
+                  error.c_str());
+    munmap(map, size);
+    return;
+  }
+  found.erase(std::remove_if(found.begin(), found.end(),
+                             [](const OnnxInitializer& t) { return t.size < kMinSharedInitializerBytes; }),
+              found.end());
+  size_t total = 0;
+  for (const OnnxInitializer& t : found) total += alignedWeightSize(t.size);
+  if (total == 0 || posix_memalign(&w.buffer, kSharedWeightAlign, total) != 0) {
+    w.buffer = nullptr;
+    munmap(map, size);
+    return;
+  }
+  OrtStatus* status = api->CreateCpuMemoryInfo(OrtDeviceAllocator, OrtMemTypeDefault, &w.memory_info);
+  if (status) {
+    logOrtStatus(api, status);
+    munmap(map, size);
+    return;
+  }
+  size_t offset = 0;
+  for (const OnnxInitializer& t : found) {
+    uint8_t* dst = static_cast<uint8_t*>(w.buffer) + offset;
+    std::memcpy(dst, bytes + t.offset, t.size);
+    OrtValue* value = nullptr;
+    status = api->CreateTensorWithDataAsOrtValue(w.memory_info, dst, t.size, t.dims.data(), t.dims.size(),
+                                                 static_cast<ONNXTensorElementDataType>(t.data_type), &value);
+    if (status) {
+      logOrtStatus(api, status);
+      continue;
+    }
+    w.initializers.emplace_back(t.name, value);
+    offset += alignedWeightSize(t.size);
+  }
+  w.bytes = offset;
+  munmap(map, size);
+  PIPER_ORT_LOG("Shared weights: %zu initializer(s), %zu bytes for %s", w.initializers.size(), w.bytes,
+                w.model_path.c_str());
 }
 
+static std::shared_ptr<SharedWeights> acquireSharedWeights(const OrtApi* api, const std::string& model_path) {
+  std::lock_guard<std::mutex> lock(g_shared_weights_mutex);
+  auto it = g_shared_weights.find(model_path);
+  if (it != g_shared_weights.end()) {
+    if (auto live = it->second.lock()) return live;
+  }
+  auto w = std::make_shared<SharedWeights>();
+  w->model_path = model_path;
+  OrtStatus* status = api->CreatePrepackedWeightsContainer(&w->container);
+  if (status) {
+    // Still usable: replicas just prepack their own weights.
+    logOrtStatus(api, status);
+    w->container = nullptr;
+  }
+  loadSharedInitializers(api, *w);
+  for (auto e = g_shared_weights.begin(); e != g_shared_weights.end();) {
+    e = e->second.expired() ? g_shared_weights.erase(e) : std::next(e);
+  }
+  g_shared_weights[model_path] = w;
+  return w;
+}
+
+static PiperOrtSession* createSessionWithWeights(const char* model_path, const SharedWeights* weights);
+
 PiperOrtSession* createSession(const char* model_path) {
+  return createSessionWithWeights(model_path, nullptr);
+}
+
+static PiperOrtSession* createSessionWithWeights(const char* model_path, const SharedWeights* weights) {
   const OrtApi* api = getApi();
   if (!api) return nullptr;
 
   auto* s = new PiperOrtSession();
   s->api = api;
 
-  OrtStatus* status;
-  status = api->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "piper", &s->env);
-  if (status) {
-    api->ReleaseStatus(status);
+  s->env = sharedEnv();
+  if (!s->env) {
     delete s;
     return nullptr;
   }
-  api->DisableTelemetryEvents(s->env);
 
-  status = api->CreateSessionOptions(&s->session_options);
-  if (status) {
-    api->ReleaseStatus(status);
-    api->ReleaseEnv(s->env);
+  s->session_options = createSharedSessionOptions(ORT_DISABLE_ALL, /*count_allocations=*/true);
+  if (!s->session_options) {
     delete s;
     return nullptr;
   }
-  api->SetSessionGraphOptimizationLevel(s->session_options, ORT_DISABLE_ALL);
   api->DisableCpuMemArena(s->session_options);
   api->DisableMemPattern(s->session_options);
-  api->DisableProfiling(s->session_options);
+  // Voices rewritten by host/decoder_fuse need the fused decoder kernels; stock exports ignore the domain.
+  registerFusedDecoderOps(s->session_options);
 
+  OrtStatus* status;
+  if (weights) {
+    // Optimizations stay disabled (ORT_DISABLE_ALL), so no initializer is rewritten and all of them can be shared.
+    for (const auto& init : weights->initializers) {
+      status = api->AddInitializer(s->session_options, init.first.c_str(), init.second);
+      if (status) logOrtStatus(api, status);  // that tensor is then loaded from the model as usual
+    }
+  }
 #ifdef _WIN32
   std::wstring wpath(model_path, model_path + strlen(model_path));
-  status = api->CreateSession(s->env, wpath.c_str(), s->session_options, &s->session);
+  const ORTCHAR_T* ort_path = wpath.c_str();
 #else
-  status = api->CreateSession(s->env, model_path, s->session_options, &s->session);
+  const ORTCHAR_T* ort_path = model_path;
 #endif
+  if (weights && weights->container) {
+    status = api->CreateSessionWithPrepackedWeightsContainer(s->env, ort_path, s->session_options, weights->container,
+                                                             &s->session);
+  } else {
+    status = api->CreateSession(s->env, ort_path, s->session_options, &s->session);
+  }
   if (status) {
-    api->ReleaseStatus(status);
+    logOrtStatus(api, status);
     api->ReleaseSessionOptions(s->session_options);
-    api->ReleaseEnv(s->env);
     delete s;
     return nullptr;
   }
@@ -128,10 +261,123 @@ void destroySession(PiperOrtSession* session) {
   const OrtApi* api = session->api;
   if (session->session) api->ReleaseSession(session->session);
   if (session->session_options) api->ReleaseSessionOptions(session->session_options);
-  if (session->env) api->ReleaseEnv(session->env);
   delete session;
 }
 
+struct PiperOrtSessionPool {
+  std::string model_path;
+  std::shared_ptr<SharedWeights> weights;
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<PiperOrtSession*> replicas;
+  std::vector<PiperOrtSession*> idle;
+  size_t creating = 0;  // replicas being created outside the lock
+  size_t first_replica_bytes = 0;
+  size_t extra_replica_bytes = 0;  // sum over replicas after the first
+};
+
+// Creates a replica and returns the ORT allocator growth it caused.
+static PiperOrtSession* createReplica(PiperOrtSessionPool* pool, size_t* ort_bytes) {
+  piper_mem::OrtWindow window;
+  PiperOrtSession* s = nullptr;
+  {
+    piper_mem::OrtWindowScope scope(&window);
+    s = createSessionWithWeights(pool->model_path.c_str(), pool->weights.get());
+  }
+  *ort_bytes = window.netBytes();
+  return s;
+}
+
+PiperOrtSessionPool* createSessionPool(const char* model_path) {
+  const OrtApi* api = getApi();
+  if (!api || !model_path) return nullptr;
+  auto* pool = new PiperOrtSessionPool();
+  pool->model_path = model_path;
+  pool->weights = acquireSharedWeights(api, pool->model_path);
+  PiperOrtSession* first = createReplica(pool, &pool->first_replica_bytes);
+  if (!first) {
+    delete pool;
+    return nullptr;
+  }
+  PIPER_ORT_LOG("Session pool: replica 1 created for %s (+%zu ORT bytes, %zu shared weight bytes)",
+                pool->model_path.c_str(), pool->first_replica_bytes, pool->weights->bytes);
+  pool->replicas.push_back(first);
+  pool->idle.push_back(first);
+  return pool;
+}
+
+void destroySessionPool(PiperOrtSessionPool* pool) {
+  if (!pool) return;
+  {
+    std::unique_lock<std::mutex> lock(pool->mu);
+    pool->cv.wait(lock, [pool] { return pool->creating == 0 && pool->idle.size() == pool->replicas.size(); });
+  }
+  for (PiperOrtSession* s : pool->replicas) destroySession(s);
+  // The shared weights (container, initializer buffers) must outlive every session created with them.
+  delete pool;
+}
+
+PiperOrtSession* acquireReplica(PiperOrtSessionPool* pool, size_t max_replicas) {
+  if (!pool) return nullptr;
+  std::unique_lock<std::mutex> lock(pool->mu);
+  for (;;) {
+    if (!pool->idle.empty()) {
+      PiperOrtSession* s = pool->idle.back();
+      pool->idle.pop_back();
+      return s;
+    }
+    if (pool->replicas.size() + pool->creating < std::max<size_t>(1, max_replicas)) {
+      ++pool->creating;
+      lock.unlock();
+      size_t ort_bytes = 0;
+      PiperOrtSession* s = createReplica(pool, &ort_bytes);
+      lock.lock();
+      --pool->creating;
+      if (s) {
+        pool->replicas.push_back(s);
+        pool->extra_replica_bytes += ort_bytes;
+        PIPER_ORT_LOG("Session pool: replica %zu created for %s (+%zu ORT bytes)", pool->replicas.size(),
+                      pool->model_path.c_str(), ort_bytes);
+        pool->cv.notify_all();
+        return s;
+      }
+      // Could not add a replica (e.g. memory); fall back to waiting for an existing one.
+      max_replicas = pool->replicas.size();
+      pool->cv.notify_all();
+      if (pool->replicas.empty()) return nullptr;
+      continue;
+    }
+    pool->cv.wait(lock);
+  }
+}
+
+void releaseReplica(PiperOrtSessionPool* pool, PiperOrtSession* session) {
+  if (!pool || !session) return;
+  {
+    std::lock_guard<std::mutex> lock(pool->mu);
+    pool->idle.push_back(session);
+  }
+  pool->cv.notify_all();
+}
+
+size_t replicaCount(PiperOrtSessionPool* pool) {
+  if (!pool) return 0;
+  std::lock_guard<std::mutex> lock(pool->mu);
+  return pool->replicas.size();
+}
+
+SessionPoolStats sessionPoolStats(PiperOrtSessionPool* pool) {
+  SessionPoolStats stats;
+  if (!pool) return stats;
+  std::lock_guard<std::mutex> lock(pool->mu);
+  stats.replicas = pool->replicas.size();
+  stats.shared_initializers = pool->weights->initializers.size();
+  stats.shared_weight_bytes = pool->weights->bytes;
+  stats.first_replica_bytes = pool->first_replica_bytes;
+  if (stats.replicas > 1) stats.replica_overhead_bytes = pool->extra_replica_bytes / (stats.replicas - 1);
+  return stats;
+}
+
 static void releaseOrtValues(const OrtApi* api,
                              OrtMemoryInfo* memory_info,
                              OrtValue* input_value,
@@ -155,7 +401,21 @@ std::vector<float> runInference(
     float noise_w,
     int64_t speaker_id) {
   std::vector<float> out;
-  if (!session || !session->api || !session->session) return out;
+  runInference(session, phoneme_ids.data(), phoneme_ids.size(), noise_scale, length_scale, noise_w, speaker_id,
+               [&out](const float* samples, size_t count) { out.assign(samples, samples + count); });
+  return out;
+}
+
+bool runInference(
+    PiperOrtSession* session,
+    const int64_t* phoneme_ids,
+    size_t count,
+    float noise_scale,
+    float length_scale,
+    float noise_w,
+    int64_t speaker_id,
+    const AudioSink& on_audio) {
+  if (!session || !session->api || !session->session || !phoneme_ids || count == 0) return false;
   const OrtApi* api = session->api;
 
   OrtMemoryInfo* memory_info = nullptr;
@@ -168,56 +428,57 @@ std::vector<float> runInference(
   OrtStatus* status = api->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &memory_info);
   if (status) {
     api->ReleaseStatus(status);
-    return out;
+    return false;
   }
 
-  int64_t input_len = static_cast<int64_t>(phoneme_ids.size());
-  std::vector<int64_t> phoneme_id_lengths = {input_len};
-  std::vector<float> scales = {noise_scale, length_scale, noise_w};
-  std::vector<int64_t> sid_vec = {speaker_id};
-  std::vector<int64_t> shape_1_n = {1, input_len};
-  std::vector<int64_t> shape_1 = {1};
-  std::vector<int64_t> shape_3 = {3};
+  // Inputs are wrapped in place (no heap copies): ids from the caller, the small ones from this frame.
+  int64_t input_len = static_cast<int64_t>(count);
+  int64_t phoneme_id_lengths[] = {input_len};
+  float scales[] = {noise_scale, length_scale, noise_w};
+  int64_t sid_vec[] = {speaker_id};
+  const int64_t shape_1_n[] = {1, input_len};
+  const int64_t shape_1[] = {1};
+  const int64_t shape_3[] = {3};
 
   status = api->CreateTensorWithDataAsOrtValue(
       memory_info,
-      const_cast<int64_t*>(phoneme_ids.data()),
-      phoneme_ids.size() * sizeof(int64_t),
-      shape_1_n.data(),
-      shape_1_n.size(),
+      const_cast<int64_t*>(phoneme_ids),
+      count * sizeof(int64_t),
+      shape_1_n,
+      2,
       ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64,
       &input_value);
   if (status) {
     api->ReleaseStatus(status);
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   status = api->CreateTensorWithDataAsOrtValue(
-      memory_info, phoneme_id_lengths.data(), phoneme_id_lengths.size() * sizeof(int64_t),
-      shape_1.data(), shape_1.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &input_lengths_value);
+      memory_info, phoneme_id_lengths, sizeof(phoneme_id_lengths),
+      shape_1, 1, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &input_lengths_value);
   if (status) {
     api->ReleaseStatus(status);
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   status = api->CreateTensorWithDataAsOrtValue(
-      memory_info, scales.data(), scales.size() * sizeof(float),
-      shape_3.data(), shape_3.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &scales_value);
+      memory_info, scales, sizeof(scales),
+      shape_3, 1, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &scales_value);
   if (status) {
     api->ReleaseStatus(status);
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   status = api->CreateTensorWithDataAsOrtValue(
-      memory_info, sid_vec.data(), sid_vec.size() * sizeof(int64_t),
-      shape_1.data(), shape_1.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &sid_value);
+      memory_info, sid_vec, sizeof(sid_vec),
+      shape_1, 1, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &sid_value);
   if (status) {
     api->ReleaseStatus(status);
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   const char* output_names[] = {"output"};
@@ -225,13 +486,11 @@ std::vector<float> runInference(
   OrtValue* outputs[] = {nullptr};
 
   // Introspect session I/O once; detect if model has "sid" input so we only pass 3 or 4 inputs accordingly.
-  static OrtSession* s_last_logged_session = nullptr;
-  static bool s_session_has_sid = false;
-  if (session->session != s_last_logged_session) {
-    s_session_has_sid = logSessionIONamesAndDetectSid(api, session->session);
-    s_last_logged_session = session->session;
+  if (!session->io_logged) {
+    session->has_sid = logSessionIONamesAndDetectSid(api, session->session);
+    session->io_logged = true;
   }
-  const bool use_sid = s_session_has_sid;
+  const bool use_sid = session->has_sid;
   const size_t num_inputs = use_sid ? 4 : 3;
 
   const char* input_names_4[] = {"input", "input_lengths", "scales", "sid"};
@@ -251,7 +510,7 @@ std::vector<float> runInference(
     PIPER_ORT_LOG("Run() failed:");
     logOrtStatus(api, status);
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   // (B) Log output count and which output is null
@@ -263,7 +522,7 @@ std::vector<float> runInference(
   output_value = outputs[0];
   if (!output_value) {
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   // Use GetTensorTypeAndShape then read data with GetTensorData
@@ -272,7 +531,7 @@ std::vector<float> runInference(
   if (status) {
     logOrtStatus(api, status);
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   size_t num_dims = 0;
@@ -281,16 +540,22 @@ std::vector<float> runInference(
     api->ReleaseStatus(status);
     api->ReleaseTensorTypeAndShapeInfo(tensor_info);
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
-  std::vector<int64_t> dims(num_dims);
-  status = api->GetDimensions(tensor_info, dims.data(), num_dims);
+  int64_t dims[kMaxOutputRank] = {};
+  if (num_dims > kMaxOutputRank) {
+    PIPER_ORT_LOG("Output tensor rank %zu not supported", num_dims);
+    api->ReleaseTensorTypeAndShapeInfo(tensor_info);
+    releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
+    return false;
+  }
+  status = api->GetDimensions(tensor_info, dims, num_dims);
   if (status) {
     api->ReleaseStatus(status);
     api->ReleaseTensorTypeAndShapeInfo(tensor_info);
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   // (C) Log output tensor element type, rank, dimensions, total elements
@@ -313,7 +578,7 @@ std::vector<float> runInference(
   if (total <= 0) {
     PIPER_ORT_LOG("Output tensor total elements <= 0, returning no audio");
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   float* data = nullptr;
@@ -326,7 +591,7 @@ std::vector<float> runInference(
       PIPER_ORT_LOG("GetTensorMutableData returned null pointer");
     }
     releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-    return out;
+    return false;
   }
 
   // (D) Log first few float samples (if any)
@@ -339,9 +604,9 @@ std::vector<float> runInference(
     std::fprintf(stderr, "\n");
   }
 
-  out.assign(data, data + total);
+  on_audio(data, static_cast<size_t>(total));
   releaseOrtValues(api, memory_info, input_value, input_lengths_value, scales_value, sid_value, output_value);
-  return out;
+  return true;
 }
 
 }  // namespace piper_ort
@@ -2,12 +2,13 @@
 #define ORT_CAPI_ADAPTER_H
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
 namespace piper_ort {
 
-// Opaque session (holds OrtEnv*, OrtSession*, etc.)
+// Opaque session (holds OrtSession*, options; env is the shared one from ort_env.h)
 struct PiperOrtSession;
 
 // Load ONNX model from path. Returns nullptr on failure.
@@ -16,6 +17,36 @@ PiperOrtSession* createSession(const char* model_path);
 
 void destroySession(PiperOrtSession* session);
 
+// Replicas of one model for concurrent inference. An OrtSession runs one utterance clause per replica at a
+// time; replicas are created lazily (up to the max passed to acquireReplica) and hold no weights of their own:
+// every session of a model (all replicas, and a second pool for the same path, e.g. a voice swapped out and
+// back in while a request still holds the old pool) gets the model's raw_data initializers from one shared
+// aligned copy via AddInitializer (onnx_initializers.h) and one prepacked-weights container, so kernels that
+// prepack hold their packed weights once as well. Models whose initializers cannot be read load as before.
+struct PiperOrtSessionPool;
+
+struct SessionPoolStats {
+  size_t replicas = 0;
+  size_t shared_initializers = 0;
+  size_t shared_weight_bytes = 0;     // one copy for every session of the model
+  size_t first_replica_bytes = 0;     // ORT allocator growth while creating the first replica
+  size_t replica_overhead_bytes = 0;  // mean ORT allocator growth per additional replica
+};
+
+// Creates the pool and its first replica. nullptr if the model cannot be loaded.
+PiperOrtSessionPool* createSessionPool(const char* model_path);
+
+// Waits for all replicas to be released, then frees them and the container.
+void destroySessionPool(PiperOrtSessionPool* pool);
+
+// A free replica; creates one if all are busy and fewer than max_replicas exist, else blocks until one is released.
+PiperOrtSession* acquireReplica(PiperOrtSessionPool* pool, size_t max_replicas);
+void releaseReplica(PiperOrtSessionPool* pool, PiperOrtSession* session);
+size_t replicaCount(PiperOrtSessionPool* pool);
+// ORT bytes come from the counting env allocator (memory_accounting.h); concurrent allocations elsewhere in
+// the process while a replica is created are attributed to it.
+SessionPoolStats sessionPoolStats(PiperOrtSessionPool* pool);
+
 // Run Piper VITS inference: phoneme_ids [1, N], scales [noise_scale, length_scale, noise_w], speaker_id.
 // Returns float audio samples (mono). Returns empty vector on failure.
 std::vector<float> runInference(
@@ -26,6 +57,19 @@ std::vector<float> runInference(
     float noise_w,
     int64_t speaker_id);
 
+// Same on a caller-owned id buffer. The output samples go to on_audio (valid only during the call) instead of
+// a new vector, so the caller can append them straight into its own buffer. False on failure.
+using AudioSink = std::function<void(const float* samples, size_t count)>;
+bool runInference(
+    PiperOrtSession* session,
+    const int64_t* phoneme_ids,
+    size_t count,
+    float noise_scale,
+    float length_scale,
+    float noise_w,
+    int64_t speaker_id,
+    const AudioSink& on_audio);
+
 }  // namespace piper_ort
 
 #endif  // ORT_CAPI_ADAPTER_H
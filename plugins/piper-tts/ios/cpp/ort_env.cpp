@@ -0,0 +1,99 @@
+#include "ort_env.h"
+#include "memory_accounting.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#define PIPER_ORT_LOG(fmt, ...) std::fprintf(stderr, "[PiperORT] " fmt "\n", ##__VA_ARGS__)
+
+namespace piper_ort {
+
+namespace {
+
+std::once_flag g_env_once;
+OrtEnv* g_env = nullptr;
+bool g_env_allocator_registered = false;
+
+// Mobile CPUs: cap the shared intra-op pool so TTS/embedding/ASR do not oversubscribe big cores.
+constexpr int kMaxIntraOpThreads = 4;
+
+void createEnv() {
+  const OrtApi* api = getApi();
+  if (!api) return;
+
+  OrtThreadingOptions* threading = nullptr;
+  OrtStatus* status = api->CreateThreadingOptions(&threading);
+  if (status) {
+    logOrtStatus(api, status);
+    return;
+  }
+  const unsigned hw = std::thread::hardware_concurrency();
+  const int intra = std::max(1, std::min(kMaxIntraOpThreads, static_cast<int>(hw)));
+  api->SetGlobalIntraOpNumThreads(threading, intra);
+  api->SetGlobalInterOpNumThreads(threading, 1);
+  api->SetGlobalSpinControl(threading, 0);
+
+  status = api->CreateEnvWithGlobalThreadPools(ORT_LOGGING_LEVEL_WARNING, "piper", threading, &g_env);
+  api->ReleaseThreadingOptions(threading);
+  if (status) {
+    PIPER_ORT_LOG("CreateEnvWithGlobalThreadPools failed:");
+    logOrtStatus(api, status);
+    g_env = nullptr;
+    return;
+  }
+  api->DisableTelemetryEvents(g_env);
+
+  // Stats builds only: sessions that ask for it allocate through the counting allocator (per-request memory
+  // accounting). It bypasses ORT's arena, so release builds leave it out.
+  if (OrtAllocator* counting = piper_mem::countingAllocator()) {
+    status = api->RegisterAllocator(g_env, counting);
+    if (status) {
+      PIPER_ORT_LOG("RegisterAllocator failed; ORT memory will not be counted:");
+      logOrtStatus(api, status);
+    } else {
+      g_env_allocator_registered = true;
+    }
+  }
+  PIPER_ORT_LOG("Shared env created (global intra-op threads=%d)", intra);
+}
+
+}  // namespace
+
+const OrtApi* getApi() {
+  const OrtApiBase* base = OrtGetApiBase();
+  if (!base) return nullptr;
+  return base->GetApi(ORT_API_VERSION);
+}
+
+OrtEnv* sharedEnv() {
+  std::call_once(g_env_once, createEnv);
+  return g_env;
+}
+
+OrtSessionOptions* createSharedSessionOptions(GraphOptimizationLevel level, bool count_allocations) {
+  const OrtApi* api = getApi();
+  if (!api) return nullptr;
+  OrtSessionOptions* options = nullptr;
+  OrtStatus* status = api->CreateSessionOptions(&options);
+  if (status) {
+    logOrtStatus(api, status);
+    return nullptr;
+  }
+  api->SetSessionGraphOptimizationLevel(options, level);
+  api->DisablePerSessionThreads(options);
+  api->DisableProfiling(options);
+  if (count_allocations && sharedEnv() && g_env_allocator_registered) {
+    logOrtStatus(api, api->AddSessionConfigEntry(options, "session.use_env_allocators", "1"));
+  }
+  return options;
+}
+
+void logOrtStatus(const OrtApi* api, OrtStatus* status) {
+  if (!status) return;
+  const char* msg = api->GetErrorMessage(status);
+  PIPER_ORT_LOG("ORT error: %s", msg ? msg : "(no message)");
+  api->ReleaseStatus(status);
+}
+
+}  // namespace piper_ort
@@ -0,0 +1,27 @@
+#ifndef ORT_ENV_H
+#define ORT_ENV_H
+
+#include <onnxruntime_c_api.h>
+
+namespace piper_ort {
+
+// ORT C API for the version we compile against. nullptr if the runtime is unavailable.
+const OrtApi* getApi();
+
+// Process-wide OrtEnv with global intra/inter-op thread pools. Shared by every session
+// (Piper TTS, query embedding, ASR) so models do not each spin up their own pools.
+// Created on first use, never released. nullptr on failure.
+OrtEnv* sharedEnv();
+
+// New session options bound to the shared env's thread pools (per-session threads disabled). With
+// count_allocations, and when the env has the counting CPU allocator (PIPER_ORT_ALLOC_STATS builds,
+// memory_accounting.h), the session allocates through it instead of ORT's own arena.
+// Caller releases with api->ReleaseSessionOptions. nullptr on failure.
+OrtSessionOptions* createSharedSessionOptions(GraphOptimizationLevel level, bool count_allocations = false);
+
+// Log an ORT error status and release it. No-op for nullptr.
+void logOrtStatus(const OrtApi* api, OrtStatus* status);
+
+}  // namespace piper_ort
+
+#endif  // ORT_ENV_H
@@ -0,0 +1,292 @@
+#include "pack_container.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace piper {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'I', 'P', 'E', 'R', 'P', 'C', '1'};
+constexpr size_t kHeaderSize = 64;
+constexpr size_t kTocEntrySize = 64;
+constexpr size_t kNameSize = 24;
+
+uint32_t readU32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t readU64(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+}  // namespace
+
+uint64_t packChecksum(const void* data, size_t n, uint64_t seed) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint64_t h = seed;
+  for (size_t i = 0; i < n; ++i) {
+    h ^= p[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+PackStringTable::PackStringTable(const uint8_t* data, size_t size, uint32_t count) {
+  const size_t table = (static_cast<size_t>(count) + 1) * sizeof(uint64_t);
+  if (!data || size < table || reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0) return;
+  const uint64_t* offsets = reinterpret_cast<const uint64_t*>(data);
+  if (offsets[0] != 0 || offsets[count] > size - table) return;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (offsets[i] > offsets[i + 1]) return;
+  }
+  offsets_ = offsets;
+  bytes_ = reinterpret_cast<const char*>(data + table);
+  bytes_size_ = static_cast<size_t>(offsets[count]);
+  count_ = count;
+}
+
+std::string PackStringTable::get(uint32_t i) const {
+  if (!offsets_ || i >= count_) return std::string();
+  return std::string(bytes_ + offsets_[i], static_cast<size_t>(offsets_[i + 1] - offsets_[i]));
+}
+
+std::string_view PackStringTable::view(uint32_t i) const {
+  if (!offsets_ || i >= count_) return std::string_view();
+  return std::string_view(bytes_ + offsets_[i], static_cast<size_t>(offsets_[i + 1] - offsets_[i]));
+}
+
+bool PackStringMap::open(const PackSection& section, std::string* error) {
+  *this = PackStringMap();
+  const uint8_t* d = section.data;
+  const size_t size = section.size;
+  if (section.kind != PackSectionKind::kStringMap || !d || size < 24) {
+    if (error) *error = section.name + ": not a string map section";
+    return false;
+  }
+  const uint32_t n = readU32(d);
+  const uint64_t keys_off = readU64(d + 8), values_off = readU64(d + 16);
+  if (keys_off > size || values_off > size || keys_off > values_off) {
+    if (error) *error = section.name + ": offsets out of range";
+    return false;
+  }
+  keys_ = PackStringTable(d + keys_off, static_cast<size_t>(values_off - keys_off), n);
+  values_ = PackStringTable(d + values_off, static_cast<size_t>(size - values_off), n);
+  if (!keys_.valid() || !values_.valid()) {
+    *this = PackStringMap();
+    if (error) *error = section.name + ": invalid string tables";
+    return false;
+  }
+  return true;
+}
+
+bool PackStringMap::find(std::string_view key, std::string_view* value) const {
+  uint32_t lo = 0, hi = keys_.size();
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (keys_.view(mid) < key) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == keys_.size() || keys_.view(lo) != key) return false;
+  if (value) *value = values_.view(lo);
+  return true;
+}
+
+bool PackTable::open(const PackSection& section, std::string* error) {
+  auto fail = [&](const std::string& msg) {
+    if (error) *error = section.name + ": " + msg;
+    *this = PackTable();
+    return false;
+  };
+  const uint8_t* d = section.data;
+  const size_t size = section.size;
+  if (section.kind != PackSectionKind::kTable || !d || size < 40) return fail("not a table section");
+  rows_ = readU32(d);
+  const uint32_t columns = readU32(d + 4);
+  const uint32_t indexes = readU32(d + 8);
+  const uint64_t names_off = readU64(d + 16), columns_off = readU64(d + 24), indexes_off = readU64(d + 32);
+  if (columns_off % 8 != 0 || columns_off > size || uint64_t(columns) * sizeof(PackColumn) > size - columns_off ||
+      indexes_off % 8 != 0 || indexes_off > size || uint64_t(indexes) * sizeof(PackIndex) > size - indexes_off ||
+      names_off > size)
+    return fail("header out of bounds");
+  const PackStringTable names(d + names_off, size - names_off, columns);
+  if (!names.valid()) return fail("bad column names");
+  for (uint32_t c = 0; c < columns; ++c) {
+    PackColumn col;
+    std::memcpy(&col, d + columns_off + c * sizeof(PackColumn), sizeof(col));
+    const uint64_t fixed = uint64_t(rows_) * 8;
+    if (col.data_off > size || col.data_off % 8 != 0) return fail("column out of bounds");
+    if (col.nulls_off != 0 && (col.nulls_off > size || (uint64_t(rows_) + 7) / 8 > size - col.nulls_off))
+      return fail("NULL bitmap out of bounds");
+    PackStringTable text;
+    switch (static_cast<PackColumnType>(col.type)) {
+      case PackColumnType::kInt:
+      case PackColumnType::kReal:
+        if (fixed > size - col.data_off) return fail("column out of bounds");
+        break;
+      case PackColumnType::kText:
+        text = PackStringTable(d + col.data_off, size - col.data_off, rows_);
+        if (!text.valid()) return fail("bad text column");
+        break;
+      default:
+        return fail("unknown column type");
+    }
+    names_.push_back(names.get(c));
+    columns_.push_back(col);
+    text_.push_back(text);
+  }
+  index_rows_.assign(columns, nullptr);
+  index_count_.assign(columns, 0);
+  for (uint32_t i = 0; i < indexes; ++i) {
+    PackIndex index;
+    std::memcpy(&index, d + indexes_off + i * sizeof(PackIndex), sizeof(index));
+    if (index.column >= columns || index.count > rows_ || index.rows_off % 4 != 0 || index.rows_off > size ||
+        uint64_t(index.count) * 4 > size - index.rows_off)
+      return fail("index out of bounds");
+    const uint32_t* rows = reinterpret_cast<const uint32_t*>(d + index.rows_off);
+    for (uint32_t r = 0; r < index.count; ++r) {
+      if (rows[r] >= rows_) return fail("index row out of range");
+    }
+    index_rows_[index.column] = rows;
+    index_count_[index.column] = index.count;
+  }
+  data_ = d;
+  return true;
+}
+
+int PackTable::column(std::string_view name) const {
+  for (size_t c = 0; c < names_.size(); ++c) {
+    if (names_[c] == name) return static_cast<int>(c);
+  }
+  return -1;
+}
+
+bool PackTable::isNull(uint32_t c, uint32_t row) const {
+  const uint64_t off = columns_[c].nulls_off;
+  return off != 0 && (data_[off + row / 8] >> (row % 8)) & 1;
+}
+
+int64_t PackTable::intAt(uint32_t c, uint32_t row) const {
+  int64_t v;
+  std::memcpy(&v, data_ + columns_[c].data_off + uint64_t(row) * 8, sizeof(v));
+  return v;
+}
+
+double PackTable::realAt(uint32_t c, uint32_t row) const {
+  double v;
+  std::memcpy(&v, data_ + columns_[c].data_off + uint64_t(row) * 8, sizeof(v));
+  return v;
+}
+
+std::string_view PackTable::textAt(uint32_t c, uint32_t row) const { return text_[c].view(row); }
+
+bool PackTable::findText(uint32_t c, std::string_view key, bool prefix, size_t limit,
+                         std::vector<uint32_t>& out) const {
+  if (c >= columns_.size() || !index_rows_[c] || type(c) != PackColumnType::kText) return false;
+  const uint32_t* begin = index_rows_[c];
+  const uint32_t* end = begin + index_count_[c];
+  const PackStringTable& text = text_[c];
+  const uint32_t* it =
+      std::lower_bound(begin, end, key, [&](uint32_t row, std::string_view k) { return text.view(row) < k; });
+  for (; it != end && out.size() < limit; ++it) {
+    const std::string_view v = text.view(*it);
+    if (prefix ? v.substr(0, key.size()) != key : v != key) break;
+    out.push_back(*it);
+  }
+  return true;
+}
+
+bool PackTable::findInt(uint32_t c, int64_t key, size_t limit, std::vector<uint32_t>& out) const {
+  if (c >= columns_.size() || !index_rows_[c] || type(c) != PackColumnType::kInt) return false;
+  const uint32_t* begin = index_rows_[c];
+  const uint32_t* end = begin + index_count_[c];
+  const uint32_t* it =
+      std::lower_bound(begin, end, key, [&](uint32_t row, int64_t k) { return intAt(c, row) < k; });
+  for (; it != end && out.size() < limit && intAt(c, *it) == key; ++it) out.push_back(*it);
+  return true;
+}
+
+PackContainer::~PackContainer() {
+  close();
+}
+
+bool PackContainer::open(const std::string& path, bool verify_checksums, std::string* error) {
+  close();
+  auto fail = [this, error](const std::string& msg) {
+    if (error) *error = msg;
+    close();
+    return false;
+  };
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return fail("cannot open file");
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize)) {
+    ::close(fd);
+    return fail("file too small");
+  }
+  void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) return fail("mmap failed");
+  map_ = map;
+  map_size_ = static_cast<size_t>(st.st_size);
+
+  const uint8_t* base = static_cast<const uint8_t*>(map_);
+  if (std::memcmp(base, kMagic, sizeof(kMagic)) != 0) return fail("bad magic");
+  if (readU32(base + 8) != kPackContainerVersion) return fail("unsupported version");
+  const uint32_t count = readU32(base + 12);
+  const uint64_t toc_offset = readU64(base + 16);
+  if (readU64(base + 24) != map_size_) return fail("file size mismatch (truncated?)");
+  content_hash_ = readU64(base + 32);
+  if (toc_offset < kHeaderSize || toc_offset + uint64_t(count) * kTocEntrySize > map_size_)
+    return fail("TOC out of bounds");
+
+  sections_.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint8_t* e = base + toc_offset + i * kTocEntrySize;
+    PackSection s;
+    s.name.assign(reinterpret_cast<const char*>(e), strnlen(reinterpret_cast<const char*>(e), kNameSize));
+    s.kind = static_cast<PackSectionKind>(readU32(e + 24));
+    s.version = readU32(e + 28);
+    s.count = readU32(e + 32);
+    s.param = readU32(e + 36);
+    const uint64_t offset = readU64(e + 40);
+    const uint64_t size = readU64(e + 48);
+    s.checksum = readU64(e + 56);
+    if (offset % kPackSectionAlign != 0 || offset > map_size_ || size > map_size_ - offset)
+      return fail("section " + s.name + " out of bounds");
+    if (!sections_.empty() && !(sections_.back().name < s.name)) return fail("TOC not sorted");
+    s.data = base + offset;
+    s.size = static_cast<size_t>(size);
+    if (verify_checksums && packChecksum(s.data, s.size) != s.checksum)
+      return fail("section " + s.name + " checksum mismatch");
+    sections_.push_back(std::move(s));
+  }
+  return true;
+}
+
+void PackContainer::close() {
+  if (map_) munmap(map_, map_size_);
+  map_ = nullptr;
+  map_size_ = 0;
+  content_hash_ = 0;
+  sections_.clear();
+}
+
+const PackSection* PackContainer::find(const std::string& name) const {
+  size_t lo = 0, hi = sections_.size();
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2;
+    if (sections_[mid].name < name) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo < sections_.size() && sections_[lo].name == name ? &sections_[lo] : nullptr;
+}
+
+}  // namespace piper
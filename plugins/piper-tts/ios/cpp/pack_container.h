@@ -0,0 +1,199 @@
+#ifndef PACK_CONTAINER_H
+#define PACK_CONTAINER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace piper {
+
+// Read-only view of pack.bin, the binary retrieval artifacts compiled from a content pack's chunks.jsonl,
+// rules.db and cards.db by the host tool pack_compile (plugins/piper-tts/host). One file is mmapped; each
+// section starts on a 4096-byte boundary so it can be paged (and madvise'd) independently.
+//
+// Layout (little-endian): 64-byte header { magic "PIPERPC1", u32 version, u32 section_count,
+// u64 toc_offset, u64 file_size, u64 content_hash, pad }, then section_count 64-byte TOC entries
+// { char name[24] (NUL-padded), u32 kind, u32 version, u32 count, u32 param, u64 offset, u64 size,
+// u64 checksum }, sorted by name. checksum is FNV-1a 64 of the section bytes; content_hash folds every
+// entry's name and checksum, so equal sources give an equal hash (the file has no timestamps).
+//
+// Section kinds (offsets inside a section are relative to its start):
+//   kVectors   "<source>.vectors"  count rows x param dim f16, row-major (row i = global row id i).
+//   kStrings   "<source>.chunks"   u64 offsets[count + 1], then bytes; string i = chunks.jsonl line i.
+//   kPostings  "<source>.postings" tokens of each chunk's text (ASCII [a-z0-9] lowercased, UTF-8 bytes kept).
+//              Header { u32 terms, u32 docs, u64 postings, u64 doc_len_off, u64 terms_off, u64 postings_off,
+//              u64 blob_off }, u32 doc_len[docs], PackTerm[terms] sorted by token bytes,
+//              PackPosting[postings] grouped by term with ascending rows, token bytes. count = terms,
+//              param = docs.
+//   kTrie      "cards.name_trie"   name_norm -> oracle_id. Header { u32 nodes, u32 keys, u64 nodes_off,
+//              u64 values_off }, PackTrieNode[nodes] (root 0; a node's children are contiguous and sorted
+//              by label), then a kStrings table of oracle ids indexed by PackTrieNode::value.
+//   kStringMap "phonemes"          word -> espeak IPA for the pack's vocabulary. Header { u32 n, u32 pad,
+//              u64 keys_off, u64 values_off }, two kStrings tables; keys sorted.
+//   kTable     "<source>.table"    rules.db / cards.db rows, column by column. Header { u32 rows, u32 columns,
+//              u32 indexes, u32 pad, u64 names_off, u64 columns_off, u64 indexes_off }, a kStrings table of
+//              column names, PackColumn[columns], PackIndex[indexes]. A column holds i64[rows], f64[rows] or a
+//              kStrings table of rows entries, plus an optional NULL bitmap. An index is the u32 row numbers
+//              whose column is not NULL, ordered by value (text by bytes, ties in row order). Rows are stored
+//              in the order of the first index. count = rows, param = columns.
+
+constexpr uint32_t kPackContainerVersion = 1;
+constexpr size_t kPackSectionAlign = 4096;
+constexpr uint32_t kPackTrieNoValue = 0xFFFFFFFFu;
+
+enum class PackSectionKind : uint32_t {
+  kVectors = 1,
+  kStrings = 2,
+  kPostings = 3,
+  kTrie = 4,
+  kStringMap = 5,
+  kTable = 6,
+};
+
+enum class PackColumnType : uint32_t {
+  kInt = 1,
+  kReal = 2,
+  kText = 3,
+};
+
+struct PackColumn {
+  uint32_t type;  // PackColumnType
+  uint32_t pad;
+  uint64_t data_off;
+  uint64_t nulls_off;  // 0: no NULLs; else bitmap, bit (row % 8) of byte row / 8 set for NULL
+};
+
+struct PackIndex {
+  uint32_t column;
+  uint32_t count;  // non-NULL rows
+  uint64_t rows_off;
+};
+
+struct PackTerm {
+  uint32_t blob_off;
+  uint32_t len;
+  uint32_t first_posting;
+  uint32_t df;
+};
+
+struct PackPosting {
+  uint32_t row;
+  uint32_t tf;
+};
+
+struct PackTrieNode {
+  uint32_t first_child;
+  uint32_t value;  // index into the oracle id table, or kPackTrieNoValue
+  uint16_t child_count;
+  uint8_t label;
+  uint8_t reserved;
+  uint32_t pad;
+};
+
+struct PackSection {
+  std::string name;
+  PackSectionKind kind = PackSectionKind::kStrings;
+  uint32_t version = 0;
+  uint32_t count = 0;
+  uint32_t param = 0;
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+  uint64_t checksum = 0;
+};
+
+uint64_t packChecksum(const void* data, size_t n, uint64_t seed = 1469598103934665603ull);
+
+// Table of u64 offsets[count + 1] followed by bytes (kStrings, and the tables inside kTrie / kStringMap).
+class PackStringTable {
+ public:
+  PackStringTable() = default;
+  PackStringTable(const uint8_t* data, size_t size, uint32_t count);
+  bool valid() const { return offsets_ != nullptr; }
+  uint32_t size() const { return count_; }
+  // Empty for an out-of-range index.
+  std::string get(uint32_t i) const;
+  std::string_view view(uint32_t i) const;
+
+ private:
+  const uint64_t* offsets_ = nullptr;
+  const char* bytes_ = nullptr;
+  size_t bytes_size_ = 0;
+  uint32_t count_ = 0;
+};
+
+// Read-only view of a kStringMap section (e.g. "phonemes"): binary search over the sorted keys.
+class PackStringMap {
+ public:
+  bool open(const PackSection& section, std::string* error = nullptr);
+  bool valid() const { return keys_.valid(); }
+  uint32_t size() const { return keys_.size(); }
+  // Value of key; false when absent.
+  bool find(std::string_view key, std::string_view* value) const;
+
+ private:
+  PackStringTable keys_;
+  PackStringTable values_;
+};
+
+// Read-only view of a kTable section. Lookups go through the section's indexes (binary search over the
+// sorted row numbers); values are read straight from the mapping.
+class PackTable {
+ public:
+  bool open(const PackSection& section, std::string* error = nullptr);
+  bool valid() const { return data_ != nullptr; }
+  uint32_t rows() const { return rows_; }
+  uint32_t columns() const { return static_cast<uint32_t>(columns_.size()); }
+  const std::string& columnName(uint32_t c) const { return names_[c]; }
+  // -1 when the table has no such column.
+  int column(std::string_view name) const;
+  PackColumnType type(uint32_t c) const { return static_cast<PackColumnType>(columns_[c].type); }
+  bool indexed(uint32_t c) const { return index_rows_[c] != nullptr; }
+
+  bool isNull(uint32_t c, uint32_t row) const;
+  int64_t intAt(uint32_t c, uint32_t row) const;
+  double realAt(uint32_t c, uint32_t row) const;
+  std::string_view textAt(uint32_t c, uint32_t row) const;
+
+  // Rows of an indexed text column equal to key (or starting with it), in index order, at most limit.
+  // False when the column is not an indexed text column.
+  bool findText(uint32_t c, std::string_view key, bool prefix, size_t limit, std::vector<uint32_t>& out) const;
+  // Same for an indexed integer column.
+  bool findInt(uint32_t c, int64_t key, size_t limit, std::vector<uint32_t>& out) const;
+
+ private:
+  const uint8_t* data_ = nullptr;
+  uint32_t rows_ = 0;
+  std::vector<std::string> names_;
+  std::vector<PackColumn> columns_;
+  std::vector<PackStringTable> text_;        // per column; valid for text columns
+  std::vector<const uint32_t*> index_rows_;  // per column; null when not indexed
+  std::vector<uint32_t> index_count_;
+};
+
+class PackContainer {
+ public:
+  PackContainer() = default;
+  ~PackContainer();
+  PackContainer(const PackContainer&) = delete;
+  PackContainer& operator=(const PackContainer&) = delete;
+
+  // Maps path and validates the header and TOC bounds. verify_checksums also hashes every section.
+  bool open(const std::string& path, bool verify_checksums, std::string* error = nullptr);
+  void close();
+
+  const PackSection* find(const std::string& name) const;
+  const std::vector<PackSection>& sections() const { return sections_; }
+  uint64_t contentHash() const { return content_hash_; }
+
+ private:
+  void* map_ = nullptr;
+  size_t map_size_ = 0;
+  uint64_t content_hash_ = 0;
+  std::vector<PackSection> sections_;
+};
+
+}  // namespace piper
+
+#endif  // PACK_CONTAINER_H
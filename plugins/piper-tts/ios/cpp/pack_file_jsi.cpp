@@ -0,0 +1,91 @@
+#include "pack_file_jsi.h"
+#include <jsi/jsi.h>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+namespace {
+
+class MappedFileBuffer : public jsi::MutableBuffer {
+ public:
+  MappedFileBuffer(void* map, size_t size) : map_(map), size_(size) {}
+  ~MappedFileBuffer() override {
+    if (map_) munmap(map_, size_);
+  }
+  size_t size() const override { return size_; }
+  uint8_t* data() override { return map_ ? static_cast<uint8_t*>(map_) : &empty_; }
+
+ private:
+  void* map_;
+  size_t size_;
+  uint8_t empty_ = 0;
+};
+
+jsi::Function readerFunction(jsi::Runtime& runtime, const char* name, PackAssetOpener open) {
+  return jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, name), 1,
+      [name, open = std::move(open)](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args,
+                                     size_t count) -> jsi::Value {
+        if (count < 1 || !args[0].isString()) {
+          throw jsi::JSError(rt, std::string(name) + "(path): expected a string");
+        }
+        const std::string path = args[0].getString(rt).utf8(rt);
+        std::string error;
+        std::shared_ptr<jsi::MutableBuffer> buffer = open(path, &error);
+        if (!buffer) throw jsi::JSError(rt, std::string(name) + ": " + path + ": " + error);
+        return jsi::ArrayBuffer(rt, std::move(buffer));
+      });
+}
+
+}  // namespace
+
+std::shared_ptr<jsi::MutableBuffer> mapPackFile(const std::string& path, std::string* error) {
+  auto fail = [error](const std::string& msg) -> std::shared_ptr<jsi::MutableBuffer> {
+    if (error) *error = msg;
+    return nullptr;
+  };
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return fail(std::strerror(errno));
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    const int e = errno;
+    ::close(fd);
+    return fail(std::strerror(e));
+  }
+  if (!S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return fail("not a regular file");
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return std::make_shared<MappedFileBuffer>(nullptr, 0);
+  }
+  void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  const int e = errno;
+  ::close(fd);
+  if (map == MAP_FAILED) return fail(std::string("mmap failed: ") + std::strerror(e));
+  return std::make_shared<MappedFileBuffer>(map, size);
+}
+
+void installPackFileJsi(jsi::Runtime& runtime, PackAssetOpener open_asset) {
+  runtime.global().setProperty(runtime, "__piperReadFileBinary",
+                               readerFunction(runtime, "__piperReadFileBinary",
+                                              [](const std::string& path, std::string* error) {
+                                                return mapPackFile(path, error);
+                                              }));
+  if (open_asset) {
+    runtime.global().setProperty(runtime, "__piperReadAssetBinary",
+                                 readerFunction(runtime, "__piperReadAssetBinary", std::move(open_asset)));
+  }
+}
+
+}  // namespace piper
@@ -0,0 +1,36 @@
+#ifndef PACK_FILE_JSI_H
+#define PACK_FILE_JSI_H
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace facebook {
+namespace jsi {
+class MutableBuffer;
+class Runtime;
+}  // namespace jsi
+}  // namespace facebook
+
+namespace piper {
+
+// Bytes of a bundled pack file (Android AAssetManager, iOS main bundle) for __piperReadAssetBinary; nullptr with
+// error set if it cannot be opened.
+using PackAssetOpener =
+    std::function<std::shared_ptr<facebook::jsi::MutableBuffer>(const std::string& path, std::string* error)>;
+
+// Maps path copy-on-write (writes from JS stay private) and unmaps when the buffer is released. An empty file
+// gives an empty buffer. nullptr with error set on failure.
+std::shared_ptr<facebook::jsi::MutableBuffer> mapPackFile(const std::string& path, std::string* error = nullptr);
+
+// Install on global:
+//   __piperReadFileBinary(path) -> ArrayBuffer: a file on disk (e.g. Documents/content_pack/...), mmapped.
+//   __piperReadAssetBinary(path) -> ArrayBuffer: a bundled pack file via open_asset (not installed if empty).
+// Both hand native memory to JS without a copy (a compressed Android asset is inflated once into an owned buffer);
+// the mapping lives until the ArrayBuffer is collected. Synchronous on the JS thread (mapping is O(1); pages fault
+// in on first access). Throw a JS Error if the file cannot be read.
+void installPackFileJsi(facebook::jsi::Runtime& runtime, PackAssetOpener open_asset = nullptr);
+
+}  // namespace piper
+
+#endif  // PACK_FILE_JSI_H
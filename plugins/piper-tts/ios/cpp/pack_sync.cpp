@@ -0,0 +1,479 @@
+#include "pack_sync.h"
+#include "json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace piper {
+
+namespace {
+
+constexpr const char* kStateFile = ".pack_sync_state";
+constexpr const char* kPartialSuffix = ".partial";
+
+const uint64_t kBlake2bIv[8] = {0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull, 0x3c6ef372fe94f82bull,
+                                0xa54ff53a5f1d36f1ull, 0x510e527fade682d1ull, 0x9b05688c2b3e6c1full,
+                                0x1f83d9abfb41bd6bull, 0x5be0cd19137e2179ull};
+
+const uint8_t kSigma[12][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}, {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4}, {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13}, {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11}, {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5}, {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}, {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+};
+
+inline uint64_t rotr64(uint64_t x, int n) { return (x >> n) | (x << (64 - n)); }
+
+inline uint64_t load64(const unsigned char* p) {
+  uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+  return v;
+}
+
+struct Entry {
+  std::string path;
+  uint64_t size = 0;
+  std::string hash;
+};
+
+struct StateRecord {
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  std::string hash;
+};
+
+class FileReader : public PackSyncReader {
+ public:
+  explicit FileReader(FILE* f) : f_(f) {}
+  ~FileReader() override { std::fclose(f_); }
+  long read(void* buf, size_t n) override {
+    const size_t got = std::fread(buf, 1, n, f_);
+    return got == 0 && std::ferror(f_) ? -1 : static_cast<long>(got);
+  }
+
+ private:
+  FILE* f_;
+};
+
+class DirectorySource : public PackSyncSource {
+ public:
+  explicit DirectorySource(std::string root) : root_(std::move(root)) {}
+  bool readAll(const std::string& rel_path, std::string& out) override {
+    FILE* f = std::fopen((root_ + "/" + rel_path).c_str(), "rb");
+    if (!f) return false;
+    char buf[65536];
+    size_t n;
+    out.clear();
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    std::fclose(f);
+    return true;
+  }
+  std::unique_ptr<PackSyncReader> open(const std::string& rel_path, uint64_t offset) override {
+    FILE* f = std::fopen((root_ + "/" + rel_path).c_str(), "rb");
+    if (!f) return nullptr;
+    if (offset > 0 && fseeko(f, static_cast<off_t>(offset), SEEK_SET) != 0) {
+      std::fclose(f);
+      return nullptr;
+    }
+    return std::unique_ptr<PackSyncReader>(new FileReader(f));
+  }
+
+ private:
+  std::string root_;
+};
+
+bool safeRelativePath(const std::string& p) {
+  if (p.empty() || p[0] == '/' || p.find('\\') != std::string::npos) return false;
+  size_t start = 0;
+  while (start <= p.size()) {
+    const size_t end = std::min(p.find('/', start), p.size());
+    const std::string part = p.substr(start, end - start);
+    if (part.empty() || part == "." || part == "..") return false;
+    start = end + 1;
+  }
+  return true;
+}
+
+bool makeParentDirs(const std::string& path) {
+  for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+    const std::string dir = path.substr(0, pos);
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+  }
+  return true;
+}
+
+bool parseManifest(const std::string& text, std::vector<Entry>& entries) {
+  nlohmann::json doc = nlohmann::json::parse(text, nullptr, false);
+  if (doc.is_discarded() || !doc.is_object() || !doc.contains("files") || !doc["files"].is_array()) return false;
+  if (doc.contains("hash") && doc["hash"] != "blake2b-512/128") return false;
+  for (const auto& f : doc["files"]) {
+    if (!f.is_object() || !f.contains("path") || !f["path"].is_string() || !f.contains("size") ||
+        !f["size"].is_number_unsigned() || !f.contains("hash") || !f["hash"].is_string())
+      return false;
+    Entry e;
+    e.path = f["path"].get<std::string>();
+    e.size = f["size"].get<uint64_t>();
+    e.hash = f["hash"].get<std::string>();
+    if (!safeRelativePath(e.path) || e.path == kPackFilesManifest || e.path == kStateFile) return false;
+    entries.push_back(std::move(e));
+  }
+  return true;
+}
+
+// "<hash> <size> <mtime> <path>" per line.
+std::unordered_map<std::string, StateRecord> readState(const std::string& path) {
+  std::unordered_map<std::string, StateRecord> state;
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return state;
+  std::string text;
+  char buf[65536];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+  std::fclose(f);
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream ls(line);
+    StateRecord r;
+    if (!(ls >> r.hash >> r.size >> r.mtime)) continue;
+    std::string rel;
+    std::getline(ls >> std::ws, rel);
+    if (!rel.empty()) state[rel] = r;
+  }
+  return state;
+}
+
+bool writeFileAtomically(const std::string& path, const std::string& data) {
+  const std::string tmp = path + ".tmp";
+  FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) return false;
+  bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+  if (std::fclose(f) != 0) ok = false;
+  if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool statFile(const std::string& path, uint64_t* size, int64_t* mtime) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+  if (size) *size = static_cast<uint64_t>(st.st_size);
+  if (mtime) *mtime = static_cast<int64_t>(st.st_mtime);
+  return true;
+}
+
+// Hashes path into hasher; bytes read in *bytes. False on a read error.
+bool hashFileInto(const std::string& path, Blake2b& hasher, std::vector<unsigned char>& buf, uint64_t* bytes) {
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return false;
+  size_t n;
+  while ((n = std::fread(buf.data(), 1, buf.size(), f)) > 0) {
+    hasher.update(buf.data(), n);
+    *bytes += n;
+  }
+  const bool ok = !std::ferror(f);
+  std::fclose(f);
+  return ok;
+}
+
+struct EntryResult {
+  enum Action { kSkipped, kVerified, kCopied } action = kSkipped;
+  bool resumed = false;
+  StateRecord record;
+  uint64_t bytes_copied = 0;
+  uint64_t bytes_hashed = 0;
+};
+
+// Copies e into partial, continuing an existing partial when resume is set (its bytes are hashed first).
+// On a size or hash mismatch the partial is removed; on a read or write error it is kept for the next attempt.
+PackSyncError copyToPartial(PackSyncSource& source, const Entry& e, const std::string& partial, bool resume,
+                            std::vector<unsigned char>& buf, EntryResult& out) {
+  Blake2b hasher;
+  uint64_t offset = 0;
+  uint64_t partial_size = 0;
+  if (resume && statFile(partial, &partial_size, nullptr) && hashFileInto(partial, hasher, buf, &out.bytes_hashed)) {
+    offset = partial_size;
+    out.resumed = true;
+  } else {
+    hasher = Blake2b();
+  }
+  std::unique_ptr<PackSyncReader> reader = source.open(e.path, offset);
+  if (!reader) return PackSyncError::kSourceReadFailed;
+  FILE* f = std::fopen(partial.c_str(), offset > 0 ? "ab" : "wb");
+  if (!f) return PackSyncError::kDestWriteFailed;
+  uint64_t total = offset;
+  PackSyncError err = PackSyncError::kNone;
+  for (;;) {
+    const long n = reader->read(buf.data(), buf.size());
+    if (n < 0) {
+      err = PackSyncError::kSourceReadFailed;
+      break;
+    }
+    if (n == 0) break;
+    hasher.update(buf.data(), static_cast<size_t>(n));
+    if (std::fwrite(buf.data(), 1, static_cast<size_t>(n), f) != static_cast<size_t>(n)) {
+      err = PackSyncError::kDestWriteFailed;
+      break;
+    }
+    total += static_cast<uint64_t>(n);
+    out.bytes_copied += static_cast<uint64_t>(n);
+  }
+  if (std::fclose(f) != 0 && err == PackSyncError::kNone) err = PackSyncError::kDestWriteFailed;
+  if (err != PackSyncError::kNone) return err;
+  if (total != e.size || hasher.hex16() != e.hash) {
+    std::remove(partial.c_str());
+    return PackSyncError::kHashMismatch;
+  }
+  return PackSyncError::kNone;
+}
+
+PackSyncError syncEntry(PackSyncSource& source, const std::string& dest_dir, const Entry& e, const StateRecord* prev,
+                        std::vector<unsigned char>& buf, EntryResult& out) {
+  const std::string dst = dest_dir + "/" + e.path;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  if (statFile(dst, &size, &mtime) && size == e.size) {
+    if (prev && prev->size == size && prev->mtime == mtime && prev->hash == e.hash) {
+      out.action = EntryResult::kSkipped;
+      out.record = *prev;
+      return PackSyncError::kNone;
+    }
+    Blake2b hasher;
+    if (hashFileInto(dst, hasher, buf, &out.bytes_hashed) && hasher.hex16() == e.hash) {
+      out.action = EntryResult::kVerified;
+      out.record = {size, mtime, e.hash};
+      return PackSyncError::kNone;
+    }
+  }
+
+  if (!makeParentDirs(dst)) return PackSyncError::kDestWriteFailed;
+  const std::string partial = dst + kPartialSuffix;
+  uint64_t partial_size = 0;
+  const bool resume = statFile(partial, &partial_size, nullptr) && partial_size > 0 && partial_size < e.size;
+  PackSyncError err = copyToPartial(source, e, partial, resume, buf, out);
+  if (err == PackSyncError::kHashMismatch && out.resumed) {
+    // The partial may be left from an older manifest version: drop it and copy the file once from the start.
+    out.resumed = false;
+    err = copyToPartial(source, e, partial, false, buf, out);
+  }
+  if (err != PackSyncError::kNone) return err;
+  if (std::rename(partial.c_str(), dst.c_str()) != 0 || !statFile(dst, &size, &mtime)) {
+    return PackSyncError::kDestWriteFailed;
+  }
+  out.action = EntryResult::kCopied;
+  out.record = {size, mtime, e.hash};
+  return PackSyncError::kNone;
+}
+
+}  // namespace
+
+const char* packSyncErrorString(PackSyncError e) {
+  switch (e) {
+    case PackSyncError::kNone: return "none";
+    case PackSyncError::kManifestMissing: return "pack_files.json not found in the bundled pack";
+    case PackSyncError::kManifestInvalid: return "pack_files.json is invalid";
+    case PackSyncError::kSourceReadFailed: return "bundled pack file could not be read";
+    case PackSyncError::kDestWriteFailed: return "pack file could not be written";
+    case PackSyncError::kHashMismatch: return "copied pack file does not match its manifest hash";
+  }
+  return "unknown";
+}
+
+std::unique_ptr<PackSyncSource> directoryPackSource(const std::string& root) {
+  return std::unique_ptr<PackSyncSource>(new DirectorySource(root));
+}
+
+bool syncPack(PackSyncSource& source, const std::string& dest_dir, const PackSyncOptions& options,
+              PackSyncReport* report, PackSyncError* out_error) {
+  const auto t0 = std::chrono::steady_clock::now();
+  PackSyncReport local;
+  PackSyncReport& r = report ? *report : local;
+  r = PackSyncReport{};
+  auto fail = [&](PackSyncError e) {
+    if (out_error) *out_error = e;
+    r.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return false;
+  };
+
+  std::string manifest_text;
+  if (!source.readAll(kPackFilesManifest, manifest_text)) return fail(PackSyncError::kManifestMissing);
+  std::vector<Entry> entries;
+  if (!parseManifest(manifest_text, entries)) return fail(PackSyncError::kManifestInvalid);
+  if (!makeParentDirs(dest_dir + "/") ) return fail(PackSyncError::kDestWriteFailed);
+
+  const std::string state_path = dest_dir + "/" + kStateFile;
+  const std::unordered_map<std::string, StateRecord> prev_state = readState(state_path);
+  r.files = entries.size();
+  for (const Entry& e : entries) r.bytes_total += e.size;
+
+  // Largest first so one big model does not start last on an otherwise idle pool.
+  std::vector<size_t> order(entries.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return entries[a].size > entries[b].size; });
+
+  size_t threads = options.threads;
+  if (threads == 0) threads = std::max<size_t>(1, std::min<size_t>(4, std::thread::hardware_concurrency()));
+  threads = std::min(threads, std::max<size_t>(1, entries.size()));
+
+  std::mutex mu;
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  PackSyncError first_error = PackSyncError::kNone;
+  std::vector<bool> done(entries.size(), false);
+  std::vector<StateRecord> records(entries.size());
+  auto worker = [&]() {
+    std::vector<unsigned char> buf(std::max<size_t>(options.buffer_bytes, 4096));
+    for (;;) {
+      const size_t k = next.fetch_add(1);
+      if (k >= order.size() || failed.load()) return;
+      const Entry& e = entries[order[k]];
+      auto it = prev_state.find(e.path);
+      EntryResult res;
+      const PackSyncError err = syncEntry(source, dest_dir, e, it == prev_state.end() ? nullptr : &it->second, buf, res);
+      std::lock_guard<std::mutex> lock(mu);
+      r.bytes_copied += res.bytes_copied;
+      r.bytes_hashed += res.bytes_hashed;
+      if (err != PackSyncError::kNone) {
+        if (!failed.exchange(true)) {
+          first_error = err;
+          r.failed_path = e.path;
+        }
+        return;
+      }
+      done[order[k]] = true;
+      records[order[k]] = res.record;
+      if (res.action == EntryResult::kSkipped) ++r.skipped;
+      else if (res.action == EntryResult::kVerified) ++r.verified;
+      else ++r.copied;
+      if (res.resumed) ++r.resumed;
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < threads; ++i) pool.emplace_back(worker);
+  worker();
+  for (std::thread& t : pool) t.join();
+
+  // Record what is in place (also after a failure, so the next attempt skips it).
+  std::string state;
+  std::unordered_map<std::string, bool> in_manifest;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    in_manifest[entries[i].path] = true;
+    if (!done[i]) continue;
+    const StateRecord& s = records[i];
+    state += s.hash + " " + std::to_string(s.size) + " " + std::to_string(s.mtime) + " " + entries[i].path + "\n";
+  }
+  if (failed) {
+    writeFileAtomically(state_path, state);
+    std::fprintf(stderr, "[Piper] pack sync failed at %s: %s\n", r.failed_path.c_str(),
+                 packSyncErrorString(first_error));
+    return fail(first_error);
+  }
+  for (const auto& kv : prev_state) {
+    if (in_manifest.count(kv.first)) continue;
+    if (std::remove((dest_dir + "/" + kv.first).c_str()) == 0) ++r.removed;
+  }
+  if (!writeFileAtomically(state_path, state) ||
+      !writeFileAtomically(dest_dir + "/" + kPackFilesManifest, manifest_text))
+    return fail(PackSyncError::kDestWriteFailed);
+
+  r.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  std::fprintf(stderr,
+               "[Piper] pack sync: %zu files, %zu copied (%zu resumed), %zu verified, %zu skipped, %zu removed; "
+               "%.1f MB copied, %.1f MB hashed in %.0f ms\n",
+               r.files, r.copied, r.resumed, r.verified, r.skipped, r.removed, r.bytes_copied / 1048576.0,
+               r.bytes_hashed / 1048576.0, r.elapsed_ms);
+  if (out_error) *out_error = PackSyncError::kNone;
+  return true;
+}
+
+Blake2b::Blake2b(size_t out_len) : out_len_(out_len == 0 || out_len > 64 ? 64 : out_len) {
+  for (int i = 0; i < 8; ++i) h_[i] = kBlake2bIv[i];
+  h_[0] ^= 0x01010000ull ^ out_len_;
+}
+
+void Blake2b::compress(bool last) {
+  uint64_t v[16], m[16];
+  for (int i = 0; i < 8; ++i) {
+    v[i] = h_[i];
+    v[i + 8] = kBlake2bIv[i];
+  }
+  v[12] ^= t_[0];
+  v[13] ^= t_[1];
+  if (last) v[14] = ~v[14];
+  for (int i = 0; i < 16; ++i) m[i] = load64(buf_ + 8 * i);
+  auto g = [&](int a, int b, int c, int d, uint64_t x, uint64_t y) {
+    v[a] = v[a] + v[b] + x;
+    v[d] = rotr64(v[d] ^ v[a], 32);
+    v[c] = v[c] + v[d];
+    v[b] = rotr64(v[b] ^ v[c], 24);
+    v[a] = v[a] + v[b] + y;
+    v[d] = rotr64(v[d] ^ v[a], 16);
+    v[c] = v[c] + v[d];
+    v[b] = rotr64(v[b] ^ v[c], 63);
+  };
+  for (int round = 0; round < 12; ++round) {
+    const uint8_t* s = kSigma[round];
+    g(0, 4, 8, 12, m[s[0]], m[s[1]]);
+    g(1, 5, 9, 13, m[s[2]], m[s[3]]);
+    g(2, 6, 10, 14, m[s[4]], m[s[5]]);
+    g(3, 7, 11, 15, m[s[6]], m[s[7]]);
+    g(0, 5, 10, 15, m[s[8]], m[s[9]]);
+    g(1, 6, 11, 12, m[s[10]], m[s[11]]);
+    g(2, 7, 8, 13, m[s[12]], m[s[13]]);
+    g(3, 4, 9, 14, m[s[14]], m[s[15]]);
+  }
+  for (int i = 0; i < 8; ++i) h_[i] ^= v[i] ^ v[i + 8];
+}
+
+void Blake2b::update(const void* data, size_t n) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  while (n > 0) {
+    if (buf_len_ == sizeof(buf_)) {
+      t_[0] += sizeof(buf_);
+      if (t_[0] < sizeof(buf_)) ++t_[1];
+      compress(false);
+      buf_len_ = 0;
+    }
+    const size_t take = std::min(n, sizeof(buf_) - buf_len_);
+    std::memcpy(buf_ + buf_len_, p, take);
+    buf_len_ += take;
+    p += take;
+    n -= take;
+  }
+}
+
+void Blake2b::final(unsigned char* out) {
+  t_[0] += buf_len_;
+  if (t_[0] < buf_len_) ++t_[1];
+  std::memset(buf_ + buf_len_, 0, sizeof(buf_) - buf_len_);
+  compress(true);
+  for (size_t i = 0; i < out_len_; ++i) out[i] = static_cast<unsigned char>(h_[i / 8] >> (8 * (i % 8)));
+}
+
+std::string Blake2b::hex16() {
+  unsigned char digest[64];
+  final(digest);
+  static const char kHex[] = "0123456789abcdef";
+  std::string hex(32, '0');
+  for (int i = 0; i < 16; ++i) {
+    hex[2 * i] = kHex[digest[i] >> 4];
+    hex[2 * i + 1] = kHex[digest[i] & 15];
+  }
+  return hex;
+}
+
+}  // namespace piper
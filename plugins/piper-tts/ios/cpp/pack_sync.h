@@ -0,0 +1,96 @@
+#ifndef PACK_SYNC_H
+#define PACK_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace piper {
+
+// Incremental copy of the bundled content pack (app bundle dir / Android assets) into a writable dir,
+// driven by pack_files.json written at pack build time:
+//   { "version": 1, "hash": "blake2b-512/128", "files": [{ "path", "size", "hash" }] }
+// hash = first 16 bytes of BLAKE2b-512 of the file, lowercase hex (Node: createHash('blake2b512')).
+//
+// A file is skipped when the destination's state record (.pack_sync_state) matches its size, mtime and
+// manifest hash, or, without a record (first sync over a legacy full copy), when the destination
+// hashes to the manifest value. Otherwise it is copied through <path>.partial on a worker pool with large
+// buffers, hashed while copying, verified and renamed into place. An interrupted copy resumes from the
+// partial file's length. Files recorded by a previous sync but absent from the manifest are removed.
+// pack_files.json is written last, so its presence marks a completed sync.
+
+constexpr const char* kPackFilesManifest = "pack_files.json";
+
+enum class PackSyncError {
+  kNone = 0,
+  kManifestMissing,
+  kManifestInvalid,
+  kSourceReadFailed,
+  kDestWriteFailed,
+  kHashMismatch,
+};
+
+const char* packSyncErrorString(PackSyncError e);
+
+class PackSyncReader {
+ public:
+  virtual ~PackSyncReader() = default;
+  // Bytes read, 0 at end, negative on error.
+  virtual long read(void* buf, size_t n) = 0;
+};
+
+class PackSyncSource {
+ public:
+  virtual ~PackSyncSource() = default;
+  // Whole small file (the manifest). False if missing.
+  virtual bool readAll(const std::string& rel_path, std::string& out) = 0;
+  // Reader positioned at offset; null if missing. Called concurrently from the worker threads.
+  virtual std::unique_ptr<PackSyncReader> open(const std::string& rel_path, uint64_t offset) = 0;
+};
+
+// Files under a directory (iOS bundle content_pack, host tools).
+std::unique_ptr<PackSyncSource> directoryPackSource(const std::string& root);
+
+struct PackSyncOptions {
+  size_t threads = 0;  // 0: min(4, hardware threads)
+  size_t buffer_bytes = 1 << 20;
+};
+
+struct PackSyncReport {
+  size_t files = 0;
+  size_t copied = 0;    // written from the source (including resumed)
+  size_t resumed = 0;   // continued from a .partial
+  size_t verified = 0;  // existing file without a state record whose hash matched
+  size_t skipped = 0;   // state record matched; not read
+  size_t removed = 0;
+  uint64_t bytes_total = 0;
+  uint64_t bytes_copied = 0;
+  uint64_t bytes_hashed = 0;  // read back from the destination for verification
+  double elapsed_ms = 0.0;
+  std::string failed_path;
+};
+
+bool syncPack(PackSyncSource& source, const std::string& dest_dir, const PackSyncOptions& options,
+              PackSyncReport* report = nullptr, PackSyncError* out_error = nullptr);
+
+// Streaming BLAKE2b (RFC 7693), unkeyed. hex16() is the pack_files.json hash.
+class Blake2b {
+ public:
+  explicit Blake2b(size_t out_len = 64);
+  void update(const void* data, size_t n);
+  void final(unsigned char* out);
+  std::string hex16();
+
+ private:
+  void compress(bool last);
+  uint64_t h_[8];
+  uint64_t t_[2] = {0, 0};
+  unsigned char buf_[128];
+  size_t buf_len_ = 0;
+  size_t out_len_;
+};
+
+}  // namespace piper
+
+#endif  // PACK_SYNC_H
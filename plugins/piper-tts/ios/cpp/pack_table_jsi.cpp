@@ -0,0 +1,207 @@
+#include "pack_table_jsi.h"
+#include "pack_container.h"
+#include <jsi/jsi.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+namespace {
+
+struct OpenPack {
+  PackContainer container;
+  std::map<std::string, PackTable> tables;
+  off_t size = 0;
+  int64_t mtime_ns = 0;
+  ino_t inode = 0;
+};
+
+std::mutex g_mutex;
+std::map<std::string, std::shared_ptr<OpenPack>> g_packs;
+
+int64_t mtimeNs(const struct stat& st) {
+#ifdef __APPLE__
+  return int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+  return int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+// The pack for path, remapped when a sync replaced the file. nullptr with error set on failure.
+std::shared_ptr<OpenPack> openPack(const std::string& path, std::string* error) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    *error = "cannot stat " + path;
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto it = g_packs.find(path);
+  if (it != g_packs.end() && it->second->size == st.st_size && it->second->mtime_ns == mtimeNs(st) &&
+      it->second->inode == st.st_ino)
+    return it->second;
+  auto pack = std::make_shared<OpenPack>();
+  // Section checksums are checked by pack_compile; hashing every section here would fault the whole file in.
+  if (!pack->container.open(path, false, error)) return nullptr;
+  for (const PackSection& section : pack->container.sections()) {
+    if (section.kind != PackSectionKind::kTable) continue;
+    if (!pack->tables[section.name].open(section, error)) return nullptr;
+  }
+  pack->size = st.st_size;
+  pack->mtime_ns = mtimeNs(st);
+  pack->inode = st.st_ino;
+  g_packs[path] = pack;
+  return pack;
+}
+
+jsi::Array stringArray(jsi::Runtime& rt, const std::vector<std::string>& values) {
+  jsi::Array out(rt, values.size());
+  for (size_t i = 0; i < values.size(); ++i) out.setValueAtIndex(rt, i, jsi::String::createFromUtf8(rt, values[i]));
+  return out;
+}
+
+jsi::Value cellValue(jsi::Runtime& rt, const PackTable& table, uint32_t c, uint32_t row) {
+  if (table.isNull(c, row)) return jsi::Value::null();
+  switch (table.type(c)) {
+    case PackColumnType::kInt:
+      return jsi::Value(static_cast<double>(table.intAt(c, row)));
+    case PackColumnType::kReal:
+      return jsi::Value(table.realAt(c, row));
+    case PackColumnType::kText: {
+      const std::string_view v = table.textAt(c, row);
+      return jsi::String::createFromUtf8(rt, reinterpret_cast<const uint8_t*>(v.data()), v.size());
+    }
+  }
+  return jsi::Value::null();
+}
+
+}  // namespace
+
+void installPackTableJsi(jsi::Runtime& runtime) {
+  runtime.global().setProperty(
+      runtime, "__piperPackTablesOpen",
+      jsi::Function::createFromHostFunction(
+          runtime, jsi::PropNameID::forAscii(runtime, "__piperPackTablesOpen"), 1,
+          [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+            if (count < 1 || !args[0].isString()) {
+              throw jsi::JSError(rt, "__piperPackTablesOpen(path): expected a string");
+            }
+            std::string error;
+            std::shared_ptr<OpenPack> pack = openPack(args[0].getString(rt).utf8(rt), &error);
+            if (!pack) throw jsi::JSError(rt, "__piperPackTablesOpen: " + error);
+            jsi::Array out(rt, pack->tables.size());
+            size_t i = 0;
+            for (const auto& [name, table] : pack->tables) {
+              std::vector<std::string> columns, indexed;
+              for (uint32_t c = 0; c < table.columns(); ++c) {
+                columns.push_back(table.columnName(c));
+                if (table.indexed(c)) indexed.push_back(table.columnName(c));
+              }
+              jsi::Object info(rt);
+              info.setProperty(rt, "name", jsi::String::createFromUtf8(rt, name));
+              info.setProperty(rt, "rows", static_cast<double>(table.rows()));
+              info.setProperty(rt, "columns", stringArray(rt, columns));
+              info.setProperty(rt, "indexed", stringArray(rt, indexed));
+              out.setValueAtIndex(rt, i++, std::move(info));
+            }
+            return out;
+          }));
+
+  runtime.global().setProperty(
+      runtime, "__piperPackTableFind",
+      jsi::Function::createFromHostFunction(
+          runtime, jsi::PropNameID::forAscii(runtime, "__piperPackTableFind"), 5,
+          [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+            if (count < 4 || !args[0].isString() || !args[1].isString() || !args[2].isString() ||
+                !(args[3].isString() || args[3].isNumber())) {
+              throw jsi::JSError(rt, "__piperPackTableFind(path, table, column, key, options?): bad arguments");
+            }
+            std::string error;
+            std::shared_ptr<OpenPack> pack = openPack(args[0].getString(rt).utf8(rt), &error);
+            if (!pack) throw jsi::JSError(rt, "__piperPackTableFind: " + error);
+            const std::string table_name = args[1].getString(rt).utf8(rt);
+            auto it = pack->tables.find(table_name);
+            if (it == pack->tables.end()) throw jsi::JSError(rt, "__piperPackTableFind: no table " + table_name);
+            const PackTable& table = it->second;
+            const std::string column_name = args[2].getString(rt).utf8(rt);
+            const int column = table.column(column_name);
+            if (column < 0 || !table.indexed(column)) {
+              throw jsi::JSError(rt, "__piperPackTableFind: " + table_name + " has no index on " + column_name);
+            }
+
+            bool prefix = false;
+            size_t limit = SIZE_MAX;
+            std::vector<uint32_t> wanted;
+            if (count > 4 && args[4].isObject()) {
+              jsi::Object options = args[4].getObject(rt);
+              const jsi::Value p = options.getProperty(rt, "prefix");
+              prefix = p.isBool() && p.getBool();
+              const jsi::Value l = options.getProperty(rt, "limit");
+              if (l.isNumber() && l.getNumber() >= 0) limit = static_cast<size_t>(l.getNumber());
+              const jsi::Value cols = options.getProperty(rt, "columns");
+              if (cols.isObject() && cols.getObject(rt).isArray(rt)) {
+                jsi::Array names = cols.getObject(rt).getArray(rt);
+                for (size_t i = 0; i < names.size(rt); ++i) {
+                  const jsi::Value name = names.getValueAtIndex(rt, i);
+                  const int c = name.isString() ? table.column(name.getString(rt).utf8(rt)) : -1;
+                  if (c >= 0) wanted.push_back(static_cast<uint32_t>(c));
+                }
+              }
+            }
+            if (wanted.empty()) {
+              for (uint32_t c = 0; c < table.columns(); ++c) wanted.push_back(c);
+            }
+
+            // Keys convert to the column's type the way SQLite's column affinity would (section = 702 matches
+            // the text '702', rule_id = '702' an integer 702).
+            std::vector<uint32_t> rows;
+            if (table.type(column) == PackColumnType::kText) {
+              std::string key;
+              if (args[3].isString()) {
+                key = args[3].getString(rt).utf8(rt);
+              } else {
+                const double n = args[3].getNumber();
+                char buf[32];
+                if (std::isfinite(n) && n == std::floor(n) && std::fabs(n) < 9e15) {
+                  std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(n));
+                } else {
+                  std::snprintf(buf, sizeof(buf), "%.17g", n);
+                }
+                key = buf;
+              }
+              table.findText(column, key, prefix, limit, rows);
+            } else if (table.type(column) == PackColumnType::kInt) {
+              double key = NAN;
+              if (args[3].isNumber()) {
+                key = args[3].getNumber();
+              } else {
+                const std::string text = args[3].getString(rt).utf8(rt);
+                char* end = nullptr;
+                const double parsed = std::strtod(text.c_str(), &end);
+                if (!text.empty() && end && *end == '\0') key = parsed;
+              }
+              if (std::isfinite(key) && key == std::floor(key)) table.findInt(column, int64_t(key), limit, rows);
+            }
+
+            jsi::Array out(rt, rows.size());
+            for (size_t i = 0; i < rows.size(); ++i) {
+              jsi::Object row(rt);
+              for (uint32_t c : wanted) {
+                row.setProperty(rt, table.columnName(c).c_str(), cellValue(rt, table, c, rows[i]));
+              }
+              out.setValueAtIndex(rt, i, std::move(row));
+            }
+            return out;
+          }));
+}
+
+}  // namespace piper
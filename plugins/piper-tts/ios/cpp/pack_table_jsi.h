@@ -0,0 +1,27 @@
+#ifndef PACK_TABLE_JSI_H
+#define PACK_TABLE_JSI_H
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+}  // namespace jsi
+}  // namespace facebook
+
+namespace piper {
+
+// Install on global (columnar rules.db / cards.db copies in a pack.bin, see pack_container.h):
+//   __piperPackTablesOpen(packBinPath) -> [{ name, rows, columns: string[], indexed: string[] }]
+//     Maps the container (kept per path and remapped when the file's size, mtime or inode changes) and lists
+//     its table sections ("rules.table", "cards.table"). Throws a JS Error if the file is missing or invalid.
+//   __piperPackTableFind(packBinPath, table, column, key, { prefix?, limit?, columns? }?) -> row objects
+//     Rows whose indexed column equals key or, with prefix: true (text columns), starts with it. A number key
+//     on a text column (or a numeric string on an integer column) is converted first, like SQLite affinity. Rows
+//     come in key order, ties in the table's row order; at most limit (default all).
+//     Only the listed columns (default all) are read; NULL -> null, integer/real -> number. Throws if the table
+//     or an index on column is missing.
+// Synchronous on the JS thread: a lookup is a binary search over the mapped index plus the values it returns.
+void installPackTableJsi(facebook::jsi::Runtime& runtime);
+
+}  // namespace piper
+
+#endif  // PACK_TABLE_JSI_H
@@ -0,0 +1,373 @@
+#include "phoneme_memo.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace piper {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedUs(Clock::time_point since) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - since).count();
+}
+
+template <size_t N>
+bool inList(std::string_view word, const char* const (&list)[N]) {
+  for (const char* entry : list) {
+    if (word == entry) return true;
+  }
+  return false;
+}
+
+// Weak/strong forms chosen by the neighbours: keyed by context, never seeded from isolation forms.
+const char* const kFunctionWords[] = {
+    "a",    "an",    "the",   "to",    "of",     "and",   "or",   "but",  "nor",   "for",   "at",   "in",
+    "on",   "by",    "as",    "from",  "with",   "into",  "onto", "than", "that",  "is",    "are",  "was",
+    "were", "be",    "been",  "am",    "has",    "have",  "had",  "do",   "did",   "can",   "could", "will",
+    "would", "shall", "should", "may",  "might",  "must",  "you",  "your", "he",    "him",   "his",  "she",
+    "her",  "it",    "its",   "we",    "us",     "our",   "they", "them", "their", "i",     "me",   "my",
+    "there", "some", "so",    "just",  "not",
+};
+
+// Spelling shared by different pronunciations (part of speech, sense): always phonemized in context.
+const char* const kHeteronyms[] = {
+    "read",      "lead",      "live",     "lives",     "wind",     "wound",    "tear",      "tears",
+    "close",     "use",       "uses",     "used",      "does",     "record",   "records",   "present",
+    "object",    "subject",   "project",  "content",   "contest",  "contract", "conduct",   "convert",
+    "desert",    "produce",   "permit",   "refuse",    "minute",   "bow",      "row",       "bass",
+    "dove",      "sow",       "invalid",  "separate",  "estimate", "moderate", "graduate",  "alternate",
+    "appropriate", "associate", "delegate", "advocate", "attribute", "increase", "decrease", "insert",
+    "insult",    "perfect",   "progress", "rebel",     "reject",   "conflict", "combat",    "compound",
+    "console",   "entrance",  "excuse",   "export",    "import",   "extract",  "polish",    "august",
+};
+
+// "<word>." that espeak reads as an abbreviation rather than the end of a clause.
+const char* const kAbbreviations[] = {
+    "mr", "mrs", "ms", "dr", "st", "jr", "sr", "vs", "etc", "no", "vol", "fig", "approx", "inc", "ltd",
+    "co", "corp", "dept", "est", "mt", "ft", "prof", "gen", "gov", "sgt", "ave", "blvd",
+};
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isTerminator(char c) {
+  return c == ',' || c == '.' || c == ';' || c == ':' || c == '!' || c == '?';
+}
+
+// UTF-8 bytes of a non-ASCII letter: lead bytes from U+00C0 up, excluding the Latin-1 symbols × ÷ and the
+// General Punctuation block (dashes, quotes; ’ is handled as an apostrophe before this is asked).
+size_t utf8LetterLength(std::string_view s, size_t i) {
+  const unsigned char c = static_cast<unsigned char>(s[i]);
+  size_t len = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC3 ? 2 : 0;
+  if (len == 0 || i + len > s.size()) return 0;
+  for (size_t k = 1; k < len; ++k) {
+    if ((static_cast<unsigned char>(s[i + k]) & 0xC0) != 0x80) return 0;
+  }
+  const unsigned char c1 = static_cast<unsigned char>(s[i + 1]);
+  if (c == 0xC3 && (c1 == 0x97 || c1 == 0xB7)) return 0;
+  if (c == 0xE2 && (c1 == 0x80 || c1 == 0x81)) return 0;
+  return len;
+}
+
+bool isRightQuote(std::string_view s, size_t i) {
+  return i + 2 < s.size() && static_cast<unsigned char>(s[i]) == 0xE2 &&
+         static_cast<unsigned char>(s[i + 1]) == 0x80 && static_cast<unsigned char>(s[i + 2]) == 0x99;
+}
+
+// Lowercased plain word (letters, inner apostrophes). False for anything else: digits, symbols, hyphens,
+// dotted or all-caps abbreviations.
+bool normalizeWord(std::string_view token, std::string& lower) {
+  lower.clear();
+  size_t upper = 0, ascii_letters = 0;
+  for (size_t i = 0; i < token.size();) {
+    const char c = token[i];
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+      if (c <= 'Z') ++upper;
+      ++ascii_letters;
+      lower += static_cast<char>(c <= 'Z' ? c - 'A' + 'a' : c);
+      ++i;
+    } else if (c == '\'' || isRightQuote(token, i)) {
+      const size_t len = c == '\'' ? 1 : 3;
+      if (i == 0 || i + len >= token.size()) return false;
+      lower += '\'';
+      i += len;
+    } else if (const size_t len = utf8LetterLength(token, i)) {
+      lower.append(token.data() + i, len);
+      i += len;
+    } else {
+      return false;
+    }
+  }
+  if (lower.empty()) return false;
+  if (upper >= 2 && upper == ascii_letters && ascii_letters == lower.size()) return false;  // "NASA", "OK"
+  return true;
+}
+
+size_t countWords(std::string_view text) {
+  size_t n = 0;
+  bool in_word = false;
+  for (char c : text) {
+    const bool space = isSpace(c);
+    if (!space && !in_word) ++n;
+    in_word = !space;
+  }
+  return n;
+}
+
+// End of the clause starting at begin (one past its terminator), or text.size().
+size_t clauseEnd(std::string_view text, size_t begin) {
+  for (size_t i = begin; i < text.size(); ++i) {
+    const char c = text[i];
+    if (c == '\n') return i + 1;
+    if (!isTerminator(c) || (i + 1 < text.size() && !isSpace(text[i + 1]))) continue;
+    if (c == '.') {
+      // "Dr." / "J." / "e.g." do not end a clause for espeak.
+      size_t w = i;
+      while (w > begin && !isSpace(text[w - 1])) --w;
+      const std::string_view word = text.substr(w, i - w);
+      if (word.size() <= 1 || word.find('.') != std::string_view::npos) continue;
+      std::string lower;
+      for (char ch : word) lower += (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+      if (inList(lower, kAbbreviations)) continue;
+    }
+    return i + 1;
+  }
+  return text.size();
+}
+
+}  // namespace
+
+PhonemeMemo::PhonemeMemo(size_t capacity) : capacity_(capacity) {}
+
+void PhonemeMemo::setCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mu_);
+  capacity_ = capacity;
+  evictTo(capacity_);
+}
+
+size_t PhonemeMemo::capacity() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return capacity_;
+}
+
+void PhonemeMemo::evictTo(size_t capacity) {
+  while (lru_.size() > capacity) {
+    index_.erase(std::string_view(lru_.back().key));
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+}
+
+bool PhonemeMemo::splitWords(const std::string& voice, std::string_view clause, std::vector<Word>& words) const {
+  words.clear();
+  size_t end = clause.size();
+  while (end > 0 && (isSpace(clause[end - 1]) || isTerminator(clause[end - 1]))) --end;
+  size_t i = 0;
+  while (i < end) {
+    while (i < end && isSpace(clause[i])) ++i;
+    size_t j = i;
+    while (j < end && !isSpace(clause[j])) ++j;
+    if (j > i) {
+      Word w;
+      if (!normalizeWord(clause.substr(i, j - i), w.lower) || inList(w.lower, kHeteronyms)) return false;
+      words.push_back(std::move(w));
+    }
+    i = j;
+  }
+  if (words.empty()) return false;
+  for (size_t k = 0; k < words.size(); ++k) {
+    Word& w = words[k];
+    w.key.reserve(voice.size() + 1 + w.lower.size() + 2);
+    w.key = voice;
+    w.key += '\0';
+    w.key += w.lower;
+    if (inList(w.lower, kFunctionWords)) {
+      char context = 'e';  // clause-final
+      if (k + 1 < words.size()) {
+        const char next = words[k + 1].lower[0];
+        context = (next == 'a' || next == 'e' || next == 'i' || next == 'o' || next == 'u') ? 'v' : 'c';
+      }
+      w.key += '\1';
+      w.key += context;
+    } else {
+      w.seedable = true;
+    }
+  }
+  return true;
+}
+
+bool PhonemeMemo::assemble(const std::vector<Word>& words, std::string& out) {
+  const Clock::time_point t0 = Clock::now();
+  std::lock_guard<std::mutex> lock(mu_);
+  if (capacity_ == 0) return false;
+  // Keys start with "<voice>\0"; the seed applies only to the voice it was rendered with.
+  const std::string_view key_voice(words[0].key.c_str());
+  const bool use_seed = seed_.valid() && key_voice == seed_voice_;
+  std::vector<std::string_view> ipa(words.size());
+  std::vector<Lru::iterator> hits;
+  hits.reserve(words.size());
+  size_t seeded = 0;
+  for (size_t k = 0; k < words.size(); ++k) {
+    auto it = index_.find(std::string_view(words[k].key));
+    if (it != index_.end()) {
+      if (it->second->context_dependent) return false;
+      ipa[k] = it->second->ipa;
+      hits.push_back(it->second);
+    } else if (words[k].seedable && use_seed && seed_.find(words[k].lower, &ipa[k]) && !ipa[k].empty()) {
+      ++seeded;
+    } else {
+      return false;
+    }
+  }
+  for (size_t k = 0; k < words.size(); ++k) {
+    if (k) out += ' ';
+    out.append(ipa[k].data(), ipa[k].size());
+  }
+  for (Lru::iterator it : hits) lru_.splice(lru_.begin(), lru_, it);
+  stats_.words += words.size();
+  stats_.memo_words += words.size();
+  stats_.seed_words += seeded;
+  ++stats_.clauses;
+  ++stats_.memo_clauses;
+  stats_.memo_us += elapsedUs(t0);
+  return true;
+}
+
+void PhonemeMemo::learn(const std::vector<Word>& words, std::string_view ipa) {
+  std::vector<std::string_view> parts;
+  parts.reserve(words.size());
+  size_t i = 0;
+  while (i < ipa.size()) {
+    while (i < ipa.size() && isSpace(ipa[i])) ++i;
+    size_t j = i;
+    while (j < ipa.size() && !isSpace(ipa[j])) ++j;
+    if (j > i) parts.push_back(ipa.substr(i, j - i));
+    i = j;
+  }
+  // espeak joins some unstressed words ("in the" -> one token); such clauses cannot be aligned.
+  if (parts.size() != words.size()) return;
+  std::lock_guard<std::mutex> lock(mu_);
+  if (capacity_ == 0) return;
+  for (size_t k = 0; k < words.size(); ++k) {
+    auto it = index_.find(std::string_view(words[k].key));
+    if (it != index_.end()) {
+      Entry& e = *it->second;
+      if (!e.context_dependent && e.ipa != parts[k]) {
+        e.context_dependent = true;
+        ++stats_.conflicts;
+      }
+      lru_.splice(lru_.begin(), lru_, it->second);
+      continue;
+    }
+    lru_.push_front(Entry{words[k].key, std::string(parts[k]), false});
+    index_.emplace(std::string_view(lru_.front().key), lru_.begin());
+    ++stats_.learned;
+  }
+  evictTo(capacity_);
+}
+
+void PhonemeMemo::runEspeak(std::string_view span, size_t word_count, const PhonemizeFn& espeak, std::string& out) {
+  const std::string text(span);
+  const Clock::time_point t0 = Clock::now();
+  espeak(text.c_str(), out);
+  const double us = elapsedUs(t0);
+  std::lock_guard<std::mutex> lock(mu_);
+  ++stats_.espeak_calls;
+  stats_.espeak_words += word_count;
+  stats_.espeak_us += us;
+  stats_.words += word_count;
+}
+
+void PhonemeMemo::phonemize(const std::string& voice, std::string_view text, const PhonemizeFn& espeak,
+                            std::string& out) {
+  if (capacity() == 0) {
+    runEspeak(text, countWords(text), espeak, out);
+    return;
+  }
+  std::vector<Word> words;
+  std::string clause_ipa;
+  size_t pending_begin = 0, pending_end = 0, pending_clauses = 0;
+  auto flushPending = [&]() {
+    if (pending_end > pending_begin) {
+      const std::string_view span = text.substr(pending_begin, pending_end - pending_begin);
+      runEspeak(span, countWords(span), espeak, out);
+      std::lock_guard<std::mutex> lock(mu_);
+      stats_.clauses += pending_clauses;
+    }
+    pending_clauses = 0;
+  };
+  size_t begin = 0;
+  while (begin < text.size()) {
+    const size_t end = clauseEnd(text, begin);
+    const std::string_view clause = text.substr(begin, end - begin);
+    if (!splitWords(voice, clause, words)) {
+      // Not memoizable: joins the pending espeak span (contiguous, so espeak sees the original text).
+      if (pending_end != begin || pending_end == pending_begin) pending_begin = begin;
+      pending_end = end;
+      if (countWords(clause) > 0) ++pending_clauses;
+      begin = end;
+      continue;
+    }
+    flushPending();
+    pending_begin = pending_end = end;
+    if (!assemble(words, out)) {
+      clause_ipa.clear();
+      runEspeak(clause, words.size(), espeak, clause_ipa);
+      learn(words, clause_ipa);
+      out += clause_ipa;
+      std::lock_guard<std::mutex> lock(mu_);
+      ++stats_.clauses;
+    }
+    begin = end;
+  }
+  flushPending();
+}
+
+bool PhonemeMemo::setSeed(const std::string& pack_path, const std::string& voice, std::string* error) {
+  if (pack_path.empty()) {
+    std::lock_guard<std::mutex> lock(mu_);
+    seed_ = PackStringMap();
+    seed_pack_.reset();
+    seed_voice_.clear();
+    return true;
+  }
+  auto pack = std::make_unique<PackContainer>();
+  if (!pack->open(pack_path, false, error)) return false;
+  const PackSection* section = pack->find("phonemes");
+  if (!section) {
+    if (error) *error = "pack has no phonemes section";
+    return false;
+  }
+  PackStringMap map;
+  if (!map.open(*section, error)) return false;
+  std::lock_guard<std::mutex> lock(mu_);
+  seed_ = map;
+  seed_pack_ = std::move(pack);
+  seed_voice_ = voice;
+  return true;
+}
+
+PhonemeMemoStats PhonemeMemo::stats() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  PhonemeMemoStats s = stats_;
+  s.entries = lru_.size();
+  s.capacity = capacity_;
+  s.seed_entries = seed_.valid() ? seed_.size() : 0;
+  return s;
+}
+
+void PhonemeMemo::resetStats() {
+  std::lock_guard<std::mutex> lock(mu_);
+  stats_ = PhonemeMemoStats();
+}
+
+void PhonemeMemo::clear() {
+  std::lock_guard<std::mutex> lock(mu_);
+  index_.clear();
+  lru_.clear();
+}
+
+}  // namespace piper
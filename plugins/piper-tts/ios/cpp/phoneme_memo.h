@@ -0,0 +1,112 @@
+#ifndef PHONEME_MEMO_H
+#define PHONEME_MEMO_H
+
+#include "pack_container.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace piper {
+
+// Phonemizes text (NUL-terminated) with the active espeak voice and appends the IPA to out.
+using PhonemizeFn = std::function<void(const char* text, std::string& out)>;
+
+struct PhonemeMemoStats {
+  uint64_t words = 0;          // words phonemized (memo and espeak)
+  uint64_t memo_words = 0;     // of those, served from the memo (learned or seeded)
+  uint64_t seed_words = 0;     // of memo_words, read from the pack seed
+  uint64_t clauses = 0;
+  uint64_t memo_clauses = 0;   // clauses assembled entirely from the memo
+  uint64_t espeak_calls = 0;
+  uint64_t espeak_words = 0;   // words in the text handed to espeak
+  double espeak_us = 0.0;      // time inside espeak
+  double memo_us = 0.0;        // time assembling memoized clauses
+  uint64_t learned = 0;        // entries added from espeak output
+  uint64_t conflicts = 0;      // words seen with two pronunciations (now context-dependent)
+  uint64_t evictions = 0;
+  size_t entries = 0;
+  size_t capacity = 0;
+  size_t seed_entries = 0;     // words in the seed pack section
+
+  double memoFraction() const { return words ? static_cast<double>(memo_words) / static_cast<double>(words) : 0.0; }
+  double espeakUsPerWord() const {
+    return espeak_words ? espeak_us / static_cast<double>(espeak_words) : 0.0;
+  }
+  // espeak time the memoized words would have cost at the measured per-word rate, minus the assembly time.
+  double savedUs() const {
+    const double saved = static_cast<double>(memo_words) * espeakUsPerWord() - memo_us;
+    return saved > 0.0 ? saved : 0.0;
+  }
+};
+
+// Word-level phoneme memo beneath espeak. Text is cut into clauses where espeak ends one (, . ; : ! ? before
+// a space, newline). A clause of plain words (letters and inner apostrophes) whose every word is memoized
+// is assembled from the memo. Any other clause goes to espeak, and its output is split back into words to
+// learn them when the counts line up. Clauses with digits, symbols, abbreviations (all-caps, dotted) or
+// heteronyms always go to espeak; consecutive ones are sent as one span, so espeak sees the original text.
+//
+// Context: function words ("the", "a", "to", ...) are keyed by whether the next word starts with a vowel
+// and whether they end the clause. A word learned with two different pronunciations is marked
+// context-dependent and every clause containing it goes to espeak from then on.
+//
+// Entries are per espeak voice in a bounded LRU. An optional seed is the pack.bin "phonemes" section
+// (pack_compile --espeak-data): isolation forms for the pack's vocabulary, read from the mapping and
+// used for content words only. Learned entries take precedence. Thread-safe; the espeak callback runs
+// without the memo's lock held.
+class PhonemeMemo {
+ public:
+  explicit PhonemeMemo(size_t capacity = 4096);
+
+  // 0 disables the memo (every call goes to espeak whole). Shrinking evicts.
+  void setCapacity(size_t capacity);
+  size_t capacity() const;
+
+  // Same IPA as espeak on the whole text (clause outputs concatenated), appended to out.
+  void phonemize(const std::string& voice, std::string_view text, const PhonemizeFn& espeak, std::string& out);
+
+  // Seed from a pack.bin "phonemes" section rendered with `voice`. Empty path drops the seed.
+  bool setSeed(const std::string& pack_path, const std::string& voice, std::string* error = nullptr);
+
+  PhonemeMemoStats stats() const;
+  void resetStats();
+  void clear();  // learned entries (the seed stays)
+
+ private:
+  struct Word {
+    std::string lower;      // lowercased, ’ folded to '
+    std::string key;        // voice \0 lower [\1 context class]
+    bool seedable = false;  // content word: the seed's isolation form applies
+  };
+  struct Entry {
+    std::string key;
+    std::string ipa;
+    bool context_dependent = false;
+  };
+  using Lru = std::list<Entry>;
+
+  bool splitWords(const std::string& voice, std::string_view clause, std::vector<Word>& words) const;
+  bool assemble(const std::vector<Word>& words, std::string& out);
+  void learn(const std::vector<Word>& words, std::string_view ipa);
+  void runEspeak(std::string_view span, size_t word_count, const PhonemizeFn& espeak, std::string& out);
+  void evictTo(size_t capacity);
+
+  mutable std::mutex mu_;
+  size_t capacity_;
+  Lru lru_;  // front = most recent
+  std::unordered_map<std::string_view, Lru::iterator> index_;  // views into the entries' keys
+  std::unique_ptr<PackContainer> seed_pack_;
+  PackStringMap seed_;
+  std::string seed_voice_;
+  PhonemeMemoStats stats_;
+};
+
+}  // namespace piper
+
+#endif  // PHONEME_MEMO_H
@@ -0,0 +1,67 @@
+#include "phoneme_memo_jsi.h"
+#include "piper_engine.h"
+#include <jsi/jsi.h>
+#include <string>
+#include <utility>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+void installPhonemeMemoJsi(jsi::Runtime& runtime) {
+  auto stats = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperPhonemeMemoStats"), 1,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        const PhonemeMemoStats s = phonemeMemoStats();
+        jsi::Object result(rt);
+        result.setProperty(rt, "words", static_cast<double>(s.words));
+        result.setProperty(rt, "memoWords", static_cast<double>(s.memo_words));
+        result.setProperty(rt, "seedWords", static_cast<double>(s.seed_words));
+        result.setProperty(rt, "memoFraction", s.memoFraction());
+        result.setProperty(rt, "clauses", static_cast<double>(s.clauses));
+        result.setProperty(rt, "memoClauses", static_cast<double>(s.memo_clauses));
+        result.setProperty(rt, "espeakCalls", static_cast<double>(s.espeak_calls));
+        result.setProperty(rt, "espeakWords", static_cast<double>(s.espeak_words));
+        result.setProperty(rt, "espeakMs", s.espeak_us / 1000.0);
+        result.setProperty(rt, "memoMs", s.memo_us / 1000.0);
+        result.setProperty(rt, "savedMs", s.savedUs() / 1000.0);
+        result.setProperty(rt, "learned", static_cast<double>(s.learned));
+        result.setProperty(rt, "conflicts", static_cast<double>(s.conflicts));
+        result.setProperty(rt, "evictions", static_cast<double>(s.evictions));
+        result.setProperty(rt, "entries", static_cast<double>(s.entries));
+        result.setProperty(rt, "capacity", static_cast<double>(s.capacity));
+        result.setProperty(rt, "seedEntries", static_cast<double>(s.seed_entries));
+        if (count > 0 && args[0].isBool() && args[0].getBool()) resetPhonemeMemoStats();
+        return result;
+      });
+
+  auto seed = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperPhonemeMemoSeed"), 2,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 1 || !args[0].isString()) {
+          throw jsi::JSError(rt, "__piperPhonemeMemoSeed(packBinPath, voice?): expected a string");
+        }
+        const std::string path = args[0].getString(rt).utf8(rt);
+        const std::string voice = count > 1 && args[1].isString() ? args[1].getString(rt).utf8(rt) : "en-us";
+        std::string error;
+        if (!setPhonemeMemoSeed(path, voice, &error)) throw jsi::JSError(rt, "__piperPhonemeMemoSeed: " + error);
+        return static_cast<double>(phonemeMemoStats().seed_entries);
+      });
+
+  auto configure = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperPhonemeMemoConfigure"), 1,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 1 || !args[0].isObject()) return jsi::Value::undefined();
+        jsi::Value capacity = args[0].getObject(rt).getProperty(rt, "capacity");
+        if (capacity.isNumber() && capacity.getNumber() >= 0) {
+          setPhonemeMemoCapacity(static_cast<size_t>(capacity.getNumber()));
+        }
+        return jsi::Value::undefined();
+      });
+
+  runtime.global().setProperty(runtime, "__piperPhonemeMemoStats", std::move(stats));
+  runtime.global().setProperty(runtime, "__piperPhonemeMemoSeed", std::move(seed));
+  runtime.global().setProperty(runtime, "__piperPhonemeMemoConfigure", std::move(configure));
+}
+
+}  // namespace piper
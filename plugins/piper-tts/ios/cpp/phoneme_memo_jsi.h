@@ -0,0 +1,22 @@
+#ifndef PHONEME_MEMO_JSI_H
+#define PHONEME_MEMO_JSI_H
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+}
+}  // namespace facebook
+
+namespace piper {
+
+// Install the word-level phoneme memo host functions (process-wide memo in piper_engine.h):
+//   __piperPhonemeMemoStats(reset?: boolean) -> { words, memoWords, seedWords, memoFraction, clauses,
+//       memoClauses, espeakCalls, espeakWords, espeakMs, memoMs, savedMs, learned, conflicts, evictions,
+//       entries, capacity, seedEntries }
+//   __piperPhonemeMemoSeed(packBinPath: string, voice?: string) -> number of seed words (throws on a bad pack)
+//   __piperPhonemeMemoConfigure({ capacity? }) -> undefined
+void installPhonemeMemoJsi(facebook::jsi::Runtime& runtime);
+
+}  // namespace piper
+
+#endif  // PHONEME_MEMO_JSI_H
@@ -1,13 +1,27 @@
 #include "piper_engine.h"
+#include "audio_pack.h"
+#include "language_segmenter.h"
+#include "memory_accounting.h"
 #include "ort_capi_adapter.h"
+#include "phoneme_memo.h"
+#include "scratch_arena.h"
+#include "text_codepoints.h"
 #include "json.hpp"
 #include <fstream>
 #include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <string_view>
+#include <thread>
 
 #ifdef PIPER_ENGINE_USE_ESPEAK
 #include <espeak-ng/speak_lib.h>
@@ -21,14 +35,133 @@ namespace {
 
 const float kMaxWavValue = 32767.0f;
 
-// Cache one session per (model_path). Config/voice state not cached across different paths.
+// Cache session pools by model_path: the primary voice plus one per-language model (LRU beyond that).
+// Users hold a shared_ptr while inferring, so an evicted pool is destroyed only once its replicas are idle.
+static constexpr size_t kMaxCachedSessions = 2;
+struct CachedSession {
+  std::string model_path;
+  std::shared_ptr<piper_ort::PiperOrtSessionPool> pool;
+};
 static std::mutex g_session_mutex;
-static piper_ort::PiperOrtSession* g_cached_session = nullptr;
-static std::string g_cached_model_path;
+static std::vector<CachedSession> g_cached_sessions;  // most recently used last
+
+// Session replicas per model = clauses inferred concurrently.
+static size_t defaultParallelism() {
+  const unsigned hw = std::thread::hardware_concurrency();
+  return std::max<size_t>(1, std::min<size_t>(4, hw / 2));
+}
+static std::atomic<size_t> g_synthesis_parallelism{defaultParallelism()};
+
+// Persistent threads for synthesizeStreaming's clause workers: each keeps its scratch arena warm across
+// utterances, and no thread is created on the way to first audio. Started with a model's session pool
+// (synthesisParallelism() threads); grows when concurrent utterances need more workers than are idle.
+class ClauseWorkerPool {
+ public:
+  void reserve(size_t threads) {
+    std::lock_guard<std::mutex> lock(mu_);
+    while (threads_ < threads) spawnLocked();
+  }
+
+  // `count` runs of one task; start() queues them, wait() returns once every run has returned.
+  struct Batch {
+    std::function<void()> task;
+    std::mutex mu;
+    std::condition_variable cv;
+    size_t remaining = 0;
+  };
+
+  void start(Batch& batch, size_t count) {
+    batch.remaining = count;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      for (size_t i = 0; i < count; ++i) queue_.push_back(&batch);
+      while (idle_ < queue_.size()) spawnLocked();
+    }
+    cv_.notify_all();
+  }
+
+  static void wait(Batch& batch) {
+    std::unique_lock<std::mutex> lock(batch.mu);
+    batch.cv.wait(lock, [&] { return batch.remaining == 0; });
+  }
+
+ private:
+  void spawnLocked() {
+    ++threads_;
+    ++idle_;
+    std::thread([this] { loop(); }).detach();
+  }
+
+  void loop() {
+    for (;;) {
+      Batch* batch = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this] { return !queue_.empty(); });
+        batch = queue_.front();
+        queue_.pop_front();
+        --idle_;
+      }
+      batch->task();
+      {
+        // Notified under the lock: the waiter may destroy the batch as soon as it sees remaining == 0.
+        std::lock_guard<std::mutex> lock(batch->mu);
+        if (--batch->remaining == 0) batch->cv.notify_all();
+      }
+      std::lock_guard<std::mutex> lock(mu_);
+      ++idle_;
+    }
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Batch*> queue_;
+  size_t threads_ = 0;
+  size_t idle_ = 0;  // threads waiting for a job
+};
+
+// Never destroyed: its threads are detached and live for the process.
+static ClauseWorkerPool& clause_workers() {
+  static ClauseWorkerPool* pool = new ClauseWorkerPool();
+  return *pool;
+}
+
+static std::mutex g_silence_trim_mutex;
+static SilenceTrimConfig g_silence_trim;
+// Pre-rendered canned lines (audio_pack.h); swapped atomically, held by requests that hit it.
+static std::mutex g_audio_pack_mutex;
+static std::shared_ptr<AudioPack> g_audio_pack;
 static std::string g_cached_espeak_path;
 #ifdef PIPER_ENGINE_USE_ESPEAK
+// espeak-ng is a global, non-reentrant library; all phonemization goes through this mutex.
+static std::mutex g_espeak_mutex;
 static bool g_espeak_initialized = false;
+// Voice currently loaded in espeak; espeak_SetVoiceByName reloads voice + dictionary even when unchanged.
+static std::string g_active_voice;
 #endif
+// Word-level memo of espeak output; process-wide so answers share the words of earlier ones.
+static PhonemeMemo g_phoneme_memo;
+
+static std::mutex g_memory_stats_mutex;
+static SynthesisMemoryStats g_memory_stats;
+static SynthesisMemoryReport g_memory_sum;
+
+// Applies op to each size field of the report (same order as the struct).
+template <typename Op>
+static void forEachMemoryField(SynthesisMemoryReport& a, const SynthesisMemoryReport& b, Op op) {
+  op(a.phoneme_bytes, b.phoneme_bytes);
+  op(a.espeak_rss_delta, b.espeak_rss_delta);
+  op(a.ort_live_bytes, b.ort_live_bytes);
+  op(a.ort_peak_bytes, b.ort_peak_bytes);
+  op(a.ort_alloc_count, b.ort_alloc_count);
+  op(a.float_audio_bytes, b.float_audio_bytes);
+  op(a.pcm_bytes, b.pcm_bytes);
+  op(a.scratch_bytes, b.scratch_bytes);
+  op(a.scratch_block_mallocs, b.scratch_block_mallocs);
+  op(a.output_bytes, b.output_bytes);
+  op(a.rss_start, b.rss_start);
+  op(a.rss_peak_delta, b.rss_peak_delta);
+}
 
 // Advance to next UTF-8 codepoint; return length in bytes (1-4), or 0 at end.
 static size_t utf8_codepoint_len(const char* p) {
@@ -41,9 +174,12 @@ static size_t utf8_codepoint_len(const char* p) {
   return 1;
 }
 
+// Phoneme (one UTF-8 codepoint) -> ids. std::less<> so codepoints are looked up as string_views, not keys.
+using PhonemeIdMap = std::map<std::string, std::vector<int64_t>, std::less<>>;
+
 // Build phoneme string -> list of ids from config["phoneme_id_map"]. Piper expects all ids per phoneme and PAD between phonemes.
-static std::map<std::string, std::vector<int64_t>> parse_phoneme_id_map(const json& config) {
-  std::map<std::string, std::vector<int64_t>> out;
+static PhonemeIdMap parse_phoneme_id_map(const json& config) {
+  PhonemeIdMap out;
   if (!config.contains("phoneme_id_map") || !config["phoneme_id_map"].is_object())
     return out;
   for (auto& [key, val] : config["phoneme_id_map"].items()) {
@@ -59,11 +195,17 @@ static std::map<std::string, std::vector<int64_t>> parse_phoneme_id_map(const js
 }
 
 // Convert phoneme string (UTF-8) to sequence of ids: BOS, PAD, (phoneme_ids, PAD)*, EOS. Matches Piper reference (interspersePad=true).
-static std::vector<int64_t> phonemes_to_ids(
-    const std::string& phonemes,
-    const std::map<std::string, std::vector<int64_t>>& id_map,
-    int64_t default_id) {
-  std::vector<int64_t> ids;
+// Unmapped phonemes become default_id, or are dropped with skip_missing (text voices: characters outside the
+// training alphabet, as Piper's preprocessing drops them). ids is replaced.
+static void phonemes_to_ids(
+    const ArenaString& phonemes,
+    const PhonemeIdMap& id_map,
+    int64_t default_id,
+    bool skip_missing,
+    ArenaVector<int64_t>& ids) {
+  ids.clear();
+  // Nearly every phoneme maps to one id plus one PAD; reserving that up front keeps the vector from growing.
+  ids.reserve(2 * phonemes.size() + 3);
   auto pad_it = id_map.find("_");
   const std::vector<int64_t>* pad_ids = (pad_it != id_map.end()) ? &pad_it->second : nullptr;
   auto bos_it = id_map.find("^");
@@ -76,10 +218,12 @@ static std::vector<int64_t> phonemes_to_ids(
   while (*p) {
     size_t len = utf8_codepoint_len(p);
     if (len == 0) break;
-    std::string key(p, len);
-    auto i = id_map.find(key);
+    auto i = id_map.find(std::string_view(p, len));
     if (i != id_map.end()) {
       for (int64_t id : i->second) ids.push_back(id);
+    } else if (skip_missing) {
+      p += len;
+      continue;
     } else {
       ids.push_back(default_id);
     }
@@ -91,18 +235,13 @@ static std::vector<int64_t> phonemes_to_ids(
   if (eos_it != id_map.end()) {
     for (int64_t id : eos_it->second) ids.push_back(id);
   }
-  return ids;
 }
 
 #ifdef PIPER_ENGINE_USE_ESPEAK
-// Phonemize text with espeak-ng; append IPA phonemes to out.
+// Requires g_espeak_mutex. Initializes espeak once and switches voice only when it differs from the active one.
 // On failure, sets *out_error to kEspeakInitFailed or kEspeakSetVoiceFailed if non-null.
-static bool phonemize_espeak(
-    const std::string& text,
-    const std::string& voice,
-    const std::string& data_path,
-    std::string& phonemes_out,
-    SynthesizeError* out_error) {
+static bool ensure_espeak_voice(const std::string& voice, const std::string& data_path, size_t* switches,
+                                SynthesizeError* out_error) {
   if (!g_espeak_initialized) {
     int r = espeak_Initialize(
         AUDIO_OUTPUT_SYNCHRONOUS,
@@ -116,14 +255,20 @@ static bool phonemize_espeak(
     g_espeak_initialized = true;
     g_cached_espeak_path = data_path;
   }
+  if (voice == g_active_voice) return true;
   if (espeak_SetVoiceByName(voice.c_str()) != 0) {
+    g_active_voice.clear();
     if (out_error) *out_error = SynthesizeError::kEspeakSetVoiceFailed;
     return false;
   }
+  g_active_voice = voice;
+  if (switches) ++*switches;
+  return true;
+}
 
-  std::string text_copy(text);
-  const char* input = text_copy.c_str();
-  phonemes_out.clear();
+// Requires g_espeak_mutex and an active voice. Phonemize text with espeak-ng; append IPA phonemes to out.
+static void espeak_phonemize(const char* text, std::string& out) {
+  const char* input = text;
   while (input && *input) {
     int terminator = 0;
     const char* ip = input;
@@ -133,15 +278,715 @@ static bool phonemize_espeak(
         0x02,  // IPA
         &terminator);
     if (phoneme_ptr)
-      phonemes_out += phoneme_ptr;
+      out += phoneme_ptr;
     input = ip;
   }
+}
+
+// Requires g_espeak_mutex and an active voice. Words the memo has seen skip espeak (phoneme_memo.h).
+static void phonemize_active_voice(const std::string& text, ArenaString& phonemes_out) {
+  static thread_local std::string phonemes;  // keeps its capacity across requests
+  phonemes.clear();
+  g_phoneme_memo.phonemize(g_active_voice, text, espeak_phonemize, phonemes);
+  phonemes_out.assign(phonemes.data(), phonemes.size());
+}
+
+// Phonemize every segment with its voice. Segments are visited grouped by voice, starting with the voice
+// espeak already has loaded, so mixed text costs one switch per distinct voice rather than one per run.
+static bool phonemize_segments(const std::vector<LanguageSegment>& segments,
+                               const std::string& data_path,
+                               ArenaVector<ArenaString>& phonemes_out,
+                               size_t* switches,
+                               SynthesizeError* out_error) {
+  std::lock_guard<std::mutex> lock(g_espeak_mutex);
+  const ArenaAllocator<char> alloc(*phonemes_out.get_allocator().arena());
+  phonemes_out.assign(segments.size(), ArenaString(alloc));
+  ArenaVector<bool> done(segments.size(), false, alloc);
+  size_t remaining = segments.size();
+  while (remaining > 0) {
+    std::string voice;
+    for (size_t i = 0; i < segments.size() && voice.empty(); ++i) {
+      if (!done[i] && segments[i].voice == g_active_voice) voice = g_active_voice;
+    }
+    if (voice.empty()) {
+      for (size_t i = 0; i < segments.size(); ++i) {
+        if (!done[i]) {
+          voice = segments[i].voice;
+          break;
+        }
+      }
+    }
+    if (!ensure_espeak_voice(voice, data_path, switches, out_error)) return false;
+    for (size_t i = 0; i < segments.size(); ++i) {
+      if (done[i] || segments[i].voice != voice) continue;
+      phonemize_active_voice(segments[i].text, phonemes_out[i]);
+      done[i] = true;
+      --remaining;
+    }
+  }
   return true;
 }
 #endif
 
+// Per-model settings from a Piper voice config (.onnx.json).
+struct VoiceModel {
+  std::string model_path;
+  PhonemeIdMap id_map;
+  int64_t default_id = 3;
+  bool text_phonemes = false;  // "phoneme_type": "text": ids from folded codepoints, no espeak
+  int sample_rate = 22050;
+  float noise_scale = 0.62f, length_scale = 1.08f, noise_w = 0.8f;
+};
+
+// "phoneme_type": "text" voices map (folded) characters through phoneme_id_map; the default is "espeak".
+static bool is_text_voice(const json& config) {
+  return config.contains("phoneme_type") && config["phoneme_type"].is_string() &&
+         config["phoneme_type"].get<std::string>() == "text";
+}
+
+static void load_voice_model(const json& config, const std::string& model_path,
+                             const SynthesizeOverrides* overrides, VoiceModel& vm) {
+  vm.model_path = model_path;
+  if (config.contains("audio") && config["audio"].contains("sample_rate"))
+    vm.sample_rate = config["audio"]["sample_rate"].get<int>();
+  // Recommended defaults: slightly slower, less warbly (length_scale=1.08, noise_scale=0.62, noise_w=0.8)
+  if (config.contains("inference")) {
+    auto& inf = config["inference"];
+    if (inf.contains("noise_scale")) vm.noise_scale = inf["noise_scale"].get<float>();
+    if (inf.contains("length_scale")) vm.length_scale = inf["length_scale"].get<float>();
+    if (inf.contains("noise_w")) vm.noise_w = inf["noise_w"].get<float>();
+  }
+  if (overrides) {
+    if (overrides->noise_scale >= 0.f) vm.noise_scale = overrides->noise_scale;
+    if (overrides->length_scale >= 0.f) vm.length_scale = overrides->length_scale;
+    if (overrides->noise_w >= 0.f) vm.noise_w = overrides->noise_w;
+  }
+  vm.text_phonemes = is_text_voice(config);
+  vm.id_map = parse_phoneme_id_map(config);
+  auto space_it = vm.id_map.find(" ");
+  if (space_it != vm.id_map.end() && !space_it->second.empty())
+    vm.default_id = space_it->second[0];
+}
+
+// Relative paths in the voice config resolve against the config's directory.
+static std::string resolve_relative(const std::string& config_path, const std::string& path) {
+  if (path.empty() || path[0] == '/') return path;
+  const size_t slash = config_path.find_last_of('/');
+  return slash == std::string::npos ? path : config_path.substr(0, slash + 1) + path;
+}
+
+// Optional config["language_models"]: { "<espeak voice or language>": { "model": "...", "config": "..." } }.
+// Matches the exact voice first, then its language prefix ("de" for "de-at"). Models whose sample rate differs
+// from the primary are skipped (their audio could not be stitched).
+static const VoiceModel* language_model_for(const json& config, const std::string& config_path,
+                                            const std::string& voice, int primary_rate,
+                                            const SynthesizeOverrides* overrides,
+                                            std::map<std::string, VoiceModel>& loaded) {
+  if (!config.contains("language_models") || !config["language_models"].is_object()) return nullptr;
+  const json& models = config["language_models"];
+  std::string key = voice;
+  if (!models.contains(key)) {
+    key = voice.substr(0, voice.find('-'));
+    if (!models.contains(key)) return nullptr;
+  }
+  auto cached = loaded.find(key);
+  if (cached != loaded.end()) return cached->second.model_path.empty() ? nullptr : &cached->second;
+
+  VoiceModel& vm = loaded[key];
+  const json& entry = models[key];
+  if (!entry.is_object() || !entry.contains("model") || !entry.contains("config")) return nullptr;
+  const std::string model_path = resolve_relative(config_path, entry["model"].get<std::string>());
+  const std::string lang_config_path = resolve_relative(config_path, entry["config"].get<std::string>());
+  std::ifstream f(lang_config_path);
+  json lang_config;
+  try {
+    if (!f) return nullptr;
+    lang_config = json::parse(f);
+  } catch (...) {
+    std::fprintf(stderr, "[Piper] language model config for '%s' unreadable; using primary voice\n", key.c_str());
+    return nullptr;
+  }
+  VoiceModel candidate;
+  load_voice_model(lang_config, model_path, overrides, candidate);
+  if (candidate.sample_rate != primary_rate) {
+    std::fprintf(stderr, "[Piper] language model for '%s' is %d Hz (primary %d Hz); using primary voice\n",
+                 key.c_str(), candidate.sample_rate, primary_rate);
+    return nullptr;
+  }
+  vm = std::move(candidate);
+  return &vm;
+}
+
+// Requires g_session_mutex. Returns the cached pool for model_path, creating it (and evicting the
+// least recently used one beyond kMaxCachedSessions) if needed.
+static std::shared_ptr<piper_ort::PiperOrtSessionPool> acquire_pool_locked(const std::string& model_path) {
+  for (size_t i = 0; i < g_cached_sessions.size(); ++i) {
+    if (g_cached_sessions[i].model_path == model_path) {
+      CachedSession hit = g_cached_sessions[i];
+      g_cached_sessions.erase(g_cached_sessions.begin() + static_cast<std::ptrdiff_t>(i));
+      g_cached_sessions.push_back(hit);
+      return hit.pool;
+    }
+  }
+  std::shared_ptr<piper_ort::PiperOrtSessionPool> pool(piper_ort::createSessionPool(model_path.c_str()),
+                                                       piper_ort::destroySessionPool);
+  if (!pool) return nullptr;
+  clause_workers().reserve(g_synthesis_parallelism.load());
+  while (g_cached_sessions.size() >= kMaxCachedSessions) g_cached_sessions.erase(g_cached_sessions.begin());
+  g_cached_sessions.push_back({model_path, pool});
+  return pool;
+}
+
+// Per-request state shared by every clause of an utterance.
+struct SynthesisContext {
+  std::string config_path;
+  uint64_t voice_key = 0;  // audio pack identity of the primary voice
+  json config;
+  VoiceModel primary;
+  SegmenterOptions seg_opts;
+  std::map<std::string, VoiceModel> language_models;
+  int64_t speaker_id = 0;
+};
+
+static bool load_context(const std::string& model_path, const std::string& config_path,
+                         const SynthesizeOverrides* overrides, SynthesisContext& ctx, SynthesizeError* out_error) {
+  std::ifstream f(config_path, std::ios::binary);
+  if (!f) {
+    if (out_error) *out_error = SynthesizeError::kConfigOpenFailed;
+    return false;
+  }
+  const std::string config_bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  try {
+    ctx.config = json::parse(config_bytes);
+  } catch (...) {
+    if (out_error) *out_error = SynthesizeError::kConfigParseFailed;
+    return false;
+  }
+  ctx.config_path = config_path;
+  bool pack_loaded;
+  {
+    std::lock_guard<std::mutex> lock(g_audio_pack_mutex);
+    pack_loaded = g_audio_pack != nullptr;
+  }
+  // The model hash is only needed to match an audio pack; hashed once per model file (cached by path and mtime).
+  uint64_t model_hash = 0;
+  if (pack_loaded && modelContentHash(model_path, &model_hash))
+    ctx.voice_key = voiceIdentityKey(config_bytes, model_hash);
+  const json& config = ctx.config;
+  load_voice_model(config, model_path, overrides, ctx.primary);
+
+  if (config.contains("espeak") && config["espeak"].contains("voice"))
+    ctx.seg_opts.default_voice = config["espeak"]["voice"].get<std::string>();
+  if (config.contains("espeak") && config["espeak"].contains("script_voices") &&
+      config["espeak"]["script_voices"].is_object()) {
+    for (auto& [script, v] : config["espeak"]["script_voices"].items()) {
+      if (v.is_string()) ctx.seg_opts.script_voices[script] = v.get<std::string>();
+    }
+  }
+  if (config.contains("num_speakers") && config["num_speakers"].get<int>() > 1)
+    ctx.speaker_id = 0;  // default speaker
+  return true;
+}
+
+// Canned line from the audio pack. Skipped when the pack was rendered for another voice or the request
+// overrides inference scales (the pack holds default-scale audio; gain is normalized away). hold keeps the
+// mapping alive while pcm is used.
+static bool find_in_audio_pack(const SynthesisContext& ctx, const std::string& text,
+                               const SynthesizeOverrides* overrides, std::shared_ptr<AudioPack>& hold,
+                               const int16_t** pcm, size_t* samples) {
+  if (overrides && (overrides->noise_scale >= 0.f || overrides->length_scale >= 0.f || overrides->noise_w >= 0.f))
+    return false;
+  {
+    std::lock_guard<std::mutex> lock(g_audio_pack_mutex);
+    hold = g_audio_pack;
+  }
+  if (!hold || hold->voiceKey() != ctx.voice_key || hold->sampleRate() != ctx.primary.sample_rate) return false;
+  return hold->find(canonicalUtteranceText(text), pcm, samples);
+}
+
+// Phonemes for one Piper model, in text order (request scratch memory).
+struct ModelRun {
+  const VoiceModel* model;
+  ArenaString phonemes;
+};
+
+// Phonemize text (one espeak voice per language segment) and group it into per-model runs. A text voice
+// ("phoneme_type": "text") takes the whole text as folded codepoints without touching espeak.
+// Not reentrant on ctx/mem/rss; espeak_rss_delta accumulates.
+static bool phonemize_runs(SynthesisContext& ctx, const std::string& espeak_data_path, const std::string& text,
+                           const SynthesizeOverrides* overrides, ArenaVector<ModelRun>& runs,
+                           SynthesisMemoryReport& mem, piper_mem::ResidentTracker& rss, SynthesizeError* out_error) {
+  const ArenaAllocator<char> alloc(*runs.get_allocator().arena());
+  if (ctx.primary.text_phonemes) {
+    runs.clear();
+    ArenaString codepoints(alloc);
+    appendFoldedTextCodepoints(text, codepoints);
+    std::fprintf(stderr, "[Piper] synthesize: text voice, %zu codepoint bytes (no espeak)\n", codepoints.size());
+    if (!codepoints.empty()) runs.push_back({&ctx.primary, std::move(codepoints)});
+    return true;
+  }
+  std::fprintf(stderr, "[Piper] synthesize: phonemize start\n");
+  std::fflush(stderr);
+  const std::vector<LanguageSegment> segments = segmentByLanguage(text, ctx.seg_opts);
+  ArenaVector<ArenaString> segment_phonemes(alloc);
+#ifdef PIPER_ENGINE_USE_ESPEAK
+  size_t voice_switches = 0;
+  const size_t rss_before_espeak = rss.sample();
+  const bool phonemized = phonemize_segments(segments, espeak_data_path, segment_phonemes, &voice_switches, out_error);
+  const size_t rss_after_espeak = rss.sample();
+  mem.espeak_rss_delta += rss_after_espeak > rss_before_espeak ? rss_after_espeak - rss_before_espeak : 0;
+  mem.rss_peak_delta = rss.peakDelta();
+  if (!phonemized)
+    return false;
+  std::fprintf(stderr, "[Piper] synthesize: phonemize done (segments=%zu voice switches=%zu)\n",
+               segments.size(), voice_switches);
+  std::fflush(stderr);
+#else
+  (void)espeak_data_path;
+  (void)mem;
+  (void)rss;
+  if (out_error) *out_error = SynthesizeError::kEspeakNotLinked;
+  return false;  // espeak not linked
+#endif
+
+  // Consecutive segments on the same Piper model share one inference; a language model from
+  // config["language_models"] takes segments in its language.
+  runs.clear();
+  for (size_t i = 0; i < segments.size(); ++i) {
+    if (segment_phonemes[i].empty()) continue;
+    const VoiceModel* vm = nullptr;
+    if (!segments[i].is_default) {
+      vm = language_model_for(ctx.config, ctx.config_path, segments[i].voice, ctx.primary.sample_rate, overrides,
+                              ctx.language_models);
+    }
+    if (!vm) vm = &ctx.primary;
+    if (runs.empty() || runs.back().model != vm) {
+      runs.push_back({vm, ArenaString(alloc)});
+    } else {
+      runs.back().phonemes += ' ';
+    }
+    // A text-type language model reads the segment's own characters, not espeak's IPA.
+    if (vm->text_phonemes) {
+      appendFoldedTextCodepoints(segments[i].text, runs.back().phonemes);
+    } else {
+      runs.back().phonemes += segment_phonemes[i];
+    }
+  }
+  return true;
+}
+
+// Run each model run on a replica of its session pool and append the audio in order. Safe to call from
+// several threads at once (each takes its own replica). phoneme_bytes_out: phoneme strings + id vectors.
+static bool infer_runs(const SynthesisContext& ctx, const ArenaVector<ModelRun>& runs, size_t max_replicas,
+                       ArenaVector<float>& audio_float, size_t* phoneme_bytes_out, SynthesizeError* out_error) {
+  auto set_err = [out_error](SynthesizeError e) { if (out_error) *out_error = e; };
+  std::fprintf(stderr, "[Piper] synthesize: runInference start (runs=%zu)\n", runs.size());
+  std::fflush(stderr);
+  const size_t start = audio_float.size();
+  size_t phoneme_bytes = 0;
+  bool any_ids = false;  // phoneme_bytes counts capacity, so it is non-zero even when every run mapped to nothing
+  ArenaVector<int64_t> phoneme_ids(ArenaAllocator<int64_t>(*audio_float.get_allocator().arena()));
+  for (const ModelRun& run : runs) {
+    phonemes_to_ids(run.phonemes, run.model->id_map, run.model->default_id, run.model->text_phonemes, phoneme_ids);
+    phoneme_bytes += run.phonemes.capacity() + phoneme_ids.capacity() * sizeof(int64_t);
+    if (phoneme_ids.empty()) continue;
+    any_ids = true;
+
+    std::shared_ptr<piper_ort::PiperOrtSessionPool> pool;
+    {
+      std::lock_guard<std::mutex> lock(g_session_mutex);
+      pool = acquire_pool_locked(run.model->model_path);
+    }
+    piper_ort::PiperOrtSession* session = pool ? piper_ort::acquireReplica(pool.get(), max_replicas) : nullptr;
+    if (!session) {
+      set_err(SynthesizeError::kOrtCreateSessionFailed);
+      return false;
+    }
+    // Appended straight from the ORT output tensor (no intermediate vector).
+    size_t run_samples = 0;
+    const bool inferred = piper_ort::runInference(
+        session, phoneme_ids.data(), phoneme_ids.size(), run.model->noise_scale, run.model->length_scale,
+        run.model->noise_w, ctx.speaker_id, [&audio_float, &run_samples](const float* samples, size_t count) {
+          audio_float.insert(audio_float.end(), samples, samples + count);
+          run_samples = count;
+        });
+    piper_ort::releaseReplica(pool.get(), session);
+    if (!inferred || run_samples == 0) {
+      set_err(SynthesizeError::kOrtRunInferenceFailed);
+      return false;
+    }
+  }
+  if (phoneme_bytes_out) *phoneme_bytes_out = phoneme_bytes;
+  if (!any_ids) {
+    set_err(SynthesizeError::kPhonemeIdsEmpty);
+    return false;
+  }
+  std::fprintf(stderr, "[Piper] synthesize: runInference done (samples=%zu)\n", audio_float.size() - start);
+  std::fflush(stderr);
+  if (audio_float.size() == start) {
+    set_err(SynthesizeError::kOrtRunInferenceFailed);
+    return false;
+  }
+  return true;
+}
+
+// phonemize_runs + infer_runs on the calling thread; phoneme_bytes keeps the per-call max.
+static bool render_float(SynthesisContext& ctx, const std::string& espeak_data_path, const std::string& text,
+                         const SynthesizeOverrides* overrides, ArenaVector<float>& audio_float,
+                         SynthesisMemoryReport& mem, piper_mem::ResidentTracker& rss, SynthesizeError* out_error) {
+  ArenaVector<ModelRun> runs(ArenaAllocator<ModelRun>(*audio_float.get_allocator().arena()));
+  if (!phonemize_runs(ctx, espeak_data_path, text, overrides, runs, mem, rss, out_error))
+    return false;
+  size_t phoneme_bytes = 0;
+  const bool ok = infer_runs(ctx, runs, g_synthesis_parallelism.load(), audio_float, &phoneme_bytes, out_error);
+  mem.phoneme_bytes = std::max(mem.phoneme_bytes, phoneme_bytes);
+  return ok;
+}
+
+// Gain, peak normalization and int16 conversion (same as Piper). pcm_out has room for n samples.
+// Applies overrides->gain_db in place and returns the peak magnitude afterwards (at least 0.01, the floor of
+// the normalization below).
+static float apply_gain(float* audio_float, size_t n, const SynthesizeOverrides* overrides) {
+  // Gain (dB): multiply samples by 10^(gain_db/20) before peak normalization
+  if (overrides && overrides->gain_db >= -100.f) {
+    const float gain_linear = std::pow(10.f, overrides->gain_db / 20.f);
+    for (size_t i = 0; i < n; ++i) audio_float[i] *= gain_linear;
+  }
+  float max_val = 0.01f;
+  for (size_t i = 0; i < n; ++i) {
+    float a = std::fabs(audio_float[i]);
+    if (a > max_val) max_val = a;
+  }
+  return max_val;
+}
+
+// Peak normalization: `peak` maps to kMaxWavValue.
+static void scale_to_pcm(const float* audio_float, size_t n, float peak, int16_t* pcm_out) {
+  float scale = kMaxWavValue / std::max(0.01f, peak);
+  for (size_t i = 0; i < n; ++i) {
+    float s = audio_float[i] * scale;
+    s = std::max(-kMaxWavValue, std::min(kMaxWavValue, s));
+    pcm_out[i] = static_cast<int16_t>(s);
+  }
+}
+
+static void float_to_pcm(float* audio_float, size_t n, const SynthesizeOverrides* overrides, int16_t* pcm_out) {
+  scale_to_pcm(audio_float, n, apply_gain(audio_float, n, overrides), pcm_out);
+}
+
+// Drops model-generated silence at the given edges of audio (and, with max_gap_ms, shortens long interior gaps)
+// per silenceTrim().
+static void trim_model_silence(ArenaVector<float>& audio_float, int sample_rate, unsigned edges, const char* where) {
+  SilenceTrimConfig config;
+  {
+    std::lock_guard<std::mutex> lock(g_silence_trim_mutex);
+    config = g_silence_trim;
+  }
+  const SilenceTrimStats trimmed = trimSilence(audio_float.data(), audio_float.size(), sample_rate, config, edges);
+  if (trimmed.removed() == 0) return;
+  audio_float.resize(audio_float.size() - trimmed.removed());
+  const double ms_per_sample = sample_rate > 0 ? 1000.0 / sample_rate : 0.0;
+  std::fprintf(stderr, "[Piper] %s: trimmed silence lead=%.0fms tail=%.0fms gaps=%zu (%.0fms), %zu samples left\n",
+               where, trimmed.lead_samples * ms_per_sample, trimmed.tail_samples * ms_per_sample, trimmed.gaps,
+               trimmed.gap_samples * ms_per_sample, audio_float.size());
+  std::fflush(stderr);
+}
+
+// Silence edges to trim on clause i of n: the utterance's outer edges only; the pauses between sentences are
+// the tail and lead silence of the clauses around them.
+static unsigned clause_trim_edges(size_t i, size_t n) {
+  return (i == 0 ? kSilenceEdgeLead : kSilenceEdgeNone) | (i + 1 == n ? kSilenceEdgeTail : kSilenceEdgeNone);
+}
+
+// Largest per-scope arena use, and every heap block the arena took (0 once it is warm).
+static void record_scratch(const ScratchScope& scratch, SynthesisMemoryReport& mem) {
+  mem.scratch_bytes = std::max(mem.scratch_bytes, scratch.usedBytes());
+  mem.scratch_block_mallocs += scratch.blockMallocs();
+}
+
+static void record_ort_window(const piper_mem::OrtWindow& window, SynthesisMemoryReport& mem) {
+  const piper_mem::OrtAllocCounters c = window.counters();
+  mem.ort_live_bytes = c.live_bytes;
+  mem.ort_peak_bytes = c.peak_bytes;
+  mem.ort_alloc_count = c.alloc_count;
+}
+
+// Clause boundaries for streaming: . ! ? ; : or a newline followed by whitespace (closing quotes and brackets
+// stay with their clause). Text inside <lang>…</lang> is never split, and clauses without a letter or digit
+// are folded into their neighbour so a stray "..." does not cost an inference.
+static std::vector<std::string> split_clauses(const std::string& text) {
+  std::vector<std::string> clauses;
+  std::string current;
+  int lang_depth = 0;
+  auto has_word = [](const std::string& s) {
+    for (unsigned char c : s) {
+      if (std::isalnum(c) || c >= 0x80) return true;
+    }
+    return false;
+  };
+  auto flush = [&]() {
+    size_t b = current.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) {
+      current.clear();
+      return;
+    }
+    size_t e = current.find_last_not_of(" \t\r\n");
+    std::string clause = current.substr(b, e - b + 1);
+    current.clear();
+    if (!has_word(clause) && !clauses.empty()) {
+      clauses.back() += ' ';
+      clauses.back() += clause;
+    } else if (!clauses.empty() && !has_word(clauses.back())) {
+      clauses.back() += ' ';
+      clauses.back() += clause;
+    } else {
+      clauses.push_back(std::move(clause));
+    }
+  };
+  for (size_t i = 0; i < text.size(); ++i) {
+    const char c = text[i];
+    if (c == '<') {
+      if (text.compare(i, 5, "<lang") == 0) ++lang_depth;
+      else if (text.compare(i, 7, "</lang>") == 0 && lang_depth > 0) --lang_depth;
+    }
+    current += c;
+    if (lang_depth > 0) continue;
+    if (c == '\n') {
+      flush();
+      continue;
+    }
+    if (c != '.' && c != '!' && c != '?' && c != ';' && c != ':') continue;
+    size_t j = i + 1;
+    while (j < text.size() && (text[j] == '.' || text[j] == '!' || text[j] == '?' || text[j] == '"' ||
+                               text[j] == '\'' || text[j] == ')' || text[j] == ']')) {
+      current += text[j];
+      ++j;
+    }
+    i = j - 1;
+    if (j == text.size() || std::isspace(static_cast<unsigned char>(text[j]))) flush();
+  }
+  flush();
+  return clauses;
+}
+
+// Streams clauses rendered by `replicas` pooled worker threads, each inferring on its own session replica, and
+// delivers them to on_chunk on the calling thread strictly in text order. Workers run at most 2x replicas
+// clauses ahead of delivery. Phonemization stays serialized (espeak is global); inference overlaps.
+static bool stream_clauses_parallel(SynthesisContext& ctx, const std::string& espeak_data_path,
+                                    const std::vector<std::string>& clauses, const SynthesizeOverrides* overrides,
+                                    const SynthesisChunkCallback& on_chunk, size_t replicas,
+                                    SynthesisMemoryReport& mem, piper_mem::ResidentTracker& rss,
+                                    size_t& sample_offset, SynthesizeError* out_error) {
+  struct ClauseResult {
+    bool done = false;
+    bool ok = false;
+    SynthesizeError error = SynthesizeError::kNone;
+    std::vector<float> audio;  // gain applied; normalized by the running peak when delivered, in text order
+    float peak = 0.f;
+  };
+  const size_t n = clauses.size();
+  const size_t window = 2 * replicas;
+  std::vector<ClauseResult> results(n);
+  std::mutex mu;  // results, next_clause, delivered, stop
+  std::condition_variable cv;
+  size_t next_clause = 0;
+  size_t delivered = 0;
+  bool stop = false;
+  std::mutex state_mu;  // ctx (language model cache), mem, rss
+  piper_mem::OrtWindow* const ort_window = piper_mem::OrtWindowScope::current();
+
+  auto worker = [&]() {
+    // Pool threads charge their ORT allocations to the request that handed them the clauses.
+    piper_mem::OrtWindowScope ort_scope(ort_window);
+    for (;;) {
+      size_t i = 0;
+      {
+        std::unique_lock<std::mutex> lock(mu);
+        cv.wait(lock, [&] { return stop || next_clause >= n || next_clause < delivered + window; });
+        if (stop || next_clause >= n) return;
+        i = next_clause++;
+      }
+      ClauseResult r;
+      // The clause's temporaries live in this worker's arena; only r.audio crosses to the delivering thread.
+      ScratchScope scratch;
+      ArenaVector<ModelRun> runs(scratch.allocator<ModelRun>());
+      ArenaVector<float> audio_float(scratch.allocator<float>());
+      size_t phoneme_bytes = 0;
+      {
+        std::lock_guard<std::mutex> state(state_mu);
+        r.ok = phonemize_runs(ctx, espeak_data_path, clauses[i], overrides, runs, mem, rss, &r.error);
+      }
+      if (r.ok) r.ok = infer_runs(ctx, runs, replicas, audio_float, &phoneme_bytes, &r.error);
+      if (r.ok) {
+        trim_model_silence(audio_float, ctx.primary.sample_rate, clause_trim_edges(i, n), "synthesizeStreaming");
+        r.peak = apply_gain(audio_float.data(), audio_float.size(), overrides);
+        r.audio.assign(audio_float.begin(), audio_float.end());
+      }
+      {
+        std::lock_guard<std::mutex> state(state_mu);
+        record_scratch(scratch, mem);
+        mem.phoneme_bytes = std::max(mem.phoneme_bytes, phoneme_bytes);
+        mem.float_audio_bytes = std::max(mem.float_audio_bytes, audio_float.capacity() * sizeof(float));
+      }
+      r.done = true;
+      {
+        std::lock_guard<std::mutex> lock(mu);
+        results[i] = std::move(r);
+      }
+      cv.notify_all();
+    }
+  };
+
+  ClauseWorkerPool::Batch workers;
+  workers.task = worker;
+  clause_workers().start(workers, replicas);
+  auto finish = [&](bool ok, SynthesizeError error) {
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      stop = true;
+    }
+    cv.notify_all();
+    ClauseWorkerPool::wait(workers);
+    if (!ok && out_error) *out_error = error;
+    return ok;
+  };
+
+  float running_peak = 0.f;
+  for (size_t i = 0; i < n; ++i) {
+    ClauseResult r;
+    {
+      std::unique_lock<std::mutex> lock(mu);
+      cv.wait(lock, [&] { return results[i].done; });
+      r = std::move(results[i]);
+    }
+    // A clause with nothing speakable (e.g. only symbols) is skipped; anything else fails the request.
+    if (!r.ok && r.error != SynthesizeError::kPhonemeIdsEmpty) return finish(false, r.error);
+    if (r.ok) {
+      running_peak = std::max(running_peak, r.peak);
+      ScratchScope scratch;
+      ArenaVector<int16_t> pcm(r.audio.size(), 0, scratch.allocator<int16_t>());
+      scale_to_pcm(r.audio.data(), r.audio.size(), running_peak, pcm.data());
+      {
+        std::lock_guard<std::mutex> state(state_mu);
+        record_scratch(scratch, mem);
+        mem.pcm_bytes = std::max(mem.pcm_bytes, pcm.capacity() * sizeof(int16_t));
+        rss.sample();
+        mem.rss_peak_delta = rss.peakDelta();
+      }
+      if (!on_chunk(pcm.data(), pcm.size(), sample_offset)) return finish(false, SynthesizeError::kCancelled);
+      sample_offset += pcm.size();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      delivered = i + 1;
+    }
+    cv.notify_all();
+  }
+  return finish(true, SynthesizeError::kNone);
+}
+
 }  // namespace
 
+void recordSynthesisMemory(const SynthesisMemoryReport& report) {
+  std::lock_guard<std::mutex> lock(g_memory_stats_mutex);
+  SynthesisMemoryStats& st = g_memory_stats;
+  ++st.requests;
+  st.last = report;
+  forEachMemoryField(st.max, report, [](auto& m, auto v) { if (v > m) m = v; });
+  forEachMemoryField(g_memory_sum, report, [](auto& sum, auto v) { sum += v; });
+  st.mean = g_memory_sum;
+  forEachMemoryField(st.mean, report, [&st](auto& m, auto) { m /= st.requests; });
+}
+
+SynthesisMemoryStats synthesisMemoryStats() {
+  std::lock_guard<std::mutex> lock(g_memory_stats_mutex);
+  return g_memory_stats;
+}
+
+void setSynthesisParallelism(size_t replicas) {
+  g_synthesis_parallelism.store(replicas == 0 ? defaultParallelism() : replicas);
+}
+
+size_t synthesisParallelism() {
+  return g_synthesis_parallelism.load();
+}
+
+std::vector<SynthesisSessionStats> synthesisSessionStats() {
+  std::vector<std::pair<std::string, std::shared_ptr<piper_ort::PiperOrtSessionPool>>> pools;
+  {
+    std::lock_guard<std::mutex> lock(g_session_mutex);
+    for (const CachedSession& c : g_cached_sessions) pools.emplace_back(c.model_path, c.pool);
+  }
+  std::vector<SynthesisSessionStats> out;
+  for (const auto& p : pools) {
+    const piper_ort::SessionPoolStats s = piper_ort::sessionPoolStats(p.second.get());
+    SynthesisSessionStats stats;
+    stats.model_path = p.first;
+    stats.replicas = s.replicas;
+    stats.shared_initializers = s.shared_initializers;
+    stats.shared_weight_bytes = s.shared_weight_bytes;
+    stats.first_replica_bytes = s.first_replica_bytes;
+    stats.replica_overhead_bytes = s.replica_overhead_bytes;
+    out.push_back(std::move(stats));
+  }
+  return out;
+}
+
+void setSilenceTrim(const SilenceTrimConfig& config) {
+  std::lock_guard<std::mutex> lock(g_silence_trim_mutex);
+  g_silence_trim = config;
+}
+
+SilenceTrimConfig silenceTrim() {
+  std::lock_guard<std::mutex> lock(g_silence_trim_mutex);
+  return g_silence_trim;
+}
+
+bool setAudioPack(const std::string& path, std::string* error) {
+  std::shared_ptr<AudioPack> pack;
+  if (!path.empty()) {
+    pack = std::make_shared<AudioPack>();
+    if (!pack->open(path, error)) return false;
+    std::fprintf(stderr, "[Piper] audio pack: %zu line(s) @ %d Hz from %s\n", pack->size(), pack->sampleRate(),
+                 path.c_str());
+  }
+  std::lock_guard<std::mutex> lock(g_audio_pack_mutex);
+  g_audio_pack = std::move(pack);
+  return true;
+}
+
+size_t audioPackSize() {
+  std::lock_guard<std::mutex> lock(g_audio_pack_mutex);
+  return g_audio_pack ? g_audio_pack->size() : 0;
+}
+
+void setPhonemeMemoCapacity(size_t words) {
+  g_phoneme_memo.setCapacity(words);
+}
+
+PhonemeMemoStats phonemeMemoStats() {
+  return g_phoneme_memo.stats();
+}
+
+void resetPhonemeMemoStats() {
+  g_phoneme_memo.resetStats();
+}
+
+bool setPhonemeMemoSeed(const std::string& pack_path, const std::string& voice, std::string* error) {
+  if (!g_phoneme_memo.setSeed(pack_path, voice, error)) return false;
+  if (!pack_path.empty()) {
+    std::fprintf(stderr, "[Piper] phoneme memo seed: %zu word(s) (%s) from %s\n",
+                 g_phoneme_memo.stats().seed_entries, voice.c_str(), pack_path.c_str());
+  }
+  return true;
+}
+
+void resetSynthesisMemoryStats() {
+  std::lock_guard<std::mutex> lock(g_memory_stats_mutex);
+  g_memory_stats = SynthesisMemoryStats{};
+  g_memory_sum = SynthesisMemoryReport{};
+}
+
 bool hasEspeak() {
 #ifdef PIPER_ENGINE_USE_ESPEAK
   return true;
@@ -150,6 +995,16 @@ bool hasEspeak() {
 #endif
 }
 
+bool voiceNeedsEspeak(const std::string& config_path) {
+  std::ifstream f(config_path);
+  if (!f) return true;
+  try {
+    return !is_text_voice(json::parse(f));
+  } catch (...) {
+    return true;
+  }
+}
+
 bool synthesize(const std::string& model_path,
                 const std::string& config_path,
                 const std::string& espeak_data_path,
@@ -157,9 +1012,15 @@ bool synthesize(const std::string& model_path,
                 std::vector<int16_t>& pcm_out,
                 int& sample_rate_out,
                 SynthesizeError* out_error,
-                const SynthesizeOverrides* overrides) {
+                const SynthesizeOverrides* overrides,
+                SynthesisMemoryReport* memory_out) {
   std::fprintf(stderr, "[Piper] synthesize: start\n");
   std::fflush(stderr);
+  SynthesisMemoryReport mem_local;
+  SynthesisMemoryReport& mem = memory_out ? *memory_out : mem_local;
+  mem = SynthesisMemoryReport{};
+  piper_mem::ResidentTracker rss;
+  mem.rss_start = rss.start();
   pcm_out.clear();
   sample_rate_out = 22050;
   auto set_err = [out_error](SynthesizeError e) { if (out_error) *out_error = e; };
@@ -169,128 +1030,149 @@ bool synthesize(const std::string& model_path,
     return false;
   }
 
-  // Load config
-  std::ifstream f(config_path);
-  if (!f) {
-    set_err(SynthesizeError::kConfigOpenFailed);
-    return false;
-  }
-  json config;
-  try {
-    config = json::parse(f);
-  } catch (...) {
-    set_err(SynthesizeError::kConfigParseFailed);
+  SynthesisContext ctx;
+  if (!load_context(model_path, config_path, overrides, ctx, out_error))
     return false;
-  }
   std::fprintf(stderr, "[Piper] synthesize: config loaded\n");
   std::fflush(stderr);
+  sample_rate_out = ctx.primary.sample_rate;
 
-  int sample_rate = 22050;
-  if (config.contains("audio") && config["audio"].contains("sample_rate"))
-    sample_rate = config["audio"]["sample_rate"].get<int>();
-  sample_rate_out = sample_rate;
-
-  // Recommended defaults: slightly slower, less warbly (length_scale=1.08, noise_scale=0.62, noise_w=0.8)
-  float noise_scale = 0.62f, length_scale = 1.08f, noise_w = 0.8f;
-  if (config.contains("inference")) {
-    auto& inf = config["inference"];
-    if (inf.contains("noise_scale")) noise_scale = inf["noise_scale"].get<float>();
-    if (inf.contains("length_scale")) length_scale = inf["length_scale"].get<float>();
-    if (inf.contains("noise_w")) noise_w = inf["noise_w"].get<float>();
-  }
-  if (overrides) {
-    if (overrides->noise_scale >= 0.f) noise_scale = overrides->noise_scale;
-    if (overrides->length_scale >= 0.f) length_scale = overrides->length_scale;
-    if (overrides->noise_w >= 0.f) noise_w = overrides->noise_w;
+  std::shared_ptr<AudioPack> pack;
+  const int16_t* pack_pcm = nullptr;
+  size_t pack_samples = 0;
+  if (find_in_audio_pack(ctx, text, overrides, pack, &pack_pcm, &pack_samples)) {
+    pcm_out.assign(pack_pcm, pack_pcm + pack_samples);
+    mem.pcm_bytes = pcm_out.capacity() * sizeof(int16_t);
+    std::fprintf(stderr, "[Piper] synthesize: audio pack hit (samples=%zu)\n", pack_samples);
+    std::fflush(stderr);
+    return true;
   }
 
-  std::string voice = "en-us";
-  if (config.contains("espeak") && config["espeak"].contains("voice"))
-    voice = config["espeak"]["voice"].get<std::string>();
+  piper_mem::OrtWindow ort_window;
+  piper_mem::OrtWindowScope ort_scope(&ort_window);
+  // Everything up to the int16 conversion is request scratch; only pcm_out is heap memory.
+  ScratchScope scratch;
+  ArenaVector<float> audio_float(scratch.allocator<float>());
+  const bool rendered = render_float(ctx, espeak_data_path, text, overrides, audio_float, mem, rss, out_error);
+  if (!rendered)
+    return false;
+  record_ort_window(ort_window, mem);
+  mem.float_audio_bytes = audio_float.capacity() * sizeof(float);
+  rss.sample();
+  mem.rss_peak_delta = rss.peakDelta();
 
-  auto id_map = parse_phoneme_id_map(config);
-  int64_t default_id = 3;
-  auto space_it = id_map.find(" ");
-  if (space_it != id_map.end() && !space_it->second.empty())
-    default_id = space_it->second[0];
+  trim_model_silence(audio_float, ctx.primary.sample_rate, kSilenceEdgeBoth, "synthesize");
+  pcm_out.resize(audio_float.size());
+  float_to_pcm(audio_float.data(), audio_float.size(), overrides, pcm_out.data());
+  record_scratch(scratch, mem);
+  mem.pcm_bytes = pcm_out.capacity() * sizeof(int16_t);
+  rss.sample();
+  mem.rss_peak_delta = rss.peakDelta();
+  return true;
+}
 
-  // Phonemize
-  std::fprintf(stderr, "[Piper] synthesize: phonemize start\n");
-  std::fflush(stderr);
-  std::string phonemes;
-#ifdef PIPER_ENGINE_USE_ESPEAK
-  if (!phonemize_espeak(text, voice, espeak_data_path, phonemes, out_error))
-    return false;
-  std::fprintf(stderr, "[Piper] synthesize: phonemize done\n");
-  std::fflush(stderr);
-#else
-  (void)voice;
-  (void)espeak_data_path;
-  set_err(SynthesizeError::kEspeakNotLinked);
-  return false;  // espeak not linked
-#endif
+bool synthesizeStreaming(const std::string& model_path,
+                         const std::string& config_path,
+                         const std::string& espeak_data_path,
+                         const std::string& text,
+                         const SynthesisChunkCallback& on_chunk,
+                         int& sample_rate_out,
+                         SynthesizeError* out_error,
+                         const SynthesizeOverrides* overrides,
+                         SynthesisMemoryReport* memory_out) {
+  SynthesisMemoryReport mem_local;
+  SynthesisMemoryReport& mem = memory_out ? *memory_out : mem_local;
+  mem = SynthesisMemoryReport{};
+  piper_mem::ResidentTracker rss;
+  mem.rss_start = rss.start();
+  sample_rate_out = 22050;
+  auto set_err = [out_error](SynthesizeError e) { if (out_error) *out_error = e; };
 
-  std::vector<int64_t> phoneme_ids = phonemes_to_ids(phonemes, id_map, default_id);
-  if (phoneme_ids.empty()) {
-    set_err(SynthesizeError::kPhonemeIdsEmpty);
+  if (model_path.empty() || config_path.empty() || text.empty() || !on_chunk) {
+    set_err(SynthesizeError::kInvalidArgs);
     return false;
   }
 
-  int64_t speaker_id = 0;
-  if (config.contains("num_speakers") && config["num_speakers"].get<int>() > 1)
-    speaker_id = 0;  // default speaker
+  SynthesisContext ctx;
+  if (!load_context(model_path, config_path, overrides, ctx, out_error))
+    return false;
+  sample_rate_out = ctx.primary.sample_rate;
 
-  // Run ONNX (cached session)
-  std::fprintf(stderr, "[Piper] synthesize: runInference start\n");
-  std::fflush(stderr);
-  piper_ort::PiperOrtSession* session = nullptr;
-  {
-    std::lock_guard<std::mutex> lock(g_session_mutex);
-    if (g_cached_model_path != model_path) {
-      if (g_cached_session) {
-        piper_ort::destroySession(g_cached_session);
-        g_cached_session = nullptr;
-      }
-      g_cached_model_path = model_path;
-    }
-    if (!g_cached_session) {
-      g_cached_session = piper_ort::createSession(model_path.c_str());
-      if (!g_cached_session) {
-        set_err(SynthesizeError::kOrtCreateSessionFailed);
-        return false;
-      }
+  // A canned line goes straight from the mapping to the callback as one chunk.
+  std::shared_ptr<AudioPack> pack;
+  const int16_t* pack_pcm = nullptr;
+  size_t pack_samples = 0;
+  if (find_in_audio_pack(ctx, text, overrides, pack, &pack_pcm, &pack_samples)) {
+    std::fprintf(stderr, "[Piper] synthesizeStreaming: audio pack hit (samples=%zu)\n", pack_samples);
+    std::fflush(stderr);
+    if (!on_chunk(pack_pcm, pack_samples, 0)) {
+      set_err(SynthesizeError::kCancelled);
+      return false;
     }
-    session = g_cached_session;
+    return true;
   }
 
-  std::vector<float> audio_float = piper_ort::runInference(
-      session, phoneme_ids, noise_scale, length_scale, noise_w, speaker_id);
-  std::fprintf(stderr, "[Piper] synthesize: runInference done (samples=%zu)\n", audio_float.size());
+  const std::vector<std::string> clauses = split_clauses(text);
+  std::fprintf(stderr, "[Piper] synthesizeStreaming: %zu clause(s)\n", clauses.size());
   std::fflush(stderr);
-  if (audio_float.empty()) {
-    set_err(SynthesizeError::kOrtRunInferenceFailed);
+  if (clauses.empty()) {
+    set_err(SynthesizeError::kPhonemeIdsEmpty);
     return false;
   }
 
-  // Gain (dB): multiply samples by 10^(gain_db/20) before peak normalization
-  float gain_linear = 1.f;
-  if (overrides && overrides->gain_db >= -100.f) {
-    gain_linear = std::pow(10.f, overrides->gain_db / 20.f);
-    for (float& v : audio_float) v *= gain_linear;
+  piper_mem::OrtWindow ort_window;
+  piper_mem::OrtWindowScope ort_scope(&ort_window);
+  size_t sample_offset = 0;
+  const size_t replicas = std::min(g_synthesis_parallelism.load(), clauses.size());
+  if (replicas > 1) {
+    std::fprintf(stderr, "[Piper] synthesizeStreaming: %zu clauses on %zu replicas\n", clauses.size(), replicas);
+    std::fflush(stderr);
+    const bool ok = stream_clauses_parallel(ctx, espeak_data_path, clauses, overrides, on_chunk, replicas, mem, rss,
+                                            sample_offset, out_error);
+    record_ort_window(ort_window, mem);
+    if (ok && sample_offset == 0) {
+      set_err(SynthesizeError::kPhonemeIdsEmpty);
+      return false;
+    }
+    return ok;
   }
 
-  // Scale and convert to int16 (same as Piper)
-  float max_val = 0.01f;
-  for (float v : audio_float) {
-    float a = std::fabs(v);
-    if (a > max_val) max_val = a;
+  // One clause of float audio and PCM is live at a time, in the thread's arena (reset per clause); the
+  // report records the largest.
+  float running_peak = 0.f;
+  for (size_t i = 0; i < clauses.size(); ++i) {
+    const std::string& clause = clauses[i];
+    ScratchScope scratch;
+    ArenaVector<float> audio_float(scratch.allocator<float>());
+    SynthesizeError clause_error = SynthesizeError::kNone;
+    if (!render_float(ctx, espeak_data_path, clause, overrides, audio_float, mem, rss, &clause_error)) {
+      // A clause with nothing speakable (e.g. only symbols) is skipped; anything else fails the request.
+      if (clause_error == SynthesizeError::kPhonemeIdsEmpty) continue;
+      set_err(clause_error);
+      record_ort_window(ort_window, mem);
+      return false;
+    }
+    mem.float_audio_bytes = std::max(mem.float_audio_bytes, audio_float.capacity() * sizeof(float));
+    trim_model_silence(audio_float, ctx.primary.sample_rate, clause_trim_edges(i, clauses.size()),
+                       "synthesizeStreaming");
+    running_peak = std::max(running_peak, apply_gain(audio_float.data(), audio_float.size(), overrides));
+    ArenaVector<int16_t> pcm(audio_float.size(), 0, scratch.allocator<int16_t>());
+    scale_to_pcm(audio_float.data(), audio_float.size(), running_peak, pcm.data());
+    record_scratch(scratch, mem);
+    mem.pcm_bytes = std::max(mem.pcm_bytes, pcm.capacity() * sizeof(int16_t));
+    rss.sample();
+    mem.rss_peak_delta = rss.peakDelta();
+    if (!on_chunk(pcm.data(), pcm.size(), sample_offset)) {
+      set_err(SynthesizeError::kCancelled);
+      record_ort_window(ort_window, mem);
+      return false;
+    }
+    sample_offset += pcm.size();
   }
-  float scale = kMaxWavValue / std::max(0.01f, max_val);
-  pcm_out.reserve(audio_float.size());
-  for (float v : audio_float) {
-    float s = v * scale;
-    s = std::max(-kMaxWavValue, std::min(kMaxWavValue, s));
-    pcm_out.push_back(static_cast<int16_t>(s));
+  record_ort_window(ort_window, mem);
+  if (sample_offset == 0) {
+    set_err(SynthesizeError::kPhonemeIdsEmpty);
+    return false;
   }
   return true;
 }
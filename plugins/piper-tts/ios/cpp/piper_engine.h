@@ -1,7 +1,11 @@
 #ifndef PIPER_ENGINE_H
 #define PIPER_ENGINE_H
 
+#include "phoneme_memo.h"
+#include "silence_trim.h"
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -10,6 +14,11 @@ namespace piper {
 // True if this build has espeak-ng phonemization (PIPER_ENGINE_USE_ESPEAK=1 at compile time).
 bool hasEspeak();
 
+// False for voices whose config has "phoneme_type": "text": their ids come straight from the text's
+// codepoints (text_codepoints.h), so they synthesize without espeak-ng data or an espeak build. True when the
+// config cannot be read (callers then keep requiring espeak data).
+bool voiceNeedsEspeak(const std::string& config_path);
+
 // Synthesis failure reason (when synthesize returns false). Pass optional out_error to get the code.
 enum class SynthesizeError {
   kNone = 0,
@@ -22,6 +31,7 @@ enum class SynthesizeError {
   kPhonemeIdsEmpty,
   kOrtCreateSessionFailed,
   kOrtRunInferenceFailed,
+  kCancelled,  // streaming: the chunk callback returned false
 };
 
 // Optional runtime overrides for inference and post-processing. Any field with value < 0 means "use config/default".
@@ -32,10 +42,79 @@ struct SynthesizeOverrides {
   float gain_db = -1.f;  // applied when converting float -> int16 (0 = no change)
 };
 
+// Per-request memory by stage (bytes). ORT figures come from the counting env allocator
+// (memory_accounting.h; 0 unless built with PIPER_ORT_ALLOC_STATS); resident figures are sampled at stage boundaries.
+struct SynthesisMemoryReport {
+  size_t phoneme_bytes = 0;       // espeak IPA string + phoneme id vector
+  size_t espeak_rss_delta = 0;    // resident growth across phonemization (espeak's own heap)
+  size_t ort_live_bytes = 0;      // ORT bytes live before Run (weights, prepacked buffers)
+  size_t ort_peak_bytes = 0;      // peak ORT bytes above ort_live_bytes during Run (intermediates + output)
+  uint64_t ort_alloc_count = 0;   // ORT allocations during Run
+  size_t float_audio_bytes = 0;   // copied float output
+  size_t pcm_bytes = 0;           // int16 output
+  size_t scratch_bytes = 0;       // request scratch arena (phonemes, ids, float audio; largest clause)
+  size_t scratch_block_mallocs = 0;  // heap blocks the arena had to take (0 once warm)
+  size_t output_bytes = 0;        // platform copy handed to Java/Obj-C; set by the caller
+  size_t rss_start = 0;
+  size_t rss_peak_delta = 0;      // max resident growth over the request
+};
+
+// Aggregate over recorded requests: per-field max and mean.
+struct SynthesisMemoryStats {
+  uint64_t requests = 0;
+  SynthesisMemoryReport last;
+  SynthesisMemoryReport max;
+  SynthesisMemoryReport mean;
+};
+
+// Add a finished request (after output_bytes is filled) to the process-wide aggregate.
+void recordSynthesisMemory(const SynthesisMemoryReport& report);
+SynthesisMemoryStats synthesisMemoryStats();
+void resetSynthesisMemoryStats();
+
+// Session replicas per model (default: half the cores, 1..4). synthesizeStreaming infers up to this many clauses
+// of one utterance concurrently, each on its own replica (ort_capi_adapter.h: replicas share prepacked weights);
+// concurrent synthesize() calls also spread across replicas. 0 restores the default.
+void setSynthesisParallelism(size_t replicas);
+size_t synthesisParallelism();
+
+// Session pool of each cached Piper model: the weight copy its replicas share and ORT bytes per replica.
+struct SynthesisSessionStats {
+  std::string model_path;
+  size_t replicas = 0;
+  size_t shared_initializers = 0;
+  size_t shared_weight_bytes = 0;
+  size_t first_replica_bytes = 0;
+  size_t replica_overhead_bytes = 0;  // mean over replicas after the first
+};
+std::vector<SynthesisSessionStats> synthesisSessionStats();
+
+// Model-silence trimming (silence_trim.h) applied to float output before int16 conversion: whole utterance for
+// synthesize, each clause for synthesizeStreaming. Enabled by default (edges only); process-wide, and from JS
+// through __piperSilenceTrimConfigure (silence_trim_jsi.h).
+void setSilenceTrim(const SilenceTrimConfig& config);
+SilenceTrimConfig silenceTrim();
+
+// Pre-rendered canned lines (audio_pack.h). synthesize / synthesizeStreaming return a pack entry instead of
+// synthesizing when the canonical text matches, the pack was rendered for this voice (config + model), and no
+// inference scale is overridden. Empty path unloads. False (pack unchanged) if the file is missing or invalid.
+bool setAudioPack(const std::string& path, std::string* error = nullptr);
+size_t audioPackSize();
+
+// Word-level memo beneath espeak (phoneme_memo.h), shared by every voice and request. Capacity is in words
+// (default 4096; 0 sends every text to espeak whole). The seed is a pack.bin whose "phonemes" section was
+// rendered with `voice`; empty path drops it. Stats count words since the last reset.
+void setPhonemeMemoCapacity(size_t words);
+PhonemeMemoStats phonemeMemoStats();
+void resetPhonemeMemoStats();
+bool setPhonemeMemoSeed(const std::string& pack_path, const std::string& voice = "en-us",
+                        std::string* error = nullptr);
+
 // Full pipeline: espeak-ng phonemize -> phoneme_id_map -> ONNX (C API) -> int16 PCM.
 // Pass espeak_data_path (directory containing espeak-ng data). Voice/session cached per (model_path, config_path).
 // If overrides != nullptr, non-negative fields override config/JSON values; gain_db is applied to output level.
 // Returns true on success; pcm_out and sample_rate_out set. On false, optional out_error gives the reason.
+// If memory_out != nullptr it receives the per-stage memory report (also filled on failure, up to the failing stage).
 bool synthesize(const std::string& model_path,
                 const std::string& config_path,
                 const std::string& espeak_data_path,
@@ -43,7 +122,30 @@ bool synthesize(const std::string& model_path,
                 std::vector<int16_t>& pcm_out,
                 int& sample_rate_out,
                 SynthesizeError* out_error = nullptr,
-                const SynthesizeOverrides* overrides = nullptr);
+                const SynthesizeOverrides* overrides = nullptr,
+                SynthesisMemoryReport* memory_out = nullptr);
+
+// Receives one clause of int16 PCM as soon as it is synthesized; sample_offset is the position of its first
+// sample within the utterance. Return false to stop (synthesizeStreaming then fails with kCancelled).
+using SynthesisChunkCallback = std::function<bool(const int16_t* pcm, size_t samples, size_t sample_offset)>;
+
+// Streaming variant of synthesize: splits text at clause boundaries (. ! ? ; : newline; never inside <lang>
+// tags) and hands each clause to on_chunk, on the calling thread, before synthesizing the next. Peak
+// normalization uses the running peak of the utterance so far, so a quiet clause keeps its level relative to
+// the louder ones before it, as in single-pass output (a clause louder than everything before it lowers the
+// gain from there on; earlier clauses cannot be rescaled). sample_rate_out is set before the first
+// callback. With synthesisParallelism() > 1, later clauses are inferred on other replicas while earlier ones
+// are delivered; on_chunk still sees them in order. In memory_out, float_audio_bytes / pcm_bytes /
+// phoneme_bytes are the largest single clause.
+bool synthesizeStreaming(const std::string& model_path,
+                         const std::string& config_path,
+                         const std::string& espeak_data_path,
+                         const std::string& text,
+                         const SynthesisChunkCallback& on_chunk,
+                         int& sample_rate_out,
+                         SynthesizeError* out_error = nullptr,
+                         const SynthesizeOverrides* overrides = nullptr,
+                         SynthesisMemoryReport* memory_out = nullptr);
 
 }  // namespace piper
 
@@ -0,0 +1,122 @@
+#include "query_cache_jsi.h"
+#include "semantic_query_cache.h"
+#include <jsi/jsi.h>
+#include <string>
+#include <utility>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+namespace {
+
+struct FloatView {
+  const float* data = nullptr;
+  size_t size = 0;
+};
+
+// Reads a Float32Array (or a bare ArrayBuffer of float32) without copying.
+FloatView readFloat32(jsi::Runtime& rt, const jsi::Value& value, const char* fn) {
+  if (!value.isObject()) throw jsi::JSError(rt, std::string(fn) + ": expected Float32Array");
+  jsi::Object obj = value.getObject(rt);
+  if (obj.isArrayBuffer(rt)) {
+    jsi::ArrayBuffer buffer = obj.getArrayBuffer(rt);
+    return {reinterpret_cast<const float*>(buffer.data(rt)), buffer.size(rt) / sizeof(float)};
+  }
+  jsi::Value buffer_value = obj.getProperty(rt, "buffer");
+  if (!buffer_value.isObject() || !buffer_value.getObject(rt).isArrayBuffer(rt)) {
+    throw jsi::JSError(rt, std::string(fn) + ": expected Float32Array");
+  }
+  jsi::ArrayBuffer buffer = buffer_value.getObject(rt).getArrayBuffer(rt);
+  const size_t offset = static_cast<size_t>(obj.getProperty(rt, "byteOffset").asNumber());
+  const size_t length = static_cast<size_t>(obj.getProperty(rt, "length").asNumber());
+  if (offset % sizeof(float) != 0 || offset + length * sizeof(float) > buffer.size(rt)) {
+    throw jsi::JSError(rt, std::string(fn) + ": Float32Array out of range");
+  }
+  return {reinterpret_cast<const float*>(buffer.data(rt) + offset), length};
+}
+
+}  // namespace
+
+void installQueryCacheJsi(jsi::Runtime& runtime) {
+  auto probe = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperQueryCacheProbe"), 2,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 2 || !args[0].isString()) {
+          throw jsi::JSError(rt, "__piperQueryCacheProbe(versionKey, query): expected string, Float32Array");
+        }
+        const FloatView q = readFloat32(rt, args[1], "__piperQueryCacheProbe");
+        QueryCacheHit hit;
+        if (!sharedQueryCache().probe(args[0].getString(rt).utf8(rt), q.data, q.size, &hit)) {
+          return jsi::Value::null();
+        }
+        jsi::Object result(rt);
+        result.setProperty(rt, "payload", jsi::String::createFromUtf8(rt, hit.payload));
+        result.setProperty(rt, "cosine", static_cast<double>(hit.cosine));
+        result.setProperty(rt, "costMs", hit.cost_ms);
+        return result;
+      });
+
+  auto insert = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperQueryCacheInsert"), 4,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 3 || !args[0].isString() || !args[2].isString()) {
+          throw jsi::JSError(rt,
+                             "__piperQueryCacheInsert(versionKey, query, payload, costMs?): expected string, "
+                             "Float32Array, string");
+        }
+        const FloatView q = readFloat32(rt, args[1], "__piperQueryCacheInsert");
+        const double cost_ms = count > 3 && args[3].isNumber() ? args[3].getNumber() : 0.0;
+        sharedQueryCache().insert(args[0].getString(rt).utf8(rt), q.data, q.size, args[2].getString(rt).utf8(rt),
+                                  cost_ms);
+        return jsi::Value::undefined();
+      });
+
+  auto configure = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperQueryCacheConfigure"), 1,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 1 || !args[0].isObject()) return jsi::Value::undefined();
+        jsi::Object obj = args[0].getObject(rt);
+        QueryCacheConfig config = sharedQueryCache().config();
+        jsi::Value min_cosine = obj.getProperty(rt, "minCosine");
+        if (min_cosine.isNumber()) config.min_cosine = static_cast<float>(min_cosine.getNumber());
+        jsi::Value capacity = obj.getProperty(rt, "capacity");
+        if (capacity.isNumber() && capacity.getNumber() >= 0) {
+          config.capacity = static_cast<size_t>(capacity.getNumber());
+        }
+        sharedQueryCache().configure(config);
+        return jsi::Value::undefined();
+      });
+
+  auto stats = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperQueryCacheStats"), 0,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value*, size_t) -> jsi::Value {
+        const QueryCacheStats s = sharedQueryCache().stats();
+        jsi::Object result(rt);
+        result.setProperty(rt, "probes", static_cast<double>(s.probes));
+        result.setProperty(rt, "hits", static_cast<double>(s.hits));
+        result.setProperty(rt, "hitRate", s.probes ? static_cast<double>(s.hits) / s.probes : 0.0);
+        result.setProperty(rt, "inserts", static_cast<double>(s.inserts));
+        result.setProperty(rt, "evictions", static_cast<double>(s.evictions));
+        result.setProperty(rt, "invalidations", static_cast<double>(s.invalidations));
+        result.setProperty(rt, "entries", static_cast<double>(s.entries));
+        result.setProperty(rt, "savedMs", s.saved_ms);
+        return result;
+      });
+
+  auto clear = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperQueryCacheClear"), 1,
+      [](jsi::Runtime&, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        sharedQueryCache().clear();
+        if (count > 0 && args[0].isBool() && args[0].getBool()) sharedQueryCache().resetStats();
+        return jsi::Value::undefined();
+      });
+
+  runtime.global().setProperty(runtime, "__piperQueryCacheProbe", std::move(probe));
+  runtime.global().setProperty(runtime, "__piperQueryCacheInsert", std::move(insert));
+  runtime.global().setProperty(runtime, "__piperQueryCacheConfigure", std::move(configure));
+  runtime.global().setProperty(runtime, "__piperQueryCacheStats", std::move(stats));
+  runtime.global().setProperty(runtime, "__piperQueryCacheClear", std::move(clear));
+}
+
+}  // namespace piper
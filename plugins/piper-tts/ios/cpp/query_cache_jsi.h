@@ -0,0 +1,22 @@
+#ifndef QUERY_CACHE_JSI_H
+#define QUERY_CACHE_JSI_H
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+}
+}  // namespace facebook
+
+namespace piper {
+
+// Install the semantic query cache host functions (process-wide sharedQueryCache(), synchronous on the JS thread):
+//   __piperQueryCacheProbe(versionKey, query: Float32Array) -> { payload, cosine, costMs } | null
+//   __piperQueryCacheInsert(versionKey, query: Float32Array, payload: string, costMs) -> undefined
+//   __piperQueryCacheConfigure({ minCosine?, capacity? }) -> undefined
+//   __piperQueryCacheStats() -> { probes, hits, hitRate, inserts, evictions, invalidations, entries, savedMs }
+//   __piperQueryCacheClear(resetStats?: boolean) -> undefined
+void installQueryCacheJsi(facebook::jsi::Runtime& runtime);
+
+}  // namespace piper
+
+#endif  // QUERY_CACHE_JSI_H
@@ -0,0 +1,112 @@
+#include "scratch_arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace piper {
+
+namespace {
+
+constexpr size_t kHeaderBytes = 2 * alignof(std::max_align_t);  // >= sizeof(Block), keeps data max-aligned
+
+thread_local int t_scope_depth = 0;
+
+char* alignUp(char* p, size_t align) {
+  const uintptr_t v = reinterpret_cast<uintptr_t>(p);
+  return reinterpret_cast<char*>((v + align - 1) & ~static_cast<uintptr_t>(align - 1));
+}
+
+}  // namespace
+
+ScratchArena::ScratchArena(size_t first_block_bytes, size_t retain_bytes)
+    : first_block_bytes_(std::max<size_t>(first_block_bytes, 1024)),
+      retain_bytes_(std::max(retain_bytes, first_block_bytes_)) {}
+
+ScratchArena::~ScratchArena() { freeBlocks(); }
+
+void ScratchArena::addBlock(size_t min_bytes) {
+  // Blocks grow geometrically so a long request takes O(log n) of them.
+  const size_t size = std::max({min_bytes, first_block_bytes_, stats_.capacity_bytes});
+  auto* block = static_cast<Block*>(::operator new(kHeaderBytes + size));
+  block->next = head_;
+  block->size = size;
+  head_ = block;
+  cursor_ = reinterpret_cast<char*>(block) + kHeaderBytes;
+  end_ = cursor_ + size;
+  last_ = nullptr;
+  stats_.capacity_bytes += size;
+  ++stats_.block_mallocs;
+}
+
+void ScratchArena::freeBlocks() {
+  while (head_) {
+    Block* next = head_->next;
+    ::operator delete(head_);
+    head_ = next;
+  }
+  cursor_ = end_ = last_ = nullptr;
+  stats_.capacity_bytes = 0;
+}
+
+void* ScratchArena::allocate(size_t bytes, size_t align) {
+  if (bytes == 0) bytes = 1;
+  char* p = cursor_ ? alignUp(cursor_, align) : nullptr;
+  if (!p || p > end_ || static_cast<size_t>(end_ - p) < bytes) {
+    addBlock(bytes + align);
+    p = alignUp(cursor_, align);
+  }
+  cursor_ = p + bytes;
+  last_ = p;
+  stats_.used_bytes += bytes;
+  ++stats_.allocations;
+  return p;
+}
+
+void ScratchArena::deallocate(void* p, size_t bytes) {
+  // Only the newest allocation can be given back (a short-lived buffer released before anything else was
+  // allocated); the rest stays until reset().
+  if (p && p == last_ && static_cast<char*>(p) + bytes == cursor_) {
+    cursor_ = last_;
+    last_ = nullptr;
+    stats_.used_bytes -= bytes;
+  }
+}
+
+void ScratchArena::reset() {
+  stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.used_bytes);
+  stats_.used_bytes = 0;
+  ++stats_.resets;
+  if (!head_) return;
+  // One block is kept. When the request spilled into several, they are replaced by one block covering all
+  // of them, so the next request of the same size fits without a heap call.
+  const size_t want = std::min(stats_.capacity_bytes, retain_bytes_);
+  if (head_->next || head_->size > retain_bytes_) {
+    freeBlocks();
+    addBlock(want);
+  }
+  cursor_ = reinterpret_cast<char*>(head_) + kHeaderBytes;
+  end_ = cursor_ + head_->size;
+  last_ = nullptr;
+}
+
+ScratchArena& threadScratchArena() {
+  thread_local ScratchArena arena;
+  return arena;
+}
+
+ScratchScope::ScratchScope()
+    : arena_(threadScratchArena()),
+      used_start_(arena_.stats().used_bytes),
+      block_mallocs_start_(arena_.stats().block_mallocs),
+      outermost_(t_scope_depth++ == 0) {}
+
+ScratchScope::~ScratchScope() {
+  --t_scope_depth;
+  if (outermost_) arena_.reset();
+}
+
+size_t ScratchScope::usedBytes() const { return arena_.stats().used_bytes - used_start_; }
+
+size_t ScratchScope::blockMallocs() const { return arena_.stats().block_mallocs - block_mallocs_start_; }
+
+}  // namespace piper
@@ -0,0 +1,118 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace piper {
+
+struct ScratchArenaStats {
+  size_t used_bytes = 0;      // handed out since the last reset
+  size_t peak_bytes = 0;      // largest used_bytes seen at a reset
+  size_t capacity_bytes = 0;  // blocks currently held
+  size_t allocations = 0;     // since construction
+  size_t block_mallocs = 0;   // heap blocks taken since construction
+  size_t resets = 0;
+};
+
+// Monotonic scratch memory for the temporaries of one synthesis request (phoneme strings, id vectors, float
+// audio). allocate() bumps a pointer through heap blocks; deallocate() only takes back the newest allocation
+// (a container growing at the top), everything else is dropped at reset(). reset() keeps one block sized to
+// what the request needed (up to retain_bytes), so a steady workload stops touching the heap after warm-up.
+// Not thread-safe; each thread has its own (threadScratchArena()).
+class ScratchArena {
+ public:
+  explicit ScratchArena(size_t first_block_bytes = 64 * 1024, size_t retain_bytes = 8 * 1024 * 1024);
+  ~ScratchArena();
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+
+  void* allocate(size_t bytes, size_t align);
+  void deallocate(void* p, size_t bytes);
+  void reset();
+  const ScratchArenaStats& stats() const { return stats_; }
+
+ private:
+  struct Block {
+    Block* next;
+    size_t size;
+  };
+  void addBlock(size_t min_bytes);
+  void freeBlocks();
+
+  Block* head_ = nullptr;  // current block; older ones follow
+  char* cursor_ = nullptr;
+  char* end_ = nullptr;
+  char* last_ = nullptr;  // start of the newest allocation
+  size_t first_block_bytes_;
+  size_t retain_bytes_;
+  ScratchArenaStats stats_;
+};
+
+// STL allocator over a ScratchArena. Bound explicitly so no container lands in an arena by accident.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit ArenaAllocator(ScratchArena& arena) noexcept : arena_(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T* p, size_t n) noexcept { arena_->deallocate(p, n * sizeof(T)); }
+  ScratchArena* arena() const noexcept { return arena_; }
+
+ private:
+  ScratchArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+  return a.arena() == b.arena();
+}
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+  return a.arena() != b.arena();
+}
+
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// The calling thread's arena (engine worker threads each get their own).
+ScratchArena& threadScratchArena();
+
+// One request (or streamed clause) on the thread's arena. The outermost scope resets the arena when it
+// ends, so nothing allocated from it may outlive the scope; nested scopes leave it to the outer one.
+class ScratchScope {
+ public:
+  ScratchScope();
+  ~ScratchScope();
+  ScratchScope(const ScratchScope&) = delete;
+  ScratchScope& operator=(const ScratchScope&) = delete;
+
+  ScratchArena& arena() const { return arena_; }
+  template <typename T = char>
+  ArenaAllocator<T> allocator() const {
+    return ArenaAllocator<T>(arena_);
+  }
+  // Bytes handed out by the arena so far in this scope, and heap blocks it had to take.
+  size_t usedBytes() const;
+  size_t blockMallocs() const;
+
+ private:
+  ScratchArena& arena_;
+  size_t used_start_;
+  size_t block_mallocs_start_;
+  bool outermost_;
+};
+
+}  // namespace piper
+
+#endif  // SCRATCH_ARENA_H
@@ -0,0 +1,161 @@
+#include "semantic_query_cache.h"
+#include "simd_f32.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace piper {
+
+namespace {
+
+float dot(const float* a, const float* b, size_t n) {
+  using namespace piper_simd;
+  f32x4 acc0 = set1(0.f), acc1 = set1(0.f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    acc0 = fmadd(acc0, load(a + i), load(b + i));
+    acc1 = fmadd(acc1, load(a + i + 4), load(b + i + 4));
+  }
+  for (; i + 4 <= n; i += 4) acc0 = fmadd(acc0, load(a + i), load(b + i));
+  float sum = hsum(add(acc0, acc1));
+  for (; i < n; ++i) sum += a[i] * b[i];
+  return sum;
+}
+
+// Unit-length copy of vec into dst; false for a zero or non-finite vector.
+bool normalizeInto(const float* vec, size_t dim, float* dst) {
+  const float norm_sq = dot(vec, vec, dim);
+  if (!(norm_sq > 0.f) || !std::isfinite(norm_sq)) return false;
+  const float inv = 1.f / std::sqrt(norm_sq);
+  for (size_t i = 0; i < dim; ++i) dst[i] = vec[i] * inv;
+  return true;
+}
+
+}  // namespace
+
+void SemanticQueryCache::configure(const QueryCacheConfig& config) {
+  std::lock_guard<std::mutex> lock(mu_);
+  config_ = config;
+  while (entries_.size() > config_.capacity) evictLruLocked();
+}
+
+QueryCacheConfig SemanticQueryCache::config() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return config_;
+}
+
+bool SemanticQueryCache::probe(const std::string& version_key, const float* vec, size_t dim,
+                               QueryCacheHit* hit_out) {
+  if (!vec || dim == 0) return false;
+  std::vector<float> query(dim);
+  if (!normalizeInto(vec, dim, query.data())) return false;
+
+  std::lock_guard<std::mutex> lock(mu_);
+  ++stats_.probes;
+  rescopeLocked(version_key, dim);
+  size_t best = entries_.size();
+  float best_cos = config_.min_cosine;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const float c = dot(query.data(), vectors_.data() + i * dim_, dim_);
+    if (c >= best_cos) {
+      best_cos = c;
+      best = i;
+    }
+  }
+  if (best == entries_.size()) return false;
+
+  Entry& e = entries_[best];
+  e.last_used = ++tick_;
+  ++stats_.hits;
+  stats_.saved_ms += e.cost_ms;
+  if (hit_out) {
+    hit_out->payload = e.payload;
+    hit_out->cosine = best_cos;
+    hit_out->cost_ms = e.cost_ms;
+  }
+  return true;
+}
+
+void SemanticQueryCache::insert(const std::string& version_key, const float* vec, size_t dim,
+                                std::string payload, double cost_ms) {
+  if (!vec || dim == 0) return;
+  std::vector<float> unit(dim);
+  if (!normalizeInto(vec, dim, unit.data())) return;
+
+  std::lock_guard<std::mutex> lock(mu_);
+  if (config_.capacity == 0) return;
+  rescopeLocked(version_key, dim);
+
+  // A near-duplicate already stored is refreshed in place rather than duplicated.
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (dot(unit.data(), vectors_.data() + i * dim_, dim_) >= config_.min_cosine) {
+      std::copy(unit.begin(), unit.end(), vectors_.begin() + static_cast<std::ptrdiff_t>(i * dim_));
+      entries_[i].payload = std::move(payload);
+      entries_[i].cost_ms = cost_ms;
+      entries_[i].last_used = ++tick_;
+      ++stats_.inserts;
+      return;
+    }
+  }
+
+  if (entries_.size() >= config_.capacity) evictLruLocked();
+  vectors_.insert(vectors_.end(), unit.begin(), unit.end());
+  Entry e;
+  e.payload = std::move(payload);
+  e.cost_ms = cost_ms;
+  e.last_used = ++tick_;
+  entries_.push_back(std::move(e));
+  ++stats_.inserts;
+}
+
+void SemanticQueryCache::clear() {
+  std::lock_guard<std::mutex> lock(mu_);
+  entries_.clear();
+  vectors_.clear();
+}
+
+QueryCacheStats SemanticQueryCache::stats() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  QueryCacheStats s = stats_;
+  s.entries = entries_.size();
+  return s;
+}
+
+void SemanticQueryCache::resetStats() {
+  std::lock_guard<std::mutex> lock(mu_);
+  stats_ = QueryCacheStats{};
+}
+
+void SemanticQueryCache::rescopeLocked(const std::string& version_key, size_t dim) {
+  if (version_key == version_key_ && dim == dim_) return;
+  if (!entries_.empty()) ++stats_.invalidations;
+  entries_.clear();
+  vectors_.clear();
+  version_key_ = version_key;
+  dim_ = dim;
+}
+
+void SemanticQueryCache::evictLruLocked() {
+  if (entries_.empty()) return;
+  size_t victim = 0;
+  for (size_t i = 1; i < entries_.size(); ++i) {
+    if (entries_[i].last_used < entries_[victim].last_used) victim = i;
+  }
+  // Swap-remove keeps vectors_ contiguous.
+  const size_t last = entries_.size() - 1;
+  if (victim != last) {
+    entries_[victim] = std::move(entries_[last]);
+    std::copy(vectors_.begin() + static_cast<std::ptrdiff_t>(last * dim_), vectors_.end(),
+              vectors_.begin() + static_cast<std::ptrdiff_t>(victim * dim_));
+  }
+  entries_.pop_back();
+  vectors_.resize(entries_.size() * dim_);
+  ++stats_.evictions;
+}
+
+SemanticQueryCache& sharedQueryCache() {
+  static SemanticQueryCache cache;
+  return cache;
+}
+
+}  // namespace piper
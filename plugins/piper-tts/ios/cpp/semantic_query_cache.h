@@ -0,0 +1,84 @@
+#ifndef SEMANTIC_QUERY_CACHE_H
+#define SEMANTIC_QUERY_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace piper {
+
+// Recent query embeddings -> retrieval result (opaque payload, e.g. the serialized top-k chunks).
+// A probe hits when the best stored query is within min_cosine of the new one. Entries are scoped to a
+// version key (pack identity + embed model); a different key or embedding dim drops everything.
+
+struct QueryCacheConfig {
+  float min_cosine = 0.95f;
+  size_t capacity = 64;
+};
+
+struct QueryCacheStats {
+  uint64_t probes = 0;
+  uint64_t hits = 0;
+  uint64_t inserts = 0;
+  uint64_t evictions = 0;
+  uint64_t invalidations = 0;
+  size_t entries = 0;
+  // Sum of the recorded miss-path cost (ms) of every entry that served a hit.
+  double saved_ms = 0.0;
+};
+
+struct QueryCacheHit {
+  std::string payload;
+  float cosine = 0.f;
+  double cost_ms = 0.0;
+};
+
+class SemanticQueryCache {
+ public:
+  SemanticQueryCache() = default;
+  SemanticQueryCache(const SemanticQueryCache&) = delete;
+  SemanticQueryCache& operator=(const SemanticQueryCache&) = delete;
+
+  // Capacity shrink evicts least recently used entries.
+  void configure(const QueryCacheConfig& config);
+  QueryCacheConfig config() const;
+
+  // Best match at or above min_cosine under version_key. The vector need not be normalized.
+  bool probe(const std::string& version_key, const float* vec, size_t dim, QueryCacheHit* hit_out);
+
+  // cost_ms: what the miss path (search + chunk load) took; credited to saved_ms on later hits.
+  void insert(const std::string& version_key, const float* vec, size_t dim, std::string payload, double cost_ms);
+
+  void clear();
+  QueryCacheStats stats() const;
+  void resetStats();
+
+ private:
+  struct Entry {
+    std::string payload;
+    double cost_ms = 0.0;
+    uint64_t last_used = 0;
+  };
+
+  // Requires mu_. Drops all entries when the version key or dim changes.
+  void rescopeLocked(const std::string& version_key, size_t dim);
+  void evictLruLocked();
+
+  mutable std::mutex mu_;
+  QueryCacheConfig config_;
+  std::string version_key_;
+  size_t dim_ = 0;
+  std::vector<float> vectors_;  // entries_.size() x dim_, unit length
+  std::vector<Entry> entries_;
+  uint64_t tick_ = 0;
+  QueryCacheStats stats_;
+};
+
+// Process-wide cache used by the JSI bindings.
+SemanticQueryCache& sharedQueryCache();
+
+}  // namespace piper
+
+#endif  // SEMANTIC_QUERY_CACHE_H
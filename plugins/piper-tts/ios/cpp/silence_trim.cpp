@@ -0,0 +1,116 @@
+#include "silence_trim.h"
+#include "simd_f32.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace piper {
+
+namespace {
+
+constexpr int kJoinFadeMs = 2;
+
+// Sum of squares of n samples, 4 lanes at a time.
+float sumSquares(const float* x, size_t n) {
+  using namespace piper_simd;
+  f32x4 acc0 = set1(0.f);
+  f32x4 acc1 = set1(0.f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const f32x4 a = load(x + i);
+    const f32x4 b = load(x + i + 4);
+    acc0 = fmadd(acc0, a, a);
+    acc1 = fmadd(acc1, b, b);
+  }
+  float sum = hsum(add(acc0, acc1));
+  for (; i < n; ++i) sum += x[i] * x[i];
+  return sum;
+}
+
+}  // namespace
+
+SilenceTrimStats trimSilence(std::vector<float>& audio, int sample_rate, const SilenceTrimConfig& config,
+                             unsigned edges) {
+  const SilenceTrimStats stats = trimSilence(audio.data(), audio.size(), sample_rate, config, edges);
+  audio.resize(audio.size() - stats.removed());
+  return stats;
+}
+
+SilenceTrimStats trimSilence(float* audio, size_t n, int sample_rate, const SilenceTrimConfig& config,
+                             unsigned edges) {
+  SilenceTrimStats stats;
+  if (!config.enabled || n == 0 || sample_rate <= 0) return stats;
+  const size_t win = std::max<size_t>(1, static_cast<size_t>(sample_rate) * std::max(1, config.window_ms) / 1000);
+  const size_t windows = (n + win - 1) / win;
+
+  std::vector<float> energy(windows);
+  float peak = 0.f;
+  for (size_t w = 0; w < windows; ++w) {
+    const size_t begin = w * win;
+    const size_t len = std::min(win, n - begin);
+    energy[w] = sumSquares(audio + begin, len) / static_cast<float>(len);
+    peak = std::max(peak, energy[w]);
+  }
+  if (!(peak > 0.f)) return stats;
+  const float threshold = peak * std::pow(10.f, config.threshold_db / 10.f);
+  size_t first = windows;
+  size_t last = 0;
+  for (size_t w = 0; w < windows; ++w) {
+    if (energy[w] < threshold) continue;
+    if (first == windows) first = w;
+    last = w;
+  }
+  if (first == windows) return stats;
+
+  // Ranges of audio to keep, in order.
+  const size_t keep = static_cast<size_t>(sample_rate) * std::max(0, config.edge_keep_ms) / 1000;
+  const size_t max_gap = static_cast<size_t>(sample_rate) * std::max(0, config.max_gap_ms) / 1000;
+  std::vector<std::pair<size_t, size_t>> ranges;
+  size_t start = (edges & kSilenceEdgeLead) && first * win > keep ? first * win - keep : 0;
+  const size_t end = (edges & kSilenceEdgeTail) ? std::min(n, (last + 1) * win + keep) : n;
+  stats.lead_samples = start;
+  stats.tail_samples = n - end;
+  if (max_gap > 0) {
+    for (size_t w = first + 1; w < last;) {
+      if (energy[w] >= threshold) {
+        ++w;
+        continue;
+      }
+      size_t run_end = w;
+      while (run_end < last && energy[run_end] < threshold) ++run_end;
+      const size_t gap_begin = w * win;
+      const size_t gap_end = run_end * win;
+      if (gap_end - gap_begin > max_gap) {
+        ranges.emplace_back(start, gap_begin + max_gap / 2);
+        start = gap_end - (max_gap - max_gap / 2);
+        stats.gap_samples += start - (gap_begin + max_gap / 2);
+        ++stats.gaps;
+      }
+      w = run_end;
+    }
+  }
+  ranges.emplace_back(start, end);
+  if (stats.removed() == 0) return stats;
+
+  // Compact in place; ranges only move left. Joins get a short fade-out / fade-in (both sides are below
+  // the silence threshold, so this only hides the step).
+  const size_t fade = std::max<size_t>(1, static_cast<size_t>(sample_rate) * kJoinFadeMs / 1000);
+  size_t out = 0;
+  for (size_t r = 0; r < ranges.size(); ++r) {
+    const size_t len = ranges[r].second - ranges[r].first;
+    if (out != ranges[r].first) std::memmove(audio + out, audio + ranges[r].first, len * sizeof(float));
+    if (r > 0) {
+      const size_t f_in = std::min(fade, len);
+      for (size_t i = 0; i < f_in; ++i) audio[out + i] *= static_cast<float>(i) / f_in;
+    }
+    if (r + 1 < ranges.size()) {
+      const size_t f_out = std::min(fade, len);
+      for (size_t i = 0; i < f_out; ++i) audio[out + len - 1 - i] *= static_cast<float>(i) / f_out;
+    }
+    out += len;
+  }
+  return stats;
+}
+
+}  // namespace piper
@@ -0,0 +1,53 @@
+#ifndef SILENCE_TRIM_H
+#define SILENCE_TRIM_H
+
+#include <cstddef>
+#include <vector>
+
+namespace piper {
+
+// Energy-based removal of model-generated silence from float VITS output, before int16 conversion.
+// The clip is cut into window_ms windows; a window is silent when its mean square is more than
+// threshold_db below the loudest window of the clip (so the test is independent of output level, which
+// float_to_pcm normalizes anyway). Leading and trailing silent windows are dropped, keeping edge_keep_ms
+// next to speech for onsets and decays, so the platform lead silence (renderLeadSilenceMs) and inter-clause
+// pads come out as configured. Interior silence is left alone by default: it holds the model's sentence
+// and paragraph pauses, which no platform puts back (Android interSentenceSilenceMs defaults to 0). With
+// max_gap_ms > 0, interior silent runs longer than that are shortened to it (half kept on each side,
+// short fades at the join).
+struct SilenceTrimConfig {
+  bool enabled = true;
+  float threshold_db = -45.f;
+  int window_ms = 10;
+  int edge_keep_ms = 20;
+  int max_gap_ms = 0;  // 0 = leave interior silence alone
+};
+
+// Clip edges trimSilence may cut. A streamed utterance trims only the lead of its first clause and the tail
+// of its last: the edges in between hold the pauses between its sentences.
+enum SilenceEdges : unsigned {
+  kSilenceEdgeNone = 0,
+  kSilenceEdgeLead = 1,
+  kSilenceEdgeTail = 2,
+  kSilenceEdgeBoth = kSilenceEdgeLead | kSilenceEdgeTail,
+};
+
+// Samples removed by one trimSilence call.
+struct SilenceTrimStats {
+  size_t lead_samples = 0;
+  size_t tail_samples = 0;
+  size_t gap_samples = 0;
+  size_t gaps = 0;
+  size_t removed() const { return lead_samples + tail_samples + gap_samples; }
+};
+
+// Trims audio in place. A clip with no window above the threshold (all silence) is left unchanged.
+SilenceTrimStats trimSilence(std::vector<float>& audio, int sample_rate, const SilenceTrimConfig& config,
+                             unsigned edges = kSilenceEdgeBoth);
+// Same on a caller-owned buffer: the kept samples are moved to the front, audio[0, n - removed()).
+SilenceTrimStats trimSilence(float* audio, size_t n, int sample_rate, const SilenceTrimConfig& config,
+                             unsigned edges = kSilenceEdgeBoth);
+
+}  // namespace piper
+
+#endif  // SILENCE_TRIM_H
@@ -0,0 +1,41 @@
+#include "silence_trim_jsi.h"
+#include "piper_engine.h"
+#include <jsi/jsi.h>
+#include <utility>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+void installSilenceTrimJsi(jsi::Runtime& runtime) {
+  auto configure = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperSilenceTrimConfigure"), 1,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        SilenceTrimConfig config = silenceTrim();
+        if (count > 0 && args[0].isObject()) {
+          jsi::Object o = args[0].getObject(rt);
+          jsi::Value enabled = o.getProperty(rt, "enabled");
+          if (enabled.isBool()) config.enabled = enabled.getBool();
+          jsi::Value threshold = o.getProperty(rt, "thresholdDb");
+          if (threshold.isNumber()) config.threshold_db = static_cast<float>(threshold.getNumber());
+          jsi::Value window = o.getProperty(rt, "windowMs");
+          if (window.isNumber() && window.getNumber() >= 1) config.window_ms = static_cast<int>(window.getNumber());
+          jsi::Value edge = o.getProperty(rt, "edgeKeepMs");
+          if (edge.isNumber() && edge.getNumber() >= 0) config.edge_keep_ms = static_cast<int>(edge.getNumber());
+          jsi::Value gap = o.getProperty(rt, "maxGapMs");
+          if (gap.isNumber() && gap.getNumber() >= 0) config.max_gap_ms = static_cast<int>(gap.getNumber());
+          setSilenceTrim(config);
+        }
+        jsi::Object result(rt);
+        result.setProperty(rt, "enabled", config.enabled);
+        result.setProperty(rt, "thresholdDb", static_cast<double>(config.threshold_db));
+        result.setProperty(rt, "windowMs", config.window_ms);
+        result.setProperty(rt, "edgeKeepMs", config.edge_keep_ms);
+        result.setProperty(rt, "maxGapMs", config.max_gap_ms);
+        return result;
+      });
+
+  runtime.global().setProperty(runtime, "__piperSilenceTrimConfigure", std::move(configure));
+}
+
+}  // namespace piper
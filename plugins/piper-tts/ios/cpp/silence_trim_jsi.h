@@ -0,0 +1,19 @@
+#ifndef SILENCE_TRIM_JSI_H
+#define SILENCE_TRIM_JSI_H
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+}
+}  // namespace facebook
+
+namespace piper {
+
+// Install the model-silence trimming host function (process-wide setSilenceTrim in piper_engine.h):
+//   __piperSilenceTrimConfigure({ enabled?, thresholdDb?, windowMs?, edgeKeepMs?, maxGapMs? }?)
+//       -> { enabled, thresholdDb, windowMs, edgeKeepMs, maxGapMs } (settings now in effect)
+void installSilenceTrimJsi(facebook::jsi::Runtime& runtime);
+
+}  // namespace piper
+
+#endif  // SILENCE_TRIM_JSI_H
@@ -0,0 +1,86 @@
+#ifndef SIMD_F32_H
+#define SIMD_F32_H
+
+// Minimal 4-lane float vector used by the DSP paths (FFT, log-mel, audio post-processing).
+// NEON on arm64/armv7 (iOS, Android), SSE2 on x86/x86_64 (simulators, Linux host tools),
+// scalar fallback elsewhere. Header-only; all loads/stores are unaligned.
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIPER_SIMD_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIPER_SIMD_SSE2 1
+#endif
+
+namespace piper_simd {
+
+#if PIPER_SIMD_NEON
+using f32x4 = float32x4_t;
+inline f32x4 load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, f32x4 v) { vst1q_f32(p, v); }
+inline f32x4 set1(float x) { return vdupq_n_f32(x); }
+inline f32x4 add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+inline f32x4 sub(f32x4 a, f32x4 b) { return vsubq_f32(a, b); }
+inline f32x4 mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+inline f32x4 max(f32x4 a, f32x4 b) { return vmaxq_f32(a, b); }
+inline f32x4 min(f32x4 a, f32x4 b) { return vminq_f32(a, b); }
+// a + b * c
+inline f32x4 fmadd(f32x4 a, f32x4 b, f32x4 c) { return vmlaq_f32(a, b, c); }
+// a - b * c
+inline f32x4 fmsub(f32x4 a, f32x4 b, f32x4 c) { return vmlsq_f32(a, b, c); }
+inline float hsum(f32x4 v) {
+#if defined(__aarch64__)
+  return vaddvq_f32(v);
+#else
+  float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+#elif PIPER_SIMD_SSE2
+using f32x4 = __m128;
+inline f32x4 load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, f32x4 v) { _mm_storeu_ps(p, v); }
+inline f32x4 set1(float x) { return _mm_set1_ps(x); }
+inline f32x4 add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+inline f32x4 sub(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+inline f32x4 mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+inline f32x4 max(f32x4 a, f32x4 b) { return _mm_max_ps(a, b); }
+inline f32x4 min(f32x4 a, f32x4 b) { return _mm_min_ps(a, b); }
+inline f32x4 fmadd(f32x4 a, f32x4 b, f32x4 c) { return _mm_add_ps(a, _mm_mul_ps(b, c)); }
+inline f32x4 fmsub(f32x4 a, f32x4 b, f32x4 c) { return _mm_sub_ps(a, _mm_mul_ps(b, c)); }
+inline float hsum(f32x4 v) {
+  __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(v, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+#else
+struct f32x4 {
+  float v[4];
+};
+inline f32x4 load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float* p, f32x4 a) {
+  for (int i = 0; i < 4; i++) p[i] = a.v[i];
+}
+inline f32x4 set1(float x) { return {{x, x, x, x}}; }
+#define PIPER_SIMD_LANEWISE(name, expr)              \
+  inline f32x4 name(f32x4 a, f32x4 b) {              \
+    f32x4 r;                                         \
+    for (int i = 0; i < 4; i++) r.v[i] = (expr);     \
+    return r;                                        \
+  }
+PIPER_SIMD_LANEWISE(add, a.v[i] + b.v[i])
+PIPER_SIMD_LANEWISE(sub, a.v[i] - b.v[i])
+PIPER_SIMD_LANEWISE(mul, a.v[i] * b.v[i])
+PIPER_SIMD_LANEWISE(max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+PIPER_SIMD_LANEWISE(min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+#undef PIPER_SIMD_LANEWISE
+inline f32x4 fmadd(f32x4 a, f32x4 b, f32x4 c) { return add(a, mul(b, c)); }
+inline f32x4 fmsub(f32x4 a, f32x4 b, f32x4 c) { return sub(a, mul(b, c)); }
+inline float hsum(f32x4 a) { return a.v[0] + a.v[1] + a.v[2] + a.v[3]; }
+#endif
+
+}  // namespace piper_simd
+
+#endif  // SIMD_F32_H
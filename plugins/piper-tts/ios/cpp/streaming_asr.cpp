@@ -0,0 +1,532 @@
+#include "streaming_asr.h"
+#include "json.hpp"
+#include "ort_env.h"
+#include <onnxruntime_c_api.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using json = nlohmann::json;
+
+namespace piper {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Largest token id accepted from tokens.txt (CTC vocabularies are a few thousand); bounds the table a
+// corrupt file can make load() allocate.
+constexpr size_t kMaxTokenId = (1u << 20) - 1;
+
+double secondsSince(Clock::time_point t0) {
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Tokens that never appear in the transcript.
+bool isSpecialToken(const std::string& t) {
+  return t.empty() || t == "<blk>" || t == "<blank>" || t == "<pad>" || t == "<unk>" || t == "<s>" ||
+         t == "</s>" || t == "<sos/eos>" || t == "<eps>";
+}
+
+// Collapse whitespace runs and trim (word-delimiter tokens can produce doubles).
+std::string normalizeSpaces(const std::string& s) {
+  std::string out;
+  out.reserve(s.size());
+  bool space = true;
+  for (char c : s) {
+    if (c == ' ') {
+      if (!space) out.push_back(' ');
+      space = true;
+    } else {
+      out.push_back(c);
+      space = false;
+    }
+  }
+  if (!out.empty() && out.back() == ' ') out.pop_back();
+  return out;
+}
+
+}  // namespace
+
+const char* asrErrorToString(AsrError error) {
+  switch (error) {
+    case AsrError::kNone: return "none";
+    case AsrError::kInvalidArgs: return "invalid args";
+    case AsrError::kConfigOpenFailed: return "ASR config could not be opened";
+    case AsrError::kConfigParseFailed: return "ASR config parse failed";
+    case AsrError::kTokensLoadFailed: return "tokens file load failed";
+    case AsrError::kOrtCreateSessionFailed: return "ORT create session failed";
+    case AsrError::kOrtRunInferenceFailed: return "ORT run failed";
+    case AsrError::kUnexpectedOutput: return "unexpected model output";
+    case AsrError::kNotLoaded: return "recognizer not loaded";
+  }
+  return "unknown";
+}
+
+struct StreamingRecognizer::Impl {
+  const OrtApi* api = nullptr;
+  OrtSession* session = nullptr;
+  OrtSessionOptions* options = nullptr;
+  OrtMemoryInfo* memory_info = nullptr;
+  std::string feature_input;
+  std::string length_input;  // empty when the graph has no length input
+  bool length_int32 = false;  // int32 length input (default int64)
+  std::string logits_output;
+
+  LogMelConfig mel;
+  bool per_feature_norm = false;
+  bool channels_first = true;
+  size_t chunk_frames = 100;
+  size_t left_context = 200;
+  size_t right_context = 0;
+  int64_t blank_id = 0;
+  std::vector<std::string> tokens;
+
+  std::unique_ptr<LogMelExtractor> extractor;
+  std::vector<float> feats;   // rows [feat_base, total_frames) x n_mels
+  size_t feat_base = 0;
+  size_t total_frames = 0;
+  size_t decoded_end = 0;
+  int64_t prev_token = 0;
+  std::vector<double> stat_sum;
+  std::vector<double> stat_sumsq;
+  size_t stat_count = 0;
+
+  std::vector<float> pcm_scratch;
+  std::vector<float> input_scratch;
+  std::string raw_text;
+
+  ~Impl() {
+    if (!api) return;
+    if (session) api->ReleaseSession(session);
+    if (options) api->ReleaseSessionOptions(options);
+    if (memory_info) api->ReleaseMemoryInfo(memory_info);
+  }
+
+  void resetStream() {
+    if (extractor) extractor->reset();
+    feats.clear();
+    feat_base = total_frames = decoded_end = 0;
+    prev_token = blank_id;
+    std::fill(stat_sum.begin(), stat_sum.end(), 0.0);
+    std::fill(stat_sumsq.begin(), stat_sumsq.end(), 0.0);
+    stat_count = 0;
+    raw_text.clear();
+  }
+
+  // Pull finished feature rows from the extractor and fold them into the running stats.
+  void collectFrames() {
+    const size_t before = feats.size();
+    const size_t added = extractor->takeFrames(feats);
+    if (!added) return;
+    total_frames += added;
+    if (!per_feature_norm) return;
+    const size_t n_mels = static_cast<size_t>(mel.n_mels);
+    for (size_t r = 0; r < added; r++) {
+      const float* row = feats.data() + before + r * n_mels;
+      for (size_t m = 0; m < n_mels; m++) {
+        stat_sum[m] += row[m];
+        stat_sumsq[m] += static_cast<double>(row[m]) * row[m];
+      }
+    }
+    stat_count += added;
+  }
+};
+
+StreamingRecognizer::StreamingRecognizer() : impl_(new Impl()) {}
+StreamingRecognizer::~StreamingRecognizer() = default;
+
+bool StreamingRecognizer::loaded() const { return impl_ && impl_->session; }
+
+int StreamingRecognizer::sampleRate() const { return impl_->mel.sample_rate; }
+
+bool StreamingRecognizer::load(const std::string& model_path,
+                               const std::string& tokens_path,
+                               const std::string& config_path,
+                               AsrError* out_error) {
+  auto setErr = [out_error](AsrError e) {
+    if (out_error) *out_error = e;
+  };
+  setErr(AsrError::kNone);
+  if (model_path.empty() || tokens_path.empty() || config_path.empty()) {
+    setErr(AsrError::kInvalidArgs);
+    return false;
+  }
+  impl_.reset(new Impl());
+  model_path_.clear();
+  text_.clear();
+  stats_ = AsrStats{};
+  Impl& im = *impl_;
+
+  std::ifstream cf(config_path);
+  if (!cf) {
+    setErr(AsrError::kConfigOpenFailed);
+    return false;
+  }
+  json config;
+  try {
+    config = json::parse(cf);
+  } catch (...) {
+    setErr(AsrError::kConfigParseFailed);
+    return false;
+  }
+  im.mel.sample_rate = config.value("sample_rate", im.mel.sample_rate);
+  im.mel.n_fft = config.value("n_fft", im.mel.n_fft);
+  im.mel.win_length = config.value("win_length", im.mel.win_length);
+  im.mel.hop_length = config.value("hop_length", im.mel.hop_length);
+  im.mel.n_mels = config.value("n_mels", im.mel.n_mels);
+  im.mel.f_min = config.value("f_min", im.mel.f_min);
+  im.mel.f_max = config.value("f_max", im.mel.f_max);
+  im.mel.preemphasis = config.value("preemphasis", im.mel.preemphasis);
+  im.mel.remove_dc = config.value("remove_dc", im.mel.remove_dc);
+  im.mel.povey_window = config.value("window", std::string("hann")) == "povey";
+  im.mel.slaney_mel = config.value("mel_scale", std::string("htk")) == "slaney";
+  im.mel.log_floor = config.value("log_floor", im.mel.log_floor);
+  im.per_feature_norm = config.value("normalize", std::string("none")) == "per_feature";
+  im.channels_first = config.value("feature_layout", std::string("channels_first")) != "channels_last";
+  im.chunk_frames = static_cast<size_t>(std::max(1, config.value("chunk_frames", 100)));
+  im.left_context = static_cast<size_t>(std::max(0, config.value("left_context_frames", 200)));
+  im.right_context = static_cast<size_t>(std::max(0, config.value("right_context_frames", 0)));
+  im.blank_id = config.value("blank_id", static_cast<int64_t>(0));
+  if (im.mel.n_mels <= 0 || im.mel.hop_length <= 0 || im.mel.win_length <= 0) {
+    setErr(AsrError::kConfigParseFailed);
+    return false;
+  }
+
+  // tokens.txt: "<token> <id>" (sherpa/k2 style) or one token per line (id = line number).
+  std::ifstream tf(tokens_path);
+  if (!tf) {
+    setErr(AsrError::kTokensLoadFailed);
+    return false;
+  }
+  std::string line;
+  size_t line_no = 0;
+  while (std::getline(tf, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    std::string tok = line;
+    size_t id = line_no++;
+    const size_t sp = line.find_last_of(" \t");
+    if (sp != std::string::npos && sp + 1 < line.size() &&
+        line.find_first_not_of("0123456789", sp + 1) == std::string::npos) {
+      tok = line.substr(0, sp);
+      // Digits only; more than 7 cannot be under kMaxTokenId (and cannot overflow below).
+      if (line.size() - (sp + 1) > 7) {
+        setErr(AsrError::kTokensLoadFailed);
+        return false;
+      }
+      id = 0;
+      for (size_t i = sp + 1; i < line.size(); i++) id = id * 10 + static_cast<size_t>(line[i] - '0');
+    }
+    if (id > kMaxTokenId) {
+      setErr(AsrError::kTokensLoadFailed);
+      return false;
+    }
+    if (im.tokens.size() <= id) im.tokens.resize(id + 1);
+    im.tokens[id] = tok;
+  }
+  if (im.tokens.empty()) {
+    setErr(AsrError::kTokensLoadFailed);
+    return false;
+  }
+
+  im.api = piper_ort::getApi();
+  OrtEnv* env = piper_ort::sharedEnv();
+  if (!im.api || !env) {
+    setErr(AsrError::kOrtCreateSessionFailed);
+    return false;
+  }
+  const OrtApi* api = im.api;
+  im.options = piper_ort::createSharedSessionOptions(ORT_ENABLE_EXTENDED);
+  if (!im.options) {
+    setErr(AsrError::kOrtCreateSessionFailed);
+    return false;
+  }
+  OrtStatus* status = api->CreateSession(env, model_path.c_str(), im.options, &im.session);
+  if (!status) status = api->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &im.memory_info);
+  if (status) {
+    piper_ort::logOrtStatus(api, status);
+    setErr(AsrError::kOrtCreateSessionFailed);
+    return false;
+  }
+
+  // Inputs: the float tensor is the feature input; an int64/int32 one is the length input.
+  OrtAllocator* allocator = nullptr;
+  size_t num_in = 0, num_out = 0;
+  status = api->GetAllocatorWithDefaultOptions(&allocator);
+  if (!status) status = api->SessionGetInputCount(im.session, &num_in);
+  if (!status) status = api->SessionGetOutputCount(im.session, &num_out);
+  if (status) {
+    piper_ort::logOrtStatus(api, status);
+    setErr(AsrError::kOrtCreateSessionFailed);
+    return false;
+  }
+  for (size_t i = 0; i < num_in; i++) {
+    char* name = nullptr;
+    OrtTypeInfo* type_info = nullptr;
+    if (api->SessionGetInputName(im.session, i, allocator, &name) != nullptr || !name) continue;
+    ONNXTensorElementDataType elem = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    if (api->SessionGetInputTypeInfo(im.session, i, &type_info) == nullptr && type_info) {
+      const OrtTensorTypeAndShapeInfo* tensor_info = nullptr;
+      if (api->CastTypeInfoToTensorInfo(type_info, &tensor_info) == nullptr && tensor_info)
+        api->GetTensorElementType(tensor_info, &elem);
+      api->ReleaseTypeInfo(type_info);
+    }
+    if (elem == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT && im.feature_input.empty()) im.feature_input = name;
+    else if ((elem == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64 || elem == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32) &&
+             im.length_input.empty()) {
+      im.length_input = name;
+      im.length_int32 = elem == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32;
+    }
+    allocator->Free(allocator, name);
+  }
+  if (num_out > 0) {
+    char* name = nullptr;
+    if (api->SessionGetOutputName(im.session, 0, allocator, &name) == nullptr && name) {
+      im.logits_output = name;
+      allocator->Free(allocator, name);
+    }
+  }
+  if (im.feature_input.empty() || im.logits_output.empty()) {
+    std::fprintf(stderr, "[Piper] ASR: model has no float feature input or no output\n");
+    setErr(AsrError::kUnexpectedOutput);
+    return false;
+  }
+
+  im.extractor.reset(new LogMelExtractor(im.mel));
+  im.stat_sum.assign(static_cast<size_t>(im.mel.n_mels), 0.0);
+  im.stat_sumsq.assign(static_cast<size_t>(im.mel.n_mels), 0.0);
+  im.resetStream();
+  model_path_ = model_path;
+  std::fprintf(stderr, "[Piper] ASR loaded: feature=\"%s\" length=\"%s\" output=\"%s\" vocab=%zu chunk=%zu left=%zu right=%zu\n",
+               im.feature_input.c_str(), im.length_input.c_str(), im.logits_output.c_str(), im.tokens.size(),
+               im.chunk_frames, im.left_context, im.right_context);
+  return true;
+}
+
+void StreamingRecognizer::reset() {
+  if (impl_) impl_->resetStream();
+  text_.clear();
+  stats_ = AsrStats{};
+}
+
+bool StreamingRecognizer::acceptPcm16(const int16_t* samples, size_t count, AsrError* out_error) {
+  if (!loaded()) {
+    if (out_error) *out_error = AsrError::kNotLoaded;
+    return false;
+  }
+  std::vector<float>& f = impl_->pcm_scratch;
+  f.resize(count);
+  const float scale = 1.0f / 32768.0f;
+  for (size_t i = 0; i < count; i++) f[i] = static_cast<float>(samples[i]) * scale;
+  return acceptFloat(f.data(), count, out_error);
+}
+
+bool StreamingRecognizer::acceptFloat(const float* samples, size_t count, AsrError* out_error) {
+  if (out_error) *out_error = AsrError::kNone;
+  if (!loaded()) {
+    if (out_error) *out_error = AsrError::kNotLoaded;
+    return false;
+  }
+  if (!samples && count) {
+    if (out_error) *out_error = AsrError::kInvalidArgs;
+    return false;
+  }
+  const auto t0 = Clock::now();
+  impl_->extractor->accept(samples, count);
+  impl_->collectFrames();
+  stats_.feature_sec += secondsSince(t0);
+  stats_.audio_sec += static_cast<double>(count) / static_cast<double>(impl_->mel.sample_rate);
+  return decodeAvailable(false, out_error);
+}
+
+std::string StreamingRecognizer::finish(AsrError* out_error) {
+  if (out_error) *out_error = AsrError::kNone;
+  if (!loaded()) {
+    if (out_error) *out_error = AsrError::kNotLoaded;
+    return std::string();
+  }
+  const auto t0 = Clock::now();
+  impl_->extractor->flush();
+  impl_->collectFrames();
+  stats_.feature_sec += secondsSince(t0);
+  decodeAvailable(true, out_error);
+  const std::string final_text = text_;
+  if (callback_) callback_(final_text, true);
+  const AsrStats finished = stats_;
+  reset();
+  stats_ = finished;
+  return final_text;
+}
+
+bool StreamingRecognizer::decodeAvailable(bool final_pass, AsrError* out_error) {
+  Impl& im = *impl_;
+  const std::string before = text_;
+  while (true) {
+    const size_t avail = im.total_frames;
+    const size_t remaining = avail - im.decoded_end;
+    if (remaining == 0) break;
+    if (!final_pass && remaining < im.chunk_frames + im.right_context) break;
+    const size_t emit_start = im.decoded_end;
+    const size_t emit_end = std::min(avail, emit_start + im.chunk_frames);
+    const size_t win_end = std::min(avail, emit_end + im.right_context);
+    const size_t win_start = emit_start > im.left_context ? emit_start - im.left_context : 0;
+    if (!runWindow(win_start, win_end, emit_start, emit_end, out_error)) return false;
+    im.decoded_end = emit_end;
+  }
+
+  // Keep only the rows the next window can still need as left context.
+  const size_t keep_from = im.decoded_end > im.left_context ? im.decoded_end - im.left_context : 0;
+  if (keep_from > im.feat_base + im.chunk_frames) {
+    const size_t drop = (keep_from - im.feat_base) * static_cast<size_t>(im.mel.n_mels);
+    im.feats.erase(im.feats.begin(), im.feats.begin() + static_cast<std::ptrdiff_t>(drop));
+    im.feat_base = keep_from;
+  }
+
+  if (text_ != before && !final_pass) {
+    stats_.partial_updates++;
+    if (stats_.first_partial_audio_sec < 0.0 && !text_.empty()) stats_.first_partial_audio_sec = stats_.audio_sec;
+    if (callback_) callback_(text_, false);
+  }
+  return true;
+}
+
+bool StreamingRecognizer::runWindow(size_t window_start,
+                                    size_t window_end,
+                                    size_t emit_start,
+                                    size_t emit_end,
+                                    AsrError* out_error) {
+  Impl& im = *impl_;
+  const OrtApi* api = im.api;
+  const auto t0 = Clock::now();
+  const size_t n_mels = static_cast<size_t>(im.mel.n_mels);
+  const size_t frames = window_end - window_start;
+
+  // Assemble [1, n_mels, T] or [1, T, n_mels], optionally normalized with running per-mel stats.
+  std::vector<float>& in = im.input_scratch;
+  in.resize(frames * n_mels);
+  const float* src = im.feats.data() + (window_start - im.feat_base) * n_mels;
+  std::vector<float> mean(n_mels, 0.0f), inv_std(n_mels, 1.0f);
+  if (im.per_feature_norm && im.stat_count > 1) {
+    const double n = static_cast<double>(im.stat_count);
+    for (size_t m = 0; m < n_mels; m++) {
+      const double mu = im.stat_sum[m] / n;
+      const double var = std::max(0.0, (im.stat_sumsq[m] - n * mu * mu) / (n - 1.0));
+      mean[m] = static_cast<float>(mu);
+      inv_std[m] = static_cast<float>(1.0 / (std::sqrt(var) + 1e-5));
+    }
+  }
+  for (size_t t = 0; t < frames; t++) {
+    const float* row = src + t * n_mels;
+    for (size_t m = 0; m < n_mels; m++) {
+      const float v = (row[m] - mean[m]) * inv_std[m];
+      if (im.channels_first) in[m * frames + t] = v;
+      else in[t * n_mels + m] = v;
+    }
+  }
+
+  const int64_t shape_cf[3] = {1, static_cast<int64_t>(n_mels), static_cast<int64_t>(frames)};
+  const int64_t shape_cl[3] = {1, static_cast<int64_t>(frames), static_cast<int64_t>(n_mels)};
+  int64_t length = static_cast<int64_t>(frames);
+  int32_t length32 = static_cast<int32_t>(frames);
+  const int64_t shape_len[1] = {1};
+  OrtValue* feat_value = nullptr;
+  OrtValue* len_value = nullptr;
+  OrtValue* out_value = nullptr;
+  auto release = [&]() {
+    if (feat_value) api->ReleaseValue(feat_value);
+    if (len_value) api->ReleaseValue(len_value);
+    if (out_value) api->ReleaseValue(out_value);
+  };
+
+  OrtStatus* status = api->CreateTensorWithDataAsOrtValue(
+      im.memory_info, in.data(), in.size() * sizeof(float), im.channels_first ? shape_cf : shape_cl, 3,
+      ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &feat_value);
+  const char* input_names[2] = {im.feature_input.c_str(), im.length_input.c_str()};
+  const OrtValue* inputs[2] = {nullptr, nullptr};
+  size_t num_inputs = 1;
+  if (!status && !im.length_input.empty()) {
+    status = im.length_int32
+                 ? api->CreateTensorWithDataAsOrtValue(im.memory_info, &length32, sizeof(length32), shape_len, 1,
+                                                       ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32, &len_value)
+                 : api->CreateTensorWithDataAsOrtValue(im.memory_info, &length, sizeof(length), shape_len, 1,
+                                                       ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &len_value);
+    num_inputs = 2;
+  }
+  inputs[0] = feat_value;
+  inputs[1] = len_value;
+  const char* output_names[1] = {im.logits_output.c_str()};
+  if (!status) status = api->Run(im.session, nullptr, input_names, inputs, num_inputs, output_names, 1, &out_value);
+  if (status || !out_value) {
+    piper_ort::logOrtStatus(api, status);
+    release();
+    if (out_error) *out_error = AsrError::kOrtRunInferenceFailed;
+    return false;
+  }
+
+  OrtTensorTypeAndShapeInfo* info = nullptr;
+  size_t rank = 0;
+  int64_t dims[3] = {0, 0, 0};
+  float* logits = nullptr;
+  status = api->GetTensorTypeAndShape(out_value, &info);
+  if (!status) status = api->GetDimensionsCount(info, &rank);
+  if (!status && (rank == 2 || rank == 3)) status = api->GetDimensions(info, dims, rank);
+  if (info) api->ReleaseTensorTypeAndShapeInfo(info);
+  if (!status) status = api->GetTensorMutableData(out_value, reinterpret_cast<void**>(&logits));
+  if (status || !logits || (rank != 2 && rank != 3)) {
+    piper_ort::logOrtStatus(api, status);
+    release();
+    if (out_error) *out_error = AsrError::kUnexpectedOutput;
+    return false;
+  }
+  const size_t out_frames = static_cast<size_t>(rank == 3 ? dims[1] : dims[0]);
+  const size_t vocab = static_cast<size_t>(rank == 3 ? dims[2] : dims[1]);
+
+  // Map the emitted feature span onto output frames (model subsampling inferred from T'/T).
+  const double ratio = static_cast<double>(out_frames) / static_cast<double>(frames);
+  const size_t out_lo = static_cast<size_t>(std::lround(static_cast<double>(emit_start - window_start) * ratio));
+  size_t out_hi = static_cast<size_t>(std::lround(static_cast<double>(emit_end - window_start) * ratio));
+  if (emit_end == window_end) out_hi = out_frames;
+  out_hi = std::min(out_hi, out_frames);
+  for (size_t t = out_lo; t < out_hi; t++) {
+    const float* row = logits + t * vocab;
+    size_t best = 0;
+    for (size_t v = 1; v < vocab; v++)
+      if (row[v] > row[best]) best = v;
+    appendToken(static_cast<int64_t>(best));
+  }
+  release();
+
+  stats_.inference_sec += secondsSince(t0);
+  stats_.model_runs++;
+  text_ = normalizeSpaces(im.raw_text);
+  return true;
+}
+
+void StreamingRecognizer::appendToken(int64_t id) {
+  Impl& im = *impl_;
+  if (id == im.blank_id) {
+    im.prev_token = id;
+    return;
+  }
+  if (id == im.prev_token) return;
+  im.prev_token = id;
+  if (id < 0 || static_cast<size_t>(id) >= im.tokens.size()) return;
+  const std::string& tok = im.tokens[static_cast<size_t>(id)];
+  if (isSpecialToken(tok)) return;
+  // SentencePiece word boundary U+2581 and wav2vec2 "|" both mean a space.
+  static const char kSpWordStart[] = "\xE2\x96\x81";
+  if (tok.compare(0, 3, kSpWordStart) == 0) {
+    im.raw_text.push_back(' ');
+    im.raw_text.append(tok, 3, std::string::npos);
+  } else if (tok == "|") {
+    im.raw_text.push_back(' ');
+  } else {
+    im.raw_text.append(tok);
+  }
+}
+
+}  // namespace piper
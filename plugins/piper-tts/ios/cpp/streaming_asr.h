@@ -0,0 +1,99 @@
+#ifndef STREAMING_ASR_H
+#define STREAMING_ASR_H
+
+#include "log_mel.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace piper {
+
+// Error codes for StreamingRecognizer (when a call returns false).
+enum class AsrError {
+  kNone = 0,
+  kInvalidArgs,
+  kConfigOpenFailed,
+  kConfigParseFailed,
+  kTokensLoadFailed,
+  kOrtCreateSessionFailed,
+  kOrtRunInferenceFailed,
+  kUnexpectedOutput,
+  kNotLoaded,
+};
+
+const char* asrErrorToString(AsrError error);
+
+// Per-stream timing, reset with the stream. RTF = (feature_sec + inference_sec) / audio_sec.
+struct AsrStats {
+  double audio_sec = 0.0;
+  double feature_sec = 0.0;
+  double inference_sec = 0.0;
+  int model_runs = 0;
+  int partial_updates = 0;
+  double first_partial_audio_sec = -1.0;  // audio consumed when the first non-empty partial appeared
+};
+
+// Called when the hypothesis changes (is_final=false) and once from finish() (is_final=true).
+using AsrHypothesisCallback = std::function<void(const std::string& text, bool is_final)>;
+
+// Streaming CTC recognizer over 16 kHz mono audio. Log-mel features (log_mel.h) are
+// computed as frames arrive; every chunk_frames new feature frames the ONNX acoustic
+// model runs on [left context + chunk + right context] on the shared ORT env, and the
+// chunk's logits are greedy-decoded with CTC collapse carried across chunks.
+//
+// Model directory contract (asr_config.json next to the model):
+//   feature settings (sample_rate, n_fft, win_length, hop_length, n_mels, f_min, f_max,
+//   preemphasis, remove_dc, window "hann"|"povey", mel_scale "htk"|"slaney"),
+//   normalize "none"|"per_feature", feature_layout "channels_first" ([1, n_mels, T]) |
+//   "channels_last" ([1, T, n_mels]), chunk_frames, left_context_frames,
+//   right_context_frames, blank_id. tokens.txt: "<token> <id>" or one token per line.
+// Not thread-safe; use one instance per stream.
+class StreamingRecognizer {
+ public:
+  StreamingRecognizer();
+  ~StreamingRecognizer();
+  StreamingRecognizer(const StreamingRecognizer&) = delete;
+  StreamingRecognizer& operator=(const StreamingRecognizer&) = delete;
+
+  bool load(const std::string& model_path,
+            const std::string& tokens_path,
+            const std::string& config_path,
+            AsrError* out_error = nullptr);
+  bool loaded() const;
+  const std::string& modelPath() const { return model_path_; }
+
+  void setCallback(AsrHypothesisCallback callback) { callback_ = std::move(callback); }
+
+  // Feed mono samples at the model sample rate (16 kHz), any chunk size (e.g. 10 ms).
+  bool acceptPcm16(const int16_t* samples, size_t count, AsrError* out_error = nullptr);
+  bool acceptFloat(const float* samples, size_t count, AsrError* out_error = nullptr);
+
+  // Flush trailing audio, decode the remainder and return the final hypothesis.
+  // Stream state (not the model) is reset afterwards; stats() keep the finished stream's values.
+  std::string finish(AsrError* out_error = nullptr);
+
+  const std::string& partial() const { return text_; }
+  const AsrStats& stats() const { return stats_; }
+  int sampleRate() const;
+
+  // Drop buffered audio/features/hypothesis and start a new stream.
+  void reset();
+
+ private:
+  struct Impl;
+  bool decodeAvailable(bool final_pass, AsrError* out_error);
+  bool runWindow(size_t window_start, size_t window_end, size_t emit_start, size_t emit_end, AsrError* out_error);
+  void appendToken(int64_t id);
+
+  std::unique_ptr<Impl> impl_;
+  std::string model_path_;
+  AsrHypothesisCallback callback_;
+  std::string text_;
+  AsrStats stats_;
+};
+
+}  // namespace piper
+
+#endif  // STREAMING_ASR_H
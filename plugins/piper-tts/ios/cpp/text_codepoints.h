@@ -0,0 +1,20 @@
+#ifndef TEXT_CODEPOINTS_H
+#define TEXT_CODEPOINTS_H
+
+#include "scratch_arena.h"
+#include <string>
+
+namespace piper {
+
+// Phonemes of a "phoneme_type": "text" voice: the text itself, case-folded and NFD-decomposed like
+// piper-phonemize's phonemize_codepoints, so each UTF-8 codepoint of the result is one phoneme_id_map key
+// (accented letters become base letter + combining mark). Folding covers ASCII, Latin (U+00C0-U+024F,
+// U+1E00-U+1EFF), Greek, Cyrillic and the Arabic letters with canonical decompositions; other codepoints
+// pass through unchanged. Invalid UTF-8 bytes are dropped.
+std::string foldTextCodepoints(const std::string& text);
+// Same, appended to a request's scratch string.
+void appendFoldedTextCodepoints(const std::string& text, ArenaString& out);
+
+}  // namespace piper
+
+#endif  // TEXT_CODEPOINTS_H
@@ -0,0 +1,703 @@
+#include "vector_index.h"
+#include "simd_f32.h"
+#include "vector_sq8.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace piper {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'I', 'P', 'E', 'R', 'V', 'S', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 40;
+
+uint64_t fnv1a64(const void* data, size_t n, uint64_t h = 1469598103934665603ull) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < n; ++i) {
+    h ^= p[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+uint64_t fnvString(const std::string& s, uint64_t h) {
+  const uint64_t len = s.size();
+  return fnv1a64(s.data(), s.size(), fnv1a64(&len, sizeof(len), h));
+}
+
+// Size and mtime so a re-copied or re-embedded file invalidates a compacted view.
+bool fingerprintFile(const std::string& path, uint64_t* h) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) return false;
+  const int64_t parts[2] = {static_cast<int64_t>(st.st_size), static_cast<int64_t>(st.st_mtime)};
+  *h = fnv1a64(parts, sizeof(parts), fnvString(path, *h));
+  return true;
+}
+
+#if !(defined(__aarch64__) && PIPER_SIMD_NEON)
+const float* halfTable() {
+  static const std::vector<float> table = [] {
+    std::vector<float> t(65536);
+    for (uint32_t i = 0; i < 65536; ++i) t[i] = halfToFloat(static_cast<uint16_t>(i));
+    return t;
+  }();
+  return table.data();
+}
+#endif
+
+// Squared L2 between a float query and one f16 row.
+float l2sqF16(const float* q, const uint16_t* row, size_t dim) {
+  using namespace piper_simd;
+  size_t i = 0;
+  float sum = 0.f;
+#if defined(__aarch64__) && PIPER_SIMD_NEON
+  float32x4_t acc0 = vdupq_n_f32(0.f), acc1 = vdupq_n_f32(0.f);
+  for (; i + 8 <= dim; i += 8) {
+    const float32x4_t d0 = vsubq_f32(vld1q_f32(q + i), vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(row + i))));
+    const float32x4_t d1 =
+        vsubq_f32(vld1q_f32(q + i + 4), vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(row + i + 4))));
+    acc0 = vfmaq_f32(acc0, d0, d0);
+    acc1 = vfmaq_f32(acc1, d1, d1);
+  }
+  sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+  for (; i < dim; ++i) {
+    const float d = q[i] - halfToFloat(row[i]);
+    sum += d * d;
+  }
+#else
+  const float* table = halfTable();
+  f32x4 acc = set1(0.f);
+  for (; i + 4 <= dim; i += 4) {
+    const float r[4] = {table[row[i]], table[row[i + 1]], table[row[i + 2]], table[row[i + 3]]};
+    const f32x4 d = sub(load(q + i), load(r));
+    acc = fmadd(acc, d, d);
+  }
+  sum = hsum(acc);
+  for (; i < dim; ++i) {
+    const float d = q[i] - table[row[i]];
+    sum += d * d;
+  }
+#endif
+  return sum;
+}
+
+// Dot product of two float vectors (coarse f32 prefixes).
+float dotF32(const float* a, const float* b, size_t n) {
+  using namespace piper_simd;
+  f32x4 acc0 = set1(0.f), acc1 = set1(0.f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    acc0 = fmadd(acc0, load(a + i), load(b + i));
+    acc1 = fmadd(acc1, load(a + i + 4), load(b + i + 4));
+  }
+  float sum = hsum(add(acc0, acc1));
+  for (; i < n; ++i) sum += a[i] * b[i];
+  return sum;
+}
+
+// Dot product of a float query (already multiplied by the per-dim scales) and an int8 coarse prefix.
+float dotI8(const float* q, const int8_t* c, size_t n) {
+  using namespace piper_simd;
+  size_t i = 0;
+  float sum = 0.f;
+#if defined(__aarch64__) && PIPER_SIMD_NEON
+  float32x4_t acc0 = vdupq_n_f32(0.f), acc1 = vdupq_n_f32(0.f);
+  for (; i + 8 <= n; i += 8) {
+    const int16x8_t w = vmovl_s8(vld1_s8(c + i));
+    acc0 = vfmaq_f32(acc0, vld1q_f32(q + i), vcvtq_f32_s32(vmovl_s16(vget_low_s16(w))));
+    acc1 = vfmaq_f32(acc1, vld1q_f32(q + i + 4), vcvtq_f32_s32(vmovl_s16(vget_high_s16(w))));
+  }
+  sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#elif PIPER_SIMD_SSE2
+  // Sign-extend by unpacking each byte into the high half of a wider lane and shifting it back down.
+  __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+  for (; i + 8 <= n; i += 8) {
+    const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(c + i));
+    const __m128i w = _mm_unpacklo_epi8(b, b);
+    const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(w, w), 24));
+    const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(w, w), 24));
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(q + i), lo));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(q + i + 4), hi));
+  }
+  sum = hsum(_mm_add_ps(acc0, acc1));
+#else
+  f32x4 acc = set1(0.f);
+  for (; i + 4 <= n; i += 4) {
+    const float r[4] = {float(c[i]), float(c[i + 1]), float(c[i + 2]), float(c[i + 3])};
+    acc = fmadd(acc, load(q + i), load(r));
+  }
+  sum = hsum(acc);
+#endif
+  for (; i < n; ++i) sum += q[i] * float(c[i]);
+  return sum;
+}
+
+// Max-heap on distance holding the k nearest so far.
+void pushNearest(std::vector<VectorHit>& heap, size_t k, uint32_t row, float d) {
+  auto farther = [](const VectorHit& a, const VectorHit& b) { return a.distance < b.distance; };
+  if (heap.size() < k) {
+    heap.push_back({row, d});
+    std::push_heap(heap.begin(), heap.end(), farther);
+  } else if (d < heap.front().distance) {
+    std::pop_heap(heap.begin(), heap.end(), farther);
+    heap.back() = {row, d};
+    std::push_heap(heap.begin(), heap.end(), farther);
+  }
+}
+
+void sortNearest(std::vector<VectorHit>& heap) {
+  std::sort_heap(heap.begin(), heap.end(),
+                 [](const VectorHit& a, const VectorHit& b) { return a.distance < b.distance; });
+}
+
+bool setError(VectorIndexError* out, VectorIndexError e) {
+  if (out) *out = e;
+  return false;
+}
+
+}  // namespace
+
+const char* vectorIndexErrorString(VectorIndexError e) {
+  switch (e) {
+    case VectorIndexError::kNone: return "none";
+    case VectorIndexError::kInvalidArgs: return "invalid arguments";
+    case VectorIndexError::kOpenFailed: return "segment file could not be opened";
+    case VectorIndexError::kBadFormat: return "segment file has a bad size or header";
+    case VectorIndexError::kDimMismatch: return "segment dim does not match the index";
+    case VectorIndexError::kRowOverlap: return "segment rows overlap an earlier segment";
+    case VectorIndexError::kWriteFailed: return "compacted segment could not be written";
+    case VectorIndexError::kBusy: return "compaction already running";
+  }
+  return "unknown";
+}
+
+struct SegmentedVectorIndex::Segment {
+  std::string name;
+  const unsigned char* base = nullptr;
+  size_t length = 0;
+  const uint16_t* vectors = nullptr;
+  const uint32_t* row_ids = nullptr;  // .vseg: explicit ascending ids; raw f16: null (first_row + i)
+  uint32_t first_row = 0;
+  size_t rows = 0;
+  uint64_t source_fingerprint = 0;  // .vseg only
+
+  ~Segment() {
+    if (base) munmap(const_cast<unsigned char*>(base), length);
+  }
+  uint32_t rowId(size_t i) const { return row_ids ? row_ids[i] : first_row + static_cast<uint32_t>(i); }
+  uint32_t lastRow() const { return rowId(rows - 1); }
+};
+
+// Unit-length prefixes of the live rows (or their full-dimension sq8 codes), in scan order, with where to
+// find each full row for the re-rank.
+struct SegmentedVectorIndex::Coarse {
+  uint32_t prefix = 0;
+  size_t candidates = 0;
+  bool int8 = false;
+  bool sq8 = false;
+  std::vector<float> rows_f32;        // [rows, prefix]
+  std::vector<int8_t> rows_i8;        // [rows, prefix] when int8; [rows, stride] sq8 codes when sq8
+  std::vector<float> scale;           // [prefix] int8 value -> float; [dim] when sq8
+  std::vector<float> offset;          // [dim] sq8 only
+  std::vector<float> norms;           // [rows] sq8 only: squared length of the dequantized row
+  size_t stride = 0;                  // sq8 only
+  size_t table_rows = 0;              // sq8 rows copied from the pack-time table
+  std::vector<uint32_t> ids;          // global row id
+  std::vector<const uint16_t*> full;  // full f16 row in its segment's mapping
+
+  size_t bytes() const {
+    return rows_f32.size() * sizeof(float) + rows_i8.size() + (scale.size() + offset.size()) * sizeof(float) +
+           norms.size() * sizeof(float) + ids.size() * sizeof(uint32_t) + full.size() * sizeof(const uint16_t*);
+  }
+};
+
+struct SegmentedVectorIndex::Snapshot {
+  uint32_t dim = 0;
+  std::vector<std::shared_ptr<Segment>> segments;
+  std::vector<std::vector<uint32_t>> skip;  // per segment: ascending local indices of tombstoned rows
+  size_t rows = 0;
+  size_t tombstones = 0;
+  bool compacted = false;
+  uint64_t fingerprint = 0;
+  std::string sq8_path;
+  std::shared_ptr<const Coarse> coarse;  // null: exact scan
+};
+
+// Raw f16 rows, or a .vseg when the file starts with its magic.
+bool SegmentedVectorIndex::mapSegment(const std::string& path, uint32_t dim, uint32_t first_row,
+                                      std::shared_ptr<Segment>& out, VectorIndexError* err) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return setError(err, VectorIndexError::kOpenFailed);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return setError(err, VectorIndexError::kBadFormat);
+  }
+  void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) return setError(err, VectorIndexError::kOpenFailed);
+  auto seg = std::make_shared<Segment>();
+  seg->base = static_cast<const unsigned char*>(map);
+  seg->length = static_cast<size_t>(st.st_size);
+  const size_t row_bytes = size_t(dim) * sizeof(uint16_t);
+
+  if (seg->length >= kHeaderSize && std::memcmp(seg->base, kMagic, sizeof(kMagic)) == 0) {
+    uint32_t version, file_dim, rows;
+    uint64_t vectors_offset;
+    std::memcpy(&version, seg->base + 8, 4);
+    std::memcpy(&file_dim, seg->base + 12, 4);
+    std::memcpy(&rows, seg->base + 16, 4);
+    std::memcpy(&seg->source_fingerprint, seg->base + 24, 8);
+    std::memcpy(&vectors_offset, seg->base + 32, 8);
+    if (version != kVersion) return setError(err, VectorIndexError::kBadFormat);
+    if (file_dim != dim) return setError(err, VectorIndexError::kDimMismatch);
+    if (rows == 0 || kHeaderSize + size_t(rows) * 4 > vectors_offset || vectors_offset % 16 != 0 ||
+        vectors_offset + size_t(rows) * row_bytes > seg->length)
+      return setError(err, VectorIndexError::kBadFormat);
+    seg->row_ids = reinterpret_cast<const uint32_t*>(seg->base + kHeaderSize);
+    seg->vectors = reinterpret_cast<const uint16_t*>(seg->base + vectors_offset);
+    seg->rows = rows;
+    for (size_t i = 1; i < seg->rows; ++i) {
+      if (seg->row_ids[i] <= seg->row_ids[i - 1]) return setError(err, VectorIndexError::kBadFormat);
+    }
+  } else {
+    if (seg->length % row_bytes != 0) return setError(err, VectorIndexError::kBadFormat);
+    seg->rows = seg->length / row_bytes;
+    if (uint64_t(first_row) + seg->rows > UINT32_MAX) return setError(err, VectorIndexError::kBadFormat);
+    seg->vectors = reinterpret_cast<const uint16_t*>(seg->base);
+    seg->first_row = first_row;
+  }
+  out = std::move(seg);
+  return true;
+}
+
+static bool readTombstones(const std::string& path, std::vector<uint32_t>& out) {
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return false;
+  uint32_t buf[1024];
+  size_t n;
+  while ((n = std::fread(buf, sizeof(uint32_t), 1024, f)) > 0) out.insert(out.end(), buf, buf + n);
+  std::fclose(f);
+  return true;
+}
+
+bool SegmentedVectorIndex::open(const VectorIndexSpec& spec, VectorIndexError* out_error) {
+  if (spec.dim == 0 || spec.segments.empty()) return setError(out_error, VectorIndexError::kInvalidArgs);
+  const uint32_t dim = spec.dim;
+  uint64_t fp = fnv1a64(&dim, sizeof(dim));
+  for (const VectorSegmentSpec& s : spec.segments) {
+    fp = fnvString(s.name, fp);
+    fp = fnv1a64(&s.first_row, sizeof(s.first_row), fp);
+    if (!s.vectors_path.empty() && !fingerprintFile(s.vectors_path, &fp))
+      return setError(out_error, VectorIndexError::kOpenFailed);
+    if (!s.tombstones_path.empty() && !fingerprintFile(s.tombstones_path, &fp))
+      return setError(out_error, VectorIndexError::kOpenFailed);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (snap_ && snap_->fingerprint == fp) return true;
+  }
+
+  auto snap = std::make_shared<Snapshot>();
+  snap->dim = dim;
+  snap->fingerprint = fp;
+  snap->sq8_path = spec.sq8_path;
+  std::shared_ptr<Segment> compacted;
+  if (!spec.compacted_path.empty() && mapSegment(spec.compacted_path, dim, 0, compacted, nullptr) &&
+      compacted->row_ids && compacted->source_fingerprint == fp) {
+    compacted->name = "compacted";
+    snap->segments.push_back(std::move(compacted));
+    snap->skip.emplace_back();
+    snap->rows = snap->segments[0]->rows;
+    snap->compacted = true;
+  } else {
+    std::vector<uint32_t> tombstones;
+    for (const VectorSegmentSpec& s : spec.segments) {
+      if (!s.tombstones_path.empty() && !readTombstones(s.tombstones_path, tombstones))
+        return setError(out_error, VectorIndexError::kOpenFailed);
+      if (s.vectors_path.empty()) continue;  // tombstone-only delta
+      std::shared_ptr<Segment> seg;
+      VectorIndexError err = VectorIndexError::kNone;
+      if (!mapSegment(s.vectors_path, dim, s.first_row, seg, &err)) return setError(out_error, err);
+      seg->name = s.name;
+      if (!snap->segments.empty() && seg->rowId(0) <= snap->segments.back()->lastRow())
+        return setError(out_error, VectorIndexError::kRowOverlap);
+      snap->rows += seg->rows;
+      snap->segments.push_back(std::move(seg));
+    }
+    if (snap->segments.empty()) return setError(out_error, VectorIndexError::kInvalidArgs);
+    std::sort(tombstones.begin(), tombstones.end());
+    tombstones.erase(std::unique(tombstones.begin(), tombstones.end()), tombstones.end());
+    for (const std::shared_ptr<Segment>& seg : snap->segments) {
+      std::vector<uint32_t> skip;
+      auto t = std::lower_bound(tombstones.begin(), tombstones.end(), seg->rowId(0));
+      for (size_t i = 0; i < seg->rows && t != tombstones.end(); ++i) {
+        const uint32_t id = seg->rowId(i);
+        while (t != tombstones.end() && *t < id) ++t;
+        if (t != tombstones.end() && *t == id) skip.push_back(static_cast<uint32_t>(i));
+      }
+      snap->tombstones += skip.size();
+      snap->skip.push_back(std::move(skip));
+    }
+  }
+
+  snap->coarse = buildCoarse(*snap, coarseSearch());
+  std::lock_guard<std::mutex> lock(mu_);
+  snap_ = std::move(snap);
+  return true;
+}
+
+void SegmentedVectorIndex::close() {
+  std::lock_guard<std::mutex> lock(mu_);
+  snap_.reset();
+}
+
+std::shared_ptr<const SegmentedVectorIndex::Snapshot> SegmentedVectorIndex::snapshot() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return snap_;
+}
+
+std::vector<VectorHit> SegmentedVectorIndex::searchExact(const float* query, size_t dim, size_t k) const {
+  std::vector<VectorHit> heap;
+  const auto snap = snapshot();
+  if (!snap || !query || dim != snap->dim || k == 0) return heap;
+  heap.reserve(k + 1);
+  for (size_t s = 0; s < snap->segments.size(); ++s) {
+    const Segment& seg = *snap->segments[s];
+    const std::vector<uint32_t>& skip = snap->skip[s];
+    size_t next_skip = 0;
+    for (size_t i = 0; i < seg.rows; ++i) {
+      if (next_skip < skip.size() && skip[next_skip] == i) {
+        ++next_skip;
+        continue;
+      }
+      pushNearest(heap, k, seg.rowId(i), l2sqF16(query, seg.vectors + i * dim, dim));
+    }
+  }
+  sortNearest(heap);
+  for (VectorHit& h : heap) h.distance = std::sqrt(h.distance);
+  return heap;
+}
+
+std::vector<VectorHit> SegmentedVectorIndex::search(const float* query, size_t dim, size_t k) const {
+  const auto snap = snapshot();
+  if (!snap || !snap->coarse || !query || dim != snap->dim || k == 0) return searchExact(query, dim, k);
+  const Coarse& coarse = *snap->coarse;
+  const size_t m = std::max(coarse.candidates, k);
+  std::vector<VectorHit> candidates;
+  candidates.reserve(m + 1);
+  const size_t rows = coarse.ids.size();
+  if (coarse.sq8) {
+    // |q - x|^2 without the constant |q|^2 is |x|^2 - 2 q.x, and with x = offset + scale * c,
+    // q.x = q.offset + (q * scale).c. q * scale is quantized with one symmetric scale so the second term is
+    // an integer dot product against the stored codes.
+    const size_t stride = coarse.stride;
+    std::vector<int8_t> q8(stride, 0);
+    float qmax = 0.f, q_offset = 0.f;
+    for (size_t d = 0; d < dim; ++d) {
+      qmax = std::max(qmax, std::fabs(query[d] * coarse.scale[d]));
+      q_offset += query[d] * coarse.offset[d];
+    }
+    const float alpha = qmax > 0.f ? qmax / 127.f : 1.f;
+    for (size_t d = 0; d < dim; ++d) {
+      q8[d] = static_cast<int8_t>(std::max(-127.f, std::min(127.f, std::round(query[d] * coarse.scale[d] / alpha))));
+    }
+    constexpr size_t kBlock = 256;
+    int32_t dots[kBlock];
+    for (size_t r = 0; r < rows; r += kBlock) {
+      const size_t n = std::min(kBlock, rows - r);
+      sq8DotRows(q8.data(), coarse.rows_i8.data() + r * stride, n, stride, dots);
+      for (size_t j = 0; j < n; ++j) {
+        pushNearest(candidates, m, static_cast<uint32_t>(r + j),
+                    coarse.norms[r + j] - 2.f * (q_offset + alpha * static_cast<float>(dots[j])));
+      }
+    }
+  } else {
+    // Coarse pass: cosine of the unit-length query prefix against every stored prefix (as 1 - cos, so the
+    // same nearest-first heap applies). int8 rows fold the per-dim scale into the query once.
+    const size_t prefix = coarse.prefix;
+    std::vector<float> q(prefix);
+    float norm = 0.f;
+    for (size_t d = 0; d < prefix; ++d) norm += query[d] * query[d];
+    const float inv = norm > 0.f ? 1.f / std::sqrt(norm) : 0.f;
+    for (size_t d = 0; d < prefix; ++d) q[d] = query[d] * inv * (coarse.int8 ? coarse.scale[d] : 1.f);
+    for (size_t r = 0; r < rows; ++r) {
+      const float cos = coarse.int8 ? dotI8(q.data(), coarse.rows_i8.data() + r * prefix, prefix)
+                                    : dotF32(q.data(), coarse.rows_f32.data() + r * prefix, prefix);
+      pushNearest(candidates, m, static_cast<uint32_t>(r), 1.f - cos);
+    }
+  }
+
+  // Fine pass: exact f16 L2 over the candidates only.
+  std::vector<VectorHit> heap;
+  heap.reserve(k + 1);
+  for (const VectorHit& c : candidates) {
+    pushNearest(heap, k, coarse.ids[c.row], l2sqF16(query, coarse.full[c.row], dim));
+  }
+  sortNearest(heap);
+  for (VectorHit& h : heap) h.distance = std::sqrt(h.distance);
+  return heap;
+}
+
+std::shared_ptr<const SegmentedVectorIndex::Coarse> SegmentedVectorIndex::buildCoarse(
+    const Snapshot& snap, const CoarseSearchConfig& config) {
+  if (config.sq8) return buildSq8(snap, config);
+  if (config.prefix_dims == 0 || config.prefix_dims >= snap.dim) return nullptr;
+  auto coarse = std::make_shared<Coarse>();
+  const size_t prefix = config.prefix_dims;
+  const size_t live = snap.rows - snap.tombstones;
+  coarse->prefix = config.prefix_dims;
+  coarse->candidates = std::max<size_t>(config.candidates, 1);
+  coarse->int8 = config.int8;
+  coarse->ids.reserve(live);
+  coarse->full.reserve(live);
+  coarse->rows_f32.reserve(live * prefix);
+  for (size_t s = 0; s < snap.segments.size(); ++s) {
+    const Segment& seg = *snap.segments[s];
+    const std::vector<uint32_t>& skip = snap.skip[s];
+    size_t next_skip = 0;
+    for (size_t i = 0; i < seg.rows; ++i) {
+      if (next_skip < skip.size() && skip[next_skip] == i) {
+        ++next_skip;
+        continue;
+      }
+      const uint16_t* row = seg.vectors + i * snap.dim;
+      const size_t at = coarse->rows_f32.size();
+      float norm = 0.f;
+      for (size_t d = 0; d < prefix; ++d) {
+        const float v = halfToFloat(row[d]);
+        coarse->rows_f32.push_back(v);
+        norm += v * v;
+      }
+      const float inv = norm > 0.f ? 1.f / std::sqrt(norm) : 0.f;
+      for (size_t d = 0; d < prefix; ++d) coarse->rows_f32[at + d] *= inv;
+      coarse->ids.push_back(seg.rowId(i));
+      coarse->full.push_back(row);
+    }
+  }
+  if (config.int8) {
+    // Symmetric per-dimension scale; the f32 copy is only needed to find it.
+    coarse->scale.assign(prefix, 0.f);
+    for (size_t r = 0; r < coarse->ids.size(); ++r) {
+      for (size_t d = 0; d < prefix; ++d) {
+        coarse->scale[d] = std::max(coarse->scale[d], std::fabs(coarse->rows_f32[r * prefix + d]));
+      }
+    }
+    for (float& sc : coarse->scale) sc = sc > 0.f ? sc / 127.f : 1.f;
+    coarse->rows_i8.resize(coarse->rows_f32.size());
+    for (size_t j = 0; j < coarse->rows_f32.size(); ++j) {
+      const float v = std::round(coarse->rows_f32[j] / coarse->scale[j % prefix]);
+      coarse->rows_i8[j] = static_cast<int8_t>(std::max(-127.f, std::min(127.f, v)));
+    }
+    std::vector<float>().swap(coarse->rows_f32);
+  }
+  std::fprintf(stderr, "[Piper] vector index coarse prefix: %zu rows x %zu dims (%s), %zu candidates, %zu bytes\n",
+               coarse->ids.size(), prefix, config.int8 ? "int8" : "f32", coarse->candidates, coarse->bytes());
+  return coarse;
+}
+
+std::shared_ptr<const SegmentedVectorIndex::Coarse> SegmentedVectorIndex::buildSq8(
+    const Snapshot& snap, const CoarseSearchConfig& config) {
+  auto coarse = std::make_shared<Coarse>();
+  const size_t dim = snap.dim;
+  const size_t live = snap.rows - snap.tombstones;
+  coarse->sq8 = true;
+  coarse->candidates = std::max<size_t>(config.candidates, 1);
+  coarse->stride = sq8Stride(dim);
+  coarse->ids.reserve(live);
+  coarse->full.reserve(live);
+  for (size_t s = 0; s < snap.segments.size(); ++s) {
+    const Segment& seg = *snap.segments[s];
+    const std::vector<uint32_t>& skip = snap.skip[s];
+    size_t next_skip = 0;
+    for (size_t i = 0; i < seg.rows; ++i) {
+      if (next_skip < skip.size() && skip[next_skip] == i) {
+        ++next_skip;
+        continue;
+      }
+      coarse->ids.push_back(seg.rowId(i));
+      coarse->full.push_back(seg.vectors + i * dim);
+    }
+  }
+  const size_t rows = coarse->ids.size();
+
+  // The pack-time table covers the base rows (ids below its row count). Its scale/offset are kept for delta
+  // rows too (they clamp); a few rows are re-encoded to check it was built from these vectors.
+  Sq8File table;
+  std::string table_error;
+  bool use_table = !snap.sq8_path.empty() && table.open(snap.sq8_path, snap.dim, &table_error);
+  if (use_table) {
+    std::vector<int8_t> check(coarse->stride);
+    const size_t probes[3] = {0, rows / 2, rows ? rows - 1 : 0};
+    for (size_t p : probes) {
+      if (p >= rows || coarse->ids[p] >= table.rows()) continue;
+      sq8Encode(coarse->full[p], dim, coarse->stride, table.scale(), table.offset(), check.data());
+      if (std::memcmp(check.data(), table.codes(coarse->ids[p]), coarse->stride) != 0) {
+        use_table = false;
+        table_error = "codes do not match the vectors";
+        break;
+      }
+    }
+  }
+  if (use_table) {
+    coarse->scale.assign(table.scale(), table.scale() + dim);
+    coarse->offset.assign(table.offset(), table.offset() + dim);
+  } else {
+    if (!snap.sq8_path.empty() && access(snap.sq8_path.c_str(), F_OK) == 0) {
+      std::fprintf(stderr, "[Piper] vector index sq8 table %s not used (%s); quantizing in memory\n",
+                   snap.sq8_path.c_str(), table_error.c_str());
+    }
+    sq8Fit(coarse->full.data(), rows, dim, coarse->scale, coarse->offset);
+  }
+  coarse->rows_i8.resize(rows * coarse->stride);
+  coarse->norms.resize(rows);
+  for (size_t r = 0; r < rows; ++r) {
+    int8_t* codes = coarse->rows_i8.data() + r * coarse->stride;
+    if (use_table && coarse->ids[r] < table.rows()) {
+      std::memcpy(codes, table.codes(coarse->ids[r]), coarse->stride);
+      coarse->norms[r] = table.norms()[coarse->ids[r]];
+      ++coarse->table_rows;
+    } else {
+      coarse->norms[r] =
+          sq8Encode(coarse->full[r], dim, coarse->stride, coarse->scale.data(), coarse->offset.data(), codes);
+    }
+  }
+  std::fprintf(stderr, "[Piper] vector index sq8: %zu rows (%zu from table), %s kernel, %zu candidates, %zu bytes\n",
+               rows, coarse->table_rows, sq8KernelName(), coarse->candidates, coarse->bytes());
+  return coarse;
+}
+
+void SegmentedVectorIndex::setCoarseSearch(const CoarseSearchConfig& config) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (config.prefix_dims == coarse_config_.prefix_dims && config.candidates == coarse_config_.candidates &&
+        config.int8 == coarse_config_.int8 && config.sq8 == coarse_config_.sq8)
+      return;
+    coarse_config_ = config;
+  }
+  const auto snap = snapshot();
+  if (!snap) return;
+  auto next = std::make_shared<Snapshot>(*snap);
+  next->coarse = buildCoarse(*next, config);
+  std::lock_guard<std::mutex> lock(mu_);
+  if (snap_ == snap) snap_ = std::move(next);  // reopened meanwhile: that open used the new config
+}
+
+CoarseSearchConfig SegmentedVectorIndex::coarseSearch() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return coarse_config_;
+}
+
+bool SegmentedVectorIndex::compact(const std::string& out_path, VectorIndexError* out_error) {
+  if (out_path.empty()) return setError(out_error, VectorIndexError::kInvalidArgs);
+  if (compacting_.exchange(true)) return setError(out_error, VectorIndexError::kBusy);
+  struct Reset {
+    std::atomic<bool>& flag;
+    ~Reset() { flag = false; }
+  } reset{compacting_};
+
+  const auto snap = snapshot();
+  if (!snap) return setError(out_error, VectorIndexError::kInvalidArgs);
+  if (snap->compacted) return true;
+  const uint32_t live = static_cast<uint32_t>(snap->rows - snap->tombstones);
+  if (live == 0) return setError(out_error, VectorIndexError::kInvalidArgs);
+  const uint64_t vectors_offset = (kHeaderSize + uint64_t(live) * 4 + 15) & ~uint64_t(15);
+
+  const std::string tmp = out_path + ".tmp";
+  FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) return setError(out_error, VectorIndexError::kWriteFailed);
+  bool ok = std::fwrite(kMagic, 1, sizeof(kMagic), f) == sizeof(kMagic);
+  const uint32_t header_u32[4] = {kVersion, snap->dim, live, 0};
+  const uint64_t header_u64[2] = {snap->fingerprint, vectors_offset};
+  ok = ok && std::fwrite(header_u32, sizeof(header_u32), 1, f) == 1;
+  ok = ok && std::fwrite(header_u64, sizeof(header_u64), 1, f) == 1;
+  // Two passes over the live rows (ids, then vectors) in ascending id order.
+  for (int pass = 0; pass < 2 && ok; ++pass) {
+    if (pass == 1) {
+      const unsigned char zeros[16] = {};
+      const size_t pad = static_cast<size_t>(vectors_offset - (kHeaderSize + uint64_t(live) * 4));
+      ok = std::fwrite(zeros, 1, pad, f) == pad;
+    }
+    for (size_t s = 0; s < snap->segments.size() && ok; ++s) {
+      const Segment& seg = *snap->segments[s];
+      const std::vector<uint32_t>& skip = snap->skip[s];
+      size_t next_skip = 0;
+      for (size_t i = 0; i < seg.rows && ok; ++i) {
+        if (next_skip < skip.size() && skip[next_skip] == i) {
+          ++next_skip;
+          continue;
+        }
+        if (pass == 0) {
+          const uint32_t id = seg.rowId(i);
+          ok = std::fwrite(&id, sizeof(id), 1, f) == 1;
+        } else {
+          ok = std::fwrite(seg.vectors + i * snap->dim, sizeof(uint16_t), snap->dim, f) == snap->dim;
+        }
+      }
+    }
+  }
+  if (std::fclose(f) != 0) ok = false;
+  if (!ok || std::rename(tmp.c_str(), out_path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return setError(out_error, VectorIndexError::kWriteFailed);
+  }
+
+  std::shared_ptr<Segment> seg;
+  VectorIndexError err = VectorIndexError::kNone;
+  if (!mapSegment(out_path, snap->dim, 0, seg, &err)) return setError(out_error, err);
+  seg->name = "compacted";
+  auto next = std::make_shared<Snapshot>();
+  next->dim = snap->dim;
+  next->rows = seg->rows;
+  next->segments.push_back(std::move(seg));
+  next->skip.emplace_back();
+  next->compacted = true;
+  next->fingerprint = snap->fingerprint;
+  next->sq8_path = snap->sq8_path;
+  next->coarse = buildCoarse(*next, coarseSearch());
+  std::fprintf(stderr, "[Piper] vector index compacted: %zu segment(s), %zu tombstone(s) -> %u rows in %s\n",
+               snap->segments.size(), snap->tombstones, live, out_path.c_str());
+
+  std::lock_guard<std::mutex> lock(mu_);
+  if (snap_ == snap) snap_ = std::move(next);  // reopened meanwhile: keep the newer spec
+  return true;
+}
+
+VectorIndexStats SegmentedVectorIndex::stats() const {
+  VectorIndexStats s;
+  s.compacting = compacting_.load();
+  const auto snap = snapshot();
+  if (!snap) return s;
+  s.segments = snap->segments.size();
+  s.rows = snap->rows;
+  s.tombstones = snap->tombstones;
+  s.live_rows = snap->rows - snap->tombstones;
+  s.compacted = snap->compacted;
+  s.fingerprint = snap->fingerprint;
+  if (snap->coarse) {
+    s.coarse_prefix_dims = snap->coarse->prefix;
+    s.coarse_bytes = snap->coarse->bytes();
+    s.sq8 = snap->coarse->sq8;
+    s.sq8_table_rows = snap->coarse->table_rows;
+  }
+  return s;
+}
+
+SegmentedVectorIndex& sharedVectorIndex(const std::string& key) {
+  static std::mutex mu;
+  static std::map<std::string, std::unique_ptr<SegmentedVectorIndex>> indexes;
+  std::lock_guard<std::mutex> lock(mu);
+  auto& slot = indexes[key];
+  if (!slot) slot.reset(new SegmentedVectorIndex());
+  return *slot;
+}
+
+}  // namespace piper
@@ -0,0 +1,132 @@
+#ifndef VECTOR_INDEX_H
+#define VECTOR_INDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace piper {
+
+// Segmented, append-only L2 vector index over mmapped f16 rows. A pack ships a base segment (the existing
+// vectors.f16) and small delta segments: each adds rows with ids after every earlier segment and may
+// tombstone earlier rows. Search scans all segments, skips tombstoned rows and merges one top-k. compact()
+// folds everything into a single .vseg file keyed by the spec fingerprint, which open() then prefers.
+//
+// .vseg layout (little-endian): magic "PIPERVS1", u32 version, u32 dim, u32 rows, u32 reserved,
+// u64 source_fingerprint, u64 vectors_offset, u32 row_ids[rows] (ascending), pad to 16, f16 rows.
+
+enum class VectorIndexError {
+  kNone = 0,
+  kInvalidArgs,
+  kOpenFailed,
+  kBadFormat,
+  kDimMismatch,
+  kRowOverlap,
+  kWriteFailed,
+  kBusy,
+};
+
+const char* vectorIndexErrorString(VectorIndexError e);
+
+struct VectorSegmentSpec {
+  std::string name;
+  std::string vectors_path;     // raw f16 rows (vectors.f16) or a .vseg; empty for a tombstone-only delta
+  uint32_t first_row = 0;       // global id of the first row of a raw f16 file
+  std::string tombstones_path;  // optional: u32 ids of earlier rows this segment removes
+};
+
+struct VectorIndexSpec {
+  uint32_t dim = 0;
+  std::vector<VectorSegmentSpec> segments;  // in append order
+  std::string compacted_path;               // optional: used instead of segments when its fingerprint matches
+  std::string sq8_path;  // optional: pack-time vectors.sq8 of the base rows (vector_sq8.h); used by the sq8 scan
+};
+
+// Coarse-to-fine search for Matryoshka-style embeddings (leading dimensions carry most of the signal).
+// A coarse copy of every live row's first prefix_dims values, re-normalized to unit length, is scanned by
+// cosine; the best `candidates` rows are re-ranked with the full-dimension f16 L2 distance. int8 stores the
+// prefix with a per-dimension scale (a quarter of the f32 bytes). prefix_dims 0 (or >= dim) is the exact scan.
+// sq8 instead scans every dimension as scalar-quantized int8 (per-dimension scale and offset) with the CPU's
+// int8 dot-product instructions, taking the codes from the spec's sq8_path where they match; prefix_dims and
+// int8 are then ignored.
+struct CoarseSearchConfig {
+  uint32_t prefix_dims = 0;
+  uint32_t candidates = 64;  // raised to k when smaller
+  bool int8 = false;
+  bool sq8 = false;
+};
+
+struct VectorHit {
+  uint32_t row = 0;
+  float distance = 0.f;  // L2
+};
+
+struct VectorIndexStats {
+  size_t segments = 0;
+  size_t rows = 0;
+  size_t live_rows = 0;
+  size_t tombstones = 0;
+  bool compacted = false;
+  bool compacting = false;
+  uint64_t fingerprint = 0;
+  uint32_t coarse_prefix_dims = 0;  // 0 = exact scan (or sq8)
+  size_t coarse_bytes = 0;
+  bool sq8 = false;
+  size_t sq8_table_rows = 0;  // rows whose codes came from the pack-time table
+};
+
+class SegmentedVectorIndex {
+ public:
+  SegmentedVectorIndex() = default;
+  SegmentedVectorIndex(const SegmentedVectorIndex&) = delete;
+  SegmentedVectorIndex& operator=(const SegmentedVectorIndex&) = delete;
+
+  // Maps the spec's files. A spec with the current fingerprint is a no-op (keeps a compacted view).
+  // On failure the previous state is kept.
+  bool open(const VectorIndexSpec& spec, VectorIndexError* out_error = nullptr);
+  void close();
+
+  // Top-k live rows by L2 distance, nearest first. Empty if dim differs or nothing is open. Approximate when
+  // a coarse prefix or the sq8 scan is configured (distances of the returned rows are still exact).
+  std::vector<VectorHit> search(const float* query, size_t dim, size_t k) const;
+  // Exhaustive scan regardless of the coarse config (recall baseline).
+  std::vector<VectorHit> searchExact(const float* query, size_t dim, size_t k) const;
+
+  // Builds the coarse prefix for the open rows (and for every later open/compaction). Blocking: one pass
+  // over the rows.
+  void setCoarseSearch(const CoarseSearchConfig& config);
+  CoarseSearchConfig coarseSearch() const;
+
+  // Writes live rows to out_path (atomically via a temp file) and swaps the mapping in. Blocking; run it off
+  // the JS thread. kBusy if another compaction is running.
+  bool compact(const std::string& out_path, VectorIndexError* out_error = nullptr);
+
+  VectorIndexStats stats() const;
+
+ private:
+  struct Segment;
+  struct Coarse;
+  struct Snapshot;
+
+  std::shared_ptr<const Snapshot> snapshot() const;
+  static std::shared_ptr<const Coarse> buildCoarse(const Snapshot& snap, const CoarseSearchConfig& config);
+  static std::shared_ptr<const Coarse> buildSq8(const Snapshot& snap, const CoarseSearchConfig& config);
+  static bool mapSegment(const std::string& path, uint32_t dim, uint32_t first_row, std::shared_ptr<Segment>& out,
+                         VectorIndexError* err);
+
+  mutable std::mutex mu_;
+  std::shared_ptr<const Snapshot> snap_;
+  CoarseSearchConfig coarse_config_;
+  std::atomic<bool> compacting_{false};
+};
+
+// Process-wide indexes by key ("rules", "cards") used by the JSI bindings.
+SegmentedVectorIndex& sharedVectorIndex(const std::string& key);
+
+}  // namespace piper
+
+#endif  // VECTOR_INDEX_H
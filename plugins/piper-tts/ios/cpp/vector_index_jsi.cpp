@@ -0,0 +1,182 @@
+#include "vector_index_jsi.h"
+#include "vector_index.h"
+#include "vector_sq8.h"
+#include <jsi/jsi.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace piper {
+
+namespace jsi = facebook::jsi;
+
+namespace {
+
+struct FloatView {
+  const float* data = nullptr;
+  size_t size = 0;
+};
+
+// Reads a Float32Array (or a bare ArrayBuffer of float32) without copying.
+FloatView readFloat32(jsi::Runtime& rt, const jsi::Value& value, const char* fn) {
+  if (!value.isObject()) throw jsi::JSError(rt, std::string(fn) + ": expected Float32Array");
+  jsi::Object obj = value.getObject(rt);
+  if (obj.isArrayBuffer(rt)) {
+    jsi::ArrayBuffer buffer = obj.getArrayBuffer(rt);
+    return {reinterpret_cast<const float*>(buffer.data(rt)), buffer.size(rt) / sizeof(float)};
+  }
+  jsi::Value buffer_value = obj.getProperty(rt, "buffer");
+  if (!buffer_value.isObject() || !buffer_value.getObject(rt).isArrayBuffer(rt)) {
+    throw jsi::JSError(rt, std::string(fn) + ": expected Float32Array");
+  }
+  jsi::ArrayBuffer buffer = buffer_value.getObject(rt).getArrayBuffer(rt);
+  const size_t offset = static_cast<size_t>(obj.getProperty(rt, "byteOffset").asNumber());
+  const size_t length = static_cast<size_t>(obj.getProperty(rt, "length").asNumber());
+  if (offset % sizeof(float) != 0 || offset + length * sizeof(float) > buffer.size(rt)) {
+    throw jsi::JSError(rt, std::string(fn) + ": Float32Array out of range");
+  }
+  return {reinterpret_cast<const float*>(buffer.data(rt) + offset), length};
+}
+
+std::string stringProperty(jsi::Runtime& rt, const jsi::Object& obj, const char* name) {
+  jsi::Value v = obj.getProperty(rt, name);
+  return v.isString() ? v.getString(rt).utf8(rt) : std::string();
+}
+
+jsi::Object statsToJs(jsi::Runtime& rt, const VectorIndexStats& s) {
+  jsi::Object result(rt);
+  result.setProperty(rt, "segments", static_cast<double>(s.segments));
+  result.setProperty(rt, "rows", static_cast<double>(s.rows));
+  result.setProperty(rt, "liveRows", static_cast<double>(s.live_rows));
+  result.setProperty(rt, "tombstones", static_cast<double>(s.tombstones));
+  result.setProperty(rt, "compacted", s.compacted);
+  result.setProperty(rt, "compacting", s.compacting);
+  result.setProperty(rt, "coarsePrefixDims", static_cast<double>(s.coarse_prefix_dims));
+  result.setProperty(rt, "coarseBytes", static_cast<double>(s.coarse_bytes));
+  result.setProperty(rt, "sq8", s.sq8);
+  result.setProperty(rt, "sq8TableRows", static_cast<double>(s.sq8_table_rows));
+  result.setProperty(rt, "sq8Kernel", jsi::String::createFromAscii(rt, sq8KernelName()));
+  return result;
+}
+
+}  // namespace
+
+void installVectorIndexJsi(jsi::Runtime& runtime) {
+  auto open = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperVectorIndexOpen"), 2,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 2 || !args[0].isString() || !args[1].isObject()) {
+          throw jsi::JSError(rt, "__piperVectorIndexOpen(key, spec): expected string, object");
+        }
+        jsi::Object obj = args[1].getObject(rt);
+        VectorIndexSpec spec;
+        jsi::Value dim = obj.getProperty(rt, "dim");
+        if (dim.isNumber() && dim.getNumber() > 0) spec.dim = static_cast<uint32_t>(dim.getNumber());
+        spec.compacted_path = stringProperty(rt, obj, "compacted");
+        spec.sq8_path = stringProperty(rt, obj, "sq8");
+        jsi::Value segments = obj.getProperty(rt, "segments");
+        if (segments.isObject() && segments.getObject(rt).isArray(rt)) {
+          jsi::Array arr = segments.getObject(rt).getArray(rt);
+          for (size_t i = 0; i < arr.size(rt); ++i) {
+            jsi::Value item = arr.getValueAtIndex(rt, i);
+            if (!item.isObject()) continue;
+            jsi::Object seg = item.getObject(rt);
+            VectorSegmentSpec s;
+            s.name = stringProperty(rt, seg, "name");
+            s.vectors_path = stringProperty(rt, seg, "vectors");
+            s.tombstones_path = stringProperty(rt, seg, "tombstones");
+            jsi::Value first_row = seg.getProperty(rt, "firstRow");
+            if (first_row.isNumber() && first_row.getNumber() >= 0) {
+              s.first_row = static_cast<uint32_t>(first_row.getNumber());
+            }
+            spec.segments.push_back(std::move(s));
+          }
+        }
+        const std::string key = args[0].getString(rt).utf8(rt);
+        VectorIndexError err = VectorIndexError::kNone;
+        if (!sharedVectorIndex(key).open(spec, &err)) {
+          throw jsi::JSError(rt, "__piperVectorIndexOpen(" + key + "): " + vectorIndexErrorString(err));
+        }
+        return statsToJs(rt, sharedVectorIndex(key).stats());
+      });
+
+  auto search = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperVectorIndexSearch"), 3,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 3 || !args[0].isString() || !args[2].isNumber()) {
+          throw jsi::JSError(rt, "__piperVectorIndexSearch(key, query, k): expected string, Float32Array, number");
+        }
+        const FloatView q = readFloat32(rt, args[1], "__piperVectorIndexSearch");
+        const double k = args[2].getNumber();
+        const std::vector<VectorHit> hits =
+            sharedVectorIndex(args[0].getString(rt).utf8(rt)).search(q.data, q.size, k > 0 ? size_t(k) : 0);
+        jsi::Array result(rt, hits.size());
+        for (size_t i = 0; i < hits.size(); ++i) {
+          jsi::Object hit(rt);
+          hit.setProperty(rt, "rowId", static_cast<double>(hits[i].row));
+          hit.setProperty(rt, "score", static_cast<double>(hits[i].distance));
+          result.setValueAtIndex(rt, i, std::move(hit));
+        }
+        return result;
+      });
+
+  auto configure = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperVectorIndexConfigure"), 2,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 2 || !args[0].isString() || !args[1].isObject()) {
+          throw jsi::JSError(rt, "__piperVectorIndexConfigure(key, options): expected string, object");
+        }
+        jsi::Object obj = args[1].getObject(rt);
+        CoarseSearchConfig config;
+        jsi::Value prefix = obj.getProperty(rt, "prefixDims");
+        if (prefix.isNumber() && prefix.getNumber() > 0) config.prefix_dims = static_cast<uint32_t>(prefix.getNumber());
+        jsi::Value candidates = obj.getProperty(rt, "candidates");
+        if (candidates.isNumber() && candidates.getNumber() > 0) {
+          config.candidates = static_cast<uint32_t>(candidates.getNumber());
+        }
+        jsi::Value int8 = obj.getProperty(rt, "int8");
+        config.int8 = int8.isBool() && int8.getBool();
+        jsi::Value sq8 = obj.getProperty(rt, "sq8");
+        config.sq8 = sq8.isBool() && sq8.getBool();
+        SegmentedVectorIndex& index = sharedVectorIndex(args[0].getString(rt).utf8(rt));
+        index.setCoarseSearch(config);
+        return statsToJs(rt, index.stats());
+      });
+
+  auto compact = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperVectorIndexCompact"), 2,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 2 || !args[0].isString() || !args[1].isString()) {
+          throw jsi::JSError(rt, "__piperVectorIndexCompact(key, outPath): expected string, string");
+        }
+        std::string key = args[0].getString(rt).utf8(rt);
+        const VectorIndexStats s = sharedVectorIndex(key).stats();
+        if (s.segments == 0 || s.compacted || s.compacting) return false;
+        std::thread([key = std::move(key), path = args[1].getString(rt).utf8(rt)]() {
+          VectorIndexError err = VectorIndexError::kNone;
+          if (!sharedVectorIndex(key).compact(path, &err) && err != VectorIndexError::kBusy) {
+            std::fprintf(stderr, "[Piper] vector index %s compaction failed: %s\n", key.c_str(),
+                         vectorIndexErrorString(err));
+          }
+        }).detach();
+        return true;
+      });
+
+  auto stats = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__piperVectorIndexStats"), 1,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count < 1 || !args[0].isString()) return jsi::Value::null();
+        const VectorIndexStats s = sharedVectorIndex(args[0].getString(rt).utf8(rt)).stats();
+        if (s.segments == 0) return jsi::Value::null();
+        return statsToJs(rt, s);
+      });
+
+  runtime.global().setProperty(runtime, "__piperVectorIndexOpen", std::move(open));
+  runtime.global().setProperty(runtime, "__piperVectorIndexSearch", std::move(search));
+  runtime.global().setProperty(runtime, "__piperVectorIndexConfigure", std::move(configure));
+  runtime.global().setProperty(runtime, "__piperVectorIndexCompact", std::move(compact));
+  runtime.global().setProperty(runtime, "__piperVectorIndexStats", std::move(stats));
+}
+
+}  // namespace piper
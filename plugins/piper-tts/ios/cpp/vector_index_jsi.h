@@ -0,0 +1,23 @@
+#ifndef VECTOR_INDEX_JSI_H
+#define VECTOR_INDEX_JSI_H
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+}
+}  // namespace facebook
+
+namespace piper {
+
+// Install the segmented vector index host functions (sharedVectorIndex(key), synchronous on the JS thread
+// except compaction, which runs on a detached worker):
+//   __piperVectorIndexOpen(key, { dim, segments: [{ name, vectors?, firstRow?, tombstones? }], compacted? })
+//       -> stats; throws on a missing/invalid segment
+//   __piperVectorIndexSearch(key, query: Float32Array, k) -> [{ rowId, score }] nearest first (L2)
+//   __piperVectorIndexCompact(key, outPath) -> boolean (false when already compacted or compacting)
+//   __piperVectorIndexStats(key) -> { segments, rows, liveRows, tombstones, compacted, compacting }
+void installVectorIndexJsi(facebook::jsi::Runtime& runtime);
+
+}  // namespace piper
+
+#endif  // VECTOR_INDEX_JSI_H
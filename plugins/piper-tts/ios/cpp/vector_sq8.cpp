@@ -0,0 +1,387 @@
+#include "vector_sq8.h"
+#include "simd_f32.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__aarch64__) && defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace piper {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'I', 'P', 'E', 'R', 'S', 'Q', '8'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 64;
+
+using DotRowsFn = void (*)(const int8_t*, const int8_t*, size_t, size_t, int32_t*);
+
+void dotRowsScalar(const int8_t* q, const int8_t* rows, size_t n, size_t stride, int32_t* out) {
+  for (size_t r = 0; r < n; ++r) {
+    const int8_t* row = rows + r * stride;
+    int32_t sum = 0;
+    for (size_t i = 0; i < stride; ++i) sum += int32_t(q[i]) * int32_t(row[i]);
+    out[r] = sum;
+  }
+}
+
+#if defined(__aarch64__) && PIPER_SIMD_NEON
+// Widening multiply into 16-bit lanes (two products of |v| <= 127 cannot overflow), pairwise into 32-bit.
+void dotRowsNeon(const int8_t* q, const int8_t* rows, size_t n, size_t stride, int32_t* out) {
+  for (size_t r = 0; r < n; ++r) {
+    const int8_t* row = rows + r * stride;
+    int32x4_t acc0 = vdupq_n_s32(0), acc1 = vdupq_n_s32(0);
+    for (size_t i = 0; i < stride; i += 32) {
+      const int8x16_t a0 = vld1q_s8(q + i), b0 = vld1q_s8(row + i);
+      const int8x16_t a1 = vld1q_s8(q + i + 16), b1 = vld1q_s8(row + i + 16);
+      acc0 = vpadalq_s16(acc0, vmlal_high_s8(vmull_s8(vget_low_s8(a0), vget_low_s8(b0)), a0, b0));
+      acc1 = vpadalq_s16(acc1, vmlal_high_s8(vmull_s8(vget_low_s8(a1), vget_low_s8(b1)), a1, b1));
+    }
+    out[r] = vaddvq_s32(vaddq_s32(acc0, acc1));
+  }
+}
+
+// SDOT (ARMv8.2 dot product): four 4-byte dot products per instruction. Builds without +dotprod emit it
+// through the assembler and only run it after the runtime check below.
+inline int32x4_t sdot(int32x4_t acc, int8x16_t a, int8x16_t b) {
+#if defined(__ARM_FEATURE_DOTPROD)
+  return vdotq_s32(acc, a, b);
+#else
+  __asm__(".arch_extension dotprod\n\tsdot %0.4s, %1.16b, %2.16b" : "+w"(acc) : "w"(a), "w"(b));
+  return acc;
+#endif
+}
+
+void dotRowsSdot(const int8_t* q, const int8_t* rows, size_t n, size_t stride, int32_t* out) {
+  for (size_t r = 0; r < n; ++r) {
+    const int8_t* row = rows + r * stride;
+    int32x4_t acc0 = vdupq_n_s32(0), acc1 = vdupq_n_s32(0);
+    for (size_t i = 0; i < stride; i += 32) {
+      acc0 = sdot(acc0, vld1q_s8(q + i), vld1q_s8(row + i));
+      acc1 = sdot(acc1, vld1q_s8(q + i + 16), vld1q_s8(row + i + 16));
+    }
+    out[r] = vaddvq_s32(vaddq_s32(acc0, acc1));
+  }
+}
+
+bool cpuHasDotProd() {
+#if defined(__ARM_FEATURE_DOTPROD)
+  return true;
+#elif defined(__APPLE__)
+  int v = 0;
+  size_t len = sizeof(v);
+  return sysctlbyname("hw.optional.arm.FEAT_DotProd", &v, &len, nullptr, 0) == 0 && v != 0;
+#elif defined(__linux__)
+  return (getauxval(AT_HWCAP) & (1ul << 20)) != 0;  // HWCAP_ASIMDDP
+#else
+  return false;
+#endif
+}
+#endif
+
+#if PIPER_SIMD_SSE2
+// Sign-extend both sides to 16 bits (the query once per call) and multiply-add pairs into 32-bit lanes.
+void dotRowsSse2(const int8_t* q, const int8_t* rows, size_t n, size_t stride, int32_t* out) {
+  std::vector<int16_t> q16(q, q + stride);
+  for (size_t r = 0; r < n; ++r) {
+    const int8_t* row = rows + r * stride;
+    __m128i acc = _mm_setzero_si128();
+    for (size_t i = 0; i < stride; i += 16) {
+      const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q16.data() + i));
+      const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q16.data() + i + 8));
+      const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(a0, _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8)));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(a1, _mm_srai_epi16(_mm_unpackhi_epi8(b, b), 8)));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    out[r] = _mm_cvtsi128_si32(acc);
+  }
+}
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PIPER_SQ8_X86_DISPATCH 1
+
+__attribute__((target("avx2"))) inline int32_t hsum256(__m256i v) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+}
+
+// maddubs multiplies unsigned by signed bytes: feed it |q| and row * sign(q). Pair sums stay below
+// 2 * 127 * 127, so the 16-bit saturation never triggers.
+__attribute__((target("avx2"))) void dotRowsAvx2(const int8_t* q, const int8_t* rows, size_t n, size_t stride,
+                                                 int32_t* out) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  for (size_t r = 0; r < n; ++r) {
+    const int8_t* row = rows + r * stride;
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    for (size_t i = 0; i < stride; i += 64) {
+      const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i));
+      const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i + 32));
+      const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+      const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i + 32));
+      const __m256i p0 = _mm256_maddubs_epi16(_mm256_sign_epi8(a0, a0), _mm256_sign_epi8(b0, a0));
+      const __m256i p1 = _mm256_maddubs_epi16(_mm256_sign_epi8(a1, a1), _mm256_sign_epi8(b1, a1));
+      acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(p0, ones));
+      acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(p1, ones));
+    }
+    out[r] = hsum256(_mm256_add_epi32(acc0, acc1));
+  }
+}
+
+// VPDPBUSD (unsigned x signed bytes, 32-bit accumulate, no saturation): the row is biased to unsigned with
+// an xor of 0x80 (c + 128) and the 128 * sum(q) it adds is taken off once per row.
+__attribute__((target("avx2,avx512vl,avx512vnni"))) void dotRowsVnni(const int8_t* q, const int8_t* rows, size_t n,
+                                                                     size_t stride, int32_t* out) {
+  const __m256i bias = _mm256_set1_epi8(static_cast<char>(0x80));
+  int32_t q_sum = 0;
+  for (size_t i = 0; i < stride; ++i) q_sum += q[i];
+  const int32_t correction = 128 * q_sum;
+  for (size_t r = 0; r < n; ++r) {
+    const int8_t* row = rows + r * stride;
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    for (size_t i = 0; i < stride; i += 64) {
+      const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i));
+      const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i + 32));
+      const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+      const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i + 32));
+      acc0 = _mm256_dpbusd_epi32(acc0, _mm256_xor_si256(b0, bias), a0);
+      acc1 = _mm256_dpbusd_epi32(acc1, _mm256_xor_si256(b1, bias), a1);
+    }
+    out[r] = hsum256(_mm256_add_epi32(acc0, acc1)) - correction;
+  }
+}
+
+bool cpuHasAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+bool cpuHasVnni() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("avx512vl") &&
+         __builtin_cpu_supports("avx512vnni");
+}
+#endif
+
+bool always() { return true; }
+
+struct Kernel {
+  const char* name;
+  DotRowsFn fn;
+  bool (*available)();
+};
+
+// Best first.
+const Kernel kKernels[] = {
+#if defined(__aarch64__) && PIPER_SIMD_NEON
+    {"sdot", dotRowsSdot, cpuHasDotProd},
+    {"neon", dotRowsNeon, always},
+#endif
+#ifdef PIPER_SQ8_X86_DISPATCH
+    {"vnni", dotRowsVnni, cpuHasVnni},
+    {"avx2", dotRowsAvx2, cpuHasAvx2},
+#endif
+#if PIPER_SIMD_SSE2
+    {"sse2", dotRowsSse2, always},
+#endif
+    {"scalar", dotRowsScalar, always},
+};
+
+std::atomic<const Kernel*>& activeKernel() {
+  static std::atomic<const Kernel*> active{[] {
+    for (const Kernel& k : kKernels) {
+      if (k.available()) return &k;
+    }
+    return &kKernels[0];
+  }()};
+  return active;
+}
+
+}  // namespace
+
+float halfToFloat(uint16_t h) {
+  const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+  uint32_t exp = (h >> 10) & 0x1fu;
+  uint32_t mant = h & 0x3ffu;
+  uint32_t bits;
+  if (exp == 0) {
+    if (mant == 0) {
+      bits = sign;
+    } else {
+      exp = 113;
+      while (!(mant & 0x400u)) {
+        mant <<= 1;
+        --exp;
+      }
+      bits = sign | (exp << 23) | ((mant & 0x3ffu) << 13);
+    }
+  } else if (exp == 31) {
+    bits = sign | 0x7f800000u | (mant << 13);
+  } else {
+    bits = sign | ((exp + 112) << 23) | (mant << 13);
+  }
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+void sq8Fit(const uint16_t* const* rows, size_t n, size_t dim, std::vector<float>& scale, std::vector<float>& offset) {
+  std::vector<float> lo(dim, INFINITY), hi(dim, -INFINITY);
+  for (size_t r = 0; r < n; ++r) {
+    const uint16_t* row = rows[r];
+    for (size_t d = 0; d < dim; ++d) {
+      const float v = halfToFloat(row[d]);
+      lo[d] = std::min(lo[d], v);
+      hi[d] = std::max(hi[d], v);
+    }
+  }
+  scale.assign(dim, 1.f);
+  offset.assign(dim, 0.f);
+  for (size_t d = 0; d < dim && n > 0; ++d) {
+    offset[d] = 0.5f * (lo[d] + hi[d]);
+    if (hi[d] > lo[d]) scale[d] = (hi[d] - lo[d]) / 254.f;
+  }
+}
+
+float sq8Encode(const uint16_t* row, size_t dim, size_t stride, const float* scale, const float* offset,
+                int8_t* out) {
+  float norm = 0.f;
+  for (size_t d = 0; d < dim; ++d) {
+    const float c = std::max(-127.f, std::min(127.f, std::round((halfToFloat(row[d]) - offset[d]) / scale[d])));
+    out[d] = static_cast<int8_t>(c);
+    const float v = offset[d] + scale[d] * c;
+    norm += v * v;
+  }
+  std::memset(out + dim, 0, stride - dim);
+  return norm;
+}
+
+bool sq8WriteFile(const std::string& path, const uint16_t* rows, size_t n, size_t dim, std::string* error) {
+  auto fail = [error](const char* msg) {
+    if (error) *error = msg;
+    return false;
+  };
+  if (!rows || n == 0 || dim == 0 || n > UINT32_MAX) return fail("no rows");
+  const size_t stride = sq8Stride(dim);
+  std::vector<const uint16_t*> row_ptrs(n);
+  for (size_t r = 0; r < n; ++r) row_ptrs[r] = rows + r * dim;
+  std::vector<float> params, offset;
+  sq8Fit(row_ptrs.data(), n, dim, params, offset);
+  params.insert(params.end(), offset.begin(), offset.end());
+  std::vector<float> norms(n);
+  std::vector<int8_t> codes(n * stride);
+  for (size_t r = 0; r < n; ++r) {
+    norms[r] = sq8Encode(rows + r * dim, dim, stride, params.data(), params.data() + dim, codes.data() + r * stride);
+  }
+
+  const uint64_t params_offset = kHeaderSize;
+  const uint64_t norms_offset = params_offset + params.size() * sizeof(float);
+  const uint64_t codes_offset = (norms_offset + n * sizeof(float) + kSq8Align - 1) / kSq8Align * kSq8Align;
+  unsigned char header[kHeaderSize] = {};
+  std::memcpy(header, kMagic, sizeof(kMagic));
+  const uint32_t header_u32[4] = {kVersion, static_cast<uint32_t>(dim), static_cast<uint32_t>(n),
+                                  static_cast<uint32_t>(stride)};
+  const uint64_t header_u64[3] = {params_offset, norms_offset, codes_offset};
+  std::memcpy(header + 8, header_u32, sizeof(header_u32));
+  std::memcpy(header + 24, header_u64, sizeof(header_u64));
+
+  const std::string tmp = path + ".tmp";
+  FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) return fail("cannot create file");
+  const unsigned char zeros[kSq8Align] = {};
+  const size_t pad = static_cast<size_t>(codes_offset - (norms_offset + n * sizeof(float)));
+  bool ok = std::fwrite(header, 1, sizeof(header), f) == sizeof(header);
+  ok = ok && std::fwrite(params.data(), sizeof(float), params.size(), f) == params.size();
+  ok = ok && std::fwrite(norms.data(), sizeof(float), n, f) == n;
+  ok = ok && std::fwrite(zeros, 1, pad, f) == pad;
+  ok = ok && std::fwrite(codes.data(), 1, codes.size(), f) == codes.size();
+  if (std::fclose(f) != 0) ok = false;
+  if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return fail("write failed");
+  }
+  return true;
+}
+
+Sq8File::~Sq8File() {
+  if (map_) munmap(map_, map_size_);
+}
+
+bool Sq8File::open(const std::string& path, uint32_t dim, std::string* error) {
+  auto fail = [error](const char* msg) {
+    if (error) *error = msg;
+    return false;
+  };
+  if (map_) return fail("already open");
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return fail("cannot open file");
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+    ::close(fd);
+    return fail("file too small");
+  }
+  void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) return fail("mmap failed");
+  map_ = map;
+  map_size_ = static_cast<size_t>(st.st_size);
+  const unsigned char* base = static_cast<const unsigned char*>(map);
+
+  uint32_t header_u32[4];
+  uint64_t header_u64[3];
+  std::memcpy(header_u32, base + 8, sizeof(header_u32));
+  std::memcpy(header_u64, base + 24, sizeof(header_u64));
+  const uint32_t rows = header_u32[2], stride = header_u32[3];
+  const uint64_t params_offset = header_u64[0], norms_offset = header_u64[1], codes_offset = header_u64[2];
+  bool valid = std::memcmp(base, kMagic, sizeof(kMagic)) == 0 && header_u32[0] == kVersion;
+  valid = valid && header_u32[1] == dim && stride == sq8Stride(dim) && rows > 0;
+  valid = valid && params_offset % 4 == 0 && params_offset + uint64_t(dim) * 8 <= norms_offset &&
+          norms_offset % 4 == 0 && norms_offset + uint64_t(rows) * 4 <= codes_offset &&
+          codes_offset % kSq8Align == 0 && codes_offset + uint64_t(rows) * stride <= map_size_;
+  if (!valid) {
+    munmap(map_, map_size_);
+    map_ = nullptr;
+    return fail(header_u32[1] != dim ? "dim mismatch" : "bad header");
+  }
+  dim_ = dim;
+  rows_ = rows;
+  stride_ = stride;
+  scale_ = reinterpret_cast<const float*>(base + params_offset);
+  norms_ = reinterpret_cast<const float*>(base + norms_offset);
+  codes_ = reinterpret_cast<const int8_t*>(base + codes_offset);
+  return true;
+}
+
+void sq8DotRows(const int8_t* q, const int8_t* rows, size_t n, size_t stride, int32_t* out) {
+  activeKernel().load(std::memory_order_relaxed)->fn(q, rows, n, stride, out);
+}
+
+const char* sq8KernelName() { return activeKernel().load(std::memory_order_relaxed)->name; }
+
+bool sq8SetKernel(const std::string& name) {
+  for (const Kernel& k : kKernels) {
+    if (name == k.name && k.available()) {
+      activeKernel().store(&k);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace piper
@@ -0,0 +1,80 @@
+#ifndef VECTOR_SQ8_H
+#define VECTOR_SQ8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace piper {
+
+// Scalar-quantized (SQ8) copy of f16 embedding rows for the vector index's int8 scan. Each dimension d gets
+// an offset (midpoint of its range) and a scale, and a value x is stored as the int8 code
+// round((x - offset[d]) / scale[d]) in [-127, 127]. Rows are padded with zero codes to a 64-byte stride so
+// the dot-product kernels need no tail handling.
+//
+// vectors.sq8 (built next to vectors.f16 by host/pack_compile --sq8; little-endian): 64-byte header
+// { magic "PIPERSQ8", u32 version, u32 dim, u32 rows, u32 stride, u64 params_offset, u64 norms_offset,
+// u64 codes_offset, pad }, f32 scale[dim], f32 offset[dim], f32 norms[rows] (squared length of each
+// dequantized row), then int8 codes[rows][stride] starting on a 64-byte boundary. Row i is global row id i
+// of the base segment.
+
+constexpr size_t kSq8Align = 64;
+
+inline size_t sq8Stride(size_t dim) { return (dim + kSq8Align - 1) / kSq8Align * kSq8Align; }
+
+float halfToFloat(uint16_t h);
+
+// Per-dimension offset/scale covering every value of the n f16 rows (each dim long).
+void sq8Fit(const uint16_t* const* rows, size_t n, size_t dim, std::vector<float>& scale, std::vector<float>& offset);
+
+// Encodes one f16 row into stride codes (zero padded; out of range values clamp). Returns the squared
+// length of the dequantized row.
+float sq8Encode(const uint16_t* row, size_t dim, size_t stride, const float* scale, const float* offset,
+                int8_t* out);
+
+// Fits and writes a vectors.sq8 for rows[n][dim] (atomically via a temp file).
+bool sq8WriteFile(const std::string& path, const uint16_t* rows, size_t n, size_t dim, std::string* error = nullptr);
+
+// Read-only mapping of a vectors.sq8.
+class Sq8File {
+ public:
+  Sq8File() = default;
+  ~Sq8File();
+  Sq8File(const Sq8File&) = delete;
+  Sq8File& operator=(const Sq8File&) = delete;
+
+  // False when the file is missing, malformed or has another dim.
+  bool open(const std::string& path, uint32_t dim, std::string* error = nullptr);
+
+  uint32_t dim() const { return dim_; }
+  uint32_t rows() const { return rows_; }
+  uint32_t stride() const { return stride_; }
+  const float* scale() const { return scale_; }
+  const float* offset() const { return scale_ + dim_; }
+  const float* norms() const { return norms_; }
+  const int8_t* codes(uint32_t row) const { return codes_ + size_t(row) * stride_; }
+
+ private:
+  void* map_ = nullptr;
+  size_t map_size_ = 0;
+  uint32_t dim_ = 0;
+  uint32_t rows_ = 0;
+  uint32_t stride_ = 0;
+  const float* scale_ = nullptr;
+  const float* norms_ = nullptr;
+  const int8_t* codes_ = nullptr;
+};
+
+// out[r] = dot(q, rows + r * stride) over stride int8 values (a multiple of kSq8Align, all in [-127, 127]).
+// The kernel is picked once per process from what the CPU supports: arm64 SDOT, x86 AVX512-VNNI or AVX2,
+// then plain NEON / SSE2 / scalar.
+void sq8DotRows(const int8_t* q, const int8_t* rows, size_t n, size_t stride, int32_t* out);
+const char* sq8KernelName();
+// Forces a kernel by name ("sdot", "neon", "vnni", "avx2", "sse2", "scalar") for benchmarks; false (and no
+// change) when it is not available on this CPU.
+bool sq8SetKernel(const std::string& name);
+
+}  // namespace piper
+
+#endif  // VECTOR_SQ8_H
@@ -0,0 +1,285 @@
+#include "wordpiece_tokenizer.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace piper {
+
+namespace {
+
+// BERT caps a single whitespace/punctuation-delimited word; longer words map to [UNK].
+constexpr size_t kMaxCharsPerWord = 100;
+
+uint64_t fnv1a(const char* s, size_t n, bool continuation) {
+  uint64_t h = continuation ? 0x84222325cbf29ce4ULL : 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < n; i++) {
+    h ^= static_cast<unsigned char>(s[i]);
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// Decode one UTF-8 codepoint at s[i]; returns byte length (1 on invalid input, cp = U+FFFD).
+size_t decodeUtf8(const unsigned char* s, size_t n, size_t i, uint32_t& cp) {
+  const unsigned char c = s[i];
+  size_t len = 1;
+  if (c < 0x80) {
+    cp = c;
+    return 1;
+  } else if ((c & 0xE0) == 0xC0) {
+    cp = c & 0x1F;
+    len = 2;
+  } else if ((c & 0xF0) == 0xE0) {
+    cp = c & 0x0F;
+    len = 3;
+  } else if ((c & 0xF8) == 0xF0) {
+    cp = c & 0x07;
+    len = 4;
+  } else {
+    cp = 0xFFFD;
+    return 1;
+  }
+  if (i + len > n) {
+    cp = 0xFFFD;
+    return 1;
+  }
+  for (size_t k = 1; k < len; k++) {
+    if ((s[i + k] & 0xC0) != 0x80) {
+      cp = 0xFFFD;
+      return 1;
+    }
+    cp = (cp << 6) | (s[i + k] & 0x3F);
+  }
+  return len;
+}
+
+void appendUtf8(uint32_t cp, std::string& out) {
+  if (cp < 0x80) {
+    out.push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else if (cp < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+}
+
+bool isWhitespace(uint32_t cp) {
+  return cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r' || cp == 0xA0 || cp == 0x1680 ||
+         (cp >= 0x2000 && cp <= 0x200A) || cp == 0x2028 || cp == 0x2029 || cp == 0x202F ||
+         cp == 0x205F || cp == 0x3000;
+}
+
+bool isControl(uint32_t cp) {
+  if (cp == '\t' || cp == '\n' || cp == '\r') return false;
+  return cp == 0 || cp < 0x20 || (cp >= 0x7F && cp <= 0x9F) || cp == 0xFFFD ||
+         (cp >= 0x200B && cp <= 0x200F) || cp == 0xFEFF;
+}
+
+bool isPunctuation(uint32_t cp) {
+  if ((cp >= 33 && cp <= 47) || (cp >= 58 && cp <= 64) || (cp >= 91 && cp <= 96) || (cp >= 123 && cp <= 126))
+    return true;
+  return cp == 0xA1 || cp == 0xA7 || cp == 0xAB || cp == 0xB6 || cp == 0xB7 || cp == 0xBB || cp == 0xBF ||
+         (cp >= 0x2010 && cp <= 0x2027) || (cp >= 0x2030 && cp <= 0x205E) ||
+         (cp >= 0x3001 && cp <= 0x303F) || (cp >= 0xFF01 && cp <= 0xFF0F) ||
+         (cp >= 0xFF1A && cp <= 0xFF20) || (cp >= 0xFF3B && cp <= 0xFF40) || (cp >= 0xFF5B && cp <= 0xFF65);
+}
+
+bool isCjk(uint32_t cp) {
+  return (cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0x3400 && cp <= 0x4DBF) || (cp >= 0x20000 && cp <= 0x2A6DF) ||
+         (cp >= 0x2A700 && cp <= 0x2CEAF) || (cp >= 0xF900 && cp <= 0xFAFF) || (cp >= 0x2F800 && cp <= 0x2FA1F);
+}
+
+// Lowercase + accent strip for ASCII and Latin-1 (what uncased BERT gets from NFD + drop Mn).
+// Indexed by cp - 0xC0; 0 keeps the codepoint as-is.
+constexpr std::array<char16_t, 64> kLatin1Fold = {
+    u'a', u'a', u'a', u'a', u'a', u'a', 0xE6, u'c', u'e', u'e', u'e', u'e', u'i', u'i', u'i', u'i',
+    0xF0, u'n', u'o', u'o', u'o', u'o', u'o', 0,    0xF8, u'u', u'u', u'u', u'u', u'y', 0xFE, 0,
+    u'a', u'a', u'a', u'a', u'a', u'a', 0,    u'c', u'e', u'e', u'e', u'e', u'i', u'i', u'i', u'i',
+    0,    u'n', u'o', u'o', u'o', u'o', u'o', 0,    0,    u'u', u'u', u'u', u'u', u'y', 0,    u'y',
+};
+
+uint32_t foldCase(uint32_t cp) {
+  if (cp >= 'A' && cp <= 'Z') return cp + 32;
+  if (cp >= 0xC0 && cp <= 0xFF) {
+    const char16_t folded = kLatin1Fold[cp - 0xC0];
+    return folded ? folded : cp;
+  }
+  if (cp >= 0x391 && cp <= 0x3A9 && cp != 0x3A2) return cp + 32;  // Greek capitals
+  if (cp >= 0x410 && cp <= 0x42F) return cp + 32;                  // Cyrillic capitals
+  return cp;
+}
+
+bool isCombiningMark(uint32_t cp) {
+  return (cp >= 0x300 && cp <= 0x36F) || (cp >= 0x1AB0 && cp <= 0x1AFF) || (cp >= 0x1DC0 && cp <= 0x1DFF) ||
+         (cp >= 0x20D0 && cp <= 0x20FF) || (cp >= 0xFE20 && cp <= 0xFE2F);
+}
+
+}  // namespace
+
+bool WordPieceTokenizer::load(const std::string& vocab_path) {
+  std::ifstream in(vocab_path, std::ios::binary);
+  if (!in) {
+    std::fprintf(stderr, "[Piper] WordPiece: cannot open vocab %s\n", vocab_path.c_str());
+    return false;
+  }
+  std::vector<std::string> lines;
+  std::string line;
+  size_t total_bytes = 0;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    total_bytes += line.size();
+    lines.push_back(std::move(line));
+  }
+
+  size_t capacity = 16;
+  while (capacity < lines.size() * 2) capacity <<= 1;
+  slots_.assign(capacity, Slot{});
+  mask_ = capacity - 1;
+  count_ = 0;
+  blob_.clear();
+  blob_.reserve(total_bytes);
+  cls_id_ = sep_id_ = unk_id_ = -1;
+
+  for (size_t id = 0; id < lines.size(); id++) {
+    const std::string& tok = lines[id];
+    if (tok.empty()) continue;
+    const bool cont = tok.size() > 2 && tok[0] == '#' && tok[1] == '#';
+    if (cont) {
+      insert(tok.data() + 2, tok.size() - 2, true, static_cast<int32_t>(id));
+    } else {
+      insert(tok.data(), tok.size(), false, static_cast<int32_t>(id));
+    }
+    if (tok == "[CLS]") cls_id_ = static_cast<int64_t>(id);
+    else if (tok == "[SEP]") sep_id_ = static_cast<int64_t>(id);
+    else if (tok == "[UNK]") unk_id_ = static_cast<int64_t>(id);
+  }
+
+  if (cls_id_ < 0 || sep_id_ < 0 || unk_id_ < 0) {
+    std::fprintf(stderr, "[Piper] WordPiece: vocab %s missing [CLS]/[SEP]/[UNK]\n", vocab_path.c_str());
+    slots_.clear();
+    return false;
+  }
+  path_ = vocab_path;
+  return true;
+}
+
+void WordPieceTokenizer::insert(const char* s, size_t n, bool continuation, int32_t id) {
+  const uint64_t h = fnv1a(s, n, continuation);
+  size_t i = static_cast<size_t>(h) & mask_;
+  while (slots_[i].id >= 0) {
+    const Slot& slot = slots_[i];
+    if (slot.hash == h && slot.continuation == continuation && slot.length == n &&
+        std::memcmp(blob_.data() + slot.offset, s, n) == 0)
+      return;  // duplicate line: first id wins, like HF
+    i = (i + 1) & mask_;
+  }
+  Slot& slot = slots_[i];
+  slot.hash = h;
+  slot.offset = static_cast<uint32_t>(blob_.size());
+  slot.length = static_cast<uint32_t>(n);
+  slot.id = id;
+  slot.continuation = continuation;
+  blob_.append(s, n);
+  count_++;
+}
+
+int32_t WordPieceTokenizer::lookup(const char* s, size_t n, bool continuation) const {
+  const uint64_t h = fnv1a(s, n, continuation);
+  size_t i = static_cast<size_t>(h) & mask_;
+  while (slots_[i].id >= 0) {
+    const Slot& slot = slots_[i];
+    if (slot.hash == h && slot.continuation == continuation && slot.length == n &&
+        std::memcmp(blob_.data() + slot.offset, s, n) == 0)
+      return slot.id;
+    i = (i + 1) & mask_;
+  }
+  return -1;
+}
+
+void WordPieceTokenizer::appendWord(const std::string& word, size_t max_ids, std::vector<int64_t>& ids) const {
+  if (word.empty() || ids.size() >= max_ids) return;
+
+  // Codepoint boundaries so subword candidates never split a UTF-8 sequence.
+  std::array<uint16_t, kMaxCharsPerWord + 1> bounds;
+  size_t nb = 0;
+  const auto* bytes = reinterpret_cast<const unsigned char*>(word.data());
+  for (size_t i = 0; i < word.size();) {
+    if (nb == kMaxCharsPerWord) {
+      ids.push_back(unk_id_);
+      return;
+    }
+    bounds[nb++] = static_cast<uint16_t>(i);
+    uint32_t cp;
+    i += decodeUtf8(bytes, word.size(), i, cp);
+  }
+  bounds[nb] = static_cast<uint16_t>(word.size());
+
+  const size_t mark = ids.size();
+  size_t start = 0;
+  while (start < nb) {
+    int32_t found = -1;
+    size_t end = nb;
+    for (; end > start; end--) {
+      found = lookup(word.data() + bounds[start], bounds[end] - bounds[start], start > 0);
+      if (found >= 0) break;
+    }
+    if (found < 0) {
+      ids.resize(mark);
+      ids.push_back(unk_id_);
+      return;
+    }
+    if (ids.size() >= max_ids) return;
+    ids.push_back(found);
+    start = end;
+  }
+}
+
+void WordPieceTokenizer::encode(const std::string& text, size_t max_tokens, std::vector<int64_t>& ids_out) const {
+  ids_out.clear();
+  if (!loaded()) return;
+  if (max_tokens < 2) max_tokens = 2;
+  const size_t max_body = max_tokens - 1;  // room for [SEP]
+  ids_out.reserve(max_tokens);
+  ids_out.push_back(cls_id_);
+
+  std::string word;
+  word.reserve(64);
+  const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+  const size_t n = text.size();
+  for (size_t i = 0; i < n && ids_out.size() < max_body;) {
+    uint32_t cp;
+    i += decodeUtf8(bytes, n, i, cp);
+    if (isControl(cp)) continue;
+    if (isWhitespace(cp)) {
+      appendWord(word, max_body, ids_out);
+      word.clear();
+      continue;
+    }
+    if (lowercase_) {
+      if (isCombiningMark(cp)) continue;
+      cp = foldCase(cp);
+    }
+    if (isPunctuation(cp) || isCjk(cp)) {
+      appendWord(word, max_body, ids_out);
+      word.clear();
+      appendUtf8(cp, word);
+      appendWord(word, max_body, ids_out);
+      word.clear();
+      continue;
+    }
+    appendUtf8(cp, word);
+  }
+  appendWord(word, max_body, ids_out);
+  ids_out.push_back(sep_id_);
+}
+
+}  // namespace piper
@@ -0,0 +1,59 @@
+#ifndef WORDPIECE_TOKENIZER_H
+#define WORDPIECE_TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace piper {
+
+// BERT-style WordPiece tokenizer over a vocab.txt (one token per line, id = line number).
+// Basic tokenization (whitespace/punctuation/CJK split, lowercase + Latin accent strip) and
+// greedy longest-match-first subwords. Vocab lives in one string blob with an open-addressing
+// index so encoding does no per-token allocation.
+class WordPieceTokenizer {
+ public:
+  // Load vocab.txt. Returns false if the file is missing or lacks [CLS]/[SEP]/[UNK].
+  bool load(const std::string& vocab_path);
+  bool loaded() const { return !slots_.empty(); }
+  const std::string& path() const { return path_; }
+
+  // Encode "[CLS] text [SEP]" into ids_out (cleared first), truncated to max_tokens (>= 2).
+  void encode(const std::string& text, size_t max_tokens, std::vector<int64_t>& ids_out) const;
+
+  // When false, input case and accents are preserved (cased vocabularies).
+  void setLowercase(bool lowercase) { lowercase_ = lowercase; }
+
+  int64_t clsId() const { return cls_id_; }
+  int64_t sepId() const { return sep_id_; }
+  int64_t unkId() const { return unk_id_; }
+  size_t vocabSize() const { return count_; }
+
+ private:
+  struct Slot {
+    uint64_t hash = 0;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+    int32_t id = -1;
+    bool continuation = false;  // "##" subword; key stored without the prefix
+  };
+
+  void insert(const char* s, size_t n, bool continuation, int32_t id);
+  int32_t lookup(const char* s, size_t n, bool continuation) const;
+  void appendWord(const std::string& word, size_t max_ids, std::vector<int64_t>& ids) const;
+
+  std::string path_;
+  std::string blob_;
+  std::vector<Slot> slots_;
+  size_t mask_ = 0;
+  size_t count_ = 0;
+  bool lowercase_ = true;
+  int64_t cls_id_ = -1;
+  int64_t sep_id_ = -1;
+  int64_t unk_id_ = -1;
+};
+
+}  // namespace piper
+
+#endif  // WORDPIECE_TOKENIZER_H
@@ -14,9 +14,16 @@ export interface Spec extends TurboModule {
   stop(): void;
   /** Copy Piper model from app assets to files dir (Android). Resolves with path or rejects. */
   copyModelToFiles(): Promise<string>;
+  /**
+   * Incremental sync of the bundled RAG pack into the app's writable dir (pack_files.json hashes).
+   * Resolves with the destination path; rejects E_NO_PACK_MANIFEST or E_PACK_SYNC.
+   */
+  syncContentPack(): Promise<string>;
   speak(text: string): Promise<void>;
   isModelAvailable(): Promise<boolean>;
   getDebugInfo(): Promise<string>;
+  /** Install JSI host functions (global.__piperEmbed, __piperAsr*). iOS installs on module creation; Android installs here. */
+  installJsi(): boolean;
 }
 
 export default TurboModuleRegistry.get<Spec>('PiperTts');
@@ -0,0 +1,104 @@
+/**
+ * Streaming on-device ASR (CTC ONNX model on the shared ORT env) via JSI.
+ * Feed mono int16 PCM as it arrives; each feed returns the current partial hypothesis. Feeds are 16 kHz
+ * unless asrStart gets front-end options, in which case device-rate mic PCM is resampled and cleaned natively.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+export type AsrModelPaths = {
+  /** CTC acoustic model (.onnx). */
+  modelPath: string;
+  /** tokens.txt ("<token> <id>" or one token per line). */
+  tokensPath: string;
+  /** asr_config.json (feature front-end + chunking). */
+  configPath: string;
+};
+
+export type AsrFinalResult = {
+  text: string;
+  audioSec: number;
+  featureSec: number;
+  inferenceSec: number;
+  /** (featureSec + inferenceSec) / audioSec. */
+  rtf: number;
+  /** Audio consumed when the first non-empty partial appeared (-1 if none). */
+  firstPartialAudioSec: number;
+  /** Present when the utterance ran through the capture front-end. */
+  frontEnd?: AsrFrontEndStats;
+};
+
+/**
+ * Native capture front-end for device-rate mic PCM (ios/cpp/capture_frontend.h): polyphase resampling to
+ * 16 kHz, high-pass, spectral noise suppression and AGC, on 10 ms frames. Starting again with the same
+ * options keeps the AGC gain and noise estimate of the previous utterance.
+ */
+export type AsrFrontEndOptions = {
+  /** Rate of the PCM passed to asrFeed (e.g. 44100, 48000). Default: the model rate. */
+  inputSampleRate?: number;
+  /** High-pass corner (default 80); 0 = off. */
+  highPassHz?: number;
+  /** Default true. */
+  noiseSuppression?: boolean;
+  /** Default true. */
+  agc?: boolean;
+  /** Speech level the AGC steers to (default -20). */
+  agcTargetDbfs?: number;
+};
+
+export type AsrFrontEndStats = {
+  /** 10 ms output frames processed. */
+  frames: number;
+  /** Processing cost per 10 ms frame (resampling included). */
+  meanFrameUs: number;
+  maxFrameUs: number;
+  agcGainDb: number;
+  /** Suppressor's noise floor estimate. */
+  noiseDbfs: number;
+  speechFrames: number;
+};
+
+type StartFn = (
+  modelPath: string,
+  tokensPath: string,
+  configPath: string,
+  options?: AsrFrontEndOptions,
+) => boolean;
+type FeedFn = (pcm16: ArrayBuffer) => string;
+type FinishFn = () => AsrFinalResult;
+
+const ASR_MISSING_MSG =
+  'PiperTts JSI ASR not installed. Rebuild the app with the piper-tts native module.';
+
+function requireFn<T>(name: string): T {
+  const fn = getPiperJsiFunction<T>(name);
+  if (fn == null) throw new Error(ASR_MISSING_MSG);
+  return fn;
+}
+
+export function isNativeAsrAvailable(): boolean {
+  return getPiperJsiFunction<StartFn>('__piperAsrStart') != null;
+}
+
+/**
+ * Begin a new utterance (loads the model on first use or when the path changes). With `frontEnd`, feeds are
+ * device-rate mic PCM; throws if the rate is unsupported.
+ */
+export function asrStart(paths: AsrModelPaths, frontEnd?: AsrFrontEndOptions): void {
+  const start = requireFn<StartFn>('__piperAsrStart');
+  if (frontEnd) start(paths.modelPath, paths.tokensPath, paths.configPath, frontEnd);
+  else start(paths.modelPath, paths.tokensPath, paths.configPath);
+}
+
+/** Feed PCM (mono int16; 16 kHz unless started with front-end options); returns the partial hypothesis so far. */
+export function asrFeed(pcm16: Int16Array): string {
+  const buffer =
+    pcm16.byteOffset === 0 && pcm16.byteLength === pcm16.buffer.byteLength
+      ? (pcm16.buffer as ArrayBuffer)
+      : (pcm16.slice().buffer as ArrayBuffer);
+  return requireFn<FeedFn>('__piperAsrFeed')(buffer);
+}
+
+/** Flush and decode the rest of the utterance. */
+export function asrFinish(): AsrFinalResult {
+  return requireFn<FinishFn>('__piperAsrFinish')();
+}
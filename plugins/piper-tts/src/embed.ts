@@ -0,0 +1,48 @@
+/**
+ * On-device query embedding via the shared ONNX Runtime env (JSI, synchronous).
+ * Model: BERT-family sentence encoder exported to ONNX with a WordPiece vocab.txt.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+export type EmbedOptions = {
+  /** Prepended before tokenization (e.g. "search_query: " for nomic-embed). */
+  queryPrefix?: string;
+  /** Token budget including [CLS]/[SEP]; default 256. */
+  maxTokens?: number;
+  /** L2-normalize the pooled vector (default true). */
+  normalize?: boolean;
+  /** Lowercase + strip accents before WordPiece (default true, uncased vocab). */
+  lowercase?: boolean;
+};
+
+type EmbedFn = (
+  modelPath: string,
+  vocabPath: string,
+  text: string,
+  options?: EmbedOptions,
+) => Float32Array;
+
+function getEmbedFn(): EmbedFn | null {
+  return getPiperJsiFunction<EmbedFn>('__piperEmbed');
+}
+
+/** True when the native embedder is linked and its JSI binding is installed (installs on first call). */
+export function isNativeEmbedAvailable(): boolean {
+  return getEmbedFn() != null;
+}
+
+/** Embed text natively. Throws when the binding is missing or the model/vocab fail to load. */
+export function embedText(
+  modelPath: string,
+  vocabPath: string,
+  text: string,
+  options?: EmbedOptions,
+): Float32Array {
+  const fn = getEmbedFn();
+  if (fn == null) {
+    throw new Error(
+      'PiperTts JSI embedder not installed. Rebuild the app with the piper-tts native module.',
+    );
+  }
+  return fn(modelPath, vocabPath, text, options);
+}
@@ -23,6 +23,56 @@ function emit(event: PluginEventPayload): void {
 
 export type { PiperErrorCode, PiperPluginError } from './errors';
 export { toPiperError } from './errors';
+export type { EmbedOptions } from './embed';
+export { embedText, isNativeEmbedAvailable } from './embed';
+export type {
+  AsrFinalResult,
+  AsrFrontEndOptions,
+  AsrFrontEndStats,
+  AsrModelPaths,
+} from './asr';
+export { asrFeed, asrFinish, asrStart, isNativeAsrAvailable } from './asr';
+export type {
+  SynthesisMemoryReport,
+  SynthesisMemoryStats,
+  SynthesisSessionStats,
+} from './memoryStats';
+export { getSynthesisMemoryStats } from './memoryStats';
+export {
+  isNativePackFileReaderAvailable,
+  readPackAssetBinary,
+  readPackFileBinary,
+} from './packFile';
+export type { PackTableFindOptions, PackTableInfo, PackTableRow } from './packTable';
+export { isNativePackTableAvailable, packTableFind, packTablesOpen } from './packTable';
+export type { PhonemeMemoStats } from './phonemeMemo';
+export { getPhonemeMemoStats, phonemeMemoConfigure, phonemeMemoSeed } from './phonemeMemo';
+export type { QueryCacheConfig, QueryCacheHit, QueryCacheStats } from './queryCache';
+export type { SilenceTrimConfig } from './silenceTrim';
+export { silenceTrimConfigure } from './silenceTrim';
+export type {
+  VectorIndexCoarseOptions,
+  VectorIndexHit,
+  VectorIndexSegment,
+  VectorIndexSpec,
+  VectorIndexStats,
+} from './vectorIndex';
+export {
+  isNativeVectorIndexAvailable,
+  vectorIndexCompact,
+  vectorIndexConfigure,
+  vectorIndexOpen,
+  vectorIndexSearch,
+  vectorIndexStats,
+} from './vectorIndex';
+export {
+  isNativeQueryCacheAvailable,
+  queryCacheClear,
+  queryCacheConfigure,
+  queryCacheInsert,
+  queryCacheProbe,
+  queryCacheStats,
+} from './queryCache';
 
 /** Voice tuning; applied via setOptions(), used by the next speak(). */
 export type SpeakOptions = {
@@ -34,6 +84,11 @@ export type SpeakOptions = {
   interSentenceSilenceMs?: number;
   /** Insert this many ms of silence after commas (0 = off). E.g. 125 for a short pause. */
   interCommaSilenceMs?: number;
+  /**
+   * Android: play each clause as soon as it is synthesized (default true). Ignored when
+   * interCommaSilenceMs is set, which needs the whole utterance.
+   */
+  streamSynthesis?: boolean;
   /** Post-synthesis gain in dB applied in native playPcm (omit = no change). */
   renderPostGainDb?: number;
   /** Prepend this many ms of silence before playback in native playPcm (omit or 0 = off). */
@@ -117,6 +172,19 @@ export default {
     return (NativePiperTts as { copyModelToFiles: () => Promise<string> }).copyModelToFiles().catch(() => null);
   },
 
+  /**
+   * Sync the bundled content pack into Documents (iOS) / files (Android), copying only changed files.
+   * Resolves with the pack path, or null when the native method is unavailable; rejects on sync errors
+   * (E_NO_PACK_MANIFEST when the bundled pack predates pack_files.json).
+   */
+  syncContentPack(): Promise<string | null> {
+    if (NativePiperTts == null) return Promise.resolve(null);
+    if (typeof (NativePiperTts as { syncContentPack?: () => Promise<string> }).syncContentPack !== 'function') {
+      return Promise.resolve(null);
+    }
+    return (NativePiperTts as { syncContentPack: () => Promise<string> }).syncContentPack();
+  },
+
   isModelAvailable(): Promise<boolean> {
     if (NativePiperTts == null) return Promise.resolve(false);
     return NativePiperTts.isModelAvailable();
@@ -0,0 +1,19 @@
+/**
+ * Resolves Piper JSI host functions, installing them on first use (Android needs installJsi();
+ * iOS installs them when the TurboModule is created).
+ */
+import NativePiperTts from './NativePiperTts';
+
+export function getPiperJsiFunction<T>(name: string): T | null {
+  const g = globalThis as Record<string, unknown>;
+  if (typeof g[name] === 'function') return g[name] as T;
+  if (NativePiperTts == null || typeof NativePiperTts.installJsi !== 'function') {
+    return null;
+  }
+  try {
+    NativePiperTts.installJsi();
+  } catch (_) {
+    return null;
+  }
+  return typeof g[name] === 'function' ? (g[name] as T) : null;
+}
@@ -0,0 +1,61 @@
+/**
+ * Synthesis memory accounting (JSI): per-stage bytes for the last request plus max/mean over all
+ * recorded requests. ORT figures come from a counting allocator on the shared ORT env; they are 0 unless
+ * the plugin is built with PIPER_ORT_ALLOC_STATS.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+export type SynthesisMemoryReport = {
+  /** espeak IPA string + phoneme id vector. */
+  phonemeBytes: number;
+  /** Resident growth across phonemization (espeak's own heap). */
+  espeakRssDelta: number;
+  /** ORT bytes live before Run (weights, prepacked buffers). */
+  ortLiveBytes: number;
+  /** Peak ORT bytes above ortLiveBytes during Run (intermediates + output). */
+  ortPeakBytes: number;
+  ortAllocCount: number;
+  floatAudioBytes: number;
+  pcmBytes: number;
+  /** Request scratch arena (phonemes, ids, float audio); largest clause when streaming. */
+  scratchBytes: number;
+  /** Heap blocks the scratch arena had to take; 0 once it is warm. */
+  scratchBlockMallocs: number;
+  /** Platform copy handed to Java (byte[]) / Obj-C (NSData). */
+  outputBytes: number;
+  rssStart: number;
+  /** Max resident growth over the request, sampled at stage boundaries. */
+  rssPeakDelta: number;
+};
+
+/** Session pool of one cached Piper model; replicas share one copy of the weights. */
+export type SynthesisSessionStats = {
+  modelPath: string;
+  replicas: number;
+  sharedInitializers: number;
+  /** Initializer bytes held once for every replica of the model. */
+  sharedWeightBytes: number;
+  /** ORT bytes allocated creating the first replica. */
+  firstReplicaBytes: number;
+  /** Mean ORT bytes per additional replica. */
+  replicaOverheadBytes: number;
+};
+
+export type SynthesisMemoryStats = {
+  requests: number;
+  last: SynthesisMemoryReport;
+  max: SynthesisMemoryReport;
+  mean: SynthesisMemoryReport;
+  /** ORT bytes live right now (all sessions). */
+  ortLiveBytes: number;
+  residentBytes: number;
+  sessions: SynthesisSessionStats[];
+};
+
+type StatsFn = (reset?: boolean) => SynthesisMemoryStats;
+
+/** Null when the JSI bindings are not installed. reset clears the aggregate after reading it. */
+export function getSynthesisMemoryStats(reset = false): SynthesisMemoryStats | null {
+  const fn = getPiperJsiFunction<StatsFn>('__piperSynthesisMemoryStats');
+  return fn ? fn(reset) : null;
+}
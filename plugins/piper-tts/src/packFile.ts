@@ -0,0 +1,27 @@
+/**
+ * Pack files as ArrayBuffers over JSI, without a base64 bridge round-trip: files on disk are mmapped
+ * copy-on-write, bundled files come straight from the APK asset / app bundle. The native memory is
+ * released when the ArrayBuffer is garbage collected. Treat asset buffers as read-only.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+type ReadFn = (path: string) => ArrayBuffer;
+
+export function isNativePackFileReaderAvailable(): boolean {
+  return getPiperJsiFunction<ReadFn>('__piperReadFileBinary') != null;
+}
+
+/** Absolute path on disk (e.g. Documents/content_pack/...). Null when JSI is not installed; throws if unreadable. */
+export function readPackFileBinary(path: string): ArrayBuffer | null {
+  const fn = getPiperJsiFunction<ReadFn>('__piperReadFileBinary');
+  return fn ? fn(path) : null;
+}
+
+/**
+ * Bundled pack file: Android asset path, or a path relative to the iOS main bundle (content_pack/...).
+ * Null when JSI is not installed; throws if the file is missing.
+ */
+export function readPackAssetBinary(path: string): ArrayBuffer | null {
+  const fn = getPiperJsiFunction<ReadFn>('__piperReadAssetBinary');
+  return fn ? fn(path) : null;
+}
@@ -0,0 +1,61 @@
+/**
+ * Columnar rules.db / cards.db copies in pack.bin (pack_compile), queried over JSI. A lookup is a binary
+ * search over the mmapped key index, and only the requested columns of the matching rows are copied into JS.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+export type PackTableInfo = {
+  /** Section name, e.g. "rules.table", "cards.table". */
+  name: string;
+  rows: number;
+  columns: string[];
+  /** Columns with a key index (usable with packTableFind). */
+  indexed: string[];
+};
+
+export type PackTableFindOptions = {
+  /** Match rows whose key starts with `key` (byte-wise, case-sensitive) instead of equal to it. */
+  prefix?: boolean;
+  limit?: number;
+  /** Columns to return (default all). */
+  columns?: string[];
+};
+
+export type PackTableRow = Record<string, string | number | null>;
+
+type OpenFn = (path: string) => PackTableInfo[];
+type FindFn = (
+  path: string,
+  table: string,
+  column: string,
+  key: string | number,
+  options?: PackTableFindOptions,
+) => PackTableRow[];
+
+export function isNativePackTableAvailable(): boolean {
+  return getPiperJsiFunction<FindFn>('__piperPackTableFind') != null;
+}
+
+/**
+ * Tables in a pack.bin (absolute path). The mapping is kept per path and replaced when the file changes.
+ * Null when JSI is not installed; throws if the file is missing or invalid.
+ */
+export function packTablesOpen(packBinPath: string): PackTableInfo[] | null {
+  const fn = getPiperJsiFunction<OpenFn>('__piperPackTablesOpen');
+  return fn ? fn(packBinPath) : null;
+}
+
+/**
+ * Rows of `table` whose indexed `column` equals (or, with `prefix`, starts with) `key`, in key order with ties
+ * in the table's row order. Null when JSI is not installed; throws if the table or index is missing.
+ */
+export function packTableFind(
+  packBinPath: string,
+  table: string,
+  column: string,
+  key: string | number,
+  options?: PackTableFindOptions,
+): PackTableRow[] | null {
+  const fn = getPiperJsiFunction<FindFn>('__piperPackTableFind');
+  return fn ? fn(packBinPath, table, column, key, options) : null;
+}
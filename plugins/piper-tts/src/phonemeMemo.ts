@@ -0,0 +1,61 @@
+/**
+ * Word-level phoneme memo beneath espeak (JSI). Clauses made of words the engine has already phonemized
+ * are assembled from the memo; numbers, abbreviations, heteronyms and words seen with two pronunciations
+ * still go through espeak in context.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+export type PhonemeMemoStats = {
+  /** Words phonemized since the last reset (memo and espeak). */
+  words: number;
+  /** Of those, served from the memo (learned or seeded). */
+  memoWords: number;
+  /** Of memoWords, read from the pack.bin seed. */
+  seedWords: number;
+  /** memoWords / words. */
+  memoFraction: number;
+  clauses: number;
+  /** Clauses assembled entirely from the memo. */
+  memoClauses: number;
+  espeakCalls: number;
+  espeakWords: number;
+  /** Time inside espeak. */
+  espeakMs: number;
+  /** Time assembling memoized clauses. */
+  memoMs: number;
+  /** espeak time the memoized words would have cost at the measured per-word rate, minus memoMs. */
+  savedMs: number;
+  learned: number;
+  /** Words learned with two pronunciations; they go to espeak from then on. */
+  conflicts: number;
+  evictions: number;
+  entries: number;
+  capacity: number;
+  /** Words in the seed (pack.bin "phonemes" section); 0 when unseeded. */
+  seedEntries: number;
+};
+
+type StatsFn = (reset?: boolean) => PhonemeMemoStats;
+type SeedFn = (packBinPath: string, voice?: string) => number;
+type ConfigureFn = (config: { capacity?: number }) => void;
+
+/** Null when the JSI bindings are not installed. reset clears the counters after reading them. */
+export function getPhonemeMemoStats(reset = false): PhonemeMemoStats | null {
+  const fn = getPiperJsiFunction<StatsFn>('__piperPhonemeMemoStats');
+  return fn ? fn(reset) : null;
+}
+
+/**
+ * Seed the memo with the isolation forms in a pack.bin "phonemes" section (pack_compile --espeak-data),
+ * rendered with `voice` (default en-us). Returns the seed size; null when JSI is not installed; throws if
+ * the pack is missing or has no phonemes section. An empty path drops the seed.
+ */
+export function phonemeMemoSeed(packBinPath: string, voice?: string): number | null {
+  const fn = getPiperJsiFunction<SeedFn>('__piperPhonemeMemoSeed');
+  return fn ? fn(packBinPath, voice) : null;
+}
+
+/** Memo capacity in words (default 4096); 0 disables it. */
+export function phonemeMemoConfigure(config: { capacity?: number }): void {
+  getPiperJsiFunction<ConfigureFn>('__piperPhonemeMemoConfigure')?.(config);
+}
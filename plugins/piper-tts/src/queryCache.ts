@@ -0,0 +1,68 @@
+/**
+ * Semantic query cache (native, JSI): recent query embeddings -> serialized retrieval result.
+ * A probe hits when a stored query is within `minCosine`; entries are scoped to a version key
+ * (pack identity + embed model) and the cache is LRU-capped.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+export type QueryCacheHit = {
+  payload: string;
+  cosine: number;
+  /** Miss-path cost recorded with the entry (ms). */
+  costMs: number;
+};
+
+export type QueryCacheStats = {
+  probes: number;
+  hits: number;
+  hitRate: number;
+  inserts: number;
+  evictions: number;
+  invalidations: number;
+  entries: number;
+  /** Sum of recorded miss-path cost for every hit (ms). */
+  savedMs: number;
+};
+
+export type QueryCacheConfig = {
+  minCosine?: number;
+  capacity?: number;
+};
+
+type ProbeFn = (versionKey: string, query: Float32Array) => QueryCacheHit | null;
+type InsertFn = (versionKey: string, query: Float32Array, payload: string, costMs?: number) => void;
+type ConfigureFn = (config: QueryCacheConfig) => void;
+type StatsFn = () => QueryCacheStats;
+type ClearFn = (resetStats?: boolean) => void;
+
+export function isNativeQueryCacheAvailable(): boolean {
+  return getPiperJsiFunction<ProbeFn>('__piperQueryCacheProbe') != null;
+}
+
+/** Returns null on a miss or when the native cache is not installed. */
+export function queryCacheProbe(versionKey: string, query: Float32Array): QueryCacheHit | null {
+  const fn = getPiperJsiFunction<ProbeFn>('__piperQueryCacheProbe');
+  return fn ? fn(versionKey, query) : null;
+}
+
+export function queryCacheInsert(
+  versionKey: string,
+  query: Float32Array,
+  payload: string,
+  costMs: number,
+): void {
+  getPiperJsiFunction<InsertFn>('__piperQueryCacheInsert')?.(versionKey, query, payload, costMs);
+}
+
+export function queryCacheConfigure(config: QueryCacheConfig): void {
+  getPiperJsiFunction<ConfigureFn>('__piperQueryCacheConfigure')?.(config);
+}
+
+export function queryCacheStats(): QueryCacheStats | null {
+  const fn = getPiperJsiFunction<StatsFn>('__piperQueryCacheStats');
+  return fn ? fn() : null;
+}
+
+export function queryCacheClear(resetStats = false): void {
+  getPiperJsiFunction<ClearFn>('__piperQueryCacheClear')?.(resetStats);
+}
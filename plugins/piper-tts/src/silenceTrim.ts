@@ -0,0 +1,30 @@
+/**
+ * Model-silence trimming (JSI): the engine drops the near-silence VITS leaves at the edges of each
+ * utterance (or streamed clause) so the platform lead and inter-clause pauses are the ones heard.
+ * Interior pauses are kept unless maxGapMs is set.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+export type SilenceTrimConfig = {
+  enabled: boolean;
+  /** A 10 ms window is silent this far below the loudest window of the clip (default -45). */
+  thresholdDb: number;
+  windowMs: number;
+  /** Silence kept next to speech at each edge (default 20). */
+  edgeKeepMs: number;
+  /** Interior silences longer than this are shortened to it; 0 (default) leaves them alone. */
+  maxGapMs: number;
+};
+
+type ConfigureFn = (config?: Partial<SilenceTrimConfig>) => SilenceTrimConfig;
+
+/**
+ * Change the process-wide trim settings (omitted fields keep their value) and return the settings in
+ * effect; call with no argument to read them. Null when the JSI bindings are not installed.
+ */
+export function silenceTrimConfigure(
+  config?: Partial<SilenceTrimConfig>,
+): SilenceTrimConfig | null {
+  const fn = getPiperJsiFunction<ConfigureFn>('__piperSilenceTrimConfigure');
+  return fn ? fn(config) : null;
+}
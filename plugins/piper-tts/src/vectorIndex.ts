@@ -0,0 +1,108 @@
+/**
+ * Segmented vector index (native, JSI): a base f16 segment plus append-only delta segments (added rows
+ * and tombstones), searched together with one merged L2 top-k. Compaction folds the deltas into a
+ * single mmapped .vseg on a native worker; later opens of the same spec use it directly.
+ */
+import { getPiperJsiFunction } from './jsi';
+
+export type VectorIndexSegment = {
+  name: string;
+  /** Absolute path to raw f16 rows (or a .vseg). Omit for a tombstone-only delta. */
+  vectors?: string;
+  /** Global row id of the first row in `vectors`. */
+  firstRow?: number;
+  /** Absolute path to little-endian u32 ids of earlier rows this segment removes. */
+  tombstones?: string;
+};
+
+export type VectorIndexSpec = {
+  dim: number;
+  segments: VectorIndexSegment[];
+  /** Compacted .vseg path; used instead of the segments when it was built from this exact spec. */
+  compacted?: string;
+  /**
+   * Pack-time vectors.sq8 (pack_compile --sq8) for the base rows; the sq8 scan copies its codes instead of
+   * quantizing at open. Ignored when missing or stale.
+   */
+  sq8?: string;
+};
+
+export type VectorIndexStats = {
+  segments: number;
+  rows: number;
+  liveRows: number;
+  tombstones: number;
+  compacted: boolean;
+  compacting: boolean;
+  /** Coarse prefix length in use; 0 = exact scan. */
+  coarsePrefixDims: number;
+  coarseBytes: number;
+  /** Full-dimension int8 scan in use, rows taken from the sq8 table, and the dot-product kernel. */
+  sq8: boolean;
+  sq8TableRows: number;
+  sq8Kernel: string;
+};
+
+/**
+ * Coarse-to-fine search for Matryoshka-style embeddings: the first `prefixDims` dimensions of every row
+ * (re-normalized, optionally int8) are scanned by cosine and the best `candidates` rows re-ranked with the
+ * full f16 L2 distance. `prefixDims` 0 (default) or >= dim is the exact scan.
+ *
+ * `sq8` scans all dimensions as int8 (per-dimension scale and offset) with the CPU's int8 dot-product
+ * instructions (arm64 SDOT, x86 VNNI/AVX2) before the same f16 re-rank; `prefixDims` and `int8` are then
+ * ignored.
+ */
+export type VectorIndexCoarseOptions = {
+  prefixDims: number;
+  /** Rows re-ranked at full dimension (default 64; never fewer than k). */
+  candidates?: number;
+  int8?: boolean;
+  sq8?: boolean;
+};
+
+export type VectorIndexHit = { rowId: number; score: number };
+
+type OpenFn = (key: string, spec: VectorIndexSpec) => VectorIndexStats;
+type SearchFn = (key: string, query: Float32Array, k: number) => VectorIndexHit[];
+type ConfigureFn = (key: string, options: VectorIndexCoarseOptions) => VectorIndexStats;
+type CompactFn = (key: string, outPath: string) => boolean;
+type StatsFn = (key: string) => VectorIndexStats | null;
+
+export function isNativeVectorIndexAvailable(): boolean {
+  return getPiperJsiFunction<OpenFn>('__piperVectorIndexOpen') != null;
+}
+
+/** Maps the spec's files under `key`; a no-op when the spec is unchanged. Throws on a missing/invalid segment. */
+export function vectorIndexOpen(key: string, spec: VectorIndexSpec): VectorIndexStats {
+  const fn = getPiperJsiFunction<OpenFn>('__piperVectorIndexOpen');
+  if (!fn) throw new Error('Native vector index not installed');
+  return fn(key, spec);
+}
+
+/** Nearest rows first; `rowId` is the global row id, `score` the L2 distance. */
+export function vectorIndexSearch(key: string, query: Float32Array, k: number): VectorIndexHit[] {
+  const fn = getPiperJsiFunction<SearchFn>('__piperVectorIndexSearch');
+  return fn ? fn(key, query, k) : [];
+}
+
+/**
+ * Sets the coarse prefix search for `key`, now and for later opens. Building the prefix copy is one pass
+ * over the rows on the calling thread; an unchanged config is a no-op. Null when not installed.
+ */
+export function vectorIndexConfigure(
+  key: string,
+  options: VectorIndexCoarseOptions,
+): VectorIndexStats | null {
+  const fn = getPiperJsiFunction<ConfigureFn>('__piperVectorIndexConfigure');
+  return fn ? fn(key, options) : null;
+}
+
+/** Starts background compaction into outPath; false if already compacted, compacting or not open. */
+export function vectorIndexCompact(key: string, outPath: string): boolean {
+  return getPiperJsiFunction<CompactFn>('__piperVectorIndexCompact')?.(key, outPath) ?? false;
+}
+
+export function vectorIndexStats(key: string): VectorIndexStats | null {
+  const fn = getPiperJsiFunction<StatsFn>('__piperVectorIndexStats');
+  return fn ? fn(key) : null;
+}
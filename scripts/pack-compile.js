@@ -0,0 +1,48 @@
+'use strict';
+/**
+ * Binary retrieval artifacts (DEST/pack.bin), shared by sync-pack-small.js and sync-pack-full.js.
+ * Runs the host tool pack_compile (plugins/piper-tts/host) over the synced pack when
+ * PIPER_PACK_COMPILE_TOOL points at it: vectors, chunk store and posting lists per source, the
+ * card-name trie and (with PIPER_ESPEAK_DATA) the phoneme cache, in one container. Output is
+ * reproducible, so an unchanged pack keeps the same pack_files.json hash and is not re-copied.
+ * With PIPER_PACK_SQ8=1 it also writes <source>/vectors.sq8 for the native index's int8 scan.
+ *
+ * Env:
+ *   PIPER_PACK_COMPILE_TOOL  path to the pack_compile binary
+ *   PIPER_ESPEAK_DATA        espeak-ng-data dir for the phoneme cache (optional)
+ *   PIPER_PACK_SQ8           1 to write the int8 vector tables (optional)
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { execFileSync } = require('child_process');
+
+/** Writes DEST/pack.bin and records pack_bin_hash on identity; no-op without the tool. */
+function compilePack(dest, identity) {
+  const tool = process.env.PIPER_PACK_COMPILE_TOOL;
+  if (!tool) return;
+  const report = path.join(os.tmpdir(), `pack_compile_${process.pid}.json`);
+  const args = [
+    '--pack',
+    dest,
+    '--out',
+    path.join(dest, 'pack.bin'),
+    '--json',
+    report,
+  ];
+  if (process.env.PIPER_ESPEAK_DATA) {
+    args.push('--espeak-data', process.env.PIPER_ESPEAK_DATA);
+  }
+  if (process.env.PIPER_PACK_SQ8 === '1') args.push('--sq8');
+  execFileSync(tool, args, { stdio: 'inherit' });
+  try {
+    identity.pack_bin_hash = JSON.parse(
+      fs.readFileSync(report, 'utf8'),
+    ).content_hash;
+  } finally {
+    fs.rmSync(report, { force: true });
+  }
+}
+
+module.exports = { compilePack };
@@ -0,0 +1,62 @@
+'use strict';
+/**
+ * pack_files.json for the native incremental pack sync (plugins/piper-tts ios/cpp/pack_sync.h),
+ * shared by sync-pack-small.js and sync-pack-full.js. Call it last: the manifest lists every file
+ * already in DEST with its size and hash, and the device copies only files whose hash changed.
+ *
+ * hash = first 16 bytes of BLAKE2b-512 (lowercase hex), matching piper::Blake2b::hex16().
+ */
+
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+
+const PACK_FILES_MANIFEST = 'pack_files.json';
+const SKIP = new Set([PACK_FILES_MANIFEST, '.DS_Store']);
+
+function blake2b128File(filePath) {
+  const hash = crypto.createHash('blake2b512');
+  const fd = fs.openSync(filePath, 'r');
+  const buf = Buffer.allocUnsafe(1 << 20);
+  try {
+    let n;
+    while ((n = fs.readSync(fd, buf, 0, buf.length, null)) > 0) {
+      hash.update(buf.subarray(0, n));
+    }
+  } finally {
+    fs.closeSync(fd);
+  }
+  return hash.digest('hex').slice(0, 32);
+}
+
+function listFiles(dir, rel, out) {
+  for (const ent of fs.readdirSync(dir, { withFileTypes: true })) {
+    const relPath = rel ? `${rel}/${ent.name}` : ent.name;
+    if (SKIP.has(ent.name)) continue;
+    if (ent.isDirectory()) listFiles(path.join(dir, ent.name), relPath, out);
+    else if (ent.isFile()) out.push(relPath);
+  }
+  return out;
+}
+
+/** Writes DEST/pack_files.json; returns the number of files listed. */
+function writePackFilesManifest(dest) {
+  const files = listFiles(dest, '', [])
+    .sort()
+    .map(relPath => {
+      const abs = path.join(dest, relPath);
+      return {
+        path: relPath,
+        size: fs.statSync(abs).size,
+        hash: blake2b128File(abs),
+      };
+    });
+  const manifest = { version: 1, hash: 'blake2b-512/128', files };
+  fs.writeFileSync(
+    path.join(dest, PACK_FILES_MANIFEST),
+    JSON.stringify(manifest, null, 2) + '\n',
+  );
+  return files.length;
+}
+
+module.exports = { writePackFilesManifest, blake2b128File, PACK_FILES_MANIFEST };
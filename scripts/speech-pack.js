@@ -0,0 +1,124 @@
+'use strict';
+/**
+ * Pre-rendered audio pack for canned lines, shared by sync-pack-small.js and sync-pack-full.js.
+ *
+ * Collects the lines the app speaks verbatim (scripted failure responses in
+ * src/app/agent/scripted/scriptedResponses.ts plus the pack's own audio/speech_lines.json, e.g.
+ * section intros) into DEST/audio/speech_lines.json, then renders DEST/audio/speech_pack.bin with the
+ * host tool (plugins/piper-tts/host, speech_pack_build) when PIPER_SPEECH_PACK_TOOL points at it.
+ * Without the tool a prebuilt speech_pack.bin from the source pack is kept as-is.
+ *
+ * Env:
+ *   PIPER_SPEECH_PACK_TOOL   path to the speech_pack_build binary
+ *   PIPER_SPEECH_MODEL_DIR   dir with model.onnx + model.onnx.json (default: Android plugin assets)
+ *   PIPER_ESPEAK_DATA        espeak-ng-data dir (default: plugins/piper-tts/ios/Resources/espeak-ng-data)
+ */
+
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+const { execFileSync } = require('child_process');
+
+const ROOT = path.resolve(__dirname, '..');
+const SCRIPTED_RESPONSES = path.join(
+  ROOT,
+  'src',
+  'app',
+  'agent',
+  'scripted',
+  'scriptedResponses.ts',
+);
+const PLUGIN = path.join(ROOT, 'plugins', 'piper-tts');
+
+/** String literals of every `readonly string[] = [...]` array in scriptedResponses.ts. */
+function scriptedLines() {
+  if (!fs.existsSync(SCRIPTED_RESPONSES)) return [];
+  const src = fs.readFileSync(SCRIPTED_RESPONSES, 'utf8');
+  const lines = [];
+  const arrayRe = /readonly string\[\]\s*=\s*\[([\s\S]*?)\];/g;
+  let m;
+  while ((m = arrayRe.exec(src)) !== null) {
+    const literalRe = /'((?:[^'\\]|\\.)*)'|"((?:[^"\\]|\\.)*)"/g;
+    let s;
+    while ((s = literalRe.exec(m[1])) !== null) {
+      lines.push((s[1] ?? s[2]).replace(/\\(.)/g, '$1'));
+    }
+  }
+  return lines;
+}
+
+function packLines(sourcePack) {
+  const p = path.join(sourcePack, 'audio', 'speech_lines.json');
+  if (!fs.existsSync(p)) return [];
+  const list = JSON.parse(fs.readFileSync(p, 'utf8'));
+  return Array.isArray(list)
+    ? list.map(x => (typeof x === 'string' ? x : x?.text)).filter(Boolean)
+    : [];
+}
+
+/** Same canonicalization as piper::canonicalUtteranceText (trim + collapse whitespace). */
+function canonical(text) {
+  return text.replace(/\s+/g, ' ').trim();
+}
+
+/**
+ * Writes DEST/audio/speech_lines.json, renders speech_pack.bin if the tool is configured, and records
+ * speech_pack_sha256 / speech_pack_lines on identity when a pack is present.
+ */
+function syncSpeechPack(sourcePack, dest, identity) {
+  const seen = new Set();
+  const lines = [];
+  for (const line of [...scriptedLines(), ...packLines(sourcePack)]) {
+    const c = canonical(line);
+    if (c && !seen.has(c)) {
+      seen.add(c);
+      lines.push(c);
+    }
+  }
+  if (lines.length === 0) return;
+
+  const audioDir = path.join(dest, 'audio');
+  fs.mkdirSync(audioDir, { recursive: true });
+  const linesPath = path.join(audioDir, 'speech_lines.json');
+  fs.writeFileSync(linesPath, JSON.stringify(lines, null, 2) + '\n');
+  const packPath = path.join(audioDir, 'speech_pack.bin');
+
+  const tool = process.env.PIPER_SPEECH_PACK_TOOL;
+  if (tool) {
+    const modelDir =
+      process.env.PIPER_SPEECH_MODEL_DIR ??
+      path.join(PLUGIN, 'android', 'src', 'main', 'assets', 'piper');
+    const espeakData =
+      process.env.PIPER_ESPEAK_DATA ??
+      path.join(PLUGIN, 'ios', 'Resources', 'espeak-ng-data');
+    execFileSync(
+      tool,
+      [
+        '--model',
+        path.join(modelDir, 'model.onnx'),
+        '--config',
+        path.join(modelDir, 'model.onnx.json'),
+        '--espeak-data',
+        espeakData,
+        '--lines',
+        linesPath,
+        '--out',
+        packPath,
+      ],
+      { stdio: 'inherit' },
+    );
+  } else if (!fs.existsSync(packPath)) {
+    console.log(
+      `Speech pack: ${lines.length} lines listed; set PIPER_SPEECH_PACK_TOOL to render speech_pack.bin`,
+    );
+    return;
+  }
+
+  identity.speech_pack_sha256 = crypto
+    .createHash('sha256')
+    .update(fs.readFileSync(packPath))
+    .digest('hex');
+  identity.speech_pack_lines = lines.length;
+}
+
+module.exports = { syncSpeechPack, scriptedLines };
@@ -22,6 +22,9 @@
 const fs = require('fs');
 const path = require('path');
 const crypto = require('crypto');
+const { syncSpeechPack } = require('./speech-pack');
+const { compilePack } = require('./pack-compile');
+const { writePackFilesManifest, PACK_FILES_MANIFEST } = require('./pack-files');
 
 const ROOT = path.resolve(__dirname, '..');
 const ASSETS = path.join(ROOT, 'assets');
@@ -127,9 +130,14 @@ function run() {
       identity.context_provider_spec_schema_version = spec.schema_version;
   }
 
+  syncSpeechPack(sourcePack, DEST, identity);
+  compilePack(DEST, identity);
+
   const identityPath = path.join(DEST, PACK_IDENTITY_FILE);
   fs.writeFileSync(identityPath, JSON.stringify(identity, null, 2) + '\n');
   console.log('Wrote', PACK_IDENTITY_FILE);
+  const listed = writePackFilesManifest(DEST);
+  console.log('Wrote', PACK_FILES_MANIFEST, `(${listed} files)`);
   console.log(
     'Next: build the app once; on first launch the app will copy this pack to device. For normal builds, run pnpm run rag:pack again.',
   );
@@ -5,7 +5,8 @@
  * This is the build contract: the app always bundles a real directory (no symlink
  * semantics). Copies manifest, router, rules, cards, hashes, context_provider_spec,
  * and any .db files; always excludes models/.
- * Writes pack_identity.json into the destination for debug/parity tracing.
+ * Writes pack_identity.json into the destination for debug/parity tracing, then
+ * pack_files.json (per-file BLAKE2b) for the incremental on-device sync.
  *
  * Usage:
  *   node scripts/sync-pack-small.js [path-to-pack_runtime]
@@ -17,6 +18,9 @@
 const fs = require('fs');
 const path = require('path');
 const crypto = require('crypto');
+const { syncSpeechPack } = require('./speech-pack');
+const { compilePack } = require('./pack-compile');
+const { writePackFilesManifest, PACK_FILES_MANIFEST } = require('./pack-files');
 
 const ROOT = path.resolve(__dirname, '..');
 const ASSETS = path.join(ROOT, 'assets');
@@ -123,6 +127,9 @@ function run() {
   }
   // Pack identity is strictly runtime-relevant (pack + router + db + spec hashes, spec schema version). Omit fixture_schema_version unless you ship fixture traces in packs.
 
+  syncSpeechPack(sourcePack, DEST, identity);
+  compilePack(DEST, identity);
+
   const identityPath = path.join(DEST, PACK_IDENTITY_FILE);
   fs.writeFileSync(identityPath, JSON.stringify(identity, null, 2) + '\n');
   console.log(
@@ -131,6 +138,8 @@ function run() {
     ':',
     JSON.stringify(identity, null, 2),
   );
+  const listed = writePackFilesManifest(DEST);
+  console.log('Wrote', PACK_FILES_MANIFEST, `(${listed} files)`);
 }
 
 run();
@@ -0,0 +1,67 @@
+jest.mock('react-native', () => ({
+  NativeModules: {
+    RagPackReader: {
+      getBundleFilePath: jest.fn(),
+      fileExistsAtPath: jest.fn(),
+    },
+  },
+}));
+jest.mock('../../../rag', () => ({ BUNDLE_PACK_ROOT: 'content_pack' }));
+jest.mock('../../../shared/logging', () => ({ logInfo: jest.fn() }));
+
+import { NativeModules } from 'react-native';
+import { getOnDeviceModelPaths } from './modelPaths';
+
+const reader = NativeModules.RagPackReader as {
+  getBundleFilePath: jest.Mock;
+  fileExistsAtPath: jest.Mock;
+};
+
+/** Bundle holding exactly `files` (relative to the bundle root), resolved under /app. */
+function bundleWith(files: string[]): void {
+  const present = new Set(files.map(f => `/app/${f}`));
+  reader.getBundleFilePath.mockImplementation(async (rel: string) =>
+    `/app/${rel}`.replace(/\/+/g, '/'),
+  );
+  reader.fileExistsAtPath.mockImplementation(async (abs: string) =>
+    present.has(abs),
+  );
+}
+
+describe('getOnDeviceModelPaths (bundle)', () => {
+  it('prefers the bundled ONNX encoder when vocab.txt is alongside', async () => {
+    bundleWith([
+      'content_pack/models/embed/model.onnx',
+      'content_pack/models/embed/vocab.txt',
+      'content_pack/models/embed/embed.gguf',
+      'content_pack/models/llm/model.gguf',
+    ]);
+    const paths = await getOnDeviceModelPaths();
+    expect(paths.embedModelPath).toBe(
+      '/app/content_pack/models/embed/model.onnx',
+    );
+    expect(paths.chatModelPath).toBe('/app/content_pack/models/llm/model.gguf');
+  });
+
+  it('falls back to embed.gguf when the bundled ONNX encoder has no vocab.txt', async () => {
+    bundleWith([
+      'content_pack/models/embed/model.onnx',
+      'content_pack/models/embed/embed.gguf',
+      'content_pack/models/llm/model.gguf',
+    ]);
+    const paths = await getOnDeviceModelPaths();
+    expect(paths.embedModelPath).toBe(
+      '/app/content_pack/models/embed/embed.gguf',
+    );
+  });
+
+  it('returns no embed model for a bundled ONNX encoder without vocab.txt or GGUF', async () => {
+    bundleWith([
+      'content_pack/models/embed/model.onnx',
+      'content_pack/models/llm/model.gguf',
+    ]);
+    const paths = await getOnDeviceModelPaths();
+    expect(paths.embedModelPath).toBe('');
+    expect(paths.chatModelPath).toBe('/app/content_pack/models/llm/model.gguf');
+  });
+});
@@ -5,8 +5,12 @@ import { logInfo } from '../../../shared/logging';
 const BUNDLE_MODEL_PREFIXES = Array.from(
   new Set([BUNDLE_PACK_ROOT, '', 'content_pack'].filter(Boolean)),
 );
-const BUNDLE_EMBED_PATH_CANDIDATES = BUNDLE_MODEL_PREFIXES.map(
-  (prefix: string) => `${prefix}/models/embed/embed.gguf`,
+/** ONNX encoder (run natively via piper-tts, needs vocab.txt alongside) is preferred over GGUF. */
+const BUNDLE_EMBED_PATH_CANDIDATES = BUNDLE_MODEL_PREFIXES.flatMap(
+  (prefix: string) => [
+    `${prefix}/models/embed/model.onnx`,
+    `${prefix}/models/embed/embed.gguf`,
+  ],
 );
 const BUNDLE_LLM_PATH_CANDIDATES = BUNDLE_MODEL_PREFIXES.map(
   (prefix: string) => `${prefix}/models/llm/model.gguf`,
@@ -35,17 +39,31 @@ export async function getOnDeviceModelPaths(
     }
   };
 
+  const resolveBundleFile = async (relativePath: string): Promise<string> => {
+    try {
+      const resolved = await RagPackReader.getBundleFilePath(relativePath);
+      return resolved && (await fileExists(resolved)) ? resolved : '';
+    } catch {
+      return '';
+    }
+  };
+
+  /** First candidate present in the bundle; an ONNX encoder only counts with its vocab.txt alongside. */
   const resolveBundleModelPath = async (
     candidates: string[],
   ): Promise<string> => {
     if (typeof RagPackReader.getBundleFilePath !== 'function') return '';
     for (const candidate of candidates) {
-      try {
-        const resolved = await RagPackReader.getBundleFilePath(candidate);
-        if (resolved && (await fileExists(resolved))) return resolved;
-      } catch {
-        /* try next */
-      }
+      const resolved = await resolveBundleFile(candidate);
+      if (!resolved) continue;
+      if (
+        candidate.endsWith('.onnx') &&
+        !(await resolveBundleFile(
+          `${candidate.slice(0, candidate.lastIndexOf('/'))}/vocab.txt`,
+        ))
+      )
+        continue;
+      return resolved;
     }
     return '';
   };
@@ -70,8 +88,15 @@ export async function getOnDeviceModelPaths(
         /* use fallbacks */
       }
     }
+    const packEmbedOnnx = `${root}/models/embed/model.onnx`;
     const packEmbed = `${root}/models/embed/embed.gguf`;
     const packLlm = `${root}/models/llm/model.gguf`;
+    if (
+      !embedModelPath &&
+      (await fileExists(packEmbedOnnx)) &&
+      (await fileExists(`${root}/models/embed/vocab.txt`))
+    )
+      embedModelPath = packEmbedOnnx;
     if (!embedModelPath && (await fileExists(packEmbed)))
       embedModelPath = packEmbed;
     if (!chatModelPath && (await fileExists(packLlm))) chatModelPath = packLlm;
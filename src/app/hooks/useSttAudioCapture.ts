@@ -8,7 +8,11 @@ import type {
   RecordingOptionsWeb,
 } from 'expo-audio';
 import AtlasNativeMic from 'atlas-native-mic';
-import { isNativeMicCaptureEnabled } from '../../shared/config/endpointConfig';
+import {
+  getNativeMicPreRollMs,
+  isNativeMicCaptureEnabled,
+  isNativeMicWarmCaptureEnabled,
+} from '../../shared/config/endpointConfig';
 import { logInfo, logWarn } from '../../shared/logging';
 
 type CommonRecordingOptions = {
@@ -178,6 +182,8 @@ async function configureRecordingAudioMode(): Promise<void> {
 }
 
 async function restorePlaybackAudioMode(): Promise<void> {
+  // The warm native mic holds a play-and-record session; a playback-only mode would stop its input.
+  if (shouldAttemptNativeMic() && isNativeMicWarmCaptureEnabled()) return;
   const { setAudioModeAsync } = getExpoAudio();
   await setAudioModeAsync({
     allowsRecording: false,
@@ -227,6 +233,13 @@ function shouldAttemptNativeMic(): boolean {
   return isNativeMicCaptureEnabled() && AtlasNativeMic.isAvailable();
 }
 
+function nativeMicInitOptions(): { warm: boolean; preRollMs: number } {
+  return {
+    warm: isNativeMicWarmCaptureEnabled(),
+    preRollMs: getNativeMicPreRollMs(),
+  };
+}
+
 function toFileUri(uri: string): string {
   if (uri.startsWith('file://')) return uri;
   if (uri.length === 0) return uri;
@@ -253,6 +266,14 @@ export function useSttAudioCapture() {
     };
   }, []);
 
+  useEffect(() => {
+    // Open the warm input before the first capture; native skips it until permission is granted.
+    if (!shouldAttemptNativeMic() || !isNativeMicWarmCaptureEnabled()) return;
+    AtlasNativeMic.init(nativeMicInitOptions()).catch(() => {
+      /* beginCapture retries init and reports failures */
+    });
+  }, []);
+
   const beginCapture = useCallback(
     async (recordingSessionId?: string): Promise<boolean> => {
       const sid = sessionKey(recordingSessionId);
@@ -273,7 +294,7 @@ export function useSttAudioCapture() {
             selectedPath: 'native',
           });
           try {
-            await AtlasNativeMic.init();
+            await AtlasNativeMic.init(nativeMicInitOptions());
             await AtlasNativeMic.startCapture(sid);
             expoRecorderRef.current?.release();
             expoRecorderRef.current = null;
@@ -550,6 +571,7 @@ export function useSttAudioCapture() {
           logInfo('AgentOrchestrator', 'stt audio capture completed (native mic)', {
             recordingSessionId,
             durationMillis,
+            preRollMillis: result.preRollMillis ?? 0,
             filename,
             mimeType,
             sizeBase64Chars: audioBase64.length,
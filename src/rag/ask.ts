@@ -1,6 +1,9 @@
 /**
  * RAG flow: embed → retrieve → merge → context → completion. Returns raw response.
  * Supports either on-device llama.rn (GGUF paths) or Ollama HTTP API.
+ * An ONNX embed model (model.onnx + vocab.txt) is run natively via piper-tts on the shared ORT env.
+ * Vector retrieval results are reused for near-identical queries via the piper-tts semantic query cache.
+ * Segmented vector indexes (base + delta segments) are scanned by the piper-tts native index when linked.
  */
 
 import type {
@@ -16,13 +19,29 @@ import {
   ragError,
   ragErrorWithAttribution,
 } from './errors';
-import { loadChunksForRows, loadVectors, searchL2 } from './retrieval';
+import {
+  indexSegmentsOf,
+  loadChunksForSegmentedRows,
+  loadSegmentedVectors,
+  searchSegmentedL2,
+} from './retrieval';
 import {
   checkFrontDoorBeforeRetrieval,
   shouldRunFrontDoorGateBeforeRetrieval,
 } from './frontDoorGate';
-import { buildPrompt, trimChunksToFitPrompt } from './runtimePrompt';
-import type { PackFileReader, PackState, RagInitParams } from './types';
+import {
+  buildPrompt,
+  staticPromptPrefix,
+  trimChunksToFitPrompt,
+} from './runtimePrompt';
+import { ensurePromptPrefix } from './promptPrefixCache';
+import type {
+  IndexMeta,
+  IndexSegment,
+  PackFileReader,
+  PackState,
+  RagInitParams,
+} from './types';
 import { RAG_USE_DETERMINISTIC_CONTEXT_ONLY } from './types';
 
 /** Llama 3 stop sequences (not exported from @atlas/runtime RN entrypoint; define here to avoid passing undefined to native). */
@@ -117,6 +136,29 @@ async function getEmbedContext(
   return ctx;
 }
 
+/** ONNX sentence encoders (vocab.txt alongside) run natively; GGUF stays on llama.rn. */
+function isOnnxEmbedModel(embedModelPath: string): boolean {
+  return /\.onnx$/i.test(embedModelPath);
+}
+
+function embedQueryNative(
+  embedModelPath: string,
+  question: string,
+): Float32Array {
+  const { embedText } = require('piper-tts') as {
+    embedText: (
+      modelPath: string,
+      vocabPath: string,
+      text: string,
+      options?: { maxTokens?: number },
+    ) => Float32Array;
+  };
+  const vocabPath = embedModelPath.replace(/[^/]+$/, 'vocab.txt');
+  return embedText(embedModelPath, vocabPath, question, {
+    maxTokens: RAG_CONFIG.embed_n_ctx,
+  });
+}
+
 async function getChatContext(
   chatModelPath: string,
 ): Promise<import('llama.rn').LlamaContext> {
@@ -138,6 +180,283 @@ interface ChunkForPromptLog {
   text?: string;
 }
 
+type QueryCacheModule = {
+  queryCacheProbe: (
+    versionKey: string,
+    query: Float32Array,
+  ) => { payload: string; cosine: number; costMs: number } | null;
+  queryCacheInsert: (
+    versionKey: string,
+    query: Float32Array,
+    payload: string,
+    costMs: number,
+  ) => void;
+  queryCacheConfigure: (config: {
+    minCosine?: number;
+    capacity?: number;
+  }) => void;
+  queryCacheStats: () => {
+    probes: number;
+    hitRate: number;
+    savedMs: number;
+  } | null;
+};
+
+/** Config last handed to the native cache; reconfigured only when rag_config changes it. */
+let queryCacheConfigured: { minCosine: number; capacity: number } | null =
+  null;
+
+/** Native semantic query cache (piper-tts JSI); null when the module is not linked. */
+function getQueryCache(): QueryCacheModule | null {
+  if (RAG_CONFIG.retrieval.query_cache_min_cosine > 1) return null;
+  try {
+    const mod = require('piper-tts') as Partial<QueryCacheModule>;
+    if (typeof mod.queryCacheProbe !== 'function') return null;
+    const minCosine = RAG_CONFIG.retrieval.query_cache_min_cosine;
+    const capacity = RAG_CONFIG.retrieval.query_cache_capacity;
+    if (
+      queryCacheConfigured?.minCosine !== minCosine ||
+      queryCacheConfigured.capacity !== capacity
+    ) {
+      mod.queryCacheConfigure?.({ minCosine, capacity });
+      queryCacheConfigured = { minCosine, capacity };
+    }
+    return mod as QueryCacheModule;
+  } catch {
+    return null;
+  }
+}
+
+type VectorIndexModule = {
+  vectorIndexOpen: (
+    key: string,
+    spec: {
+      dim: number;
+      segments: Array<{
+        name: string;
+        vectors?: string;
+        firstRow?: number;
+        tombstones?: string;
+      }>;
+      compacted?: string;
+      sq8?: string;
+    },
+  ) => { segments: number; tombstones: number; compacted: boolean };
+  vectorIndexSearch: (
+    key: string,
+    query: Float32Array,
+    k: number,
+  ) => Array<{ rowId: number; score: number }>;
+  vectorIndexCompact: (key: string, outPath: string) => boolean;
+  vectorIndexConfigure?: (
+    key: string,
+    options: { prefixDims: number; candidates?: number; int8?: boolean; sq8?: boolean },
+  ) => unknown;
+};
+
+/** Native segmented vector index (piper-tts JSI); null when not linked. */
+function getNativeVectorIndex(): VectorIndexModule | null {
+  try {
+    const mod = require('piper-tts') as Partial<VectorIndexModule> & {
+      isNativeVectorIndexAvailable?: () => boolean;
+    };
+    if (typeof mod.vectorIndexOpen !== 'function') return null;
+    if (!mod.isNativeVectorIndexAvailable?.()) return null;
+    return mod as VectorIndexModule;
+  } catch {
+    return null;
+  }
+}
+
+/** Last spec opened per native index key; reopening is only needed when the pack changes. */
+const openedNativeSpecs = new Map<string, string>();
+
+/**
+ * Top-k over one source's segments. Native when the pack is on the filesystem (files are mmapped by
+ * absolute path); a delta-bearing index is compacted in the background to <source>/segments.vseg.
+ * Falls back to the JS scan when the native index is missing or rejects the spec.
+ */
+async function searchSource(
+  reader: PackFileReader,
+  packRoot: string,
+  source: 'rules' | 'cards',
+  segments: IndexSegment[],
+  meta: IndexMeta,
+  queryVec: Float32Array,
+  k: number,
+): Promise<Array<{ rowId: number; score: number }>> {
+  const native = packRoot.startsWith('/') ? getNativeVectorIndex() : null;
+  if (native) {
+    const root = packRoot.replace(/\/+$/, '');
+    const abs = (p?: string) => (p ? `${root}/${p}` : undefined);
+    const compacted = `${root}/${source}/segments.vseg`;
+    const spec = {
+      dim: meta.dim,
+      segments: segments.map(s => ({
+        name: s.name,
+        vectors: abs(s.vectorsPath),
+        firstRow: s.firstRow,
+        tombstones: abs(s.tombstonesPath),
+      })),
+      compacted,
+      sq8: `${root}/${source}/vectors.sq8`,
+    };
+    try {
+      // Pack rag_config may change these; the native side rebuilds only when they differ.
+      native.vectorIndexConfigure?.(source, {
+        prefixDims: RAG_CONFIG.retrieval.coarse_prefix_dims,
+        candidates: RAG_CONFIG.retrieval.coarse_candidates,
+        int8: RAG_CONFIG.retrieval.coarse_int8,
+        sq8: RAG_CONFIG.retrieval.sq8_scan,
+      });
+      const specKey = JSON.stringify(spec);
+      if (openedNativeSpecs.get(source) !== specKey) {
+        const stats = native.vectorIndexOpen(source, spec);
+        openedNativeSpecs.set(source, specKey);
+        if (!stats.compacted && (stats.segments > 1 || stats.tombstones > 0)) {
+          native.vectorIndexCompact(source, compacted);
+        }
+      }
+      return native.vectorIndexSearch(source, queryVec, k);
+    } catch (e) {
+      openedNativeSpecs.delete(source);
+      logWarn('RAG', 'native vector index unavailable; using JS scan', {
+        source,
+        error: e instanceof Error ? e.message : String(e),
+      });
+    }
+  }
+  const index = await loadSegmentedVectors(reader, segments, meta, source);
+  return searchSegmentedL2(index, queryVec, k);
+}
+
+interface VectorRetrievalResult {
+  chunksForPrompt: ChunkForPromptLog[];
+  rulesCount: number;
+  cardsCount: number;
+  cache: { hit: boolean; cosine?: number; savedMs?: number } | null;
+}
+
+/**
+ * L2 top-k over rules + cards, merge, load chunks. Near-identical queries (same pack + embed model)
+ * are served from the native semantic query cache, skipping vector load, both scans and chunk loading.
+ */
+async function retrieveChunksForQuery(
+  packState: PackState,
+  reader: PackFileReader,
+  queryVec: Float32Array,
+  embedModelKey: string,
+  mark: (msg: string) => void,
+): Promise<VectorRetrievalResult> {
+  const cache = getQueryCache();
+  const versionKey = `${packState.packVersion ?? packState.packRoot}|${
+    packState.contentKey ?? ''
+  }|${embedModelKey}`;
+  if (cache) {
+    const hit = cache.queryCacheProbe(versionKey, queryVec);
+    if (hit) {
+      try {
+        const chunksForPrompt = JSON.parse(hit.payload) as ChunkForPromptLog[];
+        mark(`query cache hit (cos=${hit.cosine.toFixed(3)})`);
+        return {
+          chunksForPrompt,
+          rulesCount: chunksForPrompt.filter(c => c.source_type === 'rules')
+            .length,
+          cardsCount: chunksForPrompt.filter(c => c.source_type === 'cards')
+            .length,
+          cache: { hit: true, cosine: hit.cosine, savedMs: hit.costMs },
+        };
+      } catch {
+        // Corrupt payload: fall through to a fresh retrieval, which overwrites the entry.
+      }
+    }
+  }
+
+  const missStartedAt = Date.now();
+  const rulesMeta = packState.rules.indexMeta;
+  const cardsMeta = packState.cards.indexMeta;
+  const rulesSegments = indexSegmentsOf(packState.rules);
+  const cardsSegments = indexSegmentsOf(packState.cards);
+  mark('retrieval start');
+  const [rulesHits, cardsHits] = await Promise.all([
+    searchSource(
+      reader,
+      packState.packRoot,
+      'rules',
+      rulesSegments,
+      rulesMeta,
+      queryVec,
+      RAG_CONFIG.retrieval.top_k_rules,
+    ),
+    searchSource(
+      reader,
+      packState.packRoot,
+      'cards',
+      cardsSegments,
+      cardsMeta,
+      queryVec,
+      RAG_CONFIG.retrieval.top_k_cards,
+    ),
+  ]);
+  const merged = mergeHits(rulesHits, cardsHits);
+  const topMerged = merged.slice(0, RAG_CONFIG.retrieval.top_k_merge);
+  mark('retrieval end');
+
+  const rulesRowIds = topMerged
+    .filter(h => h.source_type === 'rules')
+    .map(h => h.rowId);
+  const cardsRowIds = topMerged
+    .filter(h => h.source_type === 'cards')
+    .map(h => h.rowId);
+  mark('chunks load start');
+  const [rulesChunks, cardsChunks] = await Promise.all([
+    loadChunksForSegmentedRows(reader, rulesSegments, rulesRowIds),
+    loadChunksForSegmentedRows(reader, cardsSegments, cardsRowIds),
+  ]);
+  mark('chunks load end');
+
+  const chunksForPrompt: ChunkForPromptLog[] = topMerged.map(h => {
+    const map = h.source_type === 'rules' ? rulesChunks : cardsChunks;
+    const c = map.get(h.rowId);
+    return {
+      doc_id: c?.doc_id ?? h.doc_id,
+      source_type: h.source_type,
+      title: c?.title,
+      text: c?.text,
+    };
+  });
+  if (cache) {
+    cache.queryCacheInsert(
+      versionKey,
+      queryVec,
+      JSON.stringify(chunksForPrompt),
+      Date.now() - missStartedAt,
+    );
+  }
+  return {
+    chunksForPrompt,
+    rulesCount: rulesRowIds.length,
+    cardsCount: cardsRowIds.length,
+    cache: cache ? { hit: false } : null,
+  };
+}
+
+/** Per-request cache outcome plus running hit rate / saved time for request-debug. */
+function queryCacheTelemetry(
+  cache: VectorRetrievalResult['cache'],
+): Record<string, unknown> | null {
+  if (!cache) return null;
+  const stats = getQueryCache()?.queryCacheStats() ?? null;
+  return {
+    hit: cache.hit,
+    cosine: cache.cosine,
+    savedMs: cache.savedMs,
+    probes: stats?.probes,
+    hitRate: stats?.hitRate,
+    totalSavedMs: stats?.savedMs,
+  };
+}
+
 function logDebugPromptAndChunks(
   chunks: ChunkForPromptLog[],
   prompt: string,
@@ -306,6 +625,25 @@ export async function runRagFlow(
     emitRag('rag_retrieval_start', {});
   }
 
+  /** Restores (or builds and saves) the static prompt prefix KV state so only the suffix is evaluated. */
+  const primePromptPrefix = async (
+    chatCtx: import('llama.rn').LlamaContext,
+    modelPath: string,
+    prompt: string,
+  ): Promise<void> => {
+    const prefix = await ensurePromptPrefix(
+      chatCtx,
+      modelPath,
+      packState.packVersion,
+      staticPromptPrefix(),
+      prompt,
+    );
+    mark(`prompt prefix ${prefix.status}`);
+    if (requestId != null && requestDebugSink) {
+      emitRag('rag_prompt_prefix', { ...prefix });
+    }
+  };
+
   const listResult = runListPreClassifier(question, packState);
   if (listResult?.useListPath) {
     // Unreachable while `useListPath` stays false. If implemented, must authorize via the same
@@ -371,51 +709,18 @@ export async function runRagFlow(
       );
     }
 
-    mark('vectors load start');
-    const [rulesIndex, cardsIndex] = await Promise.all([
-      loadVectors(reader, packState.rules.vectorsPath, rulesMeta, 'rules'),
-      loadVectors(reader, packState.cards.vectorsPath, cardsMeta, 'cards'),
-    ]);
-    mark('vectors load end');
-    mark('retrieval start');
-    const rulesTopK = Math.min(
-      RAG_CONFIG.retrieval.top_k_rules,
-      rulesIndex.nRows,
-    );
-    const cardsTopK = Math.min(
-      RAG_CONFIG.retrieval.top_k_cards,
-      cardsIndex.nRows,
+    const { chunksForPrompt, cache } = await retrieveChunksForQuery(
+      packState,
+      reader,
+      queryVec,
+      `ollama:${embedModel}`,
+      mark,
     );
-    const rulesHits = searchL2(rulesIndex, queryVec, rulesTopK);
-    const cardsHits = searchL2(cardsIndex, queryVec, cardsTopK);
-    const merged = mergeHits(rulesHits, cardsHits);
-    const topMerged = merged.slice(0, RAG_CONFIG.retrieval.top_k_merge);
-    mark('retrieval end');
     if (requestId != null && requestDebugSink) {
       emitRag('rag_retrieval_mode', { retrievalMode: 'vector' });
+      const cacheTelemetry = queryCacheTelemetry(cache);
+      if (cacheTelemetry) emitRag('rag_query_cache', cacheTelemetry);
     }
-    const rulesRowIds = topMerged
-      .filter(h => h.source_type === 'rules')
-      .map(h => h.rowId);
-    const cardsRowIds = topMerged
-      .filter(h => h.source_type === 'cards')
-      .map(h => h.rowId);
-    mark('chunks load start');
-    const [rulesChunks, cardsChunks] = await Promise.all([
-      loadChunksForRows(reader, packState.rules.chunksPath, rulesRowIds),
-      loadChunksForRows(reader, packState.cards.chunksPath, cardsRowIds),
-    ]);
-    mark('chunks load end');
-    const chunksForPrompt = topMerged.map(h => {
-      const map = h.source_type === 'rules' ? rulesChunks : cardsChunks;
-      const c = map.get(h.rowId);
-      return {
-        doc_id: c?.doc_id ?? h.doc_id,
-        source_type: h.source_type,
-        title: c?.title,
-        text: c?.text,
-      };
-    });
     options?.onRetrievalComplete?.();
     mark('context build start');
     const { prompt, contextBlock } = trimChunksToFitPrompt(
@@ -779,6 +1084,7 @@ export async function runRagFlow(
           ...generationTelemetryParams(),
         });
       }
+      await primePromptPrefix(chatCtx, params.chatModelPath, prompt);
       options?.onGenerationStart?.();
       if (requestId != null && requestDebugSink) {
         emitRag('rag_inference_start', {});
@@ -858,13 +1164,16 @@ export async function runRagFlow(
     if (!params.embedModelPath?.trim() || !params.chatModelPath?.trim()) {
       throw ragError(
         'E_MODEL_PATH',
-        'On-device models not configured. Set embedModelPath and chatModelPath to local GGUF file paths (e.g. in app documents or bundled assets). Pack expects an embed model matching index dim (e.g. nomic-embed-text) and a chat model for completion.',
+        'On-device models not configured. Set embedModelPath and chatModelPath to local GGUF file paths (embed may also be an ONNX model with vocab.txt alongside; e.g. in app documents or bundled assets). Pack expects an embed model matching index dim (e.g. nomic-embed-text) and a chat model for completion.',
       );
     }
+    const useNativeEmbed = isOnnxEmbedModel(params.embedModelPath);
     mark('embed model load start');
-    let embedCtx: import('llama.rn').LlamaContext;
+    let embedCtx: import('llama.rn').LlamaContext | null = null;
     try {
-      embedCtx = await getEmbedContext(params.embedModelPath);
+      if (!useNativeEmbed) {
+        embedCtx = await getEmbedContext(params.embedModelPath);
+      }
       mark('embed model load end');
     } catch (e) {
       const msg = e instanceof Error ? e.message : String(e);
@@ -876,8 +1185,21 @@ export async function runRagFlow(
     }
 
     mark('embedding start');
-    const embRes = await embedCtx.embedding(question);
-    queryVec = new Float32Array(embRes.embedding);
+    if (embedCtx) {
+      const embRes = await embedCtx.embedding(question);
+      queryVec = new Float32Array(embRes.embedding);
+    } else {
+      try {
+        queryVec = embedQueryNative(params.embedModelPath, question);
+      } catch (e) {
+        const msg = e instanceof Error ? e.message : String(e);
+        mark('embedding failed');
+        throw ragError(
+          'E_EMBED',
+          `Native embedding failed: ${msg} Path: ${params.embedModelPath}`,
+        );
+      }
+    }
     if (queryVec.length !== rulesMeta.dim) {
       throw ragError(
         'E_EMBED_MISMATCH',
@@ -886,52 +1208,20 @@ export async function runRagFlow(
     }
     mark('embedding end');
 
-    mark('vectors load start');
-    const [rulesIndex, cardsIndex] = await Promise.all([
-      loadVectors(reader, packState.rules.vectorsPath, rulesMeta, 'rules'),
-      loadVectors(reader, packState.cards.vectorsPath, cardsMeta, 'cards'),
-    ]);
-    mark('vectors load end');
-
-    mark('retrieval start');
-    const rulesTopK = Math.min(
-      RAG_CONFIG.retrieval.top_k_rules,
-      rulesIndex.nRows,
-    );
-    const cardsTopK = Math.min(
-      RAG_CONFIG.retrieval.top_k_cards,
-      cardsIndex.nRows,
-    );
-    const rulesHits = searchL2(rulesIndex, queryVec, rulesTopK);
-    const cardsHits = searchL2(cardsIndex, queryVec, cardsTopK);
-    const merged = mergeHits(rulesHits, cardsHits);
-    const topMerged = merged.slice(0, RAG_CONFIG.retrieval.top_k_merge);
-    mark('retrieval end');
-
-    const rulesRowIds = topMerged
-      .filter(h => h.source_type === 'rules')
-      .map(h => h.rowId);
-    const cardsRowIds = topMerged
-      .filter(h => h.source_type === 'cards')
-      .map(h => h.rowId);
-    mark('chunks load start');
-    const [rulesChunks, cardsChunks] = await Promise.all([
-      loadChunksForRows(reader, packState.rules.chunksPath, rulesRowIds),
-      loadChunksForRows(reader, packState.cards.chunksPath, cardsRowIds),
-    ]);
-    mark('chunks load end');
+    const { chunksForPrompt, rulesCount, cardsCount, cache } =
+      await retrieveChunksForQuery(
+        packState,
+        reader,
+        queryVec,
+        params.embedModelPath,
+        mark,
+      );
+    if (requestId != null && requestDebugSink) {
+      const cacheTelemetry = queryCacheTelemetry(cache);
+      if (cacheTelemetry) emitRag('rag_query_cache', cacheTelemetry);
+    }
 
     mark('context build start');
-    const chunksForPrompt = topMerged.map(h => {
-      const map = h.source_type === 'rules' ? rulesChunks : cardsChunks;
-      const c = map.get(h.rowId);
-      return {
-        doc_id: c?.doc_id ?? h.doc_id,
-        source_type: h.source_type,
-        title: c?.title,
-        text: c?.text,
-      };
-    });
     options?.onRetrievalComplete?.();
     const { prompt, contextBlock } = trimChunksToFitPrompt(
       chunksForPrompt,
@@ -941,16 +1231,16 @@ export async function runRagFlow(
     if (requestId != null && requestDebugSink) {
       emitRag('rag_context_bundle_selected', {
         contextLength: contextBlock.length,
-        rulesCount: rulesRowIds.length,
-        cardsCount: cardsRowIds.length,
+        rulesCount,
+        cardsCount,
         bundlePreview:
           contextBlock.slice(0, BUNDLE_PREVIEW_MAX) +
           (contextBlock.length > BUNDLE_PREVIEW_MAX ? '…' : ''),
       });
       emitRag('rag_context_assembled', {
         contextLength: contextBlock.length,
-        rulesCount: rulesRowIds.length,
-        cardsCount: cardsRowIds.length,
+        rulesCount,
+        cardsCount,
         bundlePreview:
           contextBlock.slice(0, BUNDLE_PREVIEW_MAX) +
           (contextBlock.length > BUNDLE_PREVIEW_MAX ? '…' : ''),
@@ -958,8 +1248,8 @@ export async function runRagFlow(
       emitRag('rag_retrieval_complete', {
         retrievalMode: 'vector',
         contextLength: contextBlock.length,
-        rulesCount: rulesRowIds.length,
-        cardsCount: cardsRowIds.length,
+        rulesCount,
+        cardsCount,
         bundlePreview:
           contextBlock.slice(0, BUNDLE_PREVIEW_MAX) +
           (contextBlock.length > BUNDLE_PREVIEW_MAX ? '…' : ''),
@@ -967,8 +1257,8 @@ export async function runRagFlow(
       emitRag('rag_prompt_built', {
         promptLength: prompt.length,
         contextLength: contextBlock.length,
-        rulesCount: rulesRowIds.length,
-        cardsCount: cardsRowIds.length,
+        rulesCount,
+        cardsCount,
         promptPreview:
           prompt.slice(0, PROMPT_PREVIEW_MAX) +
           (prompt.length > PROMPT_PREVIEW_MAX ? '…' : ''),
@@ -1017,6 +1307,7 @@ export async function runRagFlow(
         ...generationTelemetryParams(),
       });
     }
+    await primePromptPrefix(chatCtx, params.chatModelPath!, prompt);
     options?.onGenerationStart?.();
     if (requestId != null && requestDebugSink) {
       emitRag('rag_inference_start', {});
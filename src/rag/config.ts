@@ -28,6 +28,24 @@ export interface RagConfig {
     top_k_merge: number;
     rules_weight: number;
     cards_weight: number;
+    /** Semantic query cache: min cosine to reuse a previous query's top-k (> 1 disables). */
+    query_cache_min_cosine: number;
+    /** Semantic query cache: max cached queries (LRU). */
+    query_cache_capacity: number;
+    /**
+     * Native index coarse-to-fine search: leading dims of each (Matryoshka-style) vector scanned first;
+     * 0 or >= pack dim scans every dimension.
+     */
+    coarse_prefix_dims: number;
+    /** Coarse candidates re-ranked with the full f16 distance. */
+    coarse_candidates: number;
+    /** Store the coarse prefix as int8 (per-dim scale) instead of f32. */
+    coarse_int8: boolean;
+    /**
+     * Native index: scan every dimension as int8 (per-dim scale/offset, codes from <source>/vectors.sq8
+     * when the pack ships it) and re-rank coarse_candidates with the f16 distance. Overrides the prefix.
+     */
+    sq8_scan: boolean;
   };
   prompt: {
     max_prompt_chars: number;
@@ -76,6 +94,12 @@ const DEFAULT_RAG_CONFIG: RagConfig = {
     top_k_merge: 4,
     rules_weight: 0.6,
     cards_weight: 0.4,
+    query_cache_min_cosine: 0.95,
+    query_cache_capacity: 64,
+    coarse_prefix_dims: 0,
+    coarse_candidates: 64,
+    coarse_int8: false,
+    sq8_scan: false,
   },
   /** Prompt sizing: hard cap so prompt + generation fits in chat_n_ctx. */
   prompt: {
@@ -112,6 +136,16 @@ function applyNumeric(
   }
 }
 
+function applyBoolean(
+  target: Record<string, boolean>,
+  key: string,
+  value: unknown,
+): void {
+  if (typeof value === 'boolean') {
+    target[key] = value;
+  }
+}
+
 function applyString(
   target: Record<string, string>,
   key: string,
@@ -201,6 +235,36 @@ export function applyPackRagConfig(
       'cards_weight',
       override.retrieval.cards_weight,
     );
+    applyNumeric(
+      RAG_CONFIG.retrieval as unknown as Record<string, number>,
+      'query_cache_min_cosine',
+      override.retrieval.query_cache_min_cosine,
+    );
+    applyNumeric(
+      RAG_CONFIG.retrieval as unknown as Record<string, number>,
+      'query_cache_capacity',
+      override.retrieval.query_cache_capacity,
+    );
+    applyNumeric(
+      RAG_CONFIG.retrieval as unknown as Record<string, number>,
+      'coarse_prefix_dims',
+      override.retrieval.coarse_prefix_dims,
+    );
+    applyNumeric(
+      RAG_CONFIG.retrieval as unknown as Record<string, number>,
+      'coarse_candidates',
+      override.retrieval.coarse_candidates,
+    );
+    applyBoolean(
+      RAG_CONFIG.retrieval as unknown as Record<string, boolean>,
+      'coarse_int8',
+      override.retrieval.coarse_int8,
+    );
+    applyBoolean(
+      RAG_CONFIG.retrieval as unknown as Record<string, boolean>,
+      'sq8_scan',
+      override.retrieval.sq8_scan,
+    );
   }
   if (override.prompt) {
     applyNumeric(
@@ -33,20 +33,15 @@ import {
   openCardsDb,
   openRulesDb,
   type CardsDb,
+  type DbCard,
   type DbRow,
+  type DbRule,
 } from './packDbRN';
 import type { PackFileReader } from './types';
 
 const SECTION_702 = 702;
 const MIN_TOKEN_LENGTH = 3;
 
-interface DbRule {
-  rule_id?: string;
-  section?: number;
-  text?: string;
-  tokens_json?: string;
-}
-
 export interface GetContextRNResult {
   bundle: ContextBundle;
   final_context_bundle_canonical: string;
@@ -100,9 +95,9 @@ function assemble(
   }> = [];
   const includedRules: DbRule[] = [];
   const cardContexts = cards.map(c => ({
-    oracle_id: (c as { oracle_id?: string }).oracle_id ?? '',
-    name: (c as { name?: string }).name ?? '',
-    oracle_text: (c as { oracle_text?: string }).oracle_text ?? '',
+    oracle_id: (c as DbCard).oracle_id ?? '',
+    name: (c as DbCard).name ?? '',
+    oracle_text: (c as DbCard).oracle_text ?? '',
   }));
   for (const card of cardContexts) {
     const est = tokenEst(card.oracle_text);
@@ -172,9 +167,9 @@ function resolveEntityModeForCardQuery(
   const candidates = new Map<string, SemanticFrontDoorAmbiguousCandidate>();
   const addRow = (row: DbRow | null) => {
     if (!row) return;
-    const oid = String((row as { oracle_id?: string }).oracle_id ?? '');
+    const oid = String((row as DbCard).oracle_id ?? '');
     if (!oid) return;
-    const name = String((row as { name?: string }).name ?? '');
+    const name = String((row as DbCard).name ?? '');
     candidates.set(oid, { name, oracle_id: oid });
   };
 
@@ -390,7 +385,7 @@ export async function getContextRN(
 
     const cardKeywords: string[] = [];
     for (const card of resolvedCards) {
-      const ot = (card as { oracle_text?: string }).oracle_text ?? '';
+      const ot = (card as DbCard).oracle_text ?? '';
       cardKeywords.push(...generalTokens(normalize(ot, spec), stopwords));
     }
     const keywords = [...new Set([...generalTokenSet, ...cardKeywords])];
@@ -423,7 +418,7 @@ export async function getContextRN(
 
     logInfo('RAG', 'getContextRN routing summary', {
       resolvedCards: resolvedCards.map(card =>
-        String((card as { name?: string }).name ?? ''),
+        String((card as DbCard).name ?? ''),
       ),
       cardKeywordCount: cardKeywords.length,
       keywordCount: keywords.length,
@@ -557,7 +552,7 @@ export async function getContextRN(
     if (
       resolvedCards.some(card =>
         isBasicLandTypeChangeText(
-          String((card as { oracle_text?: string }).oracle_text ?? ''),
+          String((card as DbCard).oracle_text ?? ''),
         ),
       ) &&
       !finalDefRules.some(rule => rule.rule_id === '305.7') &&
@@ -571,9 +566,9 @@ export async function getContextRN(
     }
 
     const cardContextsForAssemble = resolvedCards.map(c => ({
-      oracle_id: (c as { oracle_id?: string }).oracle_id ?? '',
-      name: (c as { name?: string }).name ?? '',
-      oracle_text: (c as { oracle_text?: string }).oracle_text ?? '',
+      oracle_id: (c as DbCard).oracle_id ?? '',
+      name: (c as DbCard).name ?? '',
+      oracle_text: (c as DbCard).oracle_text ?? '',
     }));
     const { cards: inclCards, rules: inclRules } = assemble(
       cardContextsForAssemble,
@@ -597,7 +592,7 @@ export async function getContextRN(
         queryPreview: previewQuery(queryText),
         normalizedQuery: normalized,
         resolvedCards: resolvedCards.map(card =>
-          String((card as { name?: string }).name ?? ''),
+          String((card as DbCard).name ?? ''),
         ),
         sectionsConsidered,
         sectionsSelected,
@@ -11,6 +11,7 @@ import {
   RAG_USE_DETERMINISTIC_CONTEXT_ONLY,
   type Manifest,
   type IndexMeta,
+  type IndexSegment,
   type PackState,
   type RagInitParams,
 } from './types';
@@ -128,6 +129,56 @@ async function loadIndexMetaOrStub(
   }
 }
 
+/** <indexDir>/segments.json: delta segments appended to the base vectors.f16 / chunks.jsonl. */
+interface SegmentsFile {
+  segments?: Array<{
+    name?: string;
+    vectors?: string;
+    chunks?: string;
+    first_row?: number;
+    tombstones?: string;
+  }>;
+}
+
+/**
+ * Vector index segments for an index dir. Without segments.json the base files are the only segment.
+ * Entries list the base first; each later segment's first_row must be past every earlier one.
+ */
+async function loadIndexSegments(
+  reader: PackFileReader,
+  indexDir: string
+): Promise<IndexSegment[]> {
+  const base: IndexSegment = {
+    name: 'base',
+    vectorsPath: `${indexDir}/vectors.f16`,
+    chunksPath: `${indexDir}/chunks.jsonl`,
+    firstRow: 0,
+  };
+  let raw: string;
+  try {
+    raw = await reader.readFile(`${indexDir}/segments.json`);
+  } catch {
+    return [base];
+  }
+  const file = parseJson<SegmentsFile>(raw, `${indexDir}/segments.json`);
+  const rel = (p?: string) => (p ? `${indexDir}/${p.replace(/^\//, '')}` : undefined);
+  const segments: IndexSegment[] = [];
+  for (const [i, s] of (file.segments ?? []).entries()) {
+    const firstRow = s.first_row ?? 0;
+    if (segments.length > 0 && firstRow < segments[segments.length - 1]!.firstRow) {
+      throw ragError('E_PACK_LOAD', `${indexDir}/segments.json: segment ${i} first_row is not append-only`);
+    }
+    segments.push({
+      name: s.name ?? `segment-${i}`,
+      vectorsPath: rel(s.vectors),
+      chunksPath: rel(s.chunks),
+      firstRow,
+      tombstonesPath: rel(s.tombstones),
+    });
+  }
+  return segments.length > 0 ? segments : [base];
+}
+
 /** Sentinel when RAG_USE_DETERMINISTIC_CONTEXT_ONLY: no embed model is used. */
 export const PACK_EMBED_MODEL_ID_DETERMINISTIC_ONLY = 'deterministic-only';
 
@@ -147,6 +198,35 @@ export async function getPackEmbedModelId(reader: PackFileReader): Promise<strin
   return meta.embed_model_id;
 }
 
+/** FNV-1a 32-bit, hex. */
+function hashContent(text: string): string {
+  let h = 0x811c9dc5;
+  for (let i = 0; i < text.length; i++) {
+    h ^= text.charCodeAt(i);
+    h = Math.imul(h, 0x01000193);
+  }
+  return (h >>> 0).toString(16).padStart(8, '0');
+}
+
+/**
+ * Best effort: seed the TTS phoneme memo with pack.bin's per-word espeak output (the pack's card names and
+ * rules vocabulary), so answers about the pack skip espeak for words not yet spoken. Skipped without JSI,
+ * for relative pack roots, or when pack.bin has no phonemes section.
+ */
+function seedPhonemeMemo(packRoot: string): void {
+  if (!packRoot.startsWith('/')) return;
+  try {
+    const mod = require('piper-tts') as {
+      phonemeMemoSeed?: (packBinPath: string, voice?: string) => number | null;
+    };
+    if (typeof mod.phonemeMemoSeed !== 'function') return;
+    const words = mod.phonemeMemoSeed(`${packRoot.replace(/\/+$/, '')}/pack.bin`);
+    if (words != null) console.log(`[RAG] phoneme memo seeded: ${words} words`);
+  } catch {
+    // pack.bin missing or built without --espeak-data
+  }
+}
+
 /**
  * Full pack load: manifest, validate paths, index_meta for rules and cards.
  * Enforces pack embed_model_id === app embedModelId (hard-fail on mismatch).
@@ -175,6 +255,10 @@ export async function loadPack(
 
   const rulesMeta = await loadIndexMetaOrStub(reader, 'rules');
   const cardsMeta = await loadIndexMetaOrStub(reader, 'cards');
+  const [rulesSegments, cardsSegments] = await Promise.all([
+    loadIndexSegments(reader, 'rules'),
+    loadIndexSegments(reader, 'cards'),
+  ]);
   mark('index_meta loaded end');
   emit('rag_index_meta_loaded');
 
@@ -205,31 +289,53 @@ export async function loadPack(
 
   mark('pack load end');
   emit('rag_pack_load_end');
+  seedPhonemeMemo(packRoot);
 
-  if (typeof __DEV__ !== 'undefined' && __DEV__) {
-    try {
-      const identityJson = await reader.readFile('pack_identity.json');
-      const identity = JSON.parse(identityJson) as Record<string, unknown>;
+  let packVersion: string | undefined;
+  try {
+    const identityJson = await reader.readFile('pack_identity.json');
+    const identity = JSON.parse(identityJson) as Record<string, unknown>;
+    if (typeof __DEV__ !== 'undefined' && __DEV__) {
       console.log('[RAG] pack_identity', identity);
-    } catch {
-      // pack_identity.json optional (e.g. pack not from sync-pack-small)
     }
+    const parts = [identity.pack_version, identity.pack_manifest_sha].filter(
+      (v): v is string | number =>
+        typeof v === 'string' || typeof v === 'number',
+    );
+    if (parts.length > 0) packVersion = parts.join(':');
+  } catch {
+    // pack_identity.json optional (e.g. pack not from sync-pack-small)
+  }
+
+  // pack_files.json lists every file's hash (native sync); segments cover delta appends without it.
+  let packFiles = '';
+  try {
+    packFiles = await reader.readFile('pack_files.json');
+  } catch {
+    // pack_files.json optional (packs synced before the incremental copy)
   }
+  const contentKey = hashContent(
+    `${packFiles}\n${JSON.stringify(rulesSegments)}\n${JSON.stringify(cardsSegments)}`,
+  );
 
   return {
     packRoot,
     manifest,
+    packVersion,
+    contentKey,
     rules: {
       indexMeta: rulesMeta,
       chunksPath: 'rules/chunks.jsonl',
       vectorsPath: 'rules/vectors.f16',
       rowMapPath: 'rules/row_map.jsonl',
+      segments: rulesSegments,
     },
     cards: {
       indexMeta: cardsMeta,
       chunksPath: 'cards/chunks.jsonl',
       vectorsPath: 'cards/vectors.f16',
       rowMapPath: 'cards/row_map.jsonl',
+      segments: cardsSegments,
     },
     validate: {
       rulesRuleIdsPath,
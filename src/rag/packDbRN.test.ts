@@ -0,0 +1,203 @@
+import {
+  CARD_COLUMNS,
+  RULE_COLUMNS,
+  openCardsDb,
+  openRulesDb,
+  type DbRow,
+} from './packDbRN';
+
+type Row = Record<string, string | number | null>;
+
+// Fixture rows in key order (rule_id / oracle_id), with a column getContextRN never reads.
+const mockRules: Row[] = [
+  {
+    rule_id: '510.1c',
+    section: 510,
+    text: 'A blocked creature assigns combat damage.',
+    tokens_json: '["blocked","creature","combat","damage"]',
+    subrule_of: '510.1',
+  },
+  {
+    rule_id: '702.19b',
+    section: 702,
+    text: 'Trample lets excess damage through.',
+    tokens_json: '["trample","excess","damage"]',
+    subrule_of: '702.19',
+  },
+  {
+    rule_id: '702.19c',
+    section: 702,
+    text: 'Trample over planeswalkers.',
+    tokens_json: '["trample","planeswalkers"]',
+    subrule_of: '702.19',
+  },
+  {
+    rule_id: '702.2a',
+    section: 702,
+    text: 'Deathtouch is a static ability.',
+    tokens_json: '["deathtouch","static","ability"]',
+    subrule_of: '702.2',
+  },
+];
+
+const mockCards: Row[] = [
+  {
+    oracle_id: 'a1',
+    name: 'Llanowar Elves',
+    name_norm: 'llanowar elves',
+    oracle_text: '{T}: Add {G}.',
+    type_line: 'Creature',
+  },
+  {
+    oracle_id: 'b2',
+    name: 'Giant Growth',
+    name_norm: 'giant growth',
+    oracle_text: 'Target creature gets +3/+3.',
+    type_line: 'Instant',
+  },
+];
+
+let mockTablesAvailable = false;
+
+/** Fake react-native-quick-sqlite: answers the statements packDbRN issues. */
+function mockExecute(db: string, sql: string, params: Array<string | number>) {
+  const table = db === 'rules.db' ? mockRules : mockCards;
+  let rows: Row[];
+  if (sql.includes('AND LOWER(text) LIKE ?')) {
+    const sub = String(params[1]).slice(1, -1);
+    rows = table
+      .filter(
+        r =>
+          r.section === params[0] &&
+          String(r.text).toLowerCase().includes(sub),
+      )
+      .slice(0, 1);
+  } else if (sql.includes('WHERE rule_id LIKE ?')) {
+    const prefix = String(params[0]).slice(0, -1);
+    rows = table
+      .filter(r => String(r.rule_id).startsWith(prefix))
+      .slice(0, 2);
+  } else {
+    const column = /WHERE (\w+) = \?/.exec(sql)?.[1] ?? '';
+    rows = table.filter(r => r[column] === params[0]);
+  }
+  return { rows: { _array: rows.map(r => ({ ...r })) } };
+}
+
+/** Fake piper-tts table reader: rows in key order, only the requested columns. */
+function mockPackTableFind(
+  _path: string,
+  table: string,
+  column: string,
+  key: string | number,
+  options?: { prefix?: boolean; limit?: number; columns?: string[] },
+): Row[] {
+  const rows = (table === 'rules.table' ? mockRules : mockCards).filter(r =>
+    options?.prefix
+      ? String(r[column]).startsWith(String(key))
+      : r[column] === key,
+  );
+  return rows.slice(0, options?.limit ?? rows.length).map(r => {
+    const out: Row = {};
+    for (const c of options?.columns ?? Object.keys(r)) out[c] = r[c] ?? null;
+    return out;
+  });
+}
+
+jest.mock(
+  'react-native-quick-sqlite',
+  () => ({
+    QuickSQLite: {
+      open: jest.fn(),
+      close: jest.fn(),
+      execute: (db: string, sql: string, params: Array<string | number>) =>
+        mockExecute(db, sql, params),
+    },
+  }),
+  { virtual: true },
+);
+
+jest.mock(
+  'piper-tts',
+  () => ({
+    isNativePackTableAvailable: () => mockTablesAvailable,
+    packTablesOpen: () => [
+      { name: 'rules.table', indexed: ['rule_id', 'section'] },
+      { name: 'cards.table', indexed: ['oracle_id', 'name_norm'] },
+    ],
+    packTableFind: (...args: Parameters<typeof mockPackTableFind>) =>
+      mockPackTableFind(...args),
+  }),
+  { virtual: true },
+);
+
+const PACK_ROOT = '/data/files/content_pack';
+
+function pick(rows: Array<DbRow | null>, columns: string[]) {
+  return rows.map(r =>
+    r == null
+      ? null
+      : Object.fromEntries(columns.map(c => [c, r[c] ?? null])),
+  );
+}
+
+/** Runs the same lookups through the SQLite path, then the pack.bin table path. */
+function bothPaths<T>(lookup: () => T): [T, T] {
+  mockTablesAvailable = false;
+  const sqlite = lookup();
+  mockTablesAvailable = true;
+  const table = lookup();
+  return [sqlite, table];
+}
+
+describe('packDbRN pack.bin tables', () => {
+  it('materializes every field getContextRN reads', () => {
+    expect(RULE_COLUMNS).toEqual(
+      expect.arrayContaining(['rule_id', 'section', 'text', 'tokens_json']),
+    );
+    expect(CARD_COLUMNS).toEqual(
+      expect.arrayContaining(['oracle_id', 'name', 'oracle_text']),
+    );
+  });
+
+  it('returns the same rule rows as SQLite', () => {
+    const [sqlite, table] = bothPaths(() => {
+      const db = openRulesDb(PACK_ROOT);
+      return [
+        ...db.rulesBySection(702),
+        ...db.rulesBySection(510),
+        ...db.rulesBySection(999),
+        db.ruleById('702.19b'),
+        db.ruleById('100.1'),
+        db.ruleFromSectionContaining(702, 'PLANESWALKERS'),
+        db.ruleFromSectionContaining(702, 'nothing like this'),
+        ...db.rulesByRuleIdPrefix('702.19'),
+        ...db.rulesByRuleIdPrefix('702.'),
+      ];
+    });
+    expect(table).toHaveLength(sqlite.length);
+    expect(pick(table, RULE_COLUMNS)).toEqual(pick(sqlite, RULE_COLUMNS));
+    // Section-intent retrieval scores each rulesBySection row by its tokens.
+    expect(
+      table.slice(0, 3).map(r => JSON.parse(String(r?.tokens_json))),
+    ).toEqual([
+      ['trample', 'excess', 'damage'],
+      ['trample', 'planeswalkers'],
+      ['deathtouch', 'static', 'ability'],
+    ]);
+  });
+
+  it('returns the same card rows as SQLite', () => {
+    const [sqlite, table] = bothPaths(() => {
+      const db = openCardsDb(PACK_ROOT);
+      return [
+        db.cardByNameNorm('giant growth'),
+        db.cardByNameNorm('unknown card'),
+        db.cardByOracleId('a1'),
+        db.cardByOracleId('zz'),
+      ];
+    });
+    expect(pick(table, CARD_COLUMNS)).toEqual(pick(sqlite, CARD_COLUMNS));
+    expect(table[0]?.name).toBe('Giant Growth');
+  });
+});
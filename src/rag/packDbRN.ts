@@ -6,6 +6,11 @@
  * So location MUST be relative to the app files dir (e.g. "content_pack/cards"), not an absolute path.
  *
  * Requires native module to be linked: iOS run `cd ios && pod install && cd ..`, then rebuild. Android: clean & rebuild.
+ *
+ * When the pack has a pack.bin with rules.table / cards.table (pack_compile) and piper-tts exposes the JSI
+ * table reader, the key lookups read those mmapped columnar copies instead: no SQLite statement per call, and
+ * only the columns getContextRN uses are materialized. Card-name prefix queries (card_name_prefix is not in
+ * pack.bin) still open cards.db, on first use.
  */
 
 let _QuickSQLite:
@@ -37,6 +42,22 @@ function getQuickSQLite(): typeof import('react-native-quick-sqlite').QuickSQLit
 
 export type DbRow = Record<string, unknown>;
 
+/** Rule fields getContextRN reads. */
+export interface DbRule {
+  rule_id?: string;
+  section?: number;
+  text?: string;
+  /** JSON array of the rule's tokens; section-intent retrieval scores by it. */
+  tokens_json?: string;
+}
+
+/** Card fields getContextRN reads. */
+export interface DbCard {
+  oracle_id?: string;
+  name?: string;
+  oracle_text?: string;
+}
+
 export interface CardsDb {
   cardByNameNorm(nameNorm: string): DbRow | null;
   cardByOracleId(oracleId: string): DbRow | null;
@@ -66,6 +87,66 @@ function rowsFromResult(result: { rows?: { _array?: unknown[] } }): DbRow[] {
   return Array.isArray(arr) ? (arr as DbRow[]) : [];
 }
 
+type PackTableRow = Record<string, string | number | null>;
+
+type PackTableModule = {
+  packTablesOpen: (
+    packBinPath: string,
+  ) => Array<{ name: string; indexed: string[] }> | null;
+  packTableFind: (
+    packBinPath: string,
+    table: string,
+    column: string,
+    key: string | number,
+    options?: { prefix?: boolean; limit?: number; columns?: string[] },
+  ) => PackTableRow[] | null;
+};
+
+// Every DbRule / DbCard field (the Record type rejects a missing key), so a field getContextRN starts
+// reading is materialized from pack.bin as well as selected from SQLite.
+const RULE_FIELDS: Record<keyof DbRule, true> = {
+  rule_id: true,
+  section: true,
+  text: true,
+  tokens_json: true,
+};
+const CARD_FIELDS: Record<keyof DbCard, true> = {
+  oracle_id: true,
+  name: true,
+  oracle_text: true,
+};
+export const RULE_COLUMNS = Object.keys(RULE_FIELDS);
+export const CARD_COLUMNS = Object.keys(CARD_FIELDS);
+
+/**
+ * Native table reader and pack.bin path when pack.bin has `table` with every index in `indexed`; null
+ * otherwise (no JSI, relative pack root, pack.bin missing or built before tables).
+ */
+function openPackTable(
+  packRoot: string,
+  table: string,
+  indexed: string[],
+): { mod: PackTableModule; path: string } | null {
+  if (!packRoot.startsWith('/')) return null;
+  try {
+    const mod = require('piper-tts') as Partial<PackTableModule> & {
+      isNativePackTableAvailable?: () => boolean;
+    };
+    if (
+      typeof mod.packTablesOpen !== 'function' ||
+      typeof mod.packTableFind !== 'function'
+    )
+      return null;
+    if (!mod.isNativePackTableAvailable?.()) return null;
+    const path = `${packRoot.replace(/\/+$/, '')}/pack.bin`;
+    const info = mod.packTablesOpen(path)?.find(t => t.name === table);
+    if (!info || !indexed.every(c => info.indexed.includes(c))) return null;
+    return { mod: mod as PackTableModule, path };
+  } catch {
+    return null;
+  }
+}
+
 /** Relative location from app files dir, e.g. "content_pack/cards". packRoot is e.g. .../files/content_pack. */
 function relativeLocationForDb(
   packRoot: string,
@@ -77,6 +158,37 @@ function relativeLocationForDb(
 }
 
 export function openCardsDb(packRoot: string): CardsDb {
+  const tables = openPackTable(packRoot, 'cards.table', [
+    'oracle_id',
+    'name_norm',
+  ]);
+  if (tables) {
+    const { mod, path } = tables;
+    const find = (column: string, key: string): DbRow | null =>
+      mod.packTableFind(path, 'cards.table', column, key, {
+        limit: 1,
+        columns: CARD_COLUMNS,
+      })?.[0] ?? null;
+    let sqlite: CardsDb | null = null;
+    const prefixDb = () => (sqlite ??= openCardsSqlite(packRoot));
+    return {
+      cardByNameNorm: nameNorm => find('name_norm', nameNorm),
+      cardByOracleId: oracleId => find('oracle_id', oracleId),
+      cardsByPrefix: (prefix, candidateCap) =>
+        prefix ? prefixDb().cardsByPrefix(prefix, candidateCap) : [],
+      prefixCandidateOracleIds: (prefix, candidateCap) =>
+        prefix
+          ? prefixDb().prefixCandidateOracleIds(prefix, candidateCap)
+          : [],
+      close() {
+        sqlite?.close();
+      },
+    };
+  }
+  return openCardsSqlite(packRoot);
+}
+
+function openCardsSqlite(packRoot: string): CardsDb {
   const QuickSQLite = getQuickSQLite();
   const location = relativeLocationForDb(packRoot, 'cards');
   const name = 'cards.db';
@@ -130,6 +242,43 @@ export function openCardsDb(packRoot: string): CardsDb {
 }
 
 export function openRulesDb(packRoot: string): RulesDb {
+  const tables = openPackTable(packRoot, 'rules.table', [
+    'rule_id',
+    'section',
+  ]);
+  if (tables) {
+    const { mod, path } = tables;
+    // rules.table rows are stored in rule_id order, so equal sections come
+    // back ORDER BY rule_id.
+    const find = (
+      column: string,
+      key: string | number,
+      prefix: boolean,
+      limit?: number,
+    ): DbRow[] =>
+      mod.packTableFind(path, 'rules.table', column, key, {
+        prefix,
+        limit,
+        columns: RULE_COLUMNS,
+      }) ?? [];
+    return {
+      rulesBySection: section => find('section', section, false),
+      ruleById: ruleId => find('rule_id', ruleId, false, 1)[0] ?? null,
+      ruleFromSectionContaining(section, substring) {
+        const sub = (substring || '').trim().toLowerCase();
+        if (!sub) return null;
+        return (
+          find('section', section, false).find(r =>
+            String(r.text ?? '').toLowerCase().includes(sub),
+          ) ?? null
+        );
+      },
+      rulesByRuleIdPrefix: prefix => find('rule_id', prefix, true, 2),
+      close() {
+        // The mapping is shared per pack.bin path (replaced when it changes).
+      },
+    };
+  }
   const QuickSQLite = getQuickSQLite();
   const location = relativeLocationForDb(packRoot, 'rules');
   const name = 'rules.db';
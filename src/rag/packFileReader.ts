@@ -6,30 +6,56 @@
 
 import { Platform } from 'react-native';
 import type { PackFileReader } from './types';
+import { logWarn } from '../shared/logging';
 
-function base64ToBytes(base64: string): Uint8Array {
-  const chars = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
-  const len = base64.replace(new RegExp('=+$'), '').length;
-  const out: number[] = [];
+const BASE64_CHARS = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+const BASE64_LOOKUP = (() => {
+  const table = new Int16Array(128).fill(-1);
+  for (let i = 0; i < BASE64_CHARS.length; i++) table[BASE64_CHARS.charCodeAt(i)] = i;
+  return table;
+})();
+
+/** Bridge fallback: decodes straight into the returned buffer (characters outside the alphabet are skipped). */
+function base64ToArrayBuffer(base64: string): ArrayBuffer {
+  let end = base64.length;
+  while (end > 0 && base64[end - 1] === '=') end--;
+  const out = new Uint8Array(Math.floor((end * 3) / 4));
+  let n = 0;
   let buf = 0;
   let bits = 0;
-  for (let i = 0; i < len; i++) {
-    const idx = chars.indexOf(base64[i]!);
-    if (idx === -1) continue;
-    buf = buf * 64 + idx;
+  for (let i = 0; i < end; i++) {
+    const code = base64.charCodeAt(i);
+    const idx = code < 128 ? BASE64_LOOKUP[code]! : -1;
+    if (idx < 0) continue;
+    buf = ((buf << 6) | idx) & 0xffffff;
     bits += 6;
     if (bits >= 8) {
       bits -= 8;
-      out.push(Math.floor(buf / 2 ** bits) % 256);
+      out[n++] = (buf >> bits) & 0xff;
     }
   }
-  return new Uint8Array(out);
+  return n === out.length ? out.buffer : out.buffer.slice(0, n);
 }
 
-function toArrayBuffer(bytes: Uint8Array): ArrayBuffer {
-  const buffer = new ArrayBuffer(bytes.byteLength);
-  new Uint8Array(buffer).set(bytes);
-  return buffer;
+type NativePackFiles = {
+  readPackFileBinary?: (path: string) => ArrayBuffer | null;
+  readPackAssetBinary?: (path: string) => ArrayBuffer | null;
+};
+
+/**
+ * piper-tts JSI reader: the file is mmapped (or the bundled asset mapped) and handed to JS as an ArrayBuffer
+ * without copies. Null when the plugin or its JSI bindings are unavailable, so the caller uses the bridge.
+ * Throws (like the bridge would reject) when the file cannot be read.
+ */
+function readBinaryNative(kind: 'file' | 'asset', path: string): ArrayBuffer | null {
+  let files: NativePackFiles;
+  try {
+    files = require('piper-tts');
+  } catch {
+    return null;
+  }
+  const read = kind === 'file' ? files?.readPackFileBinary : files?.readPackAssetBinary;
+  return typeof read === 'function' ? read(path) : null;
 }
 
 /**
@@ -68,9 +94,9 @@ export function createBundlePackReader(): PackFileReader | null {
       },
       async readFileBinary(relativePath: string): Promise<ArrayBuffer> {
         const path = prefix + relativePath.replace(/^\//, '');
-        const base64 = await RagPackReader.readFileBinary(path);
-        const bytes = base64ToBytes(base64);
-        return toArrayBuffer(bytes);
+        const native = readBinaryNative('asset', path);
+        if (native) return native;
+        return base64ToArrayBuffer(await RagPackReader.readFileBinary(path));
       },
     };
   } catch {
@@ -102,9 +128,9 @@ export function createDocumentsPackReader(packRoot: string): PackFileReader | nu
       },
       async readFileBinary(relativePath: string): Promise<ArrayBuffer> {
         const path = `${root}/${relativePath.replace(/^\//, '')}`;
-        const base64 = await RagPackReader.readFileBinaryAtPath(path);
-        const bytes = base64ToBytes(base64);
-        return toArrayBuffer(bytes);
+        const native = readBinaryNative('file', path);
+        if (native) return native;
+        return base64ToArrayBuffer(await RagPackReader.readFileBinaryAtPath(path));
       },
     };
   } catch {
@@ -129,10 +155,40 @@ export async function getContentPackPathInDocuments(): Promise<string> {
 }
 
 /**
- * Copies the bundled content_pack to Documents (one-time). Idempotent: if pack already in Documents, skips copy.
- * Returns the Documents pack path. Rejects if bundle has no pack or copy fails.
+ * Incremental native sync (piper-tts syncContentPack): copies only files whose pack_files.json hash
+ * changed. Null when the plugin is unavailable or the bundled pack has no pack_files.json
+ * (E_NO_PACK_MANIFEST), so the caller falls back to the full copy. Any other sync failure rejects: the
+ * full copy would delete and recopy the whole pack, which the incremental sync exists to avoid.
+ */
+async function syncBundlePackNative(): Promise<string | null> {
+  let PiperTts: { syncContentPack?: () => Promise<string | null> };
+  try {
+    PiperTts = require('piper-tts').default;
+  } catch {
+    return null;
+  }
+  if (typeof PiperTts?.syncContentPack !== 'function') return null;
+  try {
+    return await PiperTts.syncContentPack();
+  } catch (e) {
+    const code = (e as { code?: unknown } | null)?.code;
+    if (code === 'E_NO_PACK_MANIFEST') {
+      logWarn('RAG', 'bundled pack has no pack_files.json; using full copy');
+      return null;
+    }
+    throw e;
+  }
+}
+
+/**
+ * Copies the bundled content_pack to Documents. Prefers the incremental native sync, which also picks up
+ * updated bundle files; the one-time full copy (skipped if the pack is already in Documents) is used only
+ * without the plugin or without pack_files.json. Returns the Documents pack path. Rejects if the bundle
+ * has no pack or the copy fails.
  */
 export async function copyBundlePackToDocuments(): Promise<string> {
+  const synced = await syncBundlePackNative();
+  if (synced) return synced;
   const { NativeModules } = require('react-native');
   const RagPackReader = NativeModules.RagPackReader ?? NativeModules.RagPackReaderModule;
   if (!RagPackReader || typeof RagPackReader.copyBundlePackToDocuments !== 'function')
@@ -0,0 +1,103 @@
+import type { LlamaContext } from 'llama.rn';
+import {
+  ensurePromptPrefix,
+  promptPrefixKey,
+  promptPrefixSessionPath,
+} from './promptPrefixCache';
+
+jest.mock('../shared/logging', () => ({
+  logInfo: jest.fn(),
+  logWarn: jest.fn(),
+}));
+
+const MODEL = '/data/models/chat.gguf';
+const PREFIX = '<|begin_of_text|>system prompt<|start_header_id|>user<|end_header_id|>';
+const PROMPT = `${PREFIX}\n\nQuestion: what is trample?`;
+
+/** Fake llama.rn context over an in-memory "disk" of saved sessions. */
+function fakeContext(disk: Map<string, number>) {
+  return {
+    loadSession: jest.fn(async (path: string) => {
+      const tokens = disk.get(path);
+      if (tokens == null) throw new Error('no such file');
+      return { tokens_loaded: tokens, prompt: PREFIX };
+    }),
+    tokenize: jest.fn(async () => ({ tokens: [1, 2, 3, 4, 5] })),
+    completion: jest.fn(async () => ({ text: 'x' })),
+    saveSession: jest.fn(async (path: string, opts?: { tokenSize?: number }) => {
+      disk.set(path, opts?.tokenSize ?? -1);
+      return opts?.tokenSize ?? 0;
+    }),
+  };
+}
+
+describe('ensurePromptPrefix', () => {
+  it('evaluates and saves the prefix once, then reuses it', async () => {
+    const disk = new Map<string, number>();
+    const ctx = fakeContext(disk);
+    const llama = ctx as unknown as LlamaContext;
+
+    const first = await ensurePromptPrefix(llama, MODEL, 'v1', PREFIX, PROMPT);
+    expect(first.status).toBe('saved');
+    expect(ctx.completion).toHaveBeenCalledWith(
+      expect.objectContaining({ prompt: PREFIX, n_predict: 1 }),
+    );
+    const path = promptPrefixSessionPath(
+      MODEL,
+      promptPrefixKey(MODEL, 'v1', PREFIX),
+    );
+    expect(disk.get(path)).toBe(5);
+
+    const second = await ensurePromptPrefix(llama, MODEL, 'v1', PREFIX, PROMPT);
+    expect(second.status).toBe('warm');
+    expect(ctx.completion).toHaveBeenCalledTimes(1);
+
+    // A new context (app restart) restores from disk without evaluating.
+    const next = fakeContext(disk);
+    const restored = await ensurePromptPrefix(
+      next as unknown as LlamaContext,
+      MODEL,
+      'v1',
+      PREFIX,
+      PROMPT,
+    );
+    expect(restored).toEqual(
+      expect.objectContaining({ status: 'restored', tokens: 5 }),
+    );
+    expect(next.completion).not.toHaveBeenCalled();
+  });
+
+  it('rebuilds for a new pack version', async () => {
+    const disk = new Map<string, number>();
+    const ctx = fakeContext(disk) as unknown as LlamaContext;
+    await ensurePromptPrefix(ctx, MODEL, 'v1', PREFIX, PROMPT);
+    const result = await ensurePromptPrefix(ctx, MODEL, 'v2', PREFIX, PROMPT);
+    expect(result.status).toBe('saved');
+    expect(disk.size).toBe(2);
+  });
+
+  it('skips prompts that do not start with the prefix and never throws', async () => {
+    const ctx = fakeContext(new Map());
+    expect(
+      (
+        await ensurePromptPrefix(
+          ctx as unknown as LlamaContext,
+          MODEL,
+          'v1',
+          PREFIX,
+          'other prompt',
+        )
+      ).status,
+    ).toBe('skipped');
+
+    ctx.completion.mockRejectedValueOnce(new Error('context busy'));
+    const failed = await ensurePromptPrefix(
+      ctx as unknown as LlamaContext,
+      MODEL,
+      'v1',
+      PREFIX,
+      PROMPT,
+    );
+    expect(failed.status).toBe('skipped');
+  });
+});
@@ -0,0 +1,132 @@
+/**
+ * Persisted KV state for the static chat prompt prefix (Llama-3 system block up to the user header,
+ * see staticPromptPrefix in runtimePrompt.ts).
+ *
+ * The first completion on a fresh chat context would otherwise evaluate that prefix again on every app
+ * start. It is evaluated once per model + pack version + prefix text and saved next to the model with
+ * llama.rn saveSession; later contexts restore it with loadSession. llama.rn reuses the longest common
+ * token prefix of consecutive prompts, so after a restore (or a previous completion with the same prefix)
+ * only the per-question suffix is evaluated.
+ */
+
+import type { LlamaContext } from 'llama.rn';
+import { logInfo, logWarn } from '../shared/logging';
+
+export type PromptPrefixStatus = 'warm' | 'restored' | 'saved' | 'skipped';
+
+export interface PromptPrefixResult {
+  status: PromptPrefixStatus;
+  /** Prefix tokens in the context's KV cache after the call (0 when skipped). */
+  tokens: number;
+  elapsedMs: number;
+}
+
+/** Context -> key of the prefix its KV cache currently starts with. */
+const primedContexts = new WeakMap<LlamaContext, string>();
+
+/** FNV-1a 32-bit, hex. */
+function hashKey(text: string): string {
+  let h = 0x811c9dc5;
+  for (let i = 0; i < text.length; i++) {
+    h ^= text.charCodeAt(i);
+    h = Math.imul(h, 0x01000193);
+  }
+  return (h >>> 0).toString(16).padStart(8, '0');
+}
+
+function sessionFileStem(modelPath: string): string {
+  return modelPath.replace(/\.gguf$/i, '');
+}
+
+/** `<model>.prefix-<key>.session` next to the model file. */
+export function promptPrefixSessionPath(modelPath: string, key: string): string {
+  return `${sessionFileStem(modelPath)}.prefix-${key}.session`;
+}
+
+export function promptPrefixKey(
+  modelPath: string,
+  packVersion: string | undefined,
+  prefix: string,
+): string {
+  return hashKey(`${modelPath}\n${packVersion ?? ''}\n${prefix}`);
+}
+
+/** Deletes other prefix sessions of this model (older pack versions / system prompts). Best effort. */
+function removeStaleSessions(modelPath: string, keepPath: string): void {
+  try {
+    const { Directory, File } = require('expo-file-system') as typeof import('expo-file-system');
+    const slash = modelPath.lastIndexOf('/');
+    if (slash <= 0) return;
+    const dir = new Directory(`file://${modelPath.slice(0, slash)}`);
+    const stem = sessionFileStem(modelPath.slice(slash + 1));
+    const keepName = keepPath.slice(keepPath.lastIndexOf('/') + 1);
+    for (const entry of dir.list()) {
+      if (
+        entry instanceof File &&
+        entry.name !== keepName &&
+        entry.name.startsWith(`${stem}.prefix-`) &&
+        entry.name.endsWith('.session')
+      ) {
+        entry.delete();
+      }
+    }
+  } catch {
+    // expo-file-system unavailable or directory not listable; stale files only cost disk
+  }
+}
+
+/**
+ * Makes ctx's KV cache start with prefix before a completion of prompt. Never throws: on any failure the
+ * completion simply evaluates the full prompt as before.
+ */
+export async function ensurePromptPrefix(
+  ctx: LlamaContext,
+  modelPath: string,
+  packVersion: string | undefined,
+  prefix: string,
+  prompt: string,
+): Promise<PromptPrefixResult> {
+  const startedAt = Date.now();
+  const done = (status: PromptPrefixStatus, tokens: number) => ({
+    status,
+    tokens,
+    elapsedMs: Date.now() - startedAt,
+  });
+  if (!prefix || !prompt.startsWith(prefix)) return done('skipped', 0);
+  const key = promptPrefixKey(modelPath, packVersion, prefix);
+  if (primedContexts.get(ctx) === key) return done('warm', 0);
+  primedContexts.delete(ctx);
+
+  const path = promptPrefixSessionPath(modelPath, key);
+  try {
+    const loaded = await ctx.loadSession(path);
+    if (loaded?.tokens_loaded > 0) {
+      primedContexts.set(ctx, key);
+      return done('restored', loaded.tokens_loaded);
+    }
+  } catch {
+    // no session yet (first run for this model + pack version) or unreadable: rebuild below
+  }
+
+  try {
+    const { tokens } = await ctx.tokenize(prefix);
+    if (!tokens?.length) return done('skipped', 0);
+    // One sampled token so llama.rn evaluates the whole prefix; only the prefix tokens are saved.
+    await ctx.completion({ prompt: prefix, n_predict: 1, temperature: 0 });
+    primedContexts.set(ctx, key);
+    const saved = await ctx.saveSession(path, { tokenSize: tokens.length });
+    removeStaleSessions(modelPath, path);
+    logInfo('RAG', 'saved prompt prefix KV state', {
+      path,
+      tokens: saved,
+      elapsedMs: Date.now() - startedAt,
+    });
+    return done('saved', tokens.length);
+  } catch (e) {
+    // e.g. a read-only model dir: the prefix may still be primed in this context, just not persisted
+    logWarn('RAG', 'prompt prefix KV state not persisted', {
+      error: e instanceof Error ? e.message : String(e),
+    });
+    return done(primedContexts.get(ctx) === key ? 'warm' : 'skipped', 0);
+  }
+}
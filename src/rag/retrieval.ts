@@ -1,10 +1,10 @@
 /**
  * Retrieval: decode vectors.f16 once, brute-force L2 top-k, merge rules + cards.
- * Optimization (plan step 6): JSI/native brute-force for the L2 loop, then optional
- * native HNSW loader (respect retrieval_format_version) for large packs.
+ * Segmented indexes (base + delta segments with tombstones) are searched natively when the
+ * piper-tts vector index is installed (see ask.ts); the functions below are the JS fallback.
  */
 
-import type { PackFileReader } from './types';
+import type { IndexSegment, PackFileReader } from './types';
 import type { IndexMeta } from './types';
 import { CONTEXT_BUNDLE_ERROR, ragErrorWithAttribution } from './errors';
 
@@ -167,3 +167,113 @@ export async function loadChunksForRows(
   }
   return byRowId;
 }
+
+/** Base + delta segments of one source, loaded for the JS search path. */
+export interface SegmentedVectorIndex {
+  segments: Array<{ segment: IndexSegment; index: VectorIndex | null }>;
+  tombstones: Set<number>;
+}
+
+const segmentedCache = new Map<string, SegmentedVectorIndex>();
+
+/** Segments of a PackState source; packs without segments.json have just the base files. */
+export function indexSegmentsOf(source: {
+  chunksPath: string;
+  vectorsPath: string;
+  segments?: IndexSegment[];
+}): IndexSegment[] {
+  return source.segments && source.segments.length > 0
+    ? source.segments
+    : [
+        {
+          name: 'base',
+          vectorsPath: source.vectorsPath,
+          chunksPath: source.chunksPath,
+          firstRow: 0,
+        },
+      ];
+}
+
+/** Load every segment's vectors (cached per path by loadVectors) and the union of tombstones. */
+export async function loadSegmentedVectors(
+  reader: PackFileReader,
+  segments: IndexSegment[],
+  meta: IndexMeta,
+  indexKey: string
+): Promise<SegmentedVectorIndex> {
+  const key = `${indexKey}:${JSON.stringify(segments)}`;
+  const cached = segmentedCache.get(key);
+  if (cached) return cached;
+  const loaded = await Promise.all(
+    segments.map(async (segment) => ({
+      segment,
+      index: segment.vectorsPath
+        ? await loadVectors(reader, segment.vectorsPath, meta, indexKey)
+        : null,
+    }))
+  );
+  const tombstones = new Set<number>();
+  for (const segment of segments) {
+    if (!segment.tombstonesPath) continue;
+    const buf = await reader.readFileBinary(segment.tombstonesPath);
+    for (const id of new Uint32Array(buf, 0, Math.floor(buf.byteLength / 4))) tombstones.add(id);
+  }
+  const index: SegmentedVectorIndex = { segments: loaded, tombstones };
+  segmentedCache.set(key, index);
+  return index;
+}
+
+/** Live row count across segments (upper bound when tombstones name rows outside any segment). */
+export function segmentedRowCount(index: SegmentedVectorIndex): number {
+  let rows = 0;
+  for (const { index: seg } of index.segments) rows += seg?.nRows ?? 0;
+  return Math.max(0, rows - index.tombstones.size);
+}
+
+/**
+ * L2 top-k over all segments with global row ids; tombstoned rows are dropped. Each segment is
+ * over-fetched by the tombstone count so the merged top-k stays exact.
+ */
+export function searchSegmentedL2(
+  index: SegmentedVectorIndex,
+  queryVector: Float32Array,
+  k: number
+): Array<{ rowId: number; score: number }> {
+  const merged: Array<{ rowId: number; score: number }> = [];
+  for (const { segment, index: seg } of index.segments) {
+    if (!seg) continue;
+    const perSegment = Math.min(k + index.tombstones.size, seg.nRows);
+    for (const hit of searchL2(seg, queryVector, perSegment)) {
+      const rowId = segment.firstRow + hit.rowId;
+      if (!index.tombstones.has(rowId)) merged.push({ rowId, score: hit.score });
+    }
+  }
+  merged.sort((a, b) => a.score - b.score);
+  return merged.slice(0, k);
+}
+
+/** Load chunks for global row ids, reading each row from the segment that added it. */
+export async function loadChunksForSegmentedRows(
+  reader: PackFileReader,
+  segments: IndexSegment[],
+  rowIds: number[]
+): Promise<Map<number, { doc_id: string; text?: string; title?: string }>> {
+  const withChunks = segments.filter((s) => s.chunksPath);
+  const bySegment = new Map<IndexSegment, number[]>();
+  for (const rowId of rowIds) {
+    let owner: IndexSegment | undefined;
+    for (const s of withChunks) if (s.firstRow <= rowId) owner = s;
+    if (!owner) continue;
+    const list = bySegment.get(owner) ?? [];
+    list.push(rowId - owner.firstRow);
+    bySegment.set(owner, list);
+  }
+  const out = new Map<number, { doc_id: string; text?: string; title?: string }>();
+  await Promise.all(
+    [...bySegment].map(async ([segment, localRows]) => {
+      const chunks = await loadChunksForRows(reader, segment.chunksPath!, localRows);
+      for (const [local, chunk] of chunks) out.set(segment.firstRow + local, chunk);
+    })
+  );
+  return out;
+}
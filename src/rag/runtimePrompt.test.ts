@@ -0,0 +1,55 @@
+import { RAG_CONFIG } from './config';
+import {
+  buildPrompt,
+  staticPromptPrefix,
+  trimChunksToFitPrompt,
+} from './runtimePrompt';
+
+jest.mock('./config', () => ({
+  RAG_CONFIG: {
+    prompt: {
+      system_instruction: 'Answer from the excerpts. Cite doc_id.',
+      default_max_context_chars: 2000,
+      max_prompt_chars: 400,
+      chars_per_token_est: 4,
+    },
+  },
+}));
+
+describe('runtimePrompt', () => {
+  it('starts every prompt with the cached static prefix', () => {
+    const prompt = buildPrompt(
+      'Rules excerpts:\n\n[702.19b] Trample',
+      'What is trample?',
+    );
+    expect(prompt.startsWith(staticPromptPrefix())).toBe(true);
+    expect(prompt.slice(staticPromptPrefix().length)).toBe(
+      '\n\nRules excerpts:\n\n[702.19b] Trample\n\nQuestion: What is trample?' +
+        '<|eot_id|>\n<|start_header_id|>assistant<|end_header_id|>\n\n',
+    );
+  });
+
+  it('keeps the prefix in step with the system instruction', () => {
+    const saved = RAG_CONFIG.prompt.system_instruction;
+    RAG_CONFIG.prompt.system_instruction = '  ';
+    try {
+      expect(staticPromptPrefix()).toContain('You are a helpful assistant.');
+      expect(buildPrompt('', 'Hi').startsWith(staticPromptPrefix())).toBe(true);
+    } finally {
+      RAG_CONFIG.prompt.system_instruction = saved;
+    }
+  });
+
+  it('still starts with the prefix after trimming chunks to fit', () => {
+    const chunks = Array.from({ length: 8 }, (_, i) => ({
+      doc_id: `r${i}`,
+      source_type: 'rules' as const,
+      text: 'x'.repeat(60),
+    }));
+    const { prompt } = trimChunksToFitPrompt(chunks, 'Why?');
+    expect(prompt.length).toBeLessThanOrEqual(
+      RAG_CONFIG.prompt.max_prompt_chars,
+    );
+    expect(prompt.startsWith(staticPromptPrefix())).toBe(true);
+  });
+});
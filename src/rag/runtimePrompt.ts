@@ -12,20 +12,19 @@ const START_USER = '<|start_header_id|>user<|end_header_id|>';
 const START_ASSISTANT = '<|start_header_id|>assistant<|end_header_id|>';
 const EOT = '<|eot_id|>';
 
-/**
- * Build prompt using Llama-3 chat format. Not exported from @atlas/runtime RN entrypoint, so defined here.
- */
-function buildLlamaHumanShortPrompt(
-  contextBlock: string,
-  question: string,
-  systemInstruction: string,
-): string {
+/** Llama-3 chat head: BOS, the system turn and the user header, ending on a special token. */
+function llamaPromptHead(systemInstruction: string): string {
   const system =
     (systemInstruction ?? '').trim() || 'You are a helpful assistant.';
+  return `${BOS}${START_SYSTEM}\n\n${system}${EOT}\n${START_USER}`;
+}
+
+/** Rest of the user turn (context + question) and the assistant header the model completes. */
+function llamaPromptTail(contextBlock: string, question: string): string {
   const userContent = [contextBlock.trim(), `Question: ${question.trim()}`]
     .filter(Boolean)
     .join('\n\n');
-  return `${BOS}${START_SYSTEM}\n\n${system}${EOT}\n${START_USER}\n\n${userContent}${EOT}\n${START_ASSISTANT}\n\n`;
+  return `\n\n${userContent}${EOT}\n${START_ASSISTANT}\n\n`;
 }
 
 export interface ChunkForPrompt {
@@ -82,14 +81,19 @@ export function buildContextBlock(
 }
 
 /**
- * Build full prompt using Llama-3 chat template (matches pack_runtime runtime).
+ * Static start of every buildPrompt() result: BOS, system block and the user header. Ends on a special
+ * token so the prompt's tokenization splits exactly here; its KV state is cached (promptPrefixCache.ts).
+ */
+export function staticPromptPrefix(): string {
+  return llamaPromptHead(RAG_CONFIG.prompt.system_instruction);
+}
+
+/**
+ * Build full prompt using Llama-3 chat template (matches pack_runtime runtime). Always staticPromptPrefix()
+ * followed by the per-question tail, so the cached prefix cannot drift from the prompt.
  */
 export function buildPrompt(contextBlock: string, question: string): string {
-  return buildLlamaHumanShortPrompt(
-    contextBlock,
-    question,
-    RAG_CONFIG.prompt.system_instruction,
-  );
+  return staticPromptPrefix() + llamaPromptTail(contextBlock, question);
 }
 
 /**
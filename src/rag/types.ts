@@ -99,21 +99,45 @@ export interface RetrievalHit {
   score?: number;
 }
 
+/**
+ * One segment of a source's vector index, in append order. The base segment is the source's
+ * vectors.f16 / chunks.jsonl; delta segments (from <source>/segments.json) add rows whose global ids
+ * start at firstRow and may tombstone earlier rows. Paths are pack-relative.
+ */
+export interface IndexSegment {
+  name: string;
+  /** f16 rows; absent for a tombstone-only delta. */
+  vectorsPath?: string;
+  /** chunks.jsonl line i describes global row firstRow + i. */
+  chunksPath?: string;
+  firstRow: number;
+  /** Little-endian u32 global row ids removed by this segment. */
+  tombstonesPath?: string;
+}
+
 /** Resolved pack state after successful load. */
 export interface PackState {
   packRoot: string;
   manifest: Manifest;
+  /** pack_identity.json pack_version/pack_manifest_sha when present; scopes caches of retrieval results. */
+  packVersion?: string;
+  /** Hash of pack_files.json and the index segment lists; changes when the pack is updated in place. */
+  contentKey?: string;
   rules: {
     indexMeta: IndexMeta;
     chunksPath: string;
     vectorsPath: string;
     rowMapPath: string;
+    /** Base segment first (from rules/segments.json); absent means vectorsPath/chunksPath only. */
+    segments?: IndexSegment[];
   };
   cards: {
     indexMeta: IndexMeta;
     chunksPath: string;
     vectorsPath: string;
     rowMapPath: string;
+    /** Base segment first (from cards/segments.json); absent means vectorsPath/chunksPath only. */
+    segments?: IndexSegment[];
   };
   validate: {
     rulesRuleIdsPath: string;
@@ -42,6 +42,30 @@ export function isNativeMicCaptureEnabled(): boolean {
   return true;
 }
 
+/** Baked at build. Keep the native mic input open between captures with a pre-roll ring. */
+const rawNativeMicWarm =
+  typeof process !== 'undefined' && process.env != null
+    ? process.env.NATIVE_MIC_WARM
+    : undefined;
+const rawNativeMicPreRollMs =
+  typeof process !== 'undefined' && process.env != null
+    ? process.env.NATIVE_MIC_PREROLL_MS
+    : undefined;
+
+/** When true, atlas-native-mic keeps its input warm (mic stays open while the app is foreground) so capture starts instantly and includes the audio just before it. Default off; `1` / `true` / `yes` enables. Baked at build. */
+export function isNativeMicWarmCaptureEnabled(): boolean {
+  const v = rawNativeMicWarm?.trim().toLowerCase();
+  return v === '1' || v === 'true' || v === 'yes';
+}
+
+/** Pre-roll kept by the warm native mic, in ms (`NATIVE_MIC_PREROLL_MS`, default 500, clamped to 0–2000). */
+export function getNativeMicPreRollMs(): number {
+  const v = rawNativeMicPreRollMs?.trim();
+  const n = v ? Number(v) : NaN;
+  if (!Number.isFinite(n)) return 500;
+  return Math.min(2000, Math.max(0, Math.round(n)));
+}
+
 /** Build-time STT mode: `local` (native only), `remote` (proxy only), `remote_with_local_fallback` (prefer remote; start-time fallback + next-listen local preference per orchestrator policy). */
 export type SttProvider = 'local' | 'remote' | 'remote_with_local_fallback';
 